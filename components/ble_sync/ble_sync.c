@@ -0,0 +1,766 @@
+/**
+ * @file ble_sync.c
+ * @brief BLE time and notification sync implementation (NimBLE)
+ */
+
+#include "ble_sync.h"
+#include "clock_service.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "event_bus.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "net_scheduler.h"
+#include "ntp_client.h"
+#include "sdkconfig.h"
+#include "sleep_manager.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <sys/time.h>
+
+#ifdef CONFIG_BLE_SYNC_ENABLE
+
+#include "host/ble_hs.h"
+#include "host/util/util.h"
+#include "nimble/nimble_port.h"
+#include "nimble/nimble_port_freertos.h"
+#include "services/gap/ble_svc_gap.h"
+#include "services/gatt/ble_svc_gatt.h"
+
+static const char *TAG = "ble_sync";
+
+#define CTS_SERVICE_UUID 0x1805
+#define CURRENT_TIME_UUID 0x2A2B
+#define LOCAL_TIME_INFO_UUID 0x2A0F
+
+// CTS application error: the value was understood but not used
+#define CTS_ERR_DATA_IGNORED 0x80
+
+// Phone time arrives within a connection interval; slew what is left
+#define SLEW_THRESHOLD_MS 500
+
+// Stay awake this long after a phone connects so it can write the time
+#define CONNECT_AWAKE_US (10 * 1000000LL)
+
+// Long interval once discovery is done; iOS wants max >= min + 15 ms and
+// a supervision timeout above 3 x max x (latency + 1)
+#define SLOW_ITVL_MIN_MS CONFIG_BLE_SYNC_CONN_INTERVAL_MS
+#define SLOW_ITVL_MAX_MS (CONFIG_BLE_SYNC_CONN_INTERVAL_MS + 40)
+#define SLOW_TIMEOUT_MS                                                        \
+  (SLOW_ITVL_MAX_MS * (CONFIG_BLE_SYNC_CONN_LATENCY + 1) * 3 + 200)
+
+#define WORK_TIME 0x01 // Current Time written
+#define WORK_ZONE 0x02 // Local Time Information written
+
+#ifdef CONFIG_BLE_SYNC_REQUIRE_PAIRING
+#define WRITE_FLAGS (BLE_GATT_CHR_F_WRITE | BLE_GATT_CHR_F_WRITE_ENC)
+#else
+#define WRITE_FLAGS BLE_GATT_CHR_F_WRITE
+#endif
+
+// Provided by NimBLE's config store, which has no public header
+void ble_store_config_init(void);
+
+// 5d8f0a10-6c3b-4f2e-9a41-2b7c1e8d4f60 / ...4f61, little endian
+static const ble_uuid128_t notif_service_uuid =
+    BLE_UUID128_INIT(0x60, 0x4f, 0x8d, 0x1e, 0x7c, 0x2b, 0x41, 0x9a, 0x2e,
+                     0x4f, 0x3b, 0x6c, 0x10, 0x0a, 0x8f, 0x5d);
+static const ble_uuid128_t notif_chr_uuid =
+    BLE_UUID128_INIT(0x61, 0x4f, 0x8d, 0x1e, 0x7c, 0x2b, 0x41, 0x9a, 0x2e,
+                     0x4f, 0x3b, 0x6c, 0x10, 0x0a, 0x8f, 0x5d);
+
+static uint8_t own_addr_type;
+static uint16_t current_time_handle;
+static esp_timer_handle_t slow_timer = NULL;
+static TaskHandle_t work_task = NULL;
+static volatile bool work_busy = false;
+
+// Connection and what the phone wrote during it, shared with the work task
+static portMUX_TYPE state_mux = portMUX_INITIALIZER_UNLOCKED;
+static uint16_t conn_handle = BLE_HS_CONN_HANDLE_NONE;
+static int64_t connected_at_us = 0; // 0 while not connected
+static ble_sync_time_t rx_time;
+static int64_t rx_time_us = 0; // esp_timer time of the write, 0 if none
+static ble_sync_local_info_t rx_zone;
+static bool have_zone = false;
+static ble_sync_stats_t stats;
+
+// Newest first
+static ble_sync_notif_t notifs[CONFIG_BLE_SYNC_NOTIF_SLOTS];
+static size_t notif_count = 0;
+
+static void advertise(void);
+
+static int64_t system_time_us(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+static int read_flat(struct os_mbuf *om, void *buf, uint16_t max_len,
+                     uint16_t *len)
+{
+  if (OS_MBUF_PKTLEN(om) > max_len)
+  {
+    return BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+  }
+  return ble_hs_mbuf_to_flat(om, buf, max_len, len) == 0
+             ? 0
+             : BLE_ATT_ERR_UNLIKELY;
+}
+
+static int current_time_access(uint16_t conn, uint16_t attr,
+                               struct ble_gatt_access_ctxt *ctxt, void *arg)
+{
+  (void)conn;
+  (void)attr;
+  (void)arg;
+  uint8_t buf[BLE_SYNC_TIME_LEN];
+
+  if (ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR)
+  {
+    ble_sync_time_t t = {0}; // All zero: not known
+    if (clock_service_is_valid())
+    {
+      ble_sync_time_from_utc_us(system_time_us(),
+                                clock_service_get_utc_offset(), 0, &t);
+    }
+    ble_sync_encode_time(&t, buf, sizeof(buf));
+    return os_mbuf_append(ctxt->om, buf, sizeof(buf)) == 0
+               ? 0
+               : BLE_ATT_ERR_INSUFFICIENT_RES;
+  }
+
+  // Stamp the arrival first; the clock is set from it later
+  int64_t now_us = esp_timer_get_time();
+  uint16_t len = 0;
+  int rc = read_flat(ctxt->om, buf, sizeof(buf), &len);
+  if (rc != 0)
+  {
+    return rc;
+  }
+  ble_sync_time_t t;
+  if (!ble_sync_decode_time(buf, len, &t))
+  {
+    ESP_LOGW(TAG, "Current Time rejected (%u bytes)", len);
+    return len == BLE_SYNC_TIME_LEN ? CTS_ERR_DATA_IGNORED
+                                    : BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+  }
+
+  portENTER_CRITICAL(&state_mux);
+  rx_time = t;
+  rx_time_us = now_us;
+  portEXIT_CRITICAL(&state_mux);
+  xTaskNotify(work_task, WORK_TIME, eSetBits);
+  return 0;
+}
+
+static int local_time_access(uint16_t conn, uint16_t attr,
+                             struct ble_gatt_access_ctxt *ctxt, void *arg)
+{
+  (void)conn;
+  (void)attr;
+  (void)arg;
+  uint8_t buf[BLE_SYNC_LOCAL_INFO_LEN];
+
+  if (ctxt->op == BLE_GATT_ACCESS_OP_READ_CHR)
+  {
+    // The DST part is folded into the zone; report it as unknown
+    const ble_sync_local_info_t info = {
+        .tz_quarters = (int8_t)(clock_service_get_utc_offset() / 900),
+        .dst_quarters = BLE_SYNC_DST_UNKNOWN,
+    };
+    ble_sync_encode_local_info(&info, buf, sizeof(buf));
+    return os_mbuf_append(ctxt->om, buf, sizeof(buf)) == 0
+               ? 0
+               : BLE_ATT_ERR_INSUFFICIENT_RES;
+  }
+
+  uint16_t len = 0;
+  int rc = read_flat(ctxt->om, buf, sizeof(buf), &len);
+  if (rc != 0)
+  {
+    return rc;
+  }
+  ble_sync_local_info_t info;
+  if (!ble_sync_decode_local_info(buf, len, &info))
+  {
+    return len == BLE_SYNC_LOCAL_INFO_LEN ? CTS_ERR_DATA_IGNORED
+                                          : BLE_ATT_ERR_INVALID_ATTR_VALUE_LEN;
+  }
+
+  portENTER_CRITICAL(&state_mux);
+  rx_zone = info;
+  have_zone = true;
+  portEXIT_CRITICAL(&state_mux);
+  xTaskNotify(work_task, WORK_ZONE, eSetBits);
+  return 0;
+}
+
+/**
+ * @brief Apply a notification write to the kept list
+ */
+static void store_notif(const ble_sync_notif_t *n)
+{
+  portENTER_CRITICAL(&state_mux);
+  if (n->op == BLE_SYNC_NOTIF_CLEAR)
+  {
+    notif_count = 0;
+  }
+  else
+  {
+    // An update or a removal replaces the old copy
+    for (size_t i = 0; i < notif_count; i++)
+    {
+      if (notifs[i].id == n->id)
+      {
+        memmove(&notifs[i], &notifs[i + 1],
+                (notif_count - i - 1) * sizeof(notifs[0]));
+        notif_count--;
+        break;
+      }
+    }
+    if (n->op == BLE_SYNC_NOTIF_POST)
+    {
+      size_t keep = notif_count < CONFIG_BLE_SYNC_NOTIF_SLOTS
+                        ? notif_count
+                        : CONFIG_BLE_SYNC_NOTIF_SLOTS - 1;
+      memmove(&notifs[1], &notifs[0], keep * sizeof(notifs[0]));
+      notifs[0] = *n;
+      notif_count = keep + 1;
+    }
+  }
+  stats.notifications++;
+  portEXIT_CRITICAL(&state_mux);
+}
+
+static int notif_access(uint16_t conn, uint16_t attr,
+                        struct ble_gatt_access_ctxt *ctxt, void *arg)
+{
+  (void)conn;
+  (void)attr;
+  (void)arg;
+  // Only the host task calls this, one write at a time
+  static uint8_t buf[BLE_SYNC_NOTIF_MAX_LEN];
+  static ble_sync_notif_t n;
+
+  if (ctxt->op != BLE_GATT_ACCESS_OP_WRITE_CHR)
+  {
+    return BLE_ATT_ERR_UNLIKELY;
+  }
+
+  uint16_t len = 0;
+  int rc = read_flat(ctxt->om, buf, sizeof(buf), &len);
+  if (rc != 0)
+  {
+    return rc;
+  }
+  if (!ble_sync_decode_notif(buf, len, &n))
+  {
+    return BLE_ATT_ERR_VALUE_NOT_ALLOWED;
+  }
+
+  store_notif(&n);
+  const event_t event = {
+      .type = EVENT_NOTIFICATION,
+      .notification = {.id = n.id, .category = n.category, .op = n.op},
+  };
+  event_bus_publish(&event);
+  ESP_LOGI(TAG, "Notification %u op %u: %s", n.id, n.op, n.title);
+  return 0;
+}
+
+static const struct ble_gatt_svc_def services[] = {
+    {
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = BLE_UUID16_DECLARE(CTS_SERVICE_UUID),
+        .characteristics =
+            (struct ble_gatt_chr_def[]){
+                {
+                    .uuid = BLE_UUID16_DECLARE(CURRENT_TIME_UUID),
+                    .access_cb = current_time_access,
+                    .flags = BLE_GATT_CHR_F_READ | BLE_GATT_CHR_F_NOTIFY |
+                             WRITE_FLAGS,
+                    .val_handle = &current_time_handle,
+                },
+                {
+                    .uuid = BLE_UUID16_DECLARE(LOCAL_TIME_INFO_UUID),
+                    .access_cb = local_time_access,
+                    .flags = BLE_GATT_CHR_F_READ | WRITE_FLAGS,
+                },
+                {0},
+            },
+    },
+    {
+        .type = BLE_GATT_SVC_TYPE_PRIMARY,
+        .uuid = &notif_service_uuid.u,
+        .characteristics =
+            (struct ble_gatt_chr_def[]){
+                {
+                    .uuid = &notif_chr_uuid.u,
+                    .access_cb = notif_access,
+                    .flags = WRITE_FLAGS,
+                },
+                {0},
+            },
+    },
+    {0},
+};
+
+/**
+ * @brief Take the phone's time zone; true if the offset changed
+ */
+static bool apply_zone(const ble_sync_local_info_t *zone)
+{
+  if (zone->tz_quarters == BLE_SYNC_TZ_UNKNOWN)
+  {
+    return false;
+  }
+  int32_t offset_s = ble_sync_local_offset_s(zone);
+  if (offset_s == clock_service_get_utc_offset())
+  {
+    return false;
+  }
+
+#ifdef CONFIG_NTP_CLIENT_ENABLE
+  // Through the NTP client's settings, so the Time Sync screen agrees.
+  // Only a whole hour of DST maps onto its DST switch.
+  bool dst = zone->dst_quarters == 4;
+  int32_t zone_min = (offset_s - (dst ? 3600 : 0)) / 60;
+  char tz[16];
+  snprintf(tz, sizeof(tz), "UTC%c%ld:%02ld", zone_min < 0 ? '-' : '+',
+           (long)(abs(zone_min) / 60), (long)(abs(zone_min) % 60));
+  ntp_client_set_timezone(tz);
+  ntp_client_set_dst_enabled(dst);
+#else
+  clock_service_set_utc_offset(offset_s);
+#endif
+  ESP_LOGI(TAG, "UTC offset %+ld min from the phone", (long)(offset_s / 60));
+  return true;
+}
+
+/**
+ * @brief Set the clock and the RTC from the phone's Current Time
+ */
+static void apply_time(const ble_sync_time_t *t, int64_t rx_us,
+                       int64_t conn_us)
+{
+  // The phone sent local time; add how long the write has been waiting
+  int64_t utc_us =
+      ble_sync_time_to_utc_us(t, clock_service_get_utc_offset()) +
+      (esp_timer_get_time() - rx_us);
+  int64_t offset_us = utc_us - system_time_us();
+  bool stepped = clock_service_correct(offset_us, SLEW_THRESHOLD_MS);
+  uint32_t took_ms = conn_us ? (uint32_t)((rx_us - conn_us) / 1000) : 0;
+
+  if (!stepped)
+  {
+    clock_service_wait_for_slew(SLEW_THRESHOLD_MS);
+  }
+  esp_err_t ret = clock_service_save_to_rtc();
+  if (ret != ESP_OK)
+  {
+    ESP_LOGW(TAG, "RTC update failed: %s", esp_err_to_name(ret));
+  }
+
+  // Same path as an NTP sync: the next NTP sync moves out a full interval
+  ntp_client_note_external_sync(offset_us / 1000, took_ms);
+  const event_t event = {
+      .type = EVENT_TIME_SYNC,
+      .time_sync.ok = true,
+      .time_sync.source = EVENT_TIME_SYNC_BLE,
+  };
+  event_bus_publish(&event);
+
+  portENTER_CRITICAL(&state_mux);
+  stats.time_syncs++;
+  stats.last_sync_ms = took_ms;
+  portEXIT_CRITICAL(&state_mux);
+
+  // The point of BLE: compare with what a WiFi session costs. A snapshot,
+  // so this does not wait for a session that is running right now
+  net_sched_stats_t wifi;
+  net_scheduler_get_stats(&wifi);
+  if (wifi.sessions > 0)
+  {
+    ESP_LOGI(TAG,
+             "Time %s by %+lld ms, %lu ms after connecting (WiFi sessions "
+             "average %lu ms)",
+             stepped ? "stepped" : "slewed", (long long)(offset_us / 1000),
+             (unsigned long)took_ms,
+             (unsigned long)(wifi.radio_on_ms / wifi.sessions));
+  }
+  else
+  {
+    ESP_LOGI(TAG, "Time %s by %+lld ms, %lu ms after connecting",
+             stepped ? "stepped" : "slewed", (long long)(offset_us / 1000),
+             (unsigned long)took_ms);
+  }
+}
+
+static void work_task_fn(void *arg)
+{
+  (void)arg;
+
+  for (;;)
+  {
+    uint32_t work = 0;
+    xTaskNotifyWait(0, UINT32_MAX, &work, portMAX_DELAY);
+    work_busy = true;
+
+    portENTER_CRITICAL(&state_mux);
+    ble_sync_time_t t = rx_time;
+    int64_t t_us = rx_time_us;
+    ble_sync_local_info_t zone = rx_zone;
+    bool zone_ok = have_zone;
+    int64_t conn_us = connected_at_us;
+    portEXIT_CRITICAL(&state_mux);
+
+    // A zone written after the time changes what that time meant
+    if ((work & WORK_ZONE) && zone_ok && apply_zone(&zone))
+    {
+      work |= WORK_TIME;
+    }
+    if ((work & WORK_TIME) && t_us != 0)
+    {
+      apply_time(&t, t_us, conn_us);
+    }
+    work_busy = false;
+  }
+}
+
+static void slow_timer_cb(void *arg)
+{
+  (void)arg;
+  const struct ble_gap_upd_params params = {
+      .itvl_min = BLE_GAP_CONN_ITVL_MS(SLOW_ITVL_MIN_MS),
+      .itvl_max = BLE_GAP_CONN_ITVL_MS(SLOW_ITVL_MAX_MS),
+      .latency = CONFIG_BLE_SYNC_CONN_LATENCY,
+      .supervision_timeout = BLE_GAP_SUPERVISION_TIMEOUT_MS(SLOW_TIMEOUT_MS),
+  };
+  uint16_t handle = conn_handle;
+  if (handle != BLE_HS_CONN_HANDLE_NONE)
+  {
+    int rc = ble_gap_update_params(handle, &params);
+    if (rc != 0)
+    {
+      ESP_LOGW(TAG, "Connection update request failed: %d", rc);
+    }
+  }
+}
+
+static void log_conn_params(uint16_t handle)
+{
+  struct ble_gap_conn_desc desc;
+  if (ble_gap_conn_find(handle, &desc) == 0)
+  {
+    // Interval in 1.25 ms units, timeout in 10 ms units
+    ESP_LOGI(TAG, "Connection interval %u ms, latency %u, timeout %u ms",
+             desc.conn_itvl * 5 / 4, desc.conn_latency,
+             desc.supervision_timeout * 10);
+  }
+}
+
+static int gap_event(struct ble_gap_event *event, void *arg)
+{
+  (void)arg;
+  int64_t now_us = esp_timer_get_time();
+
+  switch (event->type)
+  {
+  case BLE_GAP_EVENT_CONNECT:
+    if (event->connect.status != 0)
+    {
+      advertise();
+      return 0;
+    }
+    portENTER_CRITICAL(&state_mux);
+    conn_handle = event->connect.conn_handle;
+    connected_at_us = now_us;
+    rx_time_us = 0;
+    have_zone = false;
+    stats.connections++;
+    portEXIT_CRITICAL(&state_mux);
+    ESP_LOGI(TAG, "Phone connected");
+    // Let the phone discover services at its own pace first
+    esp_timer_start_once(slow_timer,
+                         (uint64_t)CONFIG_BLE_SYNC_SLOW_AFTER_S * 1000000);
+    return 0;
+
+  case BLE_GAP_EVENT_DISCONNECT:
+  {
+    esp_timer_stop(slow_timer);
+    portENTER_CRITICAL(&state_mux);
+    uint64_t connected_ms =
+        connected_at_us ? (uint64_t)(now_us - connected_at_us) / 1000 : 0;
+    stats.connected_ms += connected_ms;
+    conn_handle = BLE_HS_CONN_HANDLE_NONE;
+    connected_at_us = 0;
+    ble_sync_stats_t s = stats;
+    portEXIT_CRITICAL(&state_mux);
+
+    int64_t span_ms = now_us / 1000 - s.since_ms;
+    ESP_LOGI(TAG,
+             "Phone disconnected (reason 0x%x) after %llu ms; %lu syncs in "
+             "%lu connections, connected %lu s/day",
+             event->disconnect.reason, (unsigned long long)connected_ms,
+             (unsigned long)s.time_syncs, (unsigned long)s.connections,
+             (unsigned long)(span_ms > 0 ? s.connected_ms * 86400 / span_ms
+                                         : 0));
+    advertise();
+    return 0;
+  }
+
+  case BLE_GAP_EVENT_CONN_UPDATE:
+    if (event->conn_update.status == 0)
+    {
+      log_conn_params(event->conn_update.conn_handle);
+    }
+    return 0;
+
+  case BLE_GAP_EVENT_ADV_COMPLETE:
+    advertise();
+    return 0;
+
+  case BLE_GAP_EVENT_REPEAT_PAIRING:
+  {
+    // The phone lost its bond; forget ours and pair again
+    struct ble_gap_conn_desc desc;
+    if (ble_gap_conn_find(event->repeat_pairing.conn_handle, &desc) == 0)
+    {
+      ble_store_util_delete_peer(&desc.peer_id_addr);
+    }
+    return BLE_GAP_REPEAT_PAIRING_RETRY;
+  }
+
+  default:
+    return 0;
+  }
+}
+
+static void advertise(void)
+{
+  const char *name = ble_svc_gap_device_name();
+  struct ble_hs_adv_fields fields = {
+      .flags = BLE_HS_ADV_F_DISC_GEN | BLE_HS_ADV_F_BREDR_UNSUP,
+      .name = (const uint8_t *)name,
+      .name_len = (uint8_t)strlen(name),
+      .name_is_complete = 1,
+      .uuids16 = (ble_uuid16_t[]){BLE_UUID16_INIT(CTS_SERVICE_UUID)},
+      .num_uuids16 = 1,
+      .uuids16_is_complete = 1,
+  };
+  int rc = ble_gap_adv_set_fields(&fields);
+  if (rc != 0)
+  {
+    ESP_LOGE(TAG, "Advertising data rejected: %d", rc);
+    return;
+  }
+
+  const struct ble_gap_adv_params params = {
+      .conn_mode = BLE_GAP_CONN_MODE_UND,
+      .disc_mode = BLE_GAP_DISC_MODE_GEN,
+      .itvl_min = BLE_GAP_ADV_ITVL_MS(CONFIG_BLE_SYNC_ADV_INTERVAL_MS),
+      .itvl_max = BLE_GAP_ADV_ITVL_MS(CONFIG_BLE_SYNC_ADV_INTERVAL_MS),
+  };
+  rc = ble_gap_adv_start(own_addr_type, NULL, BLE_HS_FOREVER, &params,
+                         gap_event, NULL);
+  if (rc != 0 && rc != BLE_HS_EALREADY)
+  {
+    ESP_LOGE(TAG, "Advertising failed: %d", rc);
+  }
+}
+
+static void on_sync(void)
+{
+  ble_hs_util_ensure_addr(0);
+  if (ble_hs_id_infer_auto(0, &own_addr_type) != 0)
+  {
+    ESP_LOGE(TAG, "No usable BLE address");
+    return;
+  }
+  advertise();
+}
+
+static void on_reset(int reason)
+{
+  ESP_LOGW(TAG, "BLE host reset, reason %d", reason);
+}
+
+static void host_task(void *param)
+{
+  (void)param;
+  nimble_port_run(); // Returns only after nimble_port_stop()
+  nimble_port_freertos_deinit();
+}
+
+/**
+ * @brief Tell a connected phone the time changed (CTS notify)
+ */
+static void time_sync_event(const event_t *event, void *user_data)
+{
+  (void)user_data;
+  if (event->time_sync.ok && conn_handle != BLE_HS_CONN_HANDLE_NONE)
+  {
+    ble_gatts_chr_updated(current_time_handle);
+  }
+}
+
+/**
+ * @brief Keep the SoC awake while a phone that just connected sets the time
+ */
+static esp_err_t ble_sleep_prepare(sleep_manager_sleep_type_t sleep_type,
+                                   void *user_data)
+{
+  (void)sleep_type;
+  (void)user_data;
+  portENTER_CRITICAL(&state_mux);
+  int64_t since = connected_at_us;
+  portEXIT_CRITICAL(&state_mux);
+  bool syncing = work_busy ||
+                 (since && esp_timer_get_time() - since < CONNECT_AWAKE_US);
+  return syncing ? ESP_ERR_INVALID_STATE : ESP_OK;
+}
+
+esp_err_t ble_sync_init(void)
+{
+  if (work_task)
+  {
+    return ESP_OK;
+  }
+
+  esp_err_t ret = nimble_port_init();
+  if (ret != ESP_OK)
+  {
+    ESP_LOGE(TAG, "NimBLE init failed: %s", esp_err_to_name(ret));
+    return ret;
+  }
+
+  ble_hs_cfg.sync_cb = on_sync;
+  ble_hs_cfg.reset_cb = on_reset;
+  ble_hs_cfg.store_status_cb = ble_store_util_status_rr;
+#ifdef CONFIG_BLE_SYNC_REQUIRE_PAIRING
+  // No display or keys for a passkey: Just Works, bonded
+  ble_hs_cfg.sm_io_cap = BLE_SM_IO_CAP_NO_IO;
+  ble_hs_cfg.sm_bonding = 1;
+  ble_hs_cfg.sm_sc = 1;
+  ble_hs_cfg.sm_our_key_dist =
+      BLE_SM_PAIR_KEY_DIST_ENC | BLE_SM_PAIR_KEY_DIST_ID;
+  ble_hs_cfg.sm_their_key_dist =
+      BLE_SM_PAIR_KEY_DIST_ENC | BLE_SM_PAIR_KEY_DIST_ID;
+#endif
+
+  ble_svc_gap_init();
+  ble_svc_gatt_init();
+  int rc = ble_gatts_count_cfg(services);
+  if (rc == 0)
+  {
+    rc = ble_gatts_add_svcs(services);
+  }
+  if (rc != 0)
+  {
+    ESP_LOGE(TAG, "GATT services rejected: %d", rc);
+    nimble_port_deinit();
+    return ESP_FAIL;
+  }
+  ble_svc_gap_device_name_set(CONFIG_BLE_SYNC_DEVICE_NAME);
+  // A whole notification fits one write
+  ble_att_set_preferred_mtu(BLE_SYNC_NOTIF_MAX_LEN + 3);
+  ble_store_config_init();
+
+  const esp_timer_create_args_t timer_args = {
+      .callback = slow_timer_cb,
+      .name = "ble_slow",
+  };
+  ret = esp_timer_create(&timer_args, &slow_timer);
+  if (ret == ESP_OK &&
+      xTaskCreate(work_task_fn, "ble_sync", 3072, NULL, tskIDLE_PRIORITY + 1,
+                  &work_task) != pdPASS)
+  {
+    ret = ESP_ERR_NO_MEM;
+  }
+  if (ret != ESP_OK)
+  {
+    ESP_LOGE(TAG, "Failed to start: %s", esp_err_to_name(ret));
+    if (slow_timer)
+    {
+      esp_timer_delete(slow_timer);
+      slow_timer = NULL;
+    }
+    nimble_port_deinit();
+    return ret;
+  }
+
+  stats.since_ms = esp_timer_get_time() / 1000;
+  event_bus_subscribe(EVENT_MASK(EVENT_TIME_SYNC), EVENT_CTX_WORKER,
+                      time_sync_event, NULL);
+
+  const sleep_manager_hook_t hook = {
+      .name = "ble_sync",
+      .priority = SLEEP_HOOK_PRIORITY_DEFAULT,
+      .can_veto = true,
+      .prepare = ble_sleep_prepare,
+  };
+  ret = sleep_manager_register_hook(&hook);
+  if (ret != ESP_OK)
+  {
+    ESP_LOGW(TAG, "No sleep hook (%s)", esp_err_to_name(ret));
+  }
+
+  nimble_port_freertos_init(host_task);
+  ESP_LOGI(TAG, "Advertising as \"%s\" every %d ms",
+           CONFIG_BLE_SYNC_DEVICE_NAME, CONFIG_BLE_SYNC_ADV_INTERVAL_MS);
+  return ESP_OK;
+}
+
+void ble_sync_get_stats(ble_sync_stats_t *out)
+{
+  if (!out)
+  {
+    return;
+  }
+  int64_t now_us = esp_timer_get_time();
+  portENTER_CRITICAL(&state_mux);
+  *out = stats;
+  if (connected_at_us)
+  {
+    out->connected_ms += (uint64_t)(now_us - connected_at_us) / 1000;
+  }
+  portEXIT_CRITICAL(&state_mux);
+}
+
+bool ble_sync_get_notification(size_t index, ble_sync_notif_t *out)
+{
+  bool found = false;
+  portENTER_CRITICAL(&state_mux);
+  if (index < notif_count && out)
+  {
+    *out = notifs[index];
+    found = true;
+  }
+  portEXIT_CRITICAL(&state_mux);
+  return found;
+}
+
+#else
+
+esp_err_t ble_sync_init(void) { return ESP_OK; }
+
+void ble_sync_get_stats(ble_sync_stats_t *stats)
+{
+  if (stats)
+  {
+    memset(stats, 0, sizeof(*stats));
+  }
+}
+
+bool ble_sync_get_notification(size_t index, ble_sync_notif_t *out)
+{
+  (void)index;
+  (void)out;
+  return false;
+}
+
+#endif // CONFIG_BLE_SYNC_ENABLE
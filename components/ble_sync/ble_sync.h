@@ -0,0 +1,60 @@
+/**
+ * @file ble_sync.h
+ * @brief BLE time and notification sync with the phone
+ *
+ * A BLE peripheral the phone can set the clock through without WiFi:
+ *
+ * - Current Time Service (0x1805): writing Current Time, and optionally
+ *   Local Time Information, sets the system clock and the RTC the same way
+ *   an NTP sync does (clock_service), counts as the NTP client's last sync
+ *   and publishes EVENT_TIME_SYNC. Reads return the watch's time.
+ * - A notification characteristic (see ble_sync_codec.h) keeps the last
+ *   CONFIG_BLE_SYNC_NOTIF_SLOTS phone notifications and publishes
+ *   EVENT_NOTIFICATION for each write.
+ *
+ * Advertising is slow (CONFIG_BLE_SYNC_ADV_INTERVAL_MS) and a connection
+ * moves to a long interval with slave latency once the phone has had time
+ * to discover the services. Every time sync logs the connection time it
+ * took next to the average WiFi session of the network scheduler.
+ *
+ * Enable with CONFIG_BLE_SYNC_ENABLE (needs the NimBLE host).
+ */
+
+#ifndef BLE_SYNC_H
+#define BLE_SYNC_H
+
+#include "ble_sync_codec.h"
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  uint32_t connections;
+  uint32_t time_syncs;
+  uint32_t notifications; ///< Writes to the notification characteristic
+  uint64_t connected_ms;  ///< Total time with a phone connected
+  uint32_t last_sync_ms;  ///< Connect to clock set, last time sync
+  int64_t since_ms;       ///< When accounting started
+} ble_sync_stats_t;
+
+/* Start the BLE host, the GATT services and advertising */
+esp_err_t ble_sync_init(void);
+
+void ble_sync_get_stats(ble_sync_stats_t *stats);
+
+/*
+ * Copy a kept notification, index 0 being the newest. Returns false past
+ * the last one.
+ */
+bool ble_sync_get_notification(size_t index, ble_sync_notif_t *out);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BLE_SYNC_H
@@ -0,0 +1,274 @@
+/**
+ * @file ble_sync_codec.c
+ * @brief GATT payload codec implementation
+ */
+
+#include "ble_sync_codec.h"
+#include <string.h>
+
+#define TZ_MIN_QUARTERS (-48) // UTC-12:00
+#define TZ_MAX_QUARTERS 56    // UTC+14:00
+#define QUARTER_S 900
+
+static bool is_leap(uint16_t year)
+{
+  return (year % 4 == 0 && year % 100 != 0) || year % 400 == 0;
+}
+
+static uint8_t days_in_month(uint16_t year, uint8_t month)
+{
+  static const uint8_t days[12] = {31, 28, 31, 30, 31, 30,
+                                   31, 31, 30, 31, 30, 31};
+  return month == 2 && is_leap(year) ? 29 : days[month - 1];
+}
+
+/**
+ * @brief Days since 1970-01-01 of a proleptic Gregorian date
+ */
+static int64_t days_from_civil(int64_t y, unsigned m, unsigned d)
+{
+  y -= m <= 2;
+  const int64_t era = (y >= 0 ? y : y - 399) / 400;
+  const unsigned yoe = (unsigned)(y - era * 400);
+  const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+  const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  return era * 146097 + (int64_t)doe - 719468;
+}
+
+static void civil_from_days(int64_t z, int64_t *y, unsigned *m, unsigned *d)
+{
+  z += 719468;
+  const int64_t era = (z >= 0 ? z : z - 146096) / 146097;
+  const unsigned doe = (unsigned)(z - era * 146097);
+  const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+  const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+  const unsigned mp = (5 * doy + 2) / 153;
+  *d = doy - (153 * mp + 2) / 5 + 1;
+  *m = mp < 10 ? mp + 3 : mp - 9;
+  *y = (int64_t)yoe + era * 400 + (*m <= 2);
+}
+
+static int64_t floor_div(int64_t a, int64_t b)
+{
+  return a / b - (a % b != 0 && (a < 0) != (b < 0));
+}
+
+bool ble_sync_decode_time(const uint8_t *buf, size_t len,
+                          ble_sync_time_t *out)
+{
+  if (len != BLE_SYNC_TIME_LEN)
+  {
+    return false;
+  }
+
+  ble_sync_time_t t = {
+      .year = (uint16_t)(buf[0] | (buf[1] << 8)),
+      .month = buf[2],
+      .day = buf[3],
+      .hours = buf[4],
+      .minutes = buf[5],
+      .seconds = buf[6],
+      .day_of_week = buf[7],
+      .fractions256 = buf[8],
+      .adjust_reason = buf[9],
+  };
+  // Year and month may be 0 ("unknown") in the spec; useless for a clock
+  if (t.year < 1582 || t.year > 9999 || t.month < 1 || t.month > 12 ||
+      t.day < 1 || t.day > days_in_month(t.year, t.month) || t.hours > 23 ||
+      t.minutes > 59 || t.seconds > 59 || t.day_of_week > 7)
+  {
+    return false;
+  }
+  *out = t;
+  return true;
+}
+
+size_t ble_sync_encode_time(const ble_sync_time_t *t, uint8_t *buf,
+                            size_t len)
+{
+  if (len < BLE_SYNC_TIME_LEN)
+  {
+    return 0;
+  }
+  buf[0] = (uint8_t)(t->year & 0xFF);
+  buf[1] = (uint8_t)(t->year >> 8);
+  buf[2] = t->month;
+  buf[3] = t->day;
+  buf[4] = t->hours;
+  buf[5] = t->minutes;
+  buf[6] = t->seconds;
+  buf[7] = t->day_of_week;
+  buf[8] = t->fractions256;
+  buf[9] = t->adjust_reason;
+  return BLE_SYNC_TIME_LEN;
+}
+
+bool ble_sync_decode_local_info(const uint8_t *buf, size_t len,
+                                ble_sync_local_info_t *out)
+{
+  if (len != BLE_SYNC_LOCAL_INFO_LEN)
+  {
+    return false;
+  }
+
+  int8_t tz = (int8_t)buf[0];
+  uint8_t dst = buf[1];
+  if (tz != BLE_SYNC_TZ_UNKNOWN &&
+      (tz < TZ_MIN_QUARTERS || tz > TZ_MAX_QUARTERS))
+  {
+    return false;
+  }
+  if (dst != 0 && dst != 2 && dst != 4 && dst != 8 &&
+      dst != BLE_SYNC_DST_UNKNOWN)
+  {
+    return false;
+  }
+  out->tz_quarters = tz;
+  out->dst_quarters = dst;
+  return true;
+}
+
+size_t ble_sync_encode_local_info(const ble_sync_local_info_t *info,
+                                  uint8_t *buf, size_t len)
+{
+  if (len < BLE_SYNC_LOCAL_INFO_LEN)
+  {
+    return 0;
+  }
+  buf[0] = (uint8_t)info->tz_quarters;
+  buf[1] = info->dst_quarters;
+  return BLE_SYNC_LOCAL_INFO_LEN;
+}
+
+int32_t ble_sync_local_offset_s(const ble_sync_local_info_t *info)
+{
+  int32_t quarters = 0;
+  if (info->tz_quarters != BLE_SYNC_TZ_UNKNOWN)
+  {
+    quarters += info->tz_quarters;
+  }
+  if (info->dst_quarters != BLE_SYNC_DST_UNKNOWN)
+  {
+    quarters += info->dst_quarters;
+  }
+  return quarters * QUARTER_S;
+}
+
+int64_t ble_sync_time_to_utc_us(const ble_sync_time_t *t, int32_t offset_s)
+{
+  int64_t days = days_from_civil(t->year, t->month, t->day);
+  int64_t local_s = days * 86400 + t->hours * 3600 + t->minutes * 60 +
+                    t->seconds;
+  return (local_s - offset_s) * 1000000 +
+         (int64_t)t->fractions256 * 1000000 / 256;
+}
+
+void ble_sync_time_from_utc_us(int64_t utc_us, int32_t offset_s,
+                               uint8_t adjust_reason, ble_sync_time_t *out)
+{
+  int64_t local_us = utc_us + (int64_t)offset_s * 1000000;
+  int64_t local_s = floor_div(local_us, 1000000);
+  int64_t frac_us = local_us - local_s * 1000000;
+  int64_t days = floor_div(local_s, 86400);
+  int64_t sod = local_s - days * 86400;
+
+  int64_t year;
+  unsigned month, day;
+  civil_from_days(days, &year, &month, &day);
+
+  out->year = (uint16_t)year;
+  out->month = (uint8_t)month;
+  out->day = (uint8_t)day;
+  out->hours = (uint8_t)(sod / 3600);
+  out->minutes = (uint8_t)(sod / 60 % 60);
+  out->seconds = (uint8_t)(sod % 60);
+  // 1970-01-01 was a Thursday
+  out->day_of_week = (uint8_t)((days % 7 + 7 + 3) % 7 + 1);
+  int64_t frac = (frac_us * 256 + 500000) / 1000000;
+  out->fractions256 = (uint8_t)(frac > 255 ? 255 : frac);
+  out->adjust_reason = adjust_reason;
+}
+
+/**
+ * @brief Longest prefix of len bytes or less that ends on a character
+ *
+ * Backs off over UTF-8 continuation bytes when the cut would split one.
+ */
+static size_t utf8_fit(const uint8_t *src, size_t avail, size_t len)
+{
+  if (avail <= len)
+  {
+    return avail;
+  }
+  while (len > 0 && (src[len] & 0xC0) == 0x80)
+  {
+    len--;
+  }
+  return len;
+}
+
+static void copy_text(char *dst, size_t size, const uint8_t *src,
+                      size_t len)
+{
+  size_t n = utf8_fit(src, len, size - 1);
+  memcpy(dst, src, n);
+  dst[n] = '\0';
+}
+
+bool ble_sync_decode_notif(const uint8_t *buf, size_t len,
+                           ble_sync_notif_t *out)
+{
+  if (len < BLE_SYNC_NOTIF_HEADER_LEN || buf[0] > BLE_SYNC_NOTIF_CLEAR)
+  {
+    return false;
+  }
+
+  memset(out, 0, sizeof(*out));
+  out->op = buf[0];
+  out->category =
+      buf[1] < BLE_SYNC_CATEGORY_COUNT ? buf[1] : BLE_SYNC_CATEGORY_OTHER;
+  out->id = (uint16_t)(buf[2] | (buf[3] << 8));
+
+  const uint8_t *text = buf + BLE_SYNC_NOTIF_HEADER_LEN;
+  size_t text_len = len - BLE_SYNC_NOTIF_HEADER_LEN;
+  size_t title_len = buf[4] < text_len ? buf[4] : text_len;
+  copy_text(out->title, sizeof(out->title), text, title_len);
+  copy_text(out->body, sizeof(out->body), text + title_len,
+            text_len - title_len);
+  return true;
+}
+
+size_t ble_sync_encode_notif(const ble_sync_notif_t *n, uint8_t *buf,
+                             size_t len)
+{
+  if (len < BLE_SYNC_NOTIF_HEADER_LEN)
+  {
+    return 0;
+  }
+
+  size_t room = len - BLE_SYNC_NOTIF_HEADER_LEN;
+  if (room > UINT8_MAX)
+  {
+    room = UINT8_MAX; // Only the title length is limited
+  }
+  const uint8_t *title = (const uint8_t *)n->title;
+  size_t title_len = utf8_fit(title, strnlen(n->title, sizeof(n->title)),
+                              room);
+
+  uint8_t *p = buf + BLE_SYNC_NOTIF_HEADER_LEN;
+  memcpy(p, title, title_len);
+  p += title_len;
+
+  const uint8_t *body = (const uint8_t *)n->body;
+  size_t body_len = utf8_fit(body, strnlen(n->body, sizeof(n->body)),
+                             len - (size_t)(p - buf));
+  memcpy(p, body, body_len);
+  p += body_len;
+
+  buf[0] = n->op;
+  buf[1] = n->category;
+  buf[2] = (uint8_t)(n->id & 0xFF);
+  buf[3] = (uint8_t)(n->id >> 8);
+  buf[4] = (uint8_t)title_len;
+  return (size_t)(p - buf);
+}
@@ -0,0 +1,140 @@
+/**
+ * @file ble_sync_codec.h
+ * @brief GATT payload codec for BLE time and notification sync (pure)
+ *
+ * Encodes and decodes the characteristic values served by ble_sync.c.
+ * Kept free of NimBLE and ESP-IDF so it can be checked on the host.
+ *
+ * Current Time (0x2A2B, Current Time Service), 10 bytes, little endian:
+ *
+ *   year u16 | month | day | hours | minutes | seconds | day of week |
+ *   fractions256 | adjust reason
+ *
+ * The time is the phone's local wall time. Local Time Information
+ * (0x2A0F), 2 bytes, gives the offset that turns it into UTC:
+ *
+ *   time zone s8 (15 min units) | DST offset u8 (15 min units)
+ *
+ * Notification (custom characteristic), at most BLE_SYNC_NOTIF_MAX_LEN:
+ *
+ *   op | category | id u16 | title length | title | body
+ *
+ * Title and body are UTF-8 without terminators; the body runs to the end
+ * of the write. Both are cut to fit at a character boundary.
+ */
+
+#ifndef BLE_SYNC_CODEC_H
+#define BLE_SYNC_CODEC_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define BLE_SYNC_TIME_LEN 10
+#define BLE_SYNC_LOCAL_INFO_LEN 2
+
+/* Adjust reason bits (Current Time) */
+#define BLE_SYNC_ADJUST_MANUAL 0x01
+#define BLE_SYNC_ADJUST_EXTERNAL 0x02 ///< Set from a reference time source
+#define BLE_SYNC_ADJUST_TZ 0x04
+#define BLE_SYNC_ADJUST_DST 0x08
+
+#define BLE_SYNC_TZ_UNKNOWN (-128)
+#define BLE_SYNC_DST_UNKNOWN 255
+
+/* Notification header, then up to this much title and body */
+#define BLE_SYNC_NOTIF_HEADER_LEN 5
+#define BLE_SYNC_NOTIF_MAX_LEN 244 ///< One write at the largest ATT MTU
+#define BLE_SYNC_NOTIF_TITLE_LEN 32 ///< Stored, terminator included
+#define BLE_SYNC_NOTIF_BODY_LEN 96
+
+typedef struct {
+  uint16_t year;
+  uint8_t month;        ///< 1-12
+  uint8_t day;          ///< 1-31
+  uint8_t hours;
+  uint8_t minutes;
+  uint8_t seconds;
+  uint8_t day_of_week;  ///< 1 = Monday .. 7 = Sunday, 0 unknown
+  uint8_t fractions256; ///< 1/256 s
+  uint8_t adjust_reason;
+} ble_sync_time_t;
+
+typedef struct {
+  int8_t tz_quarters;   ///< UTC offset, or BLE_SYNC_TZ_UNKNOWN
+  uint8_t dst_quarters; ///< 0, 2, 4 or 8, or BLE_SYNC_DST_UNKNOWN
+} ble_sync_local_info_t;
+
+typedef enum {
+  BLE_SYNC_NOTIF_POST = 0,   ///< New or updated notification
+  BLE_SYNC_NOTIF_REMOVE = 1, ///< Dismissed on the phone; id only
+  BLE_SYNC_NOTIF_CLEAR = 2,  ///< Drop all
+} ble_sync_notif_op_t;
+
+/* Categories, numbered as in Apple's ANCS so a bridge can pass them on */
+typedef enum {
+  BLE_SYNC_CATEGORY_OTHER = 0,
+  BLE_SYNC_CATEGORY_CALL = 1,
+  BLE_SYNC_CATEGORY_MISSED_CALL = 2,
+  BLE_SYNC_CATEGORY_VOICEMAIL = 3,
+  BLE_SYNC_CATEGORY_SOCIAL = 4,
+  BLE_SYNC_CATEGORY_SCHEDULE = 5,
+  BLE_SYNC_CATEGORY_EMAIL = 6,
+  BLE_SYNC_CATEGORY_NEWS = 7,
+  BLE_SYNC_CATEGORY_HEALTH = 8,
+  BLE_SYNC_CATEGORY_BUSINESS = 9,
+  BLE_SYNC_CATEGORY_LOCATION = 10,
+  BLE_SYNC_CATEGORY_ENTERTAINMENT = 11,
+  BLE_SYNC_CATEGORY_COUNT
+} ble_sync_category_t;
+
+typedef struct {
+  uint16_t id;
+  uint8_t op;       ///< ble_sync_notif_op_t
+  uint8_t category; ///< ble_sync_category_t
+  char title[BLE_SYNC_NOTIF_TITLE_LEN];
+  char body[BLE_SYNC_NOTIF_BODY_LEN];
+} ble_sync_notif_t;
+
+/* False for a wrong length or an impossible date or time */
+bool ble_sync_decode_time(const uint8_t *buf, size_t len,
+                          ble_sync_time_t *out);
+
+/* Writes BLE_SYNC_TIME_LEN bytes; returns 0 if buf is too small */
+size_t ble_sync_encode_time(const ble_sync_time_t *t, uint8_t *buf,
+                            size_t len);
+
+/* False for a wrong length or an offset outside -48..+56 */
+bool ble_sync_decode_local_info(const uint8_t *buf, size_t len,
+                                ble_sync_local_info_t *out);
+
+size_t ble_sync_encode_local_info(const ble_sync_local_info_t *info,
+                                  uint8_t *buf, size_t len);
+
+/* Seconds to add to UTC for local time; unknown parts count as 0 */
+int32_t ble_sync_local_offset_s(const ble_sync_local_info_t *info);
+
+/* Local wall time to UTC microseconds */
+int64_t ble_sync_time_to_utc_us(const ble_sync_time_t *t, int32_t offset_s);
+
+/* UTC microseconds to local wall time, e.g. to answer a read */
+void ble_sync_time_from_utc_us(int64_t utc_us, int32_t offset_s,
+                               uint8_t adjust_reason, ble_sync_time_t *out);
+
+/* False if shorter than the header, or an unknown op */
+bool ble_sync_decode_notif(const uint8_t *buf, size_t len,
+                           ble_sync_notif_t *out);
+
+/* Title and body are cut to fit len; returns the bytes written, 0 on error */
+size_t ble_sync_encode_notif(const ble_sync_notif_t *n, uint8_t *buf,
+                             size_t len);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // BLE_SYNC_CODEC_H
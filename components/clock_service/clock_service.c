@@ -0,0 +1,508 @@
+/**
+ * @file clock_service.c
+ * @brief UTC system clock seeded from and disciplined against the RTC
+ */
+
+#include "clock_service.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "rtc_drift.h"
+#include "rtc_pcf85063.h"
+#include "sdkconfig.h"
+#include "settings_storage.h"
+#include <stdlib.h>
+#include <sys/time.h>
+
+static const char *TAG = "Clock";
+
+// Anything earlier means the system clock was never set
+#define CLOCK_VALID_EPOCH 1600000000
+
+#define DISCIPLINE_INTERVAL_US                                                 \
+  ((int64_t)CONFIG_CLOCK_SERVICE_DISCIPLINE_INTERVAL_MIN * 60 * 1000000)
+
+static volatile int32_t utc_offset_sec = 0;
+static bool utc_offset_set = false;
+static int64_t last_discipline_us = 0;
+static volatile bool discipline_requested = false;
+
+// First RTC increment after releasing STOP (datasheet: 0.507813-0.507935 s)
+#define RTC_STOP_RELEASE_LEAD_US 492130
+
+// Poll period when timing an RTC seconds edge
+#define EDGE_POLL_MS 10
+
+// Poll period while waiting for an adjtime() slew
+#define SLEW_POLL_MS 250
+
+// UTC second at which the RTC was last set aligned, 0 if unknown
+static uint32_t rtc_set_at = 0;
+
+#ifdef CONFIG_CLOCK_SERVICE_DRIFT_COMPENSATION
+static rtc_drift_t drift;
+static int8_t offset_steps = 0;
+#endif
+
+/**
+ * @brief struct tm (UTC) to epoch seconds without touching TZ
+ *
+ * mktime() would apply the POSIX TZ variable; this is timegm() for the
+ * proleptic Gregorian calendar.
+ */
+static time_t tm_to_utc(const struct tm *tm)
+{
+  int year = tm->tm_year + 1900;
+  int month = tm->tm_mon + 1;
+  if (month <= 2)
+  {
+    year--;
+  }
+
+  int era = (year >= 0 ? year : year - 399) / 400;
+  int yoe = year - era * 400;
+  int doy = (153 * (month + (month > 2 ? -3 : 9)) + 2) / 5 + tm->tm_mday - 1;
+  int doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+  int64_t days = (int64_t)era * 146097 + doe - 719468;
+
+  return (time_t)(days * 86400 + tm->tm_hour * 3600 + tm->tm_min * 60 +
+                  tm->tm_sec);
+}
+
+static esp_err_t read_rtc_utc(time_t *utc)
+{
+  struct tm rtc_time;
+  esp_err_t ret = rtc_read_time(&rtc_time);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+
+  *utc = tm_to_utc(&rtc_time);
+  return ESP_OK;
+}
+
+static esp_err_t write_rtc_utc(time_t utc)
+{
+  struct tm rtc_time;
+  gmtime_r(&utc, &rtc_time);
+  return rtc_write_time(&rtc_time);
+}
+
+static int64_t system_time_us(void)
+{
+  struct timeval tv;
+  gettimeofday(&tv, NULL);
+  return (int64_t)tv.tv_sec * 1000000 + tv.tv_usec;
+}
+
+/**
+ * @brief Sleep, then spin, until the system clock reaches target_us
+ */
+static void wait_until_us(int64_t target_us)
+{
+  int64_t remaining = target_us - system_time_us();
+  if (remaining > 20000)
+  {
+    vTaskDelay(pdMS_TO_TICKS((remaining - 20000) / 1000));
+  }
+  while (system_time_us() < target_us)
+  {
+  }
+}
+
+/**
+ * @brief Set the RTC so its seconds tick together with the system clock
+ *
+ * The RTC is held stopped, loaded with the next second and released just
+ * early enough that its first increment lands on the following boundary.
+ * Blocks for up to 1.5 s.
+ */
+static esp_err_t write_rtc_aligned(time_t *set_at)
+{
+  esp_err_t ret = rtc_set_stopped(true);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+
+  time_t target = (time_t)(system_time_us() / 1000000) + 1;
+  ret = write_rtc_utc(target);
+  if (ret == ESP_OK)
+  {
+    wait_until_us((int64_t)target * 1000000 + RTC_STOP_RELEASE_LEAD_US);
+  }
+
+  // Always release, or the RTC would stay stopped
+  esp_err_t release_ret = rtc_set_stopped(false);
+  if (ret == ESP_OK)
+  {
+    ret = release_ret;
+  }
+  if (ret == ESP_OK)
+  {
+    *set_at = target;
+  }
+  return ret;
+}
+
+#ifdef CONFIG_CLOCK_SERVICE_DRIFT_COMPENSATION
+/**
+ * @brief RTC minus system time, timed on an RTC seconds edge
+ *
+ * A plain read only has one-second resolution; polling until the seconds
+ * register changes pins the RTC to within EDGE_POLL_MS.
+ */
+static esp_err_t measure_rtc_error_ms(int32_t *error_ms)
+{
+  time_t first = 0;
+  esp_err_t ret = read_rtc_utc(&first);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+
+  for (int i = 0; i < 1100 / EDGE_POLL_MS; i++)
+  {
+    vTaskDelay(pdMS_TO_TICKS(EDGE_POLL_MS));
+
+    time_t rtc_now = 0;
+    int64_t sys_us = system_time_us();
+    ret = read_rtc_utc(&rtc_now);
+    if (ret != ESP_OK)
+    {
+      return ret;
+    }
+    if (rtc_now != first)
+    {
+      // The edge happened between the previous and this poll
+      int64_t edge_us = sys_us - EDGE_POLL_MS * 1000 / 2;
+      *error_ms = (int32_t)(((int64_t)rtc_now * 1000000 - edge_us) / 1000);
+      return ESP_OK;
+    }
+  }
+  return ESP_ERR_TIMEOUT;
+}
+
+static void drift_load(void)
+{
+  int32_t ppb = 0;
+  uint32_t weight = 0;
+  uint32_t samples = 0;
+
+  rtc_drift_init(&drift);
+  settings_get_int(SETTING_KEY_DRIFT_PPB, 0, &ppb);
+  settings_get_uint(SETTING_KEY_DRIFT_WEIGHT, 0, &weight);
+  settings_get_uint(SETTING_KEY_DRIFT_SAMPLES, 0, &samples);
+  drift.drift_ppb = ppb;
+  drift.weight = weight;
+  drift.samples = (uint16_t)(samples > UINT16_MAX ? UINT16_MAX : samples);
+
+  if (rtc_get_offset(&offset_steps) != ESP_OK)
+  {
+    offset_steps = 0;
+  }
+}
+
+static void drift_save(void)
+{
+  settings_set_int(SETTING_KEY_DRIFT_PPB, drift.drift_ppb);
+  settings_set_uint(SETTING_KEY_DRIFT_WEIGHT, drift.weight);
+  settings_set_uint(SETTING_KEY_DRIFT_SAMPLES, drift.samples);
+}
+
+/**
+ * @brief Compare the RTC against the freshly synced system clock
+ *
+ * Feeds the estimator and reprograms the offset register if the estimate
+ * calls for a different value.
+ */
+static void drift_update(time_t now)
+{
+  int32_t error_ms = 0;
+  if (rtc_set_at == 0 || (uint32_t)now <= rtc_set_at ||
+      measure_rtc_error_ms(&error_ms) != ESP_OK)
+  {
+    return;
+  }
+
+  uint32_t interval_s = (uint32_t)now - rtc_set_at;
+  rtc_drift_result_t result =
+      rtc_drift_add_sample(&drift, error_ms, interval_s, offset_steps);
+
+  int8_t steps = rtc_drift_offset_steps(&drift);
+  if (steps != offset_steps && rtc_set_offset(steps) == ESP_OK)
+  {
+    offset_steps = steps;
+  }
+
+  if (result == RTC_DRIFT_ACCEPTED)
+  {
+    drift_save();
+  }
+
+  ESP_LOGI(TAG,
+           "RTC error %+ld ms over %lu min (%s); drift %+ld ppb +/- %lu, "
+           "offset %d",
+           (long)error_ms, (unsigned long)(interval_s / 60),
+           result == RTC_DRIFT_ACCEPTED  ? "used"
+           : result == RTC_DRIFT_OUTLIER ? "outlier"
+                                         : "too short",
+           (long)drift.drift_ppb,
+           (unsigned long)rtc_drift_uncertainty_ppb(&drift), offset_steps);
+}
+#endif // CONFIG_CLOCK_SERVICE_DRIFT_COMPENSATION
+
+/**
+ * @brief Set the system clock from an RTC reading
+ *
+ * The RTC only counts whole seconds, so assume we are halfway through one.
+ */
+static void set_system_clock(time_t utc)
+{
+  struct timeval tv = {.tv_sec = utc, .tv_usec = 500000};
+  settimeofday(&tv, NULL);
+}
+
+esp_err_t clock_service_init(void)
+{
+  if (!utc_offset_set)
+  {
+    int32_t offset = 0;
+    settings_get_int(SETTING_KEY_UTC_OFFSET, 0, &offset);
+    utc_offset_sec = offset;
+    utc_offset_set = true;
+  }
+
+  time_t utc = 0;
+  esp_err_t ret = read_rtc_utc(&utc);
+  if (ret != ESP_OK)
+  {
+    ESP_LOGE(TAG, "Failed to read RTC: %s", esp_err_to_name(ret));
+    return ret;
+  }
+
+  // Earlier firmware kept local time in the RTC, and the build time rtc_init()
+  // falls back to is local too; convert either to UTC once
+  bool rtc_is_utc = false;
+  settings_get_bool(SETTING_KEY_RTC_UTC, false, &rtc_is_utc);
+  uint32_t set_at = 0;
+  settings_get_uint(SETTING_KEY_RTC_SET_AT, 0, &set_at);
+  rtc_set_at = set_at;
+
+  if (!rtc_is_utc || rtc_seeded_from_build_time())
+  {
+    // Not set from NTP: no baseline for drift measurement
+    rtc_set_at = 0;
+    settings_set_uint(SETTING_KEY_RTC_SET_AT, 0);
+
+    utc -= utc_offset_sec;
+    if (write_rtc_utc(utc) == ESP_OK)
+    {
+      settings_set_bool(SETTING_KEY_RTC_UTC, true);
+      ESP_LOGI(TAG, "RTC converted from local time to UTC (offset %ld s)",
+               (long)utc_offset_sec);
+    }
+  }
+
+  set_system_clock(utc);
+  last_discipline_us = esp_timer_get_time();
+
+#ifdef CONFIG_CLOCK_SERVICE_DRIFT_COMPENSATION
+  drift_load();
+#endif
+
+  struct tm local_time;
+  clock_service_get_local_time(&local_time);
+  ESP_LOGI(TAG, "System clock seeded from RTC: %04d-%02d-%02d %02d:%02d:%02d",
+           local_time.tm_year + 1900, local_time.tm_mon + 1,
+           local_time.tm_mday, local_time.tm_hour, local_time.tm_min,
+           local_time.tm_sec);
+  return ESP_OK;
+}
+
+bool clock_service_is_valid(void) { return time(NULL) >= CLOCK_VALID_EPOCH; }
+
+esp_err_t clock_service_get_utc(time_t *utc)
+{
+  if (!utc)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  *utc = time(NULL);
+  return (*utc >= CLOCK_VALID_EPOCH) ? ESP_OK : ESP_ERR_INVALID_STATE;
+}
+
+esp_err_t clock_service_get_local_time(struct tm *local_time)
+{
+  if (!local_time)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  time_t now = time(NULL);
+  if (now < CLOCK_VALID_EPOCH)
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  time_t local = now + utc_offset_sec;
+  gmtime_r(&local, local_time);
+  return ESP_OK;
+}
+
+void clock_service_set_utc_offset(int32_t offset_sec)
+{
+  utc_offset_sec = offset_sec;
+  utc_offset_set = true;
+
+  int32_t stored = 0;
+  if (settings_get_int(SETTING_KEY_UTC_OFFSET, 0, &stored) != ESP_OK ||
+      stored != offset_sec)
+  {
+    settings_set_int(SETTING_KEY_UTC_OFFSET, offset_sec);
+  }
+}
+
+int32_t clock_service_get_utc_offset(void) { return utc_offset_sec; }
+
+esp_err_t clock_service_save_to_rtc(void)
+{
+  time_t now = time(NULL);
+  if (now < CLOCK_VALID_EPOCH)
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+#ifdef CONFIG_CLOCK_SERVICE_DRIFT_COMPENSATION
+  drift_update(now);
+#endif
+
+  time_t set_at = 0;
+  esp_err_t ret = write_rtc_aligned(&set_at);
+  if (ret != ESP_OK)
+  {
+    rtc_set_at = 0;
+    settings_set_uint(SETTING_KEY_RTC_SET_AT, 0);
+    return ret;
+  }
+
+  rtc_set_at = (uint32_t)set_at;
+  settings_set_uint(SETTING_KEY_RTC_SET_AT, rtc_set_at);
+  settings_set_bool(SETTING_KEY_RTC_UTC, true);
+  last_discipline_us = esp_timer_get_time();
+  return ESP_OK;
+}
+
+bool clock_service_correct(int64_t offset_us, uint32_t slew_threshold_ms)
+{
+  if (llabs(offset_us) < (int64_t)slew_threshold_ms * 1000)
+  {
+    struct timeval delta = {
+        .tv_sec = offset_us / 1000000,
+        .tv_usec = offset_us % 1000000,
+    };
+    if (adjtime(&delta, NULL) == 0)
+    {
+      return false;
+    }
+  }
+
+  int64_t target_us = system_time_us() + offset_us;
+  struct timeval tv = {
+      .tv_sec = target_us / 1000000,
+      .tv_usec = target_us % 1000000,
+  };
+  settimeofday(&tv, NULL);
+  return true;
+}
+
+void clock_service_wait_for_slew(uint32_t slew_threshold_ms)
+{
+  // Newlib in ESP-IDF slews at 1/64 of real time
+  const uint32_t max_polls = (slew_threshold_ms * 64) / SLEW_POLL_MS + 2;
+  struct timeval left;
+
+  for (uint32_t i = 0; i < max_polls; i++)
+  {
+    if (adjtime(NULL, &left) != 0 || (left.tv_sec == 0 && left.tv_usec == 0))
+    {
+      return;
+    }
+    vTaskDelay(pdMS_TO_TICKS(SLEW_POLL_MS));
+  }
+}
+
+uint32_t clock_service_sync_interval(uint32_t min_interval_s)
+{
+#ifdef CONFIG_CLOCK_SERVICE_DRIFT_COMPENSATION
+  uint32_t max_s = (uint32_t)CONFIG_CLOCK_SERVICE_SYNC_INTERVAL_MAX_HOURS * 3600;
+  if (min_interval_s > max_s)
+  {
+    return min_interval_s;
+  }
+  return rtc_drift_sync_interval(&drift, offset_steps,
+                                 CONFIG_CLOCK_SERVICE_DRIFT_MAX_ERROR_MS,
+                                 min_interval_s, max_s);
+#else
+  return min_interval_s;
+#endif
+}
+
+esp_err_t clock_service_discipline(void)
+{
+  int64_t now_us = esp_timer_get_time();
+  if (!discipline_requested &&
+      now_us - last_discipline_us < DISCIPLINE_INTERVAL_US)
+  {
+    return ESP_OK;
+  }
+  discipline_requested = false;
+  last_discipline_us = now_us;
+
+  time_t rtc_utc = 0;
+  esp_err_t ret = read_rtc_utc(&rtc_utc);
+  if (ret != ESP_OK)
+  {
+    ESP_LOGW(TAG, "RTC read failed: %s", esp_err_to_name(ret));
+    return ret;
+  }
+
+  time_t sys_utc = time(NULL);
+  int64_t error = (int64_t)sys_utc - (int64_t)rtc_utc;
+  if (llabs(error) >= CONFIG_CLOCK_SERVICE_STEP_THRESHOLD_SEC)
+  {
+    ESP_LOGI(TAG, "System clock off by %lld s, stepping to RTC", error);
+    set_system_clock(rtc_utc);
+  }
+  else
+  {
+    ESP_LOGD(TAG, "System clock within %lld s of RTC", error);
+  }
+  return ESP_OK;
+}
+
+void clock_service_request_discipline(void) { discipline_requested = true; }
+
+esp_err_t clock_service_sync_to_rtc_edge(void)
+{
+  time_t rtc_utc = 0;
+  esp_err_t ret = read_rtc_utc(&rtc_utc);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+
+  // The RTC second has just begun, so its start is never in the future
+  int64_t behind_us = (int64_t)rtc_utc * 1000000 - system_time_us();
+  if (behind_us > 0)
+  {
+    struct timeval tv = {.tv_sec = rtc_utc, .tv_usec = 0};
+    settimeofday(&tv, NULL);
+    ESP_LOGD(TAG, "System clock caught up %lld ms to the RTC edge",
+             (long long)(behind_us / 1000));
+  }
+  return ESP_OK;
+}
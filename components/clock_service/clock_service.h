@@ -0,0 +1,161 @@
+/**
+ * @file clock_service.h
+ * @brief System clock kept in UTC and seeded from the PCF85063
+ *
+ * The RTC holds UTC. At boot (including wake from deep sleep) the system
+ * clock is seeded from it once; afterwards time reads come from
+ * gettimeofday() and cost no I2C traffic. Local time is derived in
+ * software from a UTC offset, so a timezone change never rewrites the RTC.
+ * The system clock is re-disciplined against the RTC periodically and
+ * after light sleep.
+ */
+
+#ifndef CLOCK_SERVICE_H
+#define CLOCK_SERVICE_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+#include <time.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+    /**
+     * @brief Seed the system clock from the RTC
+     *
+     * Call once after rtc_init(). On the first boot after an update from
+     * firmware that kept local time in the RTC, the RTC is converted to
+     * UTC using the current offset.
+     *
+     * @return ESP_OK on success, error code if the RTC could not be read
+     */
+    esp_err_t clock_service_init(void);
+
+    /**
+     * @brief Check whether the system clock holds a valid time
+     *
+     * @return true once seeded from the RTC or set by NTP
+     */
+    bool clock_service_is_valid(void);
+
+    /**
+     * @brief Current UTC time
+     *
+     * @param[out] utc UTC epoch seconds
+     * @return ESP_OK, or ESP_ERR_INVALID_STATE if the clock is not set
+     */
+    esp_err_t clock_service_get_utc(time_t *utc);
+
+    /**
+     * @brief Current local time (UTC plus offset)
+     *
+     * @param[out] local_time Broken-down local time
+     * @return ESP_OK, or ESP_ERR_INVALID_STATE if the clock is not set
+     */
+    esp_err_t clock_service_get_local_time(struct tm *local_time);
+
+    /**
+     * @brief Set the local time offset from UTC, DST included
+     *
+     * Takes effect on the next read and is persisted to settings. Does not
+     * touch the RTC.
+     *
+     * @param offset_sec Offset in seconds (e.g. 7200 for UTC+2)
+     */
+    void clock_service_set_utc_offset(int32_t offset_sec);
+
+    /**
+     * @brief Get the local time offset from UTC in seconds
+     */
+    int32_t clock_service_get_utc_offset(void);
+
+    /**
+     * @brief Write the system clock (UTC) to the RTC
+     *
+     * Call after the system clock was set from an authoritative source
+     * such as NTP. With CONFIG_CLOCK_SERVICE_DRIFT_COMPENSATION the RTC
+     * error since it was last set is measured first and fed to the drift
+     * estimator, which may reprogram the RTC offset register. The RTC is
+     * then set aligned to the system clock's second boundary.
+     *
+     * Blocks for up to about 2.5 s; call from a task, not a callback.
+     *
+     * @return ESP_OK on success, ESP_ERR_INVALID_STATE if the clock is not
+     *         set, or the RTC write error
+     */
+    esp_err_t clock_service_save_to_rtc(void);
+
+    /**
+     * @brief Correct the system clock by an offset from a time reference
+     *
+     * Offsets below slew_threshold_ms are slewed with adjtime() so the
+     * clock never jumps or runs backwards; larger ones are stepped. Used by
+     * NTP and by the phone's time over BLE.
+     *
+     * @param offset_us Correction, + = the clock is behind
+     * @param slew_threshold_ms Largest offset to slew, 0 always steps
+     * @return true if the clock was stepped
+     */
+    bool clock_service_correct(int64_t offset_us, uint32_t slew_threshold_ms);
+
+    /**
+     * @brief Block until a slew started by clock_service_correct() is done
+     *
+     * Call before clock_service_save_to_rtc(), which copies the system
+     * clock. Gives up after the longest slew slew_threshold_ms allows.
+     */
+    void clock_service_wait_for_slew(uint32_t slew_threshold_ms);
+
+    /**
+     * @brief Time the RTC may run before the next NTP sync
+     *
+     * Grows with the drift estimator's confidence, up to
+     * CONFIG_CLOCK_SERVICE_SYNC_INTERVAL_MAX_HOURS, so that the predicted
+     * RTC error stays below CONFIG_CLOCK_SERVICE_DRIFT_MAX_ERROR_MS.
+     *
+     * @param min_interval_s Configured interval, returned while the drift
+     *                       is not yet known
+     * @return Interval in seconds, never less than min_interval_s
+     */
+    uint32_t clock_service_sync_interval(uint32_t min_interval_s);
+
+    /**
+     * @brief Compare the system clock to the RTC and step it if needed
+     *
+     * Reads the RTC only when CONFIG_CLOCK_SERVICE_DISCIPLINE_INTERVAL_MIN
+     * has elapsed or a check was requested. Does I2C; call from a
+     * background task, not the LVGL task.
+     *
+     * @return ESP_OK (also when no check was due), or the RTC read error
+     */
+    esp_err_t clock_service_discipline(void);
+
+    /**
+     * @brief Make the next clock_service_discipline() read the RTC
+     *
+     * Safe from any context; used after light sleep.
+     */
+    void clock_service_request_discipline(void);
+
+    /**
+     * @brief Catch the system clock up with the RTC after one of its edges
+     *
+     * Call when an RTC second or minute interrupt woke the caller. The
+     * system clock is seeded halfway into an RTC second and only stepped
+     * once it is CONFIG_CLOCK_SERVICE_STEP_THRESHOLD_SEC off, so right
+     * after the edge it can still read the previous second. If it trails
+     * the RTC it is moved up to the start of the RTC's second; a clock
+     * that is ahead is left alone. Does I2C.
+     *
+     * @return ESP_OK, or the RTC read error
+     */
+    esp_err_t clock_service_sync_to_rtc_edge(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // CLOCK_SERVICE_H
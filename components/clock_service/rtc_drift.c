@@ -0,0 +1,196 @@
+/**
+ * @file rtc_drift.c
+ * @brief RTC drift estimator implementation
+ *
+ * Integer arithmetic only; the ESP32-C6 has no FPU.
+ */
+
+#include "rtc_drift.h"
+#include <stddef.h>
+
+// Weight unit is (0.1 h)^2 so a month-long interval still fits in 32 bits
+#define WEIGHT_UNIT_S 360
+
+// Sigma of the mean is MEASUREMENT / sqrt(sum of interval^2)
+#define SIGMA_NUMERATOR                                                        \
+  ((uint32_t)((uint64_t)RTC_DRIFT_MEASUREMENT_MS * 1000000 / WEIGHT_UNIT_S))
+
+// Samples further than this from the estimate are outliers ...
+#define OUTLIER_SIGMAS 4
+#define OUTLIER_FLOOR_PPB 5000
+
+// ... unless this many arrive in a row, then the crystal really changed
+#define OUTLIER_RESTART 3
+
+static uint32_t isqrt(uint64_t value)
+{
+  uint64_t root = 0;
+  uint64_t bit = 1ULL << 62;
+
+  while (bit > value)
+  {
+    bit >>= 2;
+  }
+  while (bit)
+  {
+    if (value >= root + bit)
+    {
+      value -= root + bit;
+      root = (root >> 1) + bit;
+    }
+    else
+    {
+      root >>= 1;
+    }
+    bit >>= 2;
+  }
+  return (uint32_t)root;
+}
+
+static uint32_t sample_sigma_ppb(uint32_t interval_s)
+{
+  return (uint32_t)((uint64_t)RTC_DRIFT_MEASUREMENT_MS * 1000000 / interval_s);
+}
+
+void rtc_drift_init(rtc_drift_t *est)
+{
+  if (!est)
+  {
+    return;
+  }
+  est->drift_ppb = 0;
+  est->weight = 0;
+  est->samples = 0;
+  est->rejected = 0;
+}
+
+rtc_drift_result_t rtc_drift_add_sample(rtc_drift_t *est, int32_t error_ms,
+                                        uint32_t interval_s, int8_t steps)
+{
+  if (interval_s < RTC_DRIFT_MIN_INTERVAL_S)
+  {
+    return RTC_DRIFT_TOO_SHORT;
+  }
+
+  // Rate seen over the interval, then remove the correction that was active
+  int64_t measured = (int64_t)error_ms * 1000000 / (int64_t)interval_s;
+  int64_t drift = measured - (int64_t)steps * RTC_DRIFT_PPB_PER_STEP;
+
+  if (est->samples > 0)
+  {
+    int64_t deviation = drift - est->drift_ppb;
+    if (deviation < 0)
+    {
+      deviation = -deviation;
+    }
+
+    uint64_t limit = (uint64_t)OUTLIER_SIGMAS *
+                     ((uint64_t)rtc_drift_uncertainty_ppb(est) +
+                      sample_sigma_ppb(interval_s));
+    if (limit < OUTLIER_FLOOR_PPB)
+    {
+      limit = OUTLIER_FLOOR_PPB;
+    }
+
+    if ((uint64_t)deviation > limit)
+    {
+      est->rejected++;
+      if (est->rejected < OUTLIER_RESTART)
+      {
+        return RTC_DRIFT_OUTLIER;
+      }
+      rtc_drift_init(est);
+    }
+  }
+
+  uint64_t units = (interval_s + WEIGHT_UNIT_S / 2) / WEIGHT_UNIT_S;
+  uint64_t weight = units * units;
+  if (weight > UINT32_MAX / 4)
+  {
+    weight = UINT32_MAX / 4;
+  }
+
+  // Age old samples so the estimate follows aging and temperature
+  uint64_t old_weight = (uint64_t)est->weight * 3 / 4;
+  uint64_t total = old_weight + weight;
+
+  est->drift_ppb = (int32_t)(((int64_t)est->drift_ppb * (int64_t)old_weight +
+                              drift * (int64_t)weight) /
+                             (int64_t)total);
+  est->weight = (uint32_t)total;
+  if (est->samples < UINT16_MAX)
+  {
+    est->samples++;
+  }
+  est->rejected = 0;
+  return RTC_DRIFT_ACCEPTED;
+}
+
+uint32_t rtc_drift_uncertainty_ppb(const rtc_drift_t *est)
+{
+  if (!est || est->weight == 0)
+  {
+    return UINT32_MAX;
+  }
+
+  uint32_t root = isqrt(est->weight);
+  return SIGMA_NUMERATOR / (root ? root : 1);
+}
+
+int8_t rtc_drift_offset_steps(const rtc_drift_t *est)
+{
+  if (!est || est->samples == 0)
+  {
+    return 0;
+  }
+
+  // Round to nearest; a fast crystal (+) needs a negative correction
+  int32_t half = RTC_DRIFT_PPB_PER_STEP / 2;
+  int32_t steps = (est->drift_ppb >= 0)
+                      ? -((est->drift_ppb + half) / RTC_DRIFT_PPB_PER_STEP)
+                      : ((-est->drift_ppb + half) / RTC_DRIFT_PPB_PER_STEP);
+
+  if (steps < RTC_DRIFT_STEPS_MIN)
+  {
+    steps = RTC_DRIFT_STEPS_MIN;
+  }
+  else if (steps > RTC_DRIFT_STEPS_MAX)
+  {
+    steps = RTC_DRIFT_STEPS_MAX;
+  }
+  return (int8_t)steps;
+}
+
+uint32_t rtc_drift_sync_interval(const rtc_drift_t *est, int8_t steps,
+                                 uint32_t max_error_ms, uint32_t min_s,
+                                 uint32_t max_s)
+{
+  // One sample cannot tell drift from a one-off error
+  if (!est || est->samples < 2)
+  {
+    return min_s;
+  }
+
+  int64_t residual = (int64_t)est->drift_ppb +
+                     (int64_t)steps * RTC_DRIFT_PPB_PER_STEP;
+  if (residual < 0)
+  {
+    residual = -residual;
+  }
+  uint64_t expected_ppb = (uint64_t)residual + rtc_drift_uncertainty_ppb(est);
+  if (expected_ppb == 0)
+  {
+    return max_s;
+  }
+
+  uint64_t interval = (uint64_t)max_error_ms * 1000000 / expected_ppb;
+  if (interval < min_s)
+  {
+    return min_s;
+  }
+  if (interval > max_s)
+  {
+    return max_s;
+  }
+  return (uint32_t)interval;
+}
@@ -0,0 +1,108 @@
+/**
+ * @file rtc_drift.h
+ * @brief RTC drift estimator (pure, no hardware access)
+ *
+ * Each NTP sync yields one sample: how far the RTC drifted from NTP over
+ * the time since the RTC was last set, with the offset register value that
+ * was in effect. The estimator keeps a weighted mean of the crystal's own
+ * drift (correction removed), weighting long intervals more because the
+ * measurement error is fixed in milliseconds. Older samples are aged so
+ * the estimate follows crystal aging and seasonal temperature.
+ *
+ * From the estimate it derives the offset register value and how long the
+ * RTC can run before its predicted error reaches a limit.
+ */
+
+#ifndef RTC_DRIFT_H
+#define RTC_DRIFT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Weight of one offset register step in ppb (PCF85063 normal mode) */
+#define RTC_DRIFT_PPB_PER_STEP 4340
+
+/** Offset register range */
+#define RTC_DRIFT_STEPS_MIN (-64)
+#define RTC_DRIFT_STEPS_MAX 63
+
+/** Shortest interval that gives a useful sample (seconds) */
+#define RTC_DRIFT_MIN_INTERVAL_S 3600
+
+/** Assumed error of one measurement (NTP plus edge detection), ms */
+#define RTC_DRIFT_MEASUREMENT_MS 50
+
+    typedef struct
+    {
+        int32_t drift_ppb; ///< Crystal drift without correction, + = fast
+        uint32_t weight;   ///< Aged sum of squared intervals (hours^2)
+        uint16_t samples;  ///< Accepted samples
+        uint16_t rejected; ///< Outliers since the last accepted sample
+    } rtc_drift_t;
+
+    typedef enum
+    {
+        RTC_DRIFT_ACCEPTED = 0,
+        RTC_DRIFT_TOO_SHORT, ///< Interval below RTC_DRIFT_MIN_INTERVAL_S
+        RTC_DRIFT_OUTLIER,   ///< Far from the estimate (RTC reset, bad NTP)
+    } rtc_drift_result_t;
+
+    /**
+     * @brief Reset to "nothing known"
+     */
+    void rtc_drift_init(rtc_drift_t *est);
+
+    /**
+     * @brief Add one RTC-versus-NTP comparison
+     *
+     * @param est Estimator
+     * @param error_ms RTC minus NTP time at the sync, + = RTC ahead
+     * @param interval_s Seconds since the RTC was last set from NTP
+     * @param steps Offset register value during that interval
+     * @return Whether the sample was used
+     */
+    rtc_drift_result_t rtc_drift_add_sample(rtc_drift_t *est, int32_t error_ms,
+                                            uint32_t interval_s, int8_t steps);
+
+    /**
+     * @brief One-sigma uncertainty of the estimate in ppb
+     *
+     * UINT32_MAX until the first sample.
+     */
+    uint32_t rtc_drift_uncertainty_ppb(const rtc_drift_t *est);
+
+    /**
+     * @brief Offset register value that cancels the estimated drift
+     *
+     * 0 until the first sample.
+     */
+    int8_t rtc_drift_offset_steps(const rtc_drift_t *est);
+
+    /**
+     * @brief How long the RTC may run until it is expected to be off by
+     *        max_error_ms
+     *
+     * Uses the drift left after applying steps plus the estimate's
+     * uncertainty, so the interval grows as confidence grows.
+     *
+     * @param est Estimator
+     * @param steps Offset register value that will be in effect
+     * @param max_error_ms Allowed RTC error at the next sync
+     * @param min_s Lower bound (used while fewer than two samples)
+     * @param max_s Upper bound
+     * @return Interval in seconds
+     */
+    uint32_t rtc_drift_sync_interval(const rtc_drift_t *est, int8_t steps,
+                                     uint32_t max_error_ms, uint32_t min_s,
+                                     uint32_t max_s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // RTC_DRIFT_H
@@ -0,0 +1,241 @@
+/**
+ * @file event_bus.c
+ * @brief System event bus implementation
+ */
+
+#include "event_bus.h"
+#include "event_mailbox.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "sdkconfig.h"
+
+static const char *TAG = "event_bus";
+
+#define MAX_SUBSCRIBERS 12
+
+// Display lock wait before UI events are put back and retried
+#define UI_LOCK_TIMEOUT_MS 500
+#define UI_RETRY_MS 100
+
+#define UI_BATCH_US ((int64_t)CONFIG_EVENT_BUS_UI_BATCH_MS * 1000)
+
+typedef struct
+{
+  uint32_t mask;
+  event_ctx_t ctx;
+  event_handler_t handler;
+  void *user_data;
+} subscriber_t;
+
+static subscriber_t subscribers[MAX_SUBSCRIBERS];
+static uint8_t subscriber_count = 0;
+static uint32_t ctx_mask[EVENT_CTX_COUNT]; // Types someone in the context wants
+static event_mailbox_t mailboxes[EVENT_CTX_COUNT];
+static portMUX_TYPE bus_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static TaskHandle_t bus_task = NULL;
+static event_ui_lock_t ui_lock = NULL;
+static event_ui_unlock_t ui_unlock = NULL;
+static int64_t last_ui_flush_us = 0;
+
+/**
+ * @brief Move all pending events of a context out of its mailbox
+ */
+static void mailbox_take(event_ctx_t ctx, event_batch_t *batch)
+{
+  portENTER_CRITICAL(&bus_mux);
+  event_mailbox_take(&mailboxes[ctx], batch);
+  portEXIT_CRITICAL(&bus_mux);
+}
+
+/**
+ * @brief Put back undelivered events, unless a newer state has arrived
+ */
+static void mailbox_restore(event_ctx_t ctx, const event_batch_t *batch)
+{
+  portENTER_CRITICAL(&bus_mux);
+  event_mailbox_restore(&mailboxes[ctx], batch);
+  portEXIT_CRITICAL(&bus_mux);
+}
+
+static bool mailbox_pending(event_ctx_t ctx)
+{
+  portENTER_CRITICAL(&bus_mux);
+  bool pending = event_mailbox_pending(&mailboxes[ctx]);
+  portEXIT_CRITICAL(&bus_mux);
+  return pending;
+}
+
+/**
+ * @brief Hand taken events to the context's subscribers in publish order
+ */
+static void dispatch(event_ctx_t ctx, const event_batch_t *batch)
+{
+  // Entries are never changed once counted, so they are read unlocked
+  portENTER_CRITICAL(&bus_mux);
+  uint8_t subs = subscriber_count;
+  portEXIT_CRITICAL(&bus_mux);
+
+  for (uint8_t n = 0; n < batch->count; n++)
+  {
+    const event_t *event = &batch->events[n];
+    for (uint8_t i = 0; i < subs; i++)
+    {
+      const subscriber_t *sub = &subscribers[i];
+      if (sub->ctx == ctx && (sub->mask & EVENT_MASK(event->type)))
+      {
+        sub->handler(event, sub->user_data);
+      }
+    }
+  }
+}
+
+/**
+ * @brief Deliver UI events under one display lock, at most once a frame
+ * @return How long the task may wait before it has to look again
+ */
+static TickType_t flush_ui(event_batch_t *batch)
+{
+  if (!mailbox_pending(EVENT_CTX_UI))
+  {
+    return portMAX_DELAY;
+  }
+
+  // Let the rest of a burst arrive and share this lock
+  int64_t wait_us = last_ui_flush_us + UI_BATCH_US - esp_timer_get_time();
+  if (wait_us > 0)
+  {
+    return pdMS_TO_TICKS(wait_us / 1000) + 1;
+  }
+
+  mailbox_take(EVENT_CTX_UI, batch);
+  if (!ui_lock(UI_LOCK_TIMEOUT_MS))
+  {
+    ESP_LOGW(TAG, "Display lock busy, UI events deferred");
+    mailbox_restore(EVENT_CTX_UI, batch);
+    return pdMS_TO_TICKS(UI_RETRY_MS);
+  }
+  dispatch(EVENT_CTX_UI, batch);
+  ui_unlock();
+
+  last_ui_flush_us = esp_timer_get_time();
+  return portMAX_DELAY;
+}
+
+static void event_bus_task(void *arg)
+{
+  (void)arg;
+  static event_batch_t batch;
+
+  for (;;)
+  {
+    mailbox_take(EVENT_CTX_WORKER, &batch);
+    dispatch(EVENT_CTX_WORKER, &batch);
+
+    ulTaskNotifyTake(pdTRUE, flush_ui(&batch));
+  }
+}
+
+esp_err_t event_bus_init(event_ui_lock_t lock, event_ui_unlock_t unlock)
+{
+  if (!lock || !unlock)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (bus_task)
+  {
+    return ESP_OK;
+  }
+
+  ui_lock = lock;
+  ui_unlock = unlock;
+
+  TaskHandle_t task = NULL;
+  if (xTaskCreate(event_bus_task, "event_bus", 4096, NULL, 4, &task) != pdPASS)
+  {
+    ESP_LOGE(TAG, "Failed to create event bus task");
+    return ESP_ERR_NO_MEM;
+  }
+
+  portENTER_CRITICAL(&bus_mux);
+  bus_task = task;
+  portEXIT_CRITICAL(&bus_mux);
+
+  // Events published before the task existed
+  xTaskNotifyGive(task);
+
+  ESP_LOGI(TAG, "Event bus started (%d subscriber(s))", subscriber_count);
+  return ESP_OK;
+}
+
+esp_err_t event_bus_subscribe(uint32_t type_mask, event_ctx_t ctx,
+                              event_handler_t handler, void *user_data)
+{
+  if (!handler || ctx >= EVENT_CTX_COUNT || type_mask == 0 ||
+      type_mask >= EVENT_MASK(EVENT_TYPE_COUNT))
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  portENTER_CRITICAL(&bus_mux);
+  if (subscriber_count >= MAX_SUBSCRIBERS)
+  {
+    portEXIT_CRITICAL(&bus_mux);
+    ESP_LOGE(TAG, "Subscriber table full");
+    return ESP_ERR_NO_MEM;
+  }
+  subscribers[subscriber_count] = (subscriber_t){
+      .mask = type_mask,
+      .ctx = ctx,
+      .handler = handler,
+      .user_data = user_data,
+  };
+  subscriber_count++;
+  ctx_mask[ctx] |= type_mask;
+  portEXIT_CRITICAL(&bus_mux);
+
+  return ESP_OK;
+}
+
+void event_bus_publish(const event_t *event)
+{
+  if (!event || event->type >= EVENT_TYPE_COUNT)
+  {
+    return;
+  }
+
+  uint32_t bit = EVENT_MASK(event->type);
+  int64_t now_us = esp_timer_get_time();
+  bool queued = false;
+  bool dropped = false;
+
+  portENTER_CRITICAL(&bus_mux);
+  for (int ctx = 0; ctx < EVENT_CTX_COUNT; ctx++)
+  {
+    if (!(ctx_mask[ctx] & bit))
+    {
+      continue;
+    }
+    if (event_mailbox_put(&mailboxes[ctx], event, now_us))
+    {
+      queued = true;
+    }
+    else
+    {
+      dropped = true;
+    }
+  }
+  TaskHandle_t task = bus_task;
+  portEXIT_CRITICAL(&bus_mux);
+
+  if (dropped)
+  {
+    ESP_LOGW(TAG, "Message queue full, event %d dropped", event->type);
+  }
+  if (queued && task)
+  {
+    xTaskNotifyGive(task);
+  }
+}
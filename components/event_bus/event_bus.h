@@ -0,0 +1,125 @@
+/**
+ * @file event_bus.h
+ * @brief System event bus with worker and UI-thread delivery
+ *
+ * Components publish state changes (WiFi state, battery, time sync, OTA
+ * progress, sleep, weather, phone notifications) without knowing who
+ * listens or which task they run in. Subscribers choose a delivery context:
+ *
+ * - EVENT_CTX_WORKER: called from the bus task, may block briefly.
+ * - EVENT_CTX_UI: called with the display lock held. Events that arrive
+ *   within one frame are delivered together under a single lock, so a
+ *   burst of updates costs one lock and one redraw.
+ *
+ * Most events are state: each context keeps one pending record per state
+ * type, and a newer event replaces an undelivered one of the same type
+ * (event_t.coalesced counts how many were dropped that way). Time syncs
+ * and notifications are messages, where every one matters: each context
+ * queues them in a small FIFO and drops new ones only when it is full.
+ * Publishing never allocates and never blocks.
+ *
+ * Publishing and subscribing work before event_bus_init(); pending events
+ * are delivered once the bus task runs.
+ */
+
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  EVENT_WIFI_STATE,   ///< wifi.state
+  EVENT_BATTERY,      ///< battery.*, published when percent or charging change
+  EVENT_TIME_SYNC,    ///< time_sync.*, after every NTP attempt or BLE set
+  EVENT_OTA_PROGRESS, ///< ota.*, state changes and every percent
+  EVENT_SLEEP,        ///< sleep.*, entering light sleep and after wake
+  EVENT_WEATHER,      ///< weather.*, after every forecast fetch
+  EVENT_NOTIFICATION, ///< notification.*, phone notification over BLE
+  EVENT_TYPE_COUNT
+} event_type_t;
+
+#define EVENT_MASK(type) (1u << (type))
+
+/* Queued one by one instead of merged into the latest */
+#define EVENT_MESSAGE_MASK                                                    \
+  (EVENT_MASK(EVENT_TIME_SYNC) | EVENT_MASK(EVENT_NOTIFICATION))
+#define EVENT_STATE_MASK                                                      \
+  ((EVENT_MASK(EVENT_TYPE_COUNT) - 1) & ~EVENT_MESSAGE_MASK)
+
+/* time_sync.source */
+typedef enum {
+  EVENT_TIME_SYNC_NTP,
+  EVENT_TIME_SYNC_BLE, ///< Set by a phone
+} event_time_sync_source_t;
+
+typedef enum {
+  EVENT_CTX_WORKER,
+  EVENT_CTX_UI,
+  EVENT_CTX_COUNT
+} event_ctx_t;
+
+typedef struct {
+  event_type_t type;
+  uint16_t coalesced; ///< Undelivered events it replaced; 0 for messages
+  int64_t time_us;    ///< esp_timer time of publishing
+  union {
+    struct {
+      uint8_t state; ///< wifi_state_t
+    } wifi;
+    struct {
+      uint16_t voltage_mv;
+      uint8_t percent;
+      bool charging;
+    } battery;
+    struct {
+      bool ok;
+      uint8_t source; ///< event_time_sync_source_t
+    } time_sync;
+    struct {
+      uint8_t state;   ///< ota_state_t
+      uint8_t percent;
+    } ota;
+    struct {
+      bool awake; ///< false: about to sleep
+    } sleep;
+    struct {
+      bool ok; ///< false: fetch failed, the cached forecast is unchanged
+    } weather;
+    struct {
+      uint16_t id;      ///< Phone's id; ble_sync_get_notification() has it
+      uint8_t category; ///< BLE_SYNC_CATEGORY_*
+      uint8_t op;       ///< BLE_SYNC_NOTIF_POST, _REMOVE or _CLEAR
+    } notification;
+  };
+} event_t;
+
+typedef void (*event_handler_t)(const event_t *event, void *user_data);
+
+/* Display lock used for EVENT_CTX_UI delivery, e.g. bsp_display_lock */
+typedef bool (*event_ui_lock_t)(uint32_t timeout_ms);
+typedef void (*event_ui_unlock_t)(void);
+
+/* Start the delivery task; UI subscribers get nothing until this runs */
+esp_err_t event_bus_init(event_ui_lock_t ui_lock, event_ui_unlock_t ui_unlock);
+
+/*
+ * Call handler for every event whose type is in type_mask (EVENT_MASK
+ * bits), in the given context. Subscriptions last for the whole run.
+ */
+esp_err_t event_bus_subscribe(uint32_t type_mask, event_ctx_t ctx,
+                              event_handler_t handler, void *user_data);
+
+/* Queue an event for its subscribers; any task, not from an ISR */
+void event_bus_publish(const event_t *event);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_BUS_H
@@ -0,0 +1,125 @@
+/**
+ * @file event_mailbox.c
+ * @brief Per-context pending events implementation
+ */
+
+#include "event_mailbox.h"
+
+static uint16_t saturating_inc(uint16_t value)
+{
+  return value == UINT16_MAX ? value : value + 1;
+}
+
+static bool is_message(event_type_t type)
+{
+  return (EVENT_MESSAGE_MASK & EVENT_MASK(type)) != 0;
+}
+
+static event_t *msg_at(event_mailbox_t *box, uint8_t index)
+{
+  return &box->msgs[(box->msg_head + index) % EVENT_MAILBOX_MSG_DEPTH];
+}
+
+bool event_mailbox_put(event_mailbox_t *box, const event_t *event,
+                       int64_t time_us)
+{
+  if (is_message(event->type))
+  {
+    if (box->msg_count >= EVENT_MAILBOX_MSG_DEPTH)
+    {
+      box->dropped++;
+      return false;
+    }
+    event_t *msg = msg_at(box, box->msg_count++);
+    *msg = *event;
+    msg->coalesced = 0;
+    msg->time_us = time_us;
+    return true;
+  }
+
+  uint32_t bit = EVENT_MASK(event->type);
+  event_t *slot = &box->slots[event->type];
+  uint16_t coalesced =
+      (box->pending & bit) ? saturating_inc(slot->coalesced) : 0;
+  *slot = *event;
+  slot->coalesced = coalesced;
+  slot->time_us = time_us;
+  box->pending |= bit;
+  return true;
+}
+
+/**
+ * @brief Insert after every entry published at or before it
+ */
+static void batch_insert(event_batch_t *batch, const event_t *event)
+{
+  int i = batch->count++;
+  while (i > 0 && batch->events[i - 1].time_us > event->time_us)
+  {
+    batch->events[i] = batch->events[i - 1];
+    i--;
+  }
+  batch->events[i] = *event;
+}
+
+void event_mailbox_take(event_mailbox_t *box, event_batch_t *batch)
+{
+  batch->count = 0;
+
+  for (int type = 0; type < EVENT_TYPE_COUNT; type++)
+  {
+    if (box->pending & EVENT_MASK(type))
+    {
+      batch_insert(batch, &box->slots[type]);
+    }
+  }
+  box->pending = 0;
+
+  for (uint8_t i = 0; i < box->msg_count; i++)
+  {
+    batch_insert(batch, msg_at(box, i));
+  }
+  box->msg_head = 0;
+  box->msg_count = 0;
+}
+
+void event_mailbox_restore(event_mailbox_t *box, const event_batch_t *batch)
+{
+  // Newest first, so each message lands ahead of the one after it
+  for (int n = batch->count - 1; n >= 0; n--)
+  {
+    const event_t *event = &batch->events[n];
+
+    if (is_message(event->type))
+    {
+      if (box->msg_count >= EVENT_MAILBOX_MSG_DEPTH)
+      {
+        // Full: the newest queued message makes room for the older one
+        box->msg_count--;
+        box->dropped++;
+      }
+      box->msg_head = (uint8_t)((box->msg_head + EVENT_MAILBOX_MSG_DEPTH - 1) %
+                                EVENT_MAILBOX_MSG_DEPTH);
+      box->msgs[box->msg_head] = *event;
+      box->msg_count++;
+      continue;
+    }
+
+    uint32_t bit = EVENT_MASK(event->type);
+    if (box->pending & bit)
+    {
+      event_t *slot = &box->slots[event->type];
+      slot->coalesced = saturating_inc(slot->coalesced);
+    }
+    else
+    {
+      box->slots[event->type] = *event;
+      box->pending |= bit;
+    }
+  }
+}
+
+bool event_mailbox_pending(const event_mailbox_t *box)
+{
+  return box->pending != 0 || box->msg_count != 0;
+}
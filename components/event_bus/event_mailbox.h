@@ -0,0 +1,67 @@
+/**
+ * @file event_mailbox.h
+ * @brief Per-context pending events of the event bus (internal, pure)
+ *
+ * State events (EVENT_STATE_MASK) keep one slot per type: a newer event
+ * replaces an undelivered one and counts it in event_t.coalesced, since
+ * only the latest value matters. Message events (EVENT_MESSAGE_MASK) are
+ * each worth delivering, so they go through a small FIFO instead; when it
+ * is full the new message is dropped and counted.
+ *
+ * Locking is left to the caller, so the core runs on the host.
+ */
+
+#ifndef EVENT_MAILBOX_H
+#define EVENT_MAILBOX_H
+
+#include "event_bus.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENT_MAILBOX_MSG_DEPTH 8
+
+/* Most events one take can return */
+#define EVENT_MAILBOX_BATCH_MAX (EVENT_TYPE_COUNT + EVENT_MAILBOX_MSG_DEPTH)
+
+typedef struct {
+  event_t slots[EVENT_TYPE_COUNT]; ///< Latest state event of each type
+  uint32_t pending;                ///< EVENT_MASK bits of the filled slots
+  event_t msgs[EVENT_MAILBOX_MSG_DEPTH];
+  uint8_t msg_head;
+  uint8_t msg_count;
+  uint32_t dropped; ///< Messages lost to a full FIFO, ever
+} event_mailbox_t;
+
+/* Events moved out by one take, oldest first */
+typedef struct {
+  event_t events[EVENT_MAILBOX_BATCH_MAX];
+  uint8_t count;
+} event_batch_t;
+
+/*
+ * Queue a copy of event, stamped with time_us.
+ * Returns false only when a message was dropped on a full FIFO.
+ */
+bool event_mailbox_put(event_mailbox_t *box, const event_t *event,
+                       int64_t time_us);
+
+/* Move everything pending into batch, ordered by publish time */
+void event_mailbox_take(event_mailbox_t *box, event_batch_t *batch);
+
+/*
+ * Put back a batch that could not be delivered. State events lose to a
+ * newer one of their type; messages go back ahead of those queued since.
+ */
+void event_mailbox_restore(event_mailbox_t *box, const event_batch_t *batch);
+
+bool event_mailbox_pending(const event_mailbox_t *box);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // EVENT_MAILBOX_H
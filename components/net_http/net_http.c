@@ -0,0 +1,543 @@
+/**
+ * @file net_http.c
+ * @brief Shared HTTP(S) client implementation
+ */
+
+#include "net_http.h"
+#include "event_bus.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/semphr.h"
+#include "sdkconfig.h"
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#ifdef CONFIG_NET_HTTP_CERT_BUNDLE
+#include "esp_crt_bundle.h"
+#endif
+
+#ifdef CONFIG_ENABLE_WIFI
+#include "wifi_manager.h"
+#endif
+
+static const char *TAG = "net_http";
+
+#define MAX_REDIRECTS 5
+#define ORIGIN_MAX_LEN 96
+// Signed CDN redirect URLs make for long request lines
+#define TX_BUFFER_SIZE 1024
+
+#define KEEPALIVE_US ((int64_t)CONFIG_NET_HTTP_KEEPALIVE_S * 1000000)
+
+typedef struct
+{
+  esp_http_client_handle_t client; ///< NULL: slot unused
+  char origin[ORIGIN_MAX_LEN];     ///< "scheme://host[:port]" it talks to
+  bool busy;                       ///< Owned by a request
+  bool open;                       ///< Connection kept from the last request
+  bool has_ticket;                 ///< A TLS connect has completed before
+  int64_t idle_since_us;
+
+  // Current hop, written by the event handler
+  const net_http_opts_t *opts;
+  char *location;
+  bool conn_close;      ///< Server sent "Connection: close"
+  int64_t connected_us; ///< 0 unless the hop opened a new connection
+} slot_t;
+
+static slot_t slots[CONFIG_NET_HTTP_MAX_HOSTS];
+static net_http_stats_t stats;
+static SemaphoreHandle_t pool_lock = NULL;
+static portMUX_TYPE init_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static bool is_https(const char *origin)
+{
+  return strncasecmp(origin, "https:", 6) == 0;
+}
+
+/**
+ * @brief Scheme, host and port of an absolute URL
+ * @return false for a relative or over-long URL
+ */
+static bool origin_of(const char *url, char *origin, size_t size)
+{
+  const char *sep = strstr(url, "://");
+  if (!sep)
+  {
+    return false;
+  }
+  size_t len = (size_t)(sep + 3 - url) + strcspn(sep + 3, "/?#");
+  if (len >= size)
+  {
+    return false;
+  }
+  memcpy(origin, url, len);
+  origin[len] = '\0';
+  return true;
+}
+
+static esp_err_t pool_event_handler(esp_http_client_event_t *evt)
+{
+  slot_t *s = evt->user_data;
+
+  if (evt->event_id == HTTP_EVENT_ON_CONNECTED)
+  {
+    s->connected_us = esp_timer_get_time();
+  }
+  else if (evt->event_id == HTTP_EVENT_ON_HEADER)
+  {
+    if (strcasecmp(evt->header_key, "Location") == 0)
+    {
+      free(s->location);
+      s->location = strdup(evt->header_value);
+    }
+    else if (strcasecmp(evt->header_key, "Connection") == 0 &&
+             strcasecmp(evt->header_value, "close") == 0)
+    {
+      s->conn_close = true;
+    }
+    if (s->opts && s->opts->on_header)
+    {
+      s->opts->on_header(evt->header_key, evt->header_value,
+                         s->opts->user_data);
+    }
+  }
+  return ESP_OK;
+}
+
+#ifdef CONFIG_ENABLE_WIFI
+static void wifi_state_event(const event_t *event, void *user_data)
+{
+  (void)user_data;
+  if (event->wifi.state != WIFI_STATE_CONNECTED)
+  {
+    net_http_close_idle();
+  }
+}
+#endif
+
+static bool pool_init(void)
+{
+  if (pool_lock)
+  {
+    return true;
+  }
+
+  SemaphoreHandle_t lock = xSemaphoreCreateMutex();
+  if (!lock)
+  {
+    return false;
+  }
+  bool created = false;
+  portENTER_CRITICAL(&init_mux);
+  if (!pool_lock)
+  {
+    pool_lock = lock;
+    created = true;
+  }
+  portEXIT_CRITICAL(&init_mux);
+
+  if (!created)
+  {
+    vSemaphoreDelete(lock);
+    return true;
+  }
+#ifdef CONFIG_ENABLE_WIFI
+  // Sockets do not survive the link going down
+  event_bus_subscribe(EVENT_MASK(EVENT_WIFI_STATE), EVENT_CTX_WORKER,
+                      wifi_state_event, NULL);
+#endif
+  return true;
+}
+
+static void slot_close(slot_t *s)
+{
+  if (s->open)
+  {
+    esp_http_client_close(s->client);
+    s->open = false;
+  }
+}
+
+static esp_http_client_handle_t slot_create(slot_t *s, const char *url)
+{
+  esp_http_client_config_t config = {
+      .url = url,
+      .event_handler = pool_event_handler,
+      .user_data = s,
+      .timeout_ms = CONFIG_NET_HTTP_TIMEOUT_MS,
+      .buffer_size = CONFIG_NET_HTTP_BUFFER_SIZE,
+      .buffer_size_tx = TX_BUFFER_SIZE,
+      .keep_alive_enable = true,
+      .disable_auto_redirect = true,
+  };
+#ifdef CONFIG_NET_HTTP_CERT_BUNDLE
+  config.crt_bundle_attach = esp_crt_bundle_attach;
+#endif
+#ifdef CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS
+  // The client offers the last session's ticket on its next connect
+  config.save_client_session = true;
+#endif
+  return esp_http_client_init(&config);
+}
+
+/**
+ * @brief Take the client for a URL's host, creating or recycling one
+ */
+static esp_err_t acquire(const char *url, int *index)
+{
+  char origin[ORIGIN_MAX_LEN];
+  if (!origin_of(url, origin, sizeof(origin)))
+  {
+    ESP_LOGE(TAG, "Not an absolute URL: %.64s", url);
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  xSemaphoreTake(pool_lock, portMAX_DELAY);
+  int64_t now = esp_timer_get_time();
+  int found = -1;
+  int unused = -1;
+  int oldest = -1;
+  for (int i = 0; i < CONFIG_NET_HTTP_MAX_HOSTS; i++)
+  {
+    slot_t *s = &slots[i];
+    if (!s->client)
+    {
+      unused = unused < 0 ? i : unused;
+    }
+    else if (!s->busy && strcasecmp(s->origin, origin) == 0)
+    {
+      found = i;
+      break;
+    }
+    else if (!s->busy &&
+             (oldest < 0 || s->idle_since_us < slots[oldest].idle_since_us))
+    {
+      oldest = i;
+    }
+  }
+
+  esp_err_t ret = ESP_OK;
+  if (found >= 0)
+  {
+    slot_t *s = &slots[found];
+    if (s->open && now - s->idle_since_us > KEEPALIVE_US)
+    {
+      slot_close(s);
+    }
+    // Same host, so the connection is kept
+    ret = esp_http_client_set_url(s->client, url);
+  }
+  else
+  {
+    found = unused >= 0 ? unused : oldest;
+    if (found < 0)
+    {
+      ESP_LOGE(TAG, "All %d clients busy", CONFIG_NET_HTTP_MAX_HOSTS);
+      ret = ESP_ERR_NO_MEM;
+    }
+    else
+    {
+      slot_t *s = &slots[found];
+      if (s->client)
+      {
+        ESP_LOGD(TAG, "Dropping client for %s", s->origin);
+        esp_http_client_cleanup(s->client);
+      }
+      memset(s, 0, sizeof(*s));
+      strcpy(s->origin, origin);
+      s->client = slot_create(s, url);
+      ret = s->client ? ESP_OK : ESP_ERR_NO_MEM;
+    }
+  }
+
+  if (ret == ESP_OK)
+  {
+    slots[found].busy = true;
+    *index = found;
+  }
+  xSemaphoreGive(pool_lock);
+  return ret;
+}
+
+/**
+ * @brief Hand a client back, keeping its connection if allowed
+ */
+static void release(int index, bool keep)
+{
+  slot_t *s = &slots[index];
+
+  xSemaphoreTake(pool_lock, portMAX_DELAY);
+  if (!keep || s->conn_close || KEEPALIVE_US == 0)
+  {
+    slot_close(s);
+  }
+  free(s->location);
+  s->location = NULL;
+  s->opts = NULL;
+  s->busy = false;
+  s->idle_since_us = esp_timer_get_time();
+  xSemaphoreGive(pool_lock);
+}
+
+static void set_headers(slot_t *s, const net_http_opts_t *opts, bool set)
+{
+  for (int i = 0; i < NET_HTTP_MAX_HEADERS; i++)
+  {
+    const net_http_header_t *h = &opts->headers[i];
+    if (!h->key)
+    {
+      continue;
+    }
+    if (set)
+    {
+      esp_http_client_set_header(s->client, h->key, h->value);
+    }
+    else
+    {
+      esp_http_client_delete_header(s->client, h->key);
+    }
+  }
+}
+
+static void count_hop(slot_t *s, bool reused, int64_t start_us)
+{
+  xSemaphoreTake(pool_lock, portMAX_DELAY);
+  stats.requests++;
+  if (!s->connected_us)
+  {
+    stats.reused += reused;
+    xSemaphoreGive(pool_lock);
+    return;
+  }
+
+  stats.connects++;
+  uint32_t ms = (uint32_t)((s->connected_us - start_us) / 1000);
+  bool tls = is_https(s->origin);
+  bool ticket = tls && s->has_ticket;
+  if (ticket)
+  {
+    stats.tls_ticket++;
+    stats.tls_ticket_ms += ms;
+  }
+  else if (tls)
+  {
+    stats.tls_full++;
+    stats.tls_full_ms += ms;
+  }
+  net_http_stats_t now = stats;
+  xSemaphoreGive(pool_lock);
+
+  s->has_ticket = s->has_ticket || tls;
+  ESP_LOGI(TAG,
+           "Connected to %s in %lu ms (%s); %lu request(s), %lu reused, "
+           "%lu full / %lu ticket handshake(s)",
+           s->origin, (unsigned long)ms,
+           !tls ? "plain" : ticket ? "ticket offered" : "full handshake",
+           (unsigned long)now.requests, (unsigned long)now.reused,
+           (unsigned long)now.tls_full, (unsigned long)now.tls_ticket);
+}
+
+/**
+ * @brief Send one request on a slot and read the response headers
+ */
+static esp_err_t send_hop(slot_t *s, int *status, int64_t *length)
+{
+  esp_err_t ret = ESP_FAIL;
+
+  for (int attempt = 0; attempt < 2; attempt++)
+  {
+    bool reused = s->open;
+    free(s->location);
+    s->location = NULL;
+    s->conn_close = false;
+    s->connected_us = 0;
+    if (s->opts->on_header)
+    {
+      s->opts->on_header(NULL, NULL, s->opts->user_data);
+    }
+
+    int64_t start_us = esp_timer_get_time();
+    ret = esp_http_client_open(s->client, 0);
+    if (ret == ESP_OK)
+    {
+      s->open = true;
+      *length = esp_http_client_fetch_headers(s->client);
+      *status = esp_http_client_get_status_code(s->client);
+      ret = *status > 0 ? ESP_OK : ESP_FAIL;
+    }
+    if (ret == ESP_OK || s->connected_us)
+    {
+      count_hop(s, reused, start_us);
+    }
+
+    if (ret == ESP_OK || !reused || s->connected_us)
+    {
+      break;
+    }
+    // The server dropped the idle connection; once more on a new one
+    ESP_LOGD(TAG, "Kept connection to %s gone, reconnecting", s->origin);
+    slot_close(s);
+  }
+
+  if (ret != ESP_OK)
+  {
+    slot_close(s);
+  }
+  return ret;
+}
+
+static bool is_redirect(int status)
+{
+  return status >= 300 && status < 400 && status != 304;
+}
+
+esp_err_t net_http_open(net_http_req_t *req, const net_http_opts_t *opts)
+{
+  if (!req || !opts || !opts->url)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+  memset(req, 0, sizeof(*req));
+  req->slot = -1;
+  if (!pool_init())
+  {
+    return ESP_ERR_NO_MEM;
+  }
+
+  const char *url = opts->url;
+  char *next_url = NULL;
+  int index = -1;
+  int status = 0;
+  int64_t length = 0;
+  esp_err_t ret = ESP_OK;
+
+  for (int redirects = 0;; redirects++)
+  {
+    if (index < 0)
+    {
+      ret = acquire(url, &index);
+      if (ret != ESP_OK)
+      {
+        break;
+      }
+      slots[index].opts = opts;
+      set_headers(&slots[index], opts, true);
+      esp_http_client_set_timeout_ms(slots[index].client,
+                                     opts->timeout_ms
+                                         ? (int)opts->timeout_ms
+                                         : CONFIG_NET_HTTP_TIMEOUT_MS);
+    }
+    slot_t *s = &slots[index];
+
+    ret = send_hop(s, &status, &length);
+    if (ret != ESP_OK || !is_redirect(status))
+    {
+      break;
+    }
+    if (redirects >= MAX_REDIRECTS || !s->location)
+    {
+      ret = ESP_ERR_INVALID_RESPONSE;
+      break;
+    }
+
+    // The redirect body is small; read it so the connection stays usable
+    esp_http_client_flush_response(s->client, NULL);
+
+    char origin[ORIGIN_MAX_LEN];
+    if (origin_of(s->location, origin, sizeof(origin)) &&
+        strcasecmp(origin, s->origin) != 0)
+    {
+      // Another host (e.g. GitHub -> CDN): its own client, this one is kept
+      free(next_url);
+      next_url = strdup(s->location);
+      set_headers(s, opts, false);
+      release(index, esp_http_client_is_complete_data_received(s->client));
+      index = -1;
+      if (!next_url)
+      {
+        ret = ESP_ERR_NO_MEM;
+        break;
+      }
+      url = next_url;
+    }
+    else
+    {
+      esp_http_client_set_redirection(s->client);
+    }
+  }
+  free(next_url);
+
+  if (index < 0)
+  {
+    return ret;
+  }
+
+  // Request headers belong to this request only
+  slot_t *s = &slots[index];
+  set_headers(s, opts, false);
+  s->opts = NULL;
+  if (ret != ESP_OK)
+  {
+    release(index, false);
+    return ret;
+  }
+
+  req->client = s->client;
+  req->status = status;
+  req->content_length = length;
+  req->slot = index;
+  return ESP_OK;
+}
+
+void net_http_close(net_http_req_t *req)
+{
+  if (!req || req->slot < 0)
+  {
+    return;
+  }
+
+  // Responses without a body are complete as soon as the headers are in
+  bool complete = req->status == 204 || req->status == 304 ||
+                  esp_http_client_is_complete_data_received(req->client);
+  release(req->slot, complete);
+  req->slot = -1;
+  req->client = NULL;
+}
+
+void net_http_close_idle(void)
+{
+  if (!pool_lock)
+  {
+    return;
+  }
+
+  xSemaphoreTake(pool_lock, portMAX_DELAY);
+  for (int i = 0; i < CONFIG_NET_HTTP_MAX_HOSTS; i++)
+  {
+    if (slots[i].client && !slots[i].busy)
+    {
+      slot_close(&slots[i]);
+    }
+  }
+  xSemaphoreGive(pool_lock);
+}
+
+void net_http_get_stats(net_http_stats_t *out)
+{
+  if (!out)
+  {
+    return;
+  }
+  if (!pool_lock)
+  {
+    memset(out, 0, sizeof(*out));
+    return;
+  }
+
+  xSemaphoreTake(pool_lock, portMAX_DELAY);
+  *out = stats;
+  xSemaphoreGive(pool_lock);
+}
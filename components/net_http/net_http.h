@@ -0,0 +1,102 @@
+/**
+ * @file net_http.h
+ * @brief Shared HTTP(S) client with per-host keep-alive and TLS resumption
+ *
+ * A full TLS handshake costs the C6 a few hundred milliseconds of CPU and
+ * radio time. Instead of every caller creating its own esp_http_client,
+ * requests go through a small pool of clients, one per host:
+ *
+ * - The connection stays open after a request whose body was read to the
+ *   end, so the next request to that host skips TCP and TLS setup. Open
+ *   connections are closed when WiFi goes down, when net_http_close_idle()
+ *   is called at the end of a network session, or after
+ *   CONFIG_NET_HTTP_KEEPALIVE_S without use.
+ * - Each client keeps the TLS session ticket of its last connection
+ *   (CONFIG_ESP_TLS_CLIENT_SESSION_TICKETS), so reconnecting to that host
+ *   later is an abbreviated handshake.
+ * - Redirects are followed here, and a redirect to another host (GitHub
+ *   release asset -> CDN) moves to that host's client, so both keep their
+ *   connection and ticket.
+ *
+ * Connect counts and times are kept in net_http_stats_t and logged.
+ *
+ * Typical use:
+ *
+ *   net_http_req_t req;
+ *   if (net_http_open(&req, &opts) == ESP_OK && req.status == 200)
+ *     while ((n = esp_http_client_read(req.client, buf, len)) > 0) ...
+ *   net_http_close(&req);
+ */
+
+#ifndef NET_HTTP_H
+#define NET_HTTP_H
+
+#include "esp_err.h"
+#include "esp_http_client.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NET_HTTP_MAX_HEADERS 4
+
+typedef struct {
+  const char *key;
+  const char *value;
+} net_http_header_t;
+
+typedef struct {
+  const char *url;
+  uint32_t timeout_ms;   ///< 0: CONFIG_NET_HTTP_TIMEOUT_MS
+  net_http_header_t headers[NET_HTTP_MAX_HEADERS]; ///< Unused: key NULL
+  /*
+   * Response headers of every hop, including redirects, called from
+   * net_http_open() in the calling task. Each hop starts with a call with
+   * key and value NULL.
+   */
+  void (*on_header)(const char *key, const char *value, void *user_data);
+  void *user_data;
+} net_http_opts_t;
+
+typedef struct {
+  esp_http_client_handle_t client; ///< Read the body from this
+  int status;                      ///< Status of the final response
+  int64_t content_length;          ///< -1 if not sent (chunked)
+  int slot;                        ///< Internal
+} net_http_req_t;
+
+typedef struct {
+  uint32_t requests;       ///< Hops sent, redirects included
+  uint32_t reused;         ///< Hops sent on a kept-alive connection
+  uint32_t connects;       ///< New connections
+  uint32_t tls_full;       ///< TLS connects without a session ticket
+  uint32_t tls_ticket;     ///< TLS connects offering a ticket
+  uint64_t tls_full_ms;    ///< Connect time of tls_full
+  uint64_t tls_ticket_ms;  ///< Connect time of tls_ticket
+} net_http_stats_t;
+
+/*
+ * Send a GET, following redirects, and read the response headers. On
+ * ESP_OK the request must be finished with net_http_close(), whatever the
+ * status. On error nothing is left to close.
+ */
+esp_err_t net_http_open(net_http_req_t *req, const net_http_opts_t *opts);
+
+/*
+ * Finish a request. The connection is kept for the next request to the
+ * host if the body was read completely, otherwise it is closed.
+ */
+void net_http_close(net_http_req_t *req);
+
+/* Close kept-alive connections (TLS tickets stay); e.g. before WiFi stops */
+void net_http_close_idle(void);
+
+void net_http_get_stats(net_http_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_HTTP_H
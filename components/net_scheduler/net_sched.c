@@ -0,0 +1,276 @@
+/**
+ * @file net_sched.c
+ * @brief Network job batching core implementation
+ */
+
+#include "net_sched.h"
+#include <string.h>
+
+// Deadline after a failed run when the job sets no retry_s
+#define DEFAULT_RETRY_S 300
+
+// Ceiling for the backoff after failed link bring-ups
+#define LINK_BACKOFF_MAX_MS (60 * 60 * 1000)
+
+static int64_t sched_now(const net_sched_t *s)
+{
+  return s->link->now_ms(s->link->ctx);
+}
+
+static int64_t window_open_ms(const net_sched_slot_t *slot)
+{
+  if (slot->deadline_ms == NET_SCHED_NEVER)
+  {
+    return NET_SCHED_NEVER;
+  }
+  return slot->deadline_ms - (int64_t)slot->job.window_s * 1000;
+}
+
+static int64_t next_deadline(const net_job_t *job, int64_t now_ms, bool ok)
+{
+  uint32_t due_s;
+  if (!ok)
+  {
+    due_s = job->retry_s > 0 ? job->retry_s : DEFAULT_RETRY_S;
+  }
+  else if (job->due_in_s)
+  {
+    due_s = job->due_in_s(job->user_data);
+  }
+  else if (job->interval_s == 0)
+  {
+    return NET_SCHED_NEVER; // One-shot done
+  }
+  else
+  {
+    due_s = job->interval_s;
+  }
+
+  if (due_s == UINT32_MAX)
+  {
+    return NET_SCHED_NEVER;
+  }
+  return now_ms + (int64_t)due_s * 1000;
+}
+
+void net_sched_init(net_sched_t *s, const net_link_t *link, uint32_t budget_ms,
+                    uint32_t link_retry_ms)
+{
+  memset(s, 0, sizeof(*s));
+  s->link = link;
+  s->budget_ms = budget_ms;
+  s->link_retry_ms = link_retry_ms;
+  s->link_backoff_ms = link_retry_ms;
+  s->stats.since_ms = sched_now(s);
+}
+
+int net_sched_add(net_sched_t *s, const net_job_t *job)
+{
+  if (s->count >= NET_SCHED_MAX_JOBS || !job->run)
+  {
+    return -1;
+  }
+
+  net_sched_slot_t *slot = &s->slots[s->count];
+  slot->job = *job;
+
+  // Without due_in_s a job runs at the first chance, then every interval
+  int64_t now_ms = sched_now(s);
+  slot->deadline_ms = now_ms;
+  if (job->due_in_s)
+  {
+    slot->deadline_ms = next_deadline(job, now_ms, true);
+  }
+  return s->count++;
+}
+
+void net_sched_set_due(net_sched_t *s, int id, uint32_t delay_s)
+{
+  if (id < 0 || id >= s->count)
+  {
+    return;
+  }
+  s->slots[id].deadline_ms = sched_now(s) + (int64_t)delay_s * 1000;
+}
+
+void net_sched_refresh(net_sched_t *s, int id)
+{
+  if (id < 0 || id >= s->count || !s->slots[id].job.due_in_s)
+  {
+    return;
+  }
+  net_sched_slot_t *slot = &s->slots[id];
+  slot->deadline_ms = next_deadline(&slot->job, sched_now(s), true);
+}
+
+/**
+ * @brief Whether anything justifies bringing the link up now
+ */
+static bool session_wanted(const net_sched_t *s, int64_t now_ms, bool vbus)
+{
+  for (uint8_t i = 0; i < s->count; i++)
+  {
+    const net_sched_slot_t *slot = &s->slots[i];
+    if (slot->deadline_ms <= now_ms ||
+        (vbus && window_open_ms(slot) <= now_ms))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+/**
+ * @brief Run open jobs earliest deadline first
+ *
+ * Windows are re-checked after every job, so one that opens while the
+ * link is up still makes it into this batch. The first job always runs,
+ * so a session is never wasted on a job that alone exceeds the budget.
+ *
+ * @param budgeted Skip optional jobs that would overrun the session budget
+ * @param start_ms Session start, for the budget
+ * @return Number of jobs run
+ */
+static int run_batch(net_sched_t *s, bool budgeted, int64_t start_ms)
+{
+  uint32_t visited = 0;
+  int ran = 0;
+
+  for (;;)
+  {
+    int64_t now_ms = sched_now(s);
+    int best = -1;
+    for (uint8_t i = 0; i < s->count; i++)
+    {
+      if ((visited & (1u << i)) || window_open_ms(&s->slots[i]) > now_ms)
+      {
+        continue;
+      }
+      if (best < 0 || s->slots[i].deadline_ms < s->slots[best].deadline_ms)
+      {
+        best = i;
+      }
+    }
+    if (best < 0)
+    {
+      break;
+    }
+    visited |= 1u << best;
+
+    net_sched_slot_t *slot = &s->slots[best];
+    bool required = slot->deadline_ms <= now_ms;
+    if (budgeted && !required && ran > 0 &&
+        now_ms - start_ms + (int64_t)slot->job.cost_ms > (int64_t)s->budget_ms)
+    {
+      continue; // Still open next session
+    }
+
+    bool ok = slot->job.run(slot->job.user_data);
+    if (!ok)
+    {
+      s->stats.jobs_failed++;
+    }
+    slot->deadline_ms = next_deadline(&slot->job, sched_now(s), ok);
+    ran++;
+  }
+
+  return ran;
+}
+
+int net_sched_poll(net_sched_t *s)
+{
+  const net_link_t *link = s->link;
+  int64_t start_ms = sched_now(s);
+
+  if (link->is_up(link->ctx))
+  {
+    int ran = run_batch(s, false, start_ms);
+    if (ran > 0)
+    {
+      s->stats.shared++;
+      s->stats.jobs_shared += ran;
+    }
+    return ran;
+  }
+
+  bool vbus = link->on_vbus && link->on_vbus(link->ctx);
+  if (start_ms < s->link_retry_at_ms || !session_wanted(s, start_ms, vbus))
+  {
+    return 0;
+  }
+
+  if (!link->up(link->ctx))
+  {
+    int64_t end_ms = sched_now(s);
+    s->stats.radio_on_ms += (uint64_t)(end_ms - start_ms);
+    s->stats.link_failures++;
+    s->link_retry_at_ms = end_ms + s->link_backoff_ms;
+    s->link_backoff_ms = s->link_backoff_ms * 2 > LINK_BACKOFF_MAX_MS
+                             ? LINK_BACKOFF_MAX_MS
+                             : s->link_backoff_ms * 2;
+    return 0;
+  }
+  s->link_backoff_ms = s->link_retry_ms;
+  s->link_retry_at_ms = 0;
+
+  int ran = run_batch(s, true, start_ms);
+  link->down(link->ctx);
+
+  s->stats.sessions++;
+  s->stats.jobs_run += ran;
+  s->stats.radio_on_ms += (uint64_t)(sched_now(s) - start_ms);
+  return ran;
+}
+
+int64_t net_sched_next_ms(const net_sched_t *s)
+{
+  const net_link_t *link = s->link;
+  int64_t now_ms = sched_now(s);
+  bool early = link->is_up(link->ctx) ||
+               (link->on_vbus && link->on_vbus(link->ctx));
+  int64_t next = NET_SCHED_NEVER;
+
+  for (uint8_t i = 0; i < s->count; i++)
+  {
+    int64_t at = early ? window_open_ms(&s->slots[i]) : s->slots[i].deadline_ms;
+    if (at < next)
+    {
+      next = at;
+    }
+  }
+
+  if (next == NET_SCHED_NEVER)
+  {
+    return NET_SCHED_NEVER;
+  }
+  if (next < s->link_retry_at_ms && !link->is_up(link->ctx))
+  {
+    next = s->link_retry_at_ms;
+  }
+  return next > now_ms ? next - now_ms : 0;
+}
+
+void net_sched_get_stats(const net_sched_t *s, net_sched_stats_t *stats)
+{
+  *stats = s->stats;
+}
+
+uint32_t net_sched_radio_s_per_day(const net_sched_stats_t *stats,
+                                   int64_t now_ms)
+{
+  int64_t elapsed_ms = now_ms - stats->since_ms;
+  if (elapsed_ms <= 0)
+  {
+    return 0;
+  }
+  return (uint32_t)(stats->radio_on_ms * 86400ULL / (uint64_t)elapsed_ms);
+}
+
+uint32_t net_sched_jobs_per_session_x100(const net_sched_stats_t *stats)
+{
+  if (stats->sessions == 0)
+  {
+    return 0;
+  }
+  return (uint32_t)((uint64_t)stats->jobs_run * 100 / stats->sessions);
+}
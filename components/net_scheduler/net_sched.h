@@ -0,0 +1,125 @@
+/**
+ * @file net_sched.h
+ * @brief Network job batching core (internal, pure)
+ *
+ * Every radio-on session pays for association and DHCP before the first
+ * byte moves, so jobs that need the network are batched. Each job has a
+ * deadline and a window before it in which it may run early:
+ *
+ *   |---- interval ----|
+ *   last run     open  deadline
+ *                 |<-window->|
+ *
+ * A session starts when some job reaches its deadline, or as soon as any
+ * window opens while on external power (VBUS). It then runs every job
+ * whose window is open, earliest deadline first, and takes the link down.
+ * Optional jobs (deadline still ahead) are skipped once their estimated
+ * cost would overrun the session budget. A link that is already up costs
+ * nothing to share, so open jobs always run on it.
+ *
+ * Time and the link come from the caller, so the core runs on the host
+ * against a fake link.
+ */
+
+#ifndef NET_SCHED_H
+#define NET_SCHED_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define NET_SCHED_MAX_JOBS 8
+
+/* Deadline of a job that is not scheduled (one-shot done, or disabled) */
+#define NET_SCHED_NEVER INT64_MAX
+
+typedef struct {
+  const char *name;
+  /* Runs with the link up; returns true on success */
+  bool (*run)(void *user_data);
+  /*
+   * Seconds from now until the job must run again, asked after every run
+   * and at registration; NULL uses interval_s. UINT32_MAX: not scheduled.
+   */
+  uint32_t (*due_in_s)(void *user_data);
+  void *user_data;
+  uint32_t interval_s; ///< Period between successful runs, 0 for one-shot
+  uint32_t window_s;   ///< How long before its deadline the job may run
+  uint32_t retry_s;    ///< Deadline after a failed run
+  uint32_t cost_ms;    ///< Estimated run time with the link up
+} net_job_t;
+
+typedef struct {
+  int64_t (*now_ms)(void *ctx); ///< Monotonic milliseconds
+  bool (*is_up)(void *ctx);     ///< Link already up for someone else
+  bool (*up)(void *ctx);        ///< Bring the link up; false on failure
+  void (*down)(void *ctx);      ///< Undo up()
+  bool (*on_vbus)(void *ctx);   ///< External power present, may be NULL
+  void *ctx;
+} net_link_t;
+
+typedef struct {
+  uint32_t sessions;      ///< Times the link was brought up for jobs
+  uint32_t shared;        ///< Batches run on a link that was already up
+  uint32_t link_failures; ///< up() failures
+  uint32_t jobs_run;      ///< Jobs run in sessions, successful or not
+  uint32_t jobs_shared;   ///< Jobs run on a shared link
+  uint32_t jobs_failed;
+  uint64_t radio_on_ms; ///< Link time of all sessions, up() included
+  int64_t since_ms;     ///< When accounting started
+} net_sched_stats_t;
+
+typedef struct {
+  net_job_t job;
+  int64_t deadline_ms;
+} net_sched_slot_t;
+
+typedef struct {
+  const net_link_t *link;
+  net_sched_slot_t slots[NET_SCHED_MAX_JOBS];
+  uint8_t count;
+  uint32_t budget_ms;      ///< Session length optional jobs must fit in
+  uint32_t link_retry_ms;  ///< First backoff after up() fails
+  uint32_t link_backoff_ms;
+  int64_t link_retry_at_ms; ///< No session before this after a failure
+  net_sched_stats_t stats;
+} net_sched_t;
+
+void net_sched_init(net_sched_t *s, const net_link_t *link, uint32_t budget_ms,
+                    uint32_t link_retry_ms);
+
+/* Returns the job id, or -1 if the table is full */
+int net_sched_add(net_sched_t *s, const net_job_t *job);
+
+/* Move a job's deadline, e.g. to run it now (delay 0) */
+void net_sched_set_due(net_sched_t *s, int id, uint32_t delay_s);
+
+/* Ask a job's due_in_s again, e.g. after its work was done another way */
+void net_sched_refresh(net_sched_t *s, int id);
+
+/*
+ * Run whatever is due: share an up link, or start a session if a deadline
+ * has passed (or a window is open on VBUS). Returns the jobs run.
+ */
+int net_sched_poll(net_sched_t *s);
+
+/* Milliseconds until poll has something to do, NET_SCHED_NEVER if idle */
+int64_t net_sched_next_ms(const net_sched_t *s);
+
+void net_sched_get_stats(const net_sched_t *s, net_sched_stats_t *stats);
+
+/* Session link time normalised to seconds per day */
+uint32_t net_sched_radio_s_per_day(const net_sched_stats_t *stats,
+                                   int64_t now_ms);
+
+/* Jobs per session in hundredths (150 = 1.5), shared links excluded */
+uint32_t net_sched_jobs_per_session_x100(const net_sched_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_SCHED_H
@@ -0,0 +1,360 @@
+/**
+ * @file net_scheduler.c
+ * @brief Network job scheduler on top of the WiFi manager
+ */
+
+#include "net_scheduler.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "net_http.h"
+#include "sdkconfig.h"
+#include "seqlock.h"
+#include "sleep_manager.h"
+#include "wifi_manager.h"
+#include <string.h>
+
+#ifdef CONFIG_NET_SCHEDULER_ENABLE
+
+static const char *TAG = "net_sched";
+
+// Longest the task sleeps between checks, so VBUS changes are noticed
+#define MAX_IDLE_MS (60 * 1000)
+
+// Owned by the scheduler task. A poll can hold it for a whole session
+// (WiFi bring-up and every job), so other tasks never touch it: they post
+// requests below and kick, and read the stats snapshot
+static net_sched_t sched;
+static TaskHandle_t sched_task = NULL;
+
+// Requests applied by the task before its next poll, bit n for job id n
+static portMUX_TYPE pending_mux = portMUX_INITIALIZER_UNLOCKED;
+static net_job_t pending_jobs[NET_SCHED_MAX_JOBS];
+static uint8_t job_count = 0; ///< Ids handed out, added or still pending
+static uint32_t pending_add = 0;
+static uint32_t pending_due = 0;
+static uint32_t pending_refresh = 0;
+
+// Stats as of the last poll
+static net_sched_stats_t stats_storage[2];
+static seqlock_t stats_lock = SEQLOCK_INITIALIZER(stats_storage);
+
+// Radio was suspended before the session, so it is stopped again after
+static bool radio_was_suspended = false;
+static volatile bool session_active = false;
+
+static int64_t link_now_ms(void *ctx)
+{
+  (void)ctx;
+  return esp_timer_get_time() / 1000;
+}
+
+static bool link_is_up(void *ctx)
+{
+  (void)ctx;
+  return wifi_manager_is_connected();
+}
+
+static bool link_up(void *ctx)
+{
+  (void)ctx;
+  if (!wifi_manager_has_credentials())
+  {
+    return false;
+  }
+
+  session_active = true;
+  radio_was_suspended = wifi_manager_is_suspended();
+  if (wifi_manager_request_connection() == ESP_OK &&
+      wifi_manager_wait_for_connection(
+          CONFIG_NET_SCHEDULER_CONNECT_TIMEOUT_S * 1000) == ESP_OK)
+  {
+    return true;
+  }
+
+  ESP_LOGW(TAG, "WiFi unavailable, jobs deferred");
+  if (radio_was_suspended)
+  {
+    wifi_manager_suspend_radio();
+  }
+  session_active = false;
+  return false;
+}
+
+static void link_down(void *ctx)
+{
+  (void)ctx;
+  // Kept-alive connections end with the session, TLS tickets stay
+  net_http_close_idle();
+  if (radio_was_suspended)
+  {
+    wifi_manager_suspend_radio();
+  }
+  session_active = false;
+}
+
+static bool link_on_vbus(void *ctx)
+{
+  (void)ctx;
+  return sleep_manager_is_usb_connected();
+}
+
+static const net_link_t wifi_link = {
+    .now_ms = link_now_ms,
+    .is_up = link_is_up,
+    .up = link_up,
+    .down = link_down,
+    .on_vbus = link_on_vbus,
+    .ctx = NULL,
+};
+
+static void log_stats(int ran, const net_sched_stats_t *stats)
+{
+  uint32_t per_session = net_sched_jobs_per_session_x100(stats);
+  ESP_LOGI(TAG,
+           "Ran %d job(s); %lu sessions (%lu.%02lu jobs each), %lu shared, "
+           "radio %lu s/day",
+           ran, (unsigned long)stats->sessions,
+           (unsigned long)(per_session / 100),
+           (unsigned long)(per_session % 100), (unsigned long)stats->shared,
+           (unsigned long)net_sched_radio_s_per_day(stats, link_now_ms(NULL)));
+}
+
+/**
+ * @brief Apply what other tasks posted since the last poll
+ *
+ * Ids are handed out in order, so adding the pending jobs lowest bit first
+ * gives each the slot its caller was told.
+ */
+static void apply_pending(void)
+{
+  net_job_t jobs[NET_SCHED_MAX_JOBS];
+
+  portENTER_CRITICAL(&pending_mux);
+  uint32_t add = pending_add;
+  uint32_t due = pending_due;
+  uint32_t refresh = pending_refresh;
+  pending_add = 0;
+  pending_due = 0;
+  pending_refresh = 0;
+  if (add)
+  {
+    memcpy(jobs, pending_jobs, sizeof(jobs));
+  }
+  portEXIT_CRITICAL(&pending_mux);
+
+  for (int id = 0; id < NET_SCHED_MAX_JOBS; id++)
+  {
+    if ((add & (1u << id)) && net_sched_add(&sched, &jobs[id]) != id)
+    {
+      ESP_LOGE(TAG, "Job '%s' lost its slot", jobs[id].name);
+    }
+  }
+  for (int id = 0; id < NET_SCHED_MAX_JOBS; id++)
+  {
+    if (due & (1u << id))
+    {
+      net_sched_set_due(&sched, id, 0);
+    }
+    if (refresh & (1u << id))
+    {
+      net_sched_refresh(&sched, id);
+    }
+  }
+}
+
+static void scheduler_task(void *arg)
+{
+  (void)arg;
+
+  for (;;)
+  {
+    net_sched_stats_t stats;
+    apply_pending();
+    int ran = net_sched_poll(&sched);
+    int64_t next_ms = net_sched_next_ms(&sched);
+    net_sched_get_stats(&sched, &stats);
+    seqlock_write(&stats_lock, &stats);
+
+    if (ran > 0)
+    {
+      log_stats(ran, &stats);
+    }
+
+    if (next_ms > MAX_IDLE_MS)
+    {
+      next_ms = MAX_IDLE_MS;
+    }
+    ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(next_ms) + 1);
+  }
+}
+
+/**
+ * @brief Keep the SoC awake until a running session has stopped the radio
+ */
+static esp_err_t sched_sleep_prepare(sleep_manager_sleep_type_t sleep_type,
+                                     void *user_data)
+{
+  (void)sleep_type;
+  (void)user_data;
+  return session_active ? ESP_ERR_INVALID_STATE : ESP_OK;
+}
+
+static esp_err_t sched_post_wake(sleep_manager_sleep_type_t sleep_type,
+                                 void *user_data)
+{
+  (void)sleep_type;
+  (void)user_data;
+  net_scheduler_kick(); // Deadlines may have passed while asleep
+  return ESP_OK;
+}
+
+esp_err_t net_scheduler_init(void)
+{
+  if (sched_task)
+  {
+    return ESP_OK;
+  }
+
+  net_sched_init(&sched, &wifi_link, CONFIG_NET_SCHEDULER_SESSION_BUDGET_S * 1000,
+                 CONFIG_NET_SCHEDULER_LINK_RETRY_S * 1000);
+  net_sched_stats_t stats;
+  net_sched_get_stats(&sched, &stats);
+  seqlock_write(&stats_lock, &stats);
+
+  if (xTaskCreate(scheduler_task, "net_sched", 4096, NULL, 3, &sched_task) !=
+      pdPASS)
+  {
+    ESP_LOGE(TAG, "Failed to create scheduler task");
+    return ESP_ERR_NO_MEM;
+  }
+
+  // After the WiFi hook on wake, before it on sleep entry
+  const sleep_manager_hook_t hook = {
+      .name = "net_sched",
+      .priority = SLEEP_HOOK_PRIORITY_DEFAULT,
+      .can_veto = true,
+      .prepare = sched_sleep_prepare,
+      .post_wake = sched_post_wake,
+  };
+  esp_err_t ret = sleep_manager_register_hook(&hook);
+  if (ret != ESP_OK)
+  {
+    ESP_LOGW(TAG, "No sleep hook (%s)", esp_err_to_name(ret));
+  }
+
+  ESP_LOGI(TAG, "Network scheduler started");
+  return ESP_OK;
+}
+
+/**
+ * @brief Post a request bit for the task to apply, then wake it
+ */
+static void post(uint32_t *pending, int id)
+{
+  if (!sched_task)
+  {
+    return;
+  }
+
+  portENTER_CRITICAL(&pending_mux);
+  if (id >= 0 && id < job_count)
+  {
+    *pending |= 1u << id;
+  }
+  portEXIT_CRITICAL(&pending_mux);
+  net_scheduler_kick();
+}
+
+int net_scheduler_add_job(const net_job_t *job)
+{
+  if (!sched_task || !job || !job->run)
+  {
+    return -1;
+  }
+
+  int id = -1;
+  portENTER_CRITICAL(&pending_mux);
+  if (job_count < NET_SCHED_MAX_JOBS)
+  {
+    id = job_count++;
+    pending_jobs[id] = *job;
+    pending_add |= 1u << id;
+  }
+  portEXIT_CRITICAL(&pending_mux);
+
+  if (id < 0)
+  {
+    ESP_LOGE(TAG, "Job table full, '%s' not registered", job->name);
+    return -1;
+  }
+  ESP_LOGI(TAG, "Job '%s' registered", job->name);
+  net_scheduler_kick();
+  return id;
+}
+
+void net_scheduler_run_soon(int id)
+{
+  post(&pending_due, id);
+}
+
+void net_scheduler_refresh(int id)
+{
+  post(&pending_refresh, id);
+}
+
+void net_scheduler_kick(void)
+{
+  if (sched_task)
+  {
+    xTaskNotifyGive(sched_task);
+  }
+}
+
+void net_scheduler_get_stats(net_sched_stats_t *stats)
+{
+  if (!stats)
+  {
+    return;
+  }
+  // All zero until net_scheduler_init()
+  seqlock_read(&stats_lock, stats);
+}
+
+#else
+
+esp_err_t net_scheduler_init(void)
+{
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
+int net_scheduler_add_job(const net_job_t *job)
+{
+  (void)job;
+  return -1;
+}
+
+void net_scheduler_run_soon(int id)
+{
+  (void)id;
+}
+
+void net_scheduler_refresh(int id)
+{
+  (void)id;
+}
+
+void net_scheduler_kick(void)
+{
+}
+
+void net_scheduler_get_stats(net_sched_stats_t *stats)
+{
+  if (stats)
+  {
+    memset(stats, 0, sizeof(*stats));
+  }
+}
+
+#endif // CONFIG_NET_SCHEDULER_ENABLE
@@ -0,0 +1,53 @@
+/**
+ * @file net_scheduler.h
+ * @brief Batches network jobs into shared WiFi sessions
+ *
+ * NTP syncs, update checks and other fetches register as jobs instead of
+ * each deciding on its own when to use WiFi. The scheduler brings the
+ * radio up once, runs every due or nearly due job back to back and stops
+ * the radio again; see net_sched.h for the policy. When WiFi is already
+ * connected for another reason, open jobs share that connection.
+ *
+ * Enable with CONFIG_NET_SCHEDULER_ENABLE.
+ */
+
+#ifndef NET_SCHEDULER_H
+#define NET_SCHEDULER_H
+
+#include "esp_err.h"
+#include "net_sched.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Starts the scheduler task; call after wifi_manager_init() */
+esp_err_t net_scheduler_init(void);
+
+/*
+ * Register a job (the descriptor is copied). Jobs run in the scheduler
+ * task and may block until done. Returns the job id, or -1.
+ *
+ * None of the calls below wait for a running session: requests are posted
+ * to the scheduler task and take effect before its next poll, so they are
+ * safe from the event bus, BLE callbacks and the jobs themselves.
+ */
+int net_scheduler_add_job(const net_job_t *job);
+
+/* Make a job due now, e.g. after a settings change */
+void net_scheduler_run_soon(int id);
+
+/* Re-read a job's due time, e.g. after the clock was set over BLE */
+void net_scheduler_refresh(int id);
+
+/* Re-evaluate now; call when WiFi connects so due jobs can share it */
+void net_scheduler_kick(void);
+
+/* Stats as of the last poll */
+void net_scheduler_get_stats(net_sched_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NET_SCHEDULER_H
@@ -4,15 +4,21 @@
  */
 
 #include "ntp_client.h"
-#include "rtc_pcf85063.h"
+#include "clock_service.h"
+#include "event_bus.h"
+#include "ntp_packet.h"
 #include "settings_storage.h"
 
 #include "esp_err.h"
 #include "esp_log.h"
-#include "esp_sntp.h"
+#include "esp_timer.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "lwip/netdb.h"
+#include "lwip/sockets.h"
 #include "sdkconfig.h"
+#include "seqlock.h"
+#include <errno.h>
 #include <stdlib.h>
 #include <string.h>
 #include <time.h>
@@ -25,12 +31,19 @@ static const char *TAG = "ntp_client";
 #define NTP_SERVER_MAX_LEN 63
 #define TIMEZONE_MAX_LEN 16
 
+#define NTP_PORT "123"
+#define NTP_MAX_ADDRS 4
+#define NTP_QUERY_SPACING_MS 250
+
 typedef struct
 {
     bool initialized;
     bool sync_task_running;
-    bool sntp_running;
     time_t last_sync;
+    int64_t last_offset_ms;
+    uint32_t last_rtt_ms;
+    uint32_t last_duration_ms;
+    uint8_t last_stratum;
     bool dst_enabled;
     int32_t tz_offset_minutes;
     char ntp_server[NTP_SERVER_MAX_LEN + 1];
@@ -39,7 +52,6 @@ typedef struct
 
 static ntp_client_state_t ntp_state = {
     .initialized = false,
-    .sntp_running = false,
     .sync_task_running = false,
     .last_sync = 0,
     .dst_enabled = false,
@@ -48,6 +60,37 @@ static ntp_client_state_t ntp_state = {
     .timezone = {0},
 };
 
+// Status snapshot for lock-free readers (UI, network consumers)
+static ntp_client_status_t status_storage[2];
+static seqlock_t status_lock = SEQLOCK_INITIALIZER(status_storage);
+
+// Serialises the sync task, the resync timer and API callers
+static portMUX_TYPE status_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// Starts the next sync once the (drift-stretched) interval has passed
+static esp_timer_handle_t resync_timer = NULL;
+
+// Task blocked in ntp_client_sync_wait(), told when the queries are done
+static TaskHandle_t sync_waiter = NULL;
+
+#define SYNC_NOTIFY_FAIL 1
+#define SYNC_NOTIFY_OK 2
+
+static void publish_status(void)
+{
+    ntp_client_status_t status = {0};
+
+    portENTER_CRITICAL(&status_mux);
+    status.last_sync = ntp_state.last_sync;
+    status.syncing = ntp_state.sync_task_running;
+    status.offset_ms = ntp_state.last_offset_ms;
+    status.rtt_ms = ntp_state.last_rtt_ms;
+    status.duration_ms = ntp_state.last_duration_ms;
+    status.stratum = ntp_state.last_stratum;
+    seqlock_write(&status_lock, &status);
+    portEXIT_CRITICAL(&status_mux);
+}
+
 static esp_err_t parse_timezone_offset(const char *timezone,
                                        int32_t *offset_minutes)
 {
@@ -109,6 +152,16 @@ static esp_err_t parse_timezone_offset(const char *timezone,
     return ESP_OK;
 }
 
+static int32_t get_total_offset_seconds(void)
+{
+    int32_t offset_seconds = ntp_state.tz_offset_minutes * 60;
+    if (ntp_state.dst_enabled)
+    {
+        offset_seconds += 3600;
+    }
+    return offset_seconds;
+}
+
 static void apply_timezone_settings(void)
 {
     int32_t offset_minutes = 0;
@@ -126,126 +179,362 @@ static void apply_timezone_settings(void)
 
     setenv("TZ", ntp_state.timezone, 1);
     tzset();
+
+    // Local time is derived in software; the RTC stays in UTC
+    clock_service_set_utc_offset(get_total_offset_seconds());
 }
 
-static int32_t get_total_offset_seconds(void)
+/**
+ * @brief Configured interval, stretched once the RTC drift is known
+ */
+static uint32_t sync_interval_sec(void)
 {
-    int32_t offset_seconds = ntp_state.tz_offset_minutes * 60;
-    if (ntp_state.dst_enabled)
+    return clock_service_sync_interval(
+        (uint32_t)CONFIG_NTP_SYNC_INTERVAL_MIN * 60U);
+}
+
+static int64_t system_time_us(void)
+{
+    struct timeval tv;
+    gettimeofday(&tv, NULL);
+    return (int64_t)tv.tv_sec * 1000000LL + tv.tv_usec;
+}
+
+/**
+ * @brief Resolve a server name, appending its IPv4 addresses
+ *
+ * @return Number of addresses added
+ */
+static int resolve_server(const char *host, struct sockaddr_in *addrs,
+                          int max_count)
+{
+    if (!host || host[0] == '\0' || max_count <= 0)
     {
-        offset_seconds += 3600;
+        return 0;
     }
-    return offset_seconds;
+
+    struct addrinfo hints = {
+        .ai_family = AF_INET,
+        .ai_socktype = SOCK_DGRAM,
+    };
+    struct addrinfo *res = NULL;
+    int err = getaddrinfo(host, NTP_PORT, &hints, &res);
+    if (err != 0 || !res)
+    {
+        ESP_LOGW(TAG, "DNS lookup for %s failed: %d", host, err);
+        return 0;
+    }
+
+    int count = 0;
+    for (struct addrinfo *ai = res; ai && count < max_count; ai = ai->ai_next)
+    {
+        memcpy(&addrs[count++], ai->ai_addr, sizeof(addrs[0]));
+    }
+    freeaddrinfo(res);
+    return count;
 }
 
-static void ntp_time_sync_cb(struct timeval *tv)
+/**
+ * @brief Send one request and wait for its reply
+ *
+ * Datagrams from other addresses and late replies to earlier requests are
+ * skipped until the query timeout.
+ *
+ * @param[out] kod Set when the server asked us to stop querying it
+ */
+static esp_err_t ntp_query(int sock, const struct sockaddr_in *addr,
+                           ntp_sample_t *sample, bool *kod)
 {
-    if (!tv)
+    uint8_t buf[NTP_PACKET_SIZE];
+    int64_t t1_us = system_time_us();
+    int64_t deadline = esp_timer_get_time() +
+                       (int64_t)CONFIG_NTP_QUERY_TIMEOUT_MS * 1000;
+
+    ntp_packet_build_request(buf, t1_us);
+    if (sendto(sock, buf, sizeof(buf), 0, (const struct sockaddr *)addr,
+               sizeof(*addr)) < 0)
     {
-        return;
+        return ESP_FAIL;
     }
 
-    ntp_state.last_sync = tv->tv_sec;
-    settings_set_uint(SETTING_KEY_LAST_SYNC, (uint32_t)ntp_state.last_sync);
-
-    struct tm local_time = {0};
-    if (ntp_client_get_local_time_from_utc(ntp_state.last_sync, &local_time) ==
-        ESP_OK)
+    for (;;)
     {
-        esp_err_t rtc_ret = rtc_write_time(&local_time);
-        if (rtc_ret != ESP_OK)
+        int64_t left_us = deadline - esp_timer_get_time();
+        if (left_us <= 0)
         {
-            ESP_LOGW(TAG, "RTC update failed: %s", esp_err_to_name(rtc_ret));
+            return ESP_ERR_TIMEOUT;
+        }
+
+        struct timeval timeout = {
+            .tv_sec = left_us / 1000000,
+            .tv_usec = left_us % 1000000,
+        };
+        setsockopt(sock, SOL_SOCKET, SO_RCVTIMEO, &timeout, sizeof(timeout));
+
+        struct sockaddr_in from;
+        socklen_t from_len = sizeof(from);
+        int len = recvfrom(sock, buf, sizeof(buf), 0, (struct sockaddr *)&from,
+                           &from_len);
+        int64_t t4_us = system_time_us();
+        if (len < 0)
+        {
+            return ESP_ERR_TIMEOUT;
+        }
+        if (from.sin_addr.s_addr != addr->sin_addr.s_addr)
+        {
+            continue;
         }
-    }
 
+        ntp_packet_result_t result =
+            ntp_packet_parse_reply(buf, (size_t)len, t1_us, t4_us, sample);
+        if (result == NTP_PACKET_MISMATCH)
+        {
+            continue;
+        }
+        if (result == NTP_PACKET_KOD)
+        {
+            *kod = true;
+        }
+        if (result != NTP_PACKET_OK)
+        {
 #ifdef CONFIG_NTP_DEBUG_LOGS
-    ESP_LOGI(TAG, "Time synchronized: %ld", (long)ntp_state.last_sync);
+            ESP_LOGI(TAG, "Reply rejected: %d", result);
 #endif
+            return ESP_ERR_INVALID_RESPONSE;
+        }
+        return ESP_OK;
+    }
 }
 
-static esp_err_t update_rtc_from_system_time(void)
+/**
+ * @brief Query the servers and keep the lowest round-trip sample
+ *
+ * The first round goes to each address once; later rounds are spaced so
+ * a single server is not hit with a burst. Stops early on a sample with a
+ * round trip of CONFIG_NTP_GOOD_RTT_MS or less.
+ *
+ * @param[out] best Best sample
+ * @param[out] replies Usable replies received
+ * @return true if at least one usable reply arrived
+ */
+static bool collect_best_sample(ntp_sample_t *best, int *replies)
 {
-    time_t now = time(NULL);
-    if (now < 1600000000)
+    struct sockaddr_in servers[NTP_MAX_ADDRS];
+    bool usable[NTP_MAX_ADDRS];
+    char host[NTP_SERVER_MAX_LEN + 1];
+
+    strncpy(host, ntp_state.ntp_server, sizeof(host) - 1);
+    host[sizeof(host) - 1] = '\0';
+
+    int count = resolve_server(host, servers, NTP_MAX_ADDRS);
+    if (strcmp(CONFIG_NTP_FALLBACK_SERVER, host) != 0)
     {
-        return ESP_ERR_INVALID_STATE;
+        count += resolve_server(CONFIG_NTP_FALLBACK_SERVER, servers + count,
+                                NTP_MAX_ADDRS - count);
     }
-
-    struct tm local_time = {0};
-    if (ntp_client_get_local_time_from_utc(now, &local_time) != ESP_OK)
+    if (count == 0)
     {
-        return ESP_FAIL;
+        return false;
     }
 
-    esp_err_t rtc_ret = rtc_write_time(&local_time);
-    if (rtc_ret != ESP_OK)
+    int sock = socket(AF_INET, SOCK_DGRAM, IPPROTO_UDP);
+    if (sock < 0)
     {
-        return rtc_ret;
+        ESP_LOGE(TAG, "Failed to create socket: %d", errno);
+        return false;
     }
 
-    ntp_state.last_sync = now;
-    settings_set_uint(SETTING_KEY_LAST_SYNC, (uint32_t)ntp_state.last_sync);
-    return ESP_OK;
-}
+    for (int i = 0; i < count; i++)
+    {
+        usable[i] = true;
+    }
 
-static void ntp_sync_wait_task(void *arg)
-{
-    (void)arg;
-    const int max_attempts = 40; // ~20 seconds at 500ms intervals
-    int attempts = 0;
+    bool have_sample = false;
+    int next = 0;
+    *replies = 0;
 
-    while (attempts < max_attempts)
+    for (int query = 0; query < CONFIG_NTP_SAMPLES; query++)
     {
-        sntp_sync_status_t status = esp_sntp_get_sync_status();
-        if (status == SNTP_SYNC_STATUS_COMPLETED)
+        int server = -1;
+        for (int i = 0; i < count && server < 0; i++)
         {
-            esp_err_t rtc_ret = update_rtc_from_system_time();
-            if (rtc_ret == ESP_OK)
+            int candidate = (next + i) % count;
+            if (usable[candidate])
             {
-                ESP_LOGI(TAG, "RTC updated after NTP sync");
-                break;
+                server = candidate;
             }
+        }
+        if (server < 0)
+        {
+            break;
+        }
+        next = server + 1;
 
-            ESP_LOGW(TAG, "RTC update pending: %s", esp_err_to_name(rtc_ret));
+        if (query >= count)
+        {
+            vTaskDelay(pdMS_TO_TICKS(NTP_QUERY_SPACING_MS));
         }
 
-        vTaskDelay(pdMS_TO_TICKS(500));
-        attempts++;
+        ntp_sample_t sample;
+        bool kod = false;
+        esp_err_t ret = ntp_query(sock, &servers[server], &sample, &kod);
+        if (kod)
+        {
+            ESP_LOGW(TAG, "Kiss-o'-death from %s, dropping it",
+                     inet_ntoa(servers[server].sin_addr));
+            usable[server] = false;
+        }
+        if (ret != ESP_OK)
+        {
+            continue;
+        }
+
+        (*replies)++;
+#ifdef CONFIG_NTP_DEBUG_LOGS
+        ESP_LOGI(TAG, "Sample from %s: offset %lld us, RTT %lu us, stratum %u",
+                 inet_ntoa(servers[server].sin_addr),
+                 (long long)sample.offset_us, (unsigned long)sample.rtt_us,
+                 sample.stratum);
+#endif
+        if (ntp_sample_is_better(&sample, have_sample ? best : NULL))
+        {
+            *best = sample;
+            have_sample = true;
+        }
+        if (best->rtt_us <= (uint32_t)CONFIG_NTP_GOOD_RTT_MS * 1000U)
+        {
+            break;
+        }
     }
 
-    if (attempts >= max_attempts)
+    close(sock);
+    return have_sample;
+}
+
+static void update_rtc_from_system_time(void)
+{
+    esp_err_t rtc_ret = clock_service_save_to_rtc();
+    if (rtc_ret != ESP_OK)
     {
-        ESP_LOGW(TAG, "NTP sync did not complete in time");
+        ESP_LOGW(TAG, "RTC update failed: %s", esp_err_to_name(rtc_ret));
+        return;
     }
 
-    ntp_state.sync_task_running = false;
-    vTaskDelete(NULL);
+    uint32_t next_s = sync_interval_sec();
+    ESP_LOGI(TAG, "RTC updated; next sync due in %lu min (%lu.%02lu syncs/day)",
+             (unsigned long)(next_s / 60), (unsigned long)(86400 / next_s),
+             (unsigned long)((8640000 / next_s) % 100));
+
+    if (resync_timer)
+    {
+        esp_timer_stop(resync_timer);
+        esp_timer_start_once(resync_timer, (uint64_t)next_s * 1000000ULL);
+    }
 }
 
-static void start_sntp(void)
+// Tells a sync_wait caller and event bus subscribers how the sync went
+static void notify_waiter(bool ok)
 {
-    esp_sntp_stop();
+    const event_t event = {
+        .type = EVENT_TIME_SYNC,
+        .time_sync.ok = ok,
+        .time_sync.source = EVENT_TIME_SYNC_NTP,
+    };
+    event_bus_publish(&event);
 
-    esp_sntp_setoperatingmode(SNTP_OPMODE_POLL);
-    esp_sntp_set_sync_mode(SNTP_SYNC_MODE_IMMED);
-    esp_sntp_set_time_sync_notification_cb(ntp_time_sync_cb);
+    portENTER_CRITICAL(&status_mux);
+    TaskHandle_t waiter = sync_waiter;
+    sync_waiter = NULL;
+    portEXIT_CRITICAL(&status_mux);
 
-    esp_sntp_set_sync_interval(
-        (uint32_t)CONFIG_NTP_SYNC_INTERVAL_MIN * 60U * 1000U);
+    if (waiter)
+    {
+        xTaskNotify(waiter, ok ? SYNC_NOTIFY_OK : SYNC_NOTIFY_FAIL,
+                    eSetValueWithOverwrite);
+    }
+}
 
-    if (ntp_state.ntp_server[0] == '\0')
+static void ntp_sync_task(void *arg)
+{
+    (void)arg;
+    int64_t start_us = esp_timer_get_time();
+    ntp_sample_t best = {0};
+    int replies = 0;
+
+    if (!collect_best_sample(&best, &replies))
     {
-        strncpy(ntp_state.ntp_server, CONFIG_NTP_DEFAULT_SERVER,
-                sizeof(ntp_state.ntp_server) - 1);
+        ESP_LOGW(TAG, "NTP sync failed: no usable reply");
+        notify_waiter(false);
+        ntp_state.sync_task_running = false;
+        publish_status();
+        vTaskDelete(NULL);
+        return;
+    }
+
+    bool stepped =
+        clock_service_correct(best.offset_us, CONFIG_NTP_SLEW_THRESHOLD_MS);
+    uint32_t duration_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+
+    portENTER_CRITICAL(&status_mux);
+    ntp_state.last_sync = time(NULL);
+    ntp_state.last_offset_ms = best.offset_us / 1000;
+    ntp_state.last_rtt_ms = best.rtt_us / 1000;
+    ntp_state.last_stratum = best.stratum;
+    ntp_state.last_duration_ms = duration_ms;
+    portEXIT_CRITICAL(&status_mux);
+    publish_status();
+    settings_set_uint(SETTING_KEY_LAST_SYNC, (uint32_t)ntp_state.last_sync);
+    // Network work is done; the waiter sees the new last_sync
+    notify_waiter(true);
+
+    ESP_LOGI(TAG,
+             "Time %s by %+lld ms (RTT %lu ms, stratum %u, %d/%d replies, "
+             "%lu ms)",
+             stepped ? "stepped" : "slewed", (long long)(best.offset_us / 1000),
+             (unsigned long)(best.rtt_us / 1000), best.stratum, replies,
+             CONFIG_NTP_SAMPLES, (unsigned long)duration_ms);
+
+    if (!stepped)
+    {
+        // The RTC is written from the system clock
+        clock_service_wait_for_slew(CONFIG_NTP_SLEW_THRESHOLD_MS);
+    }
+    update_rtc_from_system_time();
+
+    ntp_state.sync_task_running = false;
+    publish_status();
+    vTaskDelete(NULL);
+}
+
+static esp_err_t start_sync_task(void)
+{
+    portENTER_CRITICAL(&status_mux);
+    bool running = ntp_state.sync_task_running;
+    ntp_state.sync_task_running = true;
+    portEXIT_CRITICAL(&status_mux);
+    if (running)
+    {
+        return ESP_OK;
     }
 
-    esp_sntp_setservername(0, ntp_state.ntp_server);
-    esp_sntp_init();
-    ntp_state.sntp_running = true;
+    publish_status();
+    if (xTaskCreate(ntp_sync_task, "ntp_sync", 4096, NULL,
+                    tskIDLE_PRIORITY + 1, NULL) != pdPASS)
+    {
+        ntp_state.sync_task_running = false;
+        publish_status();
+        return ESP_ERR_NO_MEM;
+    }
+    return ESP_OK;
+}
 
-    ESP_LOGI(TAG, "SNTP started with server: %s", ntp_state.ntp_server);
+#ifndef CONFIG_NET_SCHEDULER_ENABLE
+static void resync_timer_cb(void *arg)
+{
+    (void)arg;
+    start_sync_task();
 }
+#endif
 
 esp_err_t ntp_client_init(void)
 {
@@ -301,9 +590,30 @@ esp_err_t ntp_client_init(void)
     {
         ntp_state.last_sync = (time_t)last_sync;
     }
+    publish_status();
 
     apply_timezone_settings();
-    start_sntp();
+
+    if (ntp_state.ntp_server[0] == '\0')
+    {
+        strncpy(ntp_state.ntp_server, CONFIG_NTP_DEFAULT_SERVER,
+                sizeof(ntp_state.ntp_server) - 1);
+    }
+
+#ifndef CONFIG_NET_SCHEDULER_ENABLE
+    // With the network scheduler, resyncs are one of its batched jobs
+    const esp_timer_create_args_t timer_args = {
+        .callback = resync_timer_cb,
+        .name = "ntp_resync",
+    };
+    esp_err_t ret = esp_timer_create(&timer_args, &resync_timer);
+    if (ret != ESP_OK)
+    {
+        ESP_LOGW(TAG, "No resync timer (%s), syncing on connect only",
+                 esp_err_to_name(ret));
+        resync_timer = NULL;
+    }
+#endif
 
     ntp_state.initialized = true;
     ESP_LOGI(TAG, "NTP client initialized");
@@ -317,8 +627,12 @@ esp_err_t ntp_client_deinit(void)
         return ESP_OK;
     }
 
-    esp_sntp_stop();
-    ntp_state.sntp_running = false;
+    if (resync_timer)
+    {
+        esp_timer_stop(resync_timer);
+        esp_timer_delete(resync_timer);
+        resync_timer = NULL;
+    }
     ntp_state.initialized = false;
     return ESP_OK;
 }
@@ -330,23 +644,108 @@ esp_err_t ntp_client_sync_now(void)
         return ESP_ERR_INVALID_STATE;
     }
 
-    if (!ntp_state.sntp_running)
+    return start_sync_task();
+}
+
+esp_err_t ntp_client_sync_wait(uint32_t timeout_ms)
+{
+    if (!ntp_state.initialized)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    portENTER_CRITICAL(&status_mux);
+    bool busy = ntp_state.sync_task_running || sync_waiter != NULL;
+    if (!busy)
+    {
+        sync_waiter = xTaskGetCurrentTaskHandle();
+    }
+    portEXIT_CRITICAL(&status_mux);
+    if (busy)
+    {
+        return ESP_ERR_INVALID_STATE;
+    }
+
+    // Drop a result left over from a wait that timed out
+    xTaskNotifyStateClear(NULL);
+
+    esp_err_t ret = start_sync_task();
+    uint32_t result = 0;
+    if (ret == ESP_OK &&
+        xTaskNotifyWait(0, UINT32_MAX, &result, pdMS_TO_TICKS(timeout_ms)) !=
+            pdTRUE)
+    {
+        ret = ESP_ERR_TIMEOUT;
+    }
+    if (ret != ESP_OK)
+    {
+        portENTER_CRITICAL(&status_mux);
+        sync_waiter = NULL;
+        portEXIT_CRITICAL(&status_mux);
+        return ret;
+    }
+
+    return result == SYNC_NOTIFY_OK ? ESP_OK : ESP_FAIL;
+}
+
+uint32_t ntp_client_next_sync_in_s(void)
+{
+    if (!ntp_state.initialized)
+    {
+        return UINT32_MAX;
+    }
+
+    ntp_client_status_t status;
+    ntp_client_get_status(&status);
+
+    time_t now = time(NULL);
+    if (now < 1600000000 || status.last_sync == 0)
+    {
+        return 0;
+    }
+
+    int64_t elapsed = (int64_t)now - (int64_t)status.last_sync;
+    int64_t interval = (int64_t)sync_interval_sec();
+    if (elapsed < 0 || elapsed >= interval)
     {
-        start_sntp();
+        return 0; // A clock that went backwards also asks for a sync
     }
+    return (uint32_t)(interval - elapsed);
+}
 
-    if (!esp_sntp_restart())
+bool ntp_client_needs_sync(void)
+{
+    if (!ntp_state.initialized)
     {
-        start_sntp();
+        return false;
     }
+    return ntp_client_next_sync_in_s() == 0;
+}
 
-    if (!ntp_state.sync_task_running)
+esp_err_t ntp_client_note_external_sync(int64_t offset_ms,
+                                        uint32_t duration_ms)
+{
+    if (!ntp_state.initialized)
     {
-        ntp_state.sync_task_running = true;
-        xTaskCreate(ntp_sync_wait_task, "ntp_sync_wait", 4096, NULL,
-                    tskIDLE_PRIORITY + 1, NULL);
+        return ESP_ERR_INVALID_STATE;
     }
 
+    portENTER_CRITICAL(&status_mux);
+    ntp_state.last_sync = time(NULL);
+    ntp_state.last_offset_ms = offset_ms;
+    ntp_state.last_rtt_ms = 0;
+    ntp_state.last_stratum = 0; // Not an NTP server
+    ntp_state.last_duration_ms = duration_ms;
+    portEXIT_CRITICAL(&status_mux);
+    publish_status();
+    settings_set_uint(SETTING_KEY_LAST_SYNC, (uint32_t)ntp_state.last_sync);
+
+    if (resync_timer)
+    {
+        esp_timer_stop(resync_timer);
+        esp_timer_start_once(resync_timer,
+                             (uint64_t)sync_interval_sec() * 1000000ULL);
+    }
     return ESP_OK;
 }
 
@@ -360,15 +759,7 @@ esp_err_t ntp_client_on_wifi_connected(void)
         return ESP_ERR_INVALID_STATE;
     }
 
-    time_t now = time(NULL);
-    if (now < 1600000000 || ntp_state.last_sync == 0)
-    {
-        return ntp_client_sync_now();
-    }
-
-    int64_t elapsed = (int64_t)now - (int64_t)ntp_state.last_sync;
-    int64_t min_interval = (int64_t)CONFIG_NTP_SYNC_INTERVAL_MIN * 60;
-    if (elapsed >= min_interval)
+    if (ntp_client_needs_sync())
     {
         return ntp_client_sync_now();
     }
@@ -384,10 +775,20 @@ esp_err_t ntp_client_get_last_sync(time_t *last_sync)
         return ESP_ERR_INVALID_ARG;
     }
 
-    *last_sync = ntp_state.last_sync;
+    ntp_client_status_t status;
+    ntp_client_get_status(&status);
+    *last_sync = status.last_sync;
     return ESP_OK;
 }
 
+void ntp_client_get_status(ntp_client_status_t *status)
+{
+    if (status)
+    {
+        seqlock_read(&status_lock, status);
+    }
+}
+
 esp_err_t ntp_client_set_ntp_server(const char *server)
 {
     if (!server)
@@ -406,12 +807,6 @@ esp_err_t ntp_client_set_ntp_server(const char *server)
 
     settings_set_string(SETTING_KEY_NTP_SERVER, ntp_state.ntp_server);
 
-    if (ntp_state.initialized)
-    {
-        esp_sntp_setservername(0, ntp_state.ntp_server);
-        esp_sntp_restart();
-    }
-
     return ESP_OK;
 }
 
@@ -465,6 +860,7 @@ esp_err_t ntp_client_set_dst_enabled(bool enabled)
 {
     ntp_state.dst_enabled = enabled;
     settings_set_bool(SETTING_KEY_DST_ENABLED, enabled);
+    clock_service_set_utc_offset(get_total_offset_seconds());
     return ESP_OK;
 }
 
@@ -502,6 +898,24 @@ esp_err_t ntp_client_sync_now(void) { return ESP_OK; }
 
 esp_err_t ntp_client_on_wifi_connected(void) { return ESP_OK; }
 
+esp_err_t ntp_client_sync_wait(uint32_t timeout_ms)
+{
+    (void)timeout_ms;
+    return ESP_ERR_NOT_SUPPORTED;
+}
+
+bool ntp_client_needs_sync(void) { return false; }
+
+uint32_t ntp_client_next_sync_in_s(void) { return UINT32_MAX; }
+
+esp_err_t ntp_client_note_external_sync(int64_t offset_ms,
+                                        uint32_t duration_ms)
+{
+    (void)offset_ms;
+    (void)duration_ms;
+    return ESP_OK;
+}
+
 esp_err_t ntp_client_get_last_sync(time_t *last_sync)
 {
     if (last_sync)
@@ -511,6 +925,14 @@ esp_err_t ntp_client_get_last_sync(time_t *last_sync)
     return ESP_OK;
 }
 
+void ntp_client_get_status(ntp_client_status_t *status)
+{
+    if (status)
+    {
+        memset(status, 0, sizeof(*status));
+    }
+}
+
 esp_err_t ntp_client_set_ntp_server(const char *server)
 {
     (void)server;
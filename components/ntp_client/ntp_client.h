@@ -8,6 +8,7 @@
 
 #include "esp_err.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 
 #ifdef __cplusplus
@@ -15,10 +16,27 @@ extern "C"
 {
 #endif
 
+    /**
+     * @brief Snapshot of the sync status
+     *
+     * The quality fields describe the last successful sync of this boot and
+     * are zero before it.
+     */
+    typedef struct
+    {
+        time_t last_sync;     ///< Last successful sync (UTC epoch), 0 if never
+        bool syncing;         ///< A sync is in progress
+        int64_t offset_ms;    ///< Correction applied, + = clock was behind
+        uint32_t rtt_ms;      ///< Round trip of the sample used
+        uint32_t duration_ms; ///< From sync start to the clock correction
+        uint8_t stratum;      ///< Stratum of the server used
+    } ntp_client_status_t;
+
     /**
      * @brief Initialize the NTP client
      *
-     * Loads settings (server, timezone, DST) and prepares SNTP.
+     * Loads settings (server, timezone, DST). Syncs are started by
+     * ntp_client_sync_now(), on WiFi connect and by a resync timer.
      *
      * @return ESP_OK on success, error code otherwise
      */
@@ -27,7 +45,7 @@ extern "C"
     /**
      * @brief Deinitialize the NTP client
      *
-     * Stops SNTP service.
+     * Stops the resync timer.
      *
      * @return ESP_OK on success, error code otherwise
      */
@@ -36,10 +54,26 @@ extern "C"
     /**
      * @brief Trigger an immediate NTP sync
      *
+     * Runs in a background task: sends up to CONFIG_NTP_SAMPLES queries to
+     * the configured and fallback servers, keeps the lowest round-trip
+     * sample, slews or steps the system clock and then updates the RTC.
+     *
      * @return ESP_OK on success, error code otherwise
      */
     esp_err_t ntp_client_sync_now(void);
 
+    /**
+     * @brief Run a sync and wait until its queries are done
+     *
+     * Slewing and the RTC update carry on in the background, so the caller
+     * may drop the network as soon as this returns.
+     *
+     * @param timeout_ms Longest wait
+     * @return ESP_OK on a usable reply, ESP_FAIL if none, ESP_ERR_TIMEOUT,
+     *         ESP_ERR_INVALID_STATE if not initialized or already syncing
+     */
+    esp_err_t ntp_client_sync_wait(uint32_t timeout_ms);
+
     /**
      * @brief Notify NTP client that WiFi is connected
      *
@@ -49,6 +83,37 @@ extern "C"
      */
     esp_err_t ntp_client_on_wifi_connected(void);
 
+    /**
+     * @brief Check whether an automatic sync is due
+     *
+     * True when the clock was never synced or the last sync is older than
+     * CONFIG_NTP_SYNC_INTERVAL_MIN. Used as a WiFi network consumer.
+     *
+     * @return true if a sync is due
+     */
+    bool ntp_client_needs_sync(void);
+
+    /**
+     * @brief Seconds until the next automatic sync is due
+     *
+     * @return 0 if due now, UINT32_MAX if the client is not initialized
+     */
+    uint32_t ntp_client_next_sync_in_s(void);
+
+    /**
+     * @brief Record that another source set the clock and the RTC
+     *
+     * For time from a trusted reference other than NTP (the phone over
+     * BLE). Counts as a successful sync, so the next automatic sync is
+     * due a full interval from now. Shown with stratum 0.
+     *
+     * @param offset_ms Correction that was applied
+     * @param duration_ms Time the source took, for the status
+     * @return ESP_OK, ESP_ERR_INVALID_STATE if not initialized
+     */
+    esp_err_t ntp_client_note_external_sync(int64_t offset_ms,
+                                            uint32_t duration_ms);
+
     /**
      * @brief Get last successful sync time (UTC epoch)
      *
@@ -57,10 +122,20 @@ extern "C"
      */
     esp_err_t ntp_client_get_last_sync(time_t *last_sync);
 
+    /**
+     * @brief Get a consistent snapshot of the sync status
+     *
+     * Lock-free; safe from any task. time_t is 64-bit, so last_sync cannot
+     * be read atomically on its own while the SNTP callback updates it.
+     *
+     * @param[out] status Current status
+     */
+    void ntp_client_get_status(ntp_client_status_t *status);
+
     /**
      * @brief Set NTP server hostname
      *
-     * Saves to settings storage and updates SNTP if running.
+     * Saves to settings storage; used from the next sync.
      *
      * @param server Hostname string
      * @return ESP_OK on success, error code otherwise
@@ -0,0 +1,158 @@
+/**
+ * @file ntp_packet.c
+ * @brief NTP client packet codec implementation
+ */
+
+#include "ntp_packet.h"
+#include <string.h>
+
+#define LI_VN_MODE_REQUEST 0x23 // LI 0, version 4, mode 3 (client)
+#define MODE_SERVER 4
+#define LI_UNSYNCED 3
+
+#define OFFSET_ORIGIN 24
+#define OFFSET_RECEIVE 32
+#define OFFSET_TRANSMIT 40
+
+// Seconds from 1900-01-01 (NTP era 0) to 1970-01-01
+#define NTP_UNIX_DELTA 2208988800LL
+#define NTP_ERA_SECONDS 4294967296LL
+#define US_PER_SEC 1000000LL
+
+// Timestamp rounding can make a near-zero round trip slightly negative
+#define RTT_SLACK_US 1000
+
+static uint32_t read_be32(const uint8_t *p)
+{
+    return ((uint32_t)p[0] << 24) | ((uint32_t)p[1] << 16) |
+           ((uint32_t)p[2] << 8) | (uint32_t)p[3];
+}
+
+static void write_be32(uint8_t *p, uint32_t value)
+{
+    p[0] = (uint8_t)(value >> 24);
+    p[1] = (uint8_t)(value >> 16);
+    p[2] = (uint8_t)(value >> 8);
+    p[3] = (uint8_t)value;
+}
+
+static void encode_timestamp(uint8_t *p, int64_t unix_us)
+{
+    int64_t sec = unix_us / US_PER_SEC;
+    int64_t rem = unix_us % US_PER_SEC;
+    if (rem < 0)
+    {
+        sec--;
+        rem += US_PER_SEC;
+    }
+
+    // Truncation to 32 bits wraps into era 1 after 2036 as intended
+    write_be32(p, (uint32_t)(sec + NTP_UNIX_DELTA));
+    write_be32(p + 4, (uint32_t)(((uint64_t)rem << 32) / US_PER_SEC));
+}
+
+/**
+ * @brief NTP timestamp to Unix microseconds
+ *
+ * Seconds with the top bit clear are taken as era 1 (2036-2104), which
+ * covers every date this firmware can see (RFC 4330 section 3).
+ */
+static int64_t decode_timestamp(const uint8_t *p)
+{
+    uint32_t sec = read_be32(p);
+    uint32_t frac = read_be32(p + 4);
+
+    int64_t unix_sec = (int64_t)sec - NTP_UNIX_DELTA;
+    if (!(sec & 0x80000000U))
+    {
+        unix_sec += NTP_ERA_SECONDS;
+    }
+    return unix_sec * US_PER_SEC +
+           (int64_t)(((uint64_t)frac * US_PER_SEC) >> 32);
+}
+
+static bool timestamp_is_zero(const uint8_t *p)
+{
+    return read_be32(p) == 0 && read_be32(p + 4) == 0;
+}
+
+void ntp_packet_build_request(uint8_t *buf, int64_t t1_us)
+{
+    memset(buf, 0, NTP_PACKET_SIZE);
+    buf[0] = LI_VN_MODE_REQUEST;
+    encode_timestamp(buf + OFFSET_TRANSMIT, t1_us);
+}
+
+ntp_packet_result_t ntp_packet_parse_reply(const uint8_t *buf, size_t len,
+                                           int64_t t1_us, int64_t t4_us,
+                                           ntp_sample_t *sample)
+{
+    if (len < NTP_PACKET_SIZE)
+    {
+        return NTP_PACKET_SHORT;
+    }
+
+    uint8_t leap = buf[0] >> 6;
+    uint8_t version = (buf[0] >> 3) & 0x07;
+    uint8_t mode = buf[0] & 0x07;
+    uint8_t stratum = buf[1];
+
+    if (mode != MODE_SERVER || version < 3 || version > 4)
+    {
+        return NTP_PACKET_BAD_MODE;
+    }
+
+    // The server echoes our transmit timestamp as its origin
+    uint8_t expected[8];
+    encode_timestamp(expected, t1_us);
+    if (memcmp(buf + OFFSET_ORIGIN, expected, sizeof(expected)) != 0)
+    {
+        return NTP_PACKET_MISMATCH;
+    }
+
+    if (stratum == 0)
+    {
+        return NTP_PACKET_KOD;
+    }
+    if (leap == LI_UNSYNCED || stratum > NTP_STRATUM_MAX)
+    {
+        return NTP_PACKET_UNSYNCED;
+    }
+    if (timestamp_is_zero(buf + OFFSET_RECEIVE) ||
+        timestamp_is_zero(buf + OFFSET_TRANSMIT))
+    {
+        return NTP_PACKET_BAD_TIME;
+    }
+
+    int64_t t2_us = decode_timestamp(buf + OFFSET_RECEIVE);
+    int64_t t3_us = decode_timestamp(buf + OFFSET_TRANSMIT);
+
+    int64_t rtt = (t4_us - t1_us) - (t3_us - t2_us);
+    if (rtt < 0 && rtt > -RTT_SLACK_US)
+    {
+        rtt = 0;
+    }
+    if (rtt < 0 || rtt > UINT32_MAX || t3_us < t2_us)
+    {
+        return NTP_PACKET_BAD_TIME;
+    }
+
+    sample->offset_us = ((t2_us - t1_us) + (t3_us - t4_us)) / 2;
+    sample->rtt_us = (uint32_t)rtt;
+    sample->stratum = stratum;
+    return NTP_PACKET_OK;
+}
+
+bool ntp_sample_is_better(const ntp_sample_t *sample,
+                          const ntp_sample_t *best)
+{
+    if (!best)
+    {
+        return true;
+    }
+    if (sample->rtt_us != best->rtt_us)
+    {
+        return sample->rtt_us < best->rtt_us;
+    }
+    return sample->stratum < best->stratum;
+}
@@ -0,0 +1,88 @@
+/**
+ * @file ntp_packet.h
+ * @brief NTP (RFC 5905) client packet codec (pure, no network access)
+ *
+ * Builds client requests and turns a server reply plus the local send and
+ * receive times into one clock sample. Kept free of sockets and ESP-IDF so
+ * it can be exercised on the host against recorded or synthetic replies.
+ */
+
+#ifndef NTP_PACKET_H
+#define NTP_PACKET_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Size of an NTP header without extensions or MAC */
+#define NTP_PACKET_SIZE 48
+
+/** Highest stratum of a synchronized server */
+#define NTP_STRATUM_MAX 15
+
+    /**
+     * @brief One clock sample from a request/reply exchange
+     */
+    typedef struct
+    {
+        int64_t offset_us; ///< Server clock minus local clock
+        uint32_t rtt_us;   ///< Round trip minus server processing time
+        uint8_t stratum;   ///< Server stratum (1 = reference clock)
+    } ntp_sample_t;
+
+    typedef enum
+    {
+        NTP_PACKET_OK = 0,
+        NTP_PACKET_SHORT,    ///< Fewer than NTP_PACKET_SIZE bytes
+        NTP_PACKET_BAD_MODE, ///< Not a server reply of a known version
+        NTP_PACKET_MISMATCH, ///< Reply to another request (late or spoofed)
+        NTP_PACKET_KOD,      ///< Kiss-o'-death, stop querying this server
+        NTP_PACKET_UNSYNCED, ///< Server has no usable time itself
+        NTP_PACKET_BAD_TIME, ///< Timestamps inconsistent (negative RTT)
+    } ntp_packet_result_t;
+
+    /**
+     * @brief Fill a client request
+     *
+     * @param[out] buf NTP_PACKET_SIZE bytes
+     * @param t1_us Local send time (Unix epoch, microseconds); echoed back
+     *              by the server and used to match the reply
+     */
+    void ntp_packet_build_request(uint8_t *buf, int64_t t1_us);
+
+    /**
+     * @brief Parse a server reply into a sample
+     *
+     * @param buf Received datagram
+     * @param len Its length
+     * @param t1_us Send time passed to ntp_packet_build_request()
+     * @param t4_us Local receive time (Unix epoch, microseconds)
+     * @param[out] sample Filled when NTP_PACKET_OK is returned
+     * @return Parse result
+     */
+    ntp_packet_result_t ntp_packet_parse_reply(const uint8_t *buf, size_t len,
+                                               int64_t t1_us, int64_t t4_us,
+                                               ntp_sample_t *sample);
+
+    /**
+     * @brief Whether a sample should replace the current best one
+     *
+     * The lowest round trip wins: queuing delay is the main source of
+     * offset error and it only ever adds to the round trip.
+     *
+     * @param sample Candidate
+     * @param best Current best, or NULL if none yet
+     */
+    bool ntp_sample_is_better(const ntp_sample_t *sample,
+                              const ntp_sample_t *best);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // NTP_PACKET_H
@@ -0,0 +1,722 @@
+/**
+ * @file ota_download.c
+ * @brief Resumable firmware download implementation
+ */
+
+#include "ota_download.h"
+#include "esp_app_desc.h"
+#include "esp_app_format.h"
+#include "esp_log.h"
+#include "esp_ota_ops.h"
+#include "esp_partition.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include "freertos/task.h"
+#include "mbedtls/sha256.h"
+#include "net_http.h"
+#include "ota_stream.h"
+#include "sdkconfig.h"
+#include "settings_storage.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#ifdef CONFIG_ENABLE_WIFI
+#include "wifi_manager.h"
+#endif
+
+#ifdef CONFIG_ENABLE_OTA
+
+static const char *TAG = "ota_download";
+
+#define RESUME_URL_KEY "ota_r_url"
+#define RESUME_ETAG_KEY "ota_r_etag"
+#define RESUME_SLOT_KEY "ota_r_slot"
+#define RESUME_SIZE_KEY "ota_r_size"
+#define RESUME_OFFSET_KEY "ota_r_off"
+#define RESUME_OUT_KEY "ota_r_out"
+#define RESUME_FORMAT_KEY "ota_r_fmt"
+#define RESUME_FRAME_KEY "ota_r_frame"
+#define RESUME_IMAGE_KEY "ota_r_isize"
+
+#define SECTOR_SIZE 4096
+#define CHECKPOINT_BYTES (64 * 1024) // Resume granularity vs. NVS writes
+#define URL_MAX_LEN 256
+#define ETAG_MAX_LEN 64
+#define HTTP_TIMEOUT_MS 10000
+#define BACKOFF_BASE_MS 2000
+#define BACKOFF_MAX_MS 60000
+#define WIFI_WAIT_MS 15000
+
+#ifdef CONFIG_OTA_RESUME
+#define RESUME_RETRIES CONFIG_OTA_RESUME_RETRIES
+#else
+#define RESUME_RETRIES 0
+#endif
+
+// Image header, first segment header and app descriptor, in that order
+#define HEAD_LEN                                                               \
+  (sizeof(esp_image_header_t) + sizeof(esp_image_segment_header_t) +           \
+   sizeof(esp_app_desc_t))
+
+typedef struct
+{
+  const esp_partition_t *slot;
+  const esp_partition_t *base; ///< Running slot, source of delta images
+  char url[URL_MAX_LEN];
+  char etag[ETAG_MAX_LEN]; ///< Validator of the file being fetched
+  uint32_t total;          ///< File size, 0 until known
+  uint32_t received;       ///< File bytes decoded
+  uint32_t image_size;     ///< Image size once known (differs if packed)
+  uint32_t written;        ///< Image bytes on flash
+  uint32_t erased_to;      ///< End of the erased area
+  uint32_t checkpoint;     ///< File offset last saved for resume
+  uint8_t head[HEAD_LEN];
+  bool head_checked;
+
+  ota_stream_t *stream; ///< Compressed/delta decoder, plain passes through
+  esp_err_t io_err;     ///< Why a decoder callback failed
+
+  // Response headers of the current request
+  char resp_etag[ETAG_MAX_LEN];
+  uint32_t range_total;
+
+  ota_download_progress_cb_t progress;
+  ota_download_stats_t stats;
+} download_t;
+
+static download_t dl;
+
+static void save_checkpoint(void)
+{
+#ifdef CONFIG_OTA_RESUME
+  // Only frame boundaries of a packed image can be resumed from
+  uint32_t offset = 0;
+  uint32_t out = 0;
+  ota_stream_resume_point(dl.stream, &offset, &out);
+  if (offset == dl.checkpoint)
+  {
+    return;
+  }
+
+  const ota_stream_header_t *hdr = ota_stream_get_header(dl.stream);
+  uint32_t format = 0;
+  if (hdr)
+  {
+    format = hdr->flags | ((uint32_t)hdr->window_bits << 8) |
+             ((uint32_t)hdr->lookahead_bits << 16);
+  }
+
+  // Offset last, so a half-written record never points past its own URL
+  settings_set_string(RESUME_URL_KEY, dl.url);
+  settings_set_string(RESUME_ETAG_KEY, dl.etag);
+  settings_set_uint(RESUME_SLOT_KEY, dl.slot->address);
+  settings_set_uint(RESUME_SIZE_KEY, dl.total);
+  settings_set_uint(RESUME_FORMAT_KEY, format);
+  settings_set_uint(RESUME_FRAME_KEY, hdr ? hdr->frame_size : 0);
+  settings_set_uint(RESUME_IMAGE_KEY, dl.image_size);
+  settings_set_uint(RESUME_OUT_KEY, out);
+  settings_set_uint(RESUME_OFFSET_KEY, offset);
+  dl.checkpoint = offset;
+#endif
+}
+
+void ota_download_forget(void)
+{
+  settings_erase(RESUME_OFFSET_KEY);
+  settings_erase(RESUME_OUT_KEY);
+  settings_erase(RESUME_IMAGE_KEY);
+  settings_erase(RESUME_FRAME_KEY);
+  settings_erase(RESUME_FORMAT_KEY);
+  settings_erase(RESUME_SIZE_KEY);
+  settings_erase(RESUME_SLOT_KEY);
+  settings_erase(RESUME_ETAG_KEY);
+  settings_erase(RESUME_URL_KEY);
+}
+
+/**
+ * @brief Check the image header and app descriptor of a fresh download
+ *
+ * They arrive in the first few hundred bytes, so a wrong chip, project or
+ * an image too large for the slot fails before the rest is fetched.
+ */
+static esp_err_t validate_head(void)
+{
+  const esp_image_header_t *hdr = (const esp_image_header_t *)dl.head;
+  const esp_app_desc_t *desc =
+      (const esp_app_desc_t *)(dl.head + sizeof(esp_image_header_t) +
+                               sizeof(esp_image_segment_header_t));
+
+  if (hdr->magic != ESP_IMAGE_HEADER_MAGIC ||
+      desc->magic_word != ESP_APP_DESC_MAGIC_WORD)
+  {
+    ESP_LOGE(TAG, "Not an app image");
+    return ESP_ERR_INVALID_RESPONSE;
+  }
+
+  if (hdr->chip_id != CONFIG_IDF_FIRMWARE_CHIP_ID)
+  {
+    ESP_LOGE(TAG, "Image is for chip id %d", hdr->chip_id);
+    return ESP_ERR_INVALID_VERSION;
+  }
+
+  const esp_app_desc_t *running = esp_app_get_description();
+  if (strncmp(desc->project_name, running->project_name,
+              sizeof(desc->project_name)) != 0)
+  {
+    ESP_LOGE(TAG, "Image is for '%.32s', not '%.32s'", desc->project_name,
+             running->project_name);
+    return ESP_ERR_INVALID_VERSION;
+  }
+
+  if (strncmp(desc->version, running->version, sizeof(desc->version)) == 0)
+  {
+    ESP_LOGW(TAG, "Image has the running version %.32s, installing anyway",
+             desc->version);
+  }
+
+  ESP_LOGI(TAG, "Image %.32s (%lu bytes) -> '%s'", desc->version,
+           (unsigned long)dl.image_size, dl.slot->label);
+  return ESP_OK;
+}
+
+static esp_err_t write_chunk(const uint8_t *data, size_t len)
+{
+  if (dl.written + len > dl.slot->size ||
+      (dl.image_size > 0 && dl.written + len > dl.image_size))
+  {
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  if (!dl.head_checked && dl.written < HEAD_LEN)
+  {
+    size_t copy = HEAD_LEN - dl.written;
+    copy = copy < len ? copy : len;
+    memcpy(dl.head + dl.written, data, copy);
+    if (dl.written + copy == HEAD_LEN)
+    {
+      esp_err_t ret = validate_head();
+      if (ret != ESP_OK)
+      {
+        return ret;
+      }
+      dl.head_checked = true;
+    }
+  }
+
+  uint32_t end = dl.written + len;
+  if (end > dl.erased_to)
+  {
+    uint32_t erase_end = (end + SECTOR_SIZE - 1) & ~(uint32_t)(SECTOR_SIZE - 1);
+    erase_end = erase_end < dl.slot->size ? erase_end : dl.slot->size;
+    esp_err_t ret = esp_partition_erase_range(dl.slot, dl.erased_to,
+                                              erase_end - dl.erased_to);
+    if (ret != ESP_OK)
+    {
+      return ret;
+    }
+    dl.erased_to = erase_end;
+  }
+
+  esp_err_t ret = esp_partition_write(dl.slot, dl.written, data, len);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  dl.written = end;
+  return ESP_OK;
+}
+
+static int stream_write(void *ctx, const uint8_t *data, size_t len)
+{
+  (void)ctx;
+  dl.io_err = write_chunk(data, len);
+  return dl.io_err == ESP_OK ? 0 : -1;
+}
+
+static int stream_read_base(void *ctx, uint32_t offset, uint8_t *buf,
+                            size_t len)
+{
+  (void)ctx;
+  dl.io_err = esp_partition_read(dl.base, offset, buf, len);
+  return dl.io_err == ESP_OK ? 0 : -1;
+}
+
+/**
+ * @brief Accept a packed image's header before anything is written
+ */
+static int stream_header(void *ctx, const ota_stream_header_t *hdr)
+{
+  (void)ctx;
+  if (hdr->image_size > dl.slot->size)
+  {
+    ESP_LOGE(TAG, "Image (%lu bytes) does not fit '%s' (%lu bytes)",
+             (unsigned long)hdr->image_size, dl.slot->label,
+             (unsigned long)dl.slot->size);
+    dl.io_err = ESP_ERR_INVALID_SIZE;
+    return -1;
+  }
+
+  if (hdr->flags & OTA_STREAM_FLAG_DELTA)
+  {
+    const esp_app_desc_t *running = esp_app_get_description();
+    if (memcmp(hdr->base_sha256, running->app_elf_sha256,
+               sizeof(hdr->base_sha256)) != 0)
+    {
+      ESP_LOGE(TAG, "Delta was made against another build than the running "
+                    "one, fetch the full image instead");
+      dl.io_err = ESP_ERR_INVALID_VERSION;
+      return -1;
+    }
+  }
+
+  dl.image_size = hdr->image_size;
+  ESP_LOGI(TAG, "%s image: %lu bytes for %lu on flash",
+           (hdr->flags & OTA_STREAM_FLAG_DELTA) ? "Delta" : "Compressed",
+           (unsigned long)dl.total, (unsigned long)dl.image_size);
+  return 0;
+}
+
+static const ota_stream_io_t stream_io = {
+    .write = stream_write,
+    .read_base = stream_read_base,
+    .header = stream_header,
+};
+
+static esp_err_t decode(const uint8_t *data, size_t len)
+{
+  dl.io_err = ESP_OK;
+  ota_stream_result_t res = ota_stream_push(dl.stream, data, len);
+  if (res == OTA_STREAM_OK)
+  {
+    return ESP_OK;
+  }
+  if (res == OTA_STREAM_IO_ERROR)
+  {
+    return dl.io_err;
+  }
+  ESP_LOGE(TAG, "%s at byte %lu",
+           res == OTA_STREAM_BAD_HEADER ? "Unsupported OTA container"
+                                        : "OTA container does not decode",
+           (unsigned long)dl.received);
+  return ESP_ERR_INVALID_RESPONSE;
+}
+
+#ifdef CONFIG_OTA_RESUME
+/**
+ * @brief Pick up a checkpoint left by an earlier download of the same file
+ */
+static void load_checkpoint(void)
+{
+  char url[URL_MAX_LEN] = {0};
+  uint32_t slot = 0;
+  uint32_t total = 0;
+  uint32_t offset = 0;
+  uint32_t out = 0;
+  uint32_t format = 0;
+  uint32_t image_size = 0;
+  ota_stream_header_t hdr = {0};
+
+  settings_get_uint(RESUME_OFFSET_KEY, 0, &offset);
+  settings_get_uint(RESUME_SIZE_KEY, 0, &total);
+  settings_get_uint(RESUME_SLOT_KEY, 0, &slot);
+  settings_get_string(RESUME_URL_KEY, "", url, sizeof(url));
+  settings_get_uint(RESUME_OUT_KEY, 0, &out);
+  settings_get_uint(RESUME_FORMAT_KEY, 0, &format);
+  settings_get_uint(RESUME_FRAME_KEY, 0, &hdr.frame_size);
+  settings_get_uint(RESUME_IMAGE_KEY, 0, &image_size);
+  hdr.flags = (uint8_t)format;
+  hdr.window_bits = (uint8_t)(format >> 8);
+  hdr.lookahead_bits = (uint8_t)(format >> 16);
+  hdr.image_size = image_size;
+
+  if (offset == 0 || offset >= total || slot != dl.slot->address ||
+      out > dl.slot->size || strcmp(url, dl.url) != 0 ||
+      ota_stream_resume(dl.stream, &stream_io, format ? &hdr : NULL, offset,
+                        out) != OTA_STREAM_OK)
+  {
+    if (offset != 0)
+    {
+      ESP_LOGI(TAG, "Saved download is for another image or slot, ignoring");
+      ota_download_forget();
+    }
+    ota_stream_init(dl.stream, &stream_io);
+    return;
+  }
+
+  settings_get_string(RESUME_ETAG_KEY, "", dl.etag, sizeof(dl.etag));
+  dl.total = total;
+  dl.received = offset;
+  dl.image_size = image_size;
+  dl.written = out;
+  dl.erased_to = out;
+  dl.checkpoint = offset;
+  dl.head_checked = true; // Checked when the first bytes were written
+  dl.stats.resumed_from = offset;
+  ESP_LOGI(TAG, "Resuming download at %lu of %lu bytes",
+           (unsigned long)offset, (unsigned long)total);
+}
+#endif
+
+static void restart_from_zero(void)
+{
+  dl.received = 0;
+  dl.written = 0;
+  dl.erased_to = 0;
+  dl.checkpoint = 0;
+  dl.total = 0;
+  dl.image_size = 0;
+  dl.etag[0] = '\0';
+  dl.head_checked = false;
+  ota_stream_init(dl.stream, &stream_io);
+  ota_download_forget();
+}
+
+static void on_header(const char *key, const char *value, void *user_data)
+{
+  (void)user_data;
+  if (!key)
+  {
+    // A redirect hop starts
+    dl.resp_etag[0] = '\0';
+    dl.range_total = 0;
+  }
+  else if (strcasecmp(key, "ETag") == 0)
+  {
+    strncpy(dl.resp_etag, value, sizeof(dl.resp_etag) - 1);
+    dl.resp_etag[sizeof(dl.resp_etag) - 1] = '\0';
+  }
+  else if (strcasecmp(key, "Content-Range") == 0)
+  {
+    // "bytes <first>-<last>/<total>"
+    const char *slash = strchr(value, '/');
+    if (slash)
+    {
+      dl.range_total = (uint32_t)strtoul(slash + 1, NULL, 10);
+    }
+  }
+}
+
+/**
+ * @brief One HTTP session from dl.received to the end of the file
+ *
+ * @return ESP_OK when the image is complete, ESP_ERR_INVALID_STATE when
+ *         the download must restart from byte 0 at once, otherwise see
+ *         is_retryable()
+ */
+static esp_err_t fetch_session(uint8_t *buf, size_t buf_size)
+{
+  // GitHub release assets redirect to a CDN
+  net_http_opts_t opts = {
+      .url = dl.url,
+      .timeout_ms = HTTP_TIMEOUT_MS,
+      .on_header = on_header,
+  };
+  char range[32];
+  if (dl.received > 0)
+  {
+    snprintf(range, sizeof(range), "bytes=%lu-", (unsigned long)dl.received);
+    opts.headers[0] = (net_http_header_t){"Range", range};
+    if (dl.etag[0] != '\0')
+    {
+      // Server sends the whole file (200) if it changed since
+      opts.headers[1] = (net_http_header_t){"If-Range", dl.etag};
+    }
+  }
+
+  net_http_req_t req;
+  esp_err_t ret = net_http_open(&req, &opts);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+
+  int status = req.status;
+  int64_t length = req.content_length;
+  if (status == 206 && dl.received > 0)
+  {
+    if (dl.range_total != dl.total)
+    {
+      ESP_LOGW(TAG, "Image size changed (%lu -> %lu), starting over",
+               (unsigned long)dl.total, (unsigned long)dl.range_total);
+      ret = ESP_ERR_INVALID_STATE;
+    }
+  }
+  else if (status == 200)
+  {
+    if (dl.received > 0)
+    {
+      ESP_LOGW(TAG, "Server sent the whole image, starting over");
+      restart_from_zero();
+    }
+    dl.total = length > 0 ? (uint32_t)length : 0;
+    dl.image_size = dl.total; // Replaced by the header of a packed image
+    strncpy(dl.etag, dl.resp_etag, sizeof(dl.etag) - 1);
+    if (dl.total == 0)
+    {
+      ESP_LOGE(TAG, "Server did not send the image size");
+      ret = ESP_ERR_INVALID_SIZE;
+    }
+    else if (dl.total > dl.slot->size)
+    {
+      ESP_LOGE(TAG, "Image (%lu bytes) does not fit '%s' (%lu bytes)",
+               (unsigned long)dl.total, dl.slot->label,
+               (unsigned long)dl.slot->size);
+      ret = ESP_ERR_INVALID_SIZE;
+    }
+  }
+  else if (status == 416)
+  {
+    ESP_LOGW(TAG, "Saved offset not valid on the server, starting over");
+    ret = ESP_ERR_INVALID_STATE;
+  }
+  else
+  {
+    ESP_LOGE(TAG, "HTTP status %d", status);
+    ret = status >= 500 ? ESP_FAIL : ESP_ERR_INVALID_RESPONSE;
+  }
+
+  while (ret == ESP_OK && dl.received < dl.total)
+  {
+    int read = esp_http_client_read(req.client, (char *)buf, buf_size);
+    if (read <= 0)
+    {
+      ret = read == 0 && esp_http_client_is_complete_data_received(req.client)
+                ? ESP_ERR_INVALID_SIZE
+                : ESP_FAIL;
+      break;
+    }
+    dl.stats.bytes_fetched += (uint32_t)read;
+    ret = decode(buf, (size_t)read);
+    if (ret != ESP_OK)
+    {
+      break;
+    }
+    dl.received += (uint32_t)read;
+
+    if (dl.received - dl.checkpoint >= CHECKPOINT_BYTES)
+    {
+      save_checkpoint();
+    }
+    if (dl.progress)
+    {
+      dl.progress(dl.received, dl.total);
+    }
+  }
+
+  net_http_close(&req);
+
+  // A packed image must end exactly with its last frame
+  if (ret == ESP_OK &&
+      (ota_stream_get_header(dl.stream) ? !ota_stream_done(dl.stream)
+                                        : dl.written != dl.total))
+  {
+    ESP_LOGE(TAG, "Image ended early (%lu of %lu bytes)",
+             (unsigned long)dl.written, (unsigned long)dl.image_size);
+    ret = ESP_ERR_INVALID_SIZE;
+  }
+
+  if (ret == ESP_ERR_INVALID_STATE)
+  {
+    restart_from_zero();
+  }
+  return ret;
+}
+
+/**
+ * @brief Compare the image on flash with the manifest's SHA-256
+ *
+ * Covers the decoded image, so a compressed or delta download is checked
+ * against the same digest as the plain .bin it stands for.
+ */
+static esp_err_t verify_sha256(const char *expected, uint8_t *buf,
+                               size_t buf_size)
+{
+  mbedtls_sha256_context ctx;
+  uint8_t digest[32];
+  esp_err_t ret = ESP_OK;
+
+  mbedtls_sha256_init(&ctx);
+  mbedtls_sha256_starts(&ctx, 0);
+  for (uint32_t offset = 0; offset < dl.image_size && ret == ESP_OK;)
+  {
+    uint32_t n = dl.image_size - offset;
+    n = n < buf_size ? n : (uint32_t)buf_size;
+    ret = esp_partition_read(dl.slot, offset, buf, n);
+    mbedtls_sha256_update(&ctx, buf, n);
+    offset += n;
+  }
+  mbedtls_sha256_finish(&ctx, digest);
+  mbedtls_sha256_free(&ctx);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+
+  char hex[sizeof(digest) * 2 + 1];
+  for (size_t i = 0; i < sizeof(digest); i++)
+  {
+    snprintf(hex + i * 2, 3, "%02x", digest[i]);
+  }
+  if (strcasecmp(hex, expected) != 0)
+  {
+    ESP_LOGE(TAG, "Image SHA-256 %.16s... does not match the manifest", hex);
+    return ESP_ERR_INVALID_CRC;
+  }
+  return ESP_OK;
+}
+
+/**
+ * @brief Whether an error is a dropped or refused connection
+ *
+ * Bad images, HTTP error statuses and flash errors fail straight away.
+ */
+static bool is_retryable(esp_err_t ret)
+{
+  return ret == ESP_FAIL || ret == ESP_ERR_TIMEOUT ||
+         (ret >= ESP_ERR_HTTP_BASE && ret < ESP_ERR_HTTP_BASE + 0x100);
+}
+
+static void wait_for_network(void)
+{
+#ifdef CONFIG_ENABLE_WIFI
+  if (!wifi_manager_is_connected())
+  {
+    ESP_LOGI(TAG, "Waiting for WiFi to resume the download");
+    if (wifi_manager_request_connection() == ESP_OK)
+    {
+      wifi_manager_wait_for_connection(WIFI_WAIT_MS);
+    }
+  }
+#endif
+}
+
+esp_err_t ota_download_image(const char *url, const char *sha256,
+                             ota_download_progress_cb_t progress,
+                             ota_download_stats_t *stats)
+{
+  if (!url || strlen(url) >= URL_MAX_LEN)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  memset(&dl, 0, sizeof(dl));
+  dl.slot = esp_ota_get_next_update_partition(NULL);
+  if (!dl.slot)
+  {
+    ESP_LOGE(TAG, "No OTA slot to write to (partition table has no ota_0/1)");
+    return ESP_ERR_NOT_FOUND;
+  }
+  dl.base = esp_ota_get_running_partition();
+  strncpy(dl.url, url, sizeof(dl.url) - 1);
+  dl.progress = progress;
+
+  // Fixed RAM for the whole download: HTTP buffer plus decoder state
+  uint8_t *buf = malloc(CONFIG_OTA_BUFFER_SIZE);
+  dl.stream = malloc(sizeof(ota_stream_t));
+  if (!buf || !dl.stream)
+  {
+    free(buf);
+    free(dl.stream);
+    return ESP_ERR_NO_MEM;
+  }
+  ota_stream_init(dl.stream, &stream_io);
+  int64_t start_us = esp_timer_get_time();
+
+#ifdef CONFIG_OTA_RESUME
+  load_checkpoint();
+#else
+  ota_download_forget();
+#endif
+
+  esp_err_t ret = ESP_OK;
+  int failures = 0;
+  int restarts = 0;
+
+  for (;;)
+  {
+    uint32_t before = dl.received;
+    ret = fetch_session(buf, CONFIG_OTA_BUFFER_SIZE);
+    if (ret == ESP_OK)
+    {
+      break;
+    }
+    if (ret == ESP_ERR_INVALID_STATE && ++restarts <= 1)
+    {
+      continue;
+    }
+    if (!is_retryable(ret))
+    {
+      break;
+    }
+
+    // A session that made progress earns a fresh set of retries
+    if (dl.received > before)
+    {
+      failures = 0;
+    }
+    if (failures >= RESUME_RETRIES)
+    {
+      break;
+    }
+
+    save_checkpoint();
+
+    uint32_t backoff = BACKOFF_BASE_MS << failures;
+    backoff = backoff < BACKOFF_MAX_MS ? backoff : BACKOFF_MAX_MS;
+    failures++;
+    ESP_LOGW(TAG, "Download dropped at %lu/%lu bytes (%s), retry %d in %lu ms",
+             (unsigned long)dl.received, (unsigned long)dl.total,
+             esp_err_to_name(ret), failures, (unsigned long)backoff);
+    vTaskDelay(pdMS_TO_TICKS(backoff));
+    wait_for_network();
+    dl.stats.reconnects++;
+  }
+
+  const ota_stream_header_t *hdr = ota_stream_get_header(dl.stream);
+  const char *format = !hdr                                 ? "plain"
+                       : (hdr->flags & OTA_STREAM_FLAG_DELTA) ? "delta"
+                                                              : "compressed";
+  free(dl.stream);
+  dl.stream = NULL;
+
+  if (ret == ESP_OK && sha256)
+  {
+    ret = verify_sha256(sha256, buf, CONFIG_OTA_BUFFER_SIZE);
+  }
+  free(buf);
+
+  if (ret == ESP_OK)
+  {
+    // Verifies the whole slot (hash, signature) before selecting it
+    ret = esp_ota_set_boot_partition(dl.slot);
+    if (ret != ESP_OK)
+    {
+      ESP_LOGE(TAG, "Image rejected: %s", esp_err_to_name(ret));
+    }
+  }
+  if (ret == ESP_OK || !is_retryable(ret))
+  {
+    ota_download_forget();
+  }
+
+  dl.stats.image_size = dl.image_size;
+  dl.stats.download_size = dl.total;
+  dl.stats.duration_ms = (uint32_t)((esp_timer_get_time() - start_us) / 1000);
+  ESP_LOGI(TAG,
+           "Fetched %lu bytes for a %lu byte image (%s, %lu ms, resumed at "
+           "%lu, %u reconnect(s))",
+           (unsigned long)dl.stats.bytes_fetched,
+           (unsigned long)dl.image_size, format,
+           (unsigned long)dl.stats.duration_ms,
+           (unsigned long)dl.stats.resumed_from, dl.stats.reconnects);
+  if (stats)
+  {
+    *stats = dl.stats;
+  }
+  return ret;
+}
+
+#endif // CONFIG_ENABLE_OTA
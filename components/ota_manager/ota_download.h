@@ -0,0 +1,63 @@
+/**
+ * @file ota_download.h
+ * @brief Resumable firmware download into the next OTA slot (internal)
+ *
+ * The image is fetched through net_http and written straight to the
+ * inactive app partition, erasing one sector ahead of the data. Every
+ * 64 KB the written offset is checkpointed in settings storage together
+ * with the URL, target slot, size and ETag. After a dropped connection (or
+ * a reboot) the download continues from the checkpoint with a Range
+ * request guarded by If-Range, so bytes already on flash are not fetched
+ * again unless the file on the server changed.
+ *
+ * The file may also be a compressed or delta container made by
+ * tools/ota_pack.py (see ota_stream.h); it is decoded on the way to flash
+ * and checkpoints then fall on its frame boundaries.
+ *
+ * The finished slot is verified as a whole (SHA-256, and signature with
+ * secure boot) by esp_ota_set_boot_partition(), so no hash state has to
+ * survive a resume.
+ */
+
+#ifndef OTA_DOWNLOAD_H
+#define OTA_DOWNLOAD_H
+
+#include "esp_err.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Called after each read with the file bytes done and the file size */
+typedef void (*ota_download_progress_cb_t)(uint32_t bytes_done,
+                                           uint32_t bytes_total);
+
+typedef struct {
+  uint32_t image_size;    ///< Image size on flash
+  uint32_t download_size; ///< File size, smaller for compressed and deltas
+  uint32_t resumed_from;  ///< Offset the download continued from, 0 if fresh
+  uint32_t bytes_fetched; ///< Body bytes received over HTTP in this call
+  uint32_t duration_ms;   ///< Fetch, decode and write time of this call
+  uint8_t reconnects;     ///< Sessions re-opened after a drop
+} ota_download_stats_t;
+
+/*
+ * Download url into the next OTA slot and select it for the next boot.
+ * Continues a previous interrupted download of the same url when possible.
+ * sha256 is the hex digest of the image from the release manifest, checked
+ * against the slot before it is selected; NULL skips the check. stats may
+ * be NULL.
+ */
+esp_err_t ota_download_image(const char *url, const char *sha256,
+                             ota_download_progress_cb_t progress,
+                             ota_download_stats_t *stats);
+
+/* Drop any saved resume point; the next download starts from byte 0 */
+void ota_download_forget(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OTA_DOWNLOAD_H
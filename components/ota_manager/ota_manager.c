@@ -4,16 +4,28 @@
  */
 
 #include "ota_manager.h"
+#include "ota_download.h"
+#include "ota_manifest.h"
+#include "ota_version.h"
 #include "esp_app_desc.h"
-#include "esp_http_client.h"
-#include "esp_https_ota.h"
+#include "esp_heap_caps.h"
 #include "esp_log.h"
 #include "esp_ota_ops.h"
+#include "esp_system.h"
+#include "esp_timer.h"
+#include "event_bus.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
+#include "nvs.h"
 #include "sdkconfig.h"
+#include "seqlock.h"
 #include "settings_storage.h"
 #include <string.h>
+#include <time.h>
+
+#ifdef CONFIG_ENABLE_WIFI
+#include "wifi_manager.h"
+#endif
 
 #ifdef CONFIG_ENABLE_OTA
 
@@ -21,6 +33,13 @@ static const char *TAG = "ota_manager";
 
 #define OTA_URL_KEY "ota_url"
 #define OTA_AUTO_CHECK_KEY "ota_auto"
+#define OTA_LAST_CHECK_KEY "ota_last"
+
+// Wall clock before this (2024-01-01) has not been set by NTP yet
+#define CLOCK_VALID_EPOCH 1704067200
+
+// Smallest free heap the self-test accepts on the first boot of an image
+#define SELF_TEST_MIN_FREE_HEAP (32 * 1024)
 
 typedef struct
 {
@@ -30,6 +49,9 @@ typedef struct
   void *user_data;
   char update_url[256];
   bool auto_check_enabled;
+  ota_version_info_t latest; // Result of the last successful check
+  bool latest_valid;
+  int64_t last_check_us; // esp_timer time of that check, 0 if none this boot
 } ota_manager_t;
 
 static ota_manager_t ota_mgr = {
@@ -38,26 +60,130 @@ static ota_manager_t ota_mgr = {
     .callback = NULL,
     .user_data = NULL,
     .update_url = {0},
-    .auto_check_enabled = false};
+    .auto_check_enabled = false,
+    .latest_valid = false,
+    .last_check_us = 0};
+
+// State/progress snapshot for lock-free readers
+static ota_status_t status_storage[2];
+static seqlock_t status_lock = SEQLOCK_INITIALIZER(status_storage);
+static portMUX_TYPE status_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// With the network scheduler the auto-check is one of its jobs instead
+#if defined(CONFIG_OTA_AUTO_CHECK) && !defined(CONFIG_NET_SCHEDULER_ENABLE)
+#define OTA_AUTO_CHECK_SELF
+#endif
+
+#ifdef OTA_AUTO_CHECK_SELF
+static esp_timer_handle_t auto_check_timer = NULL;
+static volatile bool auto_check_running = false;
+static void auto_check_timer_cb(void *arg);
+#endif
 
-// HTTP event handler for OTA progress
-static esp_err_t http_event_handler(esp_http_client_event_t *evt)
+static void ota_set_status_bytes(ota_state_t state, uint8_t progress,
+                                 uint32_t bytes_done, uint32_t bytes_total)
 {
-  switch (evt->event_id)
+  ota_status_t status = {
+      .state = state,
+      .progress = progress,
+      .bytes_done = bytes_done,
+      .bytes_total = bytes_total,
+  };
+
+  portENTER_CRITICAL(&status_mux);
+  ota_mgr.state = state;
+  ota_mgr.progress = progress;
+  seqlock_write(&status_lock, &status);
+  portEXIT_CRITICAL(&status_mux);
+}
+
+static void ota_set_status(ota_state_t state, uint8_t progress)
+{
+  ota_set_status_bytes(state, progress, 0, 0);
+}
+
+/**
+ * @brief Enter state unless a check or download is already running
+ *
+ * Test and set happen under one lock, so two tasks can never both start.
+ */
+static bool ota_try_begin(ota_state_t state)
+{
+  ota_status_t status = {.state = state};
+  bool busy;
+
+  portENTER_CRITICAL(&status_mux);
+  busy = ota_mgr.state == OTA_STATE_CHECKING ||
+         ota_mgr.state == OTA_STATE_DOWNLOADING;
+  if (!busy)
   {
-  case HTTP_EVENT_ON_DATA:
-    if (ota_mgr.callback && evt->data_len > 0)
-    {
-      // Calculate progress if we know total size
-      // This is a simplified version
-      ota_mgr.progress = (ota_mgr.progress + 1) % 100;
-      ota_mgr.callback(OTA_STATE_DOWNLOADING, ota_mgr.progress, ota_mgr.user_data);
-    }
-    break;
-  default:
-    break;
+    ota_mgr.state = state;
+    ota_mgr.progress = 0;
+    seqlock_write(&status_lock, &status);
+  }
+  portEXIT_CRITICAL(&status_mux);
+
+  return !busy;
+}
+
+static void ota_set_latest(const ota_manifest_t *manifest)
+{
+  ota_version_info_t latest = {0};
+  strncpy(latest.version, manifest->version, sizeof(latest.version) - 1);
+  strncpy(latest.url, manifest->url, sizeof(latest.url) - 1);
+  strncpy(latest.sha256, manifest->sha256, sizeof(latest.sha256) - 1);
+  latest.size = manifest->size;
+  latest.update_available =
+      ota_version_compare(manifest->version,
+                          esp_app_get_description()->version) > 0;
+
+  portENTER_CRITICAL(&status_mux);
+  ota_mgr.latest = latest;
+  ota_mgr.latest_valid = true;
+  portEXIT_CRITICAL(&status_mux);
+}
+
+static void ota_record_check(void)
+{
+  ota_mgr.last_check_us = esp_timer_get_time();
+  time_t now = time(NULL);
+  if (now >= CLOCK_VALID_EPOCH)
+  {
+    settings_set_uint(OTA_LAST_CHECK_KEY, (uint32_t)now);
+  }
+}
+
+static void ota_notify(ota_state_t state, uint8_t progress)
+{
+  const event_t event = {
+      .type = EVENT_OTA_PROGRESS,
+      .ota = {.state = (uint8_t)state, .percent = progress},
+  };
+  event_bus_publish(&event);
+
+  if (ota_mgr.callback)
+  {
+    ota_mgr.callback(state, progress, ota_mgr.user_data);
+  }
+}
+
+static void download_progress(uint32_t bytes_done, uint32_t bytes_total)
+{
+  uint8_t percent = 0;
+  if (bytes_total > 0)
+  {
+    percent = (uint8_t)(((uint64_t)bytes_done * 100) / bytes_total);
+  }
+
+  uint8_t last_percent = ota_mgr.progress;
+  ota_set_status_bytes(OTA_STATE_DOWNLOADING, percent, bytes_done,
+                       bytes_total);
+
+  // One callback per percent; the status snapshot has the exact bytes
+  if (percent != last_percent)
+  {
+    ota_notify(OTA_STATE_DOWNLOADING, percent);
   }
-  return ESP_OK;
 }
 
 esp_err_t ota_manager_init(void)
@@ -87,6 +213,29 @@ esp_err_t ota_manager_init(void)
     ota_mgr.auto_check_enabled = auto_check;
   }
 
+  // Last check result, so the UI knows about an update before going online
+  ota_manifest_t cached;
+  if (ota_manifest_get_cached(CONFIG_OTA_MANIFEST_URL, &cached) == ESP_OK)
+  {
+    ota_set_latest(&cached);
+  }
+
+#ifdef OTA_AUTO_CHECK_SELF
+  if (!auto_check_timer)
+  {
+    const esp_timer_create_args_t timer_args = {
+        .callback = auto_check_timer_cb,
+        .name = "ota_auto",
+    };
+    if (esp_timer_create(&timer_args, &auto_check_timer) == ESP_OK)
+    {
+      esp_timer_start_periodic(auto_check_timer,
+                               (uint64_t)CONFIG_OTA_CHECK_INTERVAL_HOURS *
+                                   3600 * 1000000);
+    }
+  }
+#endif
+
   ESP_LOGI(TAG, "OTA manager initialized. URL: %s", ota_mgr.update_url);
   return ESP_OK;
 }
@@ -104,90 +253,205 @@ esp_err_t ota_manager_get_current_version(char *version, size_t max_len)
 
 esp_err_t ota_manager_check_for_update(const char *url, ota_version_info_t *info)
 {
-  ESP_LOGI(TAG, "Checking for updates...");
-  ota_mgr.state = OTA_STATE_CHECKING;
+  if (!ota_try_begin(OTA_STATE_CHECKING))
+  {
+    ESP_LOGW(TAG, "OTA already in progress");
+    return ESP_ERR_INVALID_STATE;
+  }
+  ota_notify(OTA_STATE_CHECKING, 0);
 
-  // Simplified version check - in production, fetch version manifest
-  if (info)
+  const char *manifest_url = url ? url : CONFIG_OTA_MANIFEST_URL;
+  ESP_LOGI(TAG, "Checking for updates: %s", manifest_url);
+
+  ota_manifest_t manifest;
+  bool not_modified = false;
+  esp_err_t ret = ota_manifest_fetch(manifest_url, &manifest, &not_modified);
+  if (ret == ESP_OK)
   {
-    esp_app_desc_t *app_desc = (esp_app_desc_t *)esp_app_get_description();
-    strncpy(info->version, app_desc->version, sizeof(info->version) - 1);
-    strncpy(info->url, url ? url : ota_mgr.update_url, sizeof(info->url) - 1);
-    info->size = 0; // Would be fetched from server
+    ota_set_latest(&manifest);
+    ota_record_check();
+
+    ota_version_info_t latest;
+    ota_manager_get_latest(&latest);
+    ESP_LOGI(TAG, "Latest %s, running %s: %s%s", latest.version,
+             esp_app_get_description()->version,
+             latest.update_available ? "update available" : "up to date",
+             not_modified ? " (not modified)" : "");
+
+    const esp_partition_t *slot = esp_ota_get_next_update_partition(NULL);
+    if (latest.update_available && slot && latest.size > slot->size)
+    {
+      ESP_LOGW(TAG, "Image (%lu bytes) does not fit slot '%s' (%lu bytes)",
+               (unsigned long)latest.size, slot->label,
+               (unsigned long)slot->size);
+    }
+    if (info)
+    {
+      *info = latest;
+    }
+  }
+  else
+  {
+    ESP_LOGW(TAG, "Update check failed: %s", esp_err_to_name(ret));
   }
 
-  ota_mgr.state = OTA_STATE_IDLE;
-  return ESP_OK;
+  ota_set_status(OTA_STATE_IDLE, 0);
+  ota_notify(OTA_STATE_IDLE, 0);
+  return ret;
+}
+
+esp_err_t ota_manager_get_latest(ota_version_info_t *info)
+{
+  if (!info)
+    return ESP_ERR_INVALID_ARG;
+
+  bool valid;
+  portENTER_CRITICAL(&status_mux);
+  valid = ota_mgr.latest_valid;
+  if (valid)
+  {
+    *info = ota_mgr.latest;
+  }
+  portEXIT_CRITICAL(&status_mux);
+  return valid ? ESP_OK : ESP_ERR_NOT_FOUND;
 }
 
 esp_err_t ota_manager_start_update(const char *url)
 {
-  if (ota_mgr.state != OTA_STATE_IDLE)
+  // A failed attempt may be retried; only a running one blocks
+  if (!ota_try_begin(OTA_STATE_DOWNLOADING))
   {
     ESP_LOGW(TAG, "OTA already in progress");
     return ESP_ERR_INVALID_STATE;
   }
 
-  const char *update_url = url ? url : ota_mgr.update_url;
-  ESP_LOGI(TAG, "Starting OTA update from: %s", update_url);
-
-  ota_mgr.state = OTA_STATE_DOWNLOADING;
-  ota_mgr.progress = 0;
-
-  if (ota_mgr.callback)
+  const char *update_url = url;
+  const char *sha256 = NULL;
+  ota_version_info_t latest;
+  if (!update_url)
   {
-    ota_mgr.callback(OTA_STATE_DOWNLOADING, 0, ota_mgr.user_data);
+    if (ota_manager_get_latest(&latest) == ESP_OK && latest.update_available)
+    {
+      update_url = latest.url;
+      sha256 = latest.sha256[0] != '\0' ? latest.sha256 : NULL;
+    }
+    else
+    {
+      update_url = ota_mgr.update_url;
+    }
   }
+  ESP_LOGI(TAG, "Starting OTA update from: %s", update_url);
 
-  esp_http_client_config_t config = {
-      .url = update_url,
-      .event_handler = http_event_handler,
-      .keep_alive_enable = true,
-  };
-
-#ifdef CONFIG_OTA_ENABLE_HTTPS
-  config.cert_pem = NULL; // Add your certificate here for HTTPS
-  config.skip_cert_common_name_check = true;
-#endif
-
-  esp_https_ota_config_t ota_config = {
-      .http_config = &config,
-  };
+  ota_notify(OTA_STATE_DOWNLOADING, 0);
 
-  esp_err_t ret = esp_https_ota(&ota_config);
+  esp_err_t ret = ota_download_image(update_url, sha256, download_progress,
+                                     NULL);
 
   if (ret == ESP_OK)
   {
     ESP_LOGI(TAG, "OTA update successful! Restarting...");
-    ota_mgr.state = OTA_STATE_COMPLETE;
-    if (ota_mgr.callback)
-    {
-      ota_mgr.callback(OTA_STATE_COMPLETE, 100, ota_mgr.user_data);
-    }
+    ota_set_status(OTA_STATE_COMPLETE, 100);
+    ota_notify(OTA_STATE_COMPLETE, 100);
     vTaskDelay(pdMS_TO_TICKS(1000));
     esp_restart();
   }
   else
   {
     ESP_LOGE(TAG, "OTA update failed: %s", esp_err_to_name(ret));
-    ota_mgr.state = OTA_STATE_FAILED;
-    if (ota_mgr.callback)
-    {
-      ota_mgr.callback(OTA_STATE_FAILED, 0, ota_mgr.user_data);
-    }
+    ota_set_status(OTA_STATE_FAILED, 0);
+    ota_notify(OTA_STATE_FAILED, 0);
   }
 
   return ret;
 }
 
+#ifdef CONFIG_OTA_ENABLE_ROLLBACK
+/**
+ * @brief Checks a new image must pass before it replaces the old one
+ *
+ * Reaching this point already proves the display, UI and drivers came up.
+ * On top of that the image must be able to read its settings, have heap
+ * to spare, and be able to take the next update.
+ */
+static esp_err_t ota_self_test(void)
+{
+  char url[sizeof(ota_mgr.update_url)];
+  esp_err_t ret = settings_get_string(OTA_URL_KEY, CONFIG_OTA_UPDATE_URL, url,
+                                      sizeof(url));
+  if (ret != ESP_OK && ret != ESP_ERR_NVS_NOT_FOUND)
+  {
+    ESP_LOGE(TAG, "Self-test: settings unreadable (%s)", esp_err_to_name(ret));
+    return ret;
+  }
+
+  size_t free_heap = heap_caps_get_free_size(MALLOC_CAP_DEFAULT);
+  if (free_heap < SELF_TEST_MIN_FREE_HEAP)
+  {
+    ESP_LOGE(TAG, "Self-test: only %u bytes heap free", (unsigned)free_heap);
+    return ESP_ERR_NO_MEM;
+  }
+
+  if (!esp_ota_get_next_update_partition(NULL))
+  {
+    ESP_LOGE(TAG, "Self-test: no OTA slot for the next update");
+    return ESP_ERR_NOT_FOUND;
+  }
+
+  return ESP_OK;
+}
+#endif
+
+esp_err_t ota_manager_confirm_boot(void)
+{
+#ifdef CONFIG_OTA_ENABLE_ROLLBACK
+  const esp_partition_t *running = esp_ota_get_running_partition();
+  esp_ota_img_states_t img_state;
+  if (esp_ota_get_state_partition(running, &img_state) != ESP_OK ||
+      img_state != ESP_OTA_IMG_PENDING_VERIFY)
+  {
+    return ESP_OK;
+  }
+
+  ESP_LOGI(TAG, "First boot from '%s', running self-test", running->label);
+  esp_err_t ret = ota_self_test();
+  if (ret != ESP_OK)
+  {
+    ESP_LOGE(TAG, "Self-test failed, rolling back");
+    esp_ota_mark_app_invalid_rollback_and_reboot();
+    return ret; // Only reached if there is nothing to roll back to
+  }
+
+  ret = esp_ota_mark_app_valid_cancel_rollback();
+  if (ret == ESP_OK)
+  {
+    ESP_LOGI(TAG, "Self-test passed, firmware confirmed");
+  }
+  return ret;
+#else
+  return ESP_OK;
+#endif
+}
+
+void ota_manager_get_status(ota_status_t *status)
+{
+  if (status)
+  {
+    seqlock_read(&status_lock, status);
+  }
+}
+
 ota_state_t ota_manager_get_state(void)
 {
-  return ota_mgr.state;
+  ota_status_t status;
+  ota_manager_get_status(&status);
+  return status.state;
 }
 
 uint8_t ota_manager_get_progress(void)
 {
-  return ota_mgr.progress;
+  ota_status_t status;
+  ota_manager_get_status(&status);
+  return status.progress;
 }
 
 esp_err_t ota_manager_set_update_url(const char *url)
@@ -215,6 +479,97 @@ esp_err_t ota_manager_register_callback(ota_callback_t callback, void *user_data
   return ESP_OK;
 }
 
+uint32_t ota_manager_check_due_in_s(void)
+{
+#ifdef CONFIG_OTA_AUTO_CHECK
+  if (!ota_mgr.auto_check_enabled)
+  {
+    return UINT32_MAX;
+  }
+
+  const int64_t interval_s = (int64_t)CONFIG_OTA_CHECK_INTERVAL_HOURS * 3600;
+  int64_t elapsed_s;
+  time_t now = time(NULL);
+  uint32_t last = 0;
+
+  if (now >= CLOCK_VALID_EPOCH &&
+      settings_get_uint(OTA_LAST_CHECK_KEY, 0, &last) == ESP_OK && last != 0)
+  {
+    elapsed_s = (int64_t)now - (int64_t)last;
+  }
+  else if (ota_mgr.last_check_us != 0)
+  {
+    // No trusted wall clock: go by uptime
+    elapsed_s = (esp_timer_get_time() - ota_mgr.last_check_us) / 1000000;
+  }
+  else
+  {
+    return 0; // Not checked since boot
+  }
+
+  // A clock that went backwards makes the stored time meaningless
+  if (elapsed_s < 0 || elapsed_s >= interval_s)
+  {
+    return 0;
+  }
+  return (uint32_t)(interval_s - elapsed_s);
+#else
+  return UINT32_MAX;
+#endif
+}
+
+#ifdef OTA_AUTO_CHECK_SELF
+static void auto_check_task(void *arg)
+{
+  (void)arg;
+  ota_version_info_t info;
+  if (ota_manager_check_for_update(NULL, &info) == ESP_OK &&
+      info.update_available)
+  {
+    ESP_LOGW(TAG, "Firmware %s is available", info.version);
+  }
+  auto_check_running = false;
+  vTaskDelete(NULL);
+}
+
+/**
+ * @brief Start a background check if one is due and WiFi is already up
+ */
+static void auto_check_maybe_start(void)
+{
+  if (auto_check_running || ota_manager_check_due_in_s() != 0)
+  {
+    return;
+  }
+#ifdef CONFIG_ENABLE_WIFI
+  if (!wifi_manager_is_connected())
+  {
+    return; // Wait for the next session instead of starting one
+  }
+#endif
+
+  auto_check_running = true;
+  if (xTaskCreate(auto_check_task, "ota_check", 4096, NULL, 3, NULL) != pdPASS)
+  {
+    ESP_LOGE(TAG, "Failed to create auto-check task");
+    auto_check_running = false;
+  }
+}
+
+static void auto_check_timer_cb(void *arg)
+{
+  (void)arg;
+  auto_check_maybe_start();
+}
+#endif
+
+void ota_manager_on_wifi_connected(void)
+{
+#ifdef OTA_AUTO_CHECK_SELF
+  auto_check_maybe_start();
+#endif
+}
+
 #else
 
 esp_err_t ota_manager_init(void)
@@ -229,11 +584,19 @@ esp_err_t ota_manager_check_for_update(const char *url, ota_version_info_t *info
   {
     info->version[0] = '\0';
     info->url[0] = '\0';
+    info->sha256[0] = '\0';
     info->size = 0;
+    info->update_available = false;
   }
   return ESP_ERR_NOT_SUPPORTED;
 }
 
+esp_err_t ota_manager_get_latest(ota_version_info_t *info)
+{
+  (void)info;
+  return ESP_ERR_NOT_SUPPORTED;
+}
+
 esp_err_t ota_manager_start_update(const char *url)
 {
   (void)url;
@@ -250,6 +613,20 @@ uint8_t ota_manager_get_progress(void)
   return 0;
 }
 
+void ota_manager_get_status(ota_status_t *status)
+{
+  if (status)
+  {
+    memset(status, 0, sizeof(*status));
+    status->state = OTA_STATE_IDLE;
+  }
+}
+
+esp_err_t ota_manager_confirm_boot(void)
+{
+  return ESP_OK;
+}
+
 esp_err_t ota_manager_get_current_version(char *version, size_t max_len)
 {
   if (version && max_len > 0)
@@ -281,4 +658,13 @@ esp_err_t ota_manager_register_callback(ota_callback_t callback, void *user_data
   return ESP_ERR_NOT_SUPPORTED;
 }
 
+uint32_t ota_manager_check_due_in_s(void)
+{
+  return UINT32_MAX;
+}
+
+void ota_manager_on_wifi_connected(void)
+{
+}
+
 #endif
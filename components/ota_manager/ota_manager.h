@@ -23,22 +23,59 @@ typedef enum {
 } ota_state_t;
 
 typedef struct {
-  char version[32];
-  char url[256];
-  uint32_t size;
+  ota_state_t state;
+  uint8_t progress;     ///< Percent of bytes_total, 0 if the size is unknown
+  uint32_t bytes_done;  ///< Image bytes downloaded and written
+  uint32_t bytes_total; ///< Content-Length of the image, 0 if unknown
+} ota_status_t;
+
+typedef struct {
+  char version[32];      ///< Latest released version
+  char url[256];         ///< Image URL
+  char sha256[65];       ///< Image SHA-256 (hex), empty if unknown
+  uint32_t size;         ///< Image size in bytes
+  bool update_available; ///< version is newer than the running firmware
 } ota_version_info_t;
 
 typedef void (*ota_callback_t)(ota_state_t state, uint8_t progress, void *user_data);
 
 esp_err_t ota_manager_init(void);
+/*
+ * Fetches the release manifest (url NULL: CONFIG_OTA_MANIFEST_URL) with a
+ * conditional GET and compares its version with the running firmware.
+ * Blocks on the network; call from a task, not the UI thread.
+ */
 esp_err_t ota_manager_check_for_update(const char *url, ota_version_info_t *info);
+/* Result of the last check (kept across reboots); ESP_ERR_NOT_FOUND if none */
+esp_err_t ota_manager_get_latest(ota_version_info_t *info);
+/*
+ * Streams the image into the next OTA slot and restarts on success.
+ * url NULL: the image of the last check that found an update (verified
+ * against its SHA-256), otherwise the configured update URL.
+ */
 esp_err_t ota_manager_start_update(const char *url);
 ota_state_t ota_manager_get_state(void);
 uint8_t ota_manager_get_progress(void);
+/* State and progress from the same moment; lock-free, safe from any task */
+void ota_manager_get_status(ota_status_t *status);
 esp_err_t ota_manager_get_current_version(char *version, size_t max_len);
 esp_err_t ota_manager_set_update_url(const char *url);
 esp_err_t ota_manager_get_update_url(char *url, size_t max_len);
 esp_err_t ota_manager_register_callback(ota_callback_t callback, void *user_data);
+/*
+ * Call once the app is fully up. On the first boot of a new image this runs
+ * the self-test and keeps the image, or rolls back to the previous one.
+ */
+esp_err_t ota_manager_confirm_boot(void);
+/*
+ * Call when WiFi connects. With CONFIG_OTA_AUTO_CHECK a due check runs in
+ * the background on that connection; WiFi is never brought up for it.
+ * Does nothing with CONFIG_NET_SCHEDULER_ENABLE, which batches the check
+ * with other network jobs instead.
+ */
+void ota_manager_on_wifi_connected(void);
+/* Seconds until the next auto-check is due: 0 now, UINT32_MAX never */
+uint32_t ota_manager_check_due_in_s(void);
 
 #ifdef __cplusplus
 }
@@ -0,0 +1,252 @@
+/**
+ * @file ota_manifest.c
+ * @brief Release manifest fetch with ETag caching implementation
+ */
+
+#include "ota_manifest.h"
+#include "cJSON.h"
+#include "esp_log.h"
+#include "net_http.h"
+#include "ota_version.h"
+#include "sdkconfig.h"
+#include "settings_storage.h"
+#include <ctype.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#ifdef CONFIG_ENABLE_OTA
+
+static const char *TAG = "ota_manifest";
+
+#define CACHE_SOURCE_KEY "ota_m_src"
+#define CACHE_ETAG_KEY "ota_m_etag"
+#define CACHE_VERSION_KEY "ota_m_ver"
+#define CACHE_URL_KEY "ota_m_url"
+#define CACHE_SHA_KEY "ota_m_sha"
+#define CACHE_SIZE_KEY "ota_m_size"
+
+#define MANIFEST_MAX_LEN 1024
+#define ETAG_MAX_LEN 64
+#define SOURCE_MAX_LEN 256
+#define HTTP_TIMEOUT_MS 10000
+
+// ETag of the response being read; reset for every redirect hop
+static char resp_etag[ETAG_MAX_LEN];
+
+static void on_header(const char *key, const char *value, void *user_data)
+{
+  (void)user_data;
+  if (!key)
+  {
+    resp_etag[0] = '\0';
+  }
+  else if (strcasecmp(key, "ETag") == 0)
+  {
+    strncpy(resp_etag, value, sizeof(resp_etag) - 1);
+    resp_etag[sizeof(resp_etag) - 1] = '\0';
+  }
+}
+
+static bool is_sha256_hex(const char *s)
+{
+  for (int i = 0; i < 64; i++)
+  {
+    if (!isxdigit((unsigned char)s[i]))
+    {
+      return false;
+    }
+  }
+  return s[64] == '\0';
+}
+
+static bool copy_string(const cJSON *item, char *dst, size_t dst_size)
+{
+  if (!cJSON_IsString(item) || strlen(item->valuestring) >= dst_size)
+  {
+    return false;
+  }
+  strcpy(dst, item->valuestring);
+  return true;
+}
+
+static esp_err_t parse_manifest(const char *json, ota_manifest_t *manifest)
+{
+  cJSON *root = cJSON_Parse(json);
+  if (!root)
+  {
+    ESP_LOGE(TAG, "Manifest is not valid JSON");
+    return ESP_ERR_INVALID_RESPONSE;
+  }
+
+  ota_manifest_t m = {0};
+  const cJSON *size = cJSON_GetObjectItemCaseSensitive(root, "size");
+  bool ok =
+      copy_string(cJSON_GetObjectItemCaseSensitive(root, "version"),
+                  m.version, sizeof(m.version)) &&
+      copy_string(cJSON_GetObjectItemCaseSensitive(root, "url"), m.url,
+                  sizeof(m.url)) &&
+      copy_string(cJSON_GetObjectItemCaseSensitive(root, "sha256"), m.sha256,
+                  sizeof(m.sha256)) &&
+      cJSON_IsNumber(size) && size->valuedouble > 0 &&
+      size->valuedouble < (double)UINT32_MAX;
+  cJSON_Delete(root);
+
+  if (!ok || !is_sha256_hex(m.sha256) || !ota_version_valid(m.version))
+  {
+    ESP_LOGE(TAG, "Manifest lacks version, url, sha256 or size");
+    return ESP_ERR_INVALID_RESPONSE;
+  }
+
+  m.size = (uint32_t)size->valuedouble;
+  for (char *c = m.sha256; *c; c++)
+  {
+    *c = (char)tolower((unsigned char)*c);
+  }
+  *manifest = m;
+  return ESP_OK;
+}
+
+esp_err_t ota_manifest_get_cached(const char *url, ota_manifest_t *manifest)
+{
+  char source[SOURCE_MAX_LEN] = {0};
+  settings_get_string(CACHE_SOURCE_KEY, "", source, sizeof(source));
+  if (!url || strcmp(source, url) != 0)
+  {
+    return ESP_ERR_NOT_FOUND;
+  }
+
+  ota_manifest_t m = {0};
+  settings_get_string(CACHE_VERSION_KEY, "", m.version, sizeof(m.version));
+  settings_get_string(CACHE_URL_KEY, "", m.url, sizeof(m.url));
+  settings_get_string(CACHE_SHA_KEY, "", m.sha256, sizeof(m.sha256));
+  settings_get_uint(CACHE_SIZE_KEY, 0, &m.size);
+  if (m.version[0] == '\0' || m.url[0] == '\0' || m.size == 0)
+  {
+    return ESP_ERR_NOT_FOUND;
+  }
+
+  *manifest = m;
+  return ESP_OK;
+}
+
+static void save_cache(const char *url, const ota_manifest_t *manifest,
+                       const char *etag)
+{
+  // Drop the validator first, so a half-written cache is never revalidated
+  settings_erase(CACHE_ETAG_KEY);
+  settings_set_string(CACHE_SOURCE_KEY, url);
+  settings_set_string(CACHE_VERSION_KEY, manifest->version);
+  settings_set_string(CACHE_URL_KEY, manifest->url);
+  settings_set_string(CACHE_SHA_KEY, manifest->sha256);
+  settings_set_uint(CACHE_SIZE_KEY, manifest->size);
+  if (etag[0] != '\0')
+  {
+    settings_set_string(CACHE_ETAG_KEY, etag);
+  }
+}
+
+/**
+ * @brief Read the whole (small) body of the current response
+ */
+static esp_err_t read_body(esp_http_client_handle_t client, char *buf,
+                           size_t buf_size)
+{
+  size_t len = 0;
+  for (;;)
+  {
+    int read = esp_http_client_read(client, buf + len, buf_size - 1 - len);
+    if (read < 0)
+    {
+      return ESP_FAIL;
+    }
+    if (read == 0)
+    {
+      break;
+    }
+    len += (size_t)read;
+    if (len == buf_size - 1)
+    {
+      ESP_LOGE(TAG, "Manifest larger than %u bytes", (unsigned)buf_size - 1);
+      return ESP_ERR_INVALID_SIZE;
+    }
+  }
+  buf[len] = '\0';
+  return ESP_OK;
+}
+
+esp_err_t ota_manifest_fetch(const char *url, ota_manifest_t *manifest,
+                             bool *not_modified)
+{
+  if (!url || !manifest || strlen(url) >= SOURCE_MAX_LEN)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+  if (not_modified)
+  {
+    *not_modified = false;
+  }
+
+  ota_manifest_t cached;
+  char etag[ETAG_MAX_LEN] = {0};
+  bool have_cache = ota_manifest_get_cached(url, &cached) == ESP_OK;
+  if (have_cache)
+  {
+    settings_get_string(CACHE_ETAG_KEY, "", etag, sizeof(etag));
+  }
+
+  // GitHub "latest/download" links redirect to the release asset
+  net_http_opts_t opts = {
+      .url = url,
+      .timeout_ms = HTTP_TIMEOUT_MS,
+      .on_header = on_header,
+  };
+  if (etag[0] != '\0')
+  {
+    opts.headers[0] = (net_http_header_t){"If-None-Match", etag};
+  }
+
+  net_http_req_t req;
+  esp_err_t ret = net_http_open(&req, &opts);
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+  int status = req.status;
+  char *body = NULL;
+  if (status == 304 && have_cache)
+  {
+    ESP_LOGI(TAG, "Manifest not modified (%s)", cached.version);
+    *manifest = cached;
+    if (not_modified)
+    {
+      *not_modified = true;
+    }
+  }
+  else if (status == 200)
+  {
+    body = malloc(MANIFEST_MAX_LEN);
+    ret = body ? read_body(req.client, body, MANIFEST_MAX_LEN) : ESP_ERR_NO_MEM;
+    if (ret == ESP_OK)
+    {
+      ret = parse_manifest(body, manifest);
+    }
+    if (ret == ESP_OK)
+    {
+      save_cache(url, manifest, resp_etag);
+      ESP_LOGI(TAG, "Manifest: %s, %lu bytes", manifest->version,
+               (unsigned long)manifest->size);
+    }
+  }
+  else
+  {
+    ESP_LOGE(TAG, "Manifest request failed: HTTP %d", status);
+    ret = status == 404 ? ESP_ERR_NOT_FOUND : ESP_ERR_INVALID_RESPONSE;
+  }
+
+  free(body);
+  net_http_close(&req);
+  return ret;
+}
+
+#endif // CONFIG_ENABLE_OTA
@@ -0,0 +1,47 @@
+/**
+ * @file ota_manifest.h
+ * @brief Release manifest fetch with ETag caching (internal)
+ *
+ * The release workflow publishes ota_release.json next to the image:
+ *
+ *   {"version": "v1.4.0", "url": "https://.../esp_watch.bin",
+ *    "sha256": "<64 hex digits>", "size": 1503232}
+ *
+ * The last manifest and its ETag are kept in settings storage. A check
+ * sends If-None-Match, so an unchanged release costs one small request
+ * answered by 304 Not Modified with no body.
+ */
+
+#ifndef OTA_MANIFEST_H
+#define OTA_MANIFEST_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef struct {
+  char version[32];
+  char url[256];
+  char sha256[65]; ///< Lowercase hex
+  uint32_t size;
+} ota_manifest_t;
+
+/*
+ * Fetch the manifest at url. On a 304 the cached copy is returned and
+ * not_modified (may be NULL) is set.
+ */
+esp_err_t ota_manifest_fetch(const char *url, ota_manifest_t *manifest,
+                             bool *not_modified);
+
+/* Last manifest fetched from url, without network access */
+esp_err_t ota_manifest_get_cached(const char *url, ota_manifest_t *manifest);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OTA_MANIFEST_H
@@ -0,0 +1,548 @@
+/**
+ * @file ota_stream.c
+ * @brief Streaming decoder for compressed and delta OTA images
+ */
+
+#include "ota_stream.h"
+#include <string.h>
+
+#define MAGIC "WOTA"
+#define MAGIC_LEN 4
+
+enum
+{
+  PHASE_MAGIC,     // Deciding between a container and a plain image
+  PHASE_HEADER,    // Rest of the container header
+  PHASE_PLAIN,     // Plain image, passed through
+  PHASE_FRAME_LEN, // Payload length of the next frame
+  PHASE_FRAME,     // Frame payload
+  PHASE_DONE,      // Whole image produced
+};
+
+enum
+{
+  LZ_TAG,
+  LZ_LITERAL,
+  LZ_INDEX,
+  LZ_COUNT,
+};
+
+enum
+{
+  OP_COPY = 1,
+  OP_ADD = 2,
+  OP_INSERT = 3,
+};
+
+enum
+{
+  OPS_CODE,
+  OPS_SRC,
+  OPS_LEN,
+  OPS_DATA,
+};
+
+static uint32_t read_le32(const uint8_t *p)
+{
+  return (uint32_t)p[0] | ((uint32_t)p[1] << 8) | ((uint32_t)p[2] << 16) |
+         ((uint32_t)p[3] << 24);
+}
+
+static ota_stream_result_t flush_out(ota_stream_t *s)
+{
+  if (s->out_len == 0)
+  {
+    return OTA_STREAM_OK;
+  }
+  if (s->io.write(s->io.ctx, s->out, s->out_len) != 0)
+  {
+    return OTA_STREAM_IO_ERROR;
+  }
+  s->out_len = 0;
+  return OTA_STREAM_OK;
+}
+
+/**
+ * @brief Emit image bytes of the current frame
+ */
+static ota_stream_result_t emit(ota_stream_t *s, const uint8_t *data,
+                                size_t len)
+{
+  if (len > s->frame_out_left)
+  {
+    return OTA_STREAM_CORRUPT;
+  }
+  s->frame_out_left -= (uint32_t)len;
+  s->out_pos += (uint32_t)len;
+
+  while (len > 0)
+  {
+    size_t n = sizeof(s->out) - s->out_len;
+    n = n < len ? n : len;
+    memcpy(s->out + s->out_len, data, n);
+    s->out_len += (uint16_t)n;
+    data += n;
+    len -= n;
+    if (s->out_len == sizeof(s->out))
+    {
+      ota_stream_result_t ret = flush_out(s);
+      if (ret != OTA_STREAM_OK)
+      {
+        return ret;
+      }
+    }
+  }
+  return OTA_STREAM_OK;
+}
+
+/**
+ * @brief Emit the next ADD byte, reading the base image a block at a time
+ */
+static ota_stream_result_t emit_add(ota_stream_t *s, uint8_t diff)
+{
+  if (s->base_used == s->base_have)
+  {
+    uint32_t n = s->op_left < sizeof(s->base) ? s->op_left : sizeof(s->base);
+    if (s->io.read_base(s->io.ctx, s->op_src, s->base, n) != 0)
+    {
+      return OTA_STREAM_IO_ERROR;
+    }
+    s->op_src += n;
+    s->base_have = (uint16_t)n;
+    s->base_used = 0;
+  }
+  uint8_t c = (uint8_t)(s->base[s->base_used++] + diff);
+  return emit(s, &c, 1);
+}
+
+static ota_stream_result_t emit_copy(ota_stream_t *s)
+{
+  if (s->op_left > s->frame_out_left)
+  {
+    return OTA_STREAM_CORRUPT;
+  }
+  while (s->op_left > 0)
+  {
+    uint32_t n = s->op_left < sizeof(s->base) ? s->op_left : sizeof(s->base);
+    if (s->io.read_base(s->io.ctx, s->op_src, s->base, n) != 0)
+    {
+      return OTA_STREAM_IO_ERROR;
+    }
+    ota_stream_result_t ret = emit(s, s->base, n);
+    if (ret != OTA_STREAM_OK)
+    {
+      return ret;
+    }
+    s->op_src += n;
+    s->op_left -= n;
+  }
+  return OTA_STREAM_OK;
+}
+
+/**
+ * @brief Feed one byte of a delta op list
+ */
+static ota_stream_result_t op_byte(ota_stream_t *s, uint8_t c)
+{
+  switch (s->op_state)
+  {
+  case OPS_CODE:
+    if (c != OP_COPY && c != OP_ADD && c != OP_INSERT)
+    {
+      return OTA_STREAM_CORRUPT;
+    }
+    s->op = c;
+    s->op_state = c == OP_INSERT ? OPS_LEN : OPS_SRC;
+    s->varint = 0;
+    s->varint_shift = 0;
+    return OTA_STREAM_OK;
+
+  case OPS_SRC:
+  case OPS_LEN:
+    if (s->varint_shift > 28)
+    {
+      return OTA_STREAM_CORRUPT;
+    }
+    s->varint |= (uint32_t)(c & 0x7F) << s->varint_shift;
+    s->varint_shift += 7;
+    if (c & 0x80)
+    {
+      return OTA_STREAM_OK;
+    }
+
+    if (s->op_state == OPS_SRC)
+    {
+      s->op_src = s->varint;
+      s->op_state = OPS_LEN;
+      s->varint = 0;
+      s->varint_shift = 0;
+      return OTA_STREAM_OK;
+    }
+
+    s->op_left = s->varint;
+    if (s->op_left == 0 || s->op_left > s->frame_out_left)
+    {
+      return OTA_STREAM_CORRUPT;
+    }
+    if (s->op == OP_COPY)
+    {
+      s->op_state = OPS_CODE;
+      return emit_copy(s);
+    }
+    s->base_have = 0;
+    s->base_used = 0;
+    s->op_state = OPS_DATA;
+    return OTA_STREAM_OK;
+
+  case OPS_DATA:
+  default:
+  {
+    ota_stream_result_t ret =
+        s->op == OP_ADD ? emit_add(s, c) : emit(s, &c, 1);
+    if (--s->op_left == 0)
+    {
+      s->op_state = OPS_CODE;
+    }
+    return ret;
+  }
+  }
+}
+
+/**
+ * @brief Route one decompressed frame byte to the op decoder or the image
+ */
+static ota_stream_result_t body_byte(ota_stream_t *s, uint8_t c)
+{
+  if (s->hdr.flags & OTA_STREAM_FLAG_DELTA)
+  {
+    return op_byte(s, c);
+  }
+  return emit(s, &c, 1);
+}
+
+static uint32_t lz_take(ota_stream_t *s, uint8_t count)
+{
+  s->lz_nbits -= count;
+  return (s->lz_bits >> s->lz_nbits) & ((1U << count) - 1);
+}
+
+/**
+ * @brief Feed one payload byte to the LZSS decoder
+ *
+ * heatshrink bit stream, MSB first: tag 1 + 8 bit literal, or tag 0 +
+ * window_bits of (distance - 1) + lookahead_bits of (length - 1). The
+ * window starts zeroed and padding at the end of a frame is ignored.
+ */
+static ota_stream_result_t lz_byte(ota_stream_t *s, uint8_t c)
+{
+  const uint16_t mask = (uint16_t)((1U << s->hdr.window_bits) - 1);
+
+  s->lz_bits = (s->lz_bits << 8) | c;
+  s->lz_nbits += 8;
+
+  for (;;)
+  {
+    switch (s->lz_state)
+    {
+    case LZ_TAG:
+      if (s->lz_nbits < 1)
+      {
+        return OTA_STREAM_OK;
+      }
+      s->lz_state = lz_take(s, 1) ? LZ_LITERAL : LZ_INDEX;
+      break;
+
+    case LZ_LITERAL:
+    {
+      if (s->lz_nbits < 8)
+      {
+        return OTA_STREAM_OK;
+      }
+      uint8_t lit = (uint8_t)lz_take(s, 8);
+      s->window[s->lz_head++ & mask] = lit;
+      s->lz_state = LZ_TAG;
+      ota_stream_result_t ret = body_byte(s, lit);
+      if (ret != OTA_STREAM_OK)
+      {
+        return ret;
+      }
+      break;
+    }
+
+    case LZ_INDEX:
+      if (s->lz_nbits < s->hdr.window_bits)
+      {
+        return OTA_STREAM_OK;
+      }
+      s->lz_index = (uint16_t)(lz_take(s, s->hdr.window_bits) + 1);
+      s->lz_state = LZ_COUNT;
+      break;
+
+    case LZ_COUNT:
+    default:
+    {
+      if (s->lz_nbits < s->hdr.lookahead_bits)
+      {
+        return OTA_STREAM_OK;
+      }
+      uint32_t count = lz_take(s, s->hdr.lookahead_bits) + 1;
+      s->lz_state = LZ_TAG;
+      for (uint32_t i = 0; i < count; i++)
+      {
+        uint8_t b = s->window[(uint16_t)(s->lz_head - s->lz_index) & mask];
+        s->window[s->lz_head++ & mask] = b;
+        ota_stream_result_t ret = body_byte(s, b);
+        if (ret != OTA_STREAM_OK)
+        {
+          return ret;
+        }
+      }
+      break;
+    }
+    }
+  }
+}
+
+static void start_frame(ota_stream_t *s, uint32_t payload_len)
+{
+  uint32_t left = s->hdr.image_size - s->out_pos;
+  s->frame_left = payload_len;
+  s->frame_out_left = left < s->hdr.frame_size ? left : s->hdr.frame_size;
+
+  s->lz_state = LZ_TAG;
+  s->lz_nbits = 0;
+  s->lz_bits = 0;
+  s->lz_head = 0;
+  memset(s->window, 0, sizeof(s->window));
+
+  s->op_state = OPS_CODE;
+}
+
+static ota_stream_result_t end_frame(ota_stream_t *s)
+{
+  if (s->frame_out_left != 0 || s->op_state != OPS_CODE)
+  {
+    return OTA_STREAM_CORRUPT;
+  }
+  ota_stream_result_t ret = flush_out(s);
+  if (ret != OTA_STREAM_OK)
+  {
+    return ret;
+  }
+
+  s->boundary_in = s->in_pos;
+  s->boundary_out = s->out_pos;
+  s->len_have = 0;
+  s->phase = s->out_pos == s->hdr.image_size ? PHASE_DONE : PHASE_FRAME_LEN;
+  return OTA_STREAM_OK;
+}
+
+static ota_stream_result_t check_header(const ota_stream_header_t *hdr)
+{
+  const uint8_t known = OTA_STREAM_FLAG_LZSS | OTA_STREAM_FLAG_DELTA;
+
+  if (hdr->flags == 0 || (hdr->flags & ~known) != 0 || hdr->image_size == 0 ||
+      hdr->frame_size == 0 || hdr->frame_size % OTA_STREAM_FRAME_ALIGN != 0)
+  {
+    return OTA_STREAM_BAD_HEADER;
+  }
+  if ((hdr->flags & OTA_STREAM_FLAG_LZSS) &&
+      (hdr->window_bits < 4 ||
+       hdr->window_bits > OTA_STREAM_WINDOW_BITS_MAX ||
+       hdr->lookahead_bits < 3 || hdr->lookahead_bits >= hdr->window_bits))
+  {
+    return OTA_STREAM_BAD_HEADER;
+  }
+  return OTA_STREAM_OK;
+}
+
+static ota_stream_result_t parse_header(ota_stream_t *s)
+{
+  const uint8_t *p = s->hdr_buf;
+
+  if (p[4] != OTA_STREAM_VERSION)
+  {
+    return OTA_STREAM_BAD_HEADER;
+  }
+  s->hdr.flags = p[5];
+  s->hdr.window_bits = p[6];
+  s->hdr.lookahead_bits = p[7];
+  s->hdr.image_size = read_le32(p + 8);
+  s->hdr.frame_size = read_le32(p + 12);
+  memcpy(s->hdr.base_sha256, p + 16, sizeof(s->hdr.base_sha256));
+
+  ota_stream_result_t ret = check_header(&s->hdr);
+  if (ret != OTA_STREAM_OK)
+  {
+    return ret;
+  }
+  if (s->io.header && s->io.header(s->io.ctx, &s->hdr) != 0)
+  {
+    return OTA_STREAM_IO_ERROR;
+  }
+
+  s->boundary_in = OTA_STREAM_HEADER_SIZE;
+  s->boundary_out = 0;
+  s->len_have = 0;
+  s->phase = PHASE_FRAME_LEN;
+  return OTA_STREAM_OK;
+}
+
+void ota_stream_init(ota_stream_t *s, const ota_stream_io_t *io)
+{
+  memset(s, 0, sizeof(*s));
+  s->io = *io;
+  s->phase = PHASE_MAGIC;
+}
+
+ota_stream_result_t ota_stream_resume(ota_stream_t *s,
+                                      const ota_stream_io_t *io,
+                                      const ota_stream_header_t *hdr,
+                                      uint32_t in_pos, uint32_t out_pos)
+{
+  ota_stream_init(s, io);
+  s->in_pos = s->boundary_in = in_pos;
+  s->out_pos = s->boundary_out = out_pos;
+
+  if (!hdr)
+  {
+    s->phase = PHASE_PLAIN;
+    return in_pos == out_pos ? OTA_STREAM_OK : OTA_STREAM_BAD_HEADER;
+  }
+
+  s->hdr = *hdr;
+  ota_stream_result_t ret = check_header(&s->hdr);
+  if (ret != OTA_STREAM_OK)
+  {
+    return ret;
+  }
+  if (out_pos > hdr->image_size ||
+      (out_pos % hdr->frame_size != 0 && out_pos != hdr->image_size))
+  {
+    return OTA_STREAM_BAD_HEADER;
+  }
+  s->phase = out_pos == hdr->image_size ? PHASE_DONE : PHASE_FRAME_LEN;
+  return OTA_STREAM_OK;
+}
+
+ota_stream_result_t ota_stream_push(ota_stream_t *s, const uint8_t *data,
+                                    size_t len)
+{
+  ota_stream_result_t ret = OTA_STREAM_OK;
+
+  while (len > 0 && ret == OTA_STREAM_OK)
+  {
+    switch (s->phase)
+    {
+    case PHASE_MAGIC:
+      s->hdr_buf[s->hdr_len++] = *data++;
+      len--;
+      s->in_pos++;
+      if (memcmp(s->hdr_buf, MAGIC, s->hdr_len) != 0)
+      {
+        // Not a container: hand over what was held back
+        s->phase = PHASE_PLAIN;
+        s->out_pos += s->hdr_len;
+        if (s->io.write(s->io.ctx, s->hdr_buf, s->hdr_len) != 0)
+        {
+          ret = OTA_STREAM_IO_ERROR;
+        }
+      }
+      else if (s->hdr_len == MAGIC_LEN)
+      {
+        s->phase = PHASE_HEADER;
+      }
+      break;
+
+    case PHASE_HEADER:
+    {
+      size_t n = OTA_STREAM_HEADER_SIZE - s->hdr_len;
+      n = n < len ? n : len;
+      memcpy(s->hdr_buf + s->hdr_len, data, n);
+      s->hdr_len += (uint8_t)n;
+      s->in_pos += (uint32_t)n;
+      data += n;
+      len -= n;
+      if (s->hdr_len == OTA_STREAM_HEADER_SIZE)
+      {
+        ret = parse_header(s);
+      }
+      break;
+    }
+
+    case PHASE_PLAIN:
+      if (s->io.write(s->io.ctx, data, len) != 0)
+      {
+        return OTA_STREAM_IO_ERROR;
+      }
+      s->in_pos += (uint32_t)len;
+      s->out_pos += (uint32_t)len;
+      return OTA_STREAM_OK;
+
+    case PHASE_FRAME_LEN:
+      s->len_buf[s->len_have++] = *data++;
+      len--;
+      s->in_pos++;
+      if (s->len_have == sizeof(s->len_buf))
+      {
+        uint32_t payload_len = read_le32(s->len_buf);
+        if (payload_len == 0)
+        {
+          return OTA_STREAM_CORRUPT;
+        }
+        start_frame(s, payload_len);
+        s->phase = PHASE_FRAME;
+      }
+      break;
+
+    case PHASE_FRAME:
+    {
+      uint8_t c = *data++;
+      len--;
+      s->in_pos++;
+      ret = (s->hdr.flags & OTA_STREAM_FLAG_LZSS) ? lz_byte(s, c)
+                                                  : body_byte(s, c);
+      if (ret == OTA_STREAM_OK && --s->frame_left == 0)
+      {
+        ret = end_frame(s);
+      }
+      break;
+    }
+
+    case PHASE_DONE:
+    default:
+      // Trailing bytes after the last frame
+      return OTA_STREAM_CORRUPT;
+    }
+  }
+  return ret;
+}
+
+const ota_stream_header_t *ota_stream_get_header(const ota_stream_t *s)
+{
+  if (s->phase == PHASE_MAGIC || s->phase == PHASE_HEADER ||
+      s->phase == PHASE_PLAIN)
+  {
+    return NULL;
+  }
+  return &s->hdr;
+}
+
+void ota_stream_resume_point(const ota_stream_t *s, uint32_t *in_pos,
+                             uint32_t *out_pos)
+{
+  if (s->phase == PHASE_PLAIN)
+  {
+    uint32_t offset = s->out_pos & ~(uint32_t)(OTA_STREAM_FRAME_ALIGN - 1);
+    *in_pos = offset;
+    *out_pos = offset;
+    return;
+  }
+  *in_pos = s->boundary_in;
+  *out_pos = s->boundary_out;
+}
+
+bool ota_stream_done(const ota_stream_t *s)
+{
+  return s->phase == PHASE_DONE;
+}
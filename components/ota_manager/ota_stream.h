@@ -0,0 +1,154 @@
+/**
+ * @file ota_stream.h
+ * @brief Streaming decoder for compressed and delta OTA images (internal)
+ *
+ * Sits between the HTTP reader and the flash writer. Bytes are pushed in as
+ * they arrive and decoded image bytes come out through a write callback, so
+ * RAM use is fixed (about 4.7 KB) whatever the image size.
+ *
+ * A plain .bin is passed through unchanged. A container produced by
+ * tools/ota_pack.py starts with a header and is split into frames that
+ * each decode to frame_size image bytes (the last one may be shorter):
+ *
+ *   header  OTA_STREAM_HEADER_SIZE bytes, see ota_stream_header_t
+ *   frame   u32 LE payload length, then the payload
+ *
+ * A payload is heatshrink (LZSS) compressed when OTA_STREAM_FLAG_LZSS is
+ * set. With OTA_STREAM_FLAG_DELTA the decompressed frame is a list of ops
+ * against the running image rather than image bytes (varints are LEB128):
+ *
+ *   0x01 COPY    src, len          image bytes = base[src..src+len)
+ *   0x02 ADD     src, len, diff[]  image bytes = base[src+i] + diff[i]
+ *   0x03 INSERT  len, data[]       image bytes = data
+ *
+ * Frames share no decoder state, so a download can resume at any frame
+ * boundary with nothing but the two offsets and the header fields.
+ *
+ * Kept free of ESP-IDF so it can be run on the host against real images.
+ */
+
+#ifndef OTA_STREAM_H
+#define OTA_STREAM_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define OTA_STREAM_HEADER_SIZE 48
+#define OTA_STREAM_VERSION 1
+
+#define OTA_STREAM_FLAG_LZSS 0x01
+#define OTA_STREAM_FLAG_DELTA 0x02
+
+/* Largest LZSS window accepted; sets the decoder's RAM use */
+#define OTA_STREAM_WINDOW_BITS_MAX 12
+
+/* Frames end on flash sector boundaries so resume points erase cleanly */
+#define OTA_STREAM_FRAME_ALIGN 4096
+
+typedef struct {
+  uint8_t flags;           ///< OTA_STREAM_FLAG_*
+  uint8_t window_bits;     ///< LZSS window is 2^window_bits bytes
+  uint8_t lookahead_bits;  ///< Longest LZSS match is 2^lookahead_bits bytes
+  uint32_t image_size;     ///< Decoded image size
+  uint32_t frame_size;     ///< Image bytes per frame
+  uint8_t base_sha256[32]; ///< app_elf_sha256 of the delta base image
+} ota_stream_header_t;
+
+typedef enum {
+  OTA_STREAM_OK = 0,
+  OTA_STREAM_BAD_HEADER, ///< Unknown version, flags or codec parameters
+  OTA_STREAM_CORRUPT,    ///< Frame or op list does not decode to the image
+  OTA_STREAM_IO_ERROR,   ///< A callback returned non-zero
+} ota_stream_result_t;
+
+/* Callbacks return 0 on success; anything else aborts the stream */
+typedef struct {
+  /* Decoded image bytes, in order */
+  int (*write)(void *ctx, const uint8_t *data, size_t len);
+  /* Bytes of the running image, needed by delta containers only */
+  int (*read_base)(void *ctx, uint32_t offset, uint8_t *buf, size_t len);
+  /* Called once a container header is parsed, may be NULL */
+  int (*header)(void *ctx, const ota_stream_header_t *hdr);
+  void *ctx;
+} ota_stream_io_t;
+
+typedef struct {
+  ota_stream_io_t io;
+  ota_stream_header_t hdr;
+  uint8_t phase;
+  uint8_t hdr_buf[OTA_STREAM_HEADER_SIZE];
+  uint8_t hdr_len;
+
+  uint32_t in_pos;       ///< Stream bytes consumed
+  uint32_t out_pos;      ///< Image bytes produced
+  uint32_t boundary_in;  ///< in_pos at the last frame boundary
+  uint32_t boundary_out; ///< out_pos at the last frame boundary
+
+  // Current frame
+  uint8_t len_buf[4];
+  uint8_t len_have;
+  uint32_t frame_left;     ///< Payload bytes still to come
+  uint32_t frame_out_left; ///< Image bytes the frame still has to produce
+
+  // LZSS decoder
+  uint8_t lz_state;
+  uint8_t lz_nbits;
+  uint32_t lz_bits;
+  uint16_t lz_index;
+  uint16_t lz_head;
+  uint8_t window[1 << OTA_STREAM_WINDOW_BITS_MAX];
+
+  // Delta op decoder
+  uint8_t op;
+  uint8_t op_state;
+  uint8_t varint_shift;
+  uint32_t varint;
+  uint32_t op_src;
+  uint32_t op_left;
+  uint16_t base_have;
+  uint16_t base_used;
+  uint8_t base[256];
+
+  uint16_t out_len;
+  uint8_t out[256];
+} ota_stream_t;
+
+/* Start decoding a download from its first byte */
+void ota_stream_init(ota_stream_t *s, const ota_stream_io_t *io);
+
+/*
+ * Continue a download at a point returned by ota_stream_resume_point().
+ * hdr is the container header seen before, or NULL for a plain image.
+ */
+ota_stream_result_t ota_stream_resume(ota_stream_t *s,
+                                      const ota_stream_io_t *io,
+                                      const ota_stream_header_t *hdr,
+                                      uint32_t in_pos, uint32_t out_pos);
+
+/* Decode len more stream bytes */
+ota_stream_result_t ota_stream_push(ota_stream_t *s, const uint8_t *data,
+                                    size_t len);
+
+/* Container header, or NULL for a plain image or before it is parsed */
+const ota_stream_header_t *ota_stream_get_header(const ota_stream_t *s);
+
+/*
+ * Latest offsets the stream can be restarted from: the last frame boundary
+ * of a container, the last sector boundary of a plain image.
+ */
+void ota_stream_resume_point(const ota_stream_t *s, uint32_t *in_pos,
+                             uint32_t *out_pos);
+
+/* Whether a container has produced its whole image (false for plain) */
+bool ota_stream_done(const ota_stream_t *s);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OTA_STREAM_H
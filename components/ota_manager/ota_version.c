@@ -0,0 +1,199 @@
+/**
+ * @file ota_version.c
+ * @brief Firmware version comparison implementation
+ */
+
+#include "ota_version.h"
+#include <ctype.h>
+#include <stdint.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define PRERELEASE_MAX 32
+
+typedef struct
+{
+  uint32_t core[3];                // major, minor, patch
+  char prerelease[PRERELEASE_MAX]; // Empty for a release
+  uint32_t ahead;                  // Commits past the tag (git describe)
+} version_t;
+
+static bool parse_number(const char **p, uint32_t *value)
+{
+  if (!isdigit((unsigned char)**p))
+  {
+    return false;
+  }
+  char *end;
+  unsigned long n = strtoul(*p, &end, 10);
+  *value = (uint32_t)n;
+  *p = end;
+  return true;
+}
+
+/**
+ * @brief Match "-<commits>-g<hash>" as appended by git describe
+ */
+static bool parse_describe(const char *p, uint32_t *ahead)
+{
+  if (*p++ != '-' || !parse_number(&p, ahead) || *p++ != '-' || *p++ != 'g' ||
+      !isxdigit((unsigned char)*p))
+  {
+    return false;
+  }
+  while (isxdigit((unsigned char)*p))
+  {
+    p++;
+  }
+  return *p == '\0' || *p == '-' || *p == '+';
+}
+
+static bool parse(const char *s, version_t *v)
+{
+  memset(v, 0, sizeof(*v));
+  if (!s)
+  {
+    return false;
+  }
+
+  const char *p = s;
+  if (*p == 'v' || *p == 'V')
+  {
+    p++;
+  }
+  if (!parse_number(&p, &v->core[0]))
+  {
+    return false;
+  }
+  for (int i = 1; i < 3 && *p == '.'; i++)
+  {
+    p++;
+    if (!parse_number(&p, &v->core[i]))
+    {
+      return false;
+    }
+  }
+
+  if (*p == '\0' || *p == '+')
+  {
+    return true;
+  }
+  if (*p != '-')
+  {
+    return false;
+  }
+  if (strcmp(p, "-dirty") == 0 || parse_describe(p, &v->ahead))
+  {
+    return true;
+  }
+
+  p++;
+  size_t len = strcspn(p, "+");
+  if (len >= sizeof(v->prerelease))
+  {
+    len = sizeof(v->prerelease) - 1;
+  }
+  memcpy(v->prerelease, p, len);
+  v->prerelease[len] = '\0';
+
+  // "-rc.1-dirty" is still rc.1
+  char *dirty = strstr(v->prerelease, "-dirty");
+  if (dirty && dirty[6] == '\0')
+  {
+    *dirty = '\0';
+  }
+  return v->prerelease[0] != '\0';
+}
+
+static bool is_numeric(const char *id, size_t len)
+{
+  for (size_t i = 0; i < len; i++)
+  {
+    if (!isdigit((unsigned char)id[i]))
+    {
+      return false;
+    }
+  }
+  return len > 0;
+}
+
+/**
+ * @brief Semver 2.0 pre-release precedence (both non-empty)
+ */
+static int compare_prerelease(const char *a, const char *b)
+{
+  while (*a && *b)
+  {
+    size_t la = strcspn(a, ".");
+    size_t lb = strcspn(b, ".");
+    bool na = is_numeric(a, la);
+    bool nb = is_numeric(b, lb);
+    int cmp;
+
+    if (na && nb)
+    {
+      unsigned long va = strtoul(a, NULL, 10);
+      unsigned long vb = strtoul(b, NULL, 10);
+      cmp = (va > vb) - (va < vb);
+    }
+    else if (na != nb)
+    {
+      cmp = na ? -1 : 1; // Numeric identifiers sort first
+    }
+    else
+    {
+      cmp = strncmp(a, b, la < lb ? la : lb);
+      if (cmp == 0)
+      {
+        cmp = (la > lb) - (la < lb);
+      }
+    }
+    if (cmp != 0)
+    {
+      return cmp;
+    }
+
+    a += la;
+    b += lb;
+    a += (*a == '.');
+    b += (*b == '.');
+  }
+  return (*a != '\0') - (*b != '\0');
+}
+
+bool ota_version_valid(const char *version)
+{
+  version_t v;
+  return parse(version, &v);
+}
+
+int ota_version_compare(const char *a, const char *b)
+{
+  version_t va;
+  version_t vb;
+  if (!parse(a, &va) || !parse(b, &vb))
+  {
+    return 0;
+  }
+
+  for (int i = 0; i < 3; i++)
+  {
+    if (va.core[i] != vb.core[i])
+    {
+      return va.core[i] > vb.core[i] ? 1 : -1;
+    }
+  }
+
+  bool pa = va.prerelease[0] != '\0';
+  bool pb = vb.prerelease[0] != '\0';
+  if (pa || pb)
+  {
+    if (pa && pb)
+    {
+      return compare_prerelease(va.prerelease, vb.prerelease);
+    }
+    return pa ? -1 : 1; // A pre-release sorts before its release
+  }
+
+  return (va.ahead > vb.ahead) - (va.ahead < vb.ahead);
+}
@@ -0,0 +1,37 @@
+/**
+ * @file ota_version.h
+ * @brief Firmware version comparison (internal, pure)
+ *
+ * Versions are semver with an optional leading 'v', as written by the
+ * release workflow (tag "v1.4.0") and by ESP-IDF from `git describe`
+ * ("v1.4.0-3-g1a2b3c4-dirty"). Ordering, lowest first:
+ *
+ *   1.4.0-rc.1  <  1.4.0  <  1.4.0-3-g1a2b3c4 (3 commits past the tag)
+ *
+ * Pre-release identifiers compare as in semver 2.0; build metadata after
+ * '+' and a trailing "-dirty" are ignored.
+ */
+
+#ifndef OTA_VERSION_H
+#define OTA_VERSION_H
+
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Whether a version string can be compared at all */
+bool ota_version_valid(const char *version);
+
+/*
+ * Compare two versions like strcmp: negative if a is older than b, 0 if
+ * equal, positive if newer. Invalid versions compare equal to anything.
+ */
+int ota_version_compare(const char *a, const char *b);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // OTA_VERSION_H
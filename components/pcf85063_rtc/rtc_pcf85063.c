@@ -9,10 +9,18 @@
 #include "freertos/FreeRTOS.h"
 #include <string.h>
 
+#ifdef CONFIG_RTC_TICK_INTERRUPT
+#include "driver/gpio.h"
+#include "esp_attr.h"
+#endif
+
 static const char *TAG = "RTC";
 
 // PCF85063 I2C Address and Registers
 #define PCF85063_I2C_ADDR 0x51
+#define PCF85063_REG_CTRL1 0x00
+#define PCF85063_REG_CTRL2 0x01
+#define PCF85063_REG_OFFSET 0x02
 #define PCF85063_REG_SEC 0x04
 #define PCF85063_REG_MIN 0x05
 #define PCF85063_REG_HOUR 0x06
@@ -20,9 +28,44 @@ static const char *TAG = "RTC";
 #define PCF85063_REG_WKDAY 0x08
 #define PCF85063_REG_MONTH 0x09
 #define PCF85063_REG_YEAR 0x0A
+#define PCF85063_REG_TIMER_VALUE 0x10
+#define PCF85063_REG_TIMER_MODE 0x11
+
+// Control_1 bits
+#define PCF85063_CTRL1_STOP 0x20 // Hold the prescaler, time does not count
+
+// Control_2 bits
+#define PCF85063_CTRL2_MI 0x20      // Minute interrupt enable
+#define PCF85063_CTRL2_COF_OFF 0x07 // CLKOUT disabled
+
+// Timer_mode bits
+#define PCF85063_TIMER_CLK_1HZ 0x10 // TCF = 10
+#define PCF85063_TIMER_TE 0x04      // Timer enable
+#define PCF85063_TIMER_TIE 0x02     // Timer interrupt enable
+#define PCF85063_TIMER_TI_TP 0x01   // INT pulses instead of following TF
 
 static i2c_master_bus_handle_t i2c_handle = NULL;
 static i2c_master_dev_handle_t rtc_dev = NULL;
+static bool seeded_from_build_time = false;
+
+#ifdef CONFIG_RTC_TICK_INTERRUPT
+static bool tick_ready = false;
+static rtc_tick_t tick_rate = RTC_TICK_OFF;
+static volatile rtc_tick_cb_t tick_cb = NULL;
+static void *volatile tick_cb_data = NULL;
+
+static esp_err_t rtc_tick_init(void);
+#endif
+
+static esp_err_t rtc_read_reg(uint8_t reg, uint8_t *value) {
+  return i2c_master_transmit_receive(rtc_dev, &reg, 1, value, 1,
+                                     1000 / portTICK_PERIOD_MS);
+}
+
+static esp_err_t rtc_write_reg(uint8_t reg, uint8_t value) {
+  uint8_t data[2] = {reg, value};
+  return i2c_master_transmit(rtc_dev, data, 2, 1000 / portTICK_PERIOD_MS);
+}
 
 /**
  * @brief Convert BCD (Binary Coded Decimal) to decimal
@@ -71,6 +114,7 @@ esp_err_t rtc_init(i2c_master_bus_handle_t i2c_bus) {
              build_time.tm_mday, build_time.tm_hour, build_time.tm_min,
              build_time.tm_sec);
     rtc_write_time(&build_time);
+    seeded_from_build_time = true;
   } else {
     ESP_LOGE(TAG, "Failed to parse build time");
   }
@@ -84,6 +128,7 @@ esp_err_t rtc_init(i2c_master_bus_handle_t i2c_bus) {
                build_time.tm_mday, build_time.tm_hour, build_time.tm_min,
                build_time.tm_sec);
       rtc_write_time(&build_time);
+      seeded_from_build_time = true;
     } else {
       ESP_LOGE(TAG, "Failed to parse build time, using fallback");
       struct tm default_time = {
@@ -95,10 +140,18 @@ esp_err_t rtc_init(i2c_master_bus_handle_t i2c_bus) {
           .tm_sec = 0,
       };
       rtc_write_time(&default_time);
+      seeded_from_build_time = true;
     }
   }
 #endif
 
+#ifdef CONFIG_RTC_TICK_INTERRUPT
+  if (rtc_tick_init() != ESP_OK) {
+    ESP_LOGW(TAG, "RTC tick interrupt unavailable, callers fall back to "
+                  "polling");
+  }
+#endif
+
   return ESP_OK;
 }
 
@@ -163,6 +216,8 @@ esp_err_t rtc_write_time(const struct tm *time) {
   return ESP_OK;
 }
 
+bool rtc_seeded_from_build_time(void) { return seeded_from_build_time; }
+
 bool rtc_is_valid(void) {
   if (!rtc_dev) {
     return false;
@@ -201,3 +256,189 @@ bool rtc_is_valid(void) {
 
   return true;
 }
+
+esp_err_t rtc_set_stopped(bool stop) {
+  if (!rtc_dev) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  uint8_t ctrl1 = 0;
+  esp_err_t ret = rtc_read_reg(PCF85063_REG_CTRL1, &ctrl1);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+
+  ctrl1 = stop ? (ctrl1 | PCF85063_CTRL1_STOP) : (ctrl1 & ~PCF85063_CTRL1_STOP);
+  return rtc_write_reg(PCF85063_REG_CTRL1, ctrl1);
+}
+
+esp_err_t rtc_get_offset(int8_t *steps) {
+  if (!rtc_dev || !steps) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  uint8_t value = 0;
+  esp_err_t ret = rtc_read_reg(PCF85063_REG_OFFSET, &value);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+
+  // OFFSET[6:0] is two's complement; sign-extend from bit 6
+  *steps = (int8_t)(uint8_t)(value << 1) >> 1;
+  return ESP_OK;
+}
+
+esp_err_t rtc_set_offset(int8_t steps) {
+  if (!rtc_dev) {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (steps < RTC_OFFSET_MIN || steps > RTC_OFFSET_MAX) {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  // MODE = 0 (correction every two hours): required by the minute interrupt
+  esp_err_t ret = rtc_write_reg(PCF85063_REG_OFFSET, (uint8_t)steps & 0x7F);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to write offset: %s", esp_err_to_name(ret));
+    return ret;
+  }
+
+  ESP_LOGI(TAG, "Offset set to %d (%d ppb)", steps,
+           steps * RTC_OFFSET_PPB_PER_STEP);
+  return ESP_OK;
+}
+
+#ifdef CONFIG_RTC_TICK_INTERRUPT
+
+static void IRAM_ATTR rtc_tick_isr(void *arg) {
+  (void)arg;
+  rtc_tick_cb_t cb = tick_cb;
+  if (cb) {
+    cb(tick_cb_data);
+  }
+}
+
+static esp_err_t rtc_tick_init(void) {
+  if (CONFIG_RTC_INT_GPIO < 0) {
+    ESP_LOGW(TAG, "RTC_INT_GPIO not set");
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  // INT is open-drain, active low
+  gpio_config_t io_conf = {
+      .pin_bit_mask = 1ULL << CONFIG_RTC_INT_GPIO,
+      .mode = GPIO_MODE_INPUT,
+      .pull_up_en = GPIO_PULLUP_ENABLE,
+      .pull_down_en = GPIO_PULLDOWN_DISABLE,
+      .intr_type = GPIO_INTR_NEGEDGE,
+  };
+  esp_err_t ret = gpio_config(&io_conf);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+
+  // The touch driver may already have installed the shared ISR service
+  ret = gpio_install_isr_service(0);
+  if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE) {
+    return ret;
+  }
+
+  ret = gpio_isr_handler_add(CONFIG_RTC_INT_GPIO, rtc_tick_isr, NULL);
+  if (ret != ESP_OK) {
+    return ret;
+  }
+
+  tick_ready = true;
+
+#if defined(CONFIG_RTC_TICK_RATE_SECOND)
+  ret = rtc_tick_set_rate(RTC_TICK_SECOND);
+#else
+  ret = rtc_tick_set_rate(RTC_TICK_MINUTE);
+#endif
+  if (ret != ESP_OK) {
+    gpio_isr_handler_remove(CONFIG_RTC_INT_GPIO);
+    tick_ready = false;
+    return ret;
+  }
+
+  ESP_LOGI(TAG, "RTC tick interrupt on GPIO%d", CONFIG_RTC_INT_GPIO);
+  return ESP_OK;
+}
+
+esp_err_t rtc_tick_set_rate(rtc_tick_t rate) {
+  if (!rtc_dev || !tick_ready) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  if (rate == tick_rate) {
+    return ESP_OK;
+  }
+
+  uint8_t ctrl2 = PCF85063_CTRL2_COF_OFF;
+  uint8_t timer_mode = 0;
+
+  if (rate == RTC_TICK_MINUTE) {
+    ctrl2 |= PCF85063_CTRL2_MI;
+    timer_mode = PCF85063_TIMER_TI_TP;
+  } else if (rate == RTC_TICK_SECOND) {
+    timer_mode = PCF85063_TIMER_CLK_1HZ | PCF85063_TIMER_TE |
+                 PCF85063_TIMER_TIE | PCF85063_TIMER_TI_TP;
+  }
+
+  // Stop the timer before reloading it; writing Control_2 clears TF
+  esp_err_t ret = rtc_write_reg(PCF85063_REG_TIMER_MODE, 0);
+  if (ret == ESP_OK && rate == RTC_TICK_SECOND) {
+    ret = rtc_write_reg(PCF85063_REG_TIMER_VALUE, 1);
+  }
+  if (ret == ESP_OK) {
+    ret = rtc_write_reg(PCF85063_REG_CTRL2, ctrl2);
+  }
+  if (ret == ESP_OK && timer_mode) {
+    ret = rtc_write_reg(PCF85063_REG_TIMER_MODE, timer_mode);
+  }
+
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to program tick interrupt: %s",
+             esp_err_to_name(ret));
+    return ret;
+  }
+
+  tick_rate = rate;
+  return ESP_OK;
+}
+
+rtc_tick_t rtc_tick_get_rate(void) { return tick_rate; }
+
+void rtc_tick_set_callback(rtc_tick_cb_t cb, void *user_data) {
+  // Data first so the ISR never sees the new callback with old data
+  tick_cb = NULL;
+  tick_cb_data = user_data;
+  tick_cb = cb;
+}
+
+esp_err_t rtc_tick_set_wakeup(bool enable) {
+  if (!tick_ready) {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  if (enable) {
+    // Level wake only; the edge ISR would otherwise fire on every wake
+    gpio_intr_disable(CONFIG_RTC_INT_GPIO);
+    return gpio_wakeup_enable(CONFIG_RTC_INT_GPIO, GPIO_INTR_LOW_LEVEL);
+  }
+
+  esp_err_t ret = gpio_wakeup_disable(CONFIG_RTC_INT_GPIO);
+  if (ret == ESP_OK) {
+    ret = gpio_set_intr_type(CONFIG_RTC_INT_GPIO, GPIO_INTR_NEGEDGE);
+  }
+  if (ret == ESP_OK) {
+    ret = gpio_intr_enable(CONFIG_RTC_INT_GPIO);
+  }
+  return ret;
+}
+
+int rtc_tick_get_gpio(void) {
+  return tick_ready ? CONFIG_RTC_INT_GPIO : -1;
+}
+
+#endif // CONFIG_RTC_TICK_INTERRUPT
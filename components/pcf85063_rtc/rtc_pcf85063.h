@@ -11,7 +11,9 @@
 
 #include "driver/i2c_master.h"
 #include "esp_err.h"
+#include "sdkconfig.h"
 #include <stdbool.h>
+#include <stdint.h>
 #include <time.h>
 
 #ifdef __cplusplus
@@ -51,6 +53,129 @@ esp_err_t rtc_write_time(const struct tm *time);
  */
 bool rtc_is_valid(void);
 
+/** Offset register range and weight (MODE = 0, normal mode) */
+#define RTC_OFFSET_MIN (-64)
+#define RTC_OFFSET_MAX 63
+#define RTC_OFFSET_PPB_PER_STEP 4340
+
+/**
+ * @brief Stop or restart the time counter
+ *
+ * While stopped the upper prescaler is held in reset. After release the
+ * first seconds increment follows 0.5078 s later, which allows setting the
+ * RTC aligned to a reference second.
+ *
+ * @param stop true to stop, false to release
+ * @return ESP_OK on success
+ */
+esp_err_t rtc_set_stopped(bool stop);
+
+/**
+ * @brief Read the frequency offset register
+ *
+ * @param[out] steps Correction in RTC_OFFSET_PPB_PER_STEP units; positive
+ *                   values make the clock run faster
+ * @return ESP_OK on success
+ */
+esp_err_t rtc_get_offset(int8_t *steps);
+
+/**
+ * @brief Program the frequency offset register (normal mode)
+ *
+ * The correction is applied in pulses every two hours, so it only shows
+ * over periods of hours.
+ *
+ * @param steps RTC_OFFSET_MIN..RTC_OFFSET_MAX, positive = faster
+ * @return ESP_OK, ESP_ERR_INVALID_ARG if out of range
+ */
+esp_err_t rtc_set_offset(int8_t steps);
+
+/**
+ * @brief Check whether rtc_init() set the RTC to the build time
+ *
+ * The build time is local compile time, not UTC.
+ *
+ * @return true if the RTC lost its time and was seeded this boot
+ */
+bool rtc_seeded_from_build_time(void);
+
+/**
+ * @brief Periodic interrupt rate on the RTC INT pin
+ */
+typedef enum {
+  RTC_TICK_OFF = 0,
+  RTC_TICK_MINUTE, ///< Minute interrupt (MI), pulses at every minute change
+  RTC_TICK_SECOND, ///< Countdown timer at 1 Hz, pulses every second
+} rtc_tick_t;
+
+/**
+ * @brief Tick callback, runs in ISR context
+ */
+typedef void (*rtc_tick_cb_t)(void *user_data);
+
+#ifdef CONFIG_RTC_TICK_INTERRUPT
+
+/**
+ * @brief Program the periodic interrupt
+ *
+ * INT is driven in pulse mode, so no I2C access is needed to acknowledge a
+ * tick. Set up by rtc_init() with CONFIG_RTC_TICK_RATE.
+ *
+ * @param rate Tick rate, RTC_TICK_OFF to disable
+ * @return ESP_OK on success
+ */
+esp_err_t rtc_tick_set_rate(rtc_tick_t rate);
+
+/**
+ * @brief Get the currently programmed tick rate
+ */
+rtc_tick_t rtc_tick_get_rate(void);
+
+/**
+ * @brief Set the function called on every INT falling edge
+ *
+ * @param cb Callback (ISR context, keep it short), NULL to remove
+ * @param user_data Passed to the callback
+ */
+void rtc_tick_set_callback(rtc_tick_cb_t cb, void *user_data);
+
+/**
+ * @brief Use the INT pin as a light-sleep wake source
+ *
+ * While enabled the tick callback is masked and the pin wakes the chip on
+ * low level; disabling restores the edge interrupt.
+ *
+ * @param enable true before light sleep, false after wake
+ * @return ESP_OK, or ESP_ERR_INVALID_STATE if ticks are unavailable
+ */
+esp_err_t rtc_tick_set_wakeup(bool enable);
+
+/**
+ * @brief GPIO wired to the RTC INT pin
+ *
+ * @return GPIO number, or -1 if ticks are unavailable (init failed)
+ */
+int rtc_tick_get_gpio(void);
+
+#else
+
+static inline esp_err_t rtc_tick_set_rate(rtc_tick_t rate) {
+  (void)rate;
+  return ESP_ERR_NOT_SUPPORTED;
+}
+static inline rtc_tick_t rtc_tick_get_rate(void) { return RTC_TICK_OFF; }
+static inline void rtc_tick_set_callback(rtc_tick_cb_t cb, void *user_data) {
+  (void)cb;
+  (void)user_data;
+}
+static inline esp_err_t rtc_tick_set_wakeup(bool enable) {
+  (void)enable;
+  return ESP_ERR_NOT_SUPPORTED;
+}
+static inline int rtc_tick_get_gpio(void) { return -1; }
+
+#endif // CONFIG_RTC_TICK_INTERRUPT
+
 #ifdef __cplusplus
 }
 #endif
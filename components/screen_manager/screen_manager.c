@@ -26,6 +26,7 @@ typedef struct
   screen_anim_type_t anim_type; /*!< Animation type for this screen */
   void (*hide_callback)(void);  /*!< Hide callback for this screen */
   bool auto_delete;             /*!< Auto-delete when popped from stack */
+  uint8_t id;                   /*!< App-defined screen id (0 = none) */
 } screen_metadata_t;
 
 /**
@@ -37,12 +38,14 @@ typedef struct
   int depth;                               /*!< Current stack depth (0 = empty) */
   bool initialized;                        /*!< Initialization flag */
   bool transition_in_progress;             /*!< Prevent re-entrant navigation */
+  bool animations_disabled;                /*!< Load screens instantly */
 } screen_manager_state_t;
 
 static screen_manager_state_t s_manager = {
     .depth = 0,
     .initialized = false,
-    .transition_in_progress = false};
+    .transition_in_progress = false,
+    .animations_disabled = false};
 
 /**
  * @brief Create title label
@@ -191,6 +194,7 @@ lv_obj_t *screen_manager_create(const screen_config_t *config)
   metadata->anim_type = config->anim_type;
   metadata->hide_callback = config->hide_callback;
   metadata->auto_delete = true; // Always auto-delete when popped
+  metadata->id = config->id;
   lv_obj_set_user_data(screen, metadata);
 
   // Style as black container with no border/padding
@@ -282,7 +286,11 @@ esp_err_t screen_manager_show(lv_obj_t *screen)
   screen_anim_type_t anim_type = metadata->anim_type;
 
   // Load screen with appropriate animation
-  if (anim_type == SCREEN_ANIM_VERTICAL)
+  if (s_manager.animations_disabled)
+  {
+    lv_scr_load(screen);
+  }
+  else if (anim_type == SCREEN_ANIM_VERTICAL)
   {
     screen_nav_load_with_anim(screen, NULL);
   }
@@ -509,3 +517,28 @@ bool screen_manager_can_go_back(void)
 {
   return s_manager.initialized && s_manager.depth > 1;
 }
+
+lv_obj_t *screen_manager_get_screen_at(int index)
+{
+  if (!s_manager.initialized || index < 0 || index >= s_manager.depth)
+  {
+    return NULL;
+  }
+  return s_manager.stack[index];
+}
+
+uint8_t screen_manager_get_screen_id(lv_obj_t *screen)
+{
+  if (!screen || screen_manager_is_root(screen))
+  {
+    return 0;
+  }
+
+  screen_metadata_t *metadata = (screen_metadata_t *)lv_obj_get_user_data(screen);
+  return metadata ? metadata->id : 0;
+}
+
+void screen_manager_set_animations_enabled(bool enabled)
+{
+  s_manager.animations_disabled = !enabled;
+}
@@ -42,6 +42,7 @@ extern "C"
     bool show_back_button;        /*!< Show back button at top-left (auto-calls screen_manager_go_back) */
     screen_anim_type_t anim_type; /*!< Animation type for transitions */
     void (*hide_callback)(void);  /*!< Optional callback when screen hides (called before animation) */
+    uint8_t id;                   /*!< App-defined screen id for UI state snapshots (0 = none) */
   } screen_config_t;
 
   /**
@@ -148,6 +149,32 @@ extern "C"
    */
   bool screen_manager_can_go_back(void);
 
+  /**
+   * @brief Get a screen from the navigation stack
+   *
+   * @param index Stack index (0 = root)
+   * @return Screen object, or NULL if index is out of range
+   */
+  lv_obj_t *screen_manager_get_screen_at(int index);
+
+  /**
+   * @brief Get the app-defined id of a managed screen
+   *
+   * @param screen Screen object
+   * @return Id from screen_config_t, or 0 if none / not a managed screen
+   */
+  uint8_t screen_manager_get_screen_id(lv_obj_t *screen);
+
+  /**
+   * @brief Enable or disable transition animations
+   *
+   * Disable while rebuilding the stack (e.g. UI state restore) so screens
+   * are loaded instantly one after another.
+   *
+   * @param enabled true to animate transitions (default)
+   */
+  void screen_manager_set_animations_enabled(bool enabled);
+
 #ifdef __cplusplus
 }
 #endif
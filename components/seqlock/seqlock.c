@@ -0,0 +1,56 @@
+/**
+ * @file seqlock.c
+ * @brief Two-copy sequence lock implementation
+ */
+
+#include "seqlock.h"
+#include <string.h>
+
+void seqlock_init(seqlock_t *lock, void *storage, size_t size)
+{
+  lock->storage = storage;
+  lock->size = size;
+  memset(storage, 0, 2 * size);
+  atomic_init(&lock->sequence, 0);
+}
+
+void seqlock_write(seqlock_t *lock, const void *value)
+{
+  uint32_t seq = atomic_load_explicit(&lock->sequence, memory_order_relaxed);
+
+  // Odd: readers move to copy 1 while copy 0 is updated. Release, so the
+  // last write's copy 1 is complete before a reader can pick copy 1
+  atomic_store_explicit(&lock->sequence, seq + 1, memory_order_release);
+  // No copy 0 byte may be seen before the odd sequence; pairs with the
+  // reader's acquire fence ahead of its re-check
+  atomic_thread_fence(memory_order_release);
+  memcpy(lock->storage, value, lock->size);
+
+  // Even: readers move back to copy 0 while copy 1 catches up. Release,
+  // so copy 0 is complete before a reader can pick it
+  atomic_store_explicit(&lock->sequence, seq + 2, memory_order_release);
+  // Same as above for copy 1 against the even sequence
+  atomic_thread_fence(memory_order_release);
+  memcpy(lock->storage + lock->size, value, lock->size);
+}
+
+uint32_t seqlock_read(const seqlock_t *lock, void *value)
+{
+  uint32_t seq;
+  uint32_t check;
+
+  do
+  {
+    seq = atomic_load_explicit(&lock->sequence, memory_order_acquire);
+    memcpy(value, lock->storage + (seq & 1) * lock->size, lock->size);
+    atomic_thread_fence(memory_order_acquire);
+    check = atomic_load_explicit(&lock->sequence, memory_order_relaxed);
+  } while (check != seq);
+
+  return seq;
+}
+
+uint32_t seqlock_sequence(const seqlock_t *lock)
+{
+  return atomic_load_explicit(&lock->sequence, memory_order_acquire);
+}
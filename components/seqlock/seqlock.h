@@ -0,0 +1,97 @@
+/**
+ * @file seqlock.h
+ * @brief Single-writer, multi-reader snapshot with lock-free reads
+ *
+ * A sequence lock over two copies of a value (a "latch"): the writer bumps
+ * the sequence and updates one copy while readers use the other, then does
+ * the same for the second copy. A reader copies the stable slot and retries
+ * only if the writer completed a step meanwhile. Readers never block or
+ * fail, and because the stable copy is never written while a reader holds
+ * the CPU, a reader that preempts the writer does not spin.
+ *
+ * Suited to small status structs published by one task (sensor poller,
+ * event handler) and read from the LVGL thread.
+ *
+ * Usage:
+ * @code
+ * static my_status_t status_storage[2];
+ * static seqlock_t status_lock = SEQLOCK_INITIALIZER(status_storage);
+ *
+ * seqlock_write(&status_lock, &new_status); // producer task only
+ * seqlock_read(&status_lock, &copy);        // any task, never blocks
+ * @endcode
+ */
+
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <stdatomic.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+  typedef struct
+  {
+    _Atomic uint32_t sequence; ///< Even/odd selects the stable copy
+    uint8_t *storage;          ///< Two copies of size bytes
+    size_t size;
+  } seqlock_t;
+
+/**
+ * @brief Static initialiser over a zeroed two-element array of the value type
+ *
+ * Lets a lock be read before its owner's init function ran.
+ */
+#define SEQLOCK_INITIALIZER(storage_array)                                    \
+  {                                                                           \
+    .sequence = 0, .storage = (uint8_t *)(storage_array),                     \
+    .size = sizeof((storage_array)[0]),                                       \
+  }
+
+  /**
+   * @brief Initialise a seqlock at runtime
+   *
+   * Both copies are cleared, so readers see an all-zero value until the
+   * first write.
+   *
+   * @param lock Seqlock to initialise
+   * @param storage Buffer of at least 2 * size bytes, lives as long as lock
+   * @param size Size of the protected value
+   */
+  void seqlock_init(seqlock_t *lock, void *storage, size_t size);
+
+  /**
+   * @brief Publish a new value
+   *
+   * Only one task may write a given seqlock; concurrent writers must be
+   * serialised by the caller.
+   *
+   * @param lock Seqlock
+   * @param value New value (size bytes)
+   */
+  void seqlock_write(seqlock_t *lock, const void *value);
+
+  /**
+   * @brief Copy out the latest consistent value
+   *
+   * @param lock Seqlock
+   * @param[out] value Destination (size bytes)
+   * @return Sequence number of the copy; changes on every write, so callers
+   *         can skip work when nothing was published since the last read
+   */
+  uint32_t seqlock_read(const seqlock_t *lock, void *value);
+
+  /**
+   * @brief Get the current sequence number without copying
+   */
+  uint32_t seqlock_sequence(const seqlock_t *lock);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // SEQLOCK_H
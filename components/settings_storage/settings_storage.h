@@ -30,6 +30,12 @@ extern "C"
 #define SETTING_KEY_TIMEZONE "timezone"
 #define SETTING_KEY_DST_ENABLED "dst_enabled"
 #define SETTING_KEY_LAST_SYNC "last_sync"
+#define SETTING_KEY_UTC_OFFSET "utc_offset"
+#define SETTING_KEY_RTC_UTC "rtc_utc"
+#define SETTING_KEY_RTC_SET_AT "rtc_set_at"
+#define SETTING_KEY_DRIFT_PPB "drift_ppb"
+#define SETTING_KEY_DRIFT_WEIGHT "drift_wt"
+#define SETTING_KEY_DRIFT_SAMPLES "drift_n"
 
 /** Default values */
 #define SETTING_DEFAULT_BRIGHTNESS 80
@@ -12,11 +12,15 @@
 #include "esp_log.h"
 #include "esp_sleep.h"
 #include "esp_timer.h"
+#include "event_bus.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "lvgl.h"
 #include "pmu_axp2101.h"
+#include "rtc_pcf85063.h"
 #include "uptime_tracker.h"
+#include "wake_latency.h"
+#include <stdlib.h>
 #include <string.h>
 
 static const char *TAG = "SleepMgr";
@@ -28,6 +32,10 @@ static const char *TAG = "SleepMgr";
 #define SLEEP_LOGD(tag, format, ...) ((void)0)
 #endif
 
+// The sleep check task runs every hook on entry and wake: WiFi stop, the
+// LVGL tree walk in ui_state, RTC I2C and their logging
+#define SLEEP_TASK_STACK_SIZE 4096
+
 // Inactivity tracking
 static int64_t last_activity_time = 0;
 static int64_t last_user_activity_time = 0;
@@ -40,15 +48,219 @@ RTC_DATA_ATTR static sleep_manager_sleep_type_t last_sleep_type =
 // Task handle for sleep monitoring
 static TaskHandle_t sleep_task_handle = NULL;
 
-// Store LVGL objects for sleep/wake control
+// Timers redrawn first on wake (watchface, ...)
+#define MAX_CRITICAL_TIMERS 4
+static lv_timer_t *critical_timers[MAX_CRITICAL_TIMERS];
+static uint8_t critical_timer_count = 0;
+
+#ifdef CONFIG_SLEEP_MANAGER_STAGGERED_RESUME
+// Non-critical timers held back after wake and released a few per frame
+#define RESUME_STAGGER_PERIOD_MS 20
+static lv_timer_t **deferred_timers = NULL;
+static size_t deferred_timer_count = 0;
+static size_t deferred_timer_next = 0;
+static lv_timer_t *stagger_timer = NULL;
+#endif
+
+// Last area of the first frame after wake handed to the driver
+static volatile bool wake_flush_armed = false;
+
+// Subsystem hooks, sorted by ascending priority. Tasks register while the
+// sleep check task runs hooks, so the table is only touched under hook_mux
+// and hooks run from a snapshot of it
+#define MAX_SLEEP_HOOKS 8
+static sleep_manager_hook_t sleep_hooks[MAX_SLEEP_HOOKS];
+static uint8_t sleep_hook_count = 0;
+static portMUX_TYPE hook_mux = portMUX_INITIALIZER_UNLOCKED;
+
 typedef struct
 {
-  lv_timer_t *timer;
-} timer_state_t;
+  sleep_manager_hook_t hooks[MAX_SLEEP_HOOKS];
+  uint8_t count;
+} hook_list_t;
+static bool wake_hook_pending = false;
+static bool post_wake_hook_pending = false;
+
+static const char *const hook_phase_names[SLEEP_HOOK_PHASE_COUNT] = {
+    "prepare", "enter", "wake", "post_wake"};
+
+static sleep_manager_hook_cb_t hook_get_cb(const sleep_manager_hook_t *hook,
+                                           sleep_hook_phase_t phase)
+{
+  switch (phase)
+  {
+  case SLEEP_HOOK_PHASE_PREPARE:
+    return hook->prepare;
+  case SLEEP_HOOK_PHASE_ENTER:
+    return hook->enter;
+  case SLEEP_HOOK_PHASE_WAKE:
+    return hook->wake;
+  case SLEEP_HOOK_PHASE_POST_WAKE:
+    return hook->post_wake;
+  default:
+    return NULL;
+  }
+}
+
+/**
+ * @brief Copy the hook table, so a walk is not disturbed by registration
+ */
+static void hook_list_snapshot(hook_list_t *list)
+{
+  taskENTER_CRITICAL(&hook_mux);
+  list->count = sleep_hook_count;
+  memcpy(list->hooks, sleep_hooks, sleep_hook_count * sizeof(sleep_hooks[0]));
+  taskEXIT_CRITICAL(&hook_mux);
+}
+
+/**
+ * @brief Run a single hook callback, timing it
+ */
+static esp_err_t run_hook(const sleep_manager_hook_t *hook,
+                          sleep_hook_phase_t phase,
+                          sleep_manager_sleep_type_t sleep_type)
+{
+  sleep_manager_hook_cb_t cb = hook_get_cb(hook, phase);
+  if (!cb)
+  {
+    return ESP_OK;
+  }
+
+  int64_t start = esp_timer_get_time();
+  esp_err_t ret = cb(sleep_type, hook->user_data);
+  uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - start);
+
+  if (elapsed_us >= (uint32_t)CONFIG_SLEEP_MANAGER_HOOK_SLOW_MS * 1000U)
+  {
+    ESP_LOGW(TAG, "Slow %s hook '%s': %lu us", hook_phase_names[phase],
+             hook->name, (unsigned long)elapsed_us);
+  }
+  else
+  {
+    SLEEP_LOGD(TAG, "%s hook '%s': %lu us", hook_phase_names[phase],
+               hook->name, (unsigned long)elapsed_us);
+  }
+
+  return ret;
+}
+
+/**
+ * @brief Run a sleep-entry phase in ascending priority order
+ *
+ * @param[out] rolled_back If not NULL, set to the number of hooks (the
+ *             first ones) that got post_wake because of a veto
+ * @return ESP_OK, or the error of a vetoing prepare hook
+ */
+static esp_err_t run_entry_hooks_ex(const hook_list_t *list,
+                                    sleep_hook_phase_t phase,
+                                    sleep_manager_sleep_type_t sleep_type,
+                                    uint8_t *rolled_back)
+{
+  if (rolled_back)
+  {
+    *rolled_back = 0;
+  }
+  if (list->count == 0)
+  {
+    return ESP_OK;
+  }
+
+  int64_t start = esp_timer_get_time();
+
+  for (uint8_t i = 0; i < list->count; i++)
+  {
+    esp_err_t ret = run_hook(&list->hooks[i], phase, sleep_type);
+    if (ret == ESP_OK)
+    {
+      continue;
+    }
+
+    if (phase == SLEEP_HOOK_PHASE_PREPARE && list->hooks[i].can_veto)
+    {
+      ESP_LOGI(TAG, "Sleep vetoed by '%s': %s", list->hooks[i].name,
+               esp_err_to_name(ret));
+
+      // Let hooks that already prepared undo their work
+      for (uint8_t j = i; j > 0; j--)
+      {
+        run_hook(&list->hooks[j - 1], SLEEP_HOOK_PHASE_POST_WAKE, sleep_type);
+      }
+      if (rolled_back)
+      {
+        *rolled_back = i;
+      }
+      return ret;
+    }
+
+    ESP_LOGW(TAG, "%s hook '%s' failed: %s", hook_phase_names[phase],
+             list->hooks[i].name, esp_err_to_name(ret));
+  }
+
+  ESP_LOGI(TAG, "Hooks %s: %d in %lu us", hook_phase_names[phase],
+           list->count,
+           (unsigned long)(esp_timer_get_time() - start));
+  return ESP_OK;
+}
+
+static esp_err_t run_entry_hooks(sleep_hook_phase_t phase,
+                                 sleep_manager_sleep_type_t sleep_type)
+{
+  hook_list_t list;
+  hook_list_snapshot(&list);
+  return run_entry_hooks_ex(&list, phase, sleep_type, NULL);
+}
+
+/**
+ * @brief Run a wake phase in descending priority order
+ */
+static void run_wake_hooks(sleep_hook_phase_t phase,
+                           sleep_manager_sleep_type_t sleep_type)
+{
+  hook_list_t list;
+  hook_list_snapshot(&list);
+  if (list.count == 0)
+  {
+    return;
+  }
+
+  int64_t start = esp_timer_get_time();
+
+  for (uint8_t i = list.count; i > 0; i--)
+  {
+    esp_err_t ret = run_hook(&list.hooks[i - 1], phase, sleep_type);
+    if (ret != ESP_OK)
+    {
+      ESP_LOGW(TAG, "%s hook '%s' failed: %s", hook_phase_names[phase],
+               list.hooks[i - 1].name, esp_err_to_name(ret));
+    }
+  }
+
+  ESP_LOGI(TAG, "Hooks %s: %d in %lu us", hook_phase_names[phase],
+           list.count,
+           (unsigned long)(esp_timer_get_time() - start));
+}
+
+/**
+ * @brief Built-in hooks: count sleep time separately from awake time
+ *
+ * Counters live in RTC memory, so nothing is written to flash here.
+ */
+static esp_err_t uptime_enter_hook(sleep_manager_sleep_type_t sleep_type,
+                                   void *user_data)
+{
+  (void)user_data;
+  uptime_tracker_sleep_enter(sleep_type == SLEEP_MANAGER_SLEEP_TYPE_DEEP);
+  return ESP_OK;
+}
 
-#define MAX_TIMERS 8
-static timer_state_t saved_timers[MAX_TIMERS];
-static uint8_t saved_timer_count = 0;
+static esp_err_t uptime_wake_hook(sleep_manager_sleep_type_t sleep_type,
+                                  void *user_data)
+{
+  (void)sleep_type;
+  (void)user_data;
+  uptime_tracker_sleep_exit();
+  return ESP_OK;
+}
 
 static bool sleep_manager_lock_display_with_retry(uint32_t timeout_ms,
                                                   uint8_t retries,
@@ -70,6 +282,15 @@ static bool sleep_manager_lock_display_with_retry(uint32_t timeout_ms,
   return false;
 }
 
+static void publish_sleep_event(bool awake)
+{
+  const event_t event = {
+      .type = EVENT_SLEEP,
+      .sleep.awake = awake,
+  };
+  event_bus_publish(&event);
+}
+
 #ifdef CONFIG_SLEEP_MANAGER_POWER_LOGS
 static void log_power_state(const char *label)
 {
@@ -169,74 +390,293 @@ static esp_err_t display_wake(void)
 }
 
 /**
- * @brief Pause all LVGL timers to save power during sleep
+ * @brief Check whether a timer still exists in the LVGL timer list
  */
-static void pause_lvgl_timers(void)
+static bool lvgl_timer_exists(const lv_timer_t *timer)
 {
-#ifdef CONFIG_SLEEP_MANAGER_LVGL_TIMER_PAUSE
-  saved_timer_count = 0;
-  memset(saved_timers, 0, sizeof(saved_timers));
+  for (lv_timer_t *t = lv_timer_get_next(NULL); t != NULL;
+       t = lv_timer_get_next(t))
+  {
+    if (t == timer)
+    {
+      return true;
+    }
+  }
+  return false;
+}
 
-  // Get first timer
-  lv_timer_t *timer = lv_timer_get_next(NULL);
+/**
+ * @brief Check whether a timer must run immediately on wake
+ *
+ * Display refresh and input read timers are always critical, otherwise the
+ * first frame (and the touch that woke us) would wait behind app timers.
+ */
+static bool lvgl_timer_is_critical(lv_timer_t *timer)
+{
+  for (uint8_t i = 0; i < critical_timer_count; i++)
+  {
+    if (critical_timers[i] == timer)
+    {
+      return true;
+    }
+  }
+
+  for (lv_display_t *disp = lv_display_get_next(NULL); disp != NULL;
+       disp = lv_display_get_next(disp))
+  {
+    if (lv_display_get_refr_timer(disp) == timer)
+    {
+      return true;
+    }
+  }
 
-  while (timer != NULL && saved_timer_count < MAX_TIMERS)
+  for (lv_indev_t *indev = lv_indev_get_next(NULL); indev != NULL;
+       indev = lv_indev_get_next(indev))
   {
-    // Save timer reference
-    saved_timers[saved_timer_count].timer = timer;
+    if (lv_indev_get_read_timer(indev) == timer)
+    {
+      return true;
+    }
+  }
 
-    // Pause timer
-    lv_timer_pause(timer);
-    SLEEP_LOGD(TAG, "Paused timer %d", saved_timer_count);
+  return false;
+}
 
-    saved_timer_count++;
-    timer = lv_timer_get_next(timer);
+#ifdef CONFIG_SLEEP_MANAGER_STAGGERED_RESUME
+/**
+ * @brief Resume one deferred timer if it was not deleted meanwhile
+ */
+static void resume_deferred_timer(lv_timer_t *timer)
+{
+  if (timer && lvgl_timer_exists(timer))
+  {
+    lv_timer_resume(timer);
+    lv_timer_ready(timer);
   }
+}
 
-  if (timer != NULL && saved_timer_count >= MAX_TIMERS)
+/**
+ * @brief Release any still-deferred timers at once and drop the list
+ */
+static void finish_staggered_resume(void)
+{
+  while (deferred_timer_next < deferred_timer_count)
   {
-    ESP_LOGW(TAG, "LVGL timer pause limit reached (%d), some timers not paused",
-             MAX_TIMERS);
+    resume_deferred_timer(deferred_timers[deferred_timer_next++]);
   }
-  else if (saved_timer_count == 0)
+
+  free(deferred_timers);
+  deferred_timers = NULL;
+  deferred_timer_count = 0;
+  deferred_timer_next = 0;
+
+  if (stagger_timer)
   {
-    ESP_LOGI(TAG, "No LVGL timers found to pause");
+    lv_timer_delete(stagger_timer);
+    stagger_timer = NULL;
   }
+}
 
-  ESP_LOGI(TAG, "Paused %d LVGL timers", saved_timer_count);
+/**
+ * @brief Release a batch of deferred timers per frame
+ */
+static void stagger_timer_cb(lv_timer_t *timer)
+{
+  (void)timer;
+
+  for (int i = 0; i < CONFIG_SLEEP_MANAGER_RESUME_TIMERS_PER_FRAME &&
+                  deferred_timer_next < deferred_timer_count;
+       i++)
+  {
+    resume_deferred_timer(deferred_timers[deferred_timer_next++]);
+  }
+
+  if (deferred_timer_next >= deferred_timer_count)
+  {
+    SLEEP_LOGD(TAG, "Staggered resume finished (%d timers)",
+               (int)deferred_timer_count);
+    finish_staggered_resume();
+  }
+}
+
+/**
+ * @brief Hold back non-critical timers so they resume over later frames
+ */
+static void defer_noncritical_timers(void)
+{
+  size_t count = 0;
+  for (lv_timer_t *t = lv_timer_get_next(NULL); t != NULL;
+       t = lv_timer_get_next(t))
+  {
+    if (!lv_timer_get_paused(t) && !lvgl_timer_is_critical(t))
+    {
+      count++;
+    }
+  }
+
+  if (count == 0)
+  {
+    return;
+  }
+
+  deferred_timers = malloc(count * sizeof(lv_timer_t *));
+  if (!deferred_timers)
+  {
+    ESP_LOGW(TAG, "No memory to stagger %d timers - resuming all at once",
+             (int)count);
+    return;
+  }
+
+  for (lv_timer_t *t = lv_timer_get_next(NULL);
+       t != NULL && deferred_timer_count < count; t = lv_timer_get_next(t))
+  {
+    if (!lv_timer_get_paused(t) && !lvgl_timer_is_critical(t))
+    {
+      lv_timer_pause(t);
+      deferred_timers[deferred_timer_count++] = t;
+    }
+  }
+
+  stagger_timer = lv_timer_create(stagger_timer_cb, RESUME_STAGGER_PERIOD_MS,
+                                  NULL);
+  if (!stagger_timer)
+  {
+    finish_staggered_resume();
+    return;
+  }
+
+  ESP_LOGI(TAG, "Deferred %d LVGL timers (%d per %d ms)",
+           (int)deferred_timer_count,
+           CONFIG_SLEEP_MANAGER_RESUME_TIMERS_PER_FRAME,
+           RESUME_STAGGER_PERIOD_MS);
+}
+#endif // CONFIG_SLEEP_MANAGER_STAGGERED_RESUME
+
+/**
+ * @brief Suspend LVGL timer handling to save power during sleep
+ *
+ * Disables the timer handler as a whole, so every timer is covered no
+ * matter how many exist and per-timer pause state is left untouched.
+ */
+static void pause_lvgl_timers(void)
+{
+#ifdef CONFIG_SLEEP_MANAGER_LVGL_TIMER_PAUSE
+#ifdef CONFIG_SLEEP_MANAGER_STAGGERED_RESUME
+  // Sleeping again before a staggered resume finished
+  finish_staggered_resume();
+#endif
+
+  lv_timer_enable(false);
+  ESP_LOGI(TAG, "LVGL timer handling suspended");
 #else
   ESP_LOGI(TAG, "LVGL timer pause disabled");
 #endif
 }
 
 /**
- * @brief Resume previously paused LVGL timers
+ * @brief Resume LVGL timer handling
+ *
+ * Critical timers (display refresh, input, registered app timers) are made
+ * ready immediately. With CONFIG_SLEEP_MANAGER_STAGGERED_RESUME the rest are
+ * released a few per frame; otherwise all of them fire on the next handler
+ * run.
  */
 static void resume_lvgl_timers(void)
 {
 #ifdef CONFIG_SLEEP_MANAGER_LVGL_TIMER_PAUSE
-  for (uint8_t i = 0; i < saved_timer_count; i++)
-  {
-    lv_timer_t *timer = saved_timers[i].timer;
+#ifdef CONFIG_SLEEP_MANAGER_STAGGERED_RESUME
+  defer_noncritical_timers();
+#endif
 
-    if (timer)
+  for (lv_timer_t *t = lv_timer_get_next(NULL); t != NULL;
+       t = lv_timer_get_next(t))
+  {
+#ifdef CONFIG_SLEEP_MANAGER_STAGGERED_RESUME
+    if (!lvgl_timer_is_critical(t))
     {
-      // Resume timer
-      lv_timer_resume(timer);
-      lv_timer_ready(timer); // Force immediate execution
-      SLEEP_LOGD(TAG, "Resumed timer %d", i);
+      continue;
     }
-
-    saved_timers[i].timer = NULL;
+#endif
+    lv_timer_ready(t); // Force immediate execution
   }
 
-  ESP_LOGI(TAG, "Resumed %d LVGL timers", saved_timer_count);
-  saved_timer_count = 0;
+  lv_timer_enable(true);
+  ESP_LOGI(TAG, "LVGL timer handling resumed");
 #else
   ESP_LOGI(TAG, "LVGL timer resume disabled");
 #endif
 }
 
+/**
+ * @brief Attribute a light sleep wake to touch, button or other
+ */
+static wake_latency_source_t get_wake_latency_source(
+    esp_sleep_wakeup_cause_t cause)
+{
+#ifdef CONFIG_SLEEP_MANAGER_GPIO_WAKEUP
+  if (cause == ESP_SLEEP_WAKEUP_GPIO)
+  {
+    uint64_t wake_mask = esp_sleep_get_gpio_wakeup_status();
+#ifdef CONFIG_SLEEP_MANAGER_TOUCH_WAKEUP
+    if (wake_mask & (1ULL << TOUCH_INT_GPIO))
+    {
+      return WAKE_LATENCY_SOURCE_TOUCH;
+    }
+#endif
+    if (wake_mask & (1ULL << BOOT_BUTTON_GPIO))
+    {
+      return WAKE_LATENCY_SOURCE_BUTTON;
+    }
+  }
+#else
+  (void)cause;
+#endif
+  return WAKE_LATENCY_SOURCE_OTHER;
+}
+
+/**
+ * @brief Display event handler: last area of the first frame after wake
+ *
+ * LVGL flushes areas while the frame renders, so when the last area's
+ * flush starts the whole frame is rendered, but its transfer may still
+ * run after the refresh ends. flush_cb only starts the transfer; the
+ * sample is completed from the driver's lv_display_flush_ready() below.
+ */
+static void wake_flush_event_handler(lv_event_t *e)
+{
+  lv_display_t *disp = lv_event_get_user_data(e);
+
+  if (!lv_display_flush_is_last(disp) || !wake_latency_in_progress())
+  {
+    return;
+  }
+
+  wake_latency_mark(WAKE_LATENCY_STAGE_FIRST_RENDER);
+  wake_flush_armed = true;
+}
+
+#ifdef CONFIG_SLEEP_MANAGER_WAKE_LATENCY_STATS
+void __real_lv_display_flush_ready(lv_display_t *disp);
+
+/**
+ * @brief Linker wrap (-Wl,--wrap) of the driver's flush-ready call
+ *
+ * Called by the display driver, usually from its transfer-done ISR.
+ */
+void __wrap_lv_display_flush_ready(lv_display_t *disp)
+{
+  bool last = lv_display_flush_is_last(disp);
+
+  __real_lv_display_flush_ready(disp);
+
+  if (last && wake_flush_armed)
+  {
+    wake_flush_armed = false;
+    wake_latency_mark_from_isr(WAKE_LATENCY_STAGE_FIRST_FLUSH);
+  }
+}
+#endif
+
 /**
  * @brief Global event handler for touch events
  * Resets sleep timer and turns on backlight on any screen touch
@@ -264,6 +704,8 @@ static void global_touch_event_handler(lv_event_t *e)
 }
 
 #ifdef CONFIG_SLEEP_MANAGER_DEEP_SLEEP_ENABLE
+static void sleep_manager_enter_deep_sleep(void);
+
 static uint32_t sleep_manager_get_user_inactive_time(void)
 {
   int64_t now = esp_timer_get_time();
@@ -289,6 +731,9 @@ static void sleep_check_task(void *pvParameters)
     // Check every 500ms
     vTaskDelay(pdMS_TO_TICKS(500));
 
+    // Samples completed by the display driver's flush-ready interrupt
+    wake_latency_log_pending();
+
     // Check backlight timeout first (independent of sleep)
     if (sleep_manager_should_turn_off_backlight())
     {
@@ -330,6 +775,15 @@ static void sleep_check_task(void *pvParameters)
         }
 #endif
 
+        if (allow_deep_sleep &&
+            run_entry_hooks(SLEEP_HOOK_PHASE_PREPARE,
+                            SLEEP_MANAGER_SLEEP_TYPE_DEEP) != ESP_OK)
+        {
+          // Vetoed - restart the deep sleep countdown instead of retrying
+          last_user_activity_time = esp_timer_get_time();
+          allow_deep_sleep = false;
+        }
+
         if (allow_deep_sleep)
         {
           is_sleeping = true;
@@ -456,6 +910,9 @@ esp_err_t sleep_manager_init(void)
       {
         ESP_LOGW(TAG, "No input device found for event handler registration");
       }
+
+      lv_display_add_event_cb(disp, wake_flush_event_handler,
+                              LV_EVENT_FLUSH_START, disp);
     }
     bsp_display_unlock();
   }
@@ -464,9 +921,19 @@ esp_err_t sleep_manager_init(void)
     ESP_LOGW(TAG, "Failed to acquire display lock for touch handler registration");
   }
 
+  // Built-in hooks
+  const sleep_manager_hook_t uptime_hook = {
+      .name = "uptime",
+      .priority = SLEEP_HOOK_PRIORITY_LATE,
+      .enter = uptime_enter_hook,
+      .wake = uptime_wake_hook,
+  };
+  sleep_manager_register_hook(&uptime_hook);
+
   // Create sleep monitoring task
-  BaseType_t task_created = xTaskCreate(sleep_check_task, "sleep_check", 2048,
-                                        NULL, 5, &sleep_task_handle);
+  BaseType_t task_created =
+      xTaskCreate(sleep_check_task, "sleep_check", SLEEP_TASK_STACK_SIZE, NULL,
+                  5, &sleep_task_handle);
   if (task_created != pdPASS)
   {
     ESP_LOGE(TAG, "Failed to create sleep monitoring task");
@@ -507,6 +974,95 @@ bool sleep_manager_get_last_sleep_type(sleep_manager_sleep_type_t *out_type)
   return true;
 }
 
+esp_err_t sleep_manager_register_hook(const sleep_manager_hook_t *hook)
+{
+  if (!hook || !hook->name)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  taskENTER_CRITICAL(&hook_mux);
+  if (sleep_hook_count >= MAX_SLEEP_HOOKS)
+  {
+    taskEXIT_CRITICAL(&hook_mux);
+    ESP_LOGW(TAG, "Sleep hook table full (%d), '%s' not registered",
+             MAX_SLEEP_HOOKS, hook->name);
+    return ESP_ERR_NO_MEM;
+  }
+
+  // Insert after all hooks with priority <= new one (stable order)
+  uint8_t pos = sleep_hook_count;
+  while (pos > 0 && sleep_hooks[pos - 1].priority > hook->priority)
+  {
+    sleep_hooks[pos] = sleep_hooks[pos - 1];
+    pos--;
+  }
+  sleep_hooks[pos] = *hook;
+  sleep_hook_count++;
+  taskEXIT_CRITICAL(&hook_mux);
+
+  ESP_LOGI(TAG, "Sleep hook '%s' registered (priority %d%s)", hook->name,
+           hook->priority, hook->can_veto ? ", can veto" : "");
+  return ESP_OK;
+}
+
+esp_err_t sleep_manager_unregister_hook(const char *name)
+{
+  if (!name)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  esp_err_t ret = ESP_ERR_NOT_FOUND;
+
+  taskENTER_CRITICAL(&hook_mux);
+  for (uint8_t i = 0; i < sleep_hook_count; i++)
+  {
+    if (strcmp(sleep_hooks[i].name, name) == 0)
+    {
+      memmove(&sleep_hooks[i], &sleep_hooks[i + 1],
+              (sleep_hook_count - i - 1) * sizeof(sleep_hooks[0]));
+      sleep_hook_count--;
+      memset(&sleep_hooks[sleep_hook_count], 0, sizeof(sleep_hooks[0]));
+      ret = ESP_OK;
+      break;
+    }
+  }
+  taskEXIT_CRITICAL(&hook_mux);
+
+  return ret;
+}
+
+esp_err_t sleep_manager_set_timer_critical(lv_timer_t *timer)
+{
+  if (!timer)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  for (uint8_t i = 0; i < critical_timer_count; i++)
+  {
+    if (critical_timers[i] == timer)
+    {
+      return ESP_OK;
+    }
+  }
+
+  if (critical_timer_count >= MAX_CRITICAL_TIMERS)
+  {
+    ESP_LOGW(TAG, "Critical timer table full (%d)", MAX_CRITICAL_TIMERS);
+    return ESP_ERR_NO_MEM;
+  }
+
+  critical_timers[critical_timer_count++] = timer;
+  return ESP_OK;
+}
+
+uint32_t sleep_manager_get_wake_latency_ms(void)
+{
+  return wake_latency_last_ms();
+}
+
 #ifdef CONFIG_SLEEP_MANAGER_DEEP_SLEEP_ENABLE
 static void sleep_manager_enter_deep_sleep(void)
 {
@@ -518,6 +1074,8 @@ static void sleep_manager_enter_deep_sleep(void)
 
   last_sleep_type = SLEEP_MANAGER_SLEEP_TYPE_DEEP;
 
+  run_entry_hooks(SLEEP_HOOK_PHASE_ENTER, SLEEP_MANAGER_SLEEP_TYPE_DEEP);
+
 #ifdef CONFIG_SLEEP_MANAGER_GPIO_WAKEUP
 #ifdef CONFIG_SLEEP_MANAGER_TOUCH_WAKEUP
   ESP_LOGI(TAG,
@@ -534,6 +1092,128 @@ static void sleep_manager_enter_deep_sleep(void)
 }
 #endif
 
+#ifdef CONFIG_SLEEP_MANAGER_RTC_TICK_WAKEUP
+// RTC INT pin armed as a wake source for the current sleep, -1 if none
+static int rtc_tick_wake_gpio = -1;
+static rtc_tick_t rtc_tick_awake_rate = RTC_TICK_OFF;
+static uint32_t rtc_tick_wakeups = 0;
+
+/**
+ * @brief Wake on RTC minute edges while in light sleep
+ */
+static void rtc_tick_wakeup_arm(void)
+{
+  rtc_tick_wake_gpio = rtc_tick_get_gpio();
+  if (rtc_tick_wake_gpio < 0)
+  {
+    return;
+  }
+
+  // Minute edges are enough to re-check timeouts; seconds would wake 60x
+  rtc_tick_awake_rate = rtc_tick_get_rate();
+  if (rtc_tick_set_rate(RTC_TICK_MINUTE) != ESP_OK ||
+      rtc_tick_set_wakeup(true) != ESP_OK)
+  {
+    ESP_LOGW(TAG, "RTC tick wake-up unavailable for this sleep");
+    rtc_tick_set_rate(rtc_tick_awake_rate);
+    rtc_tick_wake_gpio = -1;
+  }
+}
+
+static void rtc_tick_wakeup_disarm(void)
+{
+  if (rtc_tick_wake_gpio < 0)
+  {
+    return;
+  }
+
+  rtc_tick_set_wakeup(false);
+  rtc_tick_set_rate(rtc_tick_awake_rate);
+  rtc_tick_wake_gpio = -1;
+}
+
+/**
+ * @brief True if only the RTC INT pin woke the chip
+ */
+static bool rtc_tick_only_wake(void)
+{
+  if (rtc_tick_wake_gpio < 0 ||
+      esp_sleep_get_wakeup_cause() != ESP_SLEEP_WAKEUP_GPIO)
+  {
+    return false;
+  }
+  return esp_sleep_get_gpio_wakeup_status() == (1ULL << rtc_tick_wake_gpio);
+}
+
+/**
+ * @brief Wait for the INT pulse to end so the level wake does not refire
+ */
+static void rtc_tick_wait_release(void)
+{
+  // The pulse is about 16 ms; give up after 50 ms
+  for (int i = 0; i < 5 && gpio_get_level(rtc_tick_wake_gpio) == 0; i++)
+  {
+    vTaskDelay(pdMS_TO_TICKS(10));
+  }
+}
+
+#ifdef CONFIG_SLEEP_MANAGER_DEEP_SLEEP_ENABLE
+/**
+ * @brief Move from light to deep sleep on a tick wake once the timeout passed
+ *
+ * The sleep check task does not run while the chip is in light sleep, so
+ * without this the deep sleep timeout would only be checked after a user
+ * wake. Returns only if deep sleep was not entered.
+ */
+static void rtc_tick_check_deep_sleep(void)
+{
+  if (sleep_manager_get_user_inactive_time() < DEEP_SLEEP_TIMEOUT_MS)
+  {
+    return;
+  }
+
+#ifdef CONFIG_SLEEP_MANAGER_PREVENT_SLEEP_ON_USB
+  if (sleep_manager_is_usb_connected())
+  {
+    return;
+  }
+#endif
+
+  hook_list_t list;
+  hook_list_snapshot(&list);
+  uint8_t rolled_back = 0;
+  if (run_entry_hooks_ex(&list, SLEEP_HOOK_PHASE_PREPARE,
+                         SLEEP_MANAGER_SLEEP_TYPE_DEEP,
+                         &rolled_back) != ESP_OK)
+  {
+    // The veto woke the hooks before it (post_wake), but the chip goes
+    // back to light sleep: take them through light sleep entry again, or
+    // e.g. the watchface data task would poll on every tick wake
+    for (uint8_t i = 0; i < rolled_back; i++)
+    {
+      run_hook(&list.hooks[i], SLEEP_HOOK_PHASE_PREPARE,
+               SLEEP_MANAGER_SLEEP_TYPE_LIGHT);
+    }
+    for (uint8_t i = 0; i < rolled_back; i++)
+    {
+      run_hook(&list.hooks[i], SLEEP_HOOK_PHASE_ENTER,
+               SLEEP_MANAGER_SLEEP_TYPE_LIGHT);
+    }
+
+    // Restart the countdown like the sleep check task does
+    last_user_activity_time = esp_timer_get_time();
+    return;
+  }
+
+  // The pin is not a deep sleep wake source; stop the RTC pulsing INT
+  rtc_tick_set_wakeup(false);
+  rtc_tick_set_rate(RTC_TICK_OFF);
+  rtc_tick_wake_gpio = -1;
+  sleep_manager_enter_deep_sleep();
+}
+#endif
+#endif // CONFIG_SLEEP_MANAGER_RTC_TICK_WAKEUP
+
 esp_err_t sleep_manager_sleep(void)
 {
   if (is_sleeping)
@@ -573,22 +1253,26 @@ esp_err_t sleep_manager_sleep(void)
   log_power_state("sleep_enter");
 #endif
 
-  // Save uptime before sleep to prevent data loss
-  esp_err_t uptime_ret = uptime_tracker_save();
-  if (uptime_ret != ESP_OK)
-  {
-    ESP_LOGW(TAG, "Failed to save uptime before sleep: %s", esp_err_to_name(uptime_ret));
-  }
-  else
+  // Give subsystems a chance to quiesce (or veto) before LVGL shuts down
+  esp_err_t hook_ret =
+      run_entry_hooks(SLEEP_HOOK_PHASE_PREPARE, SLEEP_MANAGER_SLEEP_TYPE_LIGHT);
+  if (hook_ret != ESP_OK)
   {
-    ESP_LOGI(TAG, "Uptime saved before sleep");
+    sleep_manager_reset_timer();
+    return ESP_OK;
   }
+  wake_hook_pending = true;
+  post_wake_hook_pending = true;
+  publish_sleep_event(false);
 
   // Lock LVGL before modifying timers
   if (!sleep_manager_lock_display_with_retry(200, 5, 50))
   {
     ESP_LOGW(TAG, "Failed to acquire display lock - sleep aborted");
     is_sleeping = false;
+    wake_hook_pending = false;
+    post_wake_hook_pending = false;
+    run_wake_hooks(SLEEP_HOOK_PHASE_POST_WAKE, SLEEP_MANAGER_SLEEP_TYPE_LIGHT);
     return ESP_ERR_TIMEOUT;
   }
 
@@ -598,6 +1282,9 @@ esp_err_t sleep_manager_sleep(void)
     ESP_LOGW(TAG, "No LVGL display - sleep aborted");
     bsp_display_unlock();
     is_sleeping = false;
+    wake_hook_pending = false;
+    post_wake_hook_pending = false;
+    run_wake_hooks(SLEEP_HOOK_PHASE_POST_WAKE, SLEEP_MANAGER_SLEEP_TYPE_LIGHT);
     return ESP_ERR_INVALID_STATE;
   }
 
@@ -634,8 +1321,38 @@ esp_err_t sleep_manager_sleep(void)
 
   last_sleep_type = SLEEP_MANAGER_SLEEP_TYPE_LIGHT;
 
+  // Last chance for subsystems (WiFi, ...) before the SoC sleeps
+  run_entry_hooks(SLEEP_HOOK_PHASE_ENTER, SLEEP_MANAGER_SLEEP_TYPE_LIGHT);
+
+#ifdef CONFIG_SLEEP_MANAGER_RTC_TICK_WAKEUP
+  rtc_tick_wakeup_arm();
+#endif
+
   int64_t sleep_start = esp_timer_get_time();
   esp_err_t ret = esp_light_sleep_start();
+
+#ifdef CONFIG_SLEEP_MANAGER_RTC_TICK_WAKEUP
+  // Minute edges only re-check timeouts; go straight back to sleep with the
+  // display off until a real wake source fires
+  while (ret == ESP_OK && rtc_tick_only_wake())
+  {
+    rtc_tick_wakeups++;
+    SLEEP_LOGD(TAG, "RTC tick wake %lu", (unsigned long)rtc_tick_wakeups);
+#ifdef CONFIG_SLEEP_MANAGER_DEEP_SLEEP_ENABLE
+    rtc_tick_check_deep_sleep();
+#endif
+    rtc_tick_wait_release();
+    ret = esp_light_sleep_start();
+  }
+  rtc_tick_wakeup_disarm();
+  if (rtc_tick_wakeups > 0)
+  {
+    ESP_LOGI(TAG, "Slept through %lu RTC minute tick(s)",
+             (unsigned long)rtc_tick_wakeups);
+    rtc_tick_wakeups = 0;
+  }
+#endif
+
   if (ret != ESP_OK)
   {
     ESP_LOGW(TAG, "Light sleep failed: %s", esp_err_to_name(ret));
@@ -647,6 +1364,8 @@ esp_err_t sleep_manager_sleep(void)
 
   // Check wake-up cause
   esp_sleep_wakeup_cause_t cause = esp_sleep_get_wakeup_cause();
+  wake_flush_armed = false;
+  wake_latency_begin(get_wake_latency_source(cause));
   const char *cause_str = "unknown";
 
   switch (cause)
@@ -725,10 +1444,19 @@ esp_err_t sleep_manager_wake(void)
 
   ESP_LOGI(TAG, "Waking from sleep mode...");
 
+  wake_latency_mark(WAKE_LATENCY_STAGE_WAKE_START);
+
 #ifdef CONFIG_SLEEP_MANAGER_POWER_LOGS
   log_power_state("wake_start");
 #endif
 
+  // Wake hooks run once even if the display lock forces a retry
+  if (wake_hook_pending)
+  {
+    wake_hook_pending = false;
+    run_wake_hooks(SLEEP_HOOK_PHASE_WAKE, SLEEP_MANAGER_SLEEP_TYPE_LIGHT);
+  }
+
   // Wake up display
   display_wake();
 
@@ -755,6 +1483,7 @@ esp_err_t sleep_manager_wake(void)
 
   // Resume all LVGL timers
   resume_lvgl_timers();
+  wake_latency_mark(WAKE_LATENCY_STAGE_TIMERS_RESUMED);
 
   bsp_display_unlock();
 
@@ -765,6 +1494,13 @@ esp_err_t sleep_manager_wake(void)
   is_sleeping = false;
 
   ESP_LOGI(TAG, "Wake complete");
+  publish_sleep_event(true);
+
+  if (post_wake_hook_pending)
+  {
+    post_wake_hook_pending = false;
+    run_wake_hooks(SLEEP_HOOK_PHASE_POST_WAKE, SLEEP_MANAGER_SLEEP_TYPE_LIGHT);
+  }
 
 #ifdef CONFIG_SLEEP_MANAGER_POWER_LOGS
   log_power_state("wake_complete");
@@ -26,6 +26,11 @@ extern "C"
 /** Boot button GPIO (hardware button wake source) */
 #define BOOT_BUTTON_GPIO (9)
 
+/** Suggested hook priorities (lower runs first on sleep entry) */
+#define SLEEP_HOOK_PRIORITY_EARLY (-50)
+#define SLEEP_HOOK_PRIORITY_DEFAULT (0)
+#define SLEEP_HOOK_PRIORITY_LATE (50)
+
   typedef enum
   {
     SLEEP_MANAGER_SLEEP_TYPE_NONE = 0,
@@ -33,6 +38,49 @@ extern "C"
     SLEEP_MANAGER_SLEEP_TYPE_DEEP = 2
   } sleep_manager_sleep_type_t;
 
+  /**
+   * @brief Sleep/wake hook phases
+   *
+   * Entry phases (prepare, enter) run in ascending priority order, wake
+   * phases (wake, post_wake) run in descending priority order.
+   */
+  typedef enum
+  {
+    SLEEP_HOOK_PHASE_PREPARE = 0, ///< Before LVGL/display shutdown; may veto
+    SLEEP_HOOK_PHASE_ENTER,       ///< Display off, right before SoC sleep
+    SLEEP_HOOK_PHASE_WAKE,        ///< Right after SoC wake, before display on
+    SLEEP_HOOK_PHASE_POST_WAKE,   ///< After display and LVGL timers resumed
+    SLEEP_HOOK_PHASE_COUNT
+  } sleep_hook_phase_t;
+
+  /**
+   * @brief Sleep/wake hook callback
+   *
+   * @param sleep_type Sleep type being entered or left
+   * @param user_data User data pointer from the hook descriptor
+   * @return ESP_OK to continue; from a vetoing prepare callback any other
+   *         value aborts sleep entry
+   */
+  typedef esp_err_t (*sleep_manager_hook_cb_t)(
+      sleep_manager_sleep_type_t sleep_type, void *user_data);
+
+  /**
+   * @brief Sleep/wake hook descriptor
+   *
+   * Any callback may be NULL. The descriptor is copied on registration.
+   */
+  typedef struct
+  {
+    const char *name;                  ///< Short name used in logs
+    int8_t priority;                   ///< Lower runs first on entry
+    bool can_veto;                     ///< prepare failure aborts sleep
+    sleep_manager_hook_cb_t prepare;   ///< SLEEP_HOOK_PHASE_PREPARE
+    sleep_manager_hook_cb_t enter;     ///< SLEEP_HOOK_PHASE_ENTER
+    sleep_manager_hook_cb_t wake;      ///< SLEEP_HOOK_PHASE_WAKE
+    sleep_manager_hook_cb_t post_wake; ///< SLEEP_HOOK_PHASE_POST_WAKE
+    void *user_data;                   ///< Passed to every callback
+  } sleep_manager_hook_t;
+
 // Only compile if sleep manager is enabled
 #ifdef CONFIG_SLEEP_MANAGER_ENABLE
 
@@ -157,6 +205,61 @@ extern "C"
    */
   bool sleep_manager_get_last_sleep_type(sleep_manager_sleep_type_t *out_type);
 
+  /**
+   * @brief Register a sleep/wake hook
+   *
+   * Hooks are kept sorted by priority (stable for equal priorities). Each
+   * callback is timed; callbacks slower than
+   * CONFIG_SLEEP_MANAGER_HOOK_SLOW_MS are logged as warnings.
+   *
+   * If a hook with can_veto set returns an error from prepare, sleep is
+   * aborted and hooks that already ran prepare receive post_wake so they
+   * can undo their work.
+   *
+   * Safe from any task, also while hooks run; a hook registered during a
+   * transition takes part from the next phase on.
+   *
+   * @param hook Hook descriptor (copied)
+   * @return ESP_OK on success, ESP_ERR_NO_MEM if the hook table is full
+   */
+  esp_err_t sleep_manager_register_hook(const sleep_manager_hook_t *hook);
+
+  /**
+   * @brief Remove a previously registered hook
+   *
+   * Safe from any task. A hook run that already started still calls the
+   * removed hook once, so its user_data must outlive the current sleep or
+   * wake transition.
+   *
+   * @param name Hook name used at registration
+   * @return ESP_OK on success, ESP_ERR_NOT_FOUND if no such hook
+   */
+  esp_err_t sleep_manager_unregister_hook(const char *name);
+
+  /**
+   * @brief Mark an LVGL timer as critical for wake
+   *
+   * Critical timers run on the first frame after wake. Other timers are
+   * released over the following frames when
+   * CONFIG_SLEEP_MANAGER_STAGGERED_RESUME is enabled. Display refresh and
+   * input read timers are always critical.
+   *
+   * @param timer LVGL timer (must stay alive while registered)
+   * @return ESP_OK on success, ESP_ERR_NO_MEM if the table is full
+   */
+  esp_err_t sleep_manager_set_timer_critical(lv_timer_t *timer);
+
+  /**
+   * @brief Get the last measured wake-to-first-frame latency
+   *
+   * The last wake latency sample: light sleep exit until the first frame's
+   * last area is on the panel. Needs
+   * CONFIG_SLEEP_MANAGER_WAKE_LATENCY_STATS.
+   *
+   * @return Latency in milliseconds, 0 if no wake has been measured yet
+   */
+  uint32_t sleep_manager_get_wake_latency_ms(void);
+
 #else // !CONFIG_SLEEP_MANAGER_ENABLE
 
 // Stub functions when sleep manager is disabled
@@ -177,6 +280,23 @@ static inline bool sleep_manager_get_last_sleep_type(
   (void)out_type;
   return false;
 }
+static inline esp_err_t sleep_manager_register_hook(
+    const sleep_manager_hook_t *hook)
+{
+  (void)hook;
+  return ESP_OK;
+}
+static inline esp_err_t sleep_manager_unregister_hook(const char *name)
+{
+  (void)name;
+  return ESP_OK;
+}
+static inline esp_err_t sleep_manager_set_timer_critical(lv_timer_t *timer)
+{
+  (void)timer;
+  return ESP_OK;
+}
+static inline uint32_t sleep_manager_get_wake_latency_ms(void) { return 0; }
 
 #endif // CONFIG_SLEEP_MANAGER_ENABLE
 
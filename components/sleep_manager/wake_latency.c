@@ -0,0 +1,297 @@
+/**
+ * @file wake_latency.c
+ * @brief Touch-to-photon wake latency instrumentation
+ */
+
+#include "wake_latency.h"
+
+#ifdef CONFIG_SLEEP_MANAGER_WAKE_LATENCY_STATS
+
+#include "esp_log.h"
+#include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
+#include <stdio.h>
+#include <string.h>
+
+static const char *TAG = "WakeLatency";
+
+// Exclusive bucket upper bounds (ms); last bucket is open-ended
+static const uint32_t bucket_limits_ms[WAKE_LATENCY_BUCKET_COUNT] = {
+    25, 50, 75, 100, 150, 200, 300, 500, 1000, UINT32_MAX};
+
+static const char *const source_names[WAKE_LATENCY_SOURCE_COUNT] = {
+    "touch", "button", "other"};
+
+static const char *const stage_names[WAKE_LATENCY_STAGE_COUNT] = {
+    "exit", "wake", "timers", "render", "flush"};
+
+// Histograms and current sample, shared between sleep task and LVGL task
+static portMUX_TYPE latency_lock = portMUX_INITIALIZER_UNLOCKED;
+static wake_latency_histogram_t histograms[WAKE_LATENCY_SOURCE_COUNT];
+static int64_t stage_time[WAKE_LATENCY_STAGE_COUNT];
+static wake_latency_source_t current_source = WAKE_LATENCY_SOURCE_OTHER;
+static bool sample_active = false;
+static uint32_t last_sample_ms = 0; // Any source, survives reset
+
+// Last completed sample, until it is logged from a task
+static bool log_pending = false;
+static wake_latency_source_t log_source;
+static uint32_t log_latency_ms;
+static int64_t log_stamps[WAKE_LATENCY_STAGE_COUNT];
+
+static uint8_t bucket_for(uint32_t latency_ms)
+{
+  uint8_t i = 0;
+  while (i < WAKE_LATENCY_BUCKET_COUNT - 1 && latency_ms >= bucket_limits_ms[i])
+  {
+    i++;
+  }
+  return i;
+}
+
+static void record_sample(wake_latency_source_t source, uint32_t latency_ms)
+{
+  wake_latency_histogram_t *h = &histograms[source];
+
+  if (h->count == 0 || latency_ms < h->min_ms)
+  {
+    h->min_ms = latency_ms;
+  }
+  if (latency_ms > h->max_ms)
+  {
+    h->max_ms = latency_ms;
+  }
+  h->last_ms = latency_ms;
+  h->total_ms += latency_ms;
+  h->count++;
+  h->buckets[bucket_for(latency_ms)]++;
+}
+
+/**
+ * @brief Log one completed sample with its per-stage breakdown
+ */
+static void log_sample(wake_latency_source_t source,
+                       const int64_t *stamps, uint32_t latency_ms)
+{
+  char breakdown[96];
+  size_t len = 0;
+  breakdown[0] = '\0';
+
+  for (int i = 1; i < WAKE_LATENCY_STAGE_COUNT && len < sizeof(breakdown); i++)
+  {
+    if (stamps[i] == 0)
+    {
+      continue;
+    }
+    len += snprintf(breakdown + len, sizeof(breakdown) - len, " %s+%lu",
+                    stage_names[i],
+                    (unsigned long)((stamps[i] - stamps[0]) / 1000));
+  }
+
+  if (latency_ms >= CONFIG_SLEEP_MANAGER_WAKE_LATENCY_SLOW_MS)
+  {
+    ESP_LOGW(TAG, "Slow %s wake: %lu ms (%s )", source_names[source],
+             (unsigned long)latency_ms, breakdown);
+  }
+  else
+  {
+    ESP_LOGI(TAG, "%s wake: %lu ms (%s )", source_names[source],
+             (unsigned long)latency_ms, breakdown);
+  }
+}
+
+void wake_latency_begin(wake_latency_source_t source)
+{
+  if (source >= WAKE_LATENCY_SOURCE_COUNT)
+  {
+    source = WAKE_LATENCY_SOURCE_OTHER;
+  }
+
+  int64_t now = esp_timer_get_time();
+
+  taskENTER_CRITICAL(&latency_lock);
+  memset(stage_time, 0, sizeof(stage_time));
+  stage_time[WAKE_LATENCY_STAGE_SLEEP_EXIT] = now;
+  current_source = source;
+  sample_active = true;
+  taskEXIT_CRITICAL(&latency_lock);
+}
+
+/**
+ * @brief Stamp a stage, with latency_lock held
+ *
+ * A completed sample is recorded and left in log_* for
+ * wake_latency_log_pending(), as the caller may be an ISR.
+ */
+static void mark_locked(wake_latency_stage_t stage, int64_t now)
+{
+  if (!sample_active || stage_time[stage] != 0)
+  {
+    return;
+  }
+
+  // First flush only counts once something was rendered after wake
+  if (stage == WAKE_LATENCY_STAGE_FIRST_FLUSH &&
+      stage_time[WAKE_LATENCY_STAGE_FIRST_RENDER] == 0)
+  {
+    return;
+  }
+
+  stage_time[stage] = now;
+  if (stage == WAKE_LATENCY_STAGE_FIRST_FLUSH)
+  {
+    log_source = current_source;
+    log_latency_ms =
+        (uint32_t)((now - stage_time[WAKE_LATENCY_STAGE_SLEEP_EXIT]) / 1000);
+    record_sample(log_source, log_latency_ms);
+    last_sample_ms = log_latency_ms;
+    memcpy(log_stamps, stage_time, sizeof(log_stamps));
+    sample_active = false;
+    log_pending = true;
+  }
+}
+
+void wake_latency_mark(wake_latency_stage_t stage)
+{
+  if (stage >= WAKE_LATENCY_STAGE_COUNT)
+  {
+    return;
+  }
+
+  int64_t now = esp_timer_get_time();
+
+  taskENTER_CRITICAL(&latency_lock);
+  mark_locked(stage, now);
+  taskEXIT_CRITICAL(&latency_lock);
+
+  wake_latency_log_pending();
+}
+
+void wake_latency_mark_from_isr(wake_latency_stage_t stage)
+{
+  if (stage >= WAKE_LATENCY_STAGE_COUNT)
+  {
+    return;
+  }
+
+  int64_t now = esp_timer_get_time();
+
+  taskENTER_CRITICAL_ISR(&latency_lock);
+  mark_locked(stage, now);
+  taskEXIT_CRITICAL_ISR(&latency_lock);
+}
+
+void wake_latency_log_pending(void)
+{
+  int64_t stamps[WAKE_LATENCY_STAGE_COUNT];
+  wake_latency_source_t source;
+  uint32_t latency_ms;
+
+  taskENTER_CRITICAL(&latency_lock);
+  bool pending = log_pending;
+  log_pending = false;
+  source = log_source;
+  latency_ms = log_latency_ms;
+  memcpy(stamps, log_stamps, sizeof(stamps));
+  taskEXIT_CRITICAL(&latency_lock);
+
+  // Log outside the critical section
+  if (pending)
+  {
+    log_sample(source, stamps, latency_ms);
+  }
+}
+
+bool wake_latency_in_progress(void) { return sample_active; }
+
+uint32_t wake_latency_last_ms(void)
+{
+  taskENTER_CRITICAL(&latency_lock);
+  uint32_t latency_ms = last_sample_ms;
+  taskEXIT_CRITICAL(&latency_lock);
+  return latency_ms;
+}
+
+esp_err_t wake_latency_get_histogram(wake_latency_source_t source,
+                                     wake_latency_histogram_t *out)
+{
+  if (!out || source >= WAKE_LATENCY_SOURCE_COUNT)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  taskENTER_CRITICAL(&latency_lock);
+  *out = histograms[source];
+  taskEXIT_CRITICAL(&latency_lock);
+  return ESP_OK;
+}
+
+uint32_t wake_latency_bucket_limit_ms(uint8_t bucket)
+{
+  if (bucket >= WAKE_LATENCY_BUCKET_COUNT)
+  {
+    return UINT32_MAX;
+  }
+  return bucket_limits_ms[bucket];
+}
+
+const char *wake_latency_source_name(wake_latency_source_t source)
+{
+  if (source >= WAKE_LATENCY_SOURCE_COUNT)
+  {
+    return "?";
+  }
+  return source_names[source];
+}
+
+void wake_latency_reset(void)
+{
+  taskENTER_CRITICAL(&latency_lock);
+  memset(histograms, 0, sizeof(histograms));
+  taskEXIT_CRITICAL(&latency_lock);
+  ESP_LOGI(TAG, "Wake latency histograms cleared");
+}
+
+void wake_latency_dump(void)
+{
+  ESP_LOGI(TAG, "=== Wake latency (touch-to-photon) ===");
+
+  for (int s = 0; s < WAKE_LATENCY_SOURCE_COUNT; s++)
+  {
+    wake_latency_histogram_t h;
+    wake_latency_get_histogram((wake_latency_source_t)s, &h);
+
+    if (h.count == 0)
+    {
+      ESP_LOGI(TAG, "%s: no samples", source_names[s]);
+      continue;
+    }
+
+    ESP_LOGI(TAG, "%s: n=%lu min=%lu avg=%lu max=%lu last=%lu ms",
+             source_names[s], (unsigned long)h.count, (unsigned long)h.min_ms,
+             (unsigned long)(h.total_ms / h.count), (unsigned long)h.max_ms,
+             (unsigned long)h.last_ms);
+
+    uint32_t lower = 0;
+    for (int b = 0; b < WAKE_LATENCY_BUCKET_COUNT; b++)
+    {
+      if (h.buckets[b] != 0)
+      {
+        if (bucket_limits_ms[b] == UINT32_MAX)
+        {
+          ESP_LOGI(TAG, "  >=%4lu ms: %lu", (unsigned long)lower,
+                   (unsigned long)h.buckets[b]);
+        }
+        else
+        {
+          ESP_LOGI(TAG, "  %4lu-%4lu ms: %lu", (unsigned long)lower,
+                   (unsigned long)bucket_limits_ms[b],
+                   (unsigned long)h.buckets[b]);
+        }
+      }
+      lower = bucket_limits_ms[b];
+    }
+  }
+}
+
+#endif // CONFIG_SLEEP_MANAGER_WAKE_LATENCY_STATS
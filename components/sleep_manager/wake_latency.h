@@ -0,0 +1,190 @@
+/**
+ * @file wake_latency.h
+ * @brief Touch-to-photon wake latency instrumentation
+ *
+ * Timestamps each stage of the light sleep wake path and keeps a latency
+ * histogram per wake source in RAM. Samples start when
+ * esp_light_sleep_start() returns and end when the panel transfer of the
+ * last area of the first frame after wake has finished.
+ *
+ * Enable via menuconfig:
+ * Component config → App: Sleep Manager → Wake latency statistics
+ */
+
+#ifndef WAKE_LATENCY_H
+#define WAKE_LATENCY_H
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+/** Number of histogram buckets (last bucket is open-ended) */
+#define WAKE_LATENCY_BUCKET_COUNT 10
+
+  /**
+   * @brief Wake source a sample is attributed to
+   */
+  typedef enum
+  {
+    WAKE_LATENCY_SOURCE_TOUCH = 0, ///< Touch interrupt (GPIO15)
+    WAKE_LATENCY_SOURCE_BUTTON,    ///< Boot button (GPIO9)
+    WAKE_LATENCY_SOURCE_OTHER,     ///< Timer, UART or unknown
+    WAKE_LATENCY_SOURCE_COUNT
+  } wake_latency_source_t;
+
+  /**
+   * @brief Wake path stages, in the order they occur
+   */
+  typedef enum
+  {
+    WAKE_LATENCY_STAGE_SLEEP_EXIT = 0, ///< esp_light_sleep_start() returned
+    WAKE_LATENCY_STAGE_WAKE_START,     ///< sleep_manager_wake() entered
+    WAKE_LATENCY_STAGE_TIMERS_RESUMED, ///< LVGL timer handling resumed
+    WAKE_LATENCY_STAGE_FIRST_RENDER,   ///< First frame rendered
+    WAKE_LATENCY_STAGE_FIRST_FLUSH,    ///< First frame's last area on the panel
+    WAKE_LATENCY_STAGE_COUNT
+  } wake_latency_stage_t;
+
+  /**
+   * @brief Latency histogram for one wake source
+   */
+  typedef struct
+  {
+    uint32_t count;                              ///< Number of samples
+    uint32_t min_ms;                             ///< Fastest wake
+    uint32_t max_ms;                             ///< Slowest wake
+    uint32_t last_ms;                            ///< Most recent wake
+    uint64_t total_ms;                           ///< Sum, for the average
+    uint32_t buckets[WAKE_LATENCY_BUCKET_COUNT]; ///< Sample counts
+  } wake_latency_histogram_t;
+
+#ifdef CONFIG_SLEEP_MANAGER_WAKE_LATENCY_STATS
+
+  /**
+   * @brief Start a new sample (call when light sleep returns)
+   *
+   * @param source Wake source the sample is attributed to
+   */
+  void wake_latency_begin(wake_latency_source_t source);
+
+  /**
+   * @brief Timestamp a wake path stage of the current sample
+   *
+   * Ignored when no sample is in progress or the stage was already marked.
+   * Marking WAKE_LATENCY_STAGE_FIRST_FLUSH completes the sample.
+   *
+   * @param stage Stage reached
+   */
+  void wake_latency_mark(wake_latency_stage_t stage);
+
+  /**
+   * @brief wake_latency_mark() for interrupt context
+   *
+   * A sample completed here is logged by the next
+   * wake_latency_log_pending() or wake_latency_mark() call.
+   *
+   * @param stage Stage reached
+   */
+  void wake_latency_mark_from_isr(wake_latency_stage_t stage);
+
+  /**
+   * @brief Log a sample completed from interrupt context, if any
+   */
+  void wake_latency_log_pending(void);
+
+  /**
+   * @brief Check whether a sample is waiting for its first frame
+   */
+  bool wake_latency_in_progress(void);
+
+  /**
+   * @brief Latency of the last completed sample, any source
+   *
+   * @return Milliseconds, 0 before the first sample
+   */
+  uint32_t wake_latency_last_ms(void);
+
+  /**
+   * @brief Copy the histogram of one wake source
+   *
+   * @param source Wake source
+   * @param out Output histogram
+   * @return ESP_OK on success, ESP_ERR_INVALID_ARG on bad arguments
+   */
+  esp_err_t wake_latency_get_histogram(wake_latency_source_t source,
+                                       wake_latency_histogram_t *out);
+
+  /**
+   * @brief Upper bound of a histogram bucket
+   *
+   * @param bucket Bucket index
+   * @return Exclusive upper bound in ms, UINT32_MAX for the last bucket
+   */
+  uint32_t wake_latency_bucket_limit_ms(uint8_t bucket);
+
+  /**
+   * @brief Short display name of a wake source
+   */
+  const char *wake_latency_source_name(wake_latency_source_t source);
+
+  /**
+   * @brief Clear all histograms
+   */
+  void wake_latency_reset(void);
+
+  /**
+   * @brief Print all histograms to the serial log
+   */
+  void wake_latency_dump(void);
+
+#else // !CONFIG_SLEEP_MANAGER_WAKE_LATENCY_STATS
+
+static inline void wake_latency_begin(wake_latency_source_t source)
+{
+  (void)source;
+}
+static inline void wake_latency_mark(wake_latency_stage_t stage)
+{
+  (void)stage;
+}
+static inline void wake_latency_mark_from_isr(wake_latency_stage_t stage)
+{
+  (void)stage;
+}
+static inline void wake_latency_log_pending(void) {}
+static inline bool wake_latency_in_progress(void) { return false; }
+static inline uint32_t wake_latency_last_ms(void) { return 0; }
+static inline esp_err_t wake_latency_get_histogram(
+    wake_latency_source_t source, wake_latency_histogram_t *out)
+{
+  (void)source;
+  (void)out;
+  return ESP_ERR_NOT_SUPPORTED;
+}
+static inline uint32_t wake_latency_bucket_limit_ms(uint8_t bucket)
+{
+  (void)bucket;
+  return 0;
+}
+static inline const char *wake_latency_source_name(
+    wake_latency_source_t source)
+{
+  (void)source;
+  return "";
+}
+static inline void wake_latency_reset(void) {}
+static inline void wake_latency_dump(void) {}
+
+#endif // CONFIG_SLEEP_MANAGER_WAKE_LATENCY_STATS
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WAKE_LATENCY_H
@@ -1,70 +1,333 @@
 /**
  * @file uptime_tracker.c
  * @brief Uptime Tracking Component Implementation
+ *
+ * The running counters live in RTC memory (RTC_NOINIT), which survives
+ * light sleep, deep sleep and software resets. Flash is only written every
+ * CONFIG_UPTIME_TRACKER_PERSIST_INTERVAL_HOURS, on low battery, before a
+ * restart and once per real boot. Records are appended to a ring of
+ * fixed-size slots in the storage partition; each carries a sequence number
+ * and CRC, and loading picks the newest valid slot, so a write interrupted
+ * by power loss costs at most one interval.
  */
 
 #include "uptime_tracker.h"
+#include "esp_attr.h"
 #include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include "esp_rtc_time.h"
+#include "esp_system.h"
 #include "esp_timer.h"
+#include "freertos/FreeRTOS.h"
 #include "nvs.h"
 #include "nvs_flash.h"
+#include "sdkconfig.h"
+#include <stddef.h>
 #include <string.h>
 
 static const char *TAG = "UptimeTracker";
 
-// NVS namespace for uptime storage
+// Legacy NVS keys (read once to migrate, erased on reset)
 #define NVS_NAMESPACE "uptime"
 #define NVS_KEY_TOTAL_UPTIME "total_up"
 #define NVS_KEY_BOOT_COUNT "boot_cnt"
 
+#define RING_PARTITION_LABEL "storage"
+#define RING_SECTOR_SIZE 4096
+#define RING_SECTORS 2
+#define RING_SLOT_SIZE 32
+#define RING_SLOTS_PER_SECTOR (RING_SECTOR_SIZE / RING_SLOT_SIZE)
+#define RING_SLOTS (RING_SECTORS * RING_SLOTS_PER_SECTOR)
+
+#define RECORD_MAGIC 0x52545055 // "UPTR"
+#define RTC_STATE_MAGIC 0x43525455 // "UTRC"
+#define RTC_STATE_VERSION 1
+
+// Defaults when the tracker options are hidden in menuconfig
+#ifndef CONFIG_UPTIME_TRACKER_PERSIST_INTERVAL_HOURS
+#define CONFIG_UPTIME_TRACKER_PERSIST_INTERVAL_HOURS 6
+#endif
+#ifndef CONFIG_UPTIME_TRACKER_LOW_BATTERY_PERCENT
+#define CONFIG_UPTIME_TRACKER_LOW_BATTERY_PERCENT 5
+#endif
+#ifndef CONFIG_UPTIME_TRACKER_RING_OFFSET
+#define CONFIG_UPTIME_TRACKER_RING_OFFSET 0x10000
+#endif
+
+#define US_PER_SEC 1000000ULL
+#define PERSIST_INTERVAL_US                                                    \
+  ((uint64_t)CONFIG_UPTIME_TRACKER_PERSIST_INTERVAL_HOURS * 3600 * US_PER_SEC)
+
+/** One flash slot; a blank slot reads as all 0xFF */
+typedef struct {
+  uint32_t magic;
+  uint32_t sequence;
+  uint32_t boot_count;
+  uint32_t awake_sec; ///< Total awake time across boots
+  uint32_t sleep_sec; ///< Total sleep time across boots
+  uint32_t reserved[2];
+  uint32_t crc; ///< CRC32 of all fields above
+} uptime_record_t;
+
+_Static_assert(sizeof(uptime_record_t) == RING_SLOT_SIZE, "ring slot size");
+_Static_assert(CONFIG_UPTIME_TRACKER_RING_OFFSET % RING_SECTOR_SIZE == 0,
+               "uptime ring offset must be sector aligned");
+
+/** Running counters, retained in RTC memory */
+typedef struct {
+  uint32_t magic;
+  uint32_t version;
+  uint32_t boot_count;
+  uint32_t sequence;         ///< Sequence of the last flash record
+  uint64_t total_awake_us;   ///< Across all boots
+  uint64_t total_sleep_us;
+  uint64_t session_awake_us; ///< Since the last reset (deep sleep continues)
+  uint64_t session_sleep_us;
+  uint64_t persisted_us;     ///< total awake + sleep at the last flash write
+  uint64_t deep_sleep_rtc_us; ///< RTC time at deep sleep entry, 0 if none
+  uint32_t crc;              ///< CRC32 of all fields above
+} uptime_rtc_state_t;
+
+RTC_NOINIT_ATTR static uptime_rtc_state_t rtc_state;
+
 // Internal state
 static bool initialized = false;
-static uint64_t total_uptime_seconds = 0;
-static uint64_t session_start_time_us = 0;
-static uint32_t boot_count = 0;
-static uint32_t last_save_time_sec = 0;
+static int64_t last_tick_us = 0; // esp_timer time accounted up to
+static bool asleep = false;
+static bool low_battery_flushed = false;
+static portMUX_TYPE state_mux = portMUX_INITIALIZER_UNLOCKED;
+
+static const esp_partition_t *ring_part = NULL;
+static uint32_t ring_next_slot = 0;
+
+static uint32_t rtc_state_crc(void) {
+  return esp_rom_crc32_le(0, (const uint8_t *)&rtc_state,
+                          offsetof(uptime_rtc_state_t, crc));
+}
+
+static bool rtc_state_valid(void) {
+  return rtc_state.magic == RTC_STATE_MAGIC &&
+         rtc_state.version == RTC_STATE_VERSION &&
+         rtc_state.crc == rtc_state_crc();
+}
+
+static uint32_t record_crc(const uptime_record_t *rec) {
+  return esp_rom_crc32_le(0, (const uint8_t *)rec,
+                          offsetof(uptime_record_t, crc));
+}
 
 /**
- * @brief Load uptime data from NVS
+ * @brief Add esp_timer time since the last call to the awake or sleep total
+ *
+ * esp_timer keeps counting across light sleep, so the delta spanning a
+ * light sleep is the sleep duration.
  */
-static esp_err_t load_from_nvs(void) {
-  nvs_handle_t nvs_handle;
-  esp_err_t ret;
+static void account_locked(void) {
+  int64_t now = esp_timer_get_time();
+  uint64_t delta = (uint64_t)(now - last_tick_us);
+  last_tick_us = now;
+
+  if (asleep) {
+    rtc_state.total_sleep_us += delta;
+    rtc_state.session_sleep_us += delta;
+  } else {
+    rtc_state.total_awake_us += delta;
+    rtc_state.session_awake_us += delta;
+  }
+  rtc_state.crc = rtc_state_crc();
+}
 
-  // Open NVS
-  ret = nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle);
-  if (ret == ESP_ERR_NVS_NOT_FOUND) {
-    ESP_LOGI(TAG, "No stored uptime data found (first boot)");
-    total_uptime_seconds = 0;
-    boot_count = 0;
-    return ESP_OK;
-  } else if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(ret));
-    return ret;
+static void account(void) {
+  portENTER_CRITICAL(&state_mux);
+  account_locked();
+  portEXIT_CRITICAL(&state_mux);
+}
+
+static bool slot_blank(uint32_t slot) {
+  uint32_t words[RING_SLOT_SIZE / 4];
+  if (esp_partition_read(ring_part,
+                         CONFIG_UPTIME_TRACKER_RING_OFFSET + slot * RING_SLOT_SIZE,
+                         words, sizeof(words)) != ESP_OK) {
+    return false;
+  }
+  for (size_t i = 0; i < RING_SLOT_SIZE / 4; i++) {
+    if (words[i] != 0xFFFFFFFF) {
+      return false;
+    }
   }
+  return true;
+}
+
+/**
+ * @brief Find the ring and its newest valid record
+ *
+ * @param[out] latest Newest record, if found
+ * @return true if a valid record was found
+ */
+static bool ring_load(uptime_record_t *latest) {
+  ring_part = esp_partition_find_first(ESP_PARTITION_TYPE_DATA,
+                                       ESP_PARTITION_SUBTYPE_ANY,
+                                       RING_PARTITION_LABEL);
+  if (!ring_part ||
+      ring_part->size < CONFIG_UPTIME_TRACKER_RING_OFFSET +
+                            RING_SECTORS * RING_SECTOR_SIZE) {
+    ESP_LOGW(TAG, "No room for uptime ring in '%s' partition",
+             RING_PARTITION_LABEL);
+    ring_part = NULL;
+    return false;
+  }
+
+  bool found = false;
+  uint32_t latest_slot = 0;
+
+  for (uint32_t slot = 0; slot < RING_SLOTS; slot++) {
+    uptime_record_t rec;
+    if (esp_partition_read(ring_part,
+                           CONFIG_UPTIME_TRACKER_RING_OFFSET +
+                               slot * RING_SLOT_SIZE,
+                           &rec, sizeof(rec)) != ESP_OK) {
+      continue;
+    }
+    if (rec.magic != RECORD_MAGIC || rec.crc != record_crc(&rec)) {
+      continue;
+    }
+    // Wrap-safe comparison of sequence numbers
+    if (!found || (int32_t)(rec.sequence - latest->sequence) > 0) {
+      *latest = rec;
+      latest_slot = slot;
+      found = true;
+    }
+  }
+
+  ring_next_slot = found ? (latest_slot + 1) % RING_SLOTS : 0;
+  return found;
+}
 
-  // Read total uptime
-  ret = nvs_get_u64(nvs_handle, NVS_KEY_TOTAL_UPTIME, &total_uptime_seconds);
-  if (ret != ESP_OK && ret != ESP_ERR_NVS_NOT_FOUND) {
-    ESP_LOGW(TAG, "Failed to read total uptime: %s", esp_err_to_name(ret));
-    total_uptime_seconds = 0;
+/**
+ * @brief Append a record to the ring, erasing the next sector when entered
+ */
+static esp_err_t ring_append(const uptime_record_t *rec) {
+  if (!ring_part) {
+    return ESP_ERR_NOT_FOUND;
   }
 
-  // Read boot count
-  ret = nvs_get_u32(nvs_handle, NVS_KEY_BOOT_COUNT, &boot_count);
-  if (ret != ESP_OK && ret != ESP_ERR_NVS_NOT_FOUND) {
-    ESP_LOGW(TAG, "Failed to read boot count: %s", esp_err_to_name(ret));
-    boot_count = 0;
+  for (uint32_t tries = 0; tries < RING_SLOTS; tries++) {
+    uint32_t slot = ring_next_slot;
+
+    if (slot % RING_SLOTS_PER_SECTOR == 0) {
+      // Entering a sector: it holds the oldest records
+      size_t sector = CONFIG_UPTIME_TRACKER_RING_OFFSET +
+                      (slot / RING_SLOTS_PER_SECTOR) * RING_SECTOR_SIZE;
+      esp_err_t ret =
+          esp_partition_erase_range(ring_part, sector, RING_SECTOR_SIZE);
+      if (ret != ESP_OK) {
+        ESP_LOGE(TAG, "Failed to erase ring sector: %s", esp_err_to_name(ret));
+        return ret;
+      }
+    } else if (!slot_blank(slot)) {
+      // Left dirty by an interrupted write
+      ring_next_slot = (slot + 1) % RING_SLOTS;
+      continue;
+    }
+
+    ring_next_slot = (slot + 1) % RING_SLOTS;
+    return esp_partition_write(
+        ring_part, CONFIG_UPTIME_TRACKER_RING_OFFSET + slot * RING_SLOT_SIZE,
+        rec, sizeof(*rec));
   }
 
+  return ESP_FAIL;
+}
+
+/**
+ * @brief Read pre-ring NVS counters so upgrading keeps the totals
+ */
+static void load_legacy_nvs(uint64_t *total_sec, uint32_t *boots) {
+  nvs_handle_t nvs_handle;
+  *total_sec = 0;
+  *boots = 0;
+
+  if (nvs_open(NVS_NAMESPACE, NVS_READONLY, &nvs_handle) != ESP_OK) {
+    return;
+  }
+  nvs_get_u64(nvs_handle, NVS_KEY_TOTAL_UPTIME, total_sec);
+  nvs_get_u32(nvs_handle, NVS_KEY_BOOT_COUNT, boots);
   nvs_close(nvs_handle);
 
-  ESP_LOGI(TAG, "Loaded from NVS: Total uptime=%llu sec, Boot count=%lu",
-           total_uptime_seconds, boot_count);
+  if (*total_sec || *boots) {
+    ESP_LOGI(TAG, "Migrating NVS uptime: %llu sec, %lu boots", *total_sec,
+             *boots);
+  }
+}
+
+/**
+ * @brief Rebuild the RTC state from flash after power loss
+ */
+static void restore_from_flash(void) {
+  uptime_record_t rec;
+  memset(&rtc_state, 0, sizeof(rtc_state));
+  rtc_state.magic = RTC_STATE_MAGIC;
+  rtc_state.version = RTC_STATE_VERSION;
+
+  if (ring_load(&rec)) {
+    rtc_state.boot_count = rec.boot_count;
+    rtc_state.sequence = rec.sequence;
+    rtc_state.total_awake_us = (uint64_t)rec.awake_sec * US_PER_SEC;
+    rtc_state.total_sleep_us = (uint64_t)rec.sleep_sec * US_PER_SEC;
+    ESP_LOGI(TAG, "Loaded record #%lu: awake=%lu sec, sleep=%lu sec, boots=%lu",
+             rec.sequence, rec.awake_sec, rec.sleep_sec, rec.boot_count);
+  } else {
+    uint64_t total_sec;
+    uint32_t boots;
+    load_legacy_nvs(&total_sec, &boots);
+    rtc_state.boot_count = boots;
+    rtc_state.total_awake_us = total_sec * US_PER_SEC;
+  }
+
+  rtc_state.persisted_us = rtc_state.total_awake_us + rtc_state.total_sleep_us;
+}
+
+static esp_err_t persist(void) {
+  uptime_record_t rec = {0};
+
+  portENTER_CRITICAL(&state_mux);
+  account_locked();
+  rec.magic = RECORD_MAGIC;
+  rec.sequence = rtc_state.sequence + 1;
+  rec.boot_count = rtc_state.boot_count;
+  rec.awake_sec = (uint32_t)(rtc_state.total_awake_us / US_PER_SEC);
+  rec.sleep_sec = (uint32_t)(rtc_state.total_sleep_us / US_PER_SEC);
+  portEXIT_CRITICAL(&state_mux);
+
+  memset(rec.reserved, 0, sizeof(rec.reserved));
+  rec.crc = record_crc(&rec);
+
+  esp_err_t ret = ring_append(&rec);
+  if (ret != ESP_OK) {
+    ESP_LOGE(TAG, "Failed to write uptime record: %s", esp_err_to_name(ret));
+    return ret;
+  }
+
+  portENTER_CRITICAL(&state_mux);
+  rtc_state.sequence = rec.sequence;
+  rtc_state.persisted_us = rtc_state.total_awake_us + rtc_state.total_sleep_us;
+  rtc_state.crc = rtc_state_crc();
+  portEXIT_CRITICAL(&state_mux);
 
+#ifdef CONFIG_UPTIME_TRACKER_DEBUG_LOGS
+  ESP_LOGI(TAG, "Persisted record #%lu (slot %lu)", rec.sequence,
+           (ring_next_slot + RING_SLOTS - 1) % RING_SLOTS);
+#endif
   return ESP_OK;
 }
 
+static void shutdown_handler(void) {
+  if (initialized) {
+    persist();
+  }
+}
+
 esp_err_t uptime_tracker_init(void) {
   if (initialized) {
     ESP_LOGW(TAG, "Already initialized");
@@ -73,7 +336,7 @@ esp_err_t uptime_tracker_init(void) {
 
   ESP_LOGI(TAG, "Initializing uptime tracker");
 
-  // Initialize NVS if not already done
+  // Initialize NVS if not already done (legacy counters live there)
   esp_err_t ret = nvs_flash_init();
   if (ret == ESP_ERR_NVS_NO_FREE_PAGES ||
       ret == ESP_ERR_NVS_NEW_VERSION_FOUND) {
@@ -87,25 +350,52 @@ esp_err_t uptime_tracker_init(void) {
     return ret;
   }
 
-  // Load stored uptime data
-  ret = load_from_nvs();
-  if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "Failed to load uptime data");
-    return ret;
+  bool deep_sleep_wake = false;
+  if (!rtc_state_valid()) {
+    // Power-on: RTC memory is garbage, flash is the only source
+    restore_from_flash();
+  } else {
+    // Locate the next free slot and keep sequence numbers increasing
+    uptime_record_t latest;
+    if (ring_load(&latest) &&
+        (int32_t)(latest.sequence - rtc_state.sequence) > 0) {
+      rtc_state.sequence = latest.sequence;
+    }
+
+    if (esp_reset_reason() == ESP_RST_DEEPSLEEP &&
+        rtc_state.deep_sleep_rtc_us != 0) {
+      // The RTC timer keeps running in deep sleep, esp_timer does not
+      uint64_t now_rtc = esp_rtc_get_time_us();
+      if (now_rtc > rtc_state.deep_sleep_rtc_us) {
+        uint64_t slept = now_rtc - rtc_state.deep_sleep_rtc_us;
+        rtc_state.total_sleep_us += slept;
+        rtc_state.session_sleep_us += slept;
+      }
+      deep_sleep_wake = true;
+    }
   }
+  rtc_state.deep_sleep_rtc_us = 0;
 
-  // Increment boot counter
-  boot_count++;
-
-  // Record session start time
-  session_start_time_us = esp_timer_get_time();
+  // Deep sleep wake-ups continue the session; anything else is a new boot
+  if (!deep_sleep_wake) {
+    rtc_state.boot_count++;
+    rtc_state.session_awake_us = 0;
+    rtc_state.session_sleep_us = 0;
+  }
+  rtc_state.crc = rtc_state_crc();
 
+  // Time since reset counts as awake
+  last_tick_us = 0;
+  asleep = false;
   initialized = true;
 
-  ESP_LOGI(TAG, "Uptime tracker initialized (Boot #%lu)", boot_count);
+  esp_register_shutdown_handler(shutdown_handler);
 
-  // Save the incremented boot count immediately
-  return uptime_tracker_save();
+  ESP_LOGI(TAG, "Uptime tracker initialized (Boot #%lu%s)",
+           rtc_state.boot_count, deep_sleep_wake ? ", deep sleep wake" : "");
+
+  // Record real boots right away; boot count is the reliability metric
+  return deep_sleep_wake ? ESP_OK : persist();
 }
 
 void uptime_tracker_update(void) {
@@ -113,8 +403,7 @@ void uptime_tracker_update(void) {
     return;
   }
 
-  // This function is called frequently, so it's lightweight
-  // Actual calculation happens in get_stats()
+  uptime_tracker_save();
 }
 
 esp_err_t uptime_tracker_save(void) {
@@ -123,51 +412,66 @@ esp_err_t uptime_tracker_save(void) {
     return ESP_ERR_INVALID_STATE;
   }
 
-  nvs_handle_t nvs_handle;
-  esp_err_t ret;
+  account();
 
-  // Calculate current total uptime
-  uint64_t current_session_sec =
-      (esp_timer_get_time() - session_start_time_us) / 1000000ULL;
-  uint64_t current_total = total_uptime_seconds + current_session_sec;
+  uint64_t total = rtc_state.total_awake_us + rtc_state.total_sleep_us;
+  if (total - rtc_state.persisted_us < PERSIST_INTERVAL_US) {
+    return ESP_OK; // RTC memory is enough until the interval elapses
+  }
 
-  // Open NVS for writing
-  ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
-  if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "Failed to open NVS for writing: %s", esp_err_to_name(ret));
-    return ret;
+  return persist();
+}
+
+esp_err_t uptime_tracker_flush(void) {
+  if (!initialized) {
+    ESP_LOGE(TAG, "Not initialized");
+    return ESP_ERR_INVALID_STATE;
   }
 
-  // Save total uptime
-  ret = nvs_set_u64(nvs_handle, NVS_KEY_TOTAL_UPTIME, current_total);
-  if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "Failed to write total uptime: %s", esp_err_to_name(ret));
-    nvs_close(nvs_handle);
-    return ret;
+  return persist();
+}
+
+void uptime_tracker_set_battery(uint8_t percent, bool charging) {
+  if (!initialized) {
+    return;
   }
 
-  // Save boot count
-  ret = nvs_set_u32(nvs_handle, NVS_KEY_BOOT_COUNT, boot_count);
-  if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "Failed to write boot count: %s", esp_err_to_name(ret));
-    nvs_close(nvs_handle);
-    return ret;
+  if (charging || percent > CONFIG_UPTIME_TRACKER_LOW_BATTERY_PERCENT) {
+    low_battery_flushed = false;
+    return;
   }
 
-  // Commit changes
-  ret = nvs_commit(nvs_handle);
-  if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "Failed to commit NVS: %s", esp_err_to_name(ret));
+  if (!low_battery_flushed) {
+    ESP_LOGI(TAG, "Battery at %u%%, saving uptime", percent);
+    low_battery_flushed = (persist() == ESP_OK);
   }
+}
 
-  nvs_close(nvs_handle);
+void uptime_tracker_sleep_enter(bool deep) {
+  if (!initialized) {
+    return;
+  }
 
-  last_save_time_sec = (uint32_t)current_session_sec;
+  portENTER_CRITICAL(&state_mux);
+  account_locked();
+  asleep = true;
+  if (deep) {
+    rtc_state.deep_sleep_rtc_us = esp_rtc_get_time_us();
+  }
+  rtc_state.crc = rtc_state_crc();
+  portEXIT_CRITICAL(&state_mux);
+}
 
-  ESP_LOGD(TAG, "Saved uptime: Total=%llu sec, Boot count=%lu", current_total,
-           boot_count);
+void uptime_tracker_sleep_exit(void) {
+  if (!initialized) {
+    return;
+  }
 
-  return ret;
+  portENTER_CRITICAL(&state_mux);
+  account_locked();
+  asleep = false;
+  rtc_state.crc = rtc_state_crc();
+  portEXIT_CRITICAL(&state_mux);
 }
 
 esp_err_t uptime_tracker_get_stats(uptime_stats_t *stats) {
@@ -181,13 +485,20 @@ esp_err_t uptime_tracker_get_stats(uptime_stats_t *stats) {
     return ESP_ERR_INVALID_ARG;
   }
 
-  // Calculate current session uptime
-  uint64_t current_session_sec =
-      (esp_timer_get_time() - session_start_time_us) / 1000000ULL;
-
-  stats->current_uptime_sec = current_session_sec;
-  stats->total_uptime_sec = total_uptime_seconds + current_session_sec;
-  stats->boot_count = boot_count;
+  portENTER_CRITICAL(&state_mux);
+  account_locked();
+  uptime_rtc_state_t snap = rtc_state;
+  portEXIT_CRITICAL(&state_mux);
+
+  stats->current_awake_sec = snap.session_awake_us / US_PER_SEC;
+  stats->current_sleep_sec = snap.session_sleep_us / US_PER_SEC;
+  stats->current_uptime_sec =
+      (snap.session_awake_us + snap.session_sleep_us) / US_PER_SEC;
+  stats->total_awake_sec = snap.total_awake_us / US_PER_SEC;
+  stats->total_sleep_sec = snap.total_sleep_us / US_PER_SEC;
+  stats->total_uptime_sec =
+      (snap.total_awake_us + snap.total_sleep_us) / US_PER_SEC;
+  stats->boot_count = snap.boot_count;
   stats->last_boot_time = 0; // Not tracking RTC time for now
 
   return ESP_OK;
@@ -218,31 +529,35 @@ esp_err_t uptime_tracker_reset(void) {
   nvs_handle_t nvs_handle;
   esp_err_t ret;
 
-  // Open NVS
+  // Drop legacy NVS counters so they are not migrated again
   ret = nvs_open(NVS_NAMESPACE, NVS_READWRITE, &nvs_handle);
-  if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "Failed to open NVS: %s", esp_err_to_name(ret));
-    return ret;
-  }
-
-  // Erase all keys in namespace
-  ret = nvs_erase_all(nvs_handle);
-  if (ret != ESP_OK) {
-    ESP_LOGE(TAG, "Failed to erase NVS: %s", esp_err_to_name(ret));
+  if (ret == ESP_OK) {
+    nvs_erase_all(nvs_handle);
+    nvs_commit(nvs_handle);
     nvs_close(nvs_handle);
-    return ret;
   }
 
-  // Commit changes
-  ret = nvs_commit(nvs_handle);
-  nvs_close(nvs_handle);
+  if (ring_part) {
+    ret = esp_partition_erase_range(ring_part,
+                                    CONFIG_UPTIME_TRACKER_RING_OFFSET,
+                                    RING_SECTORS * RING_SECTOR_SIZE);
+    if (ret != ESP_OK) {
+      ESP_LOGE(TAG, "Failed to erase uptime ring: %s", esp_err_to_name(ret));
+      return ret;
+    }
+    ring_next_slot = 0;
+  }
 
   // Reset internal state
-  total_uptime_seconds = 0;
-  boot_count = 0;
-  session_start_time_us = esp_timer_get_time();
+  portENTER_CRITICAL(&state_mux);
+  memset(&rtc_state, 0, sizeof(rtc_state));
+  rtc_state.magic = RTC_STATE_MAGIC;
+  rtc_state.version = RTC_STATE_VERSION;
+  last_tick_us = esp_timer_get_time();
+  rtc_state.crc = rtc_state_crc();
+  portEXIT_CRITICAL(&state_mux);
 
   ESP_LOGI(TAG, "Uptime data reset complete");
 
-  return ret;
+  return ESP_OK;
 }
@@ -2,7 +2,9 @@
  * @file uptime_tracker.h
  * @brief Uptime Tracking Component for ESP32-C6 Watch
  *
- * Tracks device uptime across reboots using NVS storage.
+ * Tracks device uptime across reboots, split into awake and sleep time.
+ * Counters are kept in RTC memory and written to flash rarely (see
+ * CONFIG_UPTIME_TRACKER_PERSIST_INTERVAL_HOURS).
  * Useful for battery consumption testing and reliability monitoring.
  */
 
@@ -23,6 +25,10 @@ extern "C" {
 typedef struct {
   uint64_t total_uptime_sec;   ///< Total uptime across all boots (seconds)
   uint64_t current_uptime_sec; ///< Current session uptime (seconds)
+  uint64_t total_awake_sec;    ///< Part of total_uptime_sec spent awake
+  uint64_t total_sleep_sec;    ///< Part of total_uptime_sec spent asleep
+  uint64_t current_awake_sec;  ///< Part of current_uptime_sec spent awake
+  uint64_t current_sleep_sec;  ///< Part of current_uptime_sec spent asleep
   uint32_t boot_count;         ///< Number of times device has booted
   uint32_t last_boot_time;     ///< Unix timestamp of last boot (if available)
 } uptime_stats_t;
@@ -30,7 +36,9 @@ typedef struct {
 /**
  * @brief Initialize uptime tracker
  *
- * Loads stored uptime data from NVS and increments boot counter.
+ * Continues from RTC memory after deep sleep or a software reset, or loads
+ * the newest flash record after power loss. Increments the boot counter
+ * (deep sleep wake-ups continue the session and are not counted as boots).
  * Must be called once at startup.
  *
  * @return ESP_OK on success, error code otherwise
@@ -41,20 +49,55 @@ esp_err_t uptime_tracker_init(void);
  * @brief Update uptime counters
  *
  * Should be called periodically (e.g., every second) to update counters.
- * This function is lightweight and safe to call frequently.
+ * Lightweight; writes flash only when the persist interval has elapsed.
  */
 void uptime_tracker_update(void);
 
 /**
- * @brief Save current uptime to NVS
+ * @brief Checkpoint uptime
  *
- * Persists current uptime data to NVS. Should be called periodically
- * (e.g., every 60 seconds) or before entering deep sleep.
+ * Updates the RTC copy and writes a flash record if the last one is older
+ * than CONFIG_UPTIME_TRACKER_PERSIST_INTERVAL_HOURS.
  *
  * @return ESP_OK on success, error code otherwise
  */
 esp_err_t uptime_tracker_save(void);
 
+/**
+ * @brief Write a flash record now
+ *
+ * Used before power may be lost. Called automatically from esp_restart().
+ *
+ * @return ESP_OK on success, error code otherwise
+ */
+esp_err_t uptime_tracker_flush(void);
+
+/**
+ * @brief Report battery level
+ *
+ * Flushes once when the battery drops to
+ * CONFIG_UPTIME_TRACKER_LOW_BATTERY_PERCENT while discharging.
+ *
+ * @param percent Battery level
+ * @param charging True while charging (re-arms the low battery flush)
+ */
+void uptime_tracker_set_battery(uint8_t percent, bool charging);
+
+/**
+ * @brief Start counting sleep time
+ *
+ * Call right before light or deep sleep.
+ *
+ * @param deep True for deep sleep (duration is measured with the RTC timer
+ *             on the next boot)
+ */
+void uptime_tracker_sleep_enter(bool deep);
+
+/**
+ * @brief Stop counting sleep time (call after light sleep returns)
+ */
+void uptime_tracker_sleep_exit(void);
+
 /**
  * @brief Get current uptime statistics
  *
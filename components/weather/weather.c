@@ -0,0 +1,349 @@
+/**
+ * @file weather.c
+ * @brief Cached weather forecast implementation
+ */
+
+#include "weather.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "esp_timer.h"
+#include "event_bus.h"
+#include "freertos/FreeRTOS.h"
+#include "net_http.h"
+#include "sdkconfig.h"
+#include "settings_storage.h"
+#include <stddef.h>
+#include <stdlib.h>
+#include <string.h>
+#include <time.h>
+
+#ifdef CONFIG_WEATHER_ENABLE
+
+static const char *TAG = "weather";
+
+#define CACHE_MAGIC 0x31435857 // "WXC1"
+
+// Settings keys; the fetch time is written last and erased first
+#define CACHE_TIME_KEY "wx_time"
+#define CACHE_NOW_KEY "wx_now"
+#define CACHE_DAY_KEY "wx_day"
+
+#define READ_CHUNK 256
+#define HTTP_TIMEOUT_MS 10000
+
+// Before this the wall clock has not been set (2024-01-01)
+#define CLOCK_VALID_AFTER 1704067200
+
+#define INTERVAL_S ((uint32_t)CONFIG_WEATHER_INTERVAL_MIN * 60)
+#define SHARE_WAIT_S ((uint32_t)CONFIG_WEATHER_SHARE_WAIT_MIN * 60)
+#define MAX_AGE_S ((uint32_t)CONFIG_WEATHER_MAX_AGE_H * 3600)
+
+typedef struct
+{
+  uint32_t magic;
+  uint32_t fetched_at; ///< UTC epoch seconds
+  weather_data_t data;
+  uint32_t crc; ///< CRC32 of all fields above
+} weather_cache_t;
+
+// Kept across deep sleep and software resets, checked by CRC
+RTC_NOINIT_ATTR static weather_cache_t rtc_cache;
+
+static weather_cache_t cache; // Served to readers
+static bool have_cache = false;
+static portMUX_TYPE cache_mux = portMUX_INITIALIZER_UNLOCKED;
+
+// From EVENT_BATTERY; full until the first reading
+static volatile uint8_t battery_percent = 100;
+static volatile bool battery_charging = false;
+
+static uint32_t cache_crc(const weather_cache_t *c)
+{
+  return esp_rom_crc32_le(0, (const uint8_t *)c,
+                          offsetof(weather_cache_t, crc));
+}
+
+static bool cache_valid(const weather_cache_t *c)
+{
+  return c->magic == CACHE_MAGIC && c->crc == cache_crc(c);
+}
+
+static void set_cache(const weather_cache_t *c)
+{
+  portENTER_CRITICAL(&cache_mux);
+  cache = *c;
+  have_cache = true;
+  portEXIT_CRITICAL(&cache_mux);
+}
+
+/**
+ * @brief Rebuild the cache from settings storage after a power loss
+ */
+static bool load_stored(weather_cache_t *c)
+{
+  uint32_t now_bits = 0;
+  uint32_t day_bits = 0;
+  memset(c, 0, sizeof(*c));
+  if (settings_get_uint(CACHE_TIME_KEY, 0, &c->fetched_at) != ESP_OK ||
+      c->fetched_at == 0)
+  {
+    return false;
+  }
+  settings_get_uint(CACHE_NOW_KEY, 0, &now_bits);
+  settings_get_uint(CACHE_DAY_KEY, 0, &day_bits);
+
+  c->magic = CACHE_MAGIC;
+  c->data.temp_c10 = (int16_t)(now_bits & 0xFFFF);
+  c->data.code = (uint8_t)(now_bits >> 16);
+  c->data.fields = (uint8_t)(now_bits >> 24);
+  c->data.high_c10 = (int16_t)(day_bits & 0xFFFF);
+  c->data.low_c10 = (int16_t)(day_bits >> 16);
+  c->crc = cache_crc(c);
+  return true;
+}
+
+static void store(const weather_cache_t *c)
+{
+  set_cache(c);
+  rtc_cache = *c;
+
+  const weather_data_t *d = &c->data;
+  settings_erase(CACHE_TIME_KEY);
+  settings_set_uint(CACHE_NOW_KEY, (uint16_t)d->temp_c10 |
+                                       ((uint32_t)d->code << 16) |
+                                       ((uint32_t)d->fields << 24));
+  settings_set_uint(CACHE_DAY_KEY, (uint16_t)d->high_c10 |
+                                       ((uint32_t)(uint16_t)d->low_c10 << 16));
+  settings_set_uint(CACHE_TIME_KEY, c->fetched_at);
+}
+
+static void battery_event(const event_t *event, void *user_data)
+{
+  (void)user_data;
+  battery_percent = event->battery.percent;
+  battery_charging = event->battery.charging;
+}
+
+/**
+ * @brief Time between fetches at the current battery level
+ */
+static uint32_t fetch_interval_s(void)
+{
+  if (battery_charging || battery_percent >= 50)
+  {
+    return INTERVAL_S;
+  }
+  if (battery_percent >= CONFIG_WEATHER_LOW_BATTERY_PERCENT)
+  {
+    return INTERVAL_S * 2;
+  }
+  return INTERVAL_S * 4;
+}
+
+/**
+ * @brief Seconds since the cached forecast was fetched, UINT32_MAX if unknown
+ */
+static uint32_t cache_age_s(uint32_t fetched_at)
+{
+  time_t now = time(NULL);
+  if (now < CLOCK_VALID_AFTER || now < (time_t)fetched_at)
+  {
+    return UINT32_MAX;
+  }
+  return (uint32_t)(now - (time_t)fetched_at);
+}
+
+esp_err_t weather_init(void)
+{
+  static bool subscribed = false;
+  if (!subscribed)
+  {
+    subscribed = event_bus_subscribe(EVENT_MASK(EVENT_BATTERY),
+                                     EVENT_CTX_WORKER, battery_event,
+                                     NULL) == ESP_OK;
+  }
+
+  weather_cache_t c;
+  const char *source = NULL;
+  if (cache_valid(&rtc_cache))
+  {
+    c = rtc_cache;
+    source = "RTC memory";
+  }
+  else if (load_stored(&c))
+  {
+    rtc_cache = c;
+    source = "settings";
+  }
+
+  if (source)
+  {
+    set_cache(&c);
+    ESP_LOGI(TAG, "Forecast from %s, fetched %lu s ago", source,
+             (unsigned long)cache_age_s(c.fetched_at));
+  }
+  return ESP_OK;
+}
+
+weather_freshness_t weather_get(weather_data_t *data, uint32_t *age_s)
+{
+  portENTER_CRITICAL(&cache_mux);
+  bool have = have_cache;
+  weather_cache_t c = cache;
+  portEXIT_CRITICAL(&cache_mux);
+
+  if (!have)
+  {
+    return WEATHER_NONE;
+  }
+
+  uint32_t age = cache_age_s(c.fetched_at);
+  if (data)
+  {
+    *data = c.data;
+  }
+  if (age_s)
+  {
+    *age_s = age;
+  }
+
+  if (age == UINT32_MAX)
+  {
+    return WEATHER_STALE; // Clock not set yet; better than nothing
+  }
+  if (age >= MAX_AGE_S)
+  {
+    return WEATHER_EXPIRED;
+  }
+  return age < fetch_interval_s() ? WEATHER_FRESH : WEATHER_STALE;
+}
+
+uint32_t weather_fetch_due_in_s(void)
+{
+  uint32_t stale_in = 0;
+
+  portENTER_CRITICAL(&cache_mux);
+  bool have = have_cache;
+  uint32_t fetched_at = cache.fetched_at;
+  portEXIT_CRITICAL(&cache_mux);
+
+  if (have)
+  {
+    uint32_t age = cache_age_s(fetched_at);
+    uint32_t interval = fetch_interval_s();
+    if (age < interval)
+    {
+      stale_in = interval - age;
+    }
+  }
+
+  // Stale data waits this long for a shared session before forcing one
+  return stale_in + SHARE_WAIT_S;
+}
+
+static void publish(bool ok)
+{
+  const event_t event = {
+      .type = EVENT_WEATHER,
+      .weather.ok = ok,
+  };
+  event_bus_publish(&event);
+}
+
+esp_err_t weather_fetch(void)
+{
+  time_t now = time(NULL);
+  if (now < CLOCK_VALID_AFTER)
+  {
+    // The fetch time would be meaningless
+    ESP_LOGW(TAG, "Clock not set, forecast not fetched");
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  int64_t start_us = esp_timer_get_time();
+  const net_http_opts_t opts = {
+      .url = CONFIG_WEATHER_URL,
+      .timeout_ms = HTTP_TIMEOUT_MS,
+  };
+  net_http_req_t req;
+  esp_err_t ret = net_http_open(&req, &opts);
+  if (ret != ESP_OK)
+  {
+    ESP_LOGW(TAG, "Forecast request failed: %s", esp_err_to_name(ret));
+    publish(false);
+    return ret;
+  }
+
+  weather_parser_t parser;
+  weather_parse_init(&parser);
+  weather_parse_result_t res = WEATHER_PARSE_MORE;
+  uint32_t total = 0;
+
+  if (req.status != 200)
+  {
+    ESP_LOGW(TAG, "Forecast request failed: HTTP %d", req.status);
+    ret = ESP_ERR_INVALID_RESPONSE;
+  }
+
+  // Read to the end even after the object closed, so the connection stays
+  // usable for the next request
+  char buf[READ_CHUNK];
+  while (ret == ESP_OK && res != WEATHER_PARSE_ERROR)
+  {
+    int read = esp_http_client_read(req.client, buf, sizeof(buf));
+    if (read < 0)
+    {
+      ret = ESP_FAIL;
+      break;
+    }
+    if (read == 0)
+    {
+      break;
+    }
+    total += (uint32_t)read;
+    res = weather_parse_push(&parser, buf, (size_t)read);
+  }
+  net_http_close(&req);
+
+  weather_cache_t c = {
+      .magic = CACHE_MAGIC,
+      .fetched_at = (uint32_t)now,
+  };
+  if (ret == ESP_OK && !weather_parse_finish(&parser, &c.data))
+  {
+    ESP_LOGE(TAG, "Forecast not understood (%lu bytes)",
+             (unsigned long)total);
+    ret = ESP_ERR_INVALID_RESPONSE;
+  }
+
+  if (ret == ESP_OK)
+  {
+    c.crc = cache_crc(&c);
+    store(&c);
+    int temp = abs(c.data.temp_c10);
+    ESP_LOGI(TAG, "%s %s%d.%d C (code %u), %lu bytes in %lu ms",
+             weather_code_name(c.data.code), c.data.temp_c10 < 0 ? "-" : "",
+             temp / 10, temp % 10, c.data.code, (unsigned long)total,
+             (unsigned long)((esp_timer_get_time() - start_us) / 1000));
+  }
+  publish(ret == ESP_OK);
+  return ret;
+}
+
+#else
+
+esp_err_t weather_init(void) { return ESP_OK; }
+
+weather_freshness_t weather_get(weather_data_t *data, uint32_t *age_s)
+{
+  (void)data;
+  (void)age_s;
+  return WEATHER_NONE;
+}
+
+esp_err_t weather_fetch(void) { return ESP_ERR_NOT_SUPPORTED; }
+
+uint32_t weather_fetch_due_in_s(void) { return UINT32_MAX; }
+
+#endif // CONFIG_WEATHER_ENABLE
@@ -0,0 +1,62 @@
+/**
+ * @file weather.h
+ * @brief Cached weather forecast for the watchface
+ *
+ * The forecast is fetched from CONFIG_WEATHER_URL by a network scheduler
+ * job and kept, with the time it was fetched, in RTC memory (survives
+ * sleep and resets) and in settings storage (survives power loss).
+ * Readers only ever see the cache, so the display never waits on the
+ * network:
+ *
+ * - Fresh: younger than the fetch interval (CONFIG_WEATHER_INTERVAL_MIN,
+ *   scaled by battery level as below).
+ * - Stale: still shown, and refetched on the next WiFi session that runs
+ *   anyway (NTP, update check). Only after CONFIG_WEATHER_SHARE_WAIT_MIN
+ *   without one does the job bring WiFi up itself.
+ * - Expired: older than CONFIG_WEATHER_MAX_AGE_H, not worth showing.
+ *
+ * The fetch interval stretches as the battery runs down (x2 below 50 %,
+ * x4 below CONFIG_WEATHER_LOW_BATTERY_PERCENT, normal while charging).
+ * Every fetch publishes EVENT_WEATHER.
+ *
+ * Enable with CONFIG_WEATHER_ENABLE.
+ */
+
+#ifndef WEATHER_H
+#define WEATHER_H
+
+#include "esp_err.h"
+#include "weather_parse.h"
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+typedef enum {
+  WEATHER_NONE,    ///< Nothing cached
+  WEATHER_FRESH,
+  WEATHER_STALE,   ///< Shown while a refetch is pending
+  WEATHER_EXPIRED, ///< Too old to show
+} weather_freshness_t;
+
+/* Load the cache and start following the battery; no network access */
+esp_err_t weather_init(void);
+
+/*
+ * Copy the cached forecast. Never blocks. age_s is the time since it was
+ * fetched, UINT32_MAX if the clock cannot tell.
+ */
+weather_freshness_t weather_get(weather_data_t *data, uint32_t *age_s);
+
+/* Fetch and cache the forecast; blocks, call with WiFi up */
+esp_err_t weather_fetch(void);
+
+/* Seconds until a fetch must run (for the network scheduler job) */
+uint32_t weather_fetch_due_in_s(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WEATHER_H
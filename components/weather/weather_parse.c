@@ -0,0 +1,409 @@
+/**
+ * @file weather_parse.c
+ * @brief Streaming forecast parser implementation
+ */
+
+#include "weather_parse.h"
+#include <stdlib.h>
+#include <string.h>
+
+enum
+{
+  ST_VALUE,   // A value, or ']' of an empty array
+  ST_KEY,     // A key, or '}' of an empty object
+  ST_COLON,
+  ST_NEXT,    // ',' or the end of the container
+  ST_STRING,
+  ST_NUMBER,
+  ST_LITERAL, // true, false, null
+  ST_DONE,
+  ST_ERROR,
+};
+
+enum
+{
+  FRAME_OBJECT,
+  FRAME_ARRAY,
+};
+
+enum
+{
+  KEY_OTHER,
+  KEY_CURRENT,
+  KEY_DAILY,
+  KEY_TEMP,
+  KEY_CODE,
+  KEY_TEMP_MAX,
+  KEY_TEMP_MIN,
+};
+
+static const char *const key_names[] = {
+    [KEY_CURRENT] = "current",
+    [KEY_DAILY] = "daily",
+    [KEY_TEMP] = "temperature_2m",
+    [KEY_CODE] = "weather_code",
+    [KEY_TEMP_MAX] = "temperature_2m_max",
+    [KEY_TEMP_MIN] = "temperature_2m_min",
+};
+
+void weather_parse_init(weather_parser_t *p)
+{
+  memset(p, 0, sizeof(*p));
+  p->state = ST_VALUE;
+}
+
+static bool token_complete(const weather_parser_t *p)
+{
+  return p->len < sizeof(p->token);
+}
+
+static void append(weather_parser_t *p, char c)
+{
+  if (p->len < sizeof(p->token) - 1)
+  {
+    p->token[p->len] = c;
+    p->token[p->len + 1] = '\0';
+  }
+  if (p->len < UINT8_MAX)
+  {
+    p->len++;
+  }
+}
+
+static uint8_t key_id(const weather_parser_t *p)
+{
+  if (!token_complete(p))
+  {
+    return KEY_OTHER;
+  }
+  for (uint8_t k = KEY_CURRENT; k < sizeof(key_names) / sizeof(key_names[0]);
+       k++)
+  {
+    if (strcmp(p->token, key_names[k]) == 0)
+    {
+      return k;
+    }
+  }
+  return KEY_OTHER;
+}
+
+static int16_t to_tenths(double v)
+{
+  v = v * 10 + (v < 0 ? -0.5 : 0.5);
+  if (v > INT16_MAX)
+  {
+    return INT16_MAX;
+  }
+  if (v < INT16_MIN)
+  {
+    return INT16_MIN;
+  }
+  return (int16_t)v;
+}
+
+/**
+ * @brief Store a finished number if its path is one of the known fields
+ */
+static void number_done(weather_parser_t *p)
+{
+  if (!token_complete(p))
+  {
+    return;
+  }
+  char *end = NULL;
+  double v = strtod(p->token, &end);
+  if (end == p->token || *end != '\0')
+  {
+    return;
+  }
+
+  const weather_parse_frame_t *s = p->stack;
+  weather_data_t *d = &p->data;
+  if (p->depth == 2 && s[0].key == KEY_CURRENT && s[1].kind == FRAME_OBJECT)
+  {
+    if (s[1].key == KEY_TEMP)
+    {
+      d->temp_c10 = to_tenths(v);
+      d->fields |= WEATHER_HAS_TEMP;
+    }
+    else if (s[1].key == KEY_CODE && v >= 0 && v <= UINT8_MAX)
+    {
+      d->code = (uint8_t)v;
+      d->fields |= WEATHER_HAS_CODE;
+    }
+  }
+  else if (p->depth == 3 && s[0].key == KEY_DAILY &&
+           s[1].kind == FRAME_OBJECT && s[2].kind == FRAME_ARRAY &&
+           s[2].index == 0)
+  {
+    if (s[1].key == KEY_TEMP_MAX)
+    {
+      d->high_c10 = to_tenths(v);
+      d->fields |= WEATHER_HAS_HIGH;
+    }
+    else if (s[1].key == KEY_TEMP_MIN)
+    {
+      d->low_c10 = to_tenths(v);
+      d->fields |= WEATHER_HAS_LOW;
+    }
+  }
+}
+
+static void value_done(weather_parser_t *p)
+{
+  p->state = p->depth == 0 ? ST_DONE : ST_NEXT;
+}
+
+static bool push_frame(weather_parser_t *p, uint8_t kind)
+{
+  if (p->depth >= WEATHER_PARSE_MAX_DEPTH)
+  {
+    return false;
+  }
+  p->stack[p->depth] = (weather_parse_frame_t){.kind = kind};
+  p->depth++;
+  return true;
+}
+
+static bool top_is(const weather_parser_t *p, uint8_t kind)
+{
+  return p->depth > 0 && p->stack[p->depth - 1].kind == kind;
+}
+
+static bool is_space(char c)
+{
+  return c == ' ' || c == '\t' || c == '\r' || c == '\n';
+}
+
+static bool is_number_char(char c)
+{
+  return (c >= '0' && c <= '9') || c == '-' || c == '+' || c == '.' ||
+         c == 'e' || c == 'E';
+}
+
+static bool is_letter(char c)
+{
+  return c >= 'a' && c <= 'z';
+}
+
+static uint8_t step(weather_parser_t *p, char c)
+{
+  switch (p->state)
+  {
+  case ST_STRING:
+    if (p->escape)
+    {
+      p->escape = false;
+      append(p, c); // Keys with escapes never match; exact text is moot
+    }
+    else if (c == '\\')
+    {
+      p->escape = true;
+    }
+    else if (c == '"')
+    {
+      if (p->in_key)
+      {
+        p->stack[p->depth - 1].key = key_id(p);
+        return ST_COLON;
+      }
+      value_done(p);
+      return p->state;
+    }
+    else
+    {
+      append(p, c);
+    }
+    return ST_STRING;
+
+  case ST_VALUE:
+    if (is_space(c))
+    {
+      return ST_VALUE;
+    }
+    if (c == '{')
+    {
+      return push_frame(p, FRAME_OBJECT) ? ST_KEY : ST_ERROR;
+    }
+    if (p->depth == 0)
+    {
+      return ST_ERROR; // The document is an object
+    }
+    if (c == '[')
+    {
+      return push_frame(p, FRAME_ARRAY) ? ST_VALUE : ST_ERROR;
+    }
+    if (c == ']' && top_is(p, FRAME_ARRAY))
+    {
+      p->depth--;
+      value_done(p);
+      return p->state;
+    }
+    p->len = 0;
+    p->token[0] = '\0';
+    if (c == '"')
+    {
+      p->in_key = false;
+      return ST_STRING;
+    }
+    if (is_number_char(c))
+    {
+      append(p, c);
+      return ST_NUMBER;
+    }
+    return is_letter(c) ? ST_LITERAL : ST_ERROR;
+
+  case ST_KEY:
+    if (is_space(c))
+    {
+      return ST_KEY;
+    }
+    if (c == '"')
+    {
+      p->in_key = true;
+      p->len = 0;
+      p->token[0] = '\0';
+      return ST_STRING;
+    }
+    if (c == '}')
+    {
+      p->depth--;
+      value_done(p);
+      return p->state;
+    }
+    return ST_ERROR;
+
+  case ST_COLON:
+    if (is_space(c))
+    {
+      return ST_COLON;
+    }
+    return c == ':' ? ST_VALUE : ST_ERROR;
+
+  case ST_NEXT:
+    if (is_space(c))
+    {
+      return ST_NEXT;
+    }
+    if (c == ',')
+    {
+      if (top_is(p, FRAME_OBJECT))
+      {
+        return ST_KEY;
+      }
+      weather_parse_frame_t *top = &p->stack[p->depth - 1];
+      if (top->index < UINT8_MAX)
+      {
+        top->index++;
+      }
+      return ST_VALUE;
+    }
+    if ((c == '}' && top_is(p, FRAME_OBJECT)) ||
+        (c == ']' && top_is(p, FRAME_ARRAY)))
+    {
+      p->depth--;
+      value_done(p);
+      return p->state;
+    }
+    return ST_ERROR;
+
+  case ST_DONE:
+    return ST_DONE; // Trailing bytes are ignored
+
+  default:
+    return ST_ERROR;
+  }
+}
+
+weather_parse_result_t weather_parse_push(weather_parser_t *p, const char *data,
+                                          size_t len)
+{
+  for (size_t i = 0; i < len && p->state != ST_ERROR; i++)
+  {
+    char c = data[i];
+
+    // Numbers and literals end at the first byte that is not theirs
+    if (p->state == ST_NUMBER)
+    {
+      if (is_number_char(c))
+      {
+        append(p, c);
+        continue;
+      }
+      number_done(p);
+      value_done(p);
+    }
+    else if (p->state == ST_LITERAL)
+    {
+      if (is_letter(c))
+      {
+        continue;
+      }
+      value_done(p);
+    }
+
+    p->state = step(p, c);
+  }
+
+  if (p->state == ST_ERROR)
+  {
+    return WEATHER_PARSE_ERROR;
+  }
+  return p->state == ST_DONE ? WEATHER_PARSE_DONE : WEATHER_PARSE_MORE;
+}
+
+bool weather_parse_finish(const weather_parser_t *p, weather_data_t *out)
+{
+  const uint8_t required = WEATHER_HAS_TEMP | WEATHER_HAS_CODE;
+  if (p->state != ST_DONE || (p->data.fields & required) != required)
+  {
+    return false;
+  }
+  *out = p->data;
+  return true;
+}
+
+const char *weather_code_name(uint8_t code)
+{
+  if (code == 0)
+  {
+    return "Clear";
+  }
+  if (code <= 2)
+  {
+    return "Cloudy";
+  }
+  if (code == 3)
+  {
+    return "Overcast";
+  }
+  if (code == 45 || code == 48)
+  {
+    return "Fog";
+  }
+  if (code >= 51 && code <= 57)
+  {
+    return "Drizzle";
+  }
+  if (code >= 61 && code <= 67)
+  {
+    return "Rain";
+  }
+  if (code >= 71 && code <= 77)
+  {
+    return "Snow";
+  }
+  if (code >= 80 && code <= 82)
+  {
+    return "Showers";
+  }
+  if (code == 85 || code == 86)
+  {
+    return "Snow";
+  }
+  if (code >= 95 && code <= 99)
+  {
+    return "Storm";
+  }
+  return "?";
+}
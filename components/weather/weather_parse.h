@@ -0,0 +1,89 @@
+/**
+ * @file weather_parse.h
+ * @brief Streaming forecast parser (internal, pure)
+ *
+ * Reads an Open-Meteo style forecast response as it arrives from the
+ * network, in chunks of any size, and keeps only the handful of numbers
+ * the watch shows. No document tree is built and nothing is allocated,
+ * so the parser state is a fixed 56 bytes however large the response is.
+ *
+ * Recognised fields (anything else is skipped):
+ *
+ *   {"current": {"temperature_2m": 12.3, "weather_code": 3, ...},
+ *    "daily": {"temperature_2m_max": [15.2, ...],
+ *              "temperature_2m_min": [7.1, ...], ...}, ...}
+ *
+ * Only the first element of the daily arrays (today) is used.
+ */
+
+#ifndef WEATHER_PARSE_H
+#define WEATHER_PARSE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* weather_data_t.fields bits */
+#define WEATHER_HAS_TEMP 0x01
+#define WEATHER_HAS_CODE 0x02
+#define WEATHER_HAS_HIGH 0x04
+#define WEATHER_HAS_LOW 0x08
+
+/* Deepest nesting followed; the forecast needs 3 */
+#define WEATHER_PARSE_MAX_DEPTH 6
+
+typedef struct {
+  int16_t temp_c10; ///< Current temperature, tenths of a degree C
+  int16_t high_c10; ///< Today's maximum
+  int16_t low_c10;  ///< Today's minimum
+  uint8_t code;     ///< WMO weather interpretation code
+  uint8_t fields;   ///< WEATHER_HAS_* of the values that were present
+} weather_data_t;
+
+typedef enum {
+  WEATHER_PARSE_MORE,  ///< Feed more data
+  WEATHER_PARSE_DONE,  ///< Top-level object closed
+  WEATHER_PARSE_ERROR, ///< Not JSON, or nested too deep
+} weather_parse_result_t;
+
+typedef struct {
+  uint8_t kind;  ///< Object or array
+  uint8_t key;   ///< Last key read in an object
+  uint8_t index; ///< Element index in an array, saturating
+} weather_parse_frame_t;
+
+typedef struct {
+  weather_data_t data;
+  weather_parse_frame_t stack[WEATHER_PARSE_MAX_DEPTH];
+  uint8_t depth;
+  uint8_t state;
+  bool in_key;
+  bool escape;
+  uint8_t len; ///< Bytes in token; may exceed sizeof(token) (truncated)
+  char token[24];
+} weather_parser_t;
+
+void weather_parse_init(weather_parser_t *p);
+
+/* Feed the next bytes of the response */
+weather_parse_result_t weather_parse_push(weather_parser_t *p, const char *data,
+                                          size_t len);
+
+/*
+ * Whether the whole document was read and held at least the current
+ * temperature and weather code; the values are copied to out.
+ */
+bool weather_parse_finish(const weather_parser_t *p, weather_data_t *out);
+
+/* Short English name of a WMO weather code ("Clear", "Rain", ...) */
+const char *weather_code_name(uint8_t code);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WEATHER_PARSE_H
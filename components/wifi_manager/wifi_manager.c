@@ -9,11 +9,17 @@
 #include "esp_event.h"
 #include "esp_log.h"
 #include "esp_netif.h"
+#include "esp_random.h"
+#include "esp_timer.h"
 #include "esp_wifi.h"
+#include "event_bus.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/event_groups.h"
 #include "nvs_flash.h"
 #include "sdkconfig.h"
+#include "seqlock.h"
+#include "sleep_manager.h"
+#include "wifi_reconnect.h"
 #include <string.h>
 
 static const char *TAG = "wifi_manager";
@@ -23,8 +29,19 @@ static const char *TAG = "wifi_manager";
 #define WIFI_FAIL_BIT BIT1
 #define WIFI_SCAN_DONE_BIT BIT2
 
-// Maximum connection retry attempts
-#define MAX_RETRY_ATTEMPTS 3
+// Failed attempts before connection waiters are told it failed; the
+// reconnect policy keeps retrying in the background
+#define FAIL_REPORT_ATTEMPTS 3
+
+// Maximum registered network consumers
+#define MAX_CONSUMERS 4
+
+typedef struct
+{
+  const char *name;
+  wifi_manager_consumer_cb_t needs_network;
+  void *user_data;
+} wifi_consumer_t;
 
 // WiFi manager state
 static struct
@@ -33,13 +50,90 @@ static struct
   wifi_state_t state;
   EventGroupHandle_t event_group;
   esp_netif_t *sta_netif;
-  int retry_count;
+  wifi_reconnect_t reconnect;
+  esp_timer_handle_t reconnect_timer;
   wifi_manager_callback_t callback;
   void *callback_user_data;
   wifi_ap_info_t scan_results[20]; // Max 20 APs
   uint16_t scan_count;
+  bool suspended;          // Radio stopped by sleep hook
+  bool resume_connect;     // Was connected/connecting before sleep
+  int64_t radio_on_since;  // esp_timer time radio was started (0 = off)
+  uint64_t radio_on_us;    // Accumulated radio-on time (excluding current)
+  int64_t stats_start;     // esp_timer time accounting started
+  wifi_consumer_t consumers[MAX_CONSUMERS];
+  uint8_t consumer_count;
+  char connected_ssid[33]; // From STA_CONNECTED, cleared on disconnect
+  char ip_str[16];         // From STA_GOT_IP, cleared on disconnect
+  volatile bool low_battery; // From EVENT_BATTERY
 } wifi_mgr = {0};
 
+// Status snapshot for lock-free readers
+static wifi_manager_status_t status_storage[2];
+static seqlock_t status_lock = SEQLOCK_INITIALIZER(status_storage);
+
+// Serialises the event task and API callers that publish the status
+static portMUX_TYPE status_mux = portMUX_INITIALIZER_UNLOCKED;
+
+/**
+ * @brief Publish the current state, SSID and IP as one snapshot
+ */
+static void wifi_manager_publish_status(void)
+{
+  wifi_manager_status_t status = {0};
+
+  portENTER_CRITICAL(&status_mux);
+  status.state = wifi_mgr.state;
+  memcpy(status.ssid, wifi_mgr.connected_ssid, sizeof(status.ssid));
+  memcpy(status.ip, wifi_mgr.ip_str, sizeof(status.ip));
+  seqlock_write(&status_lock, &status);
+  portEXIT_CRITICAL(&status_mux);
+}
+
+/**
+ * @brief Radio-on accounting helpers
+ */
+static void wifi_radio_mark_on(void)
+{
+  if (wifi_mgr.radio_on_since == 0)
+  {
+    wifi_mgr.radio_on_since = esp_timer_get_time();
+  }
+}
+
+static void wifi_radio_mark_off(void)
+{
+  if (wifi_mgr.radio_on_since != 0)
+  {
+    wifi_mgr.radio_on_us +=
+        (uint64_t)(esp_timer_get_time() - wifi_mgr.radio_on_since);
+    wifi_mgr.radio_on_since = 0;
+  }
+}
+
+/**
+ * @brief Restart the radio if it was stopped for sleep or on request
+ */
+static esp_err_t wifi_manager_ensure_started(void)
+{
+  if (!wifi_mgr.suspended)
+  {
+    return ESP_OK;
+  }
+
+  esp_err_t ret = esp_wifi_start();
+  if (ret != ESP_OK)
+  {
+    ESP_LOGE(TAG, "Failed to restart WiFi: %s", esp_err_to_name(ret));
+    return ret;
+  }
+
+  wifi_mgr.suspended = false;
+  wifi_radio_mark_on();
+  ESP_LOGI(TAG, "WiFi radio resumed");
+  return ESP_OK;
+}
+
 /**
  * @brief Update WiFi state and trigger callback
  */
@@ -48,8 +142,15 @@ static void wifi_manager_set_state(wifi_state_t new_state)
   if (wifi_mgr.state != new_state)
   {
     wifi_mgr.state = new_state;
+    wifi_manager_publish_status();
     ESP_LOGI(TAG, "State changed to: %d", new_state);
 
+    const event_t event = {
+        .type = EVENT_WIFI_STATE,
+        .wifi.state = (uint8_t)new_state,
+    };
+    event_bus_publish(&event);
+
     if (wifi_mgr.callback)
     {
       wifi_mgr.callback(new_state, wifi_mgr.callback_user_data);
@@ -57,6 +158,87 @@ static void wifi_manager_set_state(wifi_state_t new_state)
   }
 }
 
+/**
+ * @brief Track low battery (and not charging): reconnects back off harder
+ */
+static void wifi_battery_event(const event_t *event, void *user_data)
+{
+  (void)user_data;
+  wifi_mgr.low_battery =
+      CONFIG_WIFI_RECONNECT_LOW_BATTERY_PERCENT > 0 &&
+      !event->battery.charging &&
+      event->battery.percent <= CONFIG_WIFI_RECONNECT_LOW_BATTERY_PERCENT;
+}
+
+static void wifi_reconnect_cancel(void)
+{
+  if (wifi_mgr.reconnect_timer)
+  {
+    esp_timer_stop(wifi_mgr.reconnect_timer);
+  }
+}
+
+/**
+ * @brief Backoff expired: try the configured network again
+ */
+static void wifi_reconnect_timer_cb(void *arg)
+{
+  (void)arg;
+
+  // Connected, scanning or stopped since the retry was scheduled
+  if (!wifi_mgr.initialized || wifi_mgr.suspended ||
+      wifi_mgr.state != WIFI_STATE_DISCONNECTED)
+  {
+    return;
+  }
+
+  wifi_manager_set_state(WIFI_STATE_CONNECTING);
+  esp_err_t ret = esp_wifi_connect();
+  if (ret != ESP_OK)
+  {
+    ESP_LOGE(TAG, "Reconnect failed: %s", esp_err_to_name(ret));
+    wifi_manager_set_state(WIFI_STATE_FAILED);
+    xEventGroupSetBits(wifi_mgr.event_group, WIFI_FAIL_BIT);
+  }
+}
+
+/**
+ * @brief Apply the reconnect policy to a station disconnect
+ */
+static void wifi_handle_disconnect(uint16_t reason)
+{
+  wifi_disc_class_t cls = wifi_reconnect_classify(reason);
+  bool low_battery = wifi_mgr.low_battery;
+  uint32_t delay_ms =
+      wifi_reconnect_next_delay(&wifi_mgr.reconnect, reason, low_battery);
+
+  if (delay_ms == WIFI_RECONNECT_GIVE_UP)
+  {
+    if (cls == WIFI_DISC_LOCAL)
+    {
+      ESP_LOGI(TAG, "Disconnected on request");
+      return;
+    }
+    ESP_LOGE(TAG, "Giving up (reason %u, %s)", reason,
+             wifi_reconnect_class_name(cls));
+    wifi_manager_set_state(WIFI_STATE_FAILED);
+    xEventGroupSetBits(wifi_mgr.event_group, WIFI_FAIL_BIT);
+    return;
+  }
+
+  ESP_LOGI(TAG, "Disconnected (reason %u, %s), retry %u in %lu ms%s", reason,
+           wifi_reconnect_class_name(cls), wifi_mgr.reconnect.attempt,
+           (unsigned long)delay_ms, low_battery ? " (low battery)" : "");
+
+  if (wifi_mgr.reconnect.attempt >= FAIL_REPORT_ATTEMPTS)
+  {
+    xEventGroupSetBits(wifi_mgr.event_group, WIFI_FAIL_BIT);
+  }
+
+  wifi_reconnect_cancel();
+  esp_timer_start_once(wifi_mgr.reconnect_timer, (uint64_t)delay_ms * 1000);
+}
+
 /**
  * @brief WiFi event handler
  */
@@ -71,25 +253,35 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
       ESP_LOGI(TAG, "WiFi station started");
       break;
 
+    case WIFI_EVENT_STA_CONNECTED:
+    {
+      wifi_event_sta_connected_t *event =
+          (wifi_event_sta_connected_t *)event_data;
+      size_t len = event->ssid_len < 32 ? event->ssid_len : 32;
+      memcpy(wifi_mgr.connected_ssid, event->ssid, len);
+      wifi_mgr.connected_ssid[len] = '\0';
+      wifi_manager_publish_status();
+      break;
+    }
+
     case WIFI_EVENT_STA_DISCONNECTED:
-      ESP_LOGI(TAG, "Disconnected from AP");
+    {
+      wifi_event_sta_disconnected_t *event =
+          (wifi_event_sta_disconnected_t *)event_data;
+      xEventGroupClearBits(wifi_mgr.event_group, WIFI_CONNECTED_BIT);
+      wifi_mgr.connected_ssid[0] = '\0';
+      wifi_mgr.ip_str[0] = '\0';
       wifi_manager_set_state(WIFI_STATE_DISCONNECTED);
 
-      if (wifi_mgr.retry_count < MAX_RETRY_ATTEMPTS)
+      if (wifi_mgr.suspended)
       {
-        wifi_mgr.retry_count++;
-        ESP_LOGI(TAG, "Retry %d/%d", wifi_mgr.retry_count, MAX_RETRY_ATTEMPTS);
-        esp_wifi_connect();
-        wifi_manager_set_state(WIFI_STATE_CONNECTING);
-      }
-      else
-      {
-        ESP_LOGE(TAG, "Connection failed after %d attempts",
-                 MAX_RETRY_ATTEMPTS);
-        wifi_manager_set_state(WIFI_STATE_FAILED);
-        xEventGroupSetBits(wifi_mgr.event_group, WIFI_FAIL_BIT);
+        // Radio stopped for sleep - don't burn time on retries
+        break;
       }
+
+      wifi_handle_disconnect(event->reason);
       break;
+    }
 
     case WIFI_EVENT_SCAN_DONE:
       // Fetch scan results - use static buffer to avoid stack overflow
@@ -138,12 +330,160 @@ static void wifi_event_handler(void *arg, esp_event_base_t event_base,
   {
     ip_event_got_ip_t *event = (ip_event_got_ip_t *)event_data;
     ESP_LOGI(TAG, "Got IP: " IPSTR, IP2STR(&event->ip_info.ip));
-    wifi_mgr.retry_count = 0;
+    snprintf(wifi_mgr.ip_str, sizeof(wifi_mgr.ip_str), IPSTR,
+             IP2STR(&event->ip_info.ip));
+    wifi_reconnect_reset(&wifi_mgr.reconnect);
     wifi_manager_set_state(WIFI_STATE_CONNECTED);
     xEventGroupSetBits(wifi_mgr.event_group, WIFI_CONNECTED_BIT);
   }
 }
 
+/**
+ * @brief Stop the radio; wifi_manager_ensure_started() undoes it
+ */
+static esp_err_t wifi_manager_stop_radio(void)
+{
+  // Set before stopping so the disconnect event doesn't trigger retries
+  wifi_mgr.suspended = true;
+  wifi_reconnect_cancel();
+
+  esp_err_t ret = esp_wifi_stop();
+  if (ret != ESP_OK)
+  {
+    wifi_mgr.suspended = false;
+    return ret;
+  }
+
+  wifi_radio_mark_off();
+  wifi_manager_set_state(WIFI_STATE_DISCONNECTED);
+  return ESP_OK;
+}
+
+#ifdef CONFIG_WIFI_SLEEP_SUSPEND
+/**
+ * @brief Log accumulated radio-on time, normalised to seconds per hour
+ */
+static void wifi_log_radio_stats(const char *label)
+{
+  int64_t elapsed_us = esp_timer_get_time() - wifi_mgr.stats_start;
+  uint64_t on_ms = wifi_manager_get_radio_on_ms();
+  uint32_t per_hour_sec = 0;
+
+  if (elapsed_us > 0)
+  {
+    per_hour_sec = (uint32_t)((on_ms * 3600000ULL) / (uint64_t)elapsed_us);
+  }
+
+  ESP_LOGI(TAG, "Radio %s: on %llu s of %llu s (%lu s/h)", label,
+           on_ms / 1000ULL, (uint64_t)elapsed_us / 1000000ULL,
+           (unsigned long)per_hour_sec);
+}
+
+#ifdef CONFIG_WIFI_WAKE_RECONNECT_ON_DEMAND
+/**
+ * @brief Ask registered consumers whether the network is needed
+ */
+static bool wifi_consumers_need_network(void)
+{
+  for (uint8_t i = 0; i < wifi_mgr.consumer_count; i++)
+  {
+    const wifi_consumer_t *consumer = &wifi_mgr.consumers[i];
+    if (consumer->needs_network(consumer->user_data))
+    {
+      ESP_LOGI(TAG, "Consumer '%s' needs network", consumer->name);
+      return true;
+    }
+  }
+
+  return false;
+}
+#endif
+
+/**
+ * @brief Sleep hook: stop the radio (or drop to max modem-sleep)
+ */
+static esp_err_t wifi_sleep_enter_hook(sleep_manager_sleep_type_t sleep_type,
+                                       void *user_data)
+{
+  (void)sleep_type;
+  (void)user_data;
+
+  if (!wifi_mgr.initialized || wifi_mgr.suspended)
+  {
+    return ESP_OK;
+  }
+
+#ifdef CONFIG_WIFI_SLEEP_MODE_MAX_MODEM
+  esp_err_t ret = esp_wifi_set_ps(WIFI_PS_MAX_MODEM);
+  if (ret != ESP_OK)
+  {
+    ESP_LOGW(TAG, "Failed to enter max modem-sleep: %s",
+             esp_err_to_name(ret));
+  }
+  else
+  {
+    ESP_LOGI(TAG, "WiFi in max modem-sleep for sleep");
+  }
+#else
+  wifi_mgr.resume_connect = (wifi_mgr.state == WIFI_STATE_CONNECTED ||
+                             wifi_mgr.state == WIFI_STATE_CONNECTING);
+
+  esp_err_t ret = wifi_manager_stop_radio();
+  if (ret != ESP_OK)
+  {
+    ESP_LOGW(TAG, "Failed to stop WiFi for sleep: %s", esp_err_to_name(ret));
+    return ret;
+  }
+  ESP_LOGI(TAG, "WiFi radio stopped for sleep (was %s)",
+           wifi_mgr.resume_connect ? "connected" : "idle");
+#endif
+
+  wifi_log_radio_stats("before sleep");
+  return ESP_OK;
+}
+
+/**
+ * @brief Wake hook: apply the configured reconnect policy
+ */
+static esp_err_t wifi_sleep_post_wake_hook(sleep_manager_sleep_type_t sleep_type,
+                                           void *user_data)
+{
+  (void)sleep_type;
+  (void)user_data;
+
+  if (!wifi_mgr.initialized)
+  {
+    return ESP_OK;
+  }
+
+#ifdef CONFIG_WIFI_SLEEP_MODE_MAX_MODEM
+  esp_wifi_set_ps(WIFI_PS_MIN_MODEM);
+#elif defined(CONFIG_WIFI_WAKE_RECONNECT_ALWAYS)
+  if (wifi_mgr.suspended && wifi_mgr.resume_connect)
+  {
+    wifi_manager_request_connection();
+  }
+#elif defined(CONFIG_WIFI_WAKE_RECONNECT_ON_DEMAND)
+  if (wifi_mgr.suspended && wifi_consumers_need_network())
+  {
+    wifi_manager_request_connection();
+  }
+  else if (wifi_mgr.suspended)
+  {
+    ESP_LOGI(TAG, "No consumer needs network - WiFi stays off");
+  }
+#else
+  if (wifi_mgr.suspended)
+  {
+    ESP_LOGI(TAG, "WiFi stays off until requested");
+  }
+#endif
+
+  wifi_mgr.resume_connect = false;
+  return ESP_OK;
+}
+#endif // CONFIG_WIFI_SLEEP_SUSPEND
+
 esp_err_t wifi_manager_init(void)
 {
   if (wifi_mgr.initialized)
@@ -162,6 +502,34 @@ esp_err_t wifi_manager_init(void)
     return ESP_FAIL;
   }
 
+  const esp_timer_create_args_t timer_args = {
+      .callback = wifi_reconnect_timer_cb,
+      .name = "wifi_reconnect",
+  };
+  if (esp_timer_create(&timer_args, &wifi_mgr.reconnect_timer) != ESP_OK)
+  {
+    ESP_LOGE(TAG, "Failed to create reconnect timer");
+    vEventGroupDelete(wifi_mgr.event_group);
+    return ESP_FAIL;
+  }
+
+  const wifi_reconnect_config_t reconnect_cfg = {
+      .base_ms = CONFIG_WIFI_RECONNECT_BASE_MS,
+      .cap_ms = CONFIG_WIFI_RECONNECT_CAP_S * 1000,
+      .low_battery_factor = CONFIG_WIFI_RECONNECT_LOW_BATTERY_FACTOR,
+      .auth_retries = CONFIG_WIFI_RECONNECT_AUTH_RETRIES,
+  };
+  wifi_reconnect_init(&wifi_mgr.reconnect, &reconnect_cfg, esp_random());
+
+  // Subscriptions are permanent; don't add another after a deinit
+  static bool battery_subscribed = false;
+  if (!battery_subscribed)
+  {
+    battery_subscribed =
+        event_bus_subscribe(EVENT_MASK(EVENT_BATTERY), EVENT_CTX_WORKER,
+                            wifi_battery_event, NULL) == ESP_OK;
+  }
+
   // Initialize TCP/IP network interface (ignore if already initialized)
   esp_err_t ret = esp_netif_init();
   if (ret != ESP_OK && ret != ESP_ERR_INVALID_STATE)
@@ -204,6 +572,9 @@ esp_err_t wifi_manager_init(void)
 
   // Start WiFi
   ESP_ERROR_CHECK(esp_wifi_start());
+  wifi_mgr.stats_start = esp_timer_get_time();
+  wifi_mgr.radio_on_us = 0;
+  wifi_radio_mark_on();
 
   // Set WiFi country code (required for scanning to work properly)
   wifi_country_t country = {
@@ -217,8 +588,25 @@ esp_err_t wifi_manager_init(void)
 
   wifi_mgr.initialized = true;
   wifi_mgr.state = WIFI_STATE_DISCONNECTED;
-  wifi_mgr.retry_count = 0;
   wifi_mgr.scan_count = 0;
+  wifi_mgr.suspended = false;
+  wifi_manager_publish_status();
+
+#ifdef CONFIG_WIFI_SLEEP_SUSPEND
+  // Radio goes down last on entry and reconnects after the UI is back
+  const sleep_manager_hook_t sleep_hook = {
+      .name = "wifi",
+      .priority = SLEEP_HOOK_PRIORITY_DEFAULT + 10,
+      .enter = wifi_sleep_enter_hook,
+      .post_wake = wifi_sleep_post_wake_hook,
+  };
+  esp_err_t hook_ret = sleep_manager_register_hook(&sleep_hook);
+  if (hook_ret != ESP_OK)
+  {
+    ESP_LOGW(TAG, "Failed to register sleep hook: %s",
+             esp_err_to_name(hook_ret));
+  }
+#endif
 
   ESP_LOGI(TAG, "WiFi manager initialized");
   return ESP_OK;
@@ -236,12 +624,20 @@ esp_err_t wifi_manager_deinit(void)
   // Disconnect if connected
   wifi_manager_disconnect();
 
+  if (wifi_mgr.reconnect_timer)
+  {
+    esp_timer_stop(wifi_mgr.reconnect_timer);
+    esp_timer_delete(wifi_mgr.reconnect_timer);
+    wifi_mgr.reconnect_timer = NULL;
+  }
+
   // Stop WiFi
   esp_err_t ret = esp_wifi_stop();
   if (ret != ESP_OK)
   {
     ESP_LOGW(TAG, "WiFi stop failed: %s", esp_err_to_name(ret));
   }
+  wifi_radio_mark_off();
 
   // Unregister event handlers
   esp_event_handler_unregister(WIFI_EVENT, ESP_EVENT_ANY_ID,
@@ -272,6 +668,10 @@ esp_err_t wifi_manager_deinit(void)
 
   wifi_mgr.initialized = false;
   wifi_mgr.callback = NULL;
+  wifi_mgr.state = WIFI_STATE_DISCONNECTED;
+  wifi_mgr.connected_ssid[0] = '\0';
+  wifi_mgr.ip_str[0] = '\0';
+  wifi_manager_publish_status();
 
   ESP_LOGI(TAG, "WiFi manager deinitialized");
   return ESP_OK;
@@ -287,6 +687,15 @@ esp_err_t wifi_manager_scan_start(void)
 
   ESP_LOGI(TAG, "Starting WiFi scan");
 
+  esp_err_t ret = wifi_manager_ensure_started();
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+
+  // A pending reconnect would interrupt the scan
+  wifi_reconnect_cancel();
+
   // Disconnect from AP before scanning if currently connected
   if (wifi_mgr.state == WIFI_STATE_CONNECTED)
   {
@@ -315,7 +724,7 @@ esp_err_t wifi_manager_scan_start(void)
               .max = 300  // Max time per channel (ms)
           }}};
 
-  esp_err_t ret = esp_wifi_scan_start(&scan_config, false); // Non-blocking
+  ret = esp_wifi_scan_start(&scan_config, false); // Non-blocking
   if (ret != ESP_OK)
   {
     ESP_LOGE(TAG, "Scan start failed: %s", esp_err_to_name(ret));
@@ -442,12 +851,21 @@ esp_err_t wifi_manager_connect(const char *ssid, const char *password,
   xEventGroupClearBits(wifi_mgr.event_group,
                        WIFI_CONNECTED_BIT | WIFI_FAIL_BIT);
 
-  // Reset retry counter
-  wifi_mgr.retry_count = 0;
+  // Explicit connect: retry at once again and drop any pending backoff
+  wifi_reconnect_cancel();
+  wifi_reconnect_reset(&wifi_mgr.reconnect);
+
+  // Radio may have been stopped for sleep
+  esp_err_t ret = wifi_manager_ensure_started();
+  if (ret != ESP_OK)
+  {
+    wifi_manager_set_state(WIFI_STATE_FAILED);
+    return ret;
+  }
 
   // Start connection
   wifi_manager_set_state(WIFI_STATE_CONNECTING);
-  esp_err_t ret = esp_wifi_connect();
+  ret = esp_wifi_connect();
 
   if (ret != ESP_OK)
   {
@@ -469,6 +887,7 @@ esp_err_t wifi_manager_disconnect(void)
   }
 
   ESP_LOGI(TAG, "Disconnecting");
+  wifi_reconnect_cancel();
 
   esp_err_t ret = esp_wifi_disconnect();
   if (ret == ESP_OK)
@@ -486,6 +905,14 @@ bool wifi_manager_is_connected(void)
   return wifi_mgr.state == WIFI_STATE_CONNECTED;
 }
 
+void wifi_manager_get_status(wifi_manager_status_t *status)
+{
+  if (status)
+  {
+    seqlock_read(&status_lock, status);
+  }
+}
+
 esp_err_t wifi_manager_get_connected_ssid(char *ssid, size_t max_len)
 {
   if (!wifi_mgr.initialized || !ssid || max_len < 33)
@@ -493,21 +920,15 @@ esp_err_t wifi_manager_get_connected_ssid(char *ssid, size_t max_len)
     return ESP_ERR_INVALID_ARG;
   }
 
-  if (!wifi_manager_is_connected())
+  wifi_manager_status_t status;
+  wifi_manager_get_status(&status);
+  if (status.state != WIFI_STATE_CONNECTED || status.ssid[0] == '\0')
   {
     return ESP_ERR_WIFI_NOT_CONNECT;
   }
 
-  wifi_config_t wifi_config;
-  esp_err_t ret = esp_wifi_get_config(WIFI_IF_STA, &wifi_config);
-  if (ret == ESP_OK)
-  {
-    size_t len = strnlen((char *)wifi_config.sta.ssid, max_len - 1);
-    memcpy(ssid, (char *)wifi_config.sta.ssid, len);
-    ssid[len] = '\0';
-  }
-
-  return ret;
+  memcpy(ssid, status.ssid, sizeof(status.ssid));
+  return ESP_OK;
 }
 
 esp_err_t wifi_manager_get_rssi(int8_t *rssi)
@@ -539,19 +960,15 @@ esp_err_t wifi_manager_get_ip_address(char *ip_str, size_t max_len)
     return ESP_ERR_INVALID_ARG;
   }
 
-  if (!wifi_manager_is_connected())
+  wifi_manager_status_t status;
+  wifi_manager_get_status(&status);
+  if (status.state != WIFI_STATE_CONNECTED || status.ip[0] == '\0')
   {
     return ESP_ERR_WIFI_NOT_CONNECT;
   }
 
-  esp_netif_ip_info_t ip_info;
-  esp_err_t ret = esp_netif_get_ip_info(wifi_mgr.sta_netif, &ip_info);
-  if (ret == ESP_OK)
-  {
-    snprintf(ip_str, max_len, IPSTR, IP2STR(&ip_info.ip));
-  }
-
-  return ret;
+  memcpy(ip_str, status.ip, sizeof(status.ip));
+  return ESP_OK;
 }
 
 esp_err_t wifi_manager_register_callback(wifi_manager_callback_t callback,
@@ -619,3 +1036,114 @@ esp_err_t wifi_manager_auto_connect(void)
   ESP_LOGI(TAG, "Auto-connecting to saved network");
   return wifi_manager_connect(ssid, password, false); // Don't re-save
 }
+
+esp_err_t wifi_manager_wait_for_connection(uint32_t timeout_ms)
+{
+  if (!wifi_mgr.initialized)
+  {
+    ESP_LOGE(TAG, "Not initialized");
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  if (wifi_mgr.state == WIFI_STATE_CONNECTED)
+  {
+    return ESP_OK;
+  }
+
+  EventBits_t bits = xEventGroupWaitBits(
+      wifi_mgr.event_group, WIFI_CONNECTED_BIT | WIFI_FAIL_BIT, pdFALSE,
+      pdFALSE, pdMS_TO_TICKS(timeout_ms));
+
+  if ((bits & WIFI_CONNECTED_BIT) && wifi_manager_is_connected())
+  {
+    return ESP_OK;
+  }
+
+  if (bits & WIFI_FAIL_BIT)
+  {
+    return ESP_FAIL;
+  }
+
+  return ESP_ERR_TIMEOUT;
+}
+
+esp_err_t wifi_manager_register_consumer(
+    const char *name, wifi_manager_consumer_cb_t needs_network,
+    void *user_data)
+{
+  if (!name || !needs_network)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  if (wifi_mgr.consumer_count >= MAX_CONSUMERS)
+  {
+    ESP_LOGW(TAG, "Consumer table full, '%s' not registered", name);
+    return ESP_ERR_NO_MEM;
+  }
+
+  wifi_consumer_t *consumer = &wifi_mgr.consumers[wifi_mgr.consumer_count++];
+  consumer->name = name;
+  consumer->needs_network = needs_network;
+  consumer->user_data = user_data;
+
+  ESP_LOGI(TAG, "Network consumer registered: %s", name);
+  return ESP_OK;
+}
+
+esp_err_t wifi_manager_request_connection(void)
+{
+  if (!wifi_mgr.initialized)
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
+
+  if (wifi_mgr.state == WIFI_STATE_CONNECTED ||
+      wifi_mgr.state == WIFI_STATE_CONNECTING)
+  {
+    return ESP_OK;
+  }
+
+  esp_err_t ret = wifi_manager_ensure_started();
+  if (ret != ESP_OK)
+  {
+    return ret;
+  }
+
+  return wifi_manager_auto_connect();
+}
+
+esp_err_t wifi_manager_suspend_radio(void)
+{
+  if (!wifi_mgr.initialized)
+  {
+    return ESP_ERR_INVALID_STATE;
+  }
+  if (wifi_mgr.suspended)
+  {
+    return ESP_OK;
+  }
+
+  esp_err_t ret = wifi_manager_stop_radio();
+  if (ret != ESP_OK)
+  {
+    ESP_LOGW(TAG, "Failed to stop WiFi: %s", esp_err_to_name(ret));
+    return ret;
+  }
+  ESP_LOGI(TAG, "WiFi radio stopped until requested");
+  return ESP_OK;
+}
+
+bool wifi_manager_is_suspended(void) { return wifi_mgr.suspended; }
+
+uint64_t wifi_manager_get_radio_on_ms(void)
+{
+  uint64_t total_us = wifi_mgr.radio_on_us;
+
+  if (wifi_mgr.radio_on_since != 0)
+  {
+    total_us += (uint64_t)(esp_timer_get_time() - wifi_mgr.radio_on_since);
+  }
+
+  return total_us / 1000ULL;
+}
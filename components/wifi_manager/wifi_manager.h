@@ -42,6 +42,19 @@ extern "C"
     uint8_t channel;           ///< WiFi channel
   } wifi_ap_info_t;
 
+  /**
+   * @brief Snapshot of the connection status
+   *
+   * Published by the WiFi event handler; reading it never blocks and never
+   * calls into the WiFi driver, so UI code can poll it every frame.
+   */
+  typedef struct
+  {
+    wifi_state_t state;
+    char ssid[33]; ///< Connected network, empty if not associated
+    char ip[16];   ///< IPv4 address, empty until an address is assigned
+  } wifi_manager_status_t;
+
   /**
    * @brief WiFi manager callback function type
    * @param state Current WiFi state
@@ -49,6 +62,16 @@ extern "C"
    */
   typedef void (*wifi_manager_callback_t)(wifi_state_t state, void *user_data);
 
+  /**
+   * @brief Network consumer callback type
+   *
+   * Called after wake-up to decide whether WiFi should be brought back up.
+   *
+   * @param user_data User data pointer passed during registration
+   * @return true if the consumer needs the network now
+   */
+  typedef bool (*wifi_manager_consumer_cb_t)(void *user_data);
+
   /**
    * @brief Initialize WiFi manager
    *
@@ -128,6 +151,15 @@ extern "C"
    */
   bool wifi_manager_is_connected(void);
 
+  /**
+   * @brief Get a consistent snapshot of state, SSID and IP address
+   *
+   * Lock-free; safe from any task, including the LVGL task.
+   *
+   * @param[out] status Current status
+   */
+  void wifi_manager_get_status(wifi_manager_status_t *status);
+
   /**
    * @brief Get connected network SSID
    *
@@ -188,6 +220,66 @@ extern "C"
    */
   esp_err_t wifi_manager_auto_connect(void);
 
+  /**
+   * @brief Wait until WiFi is connected
+   *
+   * @param timeout_ms Timeout in milliseconds
+   * @return ESP_OK when connected, ESP_ERR_TIMEOUT on timeout
+   */
+  esp_err_t wifi_manager_wait_for_connection(uint32_t timeout_ms);
+
+  /**
+   * @brief Register a network consumer
+   *
+   * With the on-demand reconnect policy, WiFi is restarted after wake only
+   * if at least one registered consumer reports that it needs the network.
+   *
+   * @param name Short consumer name used in logs
+   * @param needs_network Callback returning true when the network is needed
+   * @param user_data Optional user data passed to callback
+   * @return ESP_OK on success, ESP_ERR_NO_MEM if the consumer table is full
+   */
+  esp_err_t wifi_manager_register_consumer(
+      const char *name, wifi_manager_consumer_cb_t needs_network,
+      void *user_data);
+
+  /**
+   * @brief Request a WiFi connection on behalf of a consumer
+   *
+   * Restarts the radio if it was suspended for sleep and connects using
+   * saved credentials. Returns immediately; use
+   * wifi_manager_wait_for_connection() to block until connected.
+   *
+   * @return ESP_OK if connected or connecting, error code otherwise
+   */
+  esp_err_t wifi_manager_request_connection(void);
+
+  /**
+   * @brief Stop the radio until the next connection request
+   *
+   * For a consumer that brought WiFi up itself and is done with it. The
+   * radio is left suspended exactly as after sleep, so
+   * wifi_manager_request_connection() restarts it.
+   *
+   * @return ESP_OK if the radio is stopped, error code otherwise
+   */
+  esp_err_t wifi_manager_suspend_radio(void);
+
+  /**
+   * @brief Check if the radio is currently suspended for sleep
+   *
+   * @return true if WiFi was stopped (for sleep or by
+   *         wifi_manager_suspend_radio()) and not restarted
+   */
+  bool wifi_manager_is_suspended(void);
+
+  /**
+   * @brief Get accumulated radio-on time since WiFi manager init
+   *
+   * @return Milliseconds the WiFi radio has been started
+   */
+  uint64_t wifi_manager_get_radio_on_ms(void);
+
 #ifdef __cplusplus
 }
 #endif
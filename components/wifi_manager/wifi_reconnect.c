@@ -0,0 +1,172 @@
+/**
+ * @file wifi_reconnect.c
+ * @brief WiFi reconnect policy implementation
+ */
+
+#include "wifi_reconnect.h"
+
+// wifi_err_reason_t values (esp_wifi_types.h), kept here so the policy
+// builds without ESP-IDF
+#define REASON_AUTH_EXPIRE 2
+#define REASON_AUTH_LEAVE 3
+#define REASON_DISASSOC_INACTIVITY 4
+#define REASON_NOT_AUTHED 6
+#define REASON_NOT_ASSOCED 7
+#define REASON_ASSOC_LEAVE 8
+#define REASON_MIC_FAILURE 14
+#define REASON_4WAY_HANDSHAKE_TIMEOUT 15
+#define REASON_802_1X_AUTH_FAILED 23
+#define REASON_BEACON_TIMEOUT 200
+#define REASON_NO_AP_FOUND 201
+#define REASON_AUTH_FAIL 202
+#define REASON_HANDSHAKE_TIMEOUT 204
+#define REASON_AP_TSF_RESET 206
+#define REASON_SA_QUERY_TIMEOUT 209
+#define REASON_NO_AP_COMPATIBLE_SECURITY 210
+#define REASON_NO_AP_AUTHMODE_THRESHOLD 211
+#define REASON_NO_AP_RSSI_THRESHOLD 212
+
+// Extra doublings for the no-AP class: each attempt is a full scan
+#define NO_AP_EXTRA_SHIFT 2
+
+// Beyond this the delay is at the cap for any sane base anyway
+#define MAX_SHIFT 20
+
+static uint32_t next_random(wifi_reconnect_t *r)
+{
+  uint32_t x = r->rng;
+  x ^= x << 13;
+  x ^= x >> 17;
+  x ^= x << 5;
+  r->rng = x;
+  return x;
+}
+
+void wifi_reconnect_init(wifi_reconnect_t *r, const wifi_reconnect_config_t *cfg,
+                         uint32_t seed)
+{
+  r->cfg = *cfg;
+  if (r->cfg.low_battery_factor == 0)
+  {
+    r->cfg.low_battery_factor = 1;
+  }
+  r->rng = seed ? seed : 0x9E3779B9u;
+  wifi_reconnect_reset(r);
+}
+
+void wifi_reconnect_reset(wifi_reconnect_t *r)
+{
+  r->attempt = 0;
+  r->auth_failures = 0;
+}
+
+wifi_disc_class_t wifi_reconnect_classify(uint16_t reason)
+{
+  switch (reason)
+  {
+  case REASON_ASSOC_LEAVE:
+    return WIFI_DISC_LOCAL;
+
+  case REASON_MIC_FAILURE:
+  case REASON_4WAY_HANDSHAKE_TIMEOUT:
+  case REASON_802_1X_AUTH_FAILED:
+  case REASON_AUTH_FAIL:
+  case REASON_HANDSHAKE_TIMEOUT:
+  case REASON_NO_AP_COMPATIBLE_SECURITY:
+  case REASON_NO_AP_AUTHMODE_THRESHOLD:
+    return WIFI_DISC_AUTH;
+
+  case REASON_NO_AP_FOUND:
+  case REASON_NO_AP_RSSI_THRESHOLD:
+    return WIFI_DISC_NO_AP;
+
+  case REASON_AUTH_EXPIRE:
+  case REASON_AUTH_LEAVE:
+  case REASON_DISASSOC_INACTIVITY:
+  case REASON_NOT_AUTHED:
+  case REASON_NOT_ASSOCED:
+  case REASON_BEACON_TIMEOUT:
+  case REASON_AP_TSF_RESET:
+  case REASON_SA_QUERY_TIMEOUT:
+    return WIFI_DISC_LINK_LOST;
+
+  default:
+    return WIFI_DISC_OTHER;
+  }
+}
+
+const char *wifi_reconnect_class_name(wifi_disc_class_t cls)
+{
+  switch (cls)
+  {
+  case WIFI_DISC_LOCAL:
+    return "local";
+  case WIFI_DISC_AUTH:
+    return "auth";
+  case WIFI_DISC_NO_AP:
+    return "no AP";
+  case WIFI_DISC_LINK_LOST:
+    return "link lost";
+  default:
+    return "other";
+  }
+}
+
+uint32_t wifi_reconnect_next_delay(wifi_reconnect_t *r, uint16_t reason,
+                                   bool low_battery)
+{
+  wifi_disc_class_t cls = wifi_reconnect_classify(reason);
+  if (cls == WIFI_DISC_LOCAL)
+  {
+    return WIFI_RECONNECT_GIVE_UP;
+  }
+
+  if (cls == WIFI_DISC_AUTH)
+  {
+    if (r->auth_failures >= r->cfg.auth_retries)
+    {
+      return WIFI_RECONNECT_GIVE_UP;
+    }
+    r->auth_failures++;
+  }
+  else
+  {
+    r->auth_failures = 0;
+  }
+
+  uint32_t shift = r->attempt;
+  if (r->attempt < UINT8_MAX)
+  {
+    r->attempt++;
+  }
+  if (cls == WIFI_DISC_NO_AP)
+  {
+    shift += NO_AP_EXTRA_SHIFT;
+  }
+  if (shift > MAX_SHIFT)
+  {
+    shift = MAX_SHIFT;
+  }
+
+  uint64_t base = r->cfg.base_ms;
+  uint64_t cap = r->cfg.cap_ms;
+  if (low_battery)
+  {
+    base *= r->cfg.low_battery_factor;
+    cap *= r->cfg.low_battery_factor;
+  }
+
+  uint64_t delay = base << shift;
+  if (delay > cap)
+  {
+    delay = cap;
+  }
+  if (delay >= WIFI_RECONNECT_GIVE_UP)
+  {
+    delay = WIFI_RECONNECT_GIVE_UP - 1;
+  }
+
+  // Equal jitter: keep half, randomise the other half
+  uint32_t half = (uint32_t)(delay / 2);
+  return (uint32_t)delay - half + next_random(r) % (half + 1);
+}
@@ -0,0 +1,83 @@
+/**
+ * @file wifi_reconnect.h
+ * @brief WiFi reconnect policy (internal, pure)
+ *
+ * Decides, for each station disconnect, whether and when to try again.
+ * The disconnect reason is sorted into a class first:
+ *
+ * - Local: we disconnected on purpose (scan, explicit disconnect). No retry.
+ * - Auth: wrong password or a failed handshake. A weak link can also time
+ *   out a handshake, so a few are tolerated before giving up for good.
+ * - No AP: the network is not in range. Retried, but starting slower,
+ *   since every attempt is a full scan.
+ * - Link lost / other: beacon timeout, AP kicked us, association failed.
+ *   Retried with the normal backoff.
+ *
+ * Delays grow exponentially from the base up to a cap and carry "equal
+ * jitter" (half fixed, half random), so watches dropped by the same AP do
+ * not all come back in the same instant. On low battery base and cap are
+ * stretched by a factor. Retries continue at the cap indefinitely, except
+ * for the local and auth classes.
+ *
+ * Randomness comes from a seed the caller supplies, so the policy runs on
+ * the host with fixed sequences.
+ */
+
+#ifndef WIFI_RECONNECT_H
+#define WIFI_RECONNECT_H
+
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/* Returned by wifi_reconnect_next_delay() when no retry should be made */
+#define WIFI_RECONNECT_GIVE_UP UINT32_MAX
+
+typedef enum {
+  WIFI_DISC_LOCAL,     ///< Disconnect we asked for
+  WIFI_DISC_AUTH,      ///< Bad password / handshake failure
+  WIFI_DISC_NO_AP,     ///< Network not found
+  WIFI_DISC_LINK_LOST, ///< Was associated, lost the AP
+  WIFI_DISC_OTHER,     ///< Anything else, treated as transient
+} wifi_disc_class_t;
+
+typedef struct {
+  uint32_t base_ms;           ///< First delay of the link-lost/other classes
+  uint32_t cap_ms;            ///< Longest delay
+  uint8_t low_battery_factor; ///< Base and cap multiplier on low battery
+  uint8_t auth_retries;       ///< Auth failures retried before giving up
+} wifi_reconnect_config_t;
+
+typedef struct {
+  wifi_reconnect_config_t cfg;
+  uint32_t rng;          ///< xorshift32 state, never 0
+  uint8_t attempt;       ///< Failures since the last reset
+  uint8_t auth_failures; ///< Consecutive auth-class failures
+} wifi_reconnect_t;
+
+void wifi_reconnect_init(wifi_reconnect_t *r, const wifi_reconnect_config_t *cfg,
+                         uint32_t seed);
+
+/* Forget past failures; call when connected or on an explicit connect */
+void wifi_reconnect_reset(wifi_reconnect_t *r);
+
+/* Class of a wifi_err_reason_t code */
+wifi_disc_class_t wifi_reconnect_classify(uint16_t reason);
+
+const char *wifi_reconnect_class_name(wifi_disc_class_t cls);
+
+/*
+ * Record a disconnect and return the delay before the next attempt in ms,
+ * or WIFI_RECONNECT_GIVE_UP.
+ */
+uint32_t wifi_reconnect_next_delay(wifi_reconnect_t *r, uint16_t reason,
+                                   bool low_battery);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WIFI_RECONNECT_H
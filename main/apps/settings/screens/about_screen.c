@@ -4,6 +4,7 @@
  */
 
 #include "about_screen.h"
+#include "settings.h"
 #include "bsp/esp-bsp.h"
 #include "build_time.h"
 #include "esp_app_desc.h"
@@ -55,8 +56,14 @@ static void build_info_text(char *buffer, size_t buffer_size)
   // Format uptime
   char uptime_str[32];
   char total_uptime_str[32];
+  char awake_str[32];
+  char sleep_str[32];
   uptime_tracker_format_time(uptime_stats.current_uptime_sec, uptime_str,
                              sizeof(uptime_str));
+  uptime_tracker_format_time(uptime_stats.current_awake_sec, awake_str,
+                             sizeof(awake_str));
+  uptime_tracker_format_time(uptime_stats.current_sleep_sec, sleep_str,
+                             sizeof(sleep_str));
   uptime_tracker_format_time(uptime_stats.total_uptime_sec, total_uptime_str,
                              sizeof(total_uptime_str));
 
@@ -66,6 +73,7 @@ static void build_info_text(char *buffer, size_t buffer_size)
            "Version: %s\n\n"
            "Build: %04d-%02d-%02d %02d:%02d\n\n"
            "Uptime: %s\n"
+           "Awake: %s / Asleep: %s\n"
            "Total: %s\n"
            "Boots: %u\n\n"
            "ESP-IDF: v%d.%d.%d\n"
@@ -74,7 +82,8 @@ static void build_info_text(char *buffer, size_t buffer_size)
            "Flash: %dMB %s",
            firmware_version, build_time.tm_year + 1900, build_time.tm_mon + 1,
            build_time.tm_mday, build_time.tm_hour, build_time.tm_min,
-           uptime_str, total_uptime_str, uptime_stats.boot_count,
+           uptime_str, awake_str, sleep_str, total_uptime_str,
+           uptime_stats.boot_count,
            ESP_IDF_VERSION_MAJOR, ESP_IDF_VERSION_MINOR, ESP_IDF_VERSION_PATCH,
            (chip_info.model == CHIP_ESP32C6) ? "ESP32-C6" : "Unknown",
            chip_info.revision, chip_info.cores, get_flash_size_mb(),
@@ -99,6 +108,7 @@ lv_obj_t *about_screen_create(lv_obj_t *parent)
       .show_back_button = true,
       .anim_type = SCREEN_ANIM_HORIZONTAL,
       .hide_callback = about_screen_hide,
+      .id = SETTINGS_SCREEN_ABOUT,
   };
 
   about_screen = screen_manager_create(&config);
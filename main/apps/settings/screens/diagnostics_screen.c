@@ -0,0 +1,225 @@
+/**
+ * @file diagnostics_screen.c
+ * @brief Diagnostics Screen Implementation
+ */
+
+#include "diagnostics_screen.h"
+#include "settings.h"
+#include "esp_log.h"
+#include "safe_area.h"
+#include "screen_manager.h"
+#include "wake_latency.h"
+#include <stdio.h>
+
+static const char *TAG = "DiagScreen";
+
+// Width of the text histogram bars (characters)
+#define HIST_BAR_WIDTH 12
+
+// UI elements
+static lv_obj_t *diagnostics_screen = NULL;
+static lv_obj_t *stats_label = NULL;
+
+/**
+ * @brief Append one wake source's histogram to the text buffer
+ */
+static size_t append_source_stats(char *buffer, size_t buffer_size,
+                                  wake_latency_source_t source)
+{
+  wake_latency_histogram_t h;
+  size_t len = 0;
+
+  if (wake_latency_get_histogram(source, &h) != ESP_OK || h.count == 0)
+  {
+    return snprintf(buffer, buffer_size, "%s: no samples\n\n",
+                    wake_latency_source_name(source));
+  }
+
+  len += snprintf(buffer + len, buffer_size - len,
+                  "%s: %lu wakes\navg %lu  min %lu  max %lu ms\n",
+                  wake_latency_source_name(source), (unsigned long)h.count,
+                  (unsigned long)(h.total_ms / h.count),
+                  (unsigned long)h.min_ms, (unsigned long)h.max_ms);
+
+  uint32_t peak = 0;
+  for (int b = 0; b < WAKE_LATENCY_BUCKET_COUNT; b++)
+  {
+    if (h.buckets[b] > peak)
+    {
+      peak = h.buckets[b];
+    }
+  }
+
+  for (int b = 0; b < WAKE_LATENCY_BUCKET_COUNT && len < buffer_size; b++)
+  {
+    if (h.buckets[b] == 0)
+    {
+      continue;
+    }
+
+    char bar[HIST_BAR_WIDTH + 1];
+    int bar_len = (int)((h.buckets[b] * HIST_BAR_WIDTH + peak - 1) / peak);
+    for (int i = 0; i < bar_len; i++)
+    {
+      bar[i] = '#';
+    }
+    bar[bar_len] = '\0';
+
+    uint32_t limit = wake_latency_bucket_limit_ms(b);
+    if (limit == UINT32_MAX)
+    {
+      len += snprintf(buffer + len, buffer_size - len, ">1s   %s %lu\n", bar,
+                      (unsigned long)h.buckets[b]);
+    }
+    else
+    {
+      len += snprintf(buffer + len, buffer_size - len, "<%-4lu %s %lu\n",
+                      (unsigned long)limit, bar, (unsigned long)h.buckets[b]);
+    }
+  }
+
+  if (len < buffer_size)
+  {
+    len += snprintf(buffer + len, buffer_size - len, "\n");
+  }
+  return len;
+}
+
+/**
+ * @brief Build the statistics text for all wake sources
+ */
+static void build_stats_text(char *buffer, size_t buffer_size)
+{
+  size_t len = snprintf(buffer, buffer_size, "Wake latency (touch-to-photon)\n\n");
+
+  for (int s = 0; s < WAKE_LATENCY_SOURCE_COUNT && len < buffer_size; s++)
+  {
+    len += append_source_stats(buffer + len, buffer_size - len,
+                               (wake_latency_source_t)s);
+  }
+}
+
+static void refresh_stats(void)
+{
+  if (!stats_label)
+  {
+    return;
+  }
+
+  char stats_text[1024];
+  build_stats_text(stats_text, sizeof(stats_text));
+  lv_label_set_text(stats_label, stats_text);
+}
+
+/**
+ * @brief Dump button callback
+ */
+static void dump_btn_cb(lv_event_t *e)
+{
+  (void)e;
+  wake_latency_dump();
+}
+
+/**
+ * @brief Reset button callback
+ */
+static void reset_btn_cb(lv_event_t *e)
+{
+  (void)e;
+  wake_latency_reset();
+  refresh_stats();
+}
+
+static lv_obj_t *create_button(lv_obj_t *parent, const char *text,
+                               uint32_t color, lv_event_cb_t cb)
+{
+  lv_obj_t *btn = lv_btn_create(parent);
+  lv_obj_set_size(btn, LV_PCT(90), 50);
+  lv_obj_set_style_bg_color(btn, lv_color_hex(color), 0);
+  lv_obj_add_event_cb(btn, cb, LV_EVENT_CLICKED, NULL);
+
+  lv_obj_t *label = lv_label_create(btn);
+  lv_label_set_text(label, text);
+  lv_obj_set_style_text_font(label, &lv_font_montserrat_18, 0);
+  lv_obj_center(label);
+  return btn;
+}
+
+lv_obj_t *diagnostics_screen_create(lv_obj_t *parent)
+{
+  (void)parent;
+
+  // Return existing screen if already created
+  if (diagnostics_screen)
+  {
+    ESP_LOGI(TAG, "Diagnostics screen already exists, returning existing");
+    return diagnostics_screen;
+  }
+
+  ESP_LOGI(TAG, "Creating diagnostics screen");
+
+  screen_config_t config = {
+      .title = "Diagnostics",
+      .show_back_button = true,
+      .anim_type = SCREEN_ANIM_HORIZONTAL,
+      .hide_callback = diagnostics_screen_hide,
+      .id = SETTINGS_SCREEN_DIAGNOSTICS,
+  };
+
+  diagnostics_screen = screen_manager_create(&config);
+  if (!diagnostics_screen)
+  {
+    ESP_LOGE(TAG, "Failed to create diagnostics screen");
+    return NULL;
+  }
+
+  // Scrollable column with statistics and actions
+  lv_obj_t *container = lv_obj_create(diagnostics_screen);
+  lv_obj_set_size(container, LV_PCT(90), LV_PCT(75));
+  lv_obj_align(container, LV_ALIGN_TOP_MID, 0, SAFE_AREA_TOP + 70);
+  lv_obj_set_style_bg_color(container, lv_color_hex(0x1a1a1a), 0);
+  lv_obj_set_style_border_width(container, 1, 0);
+  lv_obj_set_style_border_color(container, lv_color_hex(0x444444), 0);
+  lv_obj_set_flex_flow(container, LV_FLEX_FLOW_COLUMN);
+  lv_obj_set_flex_align(container, LV_FLEX_ALIGN_START, LV_FLEX_ALIGN_CENTER,
+                        LV_FLEX_ALIGN_CENTER);
+  lv_obj_set_style_pad_row(container, 10, 0);
+  lv_obj_set_scrollbar_mode(container, LV_SCROLLBAR_MODE_AUTO);
+  lv_obj_set_scroll_dir(container, LV_DIR_VER);
+
+  stats_label = lv_label_create(container);
+  lv_obj_set_width(stats_label, LV_PCT(95));
+  lv_obj_set_style_text_font(stats_label, &lv_font_montserrat_14, 0);
+  lv_obj_set_style_text_color(stats_label, lv_color_white(), 0);
+  lv_label_set_long_mode(stats_label, LV_LABEL_LONG_WRAP);
+
+  create_button(container, LV_SYMBOL_UPLOAD " Dump to Serial", 0x0066CC,
+                dump_btn_cb);
+  create_button(container, LV_SYMBOL_REFRESH " Reset Stats", 0xFF6600,
+                reset_btn_cb);
+
+  refresh_stats();
+
+  ESP_LOGI(TAG, "Diagnostics screen created");
+  return diagnostics_screen;
+}
+
+void diagnostics_screen_show(void)
+{
+  if (diagnostics_screen)
+  {
+    ESP_LOGI(TAG, "Showing diagnostics screen");
+    refresh_stats();
+    screen_manager_show(diagnostics_screen);
+  }
+  else
+  {
+    ESP_LOGW(TAG, "Diagnostics screen not created");
+  }
+}
+
+void diagnostics_screen_hide(void)
+{
+  ESP_LOGI(TAG, "Hiding diagnostics screen");
+  // Cleanup only - screen_manager_go_back() is already handling navigation
+}
@@ -0,0 +1,46 @@
+/**
+ * @file diagnostics_screen.h
+ * @brief Diagnostics Screen - Wake Latency Statistics
+ *
+ * Screen showing the touch-to-photon wake latency histogram per wake
+ * source (touch vs button) collected by the sleep manager.
+ */
+
+#ifndef DIAGNOSTICS_SCREEN_H
+#define DIAGNOSTICS_SCREEN_H
+
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create the diagnostics screen
+ *
+ * Creates a screen with:
+ * - Wake latency summary and histogram per wake source
+ * - Dump to serial button
+ * - Reset statistics button
+ * - Back button
+ *
+ * @param parent Parent LVGL object
+ * @return lv_obj_t* Pointer to the created screen object
+ */
+lv_obj_t *diagnostics_screen_create(lv_obj_t *parent);
+
+/**
+ * @brief Show the diagnostics screen (refreshes the statistics)
+ */
+void diagnostics_screen_show(void);
+
+/**
+ * @brief Hide the diagnostics screen
+ */
+void diagnostics_screen_hide(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DIAGNOSTICS_SCREEN_H
@@ -4,6 +4,7 @@
  */
 
 #include "display_settings.h"
+#include "settings.h"
 #include "bsp/esp-bsp.h"
 #include "esp_log.h"
 #include "safe_area.h"
@@ -128,6 +129,7 @@ lv_obj_t *display_settings_create(lv_obj_t *parent)
       .show_back_button = true,
       .anim_type = SCREEN_ANIM_HORIZONTAL,
       .hide_callback = display_settings_hide,
+      .id = SETTINGS_SCREEN_DISPLAY,
   };
 
   display_settings_screen = screen_manager_create(&config);
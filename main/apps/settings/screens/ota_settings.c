@@ -4,11 +4,16 @@
  */
 
 #include "ota_settings.h"
+#include "settings.h"
 #include "bsp/esp-bsp.h"
 #include "esp_log.h"
+#include "event_bus.h"
 #include "safe_area.h"
 #include "screen_manager.h"
 #include "ota_manager.h"
+#ifdef CONFIG_ENABLE_WIFI
+#include "wifi_manager.h"
+#endif
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include <string.h>
@@ -36,7 +41,8 @@ static void ota_check_event_cb(lv_event_t *e);
 static void ota_update_event_cb(lv_event_t *e);
 static void ota_settings_hide(void);
 static void ota_update_task(void *param);
-static void ota_progress_cb(ota_state_t state, uint8_t progress, void *user_data);
+static void ota_check_task(void *param);
+static void ota_progress_event_cb(const event_t *event, void *user_data);
 static void ota_set_buttons_enabled(bool enabled);
 static void ota_update_status_text(const char *text, bool lock_display);
 
@@ -59,6 +65,27 @@ static void ota_set_buttons_enabled(bool enabled)
     }
 }
 
+// Caller holds the display lock
+static void ota_show_latest(void)
+{
+    if (!latest_version_label)
+    {
+        return;
+    }
+
+    ota_version_info_t latest;
+    if (ota_manager_get_latest(&latest) != ESP_OK)
+    {
+        lv_label_set_text(latest_version_label, "Latest Version: ---");
+        return;
+    }
+
+    char latest_text[80];
+    snprintf(latest_text, sizeof(latest_text), "Latest Version: %s%s",
+             latest.version, latest.update_available ? " (update available)" : "");
+    lv_label_set_text(latest_version_label, latest_text);
+}
+
 static void ota_update_status_text(const char *text, bool lock_display)
 {
     if (!status_label || !text)
@@ -79,7 +106,8 @@ static void ota_update_status_text(const char *text, bool lock_display)
     }
 }
 
-static void ota_progress_cb(ota_state_t state, uint8_t progress, void *user_data)
+// Event bus UI context: the display lock is already held
+static void ota_progress_event_cb(const event_t *event, void *user_data)
 {
     (void)user_data;
 
@@ -88,7 +116,8 @@ static void ota_progress_cb(ota_state_t state, uint8_t progress, void *user_data
         return;
     }
 
-    bsp_display_lock(0);
+    ota_state_t state = (ota_state_t)event->ota.state;
+    uint8_t progress = event->ota.percent;
 
     switch (state)
     {
@@ -99,8 +128,23 @@ static void ota_progress_cb(ota_state_t state, uint8_t progress, void *user_data
         lv_label_set_text(status_label, "Status: Downloading...");
         lv_bar_set_value(progress_bar, progress, LV_ANIM_OFF);
         {
-            char progress_text[32];
-            snprintf(progress_text, sizeof(progress_text), "Progress: %u%%", progress);
+            ota_status_t status;
+            ota_manager_get_status(&status);
+
+            char progress_text[48];
+            if (status.bytes_total > 0)
+            {
+                snprintf(progress_text, sizeof(progress_text),
+                         "Progress: %lu / %lu KB (%u%%)",
+                         (unsigned long)(status.bytes_done / 1024),
+                         (unsigned long)(status.bytes_total / 1024), progress);
+            }
+            else
+            {
+                snprintf(progress_text, sizeof(progress_text),
+                         "Progress: %lu KB",
+                         (unsigned long)(status.bytes_done / 1024));
+            }
             lv_label_set_text(progress_label, progress_text);
         }
         break;
@@ -121,8 +165,6 @@ static void ota_progress_cb(ota_state_t state, uint8_t progress, void *user_data
         lv_label_set_text(status_label, "Status: Idle");
         break;
     }
-
-    bsp_display_unlock();
 }
 
 lv_obj_t *ota_settings_create(lv_obj_t *parent)
@@ -142,6 +184,7 @@ lv_obj_t *ota_settings_create(lv_obj_t *parent)
         .show_back_button = true,
         .anim_type = SCREEN_ANIM_HORIZONTAL,
         .hide_callback = ota_settings_hide,
+        .id = SETTINGS_SCREEN_OTA,
     };
 
     ota_screen = screen_manager_create(&config);
@@ -205,7 +248,14 @@ lv_obj_t *ota_settings_create(lv_obj_t *parent)
     lv_label_set_text(update_label, "Start OTA Update");
     lv_obj_center(update_label);
 
-    ota_manager_register_callback(ota_progress_cb, NULL);
+    // Once per boot; the handler does nothing while the screen is closed
+    static bool subscribed = false;
+    if (!subscribed)
+    {
+        subscribed = event_bus_subscribe(EVENT_MASK(EVENT_OTA_PROGRESS),
+                                         EVENT_CTX_UI, ota_progress_event_cb,
+                                         NULL) == ESP_OK;
+    }
 
     ESP_LOGI(TAG, "OTA settings screen created");
     return ota_screen;
@@ -236,6 +286,8 @@ void ota_settings_show(void)
         lv_label_set_text(current_version_label, "Current Version: ---");
     }
 
+    ota_show_latest();
+
     char update_url[256] = {0};
     if (ota_manager_get_update_url(update_url, sizeof(update_url)) == ESP_OK)
     {
@@ -268,8 +320,6 @@ static void ota_settings_hide(void)
 {
     ESP_LOGI(TAG, "Hiding OTA settings screen");
 
-    ota_manager_register_callback(NULL, NULL);
-
     ota_screen = NULL;
     status_label = NULL;
     current_version_label = NULL;
@@ -295,20 +345,17 @@ static void ota_check_event_cb(lv_event_t *e)
         return;
     }
 
+    update_in_progress = true;
+    ota_set_buttons_enabled(false);
     ota_update_status_text("Status: Checking...", false);
 
-    ota_version_info_t info = {0};
-    esp_err_t ret = ota_manager_check_for_update(NULL, &info);
-    if (ret == ESP_OK)
-    {
-        char latest_text[64];
-        snprintf(latest_text, sizeof(latest_text), "Latest Version: %s", info.version);
-        lv_label_set_text(latest_version_label, latest_text);
-        ota_update_status_text("Status: Check complete", false);
-    }
-    else
+    // The check blocks on the network; keep it off the UI thread
+    if (xTaskCreate(ota_check_task, "ota_check_task", 4096, NULL, 5, NULL) != pdPASS)
     {
-        ota_update_status_text("Status: Check failed", false);
+        ESP_LOGE(TAG, "Failed to start check task");
+        update_in_progress = false;
+        ota_set_buttons_enabled(true);
+        ota_update_status_text("Status: Failed to start task", false);
     }
 }
 
@@ -341,16 +388,74 @@ static void ota_update_event_cb(lv_event_t *e)
     }
 }
 
+/**
+ * @brief Make sure WiFi is up, re-enabling the radio if it was suspended
+ *
+ * On failure the status shows why and the buttons are enabled again.
+ */
+static bool ota_ensure_wifi(void)
+{
+#ifdef CONFIG_ENABLE_WIFI
+    // Radio may have been suspended during sleep
+    if (!wifi_manager_is_connected())
+    {
+        ota_update_status_text("Status: Connecting WiFi...", true);
+        if (wifi_manager_request_connection() != ESP_OK ||
+            wifi_manager_wait_for_connection(15000) != ESP_OK)
+        {
+            update_in_progress = false;
+            ota_update_status_text("Status: WiFi unavailable", true);
+            bsp_display_lock(0);
+            ota_set_buttons_enabled(true);
+            bsp_display_unlock();
+            return false;
+        }
+    }
+#endif
+    return true;
+}
+
+static void ota_check_task(void *param)
+{
+    (void)param;
+
+    if (ota_ensure_wifi())
+    {
+        esp_err_t ret = ota_manager_check_for_update(NULL, NULL);
+
+        update_in_progress = false;
+        bsp_display_lock(0);
+        ota_show_latest();
+        if (status_label)
+        {
+            lv_label_set_text(status_label, ret == ESP_OK ? "Status: Check complete"
+                                                          : "Status: Check failed");
+        }
+        ota_set_buttons_enabled(true);
+        bsp_display_unlock();
+    }
+
+    vTaskDelete(NULL);
+}
+
 static void ota_update_task(void *param)
 {
     (void)param;
 
+    if (!ota_ensure_wifi())
+    {
+        vTaskDelete(NULL);
+        return;
+    }
+
     esp_err_t ret = ota_manager_start_update(NULL);
     if (ret != ESP_OK)
     {
         update_in_progress = false;
         ota_update_status_text("Status: Update failed", true);
+        bsp_display_lock(0);
         ota_set_buttons_enabled(true);
+        bsp_display_unlock();
     }
 
     vTaskDelete(NULL);
@@ -4,6 +4,7 @@
  */
 
 #include "system_settings.h"
+#include "settings.h"
 #include "bsp/esp-bsp.h"
 #include "esp_heap_caps.h"
 #include "esp_log.h"
@@ -341,6 +342,7 @@ lv_obj_t *system_settings_create(lv_obj_t *parent)
       .show_back_button = true,
       .anim_type = SCREEN_ANIM_HORIZONTAL,
       .hide_callback = system_settings_hide,
+      .id = SETTINGS_SCREEN_SYSTEM,
   };
 
   system_settings_screen = screen_manager_create(&config);
@@ -4,8 +4,10 @@
  */
 
 #include "time_sync.h"
+#include "settings.h"
 #include "bsp/esp-bsp.h"
 #include "esp_log.h"
+#include "event_bus.h"
 #include "ntp_client.h"
 #include "safe_area.h"
 #include "screen_manager.h"
@@ -24,6 +26,7 @@ static const char *TAG = "TimeSync";
 static lv_obj_t *time_sync_screen = NULL;
 static lv_obj_t *status_label = NULL;
 static lv_obj_t *last_sync_label = NULL;
+static lv_obj_t *quality_label = NULL;
 static lv_obj_t *server_label = NULL;
 static lv_obj_t *timezone_dropdown = NULL;
 static lv_obj_t *dst_switch = NULL;
@@ -39,6 +42,7 @@ static void time_sync_hide(void)
     time_sync_screen = NULL;
     status_label = NULL;
     last_sync_label = NULL;
+    quality_label = NULL;
     server_label = NULL;
     timezone_dropdown = NULL;
     dst_switch = NULL;
@@ -138,6 +142,47 @@ static void update_last_sync_label(void)
     lv_label_set_text(last_sync_label, buffer);
 }
 
+static void update_quality_label(void)
+{
+    ntp_client_status_t status;
+    ntp_client_get_status(&status);
+
+    if (status.syncing)
+    {
+        lv_label_set_text(quality_label, "Syncing...");
+    }
+    else if (status.stratum == 0)
+    {
+        lv_label_set_text(quality_label, "Offset: ---");
+    }
+    else
+    {
+        char buffer[80];
+        snprintf(buffer, sizeof(buffer),
+                 "Offset %+lld ms, RTT %lu ms\nStratum %u, took %lu.%lu s",
+                 (long long)status.offset_ms, (unsigned long)status.rtt_ms,
+                 status.stratum, (unsigned long)(status.duration_ms / 1000),
+                 (unsigned long)(status.duration_ms % 1000 / 100));
+        lv_label_set_text(quality_label, buffer);
+    }
+}
+
+// Event bus UI context: the display lock is already held
+static void time_sync_event_cb(const event_t *event, void *user_data)
+{
+    (void)user_data;
+
+    if (!time_sync_screen)
+    {
+        return;
+    }
+
+    lv_label_set_text(status_label, event->time_sync.ok ? "Status: Synced"
+                                                        : "Status: Sync failed");
+    update_last_sync_label();
+    update_quality_label();
+}
+
 static void update_server_label(void)
 {
     char server[64] = {0};
@@ -158,8 +203,12 @@ static void sync_button_event_cb(lv_event_t *e)
 #ifdef CONFIG_ENABLE_WIFI
     if (!wifi_manager_is_connected())
     {
+        // Radio may be off after sleep - bring it up, sync on connect
+        esp_err_t wifi_ret = wifi_manager_request_connection();
         bsp_display_lock(0);
-        lv_label_set_text(status_label, "WiFi disconnected");
+        lv_label_set_text(status_label, wifi_ret == ESP_OK
+                                            ? "Connecting WiFi..."
+                                            : "WiFi disconnected");
         bsp_display_unlock();
         return;
     }
@@ -230,11 +279,21 @@ lv_obj_t *time_sync_create(lv_obj_t *parent)
         return time_sync_screen;
     }
 
+    // Once per boot; the handler does nothing while the screen is closed
+    static bool subscribed = false;
+    if (!subscribed)
+    {
+        subscribed = event_bus_subscribe(EVENT_MASK(EVENT_TIME_SYNC),
+                                         EVENT_CTX_UI, time_sync_event_cb,
+                                         NULL) == ESP_OK;
+    }
+
     screen_config_t config = {
         .title = "Time & Sync",
         .show_back_button = true,
         .anim_type = SCREEN_ANIM_HORIZONTAL,
         .hide_callback = time_sync_hide,
+        .id = SETTINGS_SCREEN_TIME_SYNC,
     };
 
     time_sync_screen = screen_manager_create(&config);
@@ -264,6 +323,10 @@ lv_obj_t *time_sync_create(lv_obj_t *parent)
     lv_label_set_text(last_sync_label, "Last Sync: ---");
     lv_obj_set_style_text_font(last_sync_label, &lv_font_montserrat_14, 0);
 
+    quality_label = lv_label_create(container);
+    lv_label_set_text(quality_label, "Offset: ---");
+    lv_obj_set_style_text_font(quality_label, &lv_font_montserrat_14, 0);
+
     server_label = lv_label_create(container);
     lv_label_set_text(server_label, "Server: ---");
     lv_obj_set_style_text_font(server_label, &lv_font_montserrat_14, 0);
@@ -354,6 +417,7 @@ void time_sync_update_status(void)
 #endif
 
     update_last_sync_label();
+    update_quality_label();
     update_server_label();
 
     char timezone[16] = {0};
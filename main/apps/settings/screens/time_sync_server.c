@@ -4,6 +4,7 @@
  */
 
 #include "time_sync_server.h"
+#include "settings.h"
 #include "bsp/esp-bsp.h"
 #include "esp_err.h"
 #include "esp_log.h"
@@ -81,6 +82,7 @@ lv_obj_t *time_sync_server_create(void)
         .show_back_button = true,
         .anim_type = SCREEN_ANIM_HORIZONTAL,
         .hide_callback = time_sync_server_hide,
+        .id = SETTINGS_SCREEN_TIME_SYNC_SERVER,
     };
 
     server_screen = screen_manager_create(&config);
@@ -4,6 +4,7 @@
  */
 
 #include "wifi_scan.h"
+#include "settings.h"
 #include "bsp/esp-bsp.h"
 #include "esp_log.h"
 #include "safe_area.h"
@@ -53,6 +54,7 @@ lv_obj_t *wifi_scan_create(lv_obj_t *parent)
       .show_back_button = true,
       .anim_type = SCREEN_ANIM_HORIZONTAL,
       .hide_callback = wifi_scan_hide,
+      .id = SETTINGS_SCREEN_WIFI_SCAN,
   };
 
   wifi_scan_screen = screen_manager_create(&config);
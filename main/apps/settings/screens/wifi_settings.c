@@ -4,9 +4,11 @@
  */
 
 #include "wifi_settings.h"
+#include "settings.h"
 #include "../settings.h"
 #include "bsp/esp-bsp.h"
 #include "esp_log.h"
+#include "event_bus.h"
 #include "safe_area.h"
 #include "screen_manager.h"
 #include "wifi_manager.h"
@@ -30,9 +32,10 @@ static lv_timer_t *status_timer = NULL;
 static void scan_button_event_cb(lv_event_t *e);
 static void disconnect_button_event_cb(lv_event_t *e);
 static void forget_button_event_cb(lv_event_t *e);
-static void update_connection_info(void);
+static void update_connection_info(const wifi_manager_status_t *status);
 static void wifi_settings_update_status_internal(bool lock_display);
 static void wifi_status_timer_cb(lv_timer_t *timer);
+static void wifi_state_event_cb(const event_t *event, void *user_data);
 static const char *get_signal_indicator(int8_t rssi);
 static void wifi_settings_hide(void);
 
@@ -47,12 +50,21 @@ lv_obj_t *wifi_settings_create(lv_obj_t *parent)
 
   ESP_LOGI(TAG, "Creating WiFi settings screen");
 
+  // Once per boot; the handler does nothing while the screen is closed
+  static bool subscribed = false;
+  if (!subscribed)
+  {
+    subscribed = event_bus_subscribe(EVENT_MASK(EVENT_WIFI_STATE), EVENT_CTX_UI,
+                                     wifi_state_event_cb, NULL) == ESP_OK;
+  }
+
   // Create screen using screen_manager
   screen_config_t config = {
       .title = "WiFi",
       .show_back_button = true,
       .anim_type = SCREEN_ANIM_HORIZONTAL,
       .hide_callback = wifi_settings_hide,
+      .id = SETTINGS_SCREEN_WIFI,
   };
 
   wifi_settings_screen = screen_manager_create(&config);
@@ -193,9 +205,11 @@ static void wifi_settings_update_status_internal(bool lock_display)
     bsp_display_lock(0);
   }
 
-  wifi_state_t state = wifi_manager_get_state();
+  // One snapshot so state, SSID and IP always agree
+  wifi_manager_status_t status;
+  wifi_manager_get_status(&status);
 
-  switch (state)
+  switch (status.state)
   {
   case WIFI_STATE_SCANNING:
     lv_label_set_text(status_label, "Status: Scanning...");
@@ -226,7 +240,7 @@ static void wifi_settings_update_status_internal(bool lock_display)
 
   case WIFI_STATE_CONNECTED:
     lv_label_set_text(status_label, "Status: Connected");
-    update_connection_info();
+    update_connection_info(&status);
     lv_obj_clear_flag(disconnect_btn, LV_OBJ_FLAG_HIDDEN);
     lv_obj_clear_flag(forget_btn, LV_OBJ_FLAG_HIDDEN);
     break;
@@ -253,17 +267,23 @@ static void wifi_status_timer_cb(lv_timer_t *timer)
   wifi_settings_update_status_internal(false);
 }
 
-static void update_connection_info(void)
+// Event bus UI context: the display lock is already held
+static void wifi_state_event_cb(const event_t *event, void *user_data)
+{
+  (void)event;
+  (void)user_data;
+  wifi_settings_update_status_internal(false);
+}
+
+static void update_connection_info(const wifi_manager_status_t *status)
 {
-  char ssid[33] = {0};
-  char ip[16] = {0};
   int8_t rssi = 0;
   char buffer[64];
 
   // Get SSID
-  if (wifi_manager_get_connected_ssid(ssid, sizeof(ssid)) == ESP_OK)
+  if (status->ssid[0] != '\0')
   {
-    snprintf(buffer, sizeof(buffer), "Network: %s", ssid);
+    snprintf(buffer, sizeof(buffer), "Network: %s", status->ssid);
     lv_label_set_text(ssid_label, buffer);
   }
   else
@@ -284,9 +304,9 @@ static void update_connection_info(void)
   }
 
   // Get IP address
-  if (wifi_manager_get_ip_address(ip, sizeof(ip)) == ESP_OK)
+  if (status->ip[0] != '\0')
   {
-    snprintf(buffer, sizeof(buffer), "IP: %s", ip);
+    snprintf(buffer, sizeof(buffer), "IP: %s", status->ip);
     lv_label_set_text(ip_label, buffer);
   }
   else
@@ -29,7 +29,8 @@ void wifi_settings_show(void);
 /**
  * @brief Update WiFi status display
  *
- * Called by wifi_manager callback when connection state changes.
+ * Takes the display lock. State changes also refresh the screen through
+ * the event bus.
  */
 void wifi_settings_update_status(void);
 
@@ -8,16 +8,19 @@
 #include "esp_log.h"
 #include "screen_manager.h"
 #include "screens/about_screen.h"
+#include "screens/diagnostics_screen.h"
 #include "screens/display_settings.h"
 #include "screens/system_settings.h"
 #include "screens/time_sync.h"
+#include "screens/time_sync_server.h"
 #ifdef CONFIG_ENABLE_OTA
 #include "screens/ota_settings.h"
 #endif
 #ifdef CONFIG_ENABLE_WIFI
+#include "screens/wifi_scan.h"
 #include "screens/wifi_settings.h"
 #endif
-#include <string.h>
+#include <stdint.h>
 
 static const char *TAG = "Settings";
 
@@ -26,16 +29,21 @@ static lv_obj_t *settings_screen = NULL;
 static lv_obj_t *main_menu_list = NULL;
 static lv_obj_t *tileview = NULL; // Reference to main tileview for navigation
 
+// Last menu item opened (restored with the UI state snapshot)
+static int selected_item = -1;
+
 // Forward declarations
 static void menu_item_event_cb(lv_event_t *e);
 
 /**
  * @brief Helper function to create a menu item with consistent styling
  */
-static void add_menu_item(const char *icon, const char *text)
+static void add_menu_item(const char *icon, const char *text,
+                          settings_screen_id_t id)
 {
   lv_obj_t *item = lv_list_add_btn(main_menu_list, icon, text);
-  lv_obj_add_event_cb(item, menu_item_event_cb, LV_EVENT_CLICKED, NULL);
+  lv_obj_add_event_cb(item, menu_item_event_cb, LV_EVENT_CLICKED,
+                      (void *)(uintptr_t)id);
   lv_obj_set_style_text_font(item, &lv_font_montserrat_20, 0);
   lv_obj_set_height(item, 60);
 }
@@ -53,62 +61,97 @@ static void menu_item_event_cb(lv_event_t *e)
   }
 
   lv_obj_t *item = lv_event_get_target(e);
-  const char *text = lv_list_get_btn_text(main_menu_list, item);
+  settings_screen_id_t id =
+      (settings_screen_id_t)(uintptr_t)lv_event_get_user_data(e);
 
-  // Early return if text is NULL for safety
-  if (!text)
-  {
-    ESP_LOGW(TAG, "Menu item clicked but text is NULL");
-    return;
-  }
+  ESP_LOGI(TAG, "Menu item clicked: %s",
+           lv_list_get_btn_text(main_menu_list, item));
 
-  ESP_LOGI(TAG, "Menu item clicked: %s", text);
+  settings_set_selected_item(lv_obj_get_index(item));
+  settings_open_screen(id);
+}
 
-  // Navigate to specific settings screens
+esp_err_t settings_open_screen(settings_screen_id_t id)
+{
   // Create screens on-demand to avoid navigation stack corruption
-  if (strcmp(text, "Display") == 0)
+  switch (id)
   {
+  case SETTINGS_SCREEN_DISPLAY:
     display_settings_create(settings_screen);
     display_settings_show();
-  }
-  else if (strcmp(text, "System") == 0)
-  {
+    return ESP_OK;
+
+  case SETTINGS_SCREEN_SYSTEM:
     system_settings_create(settings_screen);
     system_settings_show();
-  }
-  else if (strcmp(text, "Time & Sync") == 0)
-  {
+    return ESP_OK;
+
+  case SETTINGS_SCREEN_TIME_SYNC:
 #ifdef CONFIG_NTP_CLIENT_ENABLE
     time_sync_create(settings_screen);
     time_sync_show();
+    return ESP_OK;
 #else
     ESP_LOGI(TAG, "Time & Sync disabled in menuconfig");
+    return ESP_ERR_NOT_SUPPORTED;
 #endif
-  }
-  else if (strcmp(text, "WiFi") == 0)
-  {
+
+  case SETTINGS_SCREEN_TIME_SYNC_SERVER:
+#ifdef CONFIG_NTP_CLIENT_ENABLE
+    time_sync_server_show();
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+
+  case SETTINGS_SCREEN_WIFI:
 #ifdef CONFIG_ENABLE_WIFI
     wifi_settings_create(settings_screen);
     wifi_settings_show();
+    return ESP_OK;
 #else
     ESP_LOGI(TAG, "WiFi disabled in menuconfig");
+    return ESP_ERR_NOT_SUPPORTED;
 #endif
-  }
-  else if (strcmp(text, "OTA Updates") == 0)
-  {
+
+  case SETTINGS_SCREEN_WIFI_SCAN:
+#ifdef CONFIG_ENABLE_WIFI
+    wifi_scan_show();
+    return ESP_OK;
+#else
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+
+  case SETTINGS_SCREEN_OTA:
 #ifdef CONFIG_ENABLE_OTA
     ota_settings_create(settings_screen);
     ota_settings_show();
+    return ESP_OK;
 #else
     ESP_LOGI(TAG, "OTA disabled in menuconfig");
+    return ESP_ERR_NOT_SUPPORTED;
 #endif
-  }
-  else if (strcmp(text, "About") == 0)
-  {
+
+  case SETTINGS_SCREEN_DIAGNOSTICS:
+#ifdef CONFIG_SLEEP_MANAGER_WAKE_LATENCY_STATS
+    diagnostics_screen_create(settings_screen);
+    diagnostics_screen_show();
+    return ESP_OK;
+#else
+    ESP_LOGI(TAG, "Wake latency statistics disabled in menuconfig");
+    return ESP_ERR_NOT_SUPPORTED;
+#endif
+
+  case SETTINGS_SCREEN_ABOUT:
     bsp_display_lock(0);
     about_screen_create(settings_screen);
     about_screen_show();
     bsp_display_unlock();
+    return ESP_OK;
+
+  default:
+    ESP_LOGW(TAG, "Unknown settings screen id %d", (int)id);
+    return ESP_ERR_INVALID_ARG;
   }
 }
 
@@ -126,16 +169,19 @@ static void create_main_menu(lv_obj_t *parent)
   lv_obj_set_style_border_color(main_menu_list, lv_color_hex(0x444444), 0);
 
   // Add menu items
-  add_menu_item(LV_SYMBOL_EYE_OPEN, "Display");
-  add_menu_item(LV_SYMBOL_SETTINGS, "System");
-  add_menu_item(LV_SYMBOL_REFRESH, "Time & Sync");
+  add_menu_item(LV_SYMBOL_EYE_OPEN, "Display", SETTINGS_SCREEN_DISPLAY);
+  add_menu_item(LV_SYMBOL_SETTINGS, "System", SETTINGS_SCREEN_SYSTEM);
+  add_menu_item(LV_SYMBOL_REFRESH, "Time & Sync", SETTINGS_SCREEN_TIME_SYNC);
 #ifdef CONFIG_ENABLE_WIFI
-  add_menu_item(LV_SYMBOL_WIFI, "WiFi");
+  add_menu_item(LV_SYMBOL_WIFI, "WiFi", SETTINGS_SCREEN_WIFI);
 #endif
 #ifdef CONFIG_ENABLE_OTA
-  add_menu_item(LV_SYMBOL_DOWNLOAD, "OTA Updates");
+  add_menu_item(LV_SYMBOL_DOWNLOAD, "OTA Updates", SETTINGS_SCREEN_OTA);
 #endif
-  add_menu_item(LV_SYMBOL_LIST, "About");
+#ifdef CONFIG_SLEEP_MANAGER_WAKE_LATENCY_STATS
+  add_menu_item(LV_SYMBOL_CHARGE, "Diagnostics", SETTINGS_SCREEN_DIAGNOSTICS);
+#endif
+  add_menu_item(LV_SYMBOL_LIST, "About", SETTINGS_SCREEN_ABOUT);
 
   ESP_LOGI(TAG, "Main menu created");
 }
@@ -193,3 +239,48 @@ void settings_set_tileview(lv_obj_t *tv)
   tileview = tv;
   ESP_LOGI(TAG, "Tileview reference set: %p", tileview);
 }
+
+int settings_get_selected_item(void) { return selected_item; }
+
+void settings_set_selected_item(int index)
+{
+  if (!main_menu_list)
+  {
+    return;
+  }
+
+  // Move the highlight from the previous item
+  lv_obj_t *previous = (selected_item >= 0)
+                           ? lv_obj_get_child(main_menu_list, selected_item)
+                           : NULL;
+  if (previous)
+  {
+    lv_obj_remove_state(previous, LV_STATE_CHECKED);
+  }
+
+  lv_obj_t *item = (index >= 0) ? lv_obj_get_child(main_menu_list, index)
+                                : NULL;
+  if (item)
+  {
+    lv_obj_add_state(item, LV_STATE_CHECKED);
+    selected_item = index;
+  }
+  else
+  {
+    selected_item = -1;
+  }
+}
+
+int32_t settings_get_menu_scroll(void)
+{
+  return main_menu_list ? lv_obj_get_scroll_y(main_menu_list) : 0;
+}
+
+void settings_set_menu_scroll(int32_t scroll_y)
+{
+  if (main_menu_list)
+  {
+    lv_obj_update_layout(main_menu_list);
+    lv_obj_scroll_to_y(main_menu_list, scroll_y, LV_ANIM_OFF);
+  }
+}
@@ -8,12 +8,29 @@
 #ifndef SETTINGS_H
 #define SETTINGS_H
 
+#include "esp_err.h"
 #include "lvgl.h"
 
 #ifdef __cplusplus
 extern "C" {
 #endif
 
+/**
+ * @brief Settings screen ids (stored in UI state snapshots, keep stable)
+ */
+typedef enum {
+  SETTINGS_SCREEN_NONE = 0,
+  SETTINGS_SCREEN_DISPLAY,
+  SETTINGS_SCREEN_SYSTEM,
+  SETTINGS_SCREEN_TIME_SYNC,
+  SETTINGS_SCREEN_TIME_SYNC_SERVER,
+  SETTINGS_SCREEN_WIFI,
+  SETTINGS_SCREEN_WIFI_SCAN,
+  SETTINGS_SCREEN_OTA,
+  SETTINGS_SCREEN_DIAGNOSTICS,
+  SETTINGS_SCREEN_ABOUT,
+} settings_screen_id_t;
+
 /**
  * @brief Create and display the settings menu
  *
@@ -57,6 +74,42 @@ lv_obj_t *settings_get_screen(void);
  */
 void settings_set_tileview(lv_obj_t *tv);
 
+/**
+ * @brief Create and show a settings screen by id
+ *
+ * Used by the main menu and by UI state restore. Must be called with the
+ * display lock held.
+ *
+ * @param id Screen id
+ * @return ESP_OK if shown, ESP_ERR_NOT_SUPPORTED if disabled in menuconfig,
+ *         ESP_ERR_INVALID_ARG for unknown ids
+ */
+esp_err_t settings_open_screen(settings_screen_id_t id);
+
+/**
+ * @brief Get the index of the highlighted main menu item
+ *
+ * @return Item index, or -1 if none
+ */
+int settings_get_selected_item(void);
+
+/**
+ * @brief Highlight a main menu item
+ *
+ * @param index Item index, or -1 to clear
+ */
+void settings_set_selected_item(int index);
+
+/**
+ * @brief Get the main menu scroll offset
+ */
+int32_t settings_get_menu_scroll(void);
+
+/**
+ * @brief Restore the main menu scroll offset
+ */
+void settings_set_menu_scroll(int32_t scroll_y);
+
 #ifdef __cplusplus
 }
 #endif
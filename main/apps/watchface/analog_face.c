@@ -0,0 +1,374 @@
+/**
+ * @file analog_face.c
+ * @brief Analog watchface dial and hands implementation
+ */
+
+#include "analog_face.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <math.h>
+
+static const char *TAG = "AnalogFace";
+
+// Angles are in half-degree steps: 720 per turn, 0 = 12 o'clock, clockwise
+#define ANGLE_STEPS 720
+#define ANGLE_QUARTER (ANGLE_STEPS / 4)
+#define SIN_SHIFT 14 // Lookup values are Q14
+
+// Each hand is invalidated as this many strips along its length, so a
+// diagonal hand does not dirty its whole bounding square
+#define HAND_INV_SEGMENTS 4
+
+#define CAP_RADIUS 6
+
+typedef enum
+{
+  HAND_HOUR = 0,
+  HAND_MINUTE,
+  HAND_SECOND,
+  HAND_COUNT
+} analog_hand_id_t;
+
+typedef struct
+{
+  uint8_t length_pct; ///< Tip distance from center, % of dial radius
+  uint8_t tail_pct;   ///< Tail past the center, % of dial radius
+  uint8_t width;
+  uint32_t color;
+  int16_t angle; ///< Current angle in half degrees, -1 when hidden
+} analog_hand_t;
+
+static analog_hand_t hands[HAND_COUNT] = {
+    [HAND_HOUR] = {.length_pct = 50, .width = 8, .color = 0xFFFFFF, .angle = -1},
+    [HAND_MINUTE] = {.length_pct = 76, .width = 5, .color = 0xFFFFFF, .angle = -1},
+    [HAND_SECOND] = {.length_pct = 88,
+                     .tail_pct = 16,
+                     .width = 2,
+                     .color = 0xFF3030,
+                     .angle = -1},
+};
+
+// Quarter-wave sine table, 0..90 degrees in half-degree steps
+static int16_t sin_lut[ANGLE_QUARTER + 1];
+static bool sin_lut_ready = false;
+
+static lv_obj_t *face = NULL;
+static int32_t face_radius = 0;
+static lv_draw_buf_t *dial_buf = NULL;
+static lv_image_dsc_t dial_img;
+
+static void build_sin_lut(void)
+{
+  if (sin_lut_ready)
+  {
+    return;
+  }
+
+  for (int i = 0; i <= ANGLE_QUARTER; i++)
+  {
+    sin_lut[i] =
+        (int16_t)lroundf(sinf((float)i * (float)M_PI / ANGLE_STEPS * 2.0f) *
+                         (1 << SIN_SHIFT));
+  }
+  sin_lut_ready = true;
+}
+
+static int32_t lut_sin(int32_t angle)
+{
+  angle %= ANGLE_STEPS;
+  if (angle < 0)
+  {
+    angle += ANGLE_STEPS;
+  }
+
+  if (angle <= ANGLE_QUARTER)
+  {
+    return sin_lut[angle];
+  }
+  if (angle <= 2 * ANGLE_QUARTER)
+  {
+    return sin_lut[2 * ANGLE_QUARTER - angle];
+  }
+  if (angle <= 3 * ANGLE_QUARTER)
+  {
+    return -sin_lut[angle - 2 * ANGLE_QUARTER];
+  }
+  return -sin_lut[ANGLE_STEPS - angle];
+}
+
+static int32_t lut_cos(int32_t angle) { return lut_sin(angle + ANGLE_QUARTER); }
+
+/**
+ * @brief Point at a distance from the dial center along a clock angle
+ */
+static lv_point_t polar_point(int32_t cx, int32_t cy, int32_t angle,
+                              int32_t distance)
+{
+  lv_point_t p = {
+      .x = cx + ((distance * lut_sin(angle)) >> SIN_SHIFT),
+      .y = cy - ((distance * lut_cos(angle)) >> SIN_SHIFT),
+  };
+  return p;
+}
+
+static void hand_points(const analog_hand_t *hand, int32_t cx, int32_t cy,
+                        lv_point_t *tail, lv_point_t *tip)
+{
+  *tip = polar_point(cx, cy, hand->angle, face_radius * hand->length_pct / 100);
+  *tail = polar_point(cx, cy, hand->angle + ANGLE_STEPS / 2,
+                      face_radius * hand->tail_pct / 100);
+}
+
+/**
+ * @brief Rasterise one anti-aliased radial tick into the A8 dial
+ *
+ * Runs once at startup, so plain float math is fine here.
+ */
+static void draw_tick(float angle_rad, float r_in, float r_out, float width,
+                      uint8_t level)
+{
+  int32_t size = dial_buf->header.w;
+  uint32_t stride = dial_buf->header.stride;
+  float c = (size - 1) / 2.0f;
+  float dx = sinf(angle_rad);
+  float dy = -cosf(angle_rad);
+  float x0 = c + dx * r_in, y0 = c + dy * r_in;
+  float x1 = c + dx * r_out, y1 = c + dy * r_out;
+  float len = r_out - r_in;
+  float half = width / 2.0f;
+
+  int32_t min_x = LV_MAX(0, (int32_t)floorf(fminf(x0, x1) - half - 1));
+  int32_t max_x = LV_MIN(size - 1, (int32_t)ceilf(fmaxf(x0, x1) + half + 1));
+  int32_t min_y = LV_MAX(0, (int32_t)floorf(fminf(y0, y1) - half - 1));
+  int32_t max_y = LV_MIN(size - 1, (int32_t)ceilf(fmaxf(y0, y1) + half + 1));
+
+  for (int32_t y = min_y; y <= max_y; y++)
+  {
+    uint8_t *row = dial_buf->data + y * stride;
+    for (int32_t x = min_x; x <= max_x; x++)
+    {
+      // Distance from the pixel center to the tick segment
+      float px = x - x0, py = y - y0;
+      float t = fminf(fmaxf(px * dx + py * dy, 0.0f), len);
+      float ex = px - dx * t, ey = py - dy * t;
+      float cover = half + 0.5f - sqrtf(ex * ex + ey * ey);
+      if (cover <= 0.0f)
+      {
+        continue;
+      }
+
+      uint8_t value = (uint8_t)(fminf(cover, 1.0f) * level);
+      if (value > row[x])
+      {
+        row[x] = value;
+      }
+    }
+  }
+}
+
+/**
+ * @brief Render the static dial into a cached A8 image
+ */
+static esp_err_t build_dial(int32_t diameter)
+{
+  int64_t start = esp_timer_get_time();
+
+  dial_buf = lv_draw_buf_create(diameter, diameter, LV_COLOR_FORMAT_A8,
+                                LV_STRIDE_AUTO);
+  if (!dial_buf)
+  {
+    return ESP_ERR_NO_MEM;
+  }
+  lv_draw_buf_clear(dial_buf, NULL);
+
+  float r = diameter / 2.0f - 2.0f;
+  for (int i = 0; i < 60; i++)
+  {
+    float angle = (float)i * (float)M_PI / 30.0f;
+    if (i % 15 == 0)
+    {
+      draw_tick(angle, r - 30.0f, r, 8.0f, 255); // 12, 3, 6, 9
+    }
+    else if (i % 5 == 0)
+    {
+      draw_tick(angle, r - 22.0f, r, 5.0f, 230); // Hours
+    }
+    else
+    {
+      draw_tick(angle, r - 10.0f, r, 2.0f, 140); // Minutes
+    }
+  }
+
+  dial_img.header = dial_buf->header;
+  dial_img.data_size = dial_buf->data_size;
+  dial_img.data = dial_buf->data;
+
+  ESP_LOGI(TAG, "Dial cached (%lux%lu A8, %lu bytes) in %lld us",
+           (unsigned long)diameter, (unsigned long)diameter,
+           (unsigned long)dial_buf->data_size, esp_timer_get_time() - start);
+  return ESP_OK;
+}
+
+/**
+ * @brief Draw the hands and center cap above the dial
+ */
+static void face_draw_post_cb(lv_event_t *e)
+{
+  lv_layer_t *layer = lv_event_get_layer(e);
+  lv_area_t coords;
+  lv_obj_get_coords(face, &coords);
+  int32_t cx = coords.x1 + face_radius;
+  int32_t cy = coords.y1 + face_radius;
+
+  lv_draw_line_dsc_t line_dsc;
+  lv_draw_line_dsc_init(&line_dsc);
+  line_dsc.round_start = 1;
+  line_dsc.round_end = 1;
+
+  for (int i = 0; i < HAND_COUNT; i++)
+  {
+    const analog_hand_t *hand = &hands[i];
+    if (hand->angle < 0)
+    {
+      continue;
+    }
+
+    lv_point_t tail, tip;
+    hand_points(hand, cx, cy, &tail, &tip);
+    line_dsc.p1.x = tail.x;
+    line_dsc.p1.y = tail.y;
+    line_dsc.p2.x = tip.x;
+    line_dsc.p2.y = tip.y;
+    line_dsc.width = hand->width;
+    line_dsc.color = lv_color_hex(hand->color);
+    lv_draw_line(layer, &line_dsc);
+  }
+
+  if (hands[HAND_HOUR].angle >= 0)
+  {
+    lv_draw_rect_dsc_t cap_dsc;
+    lv_draw_rect_dsc_init(&cap_dsc);
+    cap_dsc.radius = LV_RADIUS_CIRCLE;
+    cap_dsc.bg_color = lv_color_hex(hands[HAND_SECOND].color);
+    lv_area_t cap = {cx - CAP_RADIUS, cy - CAP_RADIUS, cx + CAP_RADIUS,
+                     cy + CAP_RADIUS};
+    lv_draw_rect(layer, &cap_dsc, &cap);
+  }
+}
+
+/**
+ * @brief Invalidate the strips covered by a hand at its current angle
+ */
+static void invalidate_hand(const analog_hand_t *hand)
+{
+  if (hand->angle < 0)
+  {
+    return;
+  }
+
+  lv_area_t coords;
+  lv_obj_get_coords(face, &coords);
+  lv_point_t tail, tip;
+  hand_points(hand, coords.x1 + face_radius, coords.y1 + face_radius, &tail,
+              &tip);
+
+  // Half width plus anti-aliasing fringe
+  int32_t pad = hand->width / 2 + 2;
+  for (int k = 0; k < HAND_INV_SEGMENTS; k++)
+  {
+    int32_t ax = tail.x + (tip.x - tail.x) * k / HAND_INV_SEGMENTS;
+    int32_t ay = tail.y + (tip.y - tail.y) * k / HAND_INV_SEGMENTS;
+    int32_t bx = tail.x + (tip.x - tail.x) * (k + 1) / HAND_INV_SEGMENTS;
+    int32_t by = tail.y + (tip.y - tail.y) * (k + 1) / HAND_INV_SEGMENTS;
+
+    lv_area_t area = {LV_MIN(ax, bx) - pad, LV_MIN(ay, by) - pad,
+                      LV_MAX(ax, bx) + pad, LV_MAX(ay, by) + pad};
+    lv_obj_invalidate_area(face, &area);
+  }
+}
+
+static void move_hand(analog_hand_t *hand, int16_t angle)
+{
+  if (hand->angle == angle)
+  {
+    return;
+  }
+
+  invalidate_hand(hand);
+  hand->angle = angle;
+  invalidate_hand(hand);
+}
+
+lv_obj_t *analog_face_create(lv_obj_t *parent, int32_t diameter)
+{
+  if (face)
+  {
+    ESP_LOGW(TAG, "Analog face already exists");
+    return face;
+  }
+
+  build_sin_lut();
+
+  face = lv_obj_create(parent);
+  if (!face)
+  {
+    return NULL;
+  }
+  lv_obj_remove_style_all(face);
+  lv_obj_set_size(face, diameter, diameter);
+  lv_obj_clear_flag(face, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+  lv_obj_add_flag(face, LV_OBJ_FLAG_EVENT_BUBBLE);
+  face_radius = diameter / 2;
+
+  if (build_dial(diameter) == ESP_OK)
+  {
+    lv_obj_t *dial = lv_image_create(face);
+    lv_image_set_src(dial, &dial_img);
+    lv_obj_set_style_image_recolor(dial, lv_color_white(), 0);
+    lv_obj_set_style_image_recolor_opa(dial, LV_OPA_COVER, 0);
+    lv_obj_center(dial);
+  }
+  else
+  {
+    ESP_LOGW(TAG, "No memory for dial cache, showing hands only");
+  }
+
+  lv_obj_add_event_cb(face, face_draw_post_cb, LV_EVENT_DRAW_POST, NULL);
+  return face;
+}
+
+void analog_face_set_time(int hour, int minute, int second)
+{
+  if (!face)
+  {
+    return;
+  }
+
+  hour = LV_CLAMP(0, hour, 23) % 12;
+  minute = LV_CLAMP(0, minute, 59);
+  second = LV_CLAMP(0, second, 59);
+
+  // Half-degree steps: hour hand 0.5 deg per minute, minute hand 0.5 deg
+  // per 5 s
+  move_hand(&hands[HAND_HOUR], (int16_t)(hour * 60 + minute));
+  move_hand(&hands[HAND_MINUTE], (int16_t)(minute * 12 + second / 5));
+  move_hand(&hands[HAND_SECOND], (int16_t)(second * 12));
+}
+
+void analog_face_hide_hands(void)
+{
+  if (!face)
+  {
+    return;
+  }
+
+  for (int i = 0; i < HAND_COUNT; i++)
+  {
+    move_hand(&hands[i], -1);
+  }
+}
+
+size_t analog_face_get_cache_size(void)
+{
+  return dial_buf ? dial_buf->data_size : 0;
+}
@@ -0,0 +1,59 @@
+/**
+ * @file analog_face.h
+ * @brief Analog watchface dial and hands
+ *
+ * The static dial is rasterised once into an A8 image in internal RAM. The
+ * hands are drawn on top using sin/cos lookup tables (no floating point per
+ * tick), and a time change invalidates only the strips covered by the old
+ * and new position of each hand that moved, not the whole dial.
+ */
+
+#ifndef ANALOG_FACE_H
+#define ANALOG_FACE_H
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Create the analog face (dial image and hands)
+ *
+ * Only one analog face can exist at a time.
+ *
+ * @param parent Parent object
+ * @param diameter Dial diameter in pixels
+ * @return Face object, or NULL on allocation failure
+ */
+lv_obj_t *analog_face_create(lv_obj_t *parent, int32_t diameter);
+
+/**
+ * @brief Move the hands to the given time
+ *
+ * Hands whose position did not change are not invalidated.
+ *
+ * @param hour Hour (0-23)
+ * @param minute Minute (0-59)
+ * @param second Second (0-59)
+ */
+void analog_face_set_time(int hour, int minute, int second);
+
+/**
+ * @brief Hide the hands (e.g. while the RTC cannot be read)
+ */
+void analog_face_hide_hands(void);
+
+/**
+ * @brief Get the RAM used by the cached dial image
+ *
+ * @return Bytes allocated, 0 if the dial is not cached
+ */
+size_t analog_face_get_cache_size(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // ANALOG_FACE_H
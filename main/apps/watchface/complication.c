@@ -0,0 +1,325 @@
+/**
+ * @file complication.c
+ * @brief Watchface complication scheduler implementation
+ */
+
+#include "complication.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "Complication";
+
+#define MINUTE_MS 60000
+#define NEVER INT64_MAX
+
+// Shortest timer period, keeps a burst of requests in one run
+#define MIN_PERIOD_MS 10
+
+typedef struct
+{
+  complication_provider_t provider;
+  bool registered;
+  lv_obj_t *label;
+  complication_value_t value; ///< Last value shown on the label
+  bool value_valid;
+  int64_t due_ms; ///< Next refresh time, NEVER if none
+  bool urgent;    ///< Requested refresh, ignores max_stale_ms
+} complication_slot_t;
+
+static complication_slot_t slots[COMPLICATION_ID_COUNT];
+static lv_timer_t *scheduler_timer = NULL;
+static complication_stats_t stats = {0};
+
+// Time (ms) at which a wall-clock minute started; refreshes align to it
+static int64_t clock_origin_ms = 0;
+static bool clock_synced = false;
+
+static int64_t now_ms(void) { return esp_timer_get_time() / 1000; }
+
+/**
+ * @brief First cadence boundary after now on the minute-aligned grid
+ */
+static int64_t next_aligned(uint32_t cadence_ms, int64_t now)
+{
+  if (cadence_ms == 0)
+  {
+    return NEVER;
+  }
+
+  int64_t since = now - clock_origin_ms;
+  int64_t periods = since / cadence_ms;
+  if (since < 0 && since % cadence_ms != 0)
+  {
+    periods--; // Floor for times before the origin
+  }
+  return clock_origin_ms + (periods + 1) * cadence_ms;
+}
+
+/**
+ * @brief Latest time a slot's pending refresh may run
+ */
+static int64_t slot_deadline(const complication_slot_t *slot)
+{
+  if (slot->due_ms == NEVER || slot->urgent)
+  {
+    return slot->due_ms;
+  }
+  return slot->due_ms + slot->provider.max_stale_ms;
+}
+
+static bool slot_active(const complication_slot_t *slot)
+{
+  return slot->registered && slot->label;
+}
+
+static void apply_value(complication_slot_t *slot,
+                        const complication_value_t *value)
+{
+  if (slot->value_valid && value->color == slot->value.color &&
+      value->hidden == slot->value.hidden &&
+      strcmp(value->text, slot->value.text) == 0)
+  {
+    return; // Unchanged - no invalidation
+  }
+
+  if (!slot->value_valid || strcmp(value->text, slot->value.text) != 0)
+  {
+    lv_label_set_text(slot->label, value->text);
+  }
+  if (!slot->value_valid || value->color != slot->value.color)
+  {
+    lv_obj_set_style_text_color(slot->label, lv_color_hex(value->color), 0);
+  }
+  if (value->hidden)
+  {
+    lv_obj_add_flag(slot->label, LV_OBJ_FLAG_HIDDEN);
+  }
+  else
+  {
+    lv_obj_clear_flag(slot->label, LV_OBJ_FLAG_HIDDEN);
+  }
+
+  slot->value = *value;
+  slot->value_valid = true;
+  stats.updates++;
+}
+
+static void refresh_slot(complication_slot_t *slot, int64_t now)
+{
+  complication_value_t value = slot->value;
+  slot->provider.refresh(&value, slot->provider.user_data);
+  value.text[COMPLICATION_TEXT_LEN - 1] = '\0';
+  apply_value(slot, &value);
+
+  slot->due_ms = next_aligned(slot->provider.cadence_ms, now);
+  slot->urgent = false;
+  stats.refreshes++;
+}
+
+/**
+ * @brief Program the timer for the latest wake that meets every deadline
+ *
+ * Waking at the earliest deadline (rather than the earliest due time) lets
+ * providers whose due times fall inside that window share the wake.
+ */
+static void schedule_next(void)
+{
+  if (!scheduler_timer)
+  {
+    return;
+  }
+
+  int64_t wake = NEVER;
+  for (int i = 0; i < COMPLICATION_ID_COUNT; i++)
+  {
+    if (slot_active(&slots[i]))
+    {
+      int64_t deadline = slot_deadline(&slots[i]);
+      wake = (deadline < wake) ? deadline : wake;
+    }
+  }
+
+  if (wake == NEVER)
+  {
+    lv_timer_pause(scheduler_timer);
+    return;
+  }
+
+  int64_t delay = wake - now_ms();
+  if (delay < MIN_PERIOD_MS)
+  {
+    delay = MIN_PERIOD_MS;
+  }
+  else if (delay > MINUTE_MS)
+  {
+    delay = MINUTE_MS;
+  }
+
+  lv_timer_set_period(scheduler_timer, (uint32_t)delay);
+  lv_timer_reset(scheduler_timer);
+  lv_timer_resume(scheduler_timer);
+}
+
+static void scheduler_timer_cb(lv_timer_t *timer)
+{
+  (void)timer;
+  int64_t now = now_ms();
+  uint32_t spent_us = 0;
+  int refreshed = 0;
+
+  stats.wakeups++;
+
+  // Pass 1: refreshes at their deadline always run
+  for (int i = 0; i < COMPLICATION_ID_COUNT; i++)
+  {
+    complication_slot_t *slot = &slots[i];
+    if (slot_active(slot) && slot_deadline(slot) <= now)
+    {
+      refresh_slot(slot, now);
+      spent_us += slot->provider.cost_us;
+      refreshed++;
+    }
+  }
+
+  // Pass 2: other due refreshes share this wake while the budget allows
+  for (int i = 0; i < COMPLICATION_ID_COUNT; i++)
+  {
+    complication_slot_t *slot = &slots[i];
+    if (!slot_active(slot) || slot->due_ms > now)
+    {
+      continue;
+    }
+
+    if (spent_us + slot->provider.cost_us >
+        CONFIG_WATCHFACE_COMPLICATION_BUDGET_US)
+    {
+      stats.deferred++;
+      continue;
+    }
+
+    refresh_slot(slot, now);
+    spent_us += slot->provider.cost_us;
+    refreshed++;
+  }
+
+  ESP_LOGD(TAG, "Wake %lu: %d refresh(es), ~%lu us",
+           (unsigned long)stats.wakeups, refreshed, (unsigned long)spent_us);
+
+  schedule_next();
+}
+
+esp_err_t complication_register(complication_id_t id,
+                                const complication_provider_t *provider)
+{
+  if (id >= COMPLICATION_ID_COUNT || !provider || !provider->refresh)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  complication_slot_t *slot = &slots[id];
+  slot->provider = *provider;
+  slot->registered = true;
+  slot->value_valid = false;
+  slot->due_ms = now_ms();
+  slot->urgent = true;
+
+  ESP_LOGI(TAG, "Provider '%s' registered (cadence %lu ms, stale %lu ms)",
+           provider->name ? provider->name : "?",
+           (unsigned long)provider->cadence_ms,
+           (unsigned long)provider->max_stale_ms);
+  schedule_next();
+  return ESP_OK;
+}
+
+esp_err_t complication_bind(complication_id_t id, lv_obj_t *label)
+{
+  if (id >= COMPLICATION_ID_COUNT)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  complication_slot_t *slot = &slots[id];
+  slot->label = label;
+  slot->value_valid = false;
+  slot->due_ms = now_ms();
+  slot->urgent = true;
+  schedule_next();
+  return ESP_OK;
+}
+
+void complication_request_refresh(complication_id_t id)
+{
+  if (id >= COMPLICATION_ID_COUNT || !slot_active(&slots[id]))
+  {
+    return;
+  }
+
+  slots[id].due_ms = now_ms();
+  slots[id].urgent = true;
+  schedule_next();
+}
+
+void complication_sync_clock(int second)
+{
+  if (second < 0 || second > 59)
+  {
+    return;
+  }
+
+  int64_t now = now_ms();
+  int64_t origin = now - (int64_t)second * 1000;
+
+  // Ignore jitter from the 1 s RTC polling; realign on real steps only
+  int64_t shift = (origin - clock_origin_ms) % MINUTE_MS;
+  if (shift < 0)
+  {
+    shift += MINUTE_MS;
+  }
+  if (clock_synced && (shift < 1000 || shift > MINUTE_MS - 1000))
+  {
+    return;
+  }
+
+  clock_origin_ms = origin;
+  clock_synced = true;
+
+  for (int i = 0; i < COMPLICATION_ID_COUNT; i++)
+  {
+    complication_slot_t *slot = &slots[i];
+    if (slot_active(slot) && !slot->urgent && slot->due_ms != NEVER &&
+        slot->due_ms > now)
+    {
+      slot->due_ms = next_aligned(slot->provider.cadence_ms, now);
+    }
+  }
+
+  ESP_LOGD(TAG, "Refresh grid aligned to minute boundary");
+  schedule_next();
+}
+
+lv_timer_t *complication_scheduler_start(void)
+{
+  if (scheduler_timer)
+  {
+    return scheduler_timer;
+  }
+
+  scheduler_timer = lv_timer_create(scheduler_timer_cb, MIN_PERIOD_MS, NULL);
+  if (!scheduler_timer)
+  {
+    ESP_LOGE(TAG, "Failed to create scheduler timer");
+    return NULL;
+  }
+
+  schedule_next();
+  return scheduler_timer;
+}
+
+void complication_get_stats(complication_stats_t *out)
+{
+  if (out)
+  {
+    *out = stats;
+  }
+}
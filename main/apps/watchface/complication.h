@@ -0,0 +1,126 @@
+/**
+ * @file complication.h
+ * @brief Watchface complication providers and shared refresh scheduler
+ *
+ * A complication provider produces the text (and color) of one watchface
+ * slot. Providers declare how often they want to refresh, how late a
+ * refresh may be and roughly what it costs. A single LVGL timer refreshes
+ * all due providers together on a grid aligned to wall-clock minute
+ * boundaries, so providers with compatible cadences share one wake-up and
+ * adding a provider does not add a timer. Slot labels are only touched
+ * when a provider's output actually changed.
+ *
+ * All functions must be called from the LVGL task (display lock held).
+ */
+
+#ifndef COMPLICATION_H
+#define COMPLICATION_H
+
+#include "esp_err.h"
+#include "lvgl.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/** Maximum length of a complication text including terminator */
+#define COMPLICATION_TEXT_LEN 32
+
+/** Provider ids, used by watchface slots to bind to a provider */
+typedef enum
+{
+  COMPLICATION_BATTERY = 0,
+  COMPLICATION_UPTIME,
+  COMPLICATION_BOOT_COUNT,
+  COMPLICATION_SLEEP_INDICATOR,
+  COMPLICATION_WEATHER,
+  COMPLICATION_ID_COUNT
+} complication_id_t;
+
+/** Output of a provider refresh */
+typedef struct
+{
+  char text[COMPLICATION_TEXT_LEN];
+  uint32_t color; ///< 0xRRGGBB
+  bool hidden;
+} complication_value_t;
+
+/**
+ * @brief Provider refresh callback
+ *
+ * @param[in,out] value Last value on entry; write the new one
+ * @param user_data User data from the provider
+ */
+typedef void (*complication_refresh_cb_t)(complication_value_t *value,
+                                          void *user_data);
+
+typedef struct
+{
+  const char *name;
+  uint32_t cadence_ms;   ///< Refresh period, 0 = only on request
+  uint32_t max_stale_ms; ///< How late a refresh may run to share a wake-up
+  uint16_t cost_us;      ///< Estimated refresh cost
+  complication_refresh_cb_t refresh;
+  void *user_data;
+} complication_provider_t;
+
+typedef struct
+{
+  uint32_t wakeups;   ///< Scheduler timer runs
+  uint32_t refreshes; ///< Provider refresh calls
+  uint32_t updates;   ///< Refreshes that changed a label
+  uint32_t deferred;  ///< Refreshes pushed to a later wake by the budget
+} complication_stats_t;
+
+/**
+ * @brief Register (or replace) the provider for an id
+ *
+ * @return ESP_OK, or ESP_ERR_INVALID_ARG for a bad id or provider
+ */
+esp_err_t complication_register(complication_id_t id,
+                                const complication_provider_t *provider);
+
+/**
+ * @brief Bind a watchface slot label to a provider
+ *
+ * A provider only refreshes while bound. Binding schedules an immediate
+ * refresh so the new label is filled on the next wake.
+ *
+ * @param id Provider id
+ * @param label Label to update, or NULL to unbind
+ */
+esp_err_t complication_bind(complication_id_t id, lv_obj_t *label);
+
+/**
+ * @brief Refresh a provider on the next scheduler run
+ *
+ * For on-demand providers and for data that changed between cadences.
+ */
+void complication_request_refresh(complication_id_t id);
+
+/**
+ * @brief Align the refresh grid to the wall clock
+ *
+ * Call with the current second of the minute whenever the time is read.
+ */
+void complication_sync_clock(int second);
+
+/**
+ * @brief Create the scheduler timer
+ *
+ * @return The timer (for sleep resume configuration), or NULL on failure
+ */
+lv_timer_t *complication_scheduler_start(void);
+
+/**
+ * @brief Get scheduler statistics
+ */
+void complication_get_stats(complication_stats_t *stats);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // COMPLICATION_H
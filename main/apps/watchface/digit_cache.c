@@ -0,0 +1,263 @@
+/**
+ * @file digit_cache.c
+ * @brief Pre-rasterised digit glyph cache implementation
+ */
+
+#include "digit_cache.h"
+#include "esp_log.h"
+#include "esp_timer.h"
+#include <string.h>
+
+static const char *TAG = "DigitCache";
+
+#define GLYPH_COUNT 11 // '0'-'9' and ':'
+#define GLYPH_COLON 10
+#define TIME_CHAR_COUNT 5 // "HH:MM"
+
+/**
+ * @brief One cropped A8 glyph and its position inside its cell
+ */
+typedef struct
+{
+  lv_draw_buf_t *buf;
+  lv_image_dsc_t img;
+  int16_t ofs_x;
+  int16_t ofs_y;
+} cached_glyph_t;
+
+static cached_glyph_t glyphs[GLYPH_COUNT];
+static int32_t digit_cell_w = 0;
+static int32_t colon_cell_w = 0;
+static int32_t line_h = 0;
+static size_t cache_bytes = 0;
+static bool cache_ready = false;
+
+static const char *const glyph_text[GLYPH_COUNT] = {
+    "0", "1", "2", "3", "4", "5", "6", "7", "8", "9", ":"};
+
+static void free_glyphs(void)
+{
+  for (int i = 0; i < GLYPH_COUNT; i++)
+  {
+    if (glyphs[i].buf)
+    {
+      lv_draw_buf_destroy(glyphs[i].buf);
+    }
+  }
+  memset(glyphs, 0, sizeof(glyphs));
+  cache_bytes = 0;
+}
+
+/**
+ * @brief Crop the white-on-black RGB565 render into an A8 glyph
+ *
+ * The green channel (6 bits) of white text on black is the coverage.
+ */
+static esp_err_t store_glyph(cached_glyph_t *glyph, const lv_draw_buf_t *src,
+                             int32_t cell_w)
+{
+  int32_t min_x = cell_w, min_y = line_h, max_x = -1, max_y = -1;
+  uint32_t stride = src->header.stride;
+
+  for (int32_t y = 0; y < line_h; y++)
+  {
+    const uint16_t *row = (const uint16_t *)(src->data + y * stride);
+    for (int32_t x = 0; x < cell_w; x++)
+    {
+      if (row[x] != 0)
+      {
+        min_x = LV_MIN(min_x, x);
+        max_x = LV_MAX(max_x, x);
+        min_y = LV_MIN(min_y, y);
+        max_y = LV_MAX(max_y, y);
+      }
+    }
+  }
+
+  if (max_x < 0)
+  {
+    return ESP_ERR_NOT_FOUND;
+  }
+
+  int32_t w = max_x - min_x + 1;
+  int32_t h = max_y - min_y + 1;
+  glyph->buf = lv_draw_buf_create(w, h, LV_COLOR_FORMAT_A8, LV_STRIDE_AUTO);
+  if (!glyph->buf)
+  {
+    return ESP_ERR_NO_MEM;
+  }
+
+  uint32_t dst_stride = glyph->buf->header.stride;
+  for (int32_t y = 0; y < h; y++)
+  {
+    const uint16_t *row =
+        (const uint16_t *)(src->data + (y + min_y) * stride) + min_x;
+    uint8_t *dst = glyph->buf->data + y * dst_stride;
+    for (int32_t x = 0; x < w; x++)
+    {
+      uint8_t g6 = (row[x] >> 5) & 0x3F;
+      dst[x] = (uint8_t)((g6 << 2) | (g6 >> 4));
+    }
+  }
+
+  glyph->img.header = glyph->buf->header;
+  glyph->img.data_size = glyph->buf->data_size;
+  glyph->img.data = glyph->buf->data;
+  glyph->ofs_x = (int16_t)min_x;
+  glyph->ofs_y = (int16_t)min_y;
+  cache_bytes += glyph->buf->data_size;
+  return ESP_OK;
+}
+
+esp_err_t digit_cache_init(const lv_font_t *font)
+{
+  if (cache_ready)
+  {
+    return ESP_OK;
+  }
+
+  if (!font)
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  int64_t start = esp_timer_get_time();
+
+  // Fixed cell widths keep the time from shifting as digits change
+  line_h = lv_font_get_line_height(font);
+  digit_cell_w = 0;
+  for (int i = 0; i < 10; i++)
+  {
+    digit_cell_w =
+        LV_MAX(digit_cell_w, (int32_t)lv_font_get_glyph_width(font, '0' + i, 0));
+  }
+  colon_cell_w = lv_font_get_glyph_width(font, ':', 0);
+
+  if (digit_cell_w <= 0 || colon_cell_w <= 0 || line_h <= 0)
+  {
+    ESP_LOGE(TAG, "Font lacks digit glyphs");
+    return ESP_ERR_NOT_FOUND;
+  }
+
+  // Render each glyph once through LVGL into a scratch RGB565 canvas
+  lv_draw_buf_t *scratch = lv_draw_buf_create(digit_cell_w, line_h,
+                                              LV_COLOR_FORMAT_RGB565,
+                                              LV_STRIDE_AUTO);
+  lv_obj_t *canvas = scratch ? lv_canvas_create(NULL) : NULL;
+  if (!canvas)
+  {
+    if (scratch)
+    {
+      lv_draw_buf_destroy(scratch);
+    }
+    return ESP_ERR_NO_MEM;
+  }
+  lv_canvas_set_draw_buf(canvas, scratch);
+
+  esp_err_t ret = ESP_OK;
+  for (int i = 0; i < GLYPH_COUNT && ret == ESP_OK; i++)
+  {
+    int32_t cell_w = (i == GLYPH_COLON) ? colon_cell_w : digit_cell_w;
+
+    lv_canvas_fill_bg(canvas, lv_color_black(), LV_OPA_COVER);
+
+    lv_layer_t layer;
+    lv_canvas_init_layer(canvas, &layer);
+
+    lv_draw_label_dsc_t label_dsc;
+    lv_draw_label_dsc_init(&label_dsc);
+    label_dsc.font = font;
+    label_dsc.color = lv_color_white();
+    label_dsc.text = glyph_text[i];
+    label_dsc.align = LV_TEXT_ALIGN_CENTER;
+
+    lv_area_t area = {0, 0, cell_w - 1, line_h - 1};
+    lv_draw_label(&layer, &label_dsc, &area);
+    lv_canvas_finish_layer(canvas, &layer);
+
+    ret = store_glyph(&glyphs[i], scratch, cell_w);
+  }
+
+  lv_obj_delete(canvas);
+  lv_draw_buf_destroy(scratch);
+
+  if (ret != ESP_OK)
+  {
+    ESP_LOGE(TAG, "Failed to cache glyphs: %s", esp_err_to_name(ret));
+    free_glyphs();
+    return ret;
+  }
+
+  cache_ready = true;
+  ESP_LOGI(TAG, "Cached %d glyphs (%u bytes, cell %ldx%ld) in %lld us",
+           GLYPH_COUNT, (unsigned)cache_bytes, (long)digit_cell_w,
+           (long)line_h, esp_timer_get_time() - start);
+  return ESP_OK;
+}
+
+/**
+ * @brief X position of a character cell within "HH:MM"
+ */
+static int32_t cell_x(int index)
+{
+  // Cells: H H : M M
+  return (index <= 2) ? index * digit_cell_w
+                      : 2 * digit_cell_w + colon_cell_w +
+                            (index - 3) * digit_cell_w;
+}
+
+static void set_cell(lv_obj_t *time_obj, int index, int glyph_index)
+{
+  lv_obj_t *img = lv_obj_get_child(time_obj, index);
+  const cached_glyph_t *glyph = &glyphs[glyph_index];
+
+  if (!img || lv_image_get_src(img) == &glyph->img)
+  {
+    return;
+  }
+
+  lv_image_set_src(img, &glyph->img);
+  lv_obj_set_pos(img, cell_x(index) + glyph->ofs_x, glyph->ofs_y);
+}
+
+lv_obj_t *digit_cache_create_time(lv_obj_t *parent, lv_color_t color)
+{
+  if (!cache_ready)
+  {
+    return NULL;
+  }
+
+  lv_obj_t *time_obj = lv_obj_create(parent);
+  lv_obj_remove_style_all(time_obj);
+  lv_obj_set_size(time_obj, 4 * digit_cell_w + colon_cell_w, line_h);
+  lv_obj_clear_flag(time_obj, LV_OBJ_FLAG_SCROLLABLE | LV_OBJ_FLAG_CLICKABLE);
+
+  for (int i = 0; i < TIME_CHAR_COUNT; i++)
+  {
+    lv_obj_t *img = lv_image_create(time_obj);
+    lv_obj_set_style_image_recolor(img, color, 0);
+    lv_obj_set_style_image_recolor_opa(img, LV_OPA_COVER, 0);
+  }
+
+  set_cell(time_obj, 2, GLYPH_COLON);
+  digit_cache_set_time(time_obj, 0, 0);
+  return time_obj;
+}
+
+void digit_cache_set_time(lv_obj_t *time_obj, int hour, int minute)
+{
+  if (!time_obj || !cache_ready)
+  {
+    return;
+  }
+
+  hour = LV_CLAMP(0, hour, 99);
+  minute = LV_CLAMP(0, minute, 99);
+
+  set_cell(time_obj, 0, hour / 10);
+  set_cell(time_obj, 1, hour % 10);
+  set_cell(time_obj, 3, minute / 10);
+  set_cell(time_obj, 4, minute % 10);
+}
+
+size_t digit_cache_get_size(void) { return cache_ready ? cache_bytes : 0; }
@@ -0,0 +1,63 @@
+/**
+ * @file digit_cache.h
+ * @brief Pre-rasterised digit glyph cache for the watchface time display
+ *
+ * Renders the digits 0-9 and the colon of a font once at startup into A8
+ * bitmaps in internal RAM. The time is then drawn as a row of image blits
+ * recoloured to the text color, so minute changes no longer decompress and
+ * rasterise font glyphs.
+ */
+
+#ifndef DIGIT_CACHE_H
+#define DIGIT_CACHE_H
+
+#include "esp_err.h"
+#include "lvgl.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+/**
+ * @brief Rasterise the digit and colon glyphs of a font
+ *
+ * @param font Font to rasterise (e.g. &lv_font_montserrat_48)
+ * @return ESP_OK on success, ESP_ERR_NO_MEM if a bitmap cannot be allocated,
+ *         ESP_ERR_NOT_FOUND if the font lacks a glyph
+ */
+esp_err_t digit_cache_init(const lv_font_t *font);
+
+/**
+ * @brief Create an "HH:MM" widget drawn from the cached glyphs
+ *
+ * Digits use a fixed cell width so the time does not shift as it changes.
+ *
+ * @param parent Parent object
+ * @param color Text color
+ * @return Container object, or NULL if the cache is not initialised
+ */
+lv_obj_t *digit_cache_create_time(lv_obj_t *parent, lv_color_t color);
+
+/**
+ * @brief Update the time shown by a widget from digit_cache_create_time()
+ *
+ * Only the images whose digit changed are touched (and invalidated).
+ *
+ * @param time_obj Widget returned by digit_cache_create_time()
+ * @param hour Hour (0-23)
+ * @param minute Minute (0-59)
+ */
+void digit_cache_set_time(lv_obj_t *time_obj, int hour, int minute);
+
+/**
+ * @brief Get the RAM used by the cached bitmaps
+ *
+ * @return Bytes allocated, 0 if not initialised
+ */
+size_t digit_cache_get_size(void);
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // DIGIT_CACHE_H
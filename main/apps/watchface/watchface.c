@@ -1,21 +1,31 @@
 /**
  * @file watchface.c
- * @brief Digital Watchface Application Implementation
+ * @brief Watchface Application Implementation
  */
 
 #include "watchface.h"
+#include "analog_face.h"
 #include "bsp/esp-bsp.h"
+#include "clock_service.h"
+#include "complication.h"
+#include "digit_cache.h"
 #include "safe_area.h"
 #include "esp_log.h"
+#include "event_bus.h"
 #include "pmu_axp2101.h"
 #include "rtc_pcf85063.h"
 #include "screen_manager.h"
+#include "seqlock.h"
 #include "settings.h"
 #include "sleep_manager.h"
 #include "uptime_tracker.h"
+#include "watchface_layout.h"
+#ifdef CONFIG_WEATHER_ENABLE
+#include "weather.h"
+#endif
 #include "freertos/FreeRTOS.h"
-#include "freertos/semphr.h"
 #include "freertos/task.h"
+#include "esp_timer.h"
 #include <time.h>
 
 static const char *TAG = "Watchface";
@@ -23,6 +33,8 @@ static const char *TAG = "Watchface";
 // UI elements
 static lv_obj_t *screen = NULL;
 static lv_obj_t *time_label = NULL;
+static lv_obj_t *time_digits = NULL; // Glyph-cache time, replaces time_label
+static lv_obj_t *analog_dial = NULL;  // Analog face, replaces the time text
 static lv_obj_t *date_label = NULL;
 static lv_obj_t *battery_label = NULL;
 static lv_obj_t *uptime_label = NULL;
@@ -30,9 +42,18 @@ static lv_obj_t *boot_count_label = NULL;
 #ifdef CONFIG_SLEEP_MANAGER_SLEEP_INDICATOR
 static lv_obj_t *sleep_indicator_label = NULL;
 #endif
+#ifdef CONFIG_WEATHER_ENABLE
+static lv_obj_t *weather_label = NULL;
+#endif
 static lv_timer_t *update_timer = NULL;
 static TaskHandle_t data_task_handle = NULL;
-static SemaphoreHandle_t data_mutex = NULL;
+static volatile bool data_task_paused = false;
+
+// Data task period when the RTC INT pin drives updates (battery, fallback)
+#define TICK_POLL_MS 30000
+
+// Set when the RTC minute/second interrupt paces the watchface
+static bool tick_driven = false;
 
 typedef struct
 {
@@ -44,11 +65,23 @@ typedef struct
   bool battery_valid;
 } watchface_data_t;
 
-static watchface_data_t cached_data = {0};
+// Published by the data task, read lock-free from the LVGL timer
+static watchface_data_t data_storage[2];
+static seqlock_t data_lock = SEQLOCK_INITIALIZER(data_storage);
+
+#ifdef CONFIG_WATCHFACE_RENDER_STATS
+// Render time and flushed pixels of frames that contain a time change
+static int32_t last_shown_time = -1;
+static bool time_render_pending = false;
+static int64_t time_render_start = 0;
+static uint32_t time_render_px = 0;
+static uint32_t time_render_count = 0;
+static uint64_t time_render_total_us = 0;
+static uint32_t time_render_max_us = 0;
+static uint64_t time_render_total_px = 0;
+#endif
 
-// Save timer for periodic NVS writes
-static uint32_t save_counter = 0;
-#define SAVE_INTERVAL_SECONDS 60
+static bool last_charging = false;
 
 // Day and month name arrays
 static const char *day_names[] = {"Sun", "Mon", "Tue", "Wed",
@@ -57,7 +90,12 @@ static const char *month_names[] = {"Jan", "Feb", "Mar", "Apr", "May", "Jun",
                                     "Jul", "Aug", "Sep", "Oct", "Nov", "Dec"};
 
 static void watchface_data_task(void *param);
-static bool watchface_get_cached_data(watchface_data_t *out);
+static void watchface_rtc_tick(void *user_data);
+static esp_err_t watchface_sleep_prepare(sleep_manager_sleep_type_t sleep_type,
+                                         void *user_data);
+static esp_err_t watchface_sleep_post_wake(sleep_manager_sleep_type_t sleep_type,
+                                           void *user_data);
+static void watchface_get_cached_data(watchface_data_t *out);
 
 /**
  * @brief Widget configuration structure for UI builder
@@ -72,6 +110,8 @@ typedef struct
   lv_coord_t width;         // Widget width (LV_SIZE_CONTENT for auto)
   lv_coord_t height;        // Widget height (LV_SIZE_CONTENT for auto)
   int32_t padding;          // Additional padding from safe area edge
+  int32_t x_padding;        // Horizontal padding from safe area edge
+  bool no_safe_area;        // Offsets are from the screen edge
 } widget_config_t;
 
 /**
@@ -147,147 +187,787 @@ static const widget_config_t widget_configs[] = {
         .padding = 0,
     }
 #endif
+#ifdef CONFIG_WEATHER_ENABLE
+    ,
+    // Weather - below date
+    {
+        .obj_ptr = &weather_label,
+#ifdef CONFIG_LV_FONT_MONTSERRAT_16
+        .font = &lv_font_montserrat_16,
+#else
+        .font = &lv_font_montserrat_14, // Same fallback as layout_font()
+#endif
+        .color = 0x66CCFF,
+        .initial_text = "--",
+        .align = LV_ALIGN_CENTER,
+        .width = LV_SIZE_CONTENT,
+        .height = LV_SIZE_CONTENT,
+        .padding = 65,
+    }
+#endif
 };
 
 #define WIDGET_COUNT (sizeof(widget_configs) / sizeof(widget_configs[0]))
 
+// Labels created by the active layout, deleted when switching layouts
+static lv_obj_t *layout_objs[WF_LAYOUT_MAX_WIDGETS + WF_BIND_COUNT];
+static size_t layout_obj_count = 0;
+static uint32_t placeholder_mask = 0; // Bindings the layout does not show
+static bool time_digits_active = false;
+
+static const lv_align_t layout_aligns[WF_ALIGN_COUNT] = {
+    [WF_ALIGN_TOP_LEFT] = LV_ALIGN_TOP_LEFT,
+    [WF_ALIGN_TOP_MID] = LV_ALIGN_TOP_MID,
+    [WF_ALIGN_TOP_RIGHT] = LV_ALIGN_TOP_RIGHT,
+    [WF_ALIGN_BOTTOM_LEFT] = LV_ALIGN_BOTTOM_LEFT,
+    [WF_ALIGN_BOTTOM_MID] = LV_ALIGN_BOTTOM_MID,
+    [WF_ALIGN_BOTTOM_RIGHT] = LV_ALIGN_BOTTOM_RIGHT,
+    [WF_ALIGN_LEFT_MID] = LV_ALIGN_LEFT_MID,
+    [WF_ALIGN_RIGHT_MID] = LV_ALIGN_RIGHT_MID,
+    [WF_ALIGN_CENTER] = LV_ALIGN_CENTER,
+};
+
 /**
- * @brief Timer callback to update time and battery every second
+ * @brief Label pointer driven by a data binding
  */
-static void watchface_timer_cb(lv_timer_t *timer)
+static lv_obj_t **binding_target(uint8_t binding)
 {
+  switch (binding)
+  {
+  case WF_BIND_TIME:
+    return &time_label;
+  case WF_BIND_DATE:
+    return &date_label;
+  case WF_BIND_BATTERY:
+    return &battery_label;
+  case WF_BIND_UPTIME:
+    return &uptime_label;
+  case WF_BIND_BOOT_COUNT:
+    return &boot_count_label;
+#ifdef CONFIG_SLEEP_MANAGER_SLEEP_INDICATOR
+  case WF_BIND_SLEEP_INDICATOR:
+    return &sleep_indicator_label;
+#endif
+#ifdef CONFIG_WEATHER_ENABLE
+  case WF_BIND_WEATHER:
+    return &weather_label;
+#endif
+  default:
+    return NULL;
+  }
+}
+
+/**
+ * @brief Map a layout font id to a font enabled in this build
+ */
+static const lv_font_t *layout_font(uint8_t font)
+{
+  switch (font)
+  {
+#ifdef CONFIG_LV_FONT_MONTSERRAT_12
+  case WF_FONT_12:
+    return &lv_font_montserrat_12;
+#endif
+#ifdef CONFIG_LV_FONT_MONTSERRAT_16
+  case WF_FONT_16:
+    return &lv_font_montserrat_16;
+#endif
+#ifdef CONFIG_LV_FONT_MONTSERRAT_18
+  case WF_FONT_18:
+    return &lv_font_montserrat_18;
+#endif
+#ifdef CONFIG_LV_FONT_MONTSERRAT_20
+  case WF_FONT_20:
+    return &lv_font_montserrat_20;
+#endif
+#ifdef CONFIG_LV_FONT_MONTSERRAT_22
+  case WF_FONT_22:
+    return &lv_font_montserrat_22;
+#endif
+#ifdef CONFIG_LV_FONT_MONTSERRAT_24
+  case WF_FONT_24:
+    return &lv_font_montserrat_24;
+#endif
+#ifdef CONFIG_LV_FONT_MONTSERRAT_26
+  case WF_FONT_26:
+    return &lv_font_montserrat_26;
+#endif
+#ifdef CONFIG_LV_FONT_MONTSERRAT_48
+  case WF_FONT_48:
+    return &lv_font_montserrat_48;
+#endif
+  default:
+    return &lv_font_montserrat_14;
+  }
+}
+
+/**
+ * @brief Battery complication: percentage, voltage and charge state
+ */
+static void battery_refresh(complication_value_t *value, void *user_data)
+{
+  (void)user_data;
   watchface_data_t data = {0};
-  bool has_data = watchface_get_cached_data(&data);
 
-  // Update uptime counter
-  uptime_tracker_update();
+  watchface_get_cached_data(&data);
+  if (!data.battery_valid)
+  {
+    // Fallback display if battery reading fails completely
+    snprintf(value->text, sizeof(value->text), "? --%%");
+    value->color = 0x888888; // Gray
+    ESP_LOGW(TAG, "Failed to read battery data");
+    return;
+  }
 
-  // Update time from cached data
-  if (has_data && data.time_valid)
+  // Build battery display string with percentage and voltage
+  uint16_t volts_int = data.voltage_mv / 1000;
+  uint16_t volts_frac = (data.voltage_mv % 1000) / 10;
+  snprintf(value->text, sizeof(value->text), "%s%d%% %u.%02uV",
+           data.is_charging ? LV_SYMBOL_CHARGE " " : "", data.battery_percent,
+           volts_int, volts_frac);
+
+  // Change color based on battery level
+  if (data.battery_percent > 30)
+  {
+    value->color = 0x00FF00; // Green
+  }
+  else if (data.battery_percent > 15)
   {
-    // Update time label (HH:MM format)
-    lv_label_set_text_fmt(time_label, "%02d:%02d", data.time.tm_hour,
-                          data.time.tm_min);
+    value->color = 0xFFFF00; // Yellow
+  }
+  else
+  {
+    value->color = 0xFF0000; // Red
+  }
+}
 
-    // Update date label (Day, Month DD)
-    if (data.time.tm_wday >= 0 && data.time.tm_wday < 7 &&
-        data.time.tm_mon >= 0 && data.time.tm_mon < 12)
+/**
+ * @brief Uptime complication: current session uptime
+ */
+static void uptime_refresh(complication_value_t *value, void *user_data)
+{
+  (void)user_data;
+  uptime_stats_t stats;
+
+  if (uptime_tracker_get_stats(&stats) == ESP_OK)
+  {
+    char uptime_str[24];
+    uptime_tracker_format_time(stats.current_uptime_sec, uptime_str,
+                               sizeof(uptime_str));
+    snprintf(value->text, sizeof(value->text), "Up: %s", uptime_str);
+  }
+  value->color = 0x888888;
+}
+
+/**
+ * @brief Boot count complication: total uptime and boot count
+ */
+static void boot_count_refresh(complication_value_t *value, void *user_data)
+{
+  (void)user_data;
+  uptime_stats_t stats;
+
+  if (uptime_tracker_get_stats(&stats) == ESP_OK)
+  {
+    char total_str[24];
+    uptime_tracker_format_time(stats.total_uptime_sec, total_str,
+                               sizeof(total_str));
+    snprintf(value->text, sizeof(value->text), "T%s(B%u)", total_str,
+             (unsigned)stats.boot_count);
+  }
+  value->color = 0x666666;
+}
+
+#if defined(CONFIG_SLEEP_MANAGER_ENABLE) && defined(CONFIG_SLEEP_MANAGER_SLEEP_INDICATOR)
+/**
+ * @brief Sleep indicator complication: countdown before sleep
+ */
+static void sleep_indicator_refresh(complication_value_t *value,
+                                    void *user_data)
+{
+  (void)user_data;
+  uint32_t inactive_ms = sleep_manager_get_inactive_time();
+  uint32_t timeout_ms = SLEEP_TIMEOUT_MS;
+  uint32_t remaining_ms =
+      (inactive_ms >= timeout_ms) ? 0 : (timeout_ms - inactive_ms);
+  uint32_t remaining_sec = (remaining_ms + 999) / 1000;
+
+  value->color = 0xFF8800;
+  value->hidden =
+      remaining_sec > CONFIG_SLEEP_MANAGER_SLEEP_INDICATOR_THRESHOLD_SECONDS;
+  if (!value->hidden)
+  {
+    snprintf(value->text, sizeof(value->text), "Sleep in %lus",
+             (unsigned long)remaining_sec);
+  }
+}
+#endif
+
+#ifdef CONFIG_WEATHER_ENABLE
+#define DEGREE_SIGN "\xC2\xB0" // UTF-8, in the built-in Montserrat fonts
+
+/**
+ * @brief Tenths of a degree to whole degrees, rounding half away from zero
+ */
+static int round_c10(int16_t c10)
+{
+  return (c10 + (c10 < 0 ? -5 : 5)) / 10;
+}
+
+/**
+ * @brief Weather complication: conditions, temperature, today's range
+ *
+ * Reads the cache only. A stale forecast stays up, dimmed, until the next
+ * fetch lands (EVENT_WEATHER asks for a refresh).
+ */
+static void weather_refresh(complication_value_t *value, void *user_data)
+{
+  (void)user_data;
+  weather_data_t data;
+
+  weather_freshness_t freshness = weather_get(&data, NULL);
+  if (freshness == WEATHER_NONE || freshness == WEATHER_EXPIRED)
+  {
+    snprintf(value->text, sizeof(value->text), "--");
+    value->color = 0x888888;
+    return;
+  }
+
+  // Conditions and temperature, then today's low/high if the forecast had them
+  int len = snprintf(value->text, sizeof(value->text), "%s %d" DEGREE_SIGN,
+                     weather_code_name(data.code), round_c10(data.temp_c10));
+  const uint8_t range = WEATHER_HAS_HIGH | WEATHER_HAS_LOW;
+  if ((data.fields & range) == range && len > 0 &&
+      (size_t)len < sizeof(value->text))
+  {
+    snprintf(value->text + len, sizeof(value->text) - len, " %d/%d",
+             round_c10(data.low_c10), round_c10(data.high_c10));
+  }
+  value->color = freshness == WEATHER_FRESH ? 0x66CCFF : 0x888888;
+}
+
+static void weather_event_cb(const event_t *event, void *user_data)
+{
+  (void)event;
+  (void)user_data;
+  complication_request_refresh(COMPLICATION_WEATHER);
+}
+#endif
+
+/**
+ * @brief Register the built-in complication providers
+ */
+static void register_complications(void)
+{
+  static const complication_provider_t providers[] = {
+      [COMPLICATION_BATTERY] =
+          {
+              .name = "battery",
+              .cadence_ms = 30000,
+              .max_stale_ms = 10000,
+              .cost_us = 200,
+              .refresh = battery_refresh,
+          },
+      // Uptime and boot count only change on minute granularity and are
+      // low value, so they may lag to share the minute wake
+      [COMPLICATION_UPTIME] =
+          {
+              .name = "uptime",
+              .cadence_ms = 60000,
+              .max_stale_ms = 15000,
+              .cost_us = 100,
+              .refresh = uptime_refresh,
+          },
+      [COMPLICATION_BOOT_COUNT] =
+          {
+              .name = "boot_count",
+              .cadence_ms = 60000,
+              .max_stale_ms = 30000,
+              .cost_us = 100,
+              .refresh = boot_count_refresh,
+          },
+#if defined(CONFIG_SLEEP_MANAGER_ENABLE) && defined(CONFIG_SLEEP_MANAGER_SLEEP_INDICATOR)
+      [COMPLICATION_SLEEP_INDICATOR] =
+          {
+              .name = "sleep_indicator",
+              .cadence_ms = 1000,
+              .max_stale_ms = 0,
+              .cost_us = 50,
+              .refresh = sleep_indicator_refresh,
+          },
+#endif
+#ifdef CONFIG_WEATHER_ENABLE
+      // Only the cache is read; the minute tick just moves fresh to stale
+      [COMPLICATION_WEATHER] =
+          {
+              .name = "weather",
+              .cadence_ms = 60000,
+              .max_stale_ms = 30000,
+              .cost_us = 100,
+              .refresh = weather_refresh,
+          },
+#endif
+  };
+
+  for (size_t i = 0; i < sizeof(providers) / sizeof(providers[0]); i++)
+  {
+    if (providers[i].refresh)
     {
-      lv_label_set_text_fmt(date_label, "%s, %s %d",
-                            day_names[data.time.tm_wday],
-                            month_names[data.time.tm_mon], data.time.tm_mday);
+      complication_register((complication_id_t)i, &providers[i]);
     }
   }
-  else
+
+#ifdef CONFIG_WEATHER_ENABLE
+  // Show a new forecast as soon as it is fetched
+  static bool subscribed = false;
+  if (!subscribed)
   {
-    // Fallback display if RTC fails
-    lv_label_set_text(time_label, "--:--");
-    ESP_LOGW(TAG, "Failed to read RTC time");
+    subscribed = event_bus_subscribe(EVENT_MASK(EVENT_WEATHER), EVENT_CTX_UI,
+                                     weather_event_cb, NULL) == ESP_OK;
+  }
+#endif
+}
+
+/**
+ * @brief Complication a layout data binding is served by
+ */
+static int binding_complication(uint8_t binding)
+{
+  switch (binding)
+  {
+  case WF_BIND_BATTERY:
+    return COMPLICATION_BATTERY;
+  case WF_BIND_UPTIME:
+    return COMPLICATION_UPTIME;
+  case WF_BIND_BOOT_COUNT:
+    return COMPLICATION_BOOT_COUNT;
+  case WF_BIND_SLEEP_INDICATOR:
+    return COMPLICATION_SLEEP_INDICATOR;
+  case WF_BIND_WEATHER:
+    return COMPLICATION_WEATHER;
+  default:
+    return -1;
+  }
+}
+
+/**
+ * @brief Create one label of the active layout
+ */
+static lv_obj_t *create_widget(const widget_config_t *config)
+{
+  if (layout_obj_count >= sizeof(layout_objs) / sizeof(layout_objs[0]))
+  {
+    return NULL;
+  }
+
+  // Create label on the tile
+  lv_obj_t *label = lv_label_create(screen);
+
+  // Set size
+  lv_obj_set_size(label, config->width, config->height);
+
+  // Apply styling
+  lv_obj_set_style_text_font(label, config->font, 0);
+  lv_obj_set_style_transform_scale_x(label, 256, 0); // No scaling
+  lv_obj_set_style_transform_scale_y(label, 256, 0); // No scaling
+  lv_obj_set_style_text_color(label, lv_color_hex(config->color), 0);
+
+  // Initial text is not copied (literal or string in the mapped pack)
+  lv_label_set_text_static(label, config->initial_text);
+
+  // Make label transparent to touch events - don't intercept them
+  lv_obj_clear_flag(label, LV_OBJ_FLAG_CLICKABLE);
+  lv_obj_add_flag(label, LV_OBJ_FLAG_EVENT_BUBBLE);
+
+  // Calculate position based on alignment and safe area
+  int32_t x_offset = 0;
+  int32_t y_offset = 0;
+
+  switch (config->no_safe_area ? LV_ALIGN_CENTER : config->align)
+  {
+  case LV_ALIGN_TOP_LEFT:
+    x_offset = SAFE_AREA_HORIZONTAL;
+    y_offset = SAFE_AREA_TOP;
+    break;
+  case LV_ALIGN_TOP_MID:
+    x_offset = 0;
+    y_offset = SAFE_AREA_TOP;
+    break;
+  case LV_ALIGN_TOP_RIGHT:
+    x_offset = -SAFE_AREA_HORIZONTAL;
+    y_offset = SAFE_AREA_TOP;
+    break;
+  case LV_ALIGN_BOTTOM_LEFT:
+    x_offset = SAFE_AREA_HORIZONTAL;
+    y_offset = -SAFE_AREA_BOTTOM;
+    break;
+  case LV_ALIGN_BOTTOM_RIGHT:
+    x_offset = -SAFE_AREA_HORIZONTAL;
+    y_offset = -SAFE_AREA_BOTTOM;
+    break;
+  case LV_ALIGN_BOTTOM_MID:
+    x_offset = 0;
+    y_offset = -SAFE_AREA_BOTTOM;
+    break;
+  case LV_ALIGN_LEFT_MID:
+    x_offset = SAFE_AREA_HORIZONTAL;
+    y_offset = 0;
+    break;
+  case LV_ALIGN_RIGHT_MID:
+    x_offset = -SAFE_AREA_HORIZONTAL;
+    y_offset = 0;
+    break;
+  case LV_ALIGN_CENTER:
+  default:
+    // Center alignment uses padding directly as offset
+    x_offset = 0;
+    y_offset = 0;
+    break;
   }
 
-  if (has_data && data.battery_valid)
+  // Add custom padding (can be used for stacking or fine-tuning)
+  x_offset += config->x_padding;
+  y_offset += config->padding;
+
+  // Position widget
+  lv_obj_align(label, config->align, x_offset, y_offset);
+
+  // Store reference
+  if (config->obj_ptr)
   {
-    // Build battery display string with percentage and voltage
-    char battery_str[32];
-    uint16_t volts_int = data.voltage_mv / 1000;
-    uint16_t volts_frac = (data.voltage_mv % 1000) / 10;
+    *(config->obj_ptr) = label;
+  }
+  layout_objs[layout_obj_count++] = label;
+  return label;
+}
 
-    if (data.is_charging)
+/**
+ * @brief Build the labels of a layout from the mapped pack
+ */
+static void build_pack_layout(const wf_layout_widget_t *widgets, size_t count)
+{
+  for (size_t i = 0; i < count; i++)
+  {
+    const wf_layout_widget_t *w = &widgets[i];
+    const char *text = watchface_layout_string(w->text_offset);
+
+    const widget_config_t config = {
+        .obj_ptr = binding_target(w->binding),
+        .font = layout_font(w->font),
+        .color = w->color,
+        .initial_text = text ? text : "",
+        .align = layout_aligns[w->align],
+        .width = LV_SIZE_CONTENT,
+        .height = LV_SIZE_CONTENT,
+        .padding = w->y_ofs,
+        .x_padding = w->x_ofs,
+        .no_safe_area = (w->flags & WF_LAYOUT_FLAG_NO_SAFE_AREA) != 0,
+    };
+    create_widget(&config);
+  }
+}
+
+/**
+ * @brief Delete the labels of the active layout
+ */
+static void clear_layout(void)
+{
+  for (size_t i = 0; i < layout_obj_count; i++)
+  {
+    lv_obj_delete(layout_objs[i]);
+  }
+  layout_obj_count = 0;
+
+  for (uint8_t b = WF_BIND_NONE + 1; b < WF_BIND_COUNT; b++)
+  {
+    lv_obj_t **target = binding_target(b);
+    if (target)
     {
-      snprintf(battery_str, sizeof(battery_str),
-               LV_SYMBOL_CHARGE " %d%% %u.%02uV", data.battery_percent,
-               volts_int, volts_frac);
+      *target = NULL;
     }
-    else
+
+    int id = binding_complication(b);
+    if (id >= 0)
     {
-      snprintf(battery_str, sizeof(battery_str), "%d%% %u.%02uV",
-               data.battery_percent, volts_int, volts_frac);
+      complication_bind((complication_id_t)id, NULL);
     }
-    lv_label_set_text(battery_label, battery_str);
+  }
+}
 
-    // Change color based on battery level
-    if (data.battery_percent > 30)
+/**
+ * @brief Build a layout and attach the time display to it
+ *
+ * @param index Layout in the flash pack; the built-in table is used when no
+ *              pack is loaded
+ */
+static void watchface_apply_layout(size_t index)
+{
+  clear_layout();
+
+  size_t count = 0;
+  const wf_layout_widget_t *widgets = watchface_layout_widgets(index, &count);
+  if (widgets)
+  {
+    ESP_LOGI(TAG, "Building layout '%s' (%u widgets)",
+             watchface_layout_name(index), (unsigned)count);
+    build_pack_layout(widgets, count);
+  }
+  else
+  {
+    for (size_t i = 0; i < WIDGET_COUNT; i++)
     {
-      lv_obj_set_style_text_color(battery_label, lv_color_hex(0x00FF00),
-                                  0); // Green
+      create_widget(&widget_configs[i]);
     }
-    else if (data.battery_percent > 15)
+  }
+
+  // Bindings the layout leaves out still get an (invisible) label so the
+  // update code does not need NULL checks
+  placeholder_mask = 0;
+  for (uint8_t b = WF_BIND_NONE + 1; b < WF_BIND_COUNT; b++)
+  {
+    lv_obj_t **target = binding_target(b);
+    if (target && !*target)
     {
-      lv_obj_set_style_text_color(battery_label, lv_color_hex(0xFFFF00),
-                                  0); // Yellow
+      const widget_config_t hidden = {
+          .obj_ptr = target,
+          .font = &lv_font_montserrat_14,
+          .initial_text = "",
+          .align = LV_ALIGN_CENTER,
+          .width = LV_SIZE_CONTENT,
+          .height = LV_SIZE_CONTENT,
+      };
+      lv_obj_t *label = create_widget(&hidden);
+      if (label)
+      {
+        lv_obj_set_style_opa(label, LV_OPA_TRANSP, 0);
+        lv_obj_add_flag(label, LV_OBJ_FLAG_HIDDEN);
+      }
+      placeholder_mask |= 1u << b;
     }
-    else
+  }
+
+#ifdef CONFIG_SLEEP_MANAGER_SLEEP_INDICATOR
+  if (sleep_indicator_label)
+  {
+    lv_obj_add_flag(sleep_indicator_label, LV_OBJ_FLAG_HIDDEN);
+  }
+#endif
+
+  // Shown slots bind to their provider; providers of hidden slots idle
+  for (uint8_t b = WF_BIND_NONE + 1; b < WF_BIND_COUNT; b++)
+  {
+    int id = binding_complication(b);
+    lv_obj_t **target = binding_target(b);
+    if (id >= 0)
     {
-      lv_obj_set_style_text_color(battery_label, lv_color_hex(0xFF0000),
-                                  0); // Red
+      bool shown = target && *target && !(placeholder_mask & (1u << b));
+      complication_bind((complication_id_t)id, shown ? *target : NULL);
     }
   }
-  else
+
+  // Cached glyphs only stand in for a shown 48px time label
+  time_digits_active =
+      time_digits && !(placeholder_mask & (1u << WF_BIND_TIME)) &&
+      lv_obj_get_style_text_font(time_label, LV_PART_MAIN) ==
+          &lv_font_montserrat_48;
+  if (time_digits_active)
   {
-    // Fallback display if battery reading fails completely
-    lv_label_set_text(battery_label, "? --%%");
-    lv_obj_set_style_text_color(battery_label, lv_color_hex(0x888888),
-                                0); // Gray
-    ESP_LOGW(TAG, "Failed to read battery data");
+    lv_obj_align_to(time_digits, time_label, LV_ALIGN_CENTER, 0, 0);
   }
-
-  // Update uptime display
-  uptime_stats_t stats;
-  if (uptime_tracker_get_stats(&stats) == ESP_OK)
+  else if (time_digits)
   {
-    char uptime_str[32];
-    char total_str[32];
+    lv_obj_add_flag(time_digits, LV_OBJ_FLAG_HIDDEN);
+  }
 
-    uptime_tracker_format_time(stats.current_uptime_sec, uptime_str,
-                               sizeof(uptime_str));
-    uptime_tracker_format_time(stats.total_uptime_sec, total_str,
-                               sizeof(total_str));
+  if (analog_dial)
+  {
+    // The built-in layout moves the date inside the dial
+    if (!widgets)
+    {
+      lv_obj_align(date_label, LV_ALIGN_CENTER, 0,
+                   lv_obj_get_height(analog_dial) / 4);
+    }
+    lv_obj_add_flag(time_label, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_move_foreground(analog_dial);
+  }
+}
 
-    // Display current session uptime
-    lv_label_set_text_fmt(uptime_label, "Up: %s", uptime_str);
+#ifdef CONFIG_WATCHFACE_RENDER_STATS
+/**
+ * @brief Display event handler timing the frame after a time change
+ */
+static void time_render_event_cb(lv_event_t *e)
+{
+  lv_event_code_t code = lv_event_get_code(e);
 
-    // Display total uptime and boot count
-    lv_label_set_text_fmt(boot_count_label, "T%s(B%u)", total_str,
-                          stats.boot_count);
+  if (code == LV_EVENT_RENDER_START)
+  {
+    time_render_start = time_render_pending ? esp_timer_get_time() : 0;
+    time_render_px = 0;
+    return;
   }
 
-#if defined(CONFIG_SLEEP_MANAGER_ENABLE) && defined(CONFIG_SLEEP_MANAGER_SLEEP_INDICATOR)
-  if (sleep_indicator_label)
+  if (time_render_start == 0)
   {
-    uint32_t inactive_ms = sleep_manager_get_inactive_time();
-    uint32_t timeout_ms = SLEEP_TIMEOUT_MS;
-    uint32_t remaining_ms = (inactive_ms >= timeout_ms)
-                                ? 0
-                                : (timeout_ms - inactive_ms);
-    uint32_t remaining_sec = (remaining_ms + 999) / 1000;
+    return;
+  }
 
-    if (remaining_sec <= CONFIG_SLEEP_MANAGER_SLEEP_INDICATOR_THRESHOLD_SECONDS)
+  if (code == LV_EVENT_FLUSH_START)
+  {
+    const lv_area_t *area = lv_event_get_param(e);
+    if (area)
     {
-      lv_label_set_text_fmt(sleep_indicator_label, "Sleep in %us",
-                            remaining_sec);
-      lv_obj_clear_flag(sleep_indicator_label, LV_OBJ_FLAG_HIDDEN);
+      time_render_px += lv_area_get_size(area);
     }
-    else
+    return;
+  }
+
+  if (code != LV_EVENT_RENDER_READY)
+  {
+    return;
+  }
+
+  uint32_t elapsed_us = (uint32_t)(esp_timer_get_time() - time_render_start);
+  time_render_start = 0;
+  time_render_pending = false;
+
+  time_render_count++;
+  time_render_total_us += elapsed_us;
+  time_render_max_us = LV_MAX(time_render_max_us, elapsed_us);
+  time_render_total_px += time_render_px;
+
+  const char *mode = analog_dial          ? "analog"
+                     : time_digits_active ? "glyph cache"
+                                   : "font label";
+  ESP_LOGI(TAG,
+           "Time render: %lu us, %lu px flushed (avg %lu us / %lu px, max %lu "
+           "us, n=%lu, %s)",
+           (unsigned long)elapsed_us, (unsigned long)time_render_px,
+           (unsigned long)(time_render_total_us / time_render_count),
+           (unsigned long)(time_render_total_px / time_render_count),
+           (unsigned long)time_render_max_us, (unsigned long)time_render_count,
+           mode);
+}
+#endif
+
+/**
+ * @brief Show the time, or "--:--" when the RTC could not be read
+ *
+ * @param tm Current time, NULL if invalid
+ */
+static void watchface_set_time(const struct tm *tm)
+{
+  bool valid = (tm != NULL);
+  int hour = valid ? tm->tm_hour : 0;
+  int minute = valid ? tm->tm_min : 0;
+
+#ifdef CONFIG_WATCHFACE_RENDER_STATS
+  // The analog face changes every second, the digital one every minute
+  int32_t shown_time = -1;
+  if (valid)
+  {
+    shown_time = hour * 60 + minute;
+    if (analog_dial)
     {
-      lv_obj_add_flag(sleep_indicator_label, LV_OBJ_FLAG_HIDDEN);
+      shown_time = shown_time * 60 + tm->tm_sec;
     }
   }
+  if (shown_time != last_shown_time)
+  {
+    last_shown_time = shown_time;
+    time_render_pending = true;
+  }
 #endif
 
-  // Periodically save uptime to NVS (every 60 seconds)
-  save_counter++;
-  if (save_counter >= SAVE_INTERVAL_SECONDS)
+  if (analog_dial)
   {
-    save_counter = 0;
-    esp_err_t ret = uptime_tracker_save();
-    if (ret != ESP_OK)
+    if (valid)
     {
-      ESP_LOGW(TAG, "Failed to save uptime: %s", esp_err_to_name(ret));
+      analog_face_set_time(hour, minute, tm->tm_sec);
+      lv_obj_add_flag(time_label, LV_OBJ_FLAG_HIDDEN);
     }
     else
     {
-      ESP_LOGD(TAG, "Uptime saved to NVS");
+      analog_face_hide_hands();
+      lv_label_set_text(time_label, "--:--");
+      lv_obj_clear_flag(time_label, LV_OBJ_FLAG_HIDDEN);
     }
+    return;
+  }
+
+  if (valid && time_digits_active)
+  {
+    digit_cache_set_time(time_digits, hour, minute);
+    lv_obj_clear_flag(time_digits, LV_OBJ_FLAG_HIDDEN);
+    lv_obj_add_flag(time_label, LV_OBJ_FLAG_HIDDEN);
+    return;
+  }
+
+  // Font label path (no cache, or fallback text the cache cannot draw)
+  if (valid)
+  {
+    lv_label_set_text_fmt(time_label, "%02d:%02d", hour, minute);
+  }
+  else
+  {
+    lv_label_set_text(time_label, "--:--");
+  }
+  lv_obj_clear_flag(time_label, LV_OBJ_FLAG_HIDDEN);
+  if (time_digits)
+  {
+    lv_obj_add_flag(time_digits, LV_OBJ_FLAG_HIDDEN);
+  }
+}
+
+/**
+ * @brief Timer callback to update time and battery
+ *
+ * Runs every second, or on each RTC INT edge when CONFIG_RTC_TICK_INTERRUPT
+ * is in use.
+ */
+static void watchface_timer_cb(lv_timer_t *timer)
+{
+  watchface_data_t data;
+  watchface_get_cached_data(&data);
+
+  // Update uptime counter (RTC memory; flash only every few hours)
+  uptime_tracker_update();
+
+  // Update time from cached data
+  if (data.time_valid)
+  {
+    // Update time (HH:MM format)
+    watchface_set_time(&data.time);
+    complication_sync_clock(data.time.tm_sec);
+
+    // Update date label (Day, Month DD)
+    if (data.time.tm_wday >= 0 && data.time.tm_wday < 7 &&
+        data.time.tm_mon >= 0 && data.time.tm_mon < 12)
+    {
+      lv_label_set_text_fmt(date_label, "%s, %s %d",
+                            day_names[data.time.tm_wday],
+                            month_names[data.time.tm_mon], data.time.tm_mday);
+    }
+  }
+  else
+  {
+    // Fallback display if RTC fails
+    watchface_set_time(NULL);
+    ESP_LOGW(TAG, "Failed to read RTC time");
+  }
+
+  // Battery complication refreshes on its cadence; charger changes at once
+  bool charging = data.battery_valid && data.is_charging;
+  if (charging != last_charging)
+  {
+    last_charging = charging;
+    complication_request_refresh(COMPLICATION_BATTERY);
+  }
+
+  // Lets the tracker save to flash before the battery runs out
+  if (data.battery_valid)
+  {
+    uptime_tracker_set_battery(data.battery_percent, data.is_charging);
   }
 }
 
@@ -303,11 +983,25 @@ lv_obj_t *watchface_create(lv_obj_t *parent)
     return NULL;
   }
 
-  // Initialize RTC
+  // Initialize RTC and seed the system clock from it
   if (rtc_init(i2c) != ESP_OK)
   {
     ESP_LOGE(TAG, "Failed to initialize RTC");
   }
+  else
+  {
+    if (clock_service_init() != ESP_OK)
+    {
+      ESP_LOGE(TAG, "Failed to seed system clock from RTC");
+    }
+
+    if (rtc_tick_get_gpio() >= 0)
+    {
+      // Redraw on INT edges instead of polling every second
+      rtc_tick_set_callback(watchface_rtc_tick, NULL);
+      tick_driven = true;
+    }
+  }
 
   // Initialize PMU
   if (axp2101_init(i2c) != ESP_OK)
@@ -321,15 +1015,6 @@ lv_obj_t *watchface_create(lv_obj_t *parent)
     ESP_LOGE(TAG, "Failed to initialize uptime tracker");
   }
 
-  if (!data_mutex)
-  {
-    data_mutex = xSemaphoreCreateMutex();
-    if (!data_mutex)
-    {
-      ESP_LOGE(TAG, "Failed to create watchface data mutex");
-    }
-  }
-
   if (!data_task_handle)
   {
     BaseType_t task_ret =
@@ -340,89 +1025,78 @@ lv_obj_t *watchface_create(lv_obj_t *parent)
       ESP_LOGE(TAG, "Failed to create watchface data task");
       data_task_handle = NULL;
     }
+    else
+    {
+      // Keep the data task off the I2C bus while the device sleeps
+      const sleep_manager_hook_t sleep_hook = {
+          .name = "watchface_data",
+          .priority = SLEEP_HOOK_PRIORITY_DEFAULT - 10,
+          .prepare = watchface_sleep_prepare,
+          .post_wake = watchface_sleep_post_wake,
+      };
+      sleep_manager_register_hook(&sleep_hook);
+    }
   }
 
   // Use parent tile directly as the screen (no screen_manager needed for tiles)
   screen = parent;
   ESP_LOGI(TAG, "Using parent tile as screen: %p", screen);
 
-  // Build all widgets from configuration table
-  for (size_t i = 0; i < WIDGET_COUNT; i++)
+#ifdef CONFIG_WATCHFACE_GLYPH_CACHE
+  // Draw the time from pre-rasterised glyphs instead of the 48px font
+  if (digit_cache_init(&lv_font_montserrat_48) == ESP_OK)
   {
-    const widget_config_t *config = &widget_configs[i];
-
-    // Create label on the tile
-    lv_obj_t *label = lv_label_create(screen);
-
-    // Set size
-    lv_obj_set_size(label, config->width, config->height);
-
-    // Apply styling
-    lv_obj_set_style_text_font(label, config->font, 0);
-    lv_obj_set_style_transform_scale_x(label, 256, 0); // No scaling
-    lv_obj_set_style_transform_scale_y(label, 256, 0); // No scaling
-    lv_obj_set_style_text_color(label, lv_color_hex(config->color), 0);
-
-    // Set initial text
-    lv_label_set_text(label, config->initial_text);
-
-    // Make label transparent to touch events - don't intercept them
-    lv_obj_clear_flag(label, LV_OBJ_FLAG_CLICKABLE);
-    lv_obj_add_flag(label, LV_OBJ_FLAG_EVENT_BUBBLE);
-
-    // Calculate position based on alignment and safe area
-    int32_t x_offset = 0;
-    int32_t y_offset = 0;
-
-    switch (config->align)
-    {
-    case LV_ALIGN_TOP_LEFT:
-      x_offset = SAFE_AREA_HORIZONTAL;
-      y_offset = SAFE_AREA_TOP;
-      break;
-    case LV_ALIGN_TOP_RIGHT:
-      x_offset = -SAFE_AREA_HORIZONTAL;
-      y_offset = SAFE_AREA_TOP;
-      break;
-    case LV_ALIGN_BOTTOM_LEFT:
-      x_offset = SAFE_AREA_HORIZONTAL;
-      y_offset = -SAFE_AREA_BOTTOM;
-      break;
-    case LV_ALIGN_BOTTOM_RIGHT:
-      x_offset = -SAFE_AREA_HORIZONTAL;
-      y_offset = -SAFE_AREA_BOTTOM;
-      break;
-    case LV_ALIGN_BOTTOM_MID:
-      x_offset = 0;
-      y_offset = -SAFE_AREA_BOTTOM;
-      break;
-    case LV_ALIGN_CENTER:
-    default:
-      // Center alignment uses padding directly as offset
-      x_offset = 0;
-      y_offset = 0;
-      break;
-    }
+    time_digits = digit_cache_create_time(screen, lv_color_hex(0xFFFFFF));
+  }
+  else
+  {
+    ESP_LOGW(TAG, "Glyph cache unavailable, using font label for time");
+  }
+#endif
 
-    // Add custom padding (can be used for stacking or fine-tuning)
-    y_offset += config->padding;
+#ifdef CONFIG_WATCHFACE_STYLE_ANALOG
+  // Dial with hands replaces the time text
+  analog_dial = analog_face_create(screen, CONFIG_WATCHFACE_ANALOG_DIAL_SIZE);
+  if (analog_dial)
+  {
+    lv_obj_align(analog_dial, LV_ALIGN_CENTER, 0, 0);
+  }
+  else
+  {
+    ESP_LOGW(TAG, "Analog face unavailable, using digital time");
+  }
+#endif
 
-    // Position widget
-    lv_obj_align(label, config->align, x_offset, y_offset);
+  // Battery, uptime, boot count, sleep countdown and weather share one timer
+  register_complications();
+  complication_scheduler_start();
 
-    // Store reference
-    *(config->obj_ptr) = label;
-  }
+  // Labels come from the flash layout pack if present, else the table above
+  watchface_layout_load();
+  watchface_apply_layout(0);
 
-#ifdef CONFIG_SLEEP_MANAGER_SLEEP_INDICATOR
-  if (sleep_indicator_label)
+#ifdef CONFIG_WATCHFACE_RENDER_STATS
+  lv_display_t *disp = lv_display_get_default();
+  if (disp)
   {
-    lv_obj_add_flag(sleep_indicator_label, LV_OBJ_FLAG_HIDDEN);
+    lv_display_add_event_cb(disp, time_render_event_cb, LV_EVENT_RENDER_START,
+                            NULL);
+    lv_display_add_event_cb(disp, time_render_event_cb, LV_EVENT_FLUSH_START,
+                            NULL);
+    lv_display_add_event_cb(disp, time_render_event_cb, LV_EVENT_RENDER_READY,
+                            NULL);
   }
 #endif
 
-  // Create update timer (1000ms = 1 second)
-  update_timer = lv_timer_create(watchface_timer_cb, 1000, NULL);
+  // With RTC ticks the data task readies the timer on each edge; the period
+  // is only a fallback in case an edge is missed
+  update_timer = lv_timer_create(watchface_timer_cb,
+                                 tick_driven ? TICK_POLL_MS : 1000, NULL);
+  if (update_timer)
+  {
+    // Redraw the time on the first frame after wake
+    sleep_manager_set_timer_critical(update_timer);
+  }
 
   // Do initial update immediately
   watchface_timer_cb(NULL);
@@ -432,15 +1106,58 @@ lv_obj_t *watchface_create(lv_obj_t *parent)
   return screen;
 }
 
+/**
+ * @brief Publish the battery reading when percent or charging changed
+ */
+static void publish_battery(const watchface_data_t *data)
+{
+  static int16_t last_percent = -1;
+  static bool last_charging = false;
+
+  if (data->battery_percent == last_percent &&
+      data->is_charging == last_charging)
+  {
+    return;
+  }
+  last_percent = data->battery_percent;
+  last_charging = data->is_charging;
+
+  const event_t event = {
+      .type = EVENT_BATTERY,
+      .battery = {.voltage_mv = data->voltage_mv,
+                  .percent = data->battery_percent,
+                  .charging = data->is_charging},
+  };
+  event_bus_publish(&event);
+}
+
 static void watchface_data_task(void *param)
 {
   (void)param;
+  bool redraw = false;
 
   while (1)
   {
+    // Stay off the I2C bus while sleeping; post-wake hook notifies us
+    if (data_task_paused)
+    {
+      ulTaskNotifyTake(pdTRUE, portMAX_DELAY);
+      redraw = true;
+      continue;
+    }
+
     watchface_data_t new_data = {0};
 
-    if (rtc_read_time(&new_data.time) == ESP_OK)
+    // Right after an RTC edge the system clock may still read the last
+    // second; catch it up so the new minute is drawn on the edge
+    if (tick_driven && redraw)
+    {
+      clock_service_sync_to_rtc_edge();
+    }
+
+    // System clock read; the RTC is only consulted when a check is due
+    clock_service_discipline();
+    if (clock_service_get_local_time(&new_data.time) == ESP_OK)
     {
       new_data.time_valid = true;
     }
@@ -452,33 +1169,80 @@ static void watchface_data_task(void *param)
     if (battery_ret == ESP_OK)
     {
       new_data.battery_valid = true;
+      publish_battery(&new_data);
     }
 
-    if (data_mutex && xSemaphoreTake(data_mutex, pdMS_TO_TICKS(200)))
+    seqlock_write(&data_lock, &new_data);
+
+    if (!tick_driven)
     {
-      cached_data = new_data;
-      xSemaphoreGive(data_mutex);
+      ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(1000));
+      continue;
     }
 
-    vTaskDelay(pdMS_TO_TICKS(1000));
+    // Woken by an RTC edge: redraw now rather than on the fallback period
+    if (redraw && bsp_display_lock(0))
+    {
+      if (update_timer)
+      {
+        lv_timer_ready(update_timer);
+      }
+      bsp_display_unlock();
+    }
+
+    // Time only changes on an edge; the timeout just refreshes the battery
+    redraw = ulTaskNotifyTake(pdTRUE, pdMS_TO_TICKS(TICK_POLL_MS)) > 0;
   }
 }
 
-static bool watchface_get_cached_data(watchface_data_t *out)
+/**
+ * @brief RTC INT edge (ISR context), wakes the data task
+ */
+static void watchface_rtc_tick(void *user_data)
 {
-  if (!out || !data_mutex)
+  (void)user_data;
+  BaseType_t woken = pdFALSE;
+  if (data_task_handle)
   {
-    return false;
+    vTaskNotifyGiveFromISR(data_task_handle, &woken);
   }
+  portYIELD_FROM_ISR(woken);
+}
+
+static esp_err_t watchface_sleep_prepare(sleep_manager_sleep_type_t sleep_type,
+                                         void *user_data)
+{
+  (void)sleep_type;
+  (void)user_data;
+  data_task_paused = true;
+  return ESP_OK;
+}
+
+static esp_err_t watchface_sleep_post_wake(sleep_manager_sleep_type_t sleep_type,
+                                           void *user_data)
+{
+  (void)sleep_type;
+  (void)user_data;
+  data_task_paused = false;
 
-  if (xSemaphoreTake(data_mutex, pdMS_TO_TICKS(10)) != pdTRUE)
+  // The system clock ran from the slow RC oscillator while asleep
+  clock_service_request_discipline();
+  if (data_task_handle)
   {
-    return false;
+    xTaskNotifyGive(data_task_handle);
   }
+  return ESP_OK;
+}
 
-  *out = cached_data;
-  xSemaphoreGive(data_mutex);
-  return true;
+/**
+ * @brief Copy the latest data snapshot; never blocks
+ *
+ * Before the first sample both valid flags are false, so callers show
+ * their fallback text.
+ */
+static void watchface_get_cached_data(watchface_data_t *out)
+{
+  seqlock_read(&data_lock, out);
 }
 
 void watchface_update(void)
@@ -490,4 +1254,22 @@ void watchface_update(void)
   }
 }
 
-lv_timer_t *watchface_get_timer(void) { return update_timer; }
\ No newline at end of file
+lv_timer_t *watchface_get_timer(void) { return update_timer; }
+
+size_t watchface_get_layout_count(void)
+{
+  size_t count = watchface_layout_count();
+  return count > 0 ? count : 1;
+}
+
+esp_err_t watchface_set_layout(size_t index)
+{
+  if (!screen || index >= watchface_get_layout_count())
+  {
+    return ESP_ERR_INVALID_ARG;
+  }
+
+  watchface_apply_layout(index);
+  watchface_update();
+  return ESP_OK;
+}
@@ -1,14 +1,16 @@
 /**
  * @file watchface.h
- * @brief Digital Watchface Application
+ * @brief Watchface Application
  *
- * Large digital clock display with battery indicator
+ * Large digital or analog clock display with battery indicator
  */
 
 #ifndef WATCHFACE_H
 #define WATCHFACE_H
 
+#include "esp_err.h"
 #include "lvgl.h"
+#include <stddef.h>
 
 #ifdef __cplusplus
 extern "C" {
@@ -17,8 +19,10 @@ extern "C" {
 /**
  * @brief Create and display the watchface
  *
- * Creates a large digital clock with:
- * - Big HH:MM time display (Montserrat 48)
+ * Creates a large clock with:
+ * - Big HH:MM time display (Montserrat 48, drawn from a glyph cache when
+ *   CONFIG_WATCHFACE_GLYPH_CACHE is enabled), or an analog dial with
+ *   CONFIG_WATCHFACE_STYLE_ANALOG
  * - Date display (Day, Month DD)
  * - Battery percentage indicator in top-right corner
  *
@@ -43,6 +47,24 @@ void watchface_update(void);
  */
 lv_timer_t *watchface_get_timer(void);
 
+/**
+ * @brief Get the number of selectable layouts
+ *
+ * @return Layouts in the flash layout pack, or 1 (built-in) if none
+ */
+size_t watchface_get_layout_count(void);
+
+/**
+ * @brief Switch the watchface to another layout
+ *
+ * Deletes the current labels and builds the new ones from the mapped
+ * layout pack. Call with the display lock held.
+ *
+ * @param index Layout index (0 .. watchface_get_layout_count() - 1)
+ * @return ESP_OK on success, ESP_ERR_INVALID_ARG if index is out of range
+ */
+esp_err_t watchface_set_layout(size_t index);
+
 #ifdef __cplusplus
 }
 #endif
@@ -0,0 +1,218 @@
+/**
+ * @file watchface_layout.c
+ * @brief Binary watchface layout pack loader
+ */
+
+#include "watchface_layout.h"
+
+#ifdef CONFIG_WATCHFACE_LAYOUT_FROM_FLASH
+
+#include "esp_log.h"
+#include "esp_partition.h"
+#include "esp_rom_crc.h"
+#include <stdbool.h>
+
+static const char *TAG = "WFLayout";
+
+#define LAYOUT_PARTITION_LABEL "storage"
+
+static esp_partition_mmap_handle_t map_handle;
+
+// Views into the mapped pack, valid once load succeeded
+static const wf_layout_header_t *pack = NULL;
+static const wf_layout_entry_t *entries = NULL;
+static const wf_layout_widget_t *widgets = NULL;
+static const char *strings = NULL;
+
+static bool string_valid(const wf_layout_header_t *hdr, uint16_t offset)
+{
+  // The table ends with NUL (checked once), so any offset inside is terminated
+  return offset < hdr->string_size;
+}
+
+/**
+ * @brief Check every field so the builder can use the pack without checks
+ */
+static esp_err_t validate_pack(const uint8_t *base, size_t mapped_size)
+{
+  const wf_layout_header_t *hdr = (const wf_layout_header_t *)base;
+
+  if (mapped_size < sizeof(*hdr) || hdr->magic != WF_LAYOUT_MAGIC)
+  {
+    return ESP_ERR_NOT_FOUND;
+  }
+
+  if (hdr->version != WF_LAYOUT_VERSION)
+  {
+    ESP_LOGE(TAG, "Unsupported layout version %u", hdr->version);
+    return ESP_ERR_INVALID_VERSION;
+  }
+
+  size_t expected = sizeof(*hdr) + hdr->layout_count * sizeof(wf_layout_entry_t) +
+                    hdr->widget_count * sizeof(wf_layout_widget_t) +
+                    hdr->string_size;
+  if (hdr->layout_count == 0 || hdr->total_size != expected ||
+      hdr->total_size > mapped_size)
+  {
+    ESP_LOGE(TAG, "Bad layout pack size %lu (expected %u, window %u)",
+             (unsigned long)hdr->total_size, (unsigned)expected,
+             (unsigned)mapped_size);
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  uint32_t crc = esp_rom_crc32_le(0, base + sizeof(*hdr),
+                                  hdr->total_size - sizeof(*hdr));
+  if (crc != hdr->crc32)
+  {
+    ESP_LOGE(TAG, "Layout pack CRC mismatch (0x%08lx != 0x%08lx)",
+             (unsigned long)crc, (unsigned long)hdr->crc32);
+    return ESP_ERR_INVALID_CRC;
+  }
+
+  const wf_layout_entry_t *ent =
+      (const wf_layout_entry_t *)(base + sizeof(*hdr));
+  const wf_layout_widget_t *wid =
+      (const wf_layout_widget_t *)(ent + hdr->layout_count);
+  const char *str = (const char *)(wid + hdr->widget_count);
+
+  if (hdr->string_size == 0 || str[hdr->string_size - 1] != '\0')
+  {
+    ESP_LOGE(TAG, "Layout string table not terminated");
+    return ESP_ERR_INVALID_SIZE;
+  }
+
+  for (uint8_t l = 0; l < hdr->layout_count; l++)
+  {
+    const wf_layout_entry_t *e = &ent[l];
+    if (!string_valid(hdr, e->name_offset) || e->widget_count == 0 ||
+        e->widget_count > WF_LAYOUT_MAX_WIDGETS ||
+        e->first_widget + e->widget_count > hdr->widget_count)
+    {
+      ESP_LOGE(TAG, "Layout %u: bad entry", l);
+      return ESP_ERR_INVALID_SIZE;
+    }
+
+    uint32_t bound = 0;
+    for (uint8_t i = 0; i < e->widget_count; i++)
+    {
+      const wf_layout_widget_t *w = &wid[e->first_widget + i];
+      bool text_ok = (w->text_offset == WF_LAYOUT_NO_TEXT) ||
+                     string_valid(hdr, w->text_offset);
+
+      if (w->type >= WF_WIDGET_TYPE_COUNT || w->font >= WF_FONT_COUNT ||
+          w->align >= WF_ALIGN_COUNT || w->binding >= WF_BIND_COUNT ||
+          !text_ok)
+      {
+        ESP_LOGE(TAG, "Layout %u widget %u: invalid field", l, i);
+        return ESP_ERR_INVALID_ARG;
+      }
+
+      // Each data binding drives exactly one label
+      if (w->binding != WF_BIND_NONE)
+      {
+        if (bound & (1u << w->binding))
+        {
+          ESP_LOGE(TAG, "Layout %u widget %u: binding %u used twice", l, i,
+                   w->binding);
+          return ESP_ERR_INVALID_ARG;
+        }
+        bound |= 1u << w->binding;
+      }
+    }
+  }
+
+  pack = hdr;
+  entries = ent;
+  widgets = wid;
+  strings = str;
+  return ESP_OK;
+}
+
+esp_err_t watchface_layout_load(void)
+{
+  if (pack)
+  {
+    return ESP_OK;
+  }
+
+  const esp_partition_t *part = esp_partition_find_first(
+      ESP_PARTITION_TYPE_DATA, ESP_PARTITION_SUBTYPE_ANY, LAYOUT_PARTITION_LABEL);
+  if (!part || part->size <= CONFIG_WATCHFACE_LAYOUT_OFFSET)
+  {
+    ESP_LOGW(TAG, "No '%s' partition for layouts", LAYOUT_PARTITION_LABEL);
+    return ESP_ERR_NOT_FOUND;
+  }
+
+  size_t window = part->size - CONFIG_WATCHFACE_LAYOUT_OFFSET;
+  if (window > WF_LAYOUT_MAX_SIZE)
+  {
+    window = WF_LAYOUT_MAX_SIZE;
+  }
+
+  const void *base = NULL;
+  esp_err_t ret = esp_partition_mmap(part, CONFIG_WATCHFACE_LAYOUT_OFFSET,
+                                     window, ESP_PARTITION_MMAP_DATA, &base,
+                                     &map_handle);
+  if (ret != ESP_OK)
+  {
+    ESP_LOGE(TAG, "Failed to map layout pack: %s", esp_err_to_name(ret));
+    return ret;
+  }
+
+  ret = validate_pack(base, window);
+  if (ret != ESP_OK)
+  {
+    if (ret == ESP_ERR_NOT_FOUND)
+    {
+      ESP_LOGI(TAG, "No layout pack in flash, using built-in layout");
+    }
+    esp_partition_munmap(map_handle);
+    return ret;
+  }
+
+  ESP_LOGI(TAG, "Layout pack mapped: %u layout(s), %u widget(s), %lu bytes",
+           pack->layout_count, pack->widget_count,
+           (unsigned long)pack->total_size);
+  return ESP_OK;
+}
+
+size_t watchface_layout_count(void) { return pack ? pack->layout_count : 0; }
+
+const char *watchface_layout_name(size_t index)
+{
+  if (!pack || index >= pack->layout_count)
+  {
+    return NULL;
+  }
+  return strings + entries[index].name_offset;
+}
+
+const wf_layout_widget_t *watchface_layout_widgets(size_t index,
+                                                   size_t *count)
+{
+  if (!pack || index >= pack->layout_count)
+  {
+    if (count)
+    {
+      *count = 0;
+    }
+    return NULL;
+  }
+
+  if (count)
+  {
+    *count = entries[index].widget_count;
+  }
+  return &widgets[entries[index].first_widget];
+}
+
+const char *watchface_layout_string(uint16_t offset)
+{
+  if (!pack || offset == WF_LAYOUT_NO_TEXT || offset >= pack->string_size)
+  {
+    return NULL;
+  }
+  return strings + offset;
+}
+
+#endif // CONFIG_WATCHFACE_LAYOUT_FROM_FLASH
@@ -0,0 +1,214 @@
+/**
+ * @file watchface_layout.h
+ * @brief Binary watchface layout pack read from flash
+ *
+ * A layout pack describes one or more watchface layouts (label widgets with
+ * font, color, alignment, safe-area offsets and a data binding). It is
+ * produced on the host by tools/wf_layout_compiler.py and written to the
+ * `storage` partition. At boot the pack is memory-mapped with
+ * esp_partition_mmap() and validated once; afterwards widgets and strings
+ * are read in place, so building a watchface copies nothing to the heap.
+ *
+ * Pack layout (little-endian):
+ *
+ *   wf_layout_header_t
+ *   wf_layout_entry_t   [layout_count]
+ *   wf_layout_widget_t  [widget_count]
+ *   string table        [string_size]   (NUL-terminated strings)
+ *
+ * The CRC32 covers everything after the header.
+ */
+
+#ifndef WATCHFACE_LAYOUT_H
+#define WATCHFACE_LAYOUT_H
+
+#include "esp_err.h"
+#include "sdkconfig.h"
+#include <stddef.h>
+#include <stdint.h>
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define WF_LAYOUT_MAGIC 0x594C4657 // "WFLY"
+#define WF_LAYOUT_VERSION 1
+
+/** Maximum widgets in one layout */
+#define WF_LAYOUT_MAX_WIDGETS 24
+
+/** Bytes mapped from the partition; a pack must fit in this window */
+#define WF_LAYOUT_MAX_SIZE (16 * 1024)
+
+/** text_offset value for widgets without initial text */
+#define WF_LAYOUT_NO_TEXT 0xFFFF
+
+/** Widget flag: position is relative to the screen edge, not the safe area */
+#define WF_LAYOUT_FLAG_NO_SAFE_AREA 0x01
+
+typedef enum
+{
+  WF_WIDGET_LABEL = 0,
+  WF_WIDGET_TYPE_COUNT
+} wf_layout_widget_type_t;
+
+/** Watchface data shown by a widget (NONE = static text) */
+typedef enum
+{
+  WF_BIND_NONE = 0,
+  WF_BIND_TIME,
+  WF_BIND_DATE,
+  WF_BIND_BATTERY,
+  WF_BIND_UPTIME,
+  WF_BIND_BOOT_COUNT,
+  WF_BIND_SLEEP_INDICATOR,
+  WF_BIND_WEATHER,
+  WF_BIND_COUNT
+} wf_layout_binding_t;
+
+/** Montserrat sizes, mapped to the fonts enabled in the build */
+typedef enum
+{
+  WF_FONT_12 = 0,
+  WF_FONT_14,
+  WF_FONT_16,
+  WF_FONT_18,
+  WF_FONT_20,
+  WF_FONT_22,
+  WF_FONT_24,
+  WF_FONT_26,
+  WF_FONT_48,
+  WF_FONT_COUNT
+} wf_layout_font_t;
+
+/** Alignment, same order as lv_align_t starting at LV_ALIGN_TOP_LEFT */
+typedef enum
+{
+  WF_ALIGN_TOP_LEFT = 0,
+  WF_ALIGN_TOP_MID,
+  WF_ALIGN_TOP_RIGHT,
+  WF_ALIGN_BOTTOM_LEFT,
+  WF_ALIGN_BOTTOM_MID,
+  WF_ALIGN_BOTTOM_RIGHT,
+  WF_ALIGN_LEFT_MID,
+  WF_ALIGN_RIGHT_MID,
+  WF_ALIGN_CENTER,
+  WF_ALIGN_COUNT
+} wf_layout_align_t;
+
+typedef struct __attribute__((packed))
+{
+  uint32_t magic;
+  uint16_t version;
+  uint8_t layout_count;
+  uint8_t reserved;
+  uint16_t widget_count; ///< Widgets of all layouts
+  uint16_t string_size;
+  uint32_t total_size; ///< Whole pack including this header
+  uint32_t crc32;      ///< CRC32 of everything after the header
+} wf_layout_header_t;
+
+typedef struct __attribute__((packed))
+{
+  uint16_t name_offset;  ///< Layout name in the string table
+  uint16_t first_widget; ///< Index into the widget array
+  uint8_t widget_count;
+  uint8_t reserved[3];
+} wf_layout_entry_t;
+
+typedef struct __attribute__((packed))
+{
+  uint8_t type;    ///< wf_layout_widget_type_t
+  uint8_t font;    ///< wf_layout_font_t
+  uint8_t align;   ///< wf_layout_align_t
+  uint8_t binding; ///< wf_layout_binding_t
+  uint32_t color;  ///< 0xRRGGBB
+  int16_t x_ofs;   ///< Added to the safe-area offset
+  int16_t y_ofs;
+  uint16_t text_offset; ///< Initial text, WF_LAYOUT_NO_TEXT if none
+  uint8_t flags;        ///< WF_LAYOUT_FLAG_*
+  uint8_t reserved;
+} wf_layout_widget_t;
+
+_Static_assert(sizeof(wf_layout_header_t) == 20, "layout header size");
+_Static_assert(sizeof(wf_layout_entry_t) == 8, "layout entry size");
+_Static_assert(sizeof(wf_layout_widget_t) == 16, "layout widget size");
+
+#ifdef CONFIG_WATCHFACE_LAYOUT_FROM_FLASH
+
+/**
+ * @brief Map and validate the layout pack in the storage partition
+ *
+ * Safe to call more than once; the mapping is kept for the lifetime of
+ * the firmware because labels reference its strings directly.
+ *
+ * @return ESP_OK if a valid pack is mapped, ESP_ERR_NOT_FOUND if the
+ *         partition is missing, ESP_ERR_INVALID_VERSION or
+ *         ESP_ERR_INVALID_CRC / ESP_ERR_INVALID_SIZE if the pack is bad
+ */
+esp_err_t watchface_layout_load(void);
+
+/**
+ * @brief Number of layouts in the loaded pack (0 if none)
+ */
+size_t watchface_layout_count(void);
+
+/**
+ * @brief Name of a layout
+ *
+ * @return Name inside the mapped pack, or NULL if index is out of range
+ */
+const char *watchface_layout_name(size_t index);
+
+/**
+ * @brief Widgets of a layout, read in place from the mapped pack
+ *
+ * @param index Layout index
+ * @param[out] count Number of widgets
+ * @return First widget, or NULL if index is out of range
+ */
+const wf_layout_widget_t *watchface_layout_widgets(size_t index,
+                                                   size_t *count);
+
+/**
+ * @brief String from the pack string table
+ *
+ * @return Pointer into the mapped pack, or NULL for WF_LAYOUT_NO_TEXT
+ */
+const char *watchface_layout_string(uint16_t offset);
+
+#else
+
+static inline esp_err_t watchface_layout_load(void)
+{
+  return ESP_ERR_NOT_SUPPORTED;
+}
+static inline size_t watchface_layout_count(void) { return 0; }
+static inline const char *watchface_layout_name(size_t index)
+{
+  (void)index;
+  return NULL;
+}
+static inline const wf_layout_widget_t *watchface_layout_widgets(size_t index,
+                                                                 size_t *count)
+{
+  (void)index;
+  if (count)
+  {
+    *count = 0;
+  }
+  return NULL;
+}
+static inline const char *watchface_layout_string(uint16_t offset)
+{
+  (void)offset;
+  return NULL;
+}
+
+#endif // CONFIG_WATCHFACE_LAYOUT_FROM_FLASH
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // WATCHFACE_LAYOUT_H
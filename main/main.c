@@ -13,6 +13,15 @@
 #ifdef CONFIG_ENABLE_OTA
 #include "ota_manager.h"
 #endif
+#ifdef CONFIG_NET_SCHEDULER_ENABLE
+#include "net_scheduler.h"
+#endif
+#ifdef CONFIG_WEATHER_ENABLE
+#include "weather.h"
+#endif
+#ifdef CONFIG_BLE_SYNC_ENABLE
+#include "ble_sync.h"
+#endif
 #include "apps/settings/settings.h"
 #include "apps/watchface/watchface.h"
 #include "bsp/display.h"
@@ -23,6 +32,7 @@
 #include "esp_log.h"
 #include "esp_system.h"
 #include "esp_task_wdt.h"
+#include "event_bus.h"
 #include "freertos/FreeRTOS.h"
 #include "freertos/task.h"
 #include "lvgl.h"
@@ -30,6 +40,7 @@
 #include "screen_manager.h"
 #include "settings_storage.h"
 #include "sleep_manager.h"
+#include "ui_state.h"
 
 static const char *TAG = "Main";
 
@@ -38,111 +49,188 @@ static lv_obj_t *g_tileview = NULL;
 static lv_obj_t *g_watchface_tile = NULL;
 static lv_obj_t *g_settings_tile = NULL;
 
-#ifdef CONFIG_APP_STATE_RESTORE_ENABLE
-static int32_t g_saved_tile_row = 0;
-static int32_t g_saved_tile_col = 0;
-
-#define SETTINGS_KEY_TILE_ROW "ui_tile_row"
-#define SETTINGS_KEY_TILE_COL "ui_tile_col"
+#ifdef CONFIG_APP_WATCHDOG_ENABLE
+static TaskHandle_t app_watchdog_task_handle = NULL;
 
-static void app_state_restore_save_tile(int32_t col, int32_t row)
+static void app_watchdog_task(void *param)
 {
-  if (col == g_saved_tile_col && row == g_saved_tile_row)
-  {
-    return;
-  }
+  (void)param;
+  ESP_LOGI(TAG, "App watchdog task started");
 
-  esp_err_t row_ret = settings_set_int(SETTINGS_KEY_TILE_ROW, row);
-  esp_err_t col_ret = settings_set_int(SETTINGS_KEY_TILE_COL, col);
-  if (row_ret != ESP_OK || col_ret != ESP_OK)
+  esp_err_t add_ret = esp_task_wdt_add(NULL);
+  if (add_ret != ESP_OK)
   {
-    ESP_LOGW(TAG, "Failed to persist tile state (row=%ld col=%ld)",
-             (long)row, (long)col);
+    ESP_LOGE(TAG, "Failed to add watchdog task: %s", esp_err_to_name(add_ret));
   }
-  else
+
+  while (1)
   {
-    g_saved_tile_row = row;
-    g_saved_tile_col = col;
+    esp_task_wdt_reset();
+    vTaskDelay(pdMS_TO_TICKS(CONFIG_APP_WATCHDOG_FEED_INTERVAL_MS));
   }
 }
+#endif
 
-static void app_state_restore_load_tile(int32_t *col, int32_t *row)
+#ifdef CONFIG_ENABLE_WIFI
+// WiFi state changes, delivered by the event bus task
+static void wifi_state_event(const event_t *event, void *user_data)
 {
-  int32_t saved_row = 0;
-  int32_t saved_col = 0;
-
-  settings_get_int(SETTINGS_KEY_TILE_ROW, 0, &saved_row);
-  settings_get_int(SETTINGS_KEY_TILE_COL, 0, &saved_col);
+  (void)user_data;
+  wifi_state_t state = (wifi_state_t)event->wifi.state;
+  ESP_LOGI(TAG, "WiFi state changed: %d", state);
 
-  if (saved_row < 0 || saved_row > 1)
+#ifdef CONFIG_NET_SCHEDULER_ENABLE
+  if (state == WIFI_STATE_CONNECTED)
+  {
+    // Due jobs share this connection
+    net_scheduler_kick();
+  }
+#else
+#ifdef CONFIG_NTP_CLIENT_ENABLE
+  if (state == WIFI_STATE_CONNECTED)
   {
-    saved_row = 0;
+    ntp_client_on_wifi_connected();
   }
+#endif
 
-  if (saved_col < 0 || saved_col > 0)
+#ifdef CONFIG_ENABLE_OTA
+  if (state == WIFI_STATE_CONNECTED)
   {
-    saved_col = 0;
+    // Rides on this session; never brings WiFi up by itself
+    ota_manager_on_wifi_connected();
   }
+#endif
+#endif
+}
+
+#ifdef CONFIG_NET_SCHEDULER_ENABLE
+#ifdef CONFIG_NTP_CLIENT_ENABLE
+// Longest a sync keeps the session waiting (DNS plus all queries)
+#define NTP_JOB_TIMEOUT_MS 15000
+
+static int ntp_job_id = -1;
 
-  *row = saved_row;
-  *col = saved_col;
-  g_saved_tile_row = saved_row;
-  g_saved_tile_col = saved_col;
+static bool ntp_job_run(void *user_data)
+{
+  (void)user_data;
+  return ntp_client_sync_wait(NTP_JOB_TIMEOUT_MS) == ESP_OK;
 }
 
-static void tileview_state_event_cb(lv_event_t *e)
+static uint32_t ntp_job_due_in(void *user_data)
 {
-  lv_obj_t *tileview = lv_event_get_target(e);
-  lv_obj_t *active_tile = lv_tileview_get_tile_active(tileview);
+  (void)user_data;
+  return ntp_client_next_sync_in_s();
+}
 
-  if (active_tile == g_watchface_tile)
-  {
-    app_state_restore_save_tile(0, 0);
-  }
-  else if (active_tile == g_settings_tile)
+#ifdef CONFIG_BLE_SYNC_ENABLE
+// A phone set the time over BLE: move the NTP job's deadline out with it.
+// NTP's own syncs are published from inside the job, which reschedules
+// itself when it returns.
+static void ntp_job_time_synced(const event_t *event, void *user_data)
+{
+  (void)user_data;
+  if (event->time_sync.ok && event->time_sync.source == EVENT_TIME_SYNC_BLE &&
+      ntp_job_id >= 0)
   {
-    app_state_restore_save_tile(0, 1);
+    net_scheduler_refresh(ntp_job_id);
   }
 }
 #endif
+#endif
 
-#ifdef CONFIG_APP_WATCHDOG_ENABLE
-static TaskHandle_t app_watchdog_task_handle = NULL;
-
-static void app_watchdog_task(void *param)
+#ifdef CONFIG_OTA_AUTO_CHECK
+static bool ota_job_run(void *user_data)
 {
-  (void)param;
-  ESP_LOGI(TAG, "App watchdog task started");
-
-  esp_err_t add_ret = esp_task_wdt_add(NULL);
-  if (add_ret != ESP_OK)
+  (void)user_data;
+  ota_version_info_t info;
+  esp_err_t ret = ota_manager_check_for_update(NULL, &info);
+  if (ret == ESP_OK && info.update_available)
   {
-    ESP_LOGE(TAG, "Failed to add watchdog task: %s", esp_err_to_name(add_ret));
+    ESP_LOGW(TAG, "Firmware %s is available", info.version);
   }
+  return ret == ESP_OK;
+}
 
-  while (1)
-  {
-    esp_task_wdt_reset();
-    vTaskDelay(pdMS_TO_TICKS(CONFIG_APP_WATCHDOG_FEED_INTERVAL_MS));
-  }
+static uint32_t ota_job_due_in(void *user_data)
+{
+  (void)user_data;
+  return ota_manager_check_due_in_s();
 }
 #endif
 
-#ifdef CONFIG_ENABLE_WIFI
-// WiFi status callback
-static void wifi_status_callback(wifi_state_t state, void *user_data)
+#ifdef CONFIG_WEATHER_ENABLE
+static bool weather_job_run(void *user_data)
 {
-  ESP_LOGI(TAG, "WiFi state changed: %d", state);
-  wifi_settings_update_status();
+  (void)user_data;
+  return weather_fetch() == ESP_OK;
+}
+
+static uint32_t weather_job_due_in(void *user_data)
+{
+  (void)user_data;
+  return weather_fetch_due_in_s();
+}
+#endif
 
+/**
+ * @brief Hand periodic network work to the scheduler
+ *
+ * Windows are a quarter of each interval, so a job that comes due soon
+ * rides along with one that is due now instead of waking WiFi again.
+ */
+static void register_network_jobs(void)
+{
 #ifdef CONFIG_NTP_CLIENT_ENABLE
-  if (state == WIFI_STATE_CONNECTED)
-  {
-    ntp_client_on_wifi_connected();
-  }
+  const net_job_t ntp_job = {
+      .name = "ntp",
+      .run = ntp_job_run,
+      .due_in_s = ntp_job_due_in,
+      .window_s = CONFIG_NTP_SYNC_INTERVAL_MIN * 60 / 4,
+      .retry_s = 10 * 60,
+      .cost_ms = 2000,
+  };
+  ntp_job_id = net_scheduler_add_job(&ntp_job);
+#ifdef CONFIG_BLE_SYNC_ENABLE
+  event_bus_subscribe(EVENT_MASK(EVENT_TIME_SYNC), EVENT_CTX_WORKER,
+                      ntp_job_time_synced, NULL);
+#endif
+#endif
+
+#ifdef CONFIG_OTA_AUTO_CHECK
+  const net_job_t ota_job = {
+      .name = "ota_check",
+      .run = ota_job_run,
+      .due_in_s = ota_job_due_in,
+      .window_s = CONFIG_OTA_CHECK_INTERVAL_HOURS * 3600 / 4,
+      .retry_s = 60 * 60,
+      .cost_ms = 3000,
+  };
+  net_scheduler_add_job(&ota_job);
 #endif
+
+#ifdef CONFIG_WEATHER_ENABLE
+  // The deadline is share-wait past stale and the window the whole wait, so
+  // a stale forecast rides along with other jobs and rarely wakes WiFi
+  const net_job_t weather_job = {
+      .name = "weather",
+      .run = weather_job_run,
+      .due_in_s = weather_job_due_in,
+      .window_s = CONFIG_WEATHER_SHARE_WAIT_MIN * 60,
+      .retry_s = 15 * 60,
+      .cost_ms = 2000,
+  };
+  net_scheduler_add_job(&weather_job);
+#endif
+}
+#elif defined(CONFIG_NTP_CLIENT_ENABLE)
+// Network consumer: bring WiFi back after sleep only when a sync is due
+static bool ntp_needs_network(void *user_data)
+{
+  (void)user_data;
+  return ntp_client_needs_sync();
 }
 #endif
+#endif
 
 void app_main(void)
 {
@@ -201,6 +289,13 @@ void app_main(void)
   ESP_LOGI(TAG, "Initializing display...");
   bsp_display_start();
 
+  // UI subscribers are called with the display lock held
+  ret = event_bus_init(bsp_display_lock, bsp_display_unlock);
+  if (ret != ESP_OK)
+  {
+    ESP_LOGE(TAG, "Failed to initialize event bus: %s", esp_err_to_name(ret));
+  }
+
   // Initialize screen manager
   ESP_LOGI(TAG, "Initializing screen manager...");
   ret = screen_manager_init();
@@ -222,8 +317,12 @@ void app_main(void)
   }
   else
   {
-    // Register WiFi status callback
-    wifi_manager_register_callback(wifi_status_callback, NULL);
+    event_bus_subscribe(EVENT_MASK(EVENT_WIFI_STATE), EVENT_CTX_WORKER,
+                        wifi_state_event, NULL);
+
+#if defined(CONFIG_NTP_CLIENT_ENABLE) && !defined(CONFIG_NET_SCHEDULER_ENABLE)
+    wifi_manager_register_consumer("ntp", ntp_needs_network, NULL);
+#endif
 
 #ifdef CONFIG_WIFI_AUTO_CONNECT
     // Auto-connect (uses saved credentials or defaults if configured)
@@ -263,6 +362,36 @@ void app_main(void)
   ESP_LOGI(TAG, "OTA updates disabled in configuration");
 #endif
 
+#ifdef CONFIG_WEATHER_ENABLE
+  // Loads the cached forecast so the watchface has it from the first frame
+  weather_init();
+#endif
+
+#ifdef CONFIG_NET_SCHEDULER_ENABLE
+  // Jobs ask NTP, OTA and weather when they are due, so those come up first
+  ESP_LOGI(TAG, "Initializing network scheduler...");
+  ret = net_scheduler_init();
+  if (ret == ESP_OK)
+  {
+    register_network_jobs();
+  }
+  else
+  {
+    ESP_LOGE(TAG, "Failed to initialize network scheduler: %s",
+             esp_err_to_name(ret));
+  }
+#endif
+
+#ifdef CONFIG_BLE_SYNC_ENABLE
+  // Phone time writes go through the NTP client and the scheduler
+  ESP_LOGI(TAG, "Initializing BLE sync...");
+  ret = ble_sync_init();
+  if (ret != ESP_OK)
+  {
+    ESP_LOGE(TAG, "Failed to initialize BLE sync: %s", esp_err_to_name(ret));
+  }
+#endif
+
 #ifdef CONFIG_SLEEP_MANAGER_ENABLE
   // Initialize sleep manager
   ESP_LOGI(TAG, "Initializing sleep manager...");
@@ -342,33 +471,27 @@ void app_main(void)
   // This avoids navigation stack issues and memory leaks.
 
   // Set watchface tile as the active tile initially
-  int32_t target_tile_col = 0;
-  int32_t target_tile_row = 0;
+  lv_tileview_set_tile_by_index(tileview, 0, 0, LV_ANIM_OFF);
+
+  // CRITICAL: Load the tileview screen to make it visible
+  lv_scr_load(tileview_screen);
+  ESP_LOGI(TAG, "Tileview screen loaded and now active");
+
+  // Register tileview screen as root for navigation stack
+  screen_manager_set_root(tileview_screen);
 
 #ifdef CONFIG_APP_STATE_RESTORE_ENABLE
+  // Put the user back on the exact screen they left before deep sleep
+  ui_state_init(tileview);
+
   sleep_manager_sleep_type_t last_sleep_type = SLEEP_MANAGER_SLEEP_TYPE_NONE;
   if (sleep_manager_get_last_sleep_type(&last_sleep_type) &&
       last_sleep_type == SLEEP_MANAGER_SLEEP_TYPE_DEEP)
   {
-    app_state_restore_load_tile(&target_tile_col, &target_tile_row);
-    ESP_LOGI(TAG, "Restoring tile after deep sleep: (%ld,%ld)",
-             (long)target_tile_col, (long)target_tile_row);
+    ui_state_restore();
   }
-
-  lv_obj_add_event_cb(tileview, tileview_state_event_cb,
-                      LV_EVENT_VALUE_CHANGED, NULL);
 #endif
 
-  lv_tileview_set_tile_by_index(tileview, target_tile_col, target_tile_row,
-                                LV_ANIM_OFF);
-
-  // CRITICAL: Load the tileview screen to make it visible
-  lv_scr_load(tileview_screen);
-  ESP_LOGI(TAG, "Tileview screen loaded and now active");
-
-  // Register tileview screen as root for navigation stack
-  screen_manager_set_root(tileview_screen);
-
   // Unlock LVGL
   bsp_display_unlock();
 
@@ -379,4 +502,9 @@ void app_main(void)
   btn_config.tileview = &g_tileview;
   button_handler_init(&btn_config);
   ESP_LOGI(TAG, "Button handler initialized (short=back, long 3s=reset)");
+
+#ifdef CONFIG_ENABLE_OTA
+  // Everything is up: keep a freshly installed image (or roll it back)
+  ota_manager_confirm_boot();
+#endif
 }
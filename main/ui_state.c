@@ -0,0 +1,235 @@
+/**
+ * @file ui_state.c
+ * @brief UI navigation state snapshot implementation
+ */
+
+#include "ui_state.h"
+
+#ifdef CONFIG_APP_STATE_RESTORE_ENABLE
+
+#include "bsp/esp-bsp.h"
+#include "esp_attr.h"
+#include "esp_log.h"
+#include "esp_rom_crc.h"
+#include "screen_manager.h"
+#include "settings.h"
+#include "sleep_manager.h"
+#include <stddef.h>
+#include <string.h>
+
+static const char *TAG = "UIState";
+
+#define UI_STATE_MAGIC 0x55495354 // "UIST"
+#define UI_STATE_VERSION 1
+
+/** Screens above the root that fit in the snapshot */
+#define UI_STATE_MAX_SCREENS 7
+
+/** scroll_child value meaning "the screen object itself" */
+#define UI_STATE_SCROLL_SELF 0xFF
+
+typedef struct
+{
+  uint32_t magic;
+  uint8_t version;
+  uint8_t tile_col;
+  uint8_t tile_row;
+  uint8_t depth; ///< Screens above the root
+  uint8_t screen_ids[UI_STATE_MAX_SCREENS];
+  uint8_t scroll_child[UI_STATE_MAX_SCREENS];
+  int16_t scroll_y[UI_STATE_MAX_SCREENS];
+  int16_t menu_scroll_y;
+  int8_t menu_selected;
+  uint32_t checksum; ///< CRC32 of all fields above
+} ui_state_snapshot_t;
+
+RTC_DATA_ATTR static ui_state_snapshot_t rtc_snapshot;
+
+static lv_obj_t *s_tileview = NULL;
+
+static uint32_t snapshot_checksum(const ui_state_snapshot_t *snap)
+{
+  return esp_rom_crc32_le(0, (const uint8_t *)snap,
+                          offsetof(ui_state_snapshot_t, checksum));
+}
+
+static bool snapshot_valid(const ui_state_snapshot_t *snap)
+{
+  return snap->magic == UI_STATE_MAGIC && snap->version == UI_STATE_VERSION &&
+         snap->depth <= UI_STATE_MAX_SCREENS &&
+         snap->checksum == snapshot_checksum(snap);
+}
+
+/**
+ * @brief Find the scrolled object of a screen (the screen or a direct child)
+ */
+static void capture_scroll(lv_obj_t *screen, uint8_t *child, int16_t *scroll_y)
+{
+  *child = UI_STATE_SCROLL_SELF;
+  *scroll_y = (int16_t)lv_obj_get_scroll_y(screen);
+  if (*scroll_y != 0)
+  {
+    return;
+  }
+
+  uint32_t count = lv_obj_get_child_count(screen);
+  for (uint32_t i = 0; i < count && i < UI_STATE_SCROLL_SELF; i++)
+  {
+    int32_t y = lv_obj_get_scroll_y(lv_obj_get_child(screen, i));
+    if (y != 0)
+    {
+      *child = (uint8_t)i;
+      *scroll_y = (int16_t)y;
+      return;
+    }
+  }
+}
+
+static void restore_scroll(lv_obj_t *screen, uint8_t child, int16_t scroll_y)
+{
+  if (scroll_y == 0)
+  {
+    return;
+  }
+
+  lv_obj_t *target = (child == UI_STATE_SCROLL_SELF)
+                         ? screen
+                         : lv_obj_get_child(screen, child);
+  if (target)
+  {
+    lv_obj_update_layout(target);
+    lv_obj_scroll_to_y(target, scroll_y, LV_ANIM_OFF);
+  }
+}
+
+/**
+ * @brief Capture the current UI state (display lock must be held)
+ */
+static void ui_state_capture(void)
+{
+  ui_state_snapshot_t snap = {0};
+  snap.magic = UI_STATE_MAGIC;
+  snap.version = UI_STATE_VERSION;
+
+  if (s_tileview)
+  {
+    lv_obj_t *tile = lv_tileview_get_tile_active(s_tileview);
+    int32_t w = lv_obj_get_width(s_tileview);
+    int32_t h = lv_obj_get_height(s_tileview);
+    if (tile && w > 0 && h > 0)
+    {
+      snap.tile_col = (uint8_t)(lv_obj_get_x(tile) / w);
+      snap.tile_row = (uint8_t)(lv_obj_get_y(tile) / h);
+    }
+  }
+
+  // Stop at the first screen that cannot be recreated by id
+  int depth = screen_manager_get_depth();
+  for (int i = 1; i < depth && snap.depth < UI_STATE_MAX_SCREENS; i++)
+  {
+    lv_obj_t *screen = screen_manager_get_screen_at(i);
+    uint8_t id = screen_manager_get_screen_id(screen);
+    if (id == 0)
+    {
+      break;
+    }
+
+    snap.screen_ids[snap.depth] = id;
+    capture_scroll(screen, &snap.scroll_child[snap.depth],
+                   &snap.scroll_y[snap.depth]);
+    snap.depth++;
+  }
+
+  snap.menu_scroll_y = (int16_t)settings_get_menu_scroll();
+  snap.menu_selected = (int8_t)settings_get_selected_item();
+  snap.checksum = snapshot_checksum(&snap);
+
+  rtc_snapshot = snap;
+
+  ESP_LOGI(TAG, "UI state captured: tile (%d,%d), %d screen(s), menu item %d",
+           snap.tile_col, snap.tile_row, snap.depth, snap.menu_selected);
+}
+
+/**
+ * @brief Sleep hook: capture the UI state before deep sleep
+ */
+static esp_err_t ui_state_sleep_prepare(sleep_manager_sleep_type_t sleep_type,
+                                        void *user_data)
+{
+  (void)user_data;
+
+  if (sleep_type != SLEEP_MANAGER_SLEEP_TYPE_DEEP)
+  {
+    return ESP_OK;
+  }
+
+  if (!bsp_display_lock(200))
+  {
+    ESP_LOGW(TAG, "Display lock busy - UI state not captured");
+    rtc_snapshot.magic = 0;
+    return ESP_ERR_TIMEOUT;
+  }
+
+  ui_state_capture();
+  bsp_display_unlock();
+  return ESP_OK;
+}
+
+esp_err_t ui_state_init(lv_obj_t *tileview)
+{
+  s_tileview = tileview;
+
+  const sleep_manager_hook_t hook = {
+      .name = "ui_state",
+      .priority = SLEEP_HOOK_PRIORITY_EARLY,
+      .prepare = ui_state_sleep_prepare,
+  };
+  return sleep_manager_register_hook(&hook);
+}
+
+bool ui_state_restore(void)
+{
+  if (!snapshot_valid(&rtc_snapshot))
+  {
+    ESP_LOGI(TAG, "No valid UI state snapshot");
+    rtc_snapshot.magic = 0;
+    return false;
+  }
+
+  // Use the snapshot once
+  ui_state_snapshot_t snap = rtc_snapshot;
+  rtc_snapshot.magic = 0;
+
+  if (s_tileview)
+  {
+    lv_tileview_set_tile_by_index(s_tileview, snap.tile_col, snap.tile_row,
+                                  LV_ANIM_OFF);
+  }
+
+  settings_set_menu_scroll(snap.menu_scroll_y);
+  settings_set_selected_item(snap.menu_selected);
+
+  // Rebuild the screen stack without transition animations
+  screen_manager_set_animations_enabled(false);
+  int restored = 0;
+  for (int i = 0; i < snap.depth; i++)
+  {
+    if (settings_open_screen((settings_screen_id_t)snap.screen_ids[i]) !=
+        ESP_OK)
+    {
+      ESP_LOGW(TAG, "Cannot restore screen id %d", snap.screen_ids[i]);
+      break;
+    }
+
+    restore_scroll(screen_manager_get_current(), snap.scroll_child[i],
+                   snap.scroll_y[i]);
+    restored++;
+  }
+  screen_manager_set_animations_enabled(true);
+
+  ESP_LOGI(TAG, "UI state restored: tile (%d,%d), %d/%d screen(s)",
+           snap.tile_col, snap.tile_row, restored, snap.depth);
+  return true;
+}
+
+#endif // CONFIG_APP_STATE_RESTORE_ENABLE
@@ -0,0 +1,60 @@
+/**
+ * @file ui_state.h
+ * @brief UI navigation state snapshot kept in RTC memory across deep sleep
+ *
+ * Captures the active tile, the screen_manager stack (screen ids), per-screen
+ * scroll offsets and the selected settings menu item into RTC_DATA_ATTR
+ * memory when the device enters deep sleep, and rebuilds it on the next
+ * boot. No flash writes are involved.
+ */
+
+#ifndef UI_STATE_H
+#define UI_STATE_H
+
+#include "esp_err.h"
+#include "lvgl.h"
+#include "sdkconfig.h"
+#include <stdbool.h>
+
+#ifdef __cplusplus
+extern "C"
+{
+#endif
+
+#ifdef CONFIG_APP_STATE_RESTORE_ENABLE
+
+  /**
+   * @brief Register the deep sleep hook that captures the snapshot
+   *
+   * @param tileview Main tileview (watchface / settings tiles)
+   * @return ESP_OK on success
+   */
+  esp_err_t ui_state_init(lv_obj_t *tileview);
+
+  /**
+   * @brief Restore the snapshot after waking from deep sleep
+   *
+   * Call with the display lock held, after the root screen has been
+   * registered with screen_manager. The snapshot is invalidated once used
+   * so a later reset does not restore stale state.
+   *
+   * @return true if a valid snapshot was restored
+   */
+  bool ui_state_restore(void);
+
+#else
+
+static inline esp_err_t ui_state_init(lv_obj_t *tileview)
+{
+  (void)tileview;
+  return ESP_OK;
+}
+static inline bool ui_state_restore(void) { return false; }
+
+#endif // CONFIG_APP_STATE_RESTORE_ENABLE
+
+#ifdef __cplusplus
+}
+#endif
+
+#endif // UI_STATE_H
@@ -0,0 +1,135 @@
+#!/usr/bin/env python3
+"""Write ota_fixtures.h for test_ota_pack.c.
+
+Packs two synthetic app images with tools/ota_pack.py, so the host test
+decodes exactly what the packer emits:
+
+    fx_base       image the watch is running
+    fx_image      next release: moved, patched, new and dropped code
+    fx_full       fx_image, heatshrink only, 256-byte window
+    fx_delta      fx_image against fx_base, then heatshrink
+    fx_delta_raw  the same ops without compression
+
+    gen_ota_fixtures.py <output.h>
+"""
+
+import os
+import random
+import struct
+import sys
+
+sys.path.insert(0, os.path.join(os.path.dirname(__file__), "..", "..",
+                                "tools"))
+import ota_pack  # noqa: E402
+
+FRAME_SIZE = 4096
+IMAGE_SIZE = 5 * FRAME_SIZE + 1500  # Short last frame
+
+
+def code(rng, size):
+    """Bytes that compress like firmware: a small opcode set, varied operands."""
+    words = [rng.getrandbits(32) & 0xFFFFF07F for _ in range(16)]
+    out = bytearray()
+    while len(out) < size:
+        w = rng.choice(words)
+        if rng.random() < 0.15:
+            w |= rng.getrandbits(12) << 20
+        out += struct.pack("<I", w)
+    return out[:size]
+
+
+def app(rng, body, sha_seed):
+    header = bytearray(ota_pack.APP_ELF_SHA256_OFFSET + 32)
+    header[0] = ota_pack.IMAGE_MAGIC
+    sha = random.Random(sha_seed).randbytes(32)
+    header[ota_pack.APP_ELF_SHA256_OFFSET:] = sha
+    return bytes(header + body)
+
+
+def relocate(chunk, delta):
+    """Shift every call target in chunk, as a linker does after a move."""
+    out = bytearray(chunk)
+    for k in range(0, len(out) - 3, 16):
+        (w,) = struct.unpack_from("<I", out, k)
+        struct.pack_into("<I", out, k, (w + delta) & 0xFFFFFFFF)
+    return bytes(out)
+
+
+def images():
+    rng = random.Random(20241016)
+    body = code(rng, IMAGE_SIZE + 2000)
+    base = app(rng, body, 1)[:IMAGE_SIZE + 800]
+
+    b = base[ota_pack.APP_ELF_SHA256_OFFSET + 32:]
+    new = bytearray()
+    new += b[:6000]                           # Unchanged: COPY
+    new += rng.randbytes(700)                 # New function: INSERT
+    new += relocate(b[6000:11000], 0x40 << 20)  # Moved: ADD of small diffs
+    new += b[12000:16000]                     # 1000 bytes dropped
+    new += code(rng, 900)                     # New, but compressible
+    new += b[16000:]
+    image = app(rng, bytes(new), 2)
+    return base, image[:IMAGE_SIZE]
+
+
+def op_codes(frames):
+    seen = set()
+    for body in frames:
+        i = 0
+        while i < len(body):
+            op = body[i]
+            seen.add(op)
+            i += 1
+            values = []
+            for _ in range(1 if op == ota_pack.OP_INSERT else 2):
+                value = shift = 0
+                while True:
+                    byte = body[i]
+                    i += 1
+                    value |= (byte & 0x7F) << shift
+                    shift += 7
+                    if not byte & 0x80:
+                        break
+                values.append(value)
+            if op != ota_pack.OP_COPY:
+                i += values[-1]
+    return seen
+
+
+def c_array(name, data):
+    lines = [f"static const uint8_t {name}[{len(data)}] = {{"]
+    for k in range(0, len(data), 16):
+        lines.append("    " + ", ".join(f"0x{c:02X}" for c in
+                                         data[k:k + 16]) + ",")
+    lines.append("};")
+    return "\n".join(lines)
+
+
+def main():
+    base, image = images()
+    full = ota_pack.pack_checked(image, window_bits=8, lookahead_bits=4,
+                                 frame_size=FRAME_SIZE)
+    delta = ota_pack.pack_checked(image, base, frame_size=FRAME_SIZE)
+    delta_raw = ota_pack.pack_checked(image, base, compress=False,
+                                      frame_size=FRAME_SIZE)
+
+    # The fixtures are only worth having if they exercise what they claim
+    seen = op_codes(ota_pack.delta_frames(base, image, FRAME_SIZE))
+    if seen != {ota_pack.OP_COPY, ota_pack.OP_ADD, ota_pack.OP_INSERT}:
+        raise SystemExit(f"delta uses ops {sorted(seen)}, want all three")
+    if len(full) > len(image) * 3 // 4 or len(delta) >= len(delta_raw):
+        raise SystemExit("fixtures compress too little to hold back-refs")
+
+    with open(sys.argv[1], "w") as f:
+        f.write("// Generated by gen_ota_fixtures.py, do not edit\n\n"
+                "#include <stdint.h>\n\n")
+        f.write(f"#define FX_FRAME_SIZE {FRAME_SIZE}\n\n")
+        for name, data in (("fx_base", base), ("fx_image", image),
+                           ("fx_full", full), ("fx_delta", delta),
+                           ("fx_delta_raw", delta_raw)):
+            f.write(c_array(name, data) + "\n\n")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,80 @@
+/**
+ * @file esp_http_client.h
+ * @brief Host stand-in for esp_http_client, backed by a scripted server
+ *
+ * Only what net_http uses. The "server" answers from routes the test sets
+ * up and counts connects, so keep-alive, redirects and stale connections
+ * can be checked without a network. See mock_http.h for the controls.
+ */
+
+#ifndef ESP_HTTP_CLIENT_H
+#define ESP_HTTP_CLIENT_H
+
+#include "esp_err.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+typedef struct esp_http_client *esp_http_client_handle_t;
+
+typedef enum
+{
+  HTTP_EVENT_ERROR = 0,
+  HTTP_EVENT_ON_CONNECTED,
+  HTTP_EVENT_HEADERS_SENT,
+  HTTP_EVENT_ON_HEADER,
+  HTTP_EVENT_ON_DATA,
+  HTTP_EVENT_ON_FINISH,
+  HTTP_EVENT_DISCONNECTED,
+  HTTP_EVENT_REDIRECT,
+} esp_http_client_event_id_t;
+
+typedef struct
+{
+  esp_http_client_event_id_t event_id;
+  esp_http_client_handle_t client;
+  void *data;
+  int data_len;
+  void *user_data;
+  char *header_key;
+  char *header_value;
+} esp_http_client_event_t;
+
+typedef esp_err_t (*http_event_handle_cb)(esp_http_client_event_t *evt);
+
+typedef struct
+{
+  const char *url;
+  http_event_handle_cb event_handler;
+  void *user_data;
+  int timeout_ms;
+  int buffer_size;
+  int buffer_size_tx;
+  bool keep_alive_enable;
+  bool disable_auto_redirect;
+  bool save_client_session;
+} esp_http_client_config_t;
+
+esp_http_client_handle_t
+esp_http_client_init(const esp_http_client_config_t *config);
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client);
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client,
+                                  const char *url);
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client,
+                                     const char *key, const char *value);
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client,
+                                        const char *key);
+esp_err_t esp_http_client_set_timeout_ms(esp_http_client_handle_t client,
+                                         int timeout_ms);
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len);
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client);
+int esp_http_client_get_status_code(esp_http_client_handle_t client);
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer,
+                         int len);
+esp_err_t esp_http_client_flush_response(esp_http_client_handle_t client,
+                                         int *len);
+bool esp_http_client_is_complete_data_received(
+    esp_http_client_handle_t client);
+esp_err_t esp_http_client_set_redirection(esp_http_client_handle_t client);
+esp_err_t esp_http_client_close(esp_http_client_handle_t client);
+
+#endif // ESP_HTTP_CLIENT_H
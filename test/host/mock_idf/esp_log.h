@@ -0,0 +1,21 @@
+/**
+ * @file esp_log.h
+ * @brief Host stand-in: log calls are format-checked and dropped
+ */
+
+#ifndef ESP_LOG_H
+#define ESP_LOG_H
+
+__attribute__((format(printf, 2, 3))) static inline void
+mock_log(const char *tag, const char *fmt, ...)
+{
+  (void)tag;
+  (void)fmt;
+}
+
+#define ESP_LOGE(tag, fmt, ...) mock_log(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGW(tag, fmt, ...) mock_log(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGI(tag, fmt, ...) mock_log(tag, fmt, ##__VA_ARGS__)
+#define ESP_LOGD(tag, fmt, ...) mock_log(tag, fmt, ##__VA_ARGS__)
+
+#endif // ESP_LOG_H
@@ -0,0 +1,18 @@
+/**
+ * @file esp_timer.h
+ * @brief Host stand-in: a clock the test moves by hand
+ */
+
+#ifndef ESP_TIMER_H
+#define ESP_TIMER_H
+
+#include <stdint.h>
+
+extern int64_t mock_time_us;
+
+static inline int64_t esp_timer_get_time(void)
+{
+  return mock_time_us;
+}
+
+#endif // ESP_TIMER_H
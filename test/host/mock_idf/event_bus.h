@@ -0,0 +1,9 @@
+/**
+ * @file event_bus.h
+ * @brief Host stand-in: nothing is subscribed without CONFIG_ENABLE_WIFI
+ */
+
+#ifndef EVENT_BUS_H
+#define EVENT_BUS_H
+
+#endif // EVENT_BUS_H
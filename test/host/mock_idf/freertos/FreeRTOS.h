@@ -0,0 +1,22 @@
+/**
+ * @file FreeRTOS.h
+ * @brief Host stand-in for single-threaded tests: locks are no-ops
+ */
+
+#ifndef FREERTOS_H
+#define FREERTOS_H
+
+#include <stdint.h>
+
+typedef uint32_t TickType_t;
+typedef int BaseType_t;
+typedef int portMUX_TYPE;
+
+#define pdTRUE 1
+#define pdFALSE 0
+#define portMAX_DELAY ((TickType_t)0xFFFFFFFF)
+#define portMUX_INITIALIZER_UNLOCKED 0
+#define portENTER_CRITICAL(mux) ((void)(mux))
+#define portEXIT_CRITICAL(mux) ((void)(mux))
+
+#endif // FREERTOS_H
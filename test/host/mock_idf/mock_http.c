@@ -0,0 +1,352 @@
+/**
+ * @file mock_http.c
+ * @brief Scripted esp_http_client for the host tests
+ */
+
+#include "mock_http.h"
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <strings.h>
+
+#define MAX_ROUTES 16
+#define MAX_CLIENTS 8
+#define MAX_HEADERS 8
+#define URL_LEN 128
+
+typedef struct
+{
+  char url[URL_LEN];
+  int status;
+  char location[URL_LEN];
+  int body_len;
+  bool conn_close;
+} route_t;
+
+struct esp_http_client
+{
+  esp_http_client_config_t config;
+  char url[URL_LEN];
+  char keys[MAX_HEADERS][32];
+  char values[MAX_HEADERS][64];
+  bool connected;
+  bool dead; ///< Server closed the connection without us noticing
+  int status;
+  int body_left;
+  char location[URL_LEN];
+};
+
+int64_t mock_time_us;
+mock_http_log_t mock_http;
+
+static route_t routes[MAX_ROUTES];
+static int route_count;
+static char refused[4][URL_LEN];
+static esp_http_client_handle_t clients[MAX_CLIENTS];
+
+static void origin_of(const char *url, char *out)
+{
+  const char *sep = strstr(url, "://");
+  size_t len = sep ? (size_t)(sep + 3 - url) + strcspn(sep + 3, "/?#")
+                   : strlen(url);
+  len = len < URL_LEN - 1 ? len : URL_LEN - 1;
+  memcpy(out, url, len);
+  out[len] = '\0';
+}
+
+static bool same_origin(const char *url, const char *origin)
+{
+  char o[URL_LEN];
+  origin_of(url, o);
+  return strcasecmp(o, origin) == 0;
+}
+
+static void copy(char *dst, const char *src, size_t size)
+{
+  snprintf(dst, size, "%s", src ? src : "");
+}
+
+static void emit(esp_http_client_handle_t c, esp_http_client_event_id_t id,
+                 const char *key, const char *value)
+{
+  if (!c->config.event_handler)
+  {
+    return;
+  }
+  esp_http_client_event_t evt = {
+      .event_id = id,
+      .client = c,
+      .user_data = c->config.user_data,
+      .header_key = (char *)key,
+      .header_value = (char *)value,
+  };
+  c->config.event_handler(&evt);
+}
+
+void mock_http_reset(void)
+{
+  route_count = 0;
+  memset(refused, 0, sizeof(refused));
+  memset(&mock_http, 0, sizeof(mock_http));
+}
+
+void mock_http_route(const char *url, int status, const char *location,
+                     int body_len, bool conn_close)
+{
+  route_t *r = &routes[route_count++];
+  copy(r->url, url, sizeof(r->url));
+  r->status = status;
+  copy(r->location, location, sizeof(r->location));
+  r->body_len = body_len;
+  r->conn_close = conn_close;
+}
+
+void mock_http_drop_idle(const char *origin)
+{
+  for (int i = 0; i < MAX_CLIENTS; i++)
+  {
+    if (clients[i] && clients[i]->connected &&
+        same_origin(clients[i]->url, origin))
+    {
+      clients[i]->dead = true;
+    }
+  }
+}
+
+void mock_http_refuse(const char *origin, bool refuse)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    if (refuse ? refused[i][0] == '\0' : strcmp(refused[i], origin) == 0)
+    {
+      copy(refused[i], refuse ? origin : "", sizeof(refused[i]));
+      return;
+    }
+  }
+}
+
+bool mock_http_connected(const char *origin)
+{
+  for (int i = 0; i < MAX_CLIENTS; i++)
+  {
+    if (clients[i] && clients[i]->connected && !clients[i]->dead &&
+        same_origin(clients[i]->url, origin))
+    {
+      return true;
+    }
+  }
+  return false;
+}
+
+esp_http_client_handle_t
+esp_http_client_init(const esp_http_client_config_t *config)
+{
+  for (int i = 0; i < MAX_CLIENTS; i++)
+  {
+    if (!clients[i])
+    {
+      esp_http_client_handle_t c = calloc(1, sizeof(*c));
+      c->config = *config;
+      copy(c->url, config->url, sizeof(c->url));
+      clients[i] = c;
+      mock_http.inits++;
+      return c;
+    }
+  }
+  return NULL;
+}
+
+esp_err_t esp_http_client_cleanup(esp_http_client_handle_t client)
+{
+  esp_http_client_close(client);
+  for (int i = 0; i < MAX_CLIENTS; i++)
+  {
+    if (clients[i] == client)
+    {
+      clients[i] = NULL;
+    }
+  }
+  free(client);
+  mock_http.cleanups++;
+  return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_url(esp_http_client_handle_t client,
+                                  const char *url)
+{
+  char origin[URL_LEN];
+  origin_of(client->url, origin);
+  if (!same_origin(url, origin))
+  {
+    // As the real client: another host needs another connection
+    esp_http_client_close(client);
+  }
+  copy(client->url, url, sizeof(client->url));
+  return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_header(esp_http_client_handle_t client,
+                                     const char *key, const char *value)
+{
+  int free_slot = -1;
+  for (int i = 0; i < MAX_HEADERS; i++)
+  {
+    if (strcasecmp(client->keys[i], key) == 0)
+    {
+      free_slot = i;
+      break;
+    }
+    if (client->keys[i][0] == '\0' && free_slot < 0)
+    {
+      free_slot = i;
+    }
+  }
+  if (free_slot < 0)
+  {
+    return ESP_ERR_NO_MEM;
+  }
+  copy(client->keys[free_slot], key, sizeof(client->keys[0]));
+  copy(client->values[free_slot], value, sizeof(client->values[0]));
+  return ESP_OK;
+}
+
+esp_err_t esp_http_client_delete_header(esp_http_client_handle_t client,
+                                        const char *key)
+{
+  for (int i = 0; i < MAX_HEADERS; i++)
+  {
+    if (client->keys[i][0] != '\0' && strcasecmp(client->keys[i], key) == 0)
+    {
+      client->keys[i][0] = '\0';
+    }
+  }
+  return ESP_OK;
+}
+
+esp_err_t esp_http_client_set_timeout_ms(esp_http_client_handle_t client,
+                                         int timeout_ms)
+{
+  client->config.timeout_ms = timeout_ms;
+  return ESP_OK;
+}
+
+static const char *header_value(esp_http_client_handle_t client,
+                                const char *key)
+{
+  for (int i = 0; i < MAX_HEADERS; i++)
+  {
+    if (client->keys[i][0] != '\0' && strcasecmp(client->keys[i], key) == 0)
+    {
+      return client->values[i];
+    }
+  }
+  return "";
+}
+
+esp_err_t esp_http_client_open(esp_http_client_handle_t client, int write_len)
+{
+  (void)write_len;
+  mock_http.opens++;
+
+  if (client->connected && client->dead)
+  {
+    // Writing the request hits the reset
+    client->connected = false;
+    client->dead = false;
+    return ESP_FAIL;
+  }
+  if (!client->connected)
+  {
+    for (int i = 0; i < 4; i++)
+    {
+      if (refused[i][0] != '\0' && same_origin(client->url, refused[i]))
+      {
+        return ESP_FAIL;
+      }
+    }
+    client->connected = true;
+    mock_http.connects++;
+    mock_time_us += 50000; // Connect time shows up in the stats
+    emit(client, HTTP_EVENT_ON_CONNECTED, NULL, NULL);
+  }
+
+  if (mock_http.count < MOCK_HTTP_MAX_REQUESTS)
+  {
+    mock_http_request_t *r = &mock_http.requests[mock_http.count];
+    r->client = client;
+    copy(r->url, client->url, sizeof(r->url));
+    copy(r->range, header_value(client, "Range"), sizeof(r->range));
+  }
+  mock_http.count++;
+  return ESP_OK;
+}
+
+int64_t esp_http_client_fetch_headers(esp_http_client_handle_t client)
+{
+  const route_t *route = NULL;
+  for (int i = 0; i < route_count; i++)
+  {
+    if (strcmp(routes[i].url, client->url) == 0)
+    {
+      route = &routes[i];
+      break;
+    }
+  }
+
+  client->status = route ? route->status : 404;
+  client->body_left = route ? route->body_len : 0;
+  copy(client->location, route ? route->location : "",
+       sizeof(client->location));
+  if (client->location[0] != '\0')
+  {
+    emit(client, HTTP_EVENT_ON_HEADER, "Location", client->location);
+  }
+  if (route && route->conn_close)
+  {
+    emit(client, HTTP_EVENT_ON_HEADER, "Connection", "close");
+  }
+  return client->body_left;
+}
+
+int esp_http_client_get_status_code(esp_http_client_handle_t client)
+{
+  return client->status;
+}
+
+int esp_http_client_read(esp_http_client_handle_t client, char *buffer,
+                         int len)
+{
+  int n = len < client->body_left ? len : client->body_left;
+  memset(buffer, 'x', (size_t)n);
+  client->body_left -= n;
+  return n;
+}
+
+esp_err_t esp_http_client_flush_response(esp_http_client_handle_t client,
+                                         int *len)
+{
+  if (len)
+  {
+    *len = client->body_left;
+  }
+  client->body_left = 0;
+  return ESP_OK;
+}
+
+bool esp_http_client_is_complete_data_received(
+    esp_http_client_handle_t client)
+{
+  return client->body_left == 0;
+}
+
+esp_err_t esp_http_client_set_redirection(esp_http_client_handle_t client)
+{
+  return esp_http_client_set_url(client, client->location);
+}
+
+esp_err_t esp_http_client_close(esp_http_client_handle_t client)
+{
+  client->connected = false;
+  client->dead = false;
+  return ESP_OK;
+}
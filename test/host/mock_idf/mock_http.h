@@ -0,0 +1,53 @@
+/**
+ * @file mock_http.h
+ * @brief Controls and counters of the scripted esp_http_client server
+ */
+
+#ifndef MOCK_HTTP_H
+#define MOCK_HTTP_H
+
+#include "esp_http_client.h"
+#include <stdbool.h>
+#include <stdint.h>
+
+#define MOCK_HTTP_MAX_REQUESTS 32
+
+typedef struct
+{
+  esp_http_client_handle_t client;
+  char url[128];
+  char range[32]; ///< Range header sent with it, "" if none
+} mock_http_request_t;
+
+typedef struct
+{
+  uint32_t inits;    ///< Clients created
+  uint32_t cleanups; ///< Clients destroyed
+  uint32_t connects; ///< New connections made
+  uint32_t opens;    ///< esp_http_client_open() calls, failed ones too
+  uint32_t count;    ///< Requests the server saw
+  mock_http_request_t requests[MOCK_HTTP_MAX_REQUESTS];
+} mock_http_log_t;
+
+extern mock_http_log_t mock_http;
+
+/* Forget routes, server faults and the log; clients stay */
+void mock_http_reset(void);
+
+/*
+ * Answer GETs of url with status and a body_len byte body. location is
+ * sent as the Location header if not NULL.
+ */
+void mock_http_route(const char *url, int status, const char *location,
+                     int body_len, bool conn_close);
+
+/* The server times out the open connections to an origin */
+void mock_http_drop_idle(const char *origin);
+
+/* New connections to an origin fail (or succeed again) */
+void mock_http_refuse(const char *origin, bool refuse);
+
+/* Whether any client has a live connection to origin */
+bool mock_http_connected(const char *origin);
+
+#endif // MOCK_HTTP_H
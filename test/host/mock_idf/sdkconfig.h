@@ -0,0 +1,14 @@
+/**
+ * @file sdkconfig.h
+ * @brief Host stand-in: Kconfig defaults of the modules under test
+ */
+
+#ifndef SDKCONFIG_H
+#define SDKCONFIG_H
+
+#define CONFIG_NET_HTTP_MAX_HOSTS 3
+#define CONFIG_NET_HTTP_KEEPALIVE_S 30
+#define CONFIG_NET_HTTP_TIMEOUT_MS 10000
+#define CONFIG_NET_HTTP_BUFFER_SIZE 2048
+
+#endif // SDKCONFIG_H
@@ -0,0 +1,293 @@
+/**
+ * @file test_ble_sync_codec.c
+ * @brief ble_sync_codec: Current Time, Local Time Information, notifications
+ */
+
+#include "ble_sync_codec.h"
+#include "test_host.h"
+#include <string.h>
+
+#define US 1000000LL
+
+// 2024-10-16 00:00:00 UTC, a Wednesday
+#define DAY_2024_10_16 1729036800LL
+
+static void test_time_decode(void)
+{
+  // 2024-10-16 18:00:00, Wednesday, manual adjust (docs/POWER_LIFECYCLE.md)
+  const uint8_t buf[] = {0xE8, 0x07, 0x0A, 0x10, 0x12,
+                         0x00, 0x00, 0x03, 0x00, 0x01};
+  ble_sync_time_t t;
+  CHECK(ble_sync_decode_time(buf, sizeof(buf), &t));
+  CHECK_EQ(t.year, 2024);
+  CHECK_EQ(t.month, 10);
+  CHECK_EQ(t.day, 16);
+  CHECK_EQ(t.hours, 18);
+  CHECK_EQ(t.minutes, 0);
+  CHECK_EQ(t.seconds, 0);
+  CHECK_EQ(t.day_of_week, 3);
+  CHECK_EQ(t.adjust_reason, BLE_SYNC_ADJUST_MANUAL);
+
+  uint8_t out[BLE_SYNC_TIME_LEN + 2];
+  CHECK_EQ(ble_sync_encode_time(&t, out, sizeof(out)), BLE_SYNC_TIME_LEN);
+  CHECK(memcmp(out, buf, sizeof(buf)) == 0);
+  CHECK_EQ(ble_sync_encode_time(&t, out, BLE_SYNC_TIME_LEN - 1), 0);
+}
+
+static void test_time_rejects(void)
+{
+  const uint8_t good[] = {0xE8, 0x07, 0x02, 0x1D, 0x17,
+                          0x3B, 0x3B, 0x04, 0xFF, 0x00};
+  ble_sync_time_t t;
+  CHECK(ble_sync_decode_time(good, sizeof(good), &t)); // 2024-02-29 23:59:59
+
+  // Wrong lengths: a write is one whole value
+  CHECK(!ble_sync_decode_time(good, 0, &t));
+  CHECK(!ble_sync_decode_time(good, BLE_SYNC_TIME_LEN - 1, &t));
+  uint8_t longer[BLE_SYNC_TIME_LEN + 1] = {0};
+  memcpy(longer, good, sizeof(good));
+  CHECK(!ble_sync_decode_time(longer, sizeof(longer), &t));
+
+  // One field at a time out of range
+  static const struct
+  {
+    uint8_t index;
+    uint8_t value;
+  } bad[] = {
+      {1, 0x00}, // Year 232
+      {2, 0},    {2, 13}, // Month
+      {3, 0},    {3, 30}, // Day, and Feb 30
+      {4, 24},   {5, 60},  {6, 60}, // Time
+      {7, 8},                        // Day of week
+  };
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+  {
+    uint8_t buf[BLE_SYNC_TIME_LEN];
+    memcpy(buf, good, sizeof(buf));
+    buf[bad[i].index] = bad[i].value;
+    CHECK(!ble_sync_decode_time(buf, sizeof(buf), &t));
+  }
+
+  // Feb 29 only in leap years
+  uint8_t buf[BLE_SYNC_TIME_LEN];
+  memcpy(buf, good, sizeof(buf));
+  buf[0] = 0xE7; // 2023
+  CHECK(!ble_sync_decode_time(buf, sizeof(buf), &t));
+  buf[0] = 0xD0; // 2000, divisible by 400
+  CHECK(ble_sync_decode_time(buf, sizeof(buf), &t));
+}
+
+static void test_local_info(void)
+{
+  // UTC-05:00 plus one hour of DST
+  const uint8_t buf[] = {(uint8_t)-20, 4};
+  ble_sync_local_info_t info;
+  CHECK(ble_sync_decode_local_info(buf, sizeof(buf), &info));
+  CHECK_EQ(info.tz_quarters, -20);
+  CHECK_EQ(info.dst_quarters, 4);
+  CHECK_EQ(ble_sync_local_offset_s(&info), -4 * 3600);
+
+  uint8_t out[BLE_SYNC_LOCAL_INFO_LEN];
+  CHECK_EQ(ble_sync_encode_local_info(&info, out, sizeof(out)),
+           BLE_SYNC_LOCAL_INFO_LEN);
+  CHECK(memcmp(out, buf, sizeof(buf)) == 0);
+  CHECK_EQ(ble_sync_encode_local_info(&info, out, 1), 0);
+
+  // Unknown parts count as zero
+  const uint8_t unknown[] = {(uint8_t)BLE_SYNC_TZ_UNKNOWN,
+                             BLE_SYNC_DST_UNKNOWN};
+  CHECK(ble_sync_decode_local_info(unknown, sizeof(unknown), &info));
+  CHECK_EQ(ble_sync_local_offset_s(&info), 0);
+  const uint8_t tz_only[] = {23, BLE_SYNC_DST_UNKNOWN}; // India, +05:45
+  CHECK(ble_sync_decode_local_info(tz_only, sizeof(tz_only), &info));
+  CHECK_EQ(ble_sync_local_offset_s(&info), 23 * 900);
+
+  // Lengths, offsets past UTC-12/+14, DST that is not 0, 0.5, 1 or 2 h
+  CHECK(!ble_sync_decode_local_info(buf, 1, &info));
+  const uint8_t three[] = {0, 0, 0};
+  CHECK(!ble_sync_decode_local_info(three, sizeof(three), &info));
+  const uint8_t edges[][2] = {{(uint8_t)-48, 0}, {56, 0}};
+  const uint8_t bad[][2] = {{(uint8_t)-49, 0}, {57, 0}, {0, 3}, {0, 16}};
+  for (size_t i = 0; i < sizeof(edges) / sizeof(edges[0]); i++)
+  {
+    CHECK(ble_sync_decode_local_info(edges[i], 2, &info));
+  }
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+  {
+    CHECK(!ble_sync_decode_local_info(bad[i], 2, &info));
+  }
+}
+
+static void check_round_trip(int64_t utc_us, int32_t offset_s)
+{
+  ble_sync_time_t t;
+  ble_sync_time_from_utc_us(utc_us, offset_s, BLE_SYNC_ADJUST_EXTERNAL, &t);
+  uint8_t buf[BLE_SYNC_TIME_LEN];
+  ble_sync_encode_time(&t, buf, sizeof(buf));
+  ble_sync_time_t back;
+  CHECK(ble_sync_decode_time(buf, sizeof(buf), &back));
+  int64_t err = ble_sync_time_to_utc_us(&back, offset_s) - utc_us;
+  CHECK(err >= -US / 256 && err <= US / 256); // Within a 1/256 s step
+}
+
+static void test_utc_conversion(void)
+{
+  // 18:00 at UTC+03:00 is 15:00 UTC; fractions are 1/256 s
+  ble_sync_time_t t = {.year = 2024, .month = 10, .day = 16, .hours = 18,
+                       .fractions256 = 128};
+  CHECK_EQ(ble_sync_time_to_utc_us(&t, 3 * 3600),
+           (DAY_2024_10_16 + 15 * 3600) * US + US / 2);
+
+  // Back to local wall time, across midnight and the year boundary
+  ble_sync_time_from_utc_us((DAY_2024_10_16 + 22 * 3600) * US, 3 * 3600, 0,
+                            &t);
+  CHECK_EQ(t.day, 17);
+  CHECK_EQ(t.hours, 1);
+  CHECK_EQ(t.day_of_week, 4); // Thursday
+
+  // 2025-01-01 00:30 UTC seen from UTC-01:00
+  ble_sync_time_from_utc_us(1735691400LL * US, -3600, 0, &t);
+  CHECK_EQ(t.year, 2024);
+  CHECK_EQ(t.month, 12);
+  CHECK_EQ(t.day, 31);
+  CHECK_EQ(t.hours, 23);
+  CHECK_EQ(t.minutes, 30);
+  CHECK_EQ(t.day_of_week, 2); // Tuesday
+
+  // Just before the epoch: floors, not truncates
+  ble_sync_time_from_utc_us(-1, 0, 0, &t);
+  CHECK_EQ(t.year, 1969);
+  CHECK_EQ(t.day, 31);
+  CHECK_EQ(t.seconds, 59);
+  CHECK_EQ(t.fractions256, 255);
+  CHECK_EQ(t.day_of_week, 3); // Wednesday
+
+  check_round_trip(DAY_2024_10_16 * US, 0);
+  check_round_trip(DAY_2024_10_16 * US + 123457, -20 * 900);
+  check_round_trip(1709251199LL * US + 999999, 56 * 900); // Feb 29, 2024
+  check_round_trip(4102444800LL * US - 1, -48 * 900);    // End of 2099
+}
+
+static void test_notif_decode(void)
+{
+  const uint8_t buf[] = {BLE_SYNC_NOTIF_POST, BLE_SYNC_CATEGORY_EMAIL, 0x34,
+                         0x12, 4, 'M', 'a', 'i', 'l', 'H', 'e', 'l', 'l', 'o'};
+  ble_sync_notif_t n;
+  CHECK(ble_sync_decode_notif(buf, sizeof(buf), &n));
+  CHECK_EQ(n.op, BLE_SYNC_NOTIF_POST);
+  CHECK_EQ(n.category, BLE_SYNC_CATEGORY_EMAIL);
+  CHECK_EQ(n.id, 0x1234);
+  CHECK(strcmp(n.title, "Mail") == 0);
+  CHECK(strcmp(n.body, "Hello") == 0);
+
+  // Remove and clear carry the header only
+  const uint8_t remove[] = {BLE_SYNC_NOTIF_REMOVE, 0, 0x34, 0x12, 0};
+  CHECK(ble_sync_decode_notif(remove, sizeof(remove), &n));
+  CHECK_EQ(n.op, BLE_SYNC_NOTIF_REMOVE);
+  CHECK_EQ(n.id, 0x1234);
+  CHECK_EQ(n.title[0], '\0');
+  CHECK_EQ(n.body[0], '\0');
+
+  // Shorter than the header, unknown op
+  CHECK(!ble_sync_decode_notif(buf, BLE_SYNC_NOTIF_HEADER_LEN - 1, &n));
+  CHECK(!ble_sync_decode_notif(buf, 0, &n));
+  uint8_t bad[sizeof(buf)];
+  memcpy(bad, buf, sizeof(buf));
+  bad[0] = BLE_SYNC_NOTIF_CLEAR + 1;
+  CHECK(!ble_sync_decode_notif(bad, sizeof(bad), &n));
+
+  // Unknown category is kept as "other"; a title length past the end
+  // takes what is there
+  memcpy(bad, buf, sizeof(buf));
+  bad[1] = 200;
+  bad[4] = 200;
+  CHECK(ble_sync_decode_notif(bad, sizeof(bad), &n));
+  CHECK_EQ(n.category, BLE_SYNC_CATEGORY_OTHER);
+  CHECK(strcmp(n.title, "MailHello") == 0);
+  CHECK_EQ(n.body[0], '\0');
+}
+
+static void test_notif_truncation(void)
+{
+  // 40-byte title of two-byte characters, 120-byte body
+  uint8_t buf[BLE_SYNC_NOTIF_MAX_LEN];
+  size_t len = 0;
+  buf[len++] = BLE_SYNC_NOTIF_POST;
+  buf[len++] = BLE_SYNC_CATEGORY_SOCIAL;
+  buf[len++] = 1;
+  buf[len++] = 0;
+  buf[len++] = 40;
+  for (int i = 0; i < 20; i++)
+  {
+    buf[len++] = 0xC3; // "é"
+    buf[len++] = 0xA9;
+  }
+  for (int i = 0; i < 120; i++)
+  {
+    buf[len++] = (uint8_t)('a' + i % 26);
+  }
+
+  ble_sync_notif_t n;
+  CHECK(ble_sync_decode_notif(buf, len, &n));
+  // 31 bytes fit, the last character would be split: 15 of them stay
+  CHECK_EQ(strlen(n.title), 30);
+  CHECK(memcmp(n.title, buf + 5, 30) == 0);
+  CHECK_EQ(strlen(n.body), BLE_SYNC_NOTIF_BODY_LEN - 1);
+  CHECK(memcmp(n.body, buf + 45, BLE_SYNC_NOTIF_BODY_LEN - 1) == 0);
+}
+
+static void test_notif_encode(void)
+{
+  ble_sync_notif_t n = {
+      .id = 0xBEEF,
+      .op = BLE_SYNC_NOTIF_POST,
+      .category = BLE_SYNC_CATEGORY_CALL,
+  };
+  strcpy(n.title, "Alice");
+  strcpy(n.body, "Incoming call");
+
+  uint8_t buf[BLE_SYNC_NOTIF_MAX_LEN];
+  size_t len = ble_sync_encode_notif(&n, buf, sizeof(buf));
+  CHECK_EQ(len, BLE_SYNC_NOTIF_HEADER_LEN + 5 + 13);
+  ble_sync_notif_t back;
+  CHECK(ble_sync_decode_notif(buf, len, &back));
+  CHECK_EQ(back.id, 0xBEEF);
+  CHECK_EQ(back.category, BLE_SYNC_CATEGORY_CALL);
+  CHECK(strcmp(back.title, "Alice") == 0);
+  CHECK(strcmp(back.body, "Incoming call") == 0);
+
+  // Too small for the header; then room for three text bytes, which must
+  // not split the "é" of the title
+  CHECK_EQ(ble_sync_encode_notif(&n, buf, BLE_SYNC_NOTIF_HEADER_LEN - 1), 0);
+  strcpy(n.title, "a\xC3\xA9");
+  strcpy(n.body, "xyz");
+  len = ble_sync_encode_notif(&n, buf, BLE_SYNC_NOTIF_HEADER_LEN + 2);
+  CHECK_EQ(len, BLE_SYNC_NOTIF_HEADER_LEN + 2);
+  CHECK(ble_sync_decode_notif(buf, len, &back));
+  CHECK(strcmp(back.title, "a") == 0);
+  CHECK(strcmp(back.body, "x") == 0);
+
+  // Full fields fit one maximum write
+  memset(n.title, 't', sizeof(n.title) - 1);
+  n.title[sizeof(n.title) - 1] = '\0';
+  memset(n.body, 'b', sizeof(n.body) - 1);
+  n.body[sizeof(n.body) - 1] = '\0';
+  len = ble_sync_encode_notif(&n, buf, sizeof(buf));
+  CHECK_EQ(len, BLE_SYNC_NOTIF_HEADER_LEN + BLE_SYNC_NOTIF_TITLE_LEN - 1 +
+                    BLE_SYNC_NOTIF_BODY_LEN - 1);
+  CHECK(ble_sync_decode_notif(buf, len, &back));
+  CHECK(strcmp(back.title, n.title) == 0);
+  CHECK(strcmp(back.body, n.body) == 0);
+}
+
+int main(void)
+{
+  test_time_decode();
+  test_time_rejects();
+  test_local_info();
+  test_utc_conversion();
+  test_notif_decode();
+  test_notif_truncation();
+  test_notif_encode();
+  TEST_DONE();
+}
@@ -0,0 +1,212 @@
+/**
+ * @file test_event_mailbox.c
+ * @brief event_mailbox: state coalescing, message FIFO, overflow, restore
+ */
+
+#include "event_mailbox.h"
+#include "test_host.h"
+#include <string.h>
+
+static event_mailbox_t box;
+static event_batch_t batch;
+static int64_t now_us;
+
+static void put(const event_t *event)
+{
+  now_us += 1000;
+  event_mailbox_put(&box, event, now_us);
+}
+
+static void put_time_sync(uint8_t source)
+{
+  put(&(event_t){
+      .type = EVENT_TIME_SYNC,
+      .time_sync.ok = true,
+      .time_sync.source = source,
+  });
+}
+
+static void put_notification(uint16_t id, uint8_t op)
+{
+  put(&(event_t){
+      .type = EVENT_NOTIFICATION,
+      .notification.id = id,
+      .notification.op = op,
+  });
+}
+
+static void put_wifi(uint8_t state)
+{
+  put(&(event_t){.type = EVENT_WIFI_STATE, .wifi.state = state});
+}
+
+static void reset(void)
+{
+  memset(&box, 0, sizeof(box));
+  now_us = 0;
+}
+
+static void test_masks(void)
+{
+  CHECK(EVENT_MESSAGE_MASK & EVENT_MASK(EVENT_TIME_SYNC));
+  CHECK(EVENT_MESSAGE_MASK & EVENT_MASK(EVENT_NOTIFICATION));
+  CHECK(EVENT_STATE_MASK & EVENT_MASK(EVENT_WIFI_STATE));
+  CHECK(EVENT_STATE_MASK & EVENT_MASK(EVENT_BATTERY));
+  CHECK(EVENT_STATE_MASK & EVENT_MASK(EVENT_OTA_PROGRESS));
+  CHECK_EQ(EVENT_STATE_MASK & EVENT_MESSAGE_MASK, 0);
+  CHECK_EQ(EVENT_STATE_MASK | EVENT_MESSAGE_MASK,
+           EVENT_MASK(EVENT_TYPE_COUNT) - 1);
+}
+
+static void test_ble_then_ntp_sync(void)
+{
+  reset();
+
+  // Same dispatch cycle: neither may hide the other
+  put_time_sync(EVENT_TIME_SYNC_BLE);
+  put_time_sync(EVENT_TIME_SYNC_NTP);
+  CHECK(event_mailbox_pending(&box));
+
+  event_mailbox_take(&box, &batch);
+  CHECK_EQ(batch.count, 2);
+  CHECK_EQ(batch.events[0].type, EVENT_TIME_SYNC);
+  CHECK_EQ(batch.events[0].time_sync.source, EVENT_TIME_SYNC_BLE);
+  CHECK_EQ(batch.events[0].coalesced, 0);
+  CHECK_EQ(batch.events[1].type, EVENT_TIME_SYNC);
+  CHECK_EQ(batch.events[1].time_sync.source, EVENT_TIME_SYNC_NTP);
+  CHECK_EQ(batch.events[1].coalesced, 0);
+  CHECK(!event_mailbox_pending(&box));
+}
+
+static void test_notifications_in_order(void)
+{
+  reset();
+
+  put_notification(7, 0);
+  put_notification(8, 0);
+  put_notification(7, 1);
+  put_notification(0, 2);
+
+  event_mailbox_take(&box, &batch);
+  CHECK_EQ(batch.count, 4);
+  CHECK_EQ(batch.events[0].notification.id, 7);
+  CHECK_EQ(batch.events[0].notification.op, 0);
+  CHECK_EQ(batch.events[1].notification.id, 8);
+  CHECK_EQ(batch.events[2].notification.id, 7);
+  CHECK_EQ(batch.events[2].notification.op, 1);
+  CHECK_EQ(batch.events[3].notification.op, 2);
+}
+
+static void test_state_coalesces(void)
+{
+  reset();
+
+  put_wifi(1);
+  put_time_sync(EVENT_TIME_SYNC_NTP);
+  put_wifi(2);
+  put_wifi(3);
+
+  // Latest WiFi state only, still ordered by publish time
+  event_mailbox_take(&box, &batch);
+  CHECK_EQ(batch.count, 2);
+  CHECK_EQ(batch.events[0].type, EVENT_TIME_SYNC);
+  CHECK_EQ(batch.events[1].type, EVENT_WIFI_STATE);
+  CHECK_EQ(batch.events[1].wifi.state, 3);
+  CHECK_EQ(batch.events[1].coalesced, 2);
+  CHECK_EQ(batch.events[1].time_us, now_us);
+}
+
+static void test_overflow_drops_new(void)
+{
+  reset();
+
+  for (int i = 0; i < EVENT_MAILBOX_MSG_DEPTH; i++)
+  {
+    put_notification((uint16_t)i, 0);
+  }
+  CHECK(!event_mailbox_put(&box,
+                           &(event_t){.type = EVENT_NOTIFICATION,
+                                      .notification.id = 99},
+                           ++now_us));
+  CHECK_EQ(box.dropped, 1);
+
+  // State events never hit the limit
+  put_wifi(1);
+  CHECK_EQ(box.dropped, 1);
+
+  event_mailbox_take(&box, &batch);
+  CHECK_EQ(batch.count, EVENT_MAILBOX_MSG_DEPTH + 1);
+  for (int i = 0; i < EVENT_MAILBOX_MSG_DEPTH; i++)
+  {
+    CHECK_EQ(batch.events[i].notification.id, i);
+  }
+
+  // Room again once taken, wrapping the ring
+  for (int i = 0; i < EVENT_MAILBOX_MSG_DEPTH + 3; i++)
+  {
+    put_notification((uint16_t)(100 + i), 0);
+    if (i % 2)
+    {
+      event_mailbox_take(&box, &batch);
+    }
+  }
+  CHECK_EQ(box.dropped, 1);
+}
+
+static void test_restore(void)
+{
+  reset();
+
+  put_time_sync(EVENT_TIME_SYNC_BLE);
+  put_wifi(1);
+  put_notification(1, 0);
+  event_mailbox_take(&box, &batch);
+  CHECK_EQ(batch.count, 3);
+
+  // Delivery failed; newer events arrive before the retry
+  put_time_sync(EVENT_TIME_SYNC_NTP);
+  put_wifi(2);
+  event_mailbox_restore(&box, &batch);
+
+  event_mailbox_take(&box, &batch);
+  CHECK_EQ(batch.count, 4);
+  CHECK_EQ(batch.events[0].type, EVENT_TIME_SYNC);
+  CHECK_EQ(batch.events[0].time_sync.source, EVENT_TIME_SYNC_BLE);
+  CHECK_EQ(batch.events[1].type, EVENT_NOTIFICATION);
+  CHECK_EQ(batch.events[2].type, EVENT_TIME_SYNC);
+  CHECK_EQ(batch.events[2].time_sync.source, EVENT_TIME_SYNC_NTP);
+  CHECK_EQ(batch.events[3].type, EVENT_WIFI_STATE);
+  CHECK_EQ(batch.events[3].wifi.state, 2);
+  CHECK_EQ(batch.events[3].coalesced, 1);
+
+  // Restoring into a full FIFO keeps the older messages
+  reset();
+  put_notification(1, 0);
+  put_notification(2, 0);
+  event_mailbox_take(&box, &batch);
+  for (int i = 0; i < EVENT_MAILBOX_MSG_DEPTH; i++)
+  {
+    put_notification((uint16_t)(10 + i), 0);
+  }
+  event_mailbox_restore(&box, &batch);
+  CHECK_EQ(box.dropped, 2);
+  event_batch_t again;
+  event_mailbox_take(&box, &again);
+  CHECK_EQ(again.count, EVENT_MAILBOX_MSG_DEPTH);
+  CHECK_EQ(again.events[0].notification.id, 1);
+  CHECK_EQ(again.events[1].notification.id, 2);
+  CHECK_EQ(again.events[2].notification.id, 10);
+  CHECK_EQ(again.events[EVENT_MAILBOX_MSG_DEPTH - 1].notification.id,
+           10 + EVENT_MAILBOX_MSG_DEPTH - 3);
+}
+
+int main(void)
+{
+  test_masks();
+  test_ble_then_ntp_sync();
+  test_notifications_in_order();
+  test_state_coalesces();
+  test_overflow_drops_new();
+  test_restore();
+  TEST_DONE();
+}
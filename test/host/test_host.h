@@ -0,0 +1,53 @@
+/**
+ * @file test_host.h
+ * @brief Minimal assertions for the host tests
+ *
+ * Each test is one executable; a failed CHECK prints where and the run
+ * continues, TEST_DONE() turns the failure count into the exit status.
+ */
+
+#ifndef TEST_HOST_H
+#define TEST_HOST_H
+
+#include <stdio.h>
+#include <stdlib.h>
+
+static int test_failures = 0;
+
+#define CHECK(cond)                                                           \
+  do                                                                          \
+  {                                                                           \
+    if (!(cond))                                                              \
+    {                                                                         \
+      fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__,       \
+              #cond);                                                         \
+      test_failures++;                                                        \
+    }                                                                         \
+  } while (0)
+
+#define CHECK_EQ(a, b)                                                        \
+  do                                                                          \
+  {                                                                           \
+    long long check_a_ = (long long)(a);                                      \
+    long long check_b_ = (long long)(b);                                      \
+    if (check_a_ != check_b_)                                                 \
+    {                                                                         \
+      fprintf(stderr, "%s:%d: %s == %s failed (%lld != %lld)\n", __FILE__,   \
+              __LINE__, #a, #b, check_a_, check_b_);                          \
+      test_failures++;                                                        \
+    }                                                                         \
+  } while (0)
+
+#define TEST_DONE()                                                           \
+  do                                                                          \
+  {                                                                           \
+    if (test_failures)                                                        \
+    {                                                                         \
+      fprintf(stderr, "%d check(s) failed\n", test_failures);                 \
+      return EXIT_FAILURE;                                                    \
+    }                                                                         \
+    printf("ok\n");                                                           \
+    return EXIT_SUCCESS;                                                      \
+  } while (0)
+
+#endif // TEST_HOST_H
@@ -0,0 +1,297 @@
+/**
+ * @file test_net_http.c
+ * @brief net_http: keep-alive reuse, redirects, stale connections, LRU pool
+ *
+ * Runs net_http.c against the scripted esp_http_client in mock_idf/.
+ */
+
+#include "esp_timer.h"
+#include "mock_http.h"
+#include "net_http.h"
+#include "sdkconfig.h"
+#include "test_host.h"
+#include <string.h>
+
+#define SECOND_US 1000000LL
+
+static int hops;
+
+static void count_hops(const char *key, const char *value, void *user_data)
+{
+  (void)value;
+  (void)user_data;
+  if (!key)
+  {
+    hops++;
+  }
+}
+
+/** GET url, optionally read the whole body, close; returns the status */
+static int fetch(const char *url, bool read_body)
+{
+  const net_http_opts_t opts = {.url = url};
+  net_http_req_t req;
+  mock_time_us += SECOND_US;
+  if (net_http_open(&req, &opts) != ESP_OK)
+  {
+    return -1;
+  }
+  char buf[64];
+  while (read_body && esp_http_client_read(req.client, buf, sizeof(buf)) > 0)
+  {
+  }
+  int status = req.status;
+  net_http_close(&req);
+  return status;
+}
+
+static net_http_stats_t stats_now(void)
+{
+  net_http_stats_t s;
+  net_http_get_stats(&s);
+  return s;
+}
+
+static void test_reuse(void)
+{
+  mock_http_reset();
+  mock_http_route("http://a.test/1", 200, NULL, 100, false);
+  mock_http_route("http://a.test/2", 200, NULL, 10, false);
+  mock_http_route("http://a.test/close", 200, NULL, 10, true);
+  net_http_stats_t before = stats_now();
+
+  // Second request to the host rides on the first one's connection
+  CHECK_EQ(fetch("http://a.test/1", true), 200);
+  CHECK_EQ(fetch("http://a.test/2", true), 200);
+  CHECK_EQ(mock_http.connects, 1);
+  CHECK_EQ(mock_http.inits, 1);
+  net_http_stats_t after = stats_now();
+  CHECK_EQ(after.requests - before.requests, 2);
+  CHECK_EQ(after.reused - before.reused, 1);
+  CHECK_EQ(after.connects - before.connects, 1);
+  CHECK_EQ(after.tls_full - before.tls_full, 0); // Plain HTTP
+
+  // Body left unread: the connection is in an unknown state, closed
+  CHECK_EQ(fetch("http://a.test/1", false), 200);
+  CHECK(!mock_http_connected("http://a.test"));
+  CHECK_EQ(fetch("http://a.test/2", true), 200);
+  CHECK_EQ(mock_http.connects, 2);
+
+  // Server asked to close
+  CHECK_EQ(fetch("http://a.test/close", true), 200);
+  CHECK(!mock_http_connected("http://a.test"));
+  CHECK_EQ(fetch("http://a.test/2", true), 200);
+  CHECK_EQ(mock_http.connects, 3);
+
+  // Idle past the keep-alive: closed before the next request, not tried
+  mock_time_us += (CONFIG_NET_HTTP_KEEPALIVE_S + 1) * SECOND_US;
+  uint32_t opens = mock_http.opens;
+  CHECK_EQ(fetch("http://a.test/2", true), 200);
+  CHECK_EQ(mock_http.connects, 4);
+  CHECK_EQ(mock_http.opens - opens, 1);
+
+  // End of the network session
+  net_http_close_idle();
+  CHECK(!mock_http_connected("http://a.test"));
+  CHECK_EQ(mock_http.inits, 1); // One client throughout
+}
+
+static void test_cross_host_redirect(void)
+{
+  mock_http_reset();
+  mock_http_route("https://gh.test/release/fw.bin", 302,
+                  "https://cdn.test/asset/42?sig=abc", 20, false);
+  mock_http_route("https://cdn.test/asset/42?sig=abc", 206, NULL, 1000, false);
+  mock_http_route("https://cdn.test/other", 200, NULL, 5, false);
+  net_http_stats_t before = stats_now();
+
+  net_http_opts_t opts = {
+      .url = "https://gh.test/release/fw.bin",
+      .on_header = count_hops,
+  };
+  opts.headers[0] = (net_http_header_t){"Range", "bytes=4096-"};
+  net_http_req_t req;
+  hops = 0;
+  CHECK_EQ(net_http_open(&req, &opts), ESP_OK);
+  CHECK_EQ(req.status, 206);
+  CHECK_EQ(req.content_length, 1000);
+  CHECK_EQ(hops, 2);
+
+  // Each host got its own client, and the request headers on both hops
+  CHECK_EQ(mock_http.count, 2);
+  CHECK(strcmp(mock_http.requests[0].url, opts.url) == 0);
+  CHECK(strcmp(mock_http.requests[1].url,
+               "https://cdn.test/asset/42?sig=abc") == 0);
+  CHECK(mock_http.requests[0].client != mock_http.requests[1].client);
+  CHECK(req.client == mock_http.requests[1].client);
+  CHECK(strcmp(mock_http.requests[0].range, "bytes=4096-") == 0);
+  CHECK(strcmp(mock_http.requests[1].range, "bytes=4096-") == 0);
+
+  // The redirect body was drained, so the release host stays connected
+  CHECK(mock_http_connected("https://gh.test"));
+  char buf[256];
+  while (esp_http_client_read(req.client, buf, sizeof(buf)) > 0)
+  {
+  }
+  net_http_close(&req);
+  CHECK(mock_http_connected("https://cdn.test"));
+  net_http_stats_t after = stats_now();
+  CHECK_EQ(after.tls_full - before.tls_full, 2);
+
+  // Request headers do not leak into the next request on either host
+  CHECK_EQ(fetch("https://cdn.test/other", true), 200);
+  CHECK_EQ(fetch("https://gh.test/other", true), 404);
+  CHECK_EQ(mock_http.count, 4);
+  CHECK(strcmp(mock_http.requests[2].range, "") == 0);
+  CHECK(strcmp(mock_http.requests[3].range, "") == 0);
+
+  // Same redirect again: both hops reuse their connection
+  uint32_t connects = mock_http.connects;
+  before = stats_now();
+  CHECK_EQ(net_http_open(&req, &opts), ESP_OK);
+  while (esp_http_client_read(req.client, buf, sizeof(buf)) > 0)
+  {
+  }
+  net_http_close(&req);
+  CHECK_EQ(mock_http.connects, connects);
+  CHECK_EQ(stats_now().reused - before.reused, 2);
+
+  // New connections after the session ended offer the TLS tickets
+  net_http_close_idle();
+  before = stats_now();
+  CHECK_EQ(net_http_open(&req, &opts), ESP_OK);
+  net_http_close(&req);
+  after = stats_now();
+  CHECK_EQ(after.tls_ticket - before.tls_ticket, 2);
+  CHECK_EQ(after.tls_full - before.tls_full, 0);
+  CHECK(after.tls_ticket_ms > before.tls_ticket_ms);
+}
+
+static void test_same_host_redirect(void)
+{
+  mock_http_reset();
+  mock_http_route("http://a.test/old", 301, "http://a.test/new", 0, false);
+  mock_http_route("http://a.test/new", 200, NULL, 10, false);
+  mock_http_route("http://loop.test/x", 302, "http://loop.test/x", 0, false);
+  mock_http_route("http://loop.test/ok", 200, NULL, 0, false);
+
+  CHECK_EQ(fetch("http://a.test/old", true), 200);
+  CHECK_EQ(mock_http.count, 2);
+  CHECK(mock_http.requests[0].client == mock_http.requests[1].client);
+  CHECK(mock_http.connects <= 1);
+
+  // A redirect loop ends after MAX_REDIRECTS and frees the client
+  const net_http_opts_t loop = {.url = "http://loop.test/x"};
+  net_http_req_t req;
+  uint32_t count = mock_http.count;
+  CHECK_EQ(net_http_open(&req, &loop), ESP_ERR_INVALID_RESPONSE);
+  CHECK_EQ(mock_http.count - count, 6);
+  CHECK_EQ(fetch("http://loop.test/ok", true), 200);
+}
+
+static void test_stale_connection_retry(void)
+{
+  mock_http_reset();
+  mock_http_route("http://a.test/1", 200, NULL, 10, false);
+  CHECK_EQ(fetch("http://a.test/1", true), 200);
+  net_http_stats_t before = stats_now();
+
+  // The server dropped the kept connection: one retry on a new one
+  mock_http_drop_idle("http://a.test");
+  uint32_t opens = mock_http.opens;
+  uint32_t connects = mock_http.connects;
+  uint32_t count = mock_http.count;
+  CHECK_EQ(fetch("http://a.test/1", true), 200);
+  CHECK_EQ(mock_http.opens - opens, 2);
+  CHECK_EQ(mock_http.connects - connects, 1);
+  CHECK_EQ(mock_http.count - count, 1);
+  net_http_stats_t after = stats_now();
+  CHECK_EQ(after.requests - before.requests, 1);
+  CHECK_EQ(after.reused - before.reused, 0);
+
+  // A failed new connection is not retried
+  net_http_close_idle();
+  mock_http_refuse("http://a.test", true);
+  opens = mock_http.opens;
+  CHECK_EQ(fetch("http://a.test/1", true), -1);
+  CHECK_EQ(mock_http.opens - opens, 1);
+
+  // Stale, then refused: gives up after the one retry, client freed
+  mock_http_refuse("http://a.test", false);
+  CHECK_EQ(fetch("http://a.test/1", true), 200);
+  mock_http_drop_idle("http://a.test");
+  mock_http_refuse("http://a.test", true);
+  opens = mock_http.opens;
+  CHECK_EQ(fetch("http://a.test/1", true), -1);
+  CHECK_EQ(mock_http.opens - opens, 2);
+  mock_http_refuse("http://a.test", false);
+  CHECK_EQ(fetch("http://a.test/1", true), 200);
+}
+
+static void test_lru_eviction(void)
+{
+  static const char *const url[] = {
+      "http://h1.test/f", "http://h2.test/f", "http://h3.test/f",
+      "http://h4.test/f", "http://h5.test/f",
+  };
+  mock_http_reset();
+  for (int i = 0; i < 5; i++)
+  {
+    mock_http_route(url[i], 200, NULL, 10, false);
+  }
+
+  // Fill the pool, then touch h1 so h2 is the least recently used
+  CHECK_EQ(CONFIG_NET_HTTP_MAX_HOSTS, 3);
+  for (int i = 0; i < 3; i++)
+  {
+    CHECK_EQ(fetch(url[i], true), 200);
+  }
+  CHECK_EQ(fetch(url[0], true), 200);
+  uint32_t cleanups = mock_http.cleanups;
+  uint32_t connects = mock_http.connects;
+
+  CHECK_EQ(fetch(url[3], true), 200);
+  CHECK_EQ(mock_http.cleanups - cleanups, 1);
+  CHECK(!mock_http_connected("http://h2.test"));
+  CHECK(mock_http_connected("http://h1.test"));
+  CHECK(mock_http_connected("http://h3.test"));
+  CHECK(mock_http_connected("http://h4.test"));
+
+  // The survivors keep their connections
+  CHECK_EQ(fetch(url[0], true), 200);
+  CHECK_EQ(mock_http.connects - connects, 1);
+
+  // h2 comes back in place of h3, now the oldest
+  CHECK_EQ(fetch(url[1], true), 200);
+  CHECK(!mock_http_connected("http://h3.test"));
+  CHECK(mock_http_connected("http://h4.test"));
+
+  // Clients in use are never taken
+  const net_http_opts_t o1 = {.url = url[0]};
+  const net_http_opts_t o2 = {.url = url[1]};
+  const net_http_opts_t o4 = {.url = url[3]};
+  const net_http_opts_t o5 = {.url = url[4]};
+  net_http_req_t r1;
+  net_http_req_t r2;
+  net_http_req_t r4;
+  net_http_req_t r5;
+  CHECK_EQ(net_http_open(&r1, &o1), ESP_OK);
+  CHECK_EQ(net_http_open(&r2, &o2), ESP_OK);
+  CHECK_EQ(net_http_open(&r4, &o4), ESP_OK);
+  CHECK_EQ(net_http_open(&r5, &o5), ESP_ERR_NO_MEM);
+  net_http_close(&r1);
+  net_http_close(&r2);
+  net_http_close(&r4);
+  CHECK_EQ(net_http_open(&r5, &o5), ESP_OK);
+  net_http_close(&r5);
+}
+
+int main(void)
+{
+  test_reuse();
+  test_cross_host_redirect();
+  test_same_host_redirect();
+  test_stale_connection_retry();
+  test_lru_eviction();
+  TEST_DONE();
+}
@@ -0,0 +1,488 @@
+/**
+ * @file test_net_sched.c
+ * @brief net_sched: batching, early windows, VBUS, backoff, budget, stats
+ *
+ * Runs the core against a fake link whose clock only moves when the link
+ * comes up or a job runs.
+ */
+
+#include "net_sched.h"
+#include "test_host.h"
+#include <string.h>
+
+#define SECOND_MS 1000
+#define UP_MS 2000 // Association and DHCP
+#define BUDGET_MS 10000
+#define LINK_RETRY_MS 30000
+
+typedef struct
+{
+  int64_t now_ms;
+  bool up;     ///< Brought up by the scheduler
+  bool shared; ///< Up for someone else
+  bool vbus;
+  bool fail_up;
+  int ups;
+  int downs;
+} fake_link_t;
+
+typedef struct
+{
+  fake_link_t *link;
+  uint32_t run_ms; ///< Time the job takes
+  bool ok;
+  int runs;
+  int order; ///< Position in the last batch, from 1
+} fake_job_t;
+
+static fake_link_t fake;
+static int batch_pos;
+
+static int64_t fake_now_ms(void *ctx)
+{
+  return ((fake_link_t *)ctx)->now_ms;
+}
+
+static bool fake_is_up(void *ctx)
+{
+  return ((fake_link_t *)ctx)->shared;
+}
+
+static bool fake_up(void *ctx)
+{
+  fake_link_t *f = ctx;
+  f->ups++;
+  f->now_ms += UP_MS;
+  if (f->fail_up)
+  {
+    return false;
+  }
+  f->up = true;
+  return true;
+}
+
+static void fake_down(void *ctx)
+{
+  fake_link_t *f = ctx;
+  f->downs++;
+  f->up = false;
+}
+
+static bool fake_on_vbus(void *ctx)
+{
+  return ((fake_link_t *)ctx)->vbus;
+}
+
+static const net_link_t link = {
+    .now_ms = fake_now_ms,
+    .is_up = fake_is_up,
+    .up = fake_up,
+    .down = fake_down,
+    .on_vbus = fake_on_vbus,
+    .ctx = &fake,
+};
+
+static bool job_run(void *user_data)
+{
+  fake_job_t *j = user_data;
+  CHECK(j->link->up || j->link->shared); // Never run without the link
+  j->link->now_ms += j->run_ms;
+  j->runs++;
+  j->order = ++batch_pos;
+  return j->ok;
+}
+
+static net_job_t job(fake_job_t *j, uint32_t interval_s, uint32_t window_s,
+                     uint32_t cost_ms)
+{
+  j->link = &fake;
+  j->run_ms = cost_ms;
+  j->ok = true;
+  return (net_job_t){
+      .name = "job",
+      .run = job_run,
+      .user_data = j,
+      .interval_s = interval_s,
+      .window_s = window_s,
+      .retry_s = 60,
+      .cost_ms = cost_ms,
+  };
+}
+
+static int add(net_sched_t *s, fake_job_t *j, uint32_t interval_s,
+               uint32_t window_s, uint32_t cost_ms)
+{
+  const net_job_t nj = job(j, interval_s, window_s, cost_ms);
+  return net_sched_add(s, &nj);
+}
+
+static void setup(net_sched_t *s)
+{
+  memset(&fake, 0, sizeof(fake));
+  fake.now_ms = 1000 * SECOND_MS;
+  net_sched_init(s, &link, BUDGET_MS, LINK_RETRY_MS);
+}
+
+static int poll(net_sched_t *s)
+{
+  batch_pos = 0;
+  return net_sched_poll(s);
+}
+
+static void test_due_jobs_batched(void)
+{
+  net_sched_t s;
+  setup(&s);
+  fake_job_t a = {0};
+  fake_job_t b = {0};
+  fake_job_t c = {0};
+  CHECK_EQ(add(&s, &a, 600, 60, 500), 0);
+  CHECK_EQ(add(&s, &b, 900, 60, 500), 1);
+  CHECK_EQ(add(&s, &c, 0, 0, 500), 2);
+
+  // All three run at the first chance, in one session
+  CHECK_EQ(net_sched_next_ms(&s), 0);
+  CHECK_EQ(poll(&s), 3);
+  CHECK_EQ(fake.ups, 1);
+  CHECK_EQ(fake.downs, 1);
+  CHECK(!fake.up);
+
+  // Nothing due until a's deadline; c was one-shot
+  int64_t next = net_sched_next_ms(&s);
+  CHECK(next > 590 * SECOND_MS && next <= 600 * SECOND_MS);
+  CHECK_EQ(poll(&s), 0);
+  CHECK_EQ(fake.ups, 1);
+
+  // Two deadlines passing together while idle still cost one session
+  fake.now_ms += 1000 * SECOND_MS;
+  CHECK_EQ(poll(&s), 2);
+  CHECK_EQ(a.runs, 2);
+  CHECK_EQ(b.runs, 2);
+  CHECK_EQ(c.runs, 1);
+  CHECK_EQ(fake.ups, 2);
+
+  // Table full, or no run callback
+  fake_job_t extra = {0};
+  net_job_t no_run = job(&extra, 60, 0, 0);
+  no_run.run = NULL;
+  CHECK_EQ(net_sched_add(&s, &no_run), -1);
+  for (int i = s.count; i < NET_SCHED_MAX_JOBS; i++)
+  {
+    CHECK(add(&s, &extra, 0, 0, 0) >= 0);
+  }
+  CHECK_EQ(add(&s, &extra, 0, 0, 0), -1);
+}
+
+static void test_nearly_due_ride_along(void)
+{
+  net_sched_t s;
+  setup(&s);
+  fake_job_t a = {0};
+  fake_job_t b = {0};
+  fake_job_t far = {0};
+  add(&s, &a, 600, 30, 500);
+  add(&s, &b, 660, 120, 500);
+  add(&s, &far, 3600, 60, 500);
+  poll(&s);
+  CHECK_EQ(fake.ups, 1);
+
+  // At a's deadline b is 60 s from its own but inside its window: it
+  // rides along and the next session moves out to b's new period
+  fake.now_ms += 600 * SECOND_MS;
+  CHECK_EQ(poll(&s), 2);
+  CHECK_EQ(a.runs, 2);
+  CHECK_EQ(b.runs, 2);
+  CHECK_EQ(far.runs, 1); // Window not open yet
+  CHECK_EQ(a.order, 1);  // Earliest deadline first
+  CHECK_EQ(b.order, 2);
+  CHECK_EQ(fake.ups, 2);
+
+  // Off VBUS the next wake-up is a's deadline, not b's window; an open
+  // window alone does not start a session
+  CHECK_EQ(net_sched_next_ms(&s), 600 * SECOND_MS - 500);
+  fake.now_ms += 550 * SECOND_MS;
+  CHECK_EQ(poll(&s), 0);
+  CHECK_EQ(fake.ups, 2);
+}
+
+static void test_vbus_starts_early(void)
+{
+  net_sched_t s;
+  setup(&s);
+  fake_job_t a = {0};
+  add(&s, &a, 600, 120, 500);
+  poll(&s);
+
+  // Inside the window, off VBUS: waits for the deadline
+  fake.now_ms += 500 * SECOND_MS;
+  int64_t wait_ms = net_sched_next_ms(&s);
+  CHECK(wait_ms > 0);
+  CHECK_EQ(poll(&s), 0);
+
+  // Plugged in: the open window is enough
+  fake.vbus = true;
+  CHECK_EQ(net_sched_next_ms(&s), 0);
+  CHECK_EQ(poll(&s), 1);
+  CHECK_EQ(a.runs, 2);
+  CHECK_EQ(fake.ups, 2);
+
+  // Before the window opens, VBUS changes nothing
+  fake.now_ms += 100 * SECOND_MS;
+  CHECK(net_sched_next_ms(&s) > 0);
+  CHECK_EQ(poll(&s), 0);
+
+  // A link without a VBUS sense never starts early
+  net_link_t no_vbus = link;
+  no_vbus.on_vbus = NULL;
+  s.link = &no_vbus;
+  fake.now_ms += 400 * SECOND_MS;
+  CHECK(net_sched_next_ms(&s) > 0);
+  CHECK_EQ(poll(&s), 0);
+  s.link = &link;
+}
+
+static void test_link_failure_backoff(void)
+{
+  net_sched_t s;
+  setup(&s);
+  fake_job_t a = {0};
+  add(&s, &a, 600, 60, 500);
+
+  fake.fail_up = true;
+  CHECK_EQ(poll(&s), 0);
+  CHECK_EQ(fake.ups, 1);
+  CHECK_EQ(fake.downs, 0);
+  CHECK_EQ(a.runs, 0);
+
+  // The job is still due, but the link is left alone for the backoff
+  CHECK_EQ(net_sched_next_ms(&s), LINK_RETRY_MS);
+  fake.now_ms += LINK_RETRY_MS - 1;
+  CHECK_EQ(poll(&s), 0);
+  CHECK_EQ(fake.ups, 1);
+
+  // Each failure doubles the wait
+  fake.now_ms += 1;
+  CHECK_EQ(poll(&s), 0);
+  CHECK_EQ(fake.ups, 2);
+  CHECK_EQ(net_sched_next_ms(&s), 2 * LINK_RETRY_MS);
+  fake.now_ms += 2 * LINK_RETRY_MS;
+  CHECK_EQ(poll(&s), 0);
+  CHECK_EQ(net_sched_next_ms(&s), 4 * LINK_RETRY_MS);
+
+  // And is capped at an hour
+  for (int i = 0; i < 10; i++)
+  {
+    fake.now_ms += net_sched_next_ms(&s);
+    poll(&s);
+    CHECK(net_sched_next_ms(&s) <= 60 * 60 * SECOND_MS);
+  }
+  CHECK_EQ(net_sched_next_ms(&s), 60 * 60 * SECOND_MS);
+
+  // Back up: the job runs and the backoff starts over
+  fake.fail_up = false;
+  fake.now_ms += net_sched_next_ms(&s);
+  CHECK_EQ(poll(&s), 1);
+  net_sched_stats_t st;
+  net_sched_get_stats(&s, &st);
+  CHECK_EQ(st.link_failures, 13);
+  CHECK_EQ(st.sessions, 1);
+  fake.fail_up = true;
+  fake.now_ms += 600 * SECOND_MS;
+  poll(&s);
+  CHECK_EQ(net_sched_next_ms(&s), LINK_RETRY_MS);
+
+  // A failed run is retried after retry_s, not the interval
+  fake.fail_up = false;
+  a.ok = false;
+  fake.now_ms += LINK_RETRY_MS;
+  CHECK_EQ(poll(&s), 1);
+  int64_t next = net_sched_next_ms(&s);
+  CHECK(next > 50 * SECOND_MS && next <= 60 * SECOND_MS);
+  net_sched_get_stats(&s, &st);
+  CHECK_EQ(st.jobs_failed, 1);
+}
+
+static void test_shared_link(void)
+{
+  net_sched_t s;
+  setup(&s);
+  fake_job_t a = {0};
+  fake_job_t b = {0};
+  add(&s, &a, 600, 60, 500);
+  add(&s, &b, 900, 400, 20000);
+  poll(&s);
+  CHECK_EQ(fake.ups, 1);
+
+  // Up for someone else (a sync, a user action): open jobs run on it
+  // without up()/down(), and early jobs come along without a budget
+  fake.shared = true;
+  fake.now_ms += 300 * SECOND_MS;
+  CHECK_EQ(poll(&s), 0); // No window open yet
+  fake.now_ms += 260 * SECOND_MS;
+  CHECK_EQ(net_sched_next_ms(&s), 0);
+  CHECK_EQ(poll(&s), 2); // b is early and twice the budget
+  CHECK_EQ(a.runs, 2);
+  CHECK_EQ(b.runs, 2);
+  CHECK_EQ(fake.ups, 1);
+  CHECK_EQ(fake.downs, 1);
+
+  net_sched_stats_t st;
+  net_sched_get_stats(&s, &st);
+  CHECK_EQ(st.sessions, 1);
+  CHECK_EQ(st.shared, 1);
+  CHECK_EQ(st.jobs_shared, 2);
+  CHECK_EQ(st.jobs_run, 2); // Sessions only
+
+  // The link time of shared batches is not charged to the scheduler
+  CHECK_EQ(st.radio_on_ms, UP_MS + 500 + 20000);
+}
+
+static void test_budget_skip(void)
+{
+  net_sched_t s;
+  setup(&s);
+  fake_job_t due = {0};
+  fake_job_t cheap = {0};
+  fake_job_t heavy = {0};
+  add(&s, &due, 600, 60, 3000);
+  add(&s, &cheap, 620, 60, 1000);
+  add(&s, &heavy, 630, 60, 8000);
+  poll(&s); // First chance: all required, the budget does not apply
+  CHECK_EQ(heavy.runs, 1);
+
+  // due is required and runs; cheap fits in what is left of the budget;
+  // heavy would overrun it and waits for its own deadline
+  int64_t t0 = 1000 * SECOND_MS;
+  fake.now_ms = t0 + 606 * SECOND_MS;
+  CHECK_EQ(poll(&s), 2);
+  CHECK_EQ(due.runs, 2);
+  CHECK_EQ(cheap.runs, 2);
+  CHECK_EQ(heavy.runs, 1);
+
+  // Its deadline starts the next session
+  fake.now_ms = t0 + 645 * SECOND_MS;
+  CHECK_EQ(poll(&s), 1);
+  CHECK_EQ(heavy.runs, 2);
+
+  // A lone optional job larger than the budget still gets its session
+  // when a deadline starts one: the first job always runs
+  net_sched_t t;
+  setup(&t);
+  fake_job_t big = {0};
+  add(&t, &big, 600, 600, BUDGET_MS * 2);
+  poll(&t);
+  fake.vbus = true;
+  fake.now_ms += 10 * SECOND_MS;
+  CHECK_EQ(poll(&t), 1);
+  CHECK_EQ(big.runs, 2);
+}
+
+static void test_stats(void)
+{
+  net_sched_t s;
+  setup(&s);
+  int64_t start_ms = fake.now_ms;
+  fake_job_t a = {0};
+  fake_job_t b = {0};
+  fake_job_t c = {0};
+  add(&s, &a, 3600, 600, 1000);
+  add(&s, &b, 3600, 600, 1000);
+  add(&s, &c, 7200, 0, 1000);
+
+  net_sched_stats_t st;
+  net_sched_get_stats(&s, &st);
+  CHECK_EQ(st.since_ms, start_ms);
+  CHECK_EQ(net_sched_jobs_per_session_x100(&st), 0); // No session yet
+  CHECK_EQ(net_sched_radio_s_per_day(&st, start_ms), 0);
+
+  // Hourly for a day: 3 jobs in the first session, then 2 and 3
+  // alternating (c every other hour). Deadlines count from the end of a
+  // run, so each poll is a little later than the one before.
+  for (int h = 0; h < 24; h++)
+  {
+    fake.now_ms = start_ms + (int64_t)h * (3600 + 10) * SECOND_MS;
+    poll(&s);
+  }
+  net_sched_get_stats(&s, &st);
+  CHECK_EQ(st.sessions, 24);
+  CHECK_EQ(st.jobs_run, 12 * 3 + 12 * 2);
+  CHECK_EQ(net_sched_jobs_per_session_x100(&st), 250);
+  CHECK_EQ(st.radio_on_ms, 24 * UP_MS + 60 * 1000);
+
+  // 48 + 60 s of link time over 24 h
+  int64_t day_ms = start_ms + 86400LL * SECOND_MS;
+  CHECK_EQ(net_sched_radio_s_per_day(&st, day_ms), 108);
+  // Over half a day the same time is twice the rate
+  CHECK_EQ(net_sched_radio_s_per_day(&st, start_ms + 43200LL * SECOND_MS),
+           216);
+  CHECK_EQ(net_sched_radio_s_per_day(&st, start_ms - 1), 0);
+
+  // Failed bring-ups count as radio time but not as sessions
+  fake.fail_up = true;
+  fake.now_ms = start_ms + 24LL * (3600 + 10) * SECOND_MS;
+  poll(&s);
+  net_sched_get_stats(&s, &st);
+  CHECK_EQ(st.sessions, 24);
+  CHECK_EQ(st.link_failures, 1);
+  CHECK_EQ(st.radio_on_ms, 25 * UP_MS + 60 * 1000);
+}
+
+static uint32_t due_from(void *user_data)
+{
+  return *(uint32_t *)user_data;
+}
+
+static bool run_ok(void *user_data)
+{
+  (void)user_data;
+  return true;
+}
+
+static void test_due_in_and_refresh(void)
+{
+  net_sched_t s;
+  setup(&s);
+  uint32_t due_s = 3600;
+  const net_job_t sync = {
+      .name = "sync",
+      .run = run_ok,
+      .due_in_s = due_from,
+      .user_data = &due_s,
+      .window_s = 60,
+  };
+  int id = net_sched_add(&s, &sync);
+  CHECK_EQ(net_sched_next_ms(&s), 3600 * SECOND_MS); // Asked at registration
+
+  // Done another way: asked again, the deadline moves out
+  fake.now_ms += 1800 * SECOND_MS;
+  due_s = 7200;
+  net_sched_refresh(&s, id);
+  CHECK_EQ(net_sched_next_ms(&s), 7200 * SECOND_MS);
+
+  // Not scheduled, then forced to run now
+  due_s = UINT32_MAX;
+  net_sched_refresh(&s, id);
+  CHECK_EQ(net_sched_next_ms(&s), NET_SCHED_NEVER);
+  net_sched_set_due(&s, id, 0);
+  CHECK_EQ(poll(&s), 1);
+  CHECK_EQ(net_sched_next_ms(&s), NET_SCHED_NEVER);
+
+  // Bad ids are ignored
+  net_sched_set_due(&s, -1, 0);
+  net_sched_set_due(&s, 5, 0);
+  net_sched_refresh(&s, 5);
+  CHECK_EQ(net_sched_next_ms(&s), NET_SCHED_NEVER);
+}
+
+int main(void)
+{
+  test_due_jobs_batched();
+  test_nearly_due_ride_along();
+  test_vbus_starts_early();
+  test_link_failure_backoff();
+  test_shared_link();
+  test_budget_skip();
+  test_stats();
+  test_due_in_and_refresh();
+  TEST_DONE();
+}
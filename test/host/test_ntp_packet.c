@@ -0,0 +1,192 @@
+/**
+ * @file test_ntp_packet.c
+ * @brief ntp_packet: reply validation, offset and round trip, sample choice
+ */
+
+#include "ntp_packet.h"
+#include "test_host.h"
+#include <string.h>
+
+#define US 1000000LL
+#define NTP_UNIX_DELTA 2208988800LL
+
+// 2024-10-16 12:00:00 UTC and 2040-01-01 00:00:00 UTC (NTP era 1)
+#define T_2024 (1729080000LL * US)
+#define T_2040 (2208988800LL * US)
+
+/** Independent NTP timestamp encoder (era wraps by truncation) */
+static void put_timestamp(uint8_t *p, int64_t unix_us)
+{
+  int64_t sec = unix_us / US;
+  int64_t rem = unix_us % US;
+  uint32_t s = (uint32_t)(sec + NTP_UNIX_DELTA);
+  uint32_t f = (uint32_t)(((uint64_t)rem << 32) / US);
+  for (int i = 0; i < 4; i++)
+  {
+    p[i] = (uint8_t)(s >> (24 - 8 * i));
+    p[4 + i] = (uint8_t)(f >> (24 - 8 * i));
+  }
+}
+
+/**
+ * @brief A server reply to the request sent at t1, as the server saw it
+ */
+static void make_reply(uint8_t *buf, int64_t t1_us, int64_t t2_us,
+                       int64_t t3_us, uint8_t li_vn_mode, uint8_t stratum)
+{
+  uint8_t request[NTP_PACKET_SIZE];
+  ntp_packet_build_request(request, t1_us);
+
+  memset(buf, 0, NTP_PACKET_SIZE);
+  buf[0] = li_vn_mode;
+  buf[1] = stratum;
+  memcpy(buf + 24, request + 40, 8); // Origin = our transmit time
+  put_timestamp(buf + 32, t2_us);
+  put_timestamp(buf + 40, t3_us);
+}
+
+#define SERVER_V4 0x24 // LI 0, version 4, mode 4
+#define SERVER_V3 0x1C // LI 0, version 3, mode 4
+
+static void test_request(void)
+{
+  uint8_t buf[NTP_PACKET_SIZE];
+  ntp_packet_build_request(buf, T_2024 + 250000);
+  CHECK_EQ(buf[0], 0x23); // Version 4, client
+  uint8_t expected[8];
+  put_timestamp(expected, T_2024 + 250000);
+  CHECK(memcmp(buf + 40, expected, 8) == 0);
+}
+
+static void test_offset_and_rtt(int64_t t1)
+{
+  // Server 1.5 s ahead, 20 ms each way, 2 ms processing
+  const int64_t offset = 1500000;
+  int64_t t2 = t1 + 20000 + offset;
+  int64_t t3 = t2 + 2000;
+  int64_t t4 = t1 + 42000;
+  uint8_t buf[NTP_PACKET_SIZE];
+  ntp_sample_t s;
+
+  make_reply(buf, t1, t2, t3, SERVER_V4, 2);
+  CHECK_EQ(ntp_packet_parse_reply(buf, sizeof(buf), t1, t4, &s),
+           NTP_PACKET_OK);
+  CHECK(s.offset_us >= offset - 1 && s.offset_us <= offset + 1);
+  CHECK(s.rtt_us >= 39999 && s.rtt_us <= 40001);
+  CHECK_EQ(s.stratum, 2);
+}
+
+static void test_era(void)
+{
+  // 2040 has the top bit of the NTP seconds clear: must decode as era 1
+  test_offset_and_rtt(T_2024);
+  test_offset_and_rtt(T_2040);
+  test_offset_and_rtt(T_2040 + 30LL * 365 * 86400 * US);
+
+  // Client sends 5 ms before the 2036 rollover, the server answers after
+  int64_t t1 = (4294967296LL - NTP_UNIX_DELTA) * US - 5000;
+  uint8_t buf[NTP_PACKET_SIZE];
+  ntp_sample_t s;
+  make_reply(buf, t1, t1 + 10000, t1 + 10000, SERVER_V4, 1);
+  CHECK_EQ(ntp_packet_parse_reply(buf, sizeof(buf), t1, t1 + 20000, &s),
+           NTP_PACKET_OK);
+  CHECK(s.offset_us >= -1 && s.offset_us <= 1);
+}
+
+static void test_rejects(void)
+{
+  const int64_t t1 = T_2024;
+  uint8_t buf[NTP_PACKET_SIZE];
+  ntp_sample_t s;
+
+  make_reply(buf, t1, t1 + 5000, t1 + 5000, SERVER_V4, 1);
+  CHECK_EQ(ntp_packet_parse_reply(buf, NTP_PACKET_SIZE - 1, t1, t1 + 10000,
+                                  &s),
+           NTP_PACKET_SHORT);
+
+  // Client mode, and a version we do not speak
+  make_reply(buf, t1, t1 + 5000, t1 + 5000, 0x23, 1);
+  CHECK_EQ(ntp_packet_parse_reply(buf, sizeof(buf), t1, t1 + 10000, &s),
+           NTP_PACKET_BAD_MODE);
+  make_reply(buf, t1, t1 + 5000, t1 + 5000, 0x14, 1);
+  CHECK_EQ(ntp_packet_parse_reply(buf, sizeof(buf), t1, t1 + 10000, &s),
+           NTP_PACKET_BAD_MODE);
+  make_reply(buf, t1, t1 + 5000, t1 + 5000, SERVER_V3, 1);
+  CHECK_EQ(ntp_packet_parse_reply(buf, sizeof(buf), t1, t1 + 10000, &s),
+           NTP_PACKET_OK);
+
+  // Reply to an earlier request (1 us apart is a different timestamp)
+  make_reply(buf, t1 - 1, t1 + 5000, t1 + 5000, SERVER_V4, 1);
+  CHECK_EQ(ntp_packet_parse_reply(buf, sizeof(buf), t1, t1 + 10000, &s),
+           NTP_PACKET_MISMATCH);
+
+  // Kiss-o'-death counts only once the origin matches, or anyone on the
+  // path could silence a server
+  make_reply(buf, t1, 0, 0, SERVER_V4, 0);
+  memcpy(buf + 12, "RATE", 4);
+  CHECK_EQ(ntp_packet_parse_reply(buf, sizeof(buf), t1, t1 + 10000, &s),
+           NTP_PACKET_KOD);
+  make_reply(buf, t1 + 1000, 0, 0, SERVER_V4, 0);
+  memcpy(buf + 12, "RATE", 4);
+  CHECK_EQ(ntp_packet_parse_reply(buf, sizeof(buf), t1, t1 + 10000, &s),
+           NTP_PACKET_MISMATCH);
+
+  // Unsynchronised: alarm leap indicator, or stratum 16
+  make_reply(buf, t1, t1 + 5000, t1 + 5000, 0xE4, 1);
+  CHECK_EQ(ntp_packet_parse_reply(buf, sizeof(buf), t1, t1 + 10000, &s),
+           NTP_PACKET_UNSYNCED);
+  make_reply(buf, t1, t1 + 5000, t1 + 5000, SERVER_V4, 16);
+  CHECK_EQ(ntp_packet_parse_reply(buf, sizeof(buf), t1, t1 + 10000, &s),
+           NTP_PACKET_UNSYNCED);
+
+  // Missing receive timestamp, and a server that answered before it heard
+  make_reply(buf, t1, t1 + 5000, t1 + 5000, SERVER_V4, 1);
+  memset(buf + 32, 0, 8);
+  CHECK_EQ(ntp_packet_parse_reply(buf, sizeof(buf), t1, t1 + 10000, &s),
+           NTP_PACKET_BAD_TIME);
+  make_reply(buf, t1, t1 + 5000, t1 + 4000, SERVER_V4, 1);
+  CHECK_EQ(ntp_packet_parse_reply(buf, sizeof(buf), t1, t1 + 10000, &s),
+           NTP_PACKET_BAD_TIME);
+}
+
+static void test_rtt_slack(void)
+{
+  const int64_t t1 = T_2024;
+  uint8_t buf[NTP_PACKET_SIZE];
+  ntp_sample_t s;
+
+  // Server processing 0.5 ms longer than the whole round trip: rounding
+  make_reply(buf, t1, t1 + 100, t1 + 1600, SERVER_V4, 1);
+  CHECK_EQ(ntp_packet_parse_reply(buf, sizeof(buf), t1, t1 + 1100, &s),
+           NTP_PACKET_OK);
+  CHECK_EQ(s.rtt_us, 0);
+
+  // 1.5 ms is not rounding any more
+  make_reply(buf, t1, t1 + 100, t1 + 2600, SERVER_V4, 1);
+  CHECK_EQ(ntp_packet_parse_reply(buf, sizeof(buf), t1, t1 + 1100, &s),
+           NTP_PACKET_BAD_TIME);
+}
+
+static void test_is_better(void)
+{
+  const ntp_sample_t slow = {.offset_us = 0, .rtt_us = 80000, .stratum = 1};
+  const ntp_sample_t fast = {.offset_us = 0, .rtt_us = 20000, .stratum = 3};
+  const ntp_sample_t fast_s2 = {.offset_us = 5, .rtt_us = 20000, .stratum = 2};
+
+  CHECK(ntp_sample_is_better(&slow, NULL));
+  CHECK(ntp_sample_is_better(&fast, &slow));
+  CHECK(!ntp_sample_is_better(&slow, &fast)); // RTT beats stratum
+  CHECK(ntp_sample_is_better(&fast_s2, &fast));
+  CHECK(!ntp_sample_is_better(&fast, &fast_s2));
+  CHECK(!ntp_sample_is_better(&fast, &fast)); // Ties keep the first
+}
+
+int main(void)
+{
+  test_request();
+  test_era();
+  test_rejects();
+  test_rtt_slack();
+  test_is_better();
+  TEST_DONE();
+}
@@ -0,0 +1,341 @@
+/**
+ * @file test_ota_pack.c
+ * @brief ota_stream against containers made by tools/ota_pack.py
+ *
+ * ota_fixtures.h is generated at build time by gen_ota_fixtures.py, so
+ * these decode whatever the packer currently emits: LZSS back-references
+ * that wrap a 256-byte window, and COPY/ADD/INSERT ops against a base.
+ */
+
+#define _POSIX_C_SOURCE 199309L
+
+#include "ota_fixtures.h"
+#include "ota_stream.h"
+#include "test_host.h"
+#include <string.h>
+#include <time.h>
+
+// app_elf_sha256 in esp_app_desc_t, as ota_pack.py reads it
+#define APP_ELF_SHA256_OFFSET (24 + 8 + 144)
+
+typedef struct
+{
+  uint8_t data[sizeof(fx_image)];
+  uint32_t pos;
+  const uint8_t *base; ///< Running image, for delta ops
+  size_t base_len;
+  const uint8_t *running_sha256; ///< NULL: accept any header
+} target_t;
+
+static int target_write(void *ctx, const uint8_t *data, size_t len)
+{
+  target_t *t = ctx;
+  if (t->pos + len > sizeof(t->data))
+  {
+    return -1;
+  }
+  memcpy(t->data + t->pos, data, len);
+  t->pos += (uint32_t)len;
+  return 0;
+}
+
+static int target_read_base(void *ctx, uint32_t offset, uint8_t *buf,
+                            size_t len)
+{
+  target_t *t = ctx;
+  if (offset > t->base_len || len > t->base_len - offset)
+  {
+    return -1; // Past the end of the partition
+  }
+  memcpy(buf, t->base + offset, len);
+  return 0;
+}
+
+/** As ota_download: a delta must have been made against this very build */
+static int target_header(void *ctx, const ota_stream_header_t *hdr)
+{
+  target_t *t = ctx;
+  if ((hdr->flags & OTA_STREAM_FLAG_DELTA) && t->running_sha256 &&
+      memcmp(hdr->base_sha256, t->running_sha256, 32) != 0)
+  {
+    return -1;
+  }
+  return 0;
+}
+
+static target_t target;
+static const ota_stream_io_t io = {
+    .write = target_write,
+    .read_base = target_read_base,
+    .header = target_header,
+    .ctx = &target,
+};
+static ota_stream_t stream;
+
+static void target_reset(void)
+{
+  memset(&target, 0, sizeof(target));
+  target.base = fx_base;
+  target.base_len = sizeof(fx_base);
+  target.running_sha256 = fx_base + APP_ELF_SHA256_OFFSET;
+}
+
+static ota_stream_result_t push_chunked(const uint8_t *data, size_t from,
+                                        size_t to, size_t chunk)
+{
+  while (from < to)
+  {
+    size_t n = to - from < chunk ? to - from : chunk;
+    ota_stream_result_t ret = ota_stream_push(&stream, data + from, n);
+    if (ret != OTA_STREAM_OK)
+    {
+      return ret;
+    }
+    from += n;
+  }
+  return OTA_STREAM_OK;
+}
+
+static void check_decodes(const uint8_t *container, size_t len, size_t chunk)
+{
+  target_reset();
+  ota_stream_init(&stream, &io);
+  CHECK_EQ(push_chunked(container, 0, len, chunk), OTA_STREAM_OK);
+  CHECK(ota_stream_done(&stream));
+  CHECK_EQ(target.pos, sizeof(fx_image));
+  CHECK(memcmp(target.data, fx_image, sizeof(fx_image)) == 0);
+}
+
+static void test_decode(void)
+{
+  // One byte at a time splits every bit field and varint; a whole
+  // container in one push runs matches across the output buffer
+  static const size_t chunks[] = {1, 7, 1460, SIZE_MAX};
+  for (size_t i = 0; i < sizeof(chunks) / sizeof(chunks[0]); i++)
+  {
+    check_decodes(fx_full, sizeof(fx_full), chunks[i]);
+    check_decodes(fx_delta, sizeof(fx_delta), chunks[i]);
+    check_decodes(fx_delta_raw, sizeof(fx_delta_raw), chunks[i]);
+  }
+
+  const ota_stream_header_t *hdr = ota_stream_get_header(&stream);
+  CHECK(hdr != NULL);
+  CHECK_EQ(hdr->flags, OTA_STREAM_FLAG_DELTA);
+  CHECK_EQ(hdr->frame_size, FX_FRAME_SIZE);
+  CHECK_EQ(hdr->image_size, sizeof(fx_image));
+}
+
+/** Frame boundaries of a container: in offsets and the image bytes before */
+static int frame_boundaries(const uint8_t *container, size_t len,
+                            uint32_t *in, uint32_t *out, int max)
+{
+  uint32_t pos = OTA_STREAM_HEADER_SIZE;
+  uint32_t image = 0;
+  int n = 0;
+  while (pos < len && n < max)
+  {
+    in[n] = pos;
+    out[n++] = image;
+    pos += 4 + ((uint32_t)container[pos] | (uint32_t)container[pos + 1] << 8 |
+                (uint32_t)container[pos + 2] << 16 |
+                (uint32_t)container[pos + 3] << 24);
+    image += FX_FRAME_SIZE;
+  }
+  return n;
+}
+
+static void test_resume_mid_delta(void)
+{
+  uint32_t in[8];
+  uint32_t out[8];
+  int frames = frame_boundaries(fx_delta, sizeof(fx_delta), in, out, 8);
+  CHECK_EQ(frames, (int)((sizeof(fx_image) + FX_FRAME_SIZE - 1) /
+                         FX_FRAME_SIZE));
+
+  // Cut inside frames 1 to 3: the decoder is mid-op, mid-varint or
+  // mid-back-reference; resume from the boundary before the cut with
+  // nothing but the saved header fields and offsets
+  for (int f = 1; f < frames - 1; f++)
+  {
+    uint32_t span = in[f + 1] - in[f];
+    for (uint32_t cut = in[f] + 1; cut < in[f + 1]; cut += span / 23 + 1)
+    {
+      target_reset();
+      ota_stream_init(&stream, &io);
+      CHECK_EQ(push_chunked(fx_delta, 0, cut, 61), OTA_STREAM_OK);
+
+      uint32_t resume_in = 0;
+      uint32_t resume_out = 0;
+      ota_stream_resume_point(&stream, &resume_in, &resume_out);
+      CHECK_EQ(resume_in, in[f]);
+      CHECK_EQ(resume_out, out[f]);
+      CHECK(memcmp(target.data, fx_image, resume_out) == 0);
+
+      ota_stream_header_t hdr = *ota_stream_get_header(&stream);
+      memset(target.data + resume_out, 0, sizeof(target.data) - resume_out);
+      target.pos = resume_out;
+      CHECK_EQ(ota_stream_resume(&stream, &io, &hdr, resume_in, resume_out),
+               OTA_STREAM_OK);
+      CHECK_EQ(push_chunked(fx_delta, resume_in, sizeof(fx_delta), 61),
+               OTA_STREAM_OK);
+      CHECK(ota_stream_done(&stream));
+      CHECK_EQ(target.pos, sizeof(fx_image));
+      CHECK(memcmp(target.data, fx_image, sizeof(fx_image)) == 0);
+    }
+  }
+}
+
+static void test_base_mismatch(void)
+{
+  // Another running build: refused at the header, before any write
+  uint8_t other[32];
+  memcpy(other, fx_base + APP_ELF_SHA256_OFFSET, sizeof(other));
+  other[31] ^= 1;
+  target_reset();
+  target.running_sha256 = other;
+  ota_stream_init(&stream, &io);
+  CHECK_EQ(push_chunked(fx_delta, 0, sizeof(fx_delta), 1460),
+           OTA_STREAM_IO_ERROR);
+  CHECK_EQ(target.pos, 0);
+
+  // A full image does not depend on the running build
+  target.pos = 0;
+  ota_stream_init(&stream, &io);
+  CHECK_EQ(push_chunked(fx_full, 0, sizeof(fx_full), 1460), OTA_STREAM_OK);
+  CHECK(ota_stream_done(&stream));
+
+  // Ops reading past a shorter base partition fail instead of inventing
+  // bytes
+  target_reset();
+  target.base_len = sizeof(fx_base) / 2;
+  ota_stream_init(&stream, &io);
+  CHECK_EQ(push_chunked(fx_delta, 0, sizeof(fx_delta), 1460),
+           OTA_STREAM_IO_ERROR);
+}
+
+static void test_corrupt_ops(void)
+{
+  static uint8_t bad[sizeof(fx_delta_raw)];
+  const size_t first_op = OTA_STREAM_HEADER_SIZE + 4;
+
+  // Unknown op code
+  memcpy(bad, fx_delta_raw, sizeof(bad));
+  bad[first_op] = 0x07;
+  target_reset();
+  ota_stream_init(&stream, &io);
+  CHECK_EQ(push_chunked(bad, 0, sizeof(bad), 1460), OTA_STREAM_CORRUPT);
+
+  // A frame's ops producing more than frame_size bytes: the first op is
+  // a COPY from the base header, stretch it to eight frames
+  CHECK_EQ(fx_delta_raw[first_op], 0x01);
+  CHECK_EQ(fx_delta_raw[first_op + 1], 0x00); // From base offset 0
+  memcpy(bad, fx_delta_raw, sizeof(bad));
+  bad[first_op + 2] = 0x80;
+  bad[first_op + 3] = 0x80;
+  bad[first_op + 4] = 0x02; // 2 << 14
+  target_reset();
+  ota_stream_init(&stream, &io);
+  CHECK_EQ(push_chunked(bad, 0, sizeof(bad), 1460), OTA_STREAM_CORRUPT);
+
+  // Frame payload cut short: its ops produce too little
+  uint32_t in[8];
+  uint32_t out[8];
+  int frames = frame_boundaries(fx_delta_raw, sizeof(fx_delta_raw), in, out, 8);
+  memcpy(bad, fx_delta_raw, sizeof(bad));
+  memcpy(bad + in[0], "\x01\0\0\0", 4); // One byte: a lone op code
+  target_reset();
+  ota_stream_init(&stream, &io);
+  CHECK_EQ(push_chunked(bad, 0, in[0] + 5, 1460), OTA_STREAM_CORRUPT);
+
+  // The last frame has all its image bytes but ends inside another op
+  static uint8_t longer[sizeof(fx_delta_raw) + 1];
+  memcpy(longer, fx_delta_raw, sizeof(fx_delta_raw));
+  longer[sizeof(fx_delta_raw)] = 0x01;
+  longer[in[frames - 1]]++; // Payload of the last frame is under 256 bytes
+  CHECK(longer[in[frames - 1]] != 0);
+  target_reset();
+  ota_stream_init(&stream, &io);
+  CHECK_EQ(push_chunked(longer, 0, sizeof(longer), 1460),
+           OTA_STREAM_CORRUPT);
+}
+
+/**
+ * @brief A back-reference before any output reads zeros, in every frame
+ *
+ * heatshrink starts each window zeroed and the packer never relies on
+ * it, so build the frames by hand: 4096 literal 0xFF, then one 16-byte
+ * match at distance 1 that must not see the previous frame's bytes.
+ */
+static void test_window_starts_zeroed(void)
+{
+  static uint8_t container[OTA_STREAM_HEADER_SIZE + 4 + 4608 + 4 + 2];
+  static const uint8_t header[16] = {
+      'W', 'O', 'T', 'A', OTA_STREAM_VERSION, OTA_STREAM_FLAG_LZSS, 8, 4,
+      0x10, 0x10, 0, 0, // Image: 4096 + 16 bytes
+      0x00, 0x10, 0, 0, // Frame: 4096 bytes
+  };
+  memset(container, 0, sizeof(container));
+  memcpy(container, header, sizeof(header));
+
+  uint8_t *p = container + OTA_STREAM_HEADER_SIZE;
+  p[0] = 0x00;
+  p[1] = 0x12; // 4608 bytes
+  p += 4;
+  memset(p, 0xFF, 4608); // 9-bit literals of 0xFF are all one bits
+  p += 4608;
+  p[0] = 2;
+  p += 4;
+  p[0] = 0x00; // Tag 0, distance 1 (0b00000000), length 16 (0b1111)
+  p[1] = 0x78;
+
+  target_reset();
+  ota_stream_init(&stream, &io);
+  CHECK_EQ(ota_stream_push(&stream, container, sizeof(container)),
+           OTA_STREAM_OK);
+  CHECK(ota_stream_done(&stream));
+  CHECK_EQ(target.pos, 4096 + 16);
+  CHECK_EQ(target.data[4095], 0xFF);
+  static const uint8_t zeros[16];
+  CHECK(memcmp(target.data + 4096, zeros, sizeof(zeros)) == 0);
+}
+
+static double elapsed_ms(const struct timespec *start)
+{
+  struct timespec now;
+  clock_gettime(CLOCK_MONOTONIC, &now);
+  return (double)(now.tv_sec - start->tv_sec) * 1e3 +
+         (double)(now.tv_nsec - start->tv_nsec) / 1e6;
+}
+
+/** Patch size and apply time, for comparing packer changes */
+static void report(const char *name, const uint8_t *container, size_t len)
+{
+  enum
+  {
+    RUNS = 20
+  };
+  struct timespec start;
+  clock_gettime(CLOCK_MONOTONIC, &start);
+  for (int i = 0; i < RUNS; i++)
+  {
+    target_reset();
+    ota_stream_init(&stream, &io);
+    ota_stream_push(&stream, container, len);
+  }
+  double ms = elapsed_ms(&start) / RUNS;
+  printf("%-10s %6zu bytes for %zu (%4.1f%%), applied in %.3f ms\n", name,
+         len, sizeof(fx_image), 100.0 * (double)len / sizeof(fx_image), ms);
+}
+
+int main(void)
+{
+  test_decode();
+  test_resume_mid_delta();
+  test_base_mismatch();
+  test_corrupt_ops();
+  test_window_starts_zeroed();
+  report("full", fx_full, sizeof(fx_full));
+  report("delta", fx_delta, sizeof(fx_delta));
+  report("delta raw", fx_delta_raw, sizeof(fx_delta_raw));
+  TEST_DONE();
+}
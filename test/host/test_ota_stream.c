@@ -0,0 +1,293 @@
+/**
+ * @file test_ota_stream.c
+ * @brief ota_stream: resume points of plain and packed images after a drop
+ */
+
+#include "ota_stream.h"
+#include "test_host.h"
+#include <string.h>
+
+#define FRAME_SIZE 4096
+#define IMAGE_SIZE (3 * FRAME_SIZE + 1000) // Short last frame
+#define WINDOW_BITS 8
+#define LOOKAHEAD_BITS 4
+#define CONTAINER_MAX (OTA_STREAM_HEADER_SIZE + 4 * 4 + IMAGE_SIZE * 9 / 8 + 16)
+
+static uint8_t image[IMAGE_SIZE];
+static uint8_t container[CONTAINER_MAX];
+static size_t container_len;
+static uint32_t frame_start[4]; // Container offset of each frame length
+
+/** Flash stand-in: decoded bytes land at the current write offset */
+typedef struct
+{
+  uint8_t data[IMAGE_SIZE];
+  uint32_t pos;
+} sink_t;
+
+static int sink_write(void *ctx, const uint8_t *data, size_t len)
+{
+  sink_t *sink = ctx;
+  if (sink->pos + len > sizeof(sink->data))
+  {
+    return -1;
+  }
+  memcpy(sink->data + sink->pos, data, len);
+  sink->pos += (uint32_t)len;
+  return 0;
+}
+
+static sink_t sink;
+static const ota_stream_io_t io = {.write = sink_write, .ctx = &sink};
+static ota_stream_t stream;
+
+static void put_le32(uint8_t *p, uint32_t v)
+{
+  for (int i = 0; i < 4; i++)
+  {
+    p[i] = (uint8_t)(v >> (8 * i));
+  }
+}
+
+/**
+ * @brief Pack the image as an LZSS container of literals only
+ *
+ * Enough for the framing; ota_pack.py round-trips real matches.
+ */
+static void build_container(void)
+{
+  uint8_t *p = container;
+  memcpy(p, "WOTA", 4);
+  p[4] = OTA_STREAM_VERSION;
+  p[5] = OTA_STREAM_FLAG_LZSS;
+  p[6] = WINDOW_BITS;
+  p[7] = LOOKAHEAD_BITS;
+  put_le32(p + 8, IMAGE_SIZE);
+  put_le32(p + 12, FRAME_SIZE);
+  memset(p + 16, 0, 32);
+  p += OTA_STREAM_HEADER_SIZE;
+
+  for (uint32_t f = 0; f * FRAME_SIZE < IMAGE_SIZE; f++)
+  {
+    frame_start[f] = (uint32_t)(p - container);
+    uint8_t *payload = p + 4;
+    uint32_t acc = 0;
+    int nbits = 0;
+    size_t n = 0;
+    uint32_t end = (f + 1) * FRAME_SIZE;
+    end = end < IMAGE_SIZE ? end : IMAGE_SIZE;
+
+    for (uint32_t i = f * FRAME_SIZE; i < end; i++)
+    {
+      acc = (acc << 9) | 0x100 | image[i]; // Tag 1, then the literal
+      nbits += 9;
+      while (nbits >= 8)
+      {
+        nbits -= 8;
+        payload[n++] = (uint8_t)(acc >> nbits);
+      }
+    }
+    if (nbits > 0)
+    {
+      payload[n++] = (uint8_t)(acc << (8 - nbits));
+    }
+    put_le32(p, (uint32_t)n);
+    p = payload + n;
+  }
+  container_len = (size_t)(p - container);
+}
+
+static void fill_image(uint8_t first)
+{
+  uint32_t x = 12345;
+  for (size_t i = 0; i < IMAGE_SIZE; i++)
+  {
+    x = x * 1103515245 + 12345;
+    image[i] = (uint8_t)(x >> 16);
+  }
+  image[0] = first;
+}
+
+/** Push [from, to) in uneven chunks, like HTTP reads */
+static ota_stream_result_t push_range(const uint8_t *data, size_t from,
+                                      size_t to)
+{
+  size_t chunk = 1;
+  while (from < to)
+  {
+    size_t n = to - from < chunk ? to - from : chunk;
+    ota_stream_result_t ret = ota_stream_push(&stream, data + from, n);
+    if (ret != OTA_STREAM_OK)
+    {
+      return ret;
+    }
+    from += n;
+    chunk = chunk * 3 % 1531 + 1;
+  }
+  return OTA_STREAM_OK;
+}
+
+static void test_plain_sector_alignment(void)
+{
+  fill_image(0xE9);
+  memset(&sink, 0, sizeof(sink));
+  ota_stream_init(&stream, &io);
+
+  // The connection drops 5000 bytes in: flash holds them, resume at 4 KB
+  CHECK_EQ(push_range(image, 0, 5000), OTA_STREAM_OK);
+  CHECK(ota_stream_get_header(&stream) == NULL);
+  uint32_t in = 1;
+  uint32_t out = 1;
+  ota_stream_resume_point(&stream, &in, &out);
+  CHECK_EQ(in, 4096);
+  CHECK_EQ(out, 4096);
+
+  // Exactly on a sector, and before the first one
+  CHECK_EQ(push_range(image, 5000, 8192), OTA_STREAM_OK);
+  ota_stream_resume_point(&stream, &in, &out);
+  CHECK_EQ(in, 8192);
+  sink.pos = 0;
+  ota_stream_init(&stream, &io);
+  CHECK_EQ(push_range(image, 0, 4095), OTA_STREAM_OK);
+  ota_stream_resume_point(&stream, &in, &out);
+  CHECK_EQ(in, 0);
+
+  // Restart at 8 KB and finish the image
+  memset(sink.data + 8192, 0, sizeof(sink.data) - 8192);
+  sink.pos = 8192;
+  CHECK_EQ(ota_stream_resume(&stream, &io, NULL, 8192, 8192), OTA_STREAM_OK);
+  CHECK_EQ(push_range(image, 8192, IMAGE_SIZE), OTA_STREAM_OK);
+  CHECK_EQ(sink.pos, IMAGE_SIZE);
+  CHECK(memcmp(sink.data, image, IMAGE_SIZE) == 0);
+  CHECK(!ota_stream_done(&stream));
+
+  // A plain image has no framing: both offsets must agree
+  CHECK_EQ(ota_stream_resume(&stream, &io, NULL, 8192, 4096),
+           OTA_STREAM_BAD_HEADER);
+}
+
+/**
+ * @brief Drop the connection at `cut`, resume from the reported point
+ */
+static void drop_and_resume(size_t cut)
+{
+  memset(&sink, 0, sizeof(sink));
+  ota_stream_init(&stream, &io);
+  CHECK_EQ(push_range(container, 0, cut), OTA_STREAM_OK);
+
+  uint32_t in = 0;
+  uint32_t out = 0;
+  ota_stream_resume_point(&stream, &in, &out);
+  const ota_stream_header_t *seen = ota_stream_get_header(&stream);
+  if (cut < OTA_STREAM_HEADER_SIZE)
+  {
+    // Nothing to resume from: ota_download starts over at offset 0
+    CHECK(seen == NULL);
+    CHECK_EQ(in, 0);
+    CHECK_EQ(out, 0);
+    return;
+  }
+  CHECK(seen != NULL);
+
+  // The last frame boundary at or before the cut
+  size_t expected_in = OTA_STREAM_HEADER_SIZE;
+  uint32_t expected_out = 0;
+  for (uint32_t f = 1; f < 4; f++)
+  {
+    if (frame_start[f] <= cut)
+    {
+      expected_in = frame_start[f];
+      expected_out = f * FRAME_SIZE;
+    }
+  }
+  if (cut == container_len)
+  {
+    expected_in = container_len;
+    expected_out = IMAGE_SIZE;
+  }
+  CHECK_EQ(in, expected_in);
+  CHECK_EQ(out, expected_out);
+  CHECK_EQ(out % FRAME_SIZE == 0 || out == IMAGE_SIZE, 1);
+
+  // Everything before the boundary is already in flash
+  CHECK(sink.pos >= out);
+  CHECK(memcmp(sink.data, image, out) == 0);
+
+  // Only the header fields survive a reboot, not the decoder
+  ota_stream_header_t hdr = *seen;
+  memset(sink.data + out, 0, sizeof(sink.data) - out);
+  sink.pos = out;
+  CHECK_EQ(ota_stream_resume(&stream, &io, &hdr, in, out), OTA_STREAM_OK);
+  CHECK_EQ(push_range(container, in, container_len), OTA_STREAM_OK);
+  CHECK(ota_stream_done(&stream));
+  CHECK_EQ(sink.pos, IMAGE_SIZE);
+  CHECK(memcmp(sink.data, image, IMAGE_SIZE) == 0);
+}
+
+static void test_container_frame_boundary(void)
+{
+  fill_image(0xE9);
+  build_container();
+
+  // Inside the header, around every frame start (before it, inside its
+  // length field, at the first payload bytes) and mid-payload
+  static const size_t header_cuts[] = {3, 4, 20, OTA_STREAM_HEADER_SIZE};
+  for (size_t i = 0; i < sizeof(header_cuts) / sizeof(header_cuts[0]); i++)
+  {
+    drop_and_resume(header_cuts[i]);
+  }
+  for (uint32_t f = 0; f < 4; f++)
+  {
+    for (int d = -1; d <= 5; d++)
+    {
+      drop_and_resume((size_t)((int)frame_start[f] + d));
+    }
+    drop_and_resume(frame_start[f] + 4 + 500);
+  }
+  drop_and_resume(container_len - 1);
+  drop_and_resume(container_len); // Complete, nothing left to fetch
+}
+
+static void test_rejected_resume(void)
+{
+  const ota_stream_header_t hdr = {
+      .flags = OTA_STREAM_FLAG_LZSS,
+      .window_bits = WINDOW_BITS,
+      .lookahead_bits = LOOKAHEAD_BITS,
+      .image_size = IMAGE_SIZE,
+      .frame_size = FRAME_SIZE,
+  };
+
+  // Off a frame boundary, or past the image
+  CHECK_EQ(ota_stream_resume(&stream, &io, &hdr, 1000, 4095),
+           OTA_STREAM_BAD_HEADER);
+  CHECK_EQ(ota_stream_resume(&stream, &io, &hdr, 1000, IMAGE_SIZE + 1),
+           OTA_STREAM_BAD_HEADER);
+
+  // The end of the image is a boundary even though it is not aligned
+  CHECK_EQ(ota_stream_resume(&stream, &io, &hdr, 1000, IMAGE_SIZE),
+           OTA_STREAM_OK);
+  CHECK(ota_stream_done(&stream));
+
+  // Saved header fields that no container could have
+  ota_stream_header_t bad = hdr;
+  bad.frame_size = FRAME_SIZE + 512; // Frames must end on a sector
+  CHECK_EQ(ota_stream_resume(&stream, &io, &bad, 1000, 0),
+           OTA_STREAM_BAD_HEADER);
+  bad = hdr;
+  bad.window_bits = OTA_STREAM_WINDOW_BITS_MAX + 1;
+  CHECK_EQ(ota_stream_resume(&stream, &io, &bad, 1000, 0),
+           OTA_STREAM_BAD_HEADER);
+  bad = hdr;
+  bad.flags = 0x80;
+  CHECK_EQ(ota_stream_resume(&stream, &io, &bad, 1000, 0),
+           OTA_STREAM_BAD_HEADER);
+}
+
+int main(void)
+{
+  test_plain_sector_alignment();
+  test_container_frame_boundary();
+  test_rejected_resume();
+  TEST_DONE();
+}
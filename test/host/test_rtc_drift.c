@@ -0,0 +1,165 @@
+/**
+ * @file test_rtc_drift.c
+ * @brief rtc_drift: sample rejection, offset register sign, sync interval
+ */
+
+#include "rtc_drift.h"
+#include "test_host.h"
+
+#define DAY_S 86400
+
+/** RTC error after interval_s for a crystal drift, with steps applied */
+static int32_t error_ms_for(int32_t drift_ppb, int8_t steps,
+                            uint32_t interval_s)
+{
+  int64_t rate = (int64_t)drift_ppb + (int64_t)steps * RTC_DRIFT_PPB_PER_STEP;
+  return (int32_t)(rate * (int64_t)interval_s / 1000000);
+}
+
+static void test_short_interval(void)
+{
+  rtc_drift_t est;
+  rtc_drift_init(&est);
+  CHECK_EQ(rtc_drift_add_sample(&est, 100, RTC_DRIFT_MIN_INTERVAL_S - 1, 0),
+           RTC_DRIFT_TOO_SHORT);
+  CHECK_EQ(est.samples, 0);
+  CHECK_EQ(rtc_drift_uncertainty_ppb(&est), UINT32_MAX);
+  CHECK_EQ(rtc_drift_offset_steps(&est), 0);
+}
+
+static void test_correction_removed(void)
+{
+  // 10 ppm fast crystal, measured while the register held -2 steps
+  rtc_drift_t est;
+  rtc_drift_init(&est);
+  int32_t err = error_ms_for(10000, -2, DAY_S);
+  CHECK_EQ(rtc_drift_add_sample(&est, err, DAY_S, -2), RTC_DRIFT_ACCEPTED);
+  CHECK(est.drift_ppb > 9980 && est.drift_ppb < 10020);
+  CHECK_EQ(est.samples, 1);
+  CHECK(rtc_drift_uncertainty_ppb(&est) < 1000);
+}
+
+static void test_offset_steps_sign(void)
+{
+  rtc_drift_t est;
+  rtc_drift_init(&est);
+
+  // A fast crystal (+) is slowed with negative steps, and the reverse
+  est.samples = 1;
+  est.drift_ppb = 10000;
+  CHECK_EQ(rtc_drift_offset_steps(&est), -2);
+  est.drift_ppb = -10000;
+  CHECK_EQ(rtc_drift_offset_steps(&est), 2);
+
+  // Rounds to the nearest step
+  est.drift_ppb = RTC_DRIFT_PPB_PER_STEP / 2 - 1;
+  CHECK_EQ(rtc_drift_offset_steps(&est), 0);
+  est.drift_ppb = RTC_DRIFT_PPB_PER_STEP / 2;
+  CHECK_EQ(rtc_drift_offset_steps(&est), -1);
+  est.drift_ppb = -(RTC_DRIFT_PPB_PER_STEP / 2);
+  CHECK_EQ(rtc_drift_offset_steps(&est), 1);
+
+  // Clamped to the register range
+  est.drift_ppb = 1000000;
+  CHECK_EQ(rtc_drift_offset_steps(&est), RTC_DRIFT_STEPS_MIN);
+  est.drift_ppb = -1000000;
+  CHECK_EQ(rtc_drift_offset_steps(&est), RTC_DRIFT_STEPS_MAX);
+
+  // The suggested steps cancel the drift a later sample sees
+  rtc_drift_t real;
+  rtc_drift_init(&real);
+  rtc_drift_add_sample(&real, error_ms_for(13000, 0, DAY_S), DAY_S, 0);
+  int8_t steps = rtc_drift_offset_steps(&real);
+  CHECK_EQ(steps, -3);
+  int32_t residual_ms = error_ms_for(13000, steps, DAY_S);
+  CHECK(residual_ms > -5 && residual_ms < 5);
+}
+
+static void test_outlier_rejection(void)
+{
+  rtc_drift_t est;
+  rtc_drift_init(&est);
+  for (int i = 0; i < 3; i++)
+  {
+    CHECK_EQ(rtc_drift_add_sample(&est, error_ms_for(2000, 0, DAY_S), DAY_S,
+                                  0),
+             RTC_DRIFT_ACCEPTED);
+  }
+  CHECK_EQ(est.samples, 3);
+  const rtc_drift_t before = est;
+
+  // One bad sample (RTC reset, bad NTP reply) leaves the estimate alone
+  int32_t jump = error_ms_for(50000, 0, DAY_S);
+  CHECK_EQ(rtc_drift_add_sample(&est, jump, DAY_S, 0), RTC_DRIFT_OUTLIER);
+  CHECK_EQ(est.drift_ppb, before.drift_ppb);
+  CHECK_EQ(est.weight, before.weight);
+  CHECK_EQ(est.rejected, 1);
+
+  // A good sample clears the outlier count
+  CHECK_EQ(rtc_drift_add_sample(&est, error_ms_for(2000, 0, DAY_S), DAY_S, 0),
+           RTC_DRIFT_ACCEPTED);
+  CHECK_EQ(est.rejected, 0);
+
+  // Three in a row: the crystal really changed, start over from them
+  CHECK_EQ(rtc_drift_add_sample(&est, jump, DAY_S, 0), RTC_DRIFT_OUTLIER);
+  CHECK_EQ(rtc_drift_add_sample(&est, jump, DAY_S, 0), RTC_DRIFT_OUTLIER);
+  CHECK_EQ(est.rejected, 2);
+  CHECK_EQ(rtc_drift_add_sample(&est, jump, DAY_S, 0), RTC_DRIFT_ACCEPTED);
+  CHECK_EQ(est.samples, 1);
+  CHECK_EQ(est.rejected, 0);
+  CHECK(est.drift_ppb > 49980 && est.drift_ppb < 50020);
+
+  // Small deviations stay under the floor and are averaged in
+  rtc_drift_init(&est);
+  rtc_drift_add_sample(&est, error_ms_for(2000, 0, DAY_S), DAY_S, 0);
+  rtc_drift_add_sample(&est, error_ms_for(2000, 0, DAY_S), DAY_S, 0);
+  CHECK_EQ(rtc_drift_add_sample(&est, error_ms_for(6000, 0, DAY_S), DAY_S, 0),
+           RTC_DRIFT_ACCEPTED);
+  CHECK(est.drift_ppb > 2000 && est.drift_ppb < 6000);
+}
+
+static void test_sync_interval(void)
+{
+  const uint32_t min_s = 12 * 3600;
+  const uint32_t max_s = 7 * DAY_S;
+  rtc_drift_t est;
+  rtc_drift_init(&est);
+
+  // Fewer than two samples: the configured minimum
+  CHECK_EQ(rtc_drift_sync_interval(&est, 0, 1000, min_s, max_s), min_s);
+  rtc_drift_add_sample(&est, error_ms_for(20000, 0, DAY_S), DAY_S, 0);
+  CHECK_EQ(rtc_drift_sync_interval(&est, 0, 1000, min_s, max_s), min_s);
+  rtc_drift_add_sample(&est, error_ms_for(20000, 0, DAY_S), DAY_S, 0);
+
+  // Uncorrected: time until drift plus uncertainty reaches the limit
+  uint64_t expected_ppb =
+      (uint64_t)est.drift_ppb + rtc_drift_uncertainty_ppb(&est);
+  uint32_t uncorrected = rtc_drift_sync_interval(&est, 0, 1000, 1, max_s);
+  CHECK_EQ(uncorrected, 1000ULL * 1000000 / expected_ppb);
+
+  // Clamped both ways
+  CHECK_EQ(rtc_drift_sync_interval(&est, 0, 1000, 2 * DAY_S, max_s),
+           2 * DAY_S);
+  CHECK_EQ(rtc_drift_sync_interval(&est, 0, 1000, 1, 3600), 3600);
+
+  // Correcting with the suggested steps allows longer, the wrong sign less
+  int8_t steps = rtc_drift_offset_steps(&est);
+  CHECK(steps < 0);
+  uint32_t corrected = rtc_drift_sync_interval(&est, steps, 1000, 1, 1u << 31);
+  uint32_t wrong = rtc_drift_sync_interval(&est, (int8_t)-steps, 1000, 1,
+                                           1u << 31);
+  CHECK(corrected > uncorrected);
+  CHECK(wrong < uncorrected);
+  CHECK_EQ(rtc_drift_sync_interval(&est, steps, 1000, min_s, 3 * DAY_S),
+           3 * DAY_S);
+}
+
+int main(void)
+{
+  test_short_interval();
+  test_correction_removed();
+  test_offset_steps_sign();
+  test_outlier_rejection();
+  test_sync_interval();
+  TEST_DONE();
+}
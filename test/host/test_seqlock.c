@@ -0,0 +1,154 @@
+/**
+ * @file test_seqlock.c
+ * @brief seqlock: one writer against concurrent readers, no torn reads
+ */
+
+#include "seqlock.h"
+#include "test_host.h"
+#include <pthread.h>
+#include <stdbool.h>
+#include <stdint.h>
+#include <string.h>
+
+// Copies long enough that a reader is regularly preempted or overtaken in
+// the middle of one, also on a single-core host
+#define WORDS (64 * 1024)
+#define WRITES 4000
+#define READERS 3
+
+typedef struct
+{
+  uint32_t word[WORDS];
+} value_t;
+
+static value_t storage[2];
+static seqlock_t lock = SEQLOCK_INITIALIZER(storage);
+static atomic_bool writer_done;
+
+typedef struct
+{
+  unsigned long reads;
+  unsigned long torn;
+  unsigned long backwards;
+} reader_result_t;
+
+static void *writer(void *arg)
+{
+  (void)arg;
+  value_t v;
+  for (uint32_t n = 1; n <= WRITES; n++)
+  {
+    for (int i = 0; i < WORDS; i++)
+    {
+      v.word[i] = n;
+    }
+    seqlock_write(&lock, &v);
+  }
+  atomic_store(&writer_done, true);
+  return NULL;
+}
+
+static void *reader(void *arg)
+{
+  reader_result_t *r = arg;
+  uint32_t last_value = 0;
+  uint32_t last_seq = 0;
+  value_t v;
+
+  while (!atomic_load(&writer_done))
+  {
+    uint32_t seq = seqlock_read(&lock, &v);
+    for (int i = 1; i < WORDS; i++)
+    {
+      if (v.word[i] != v.word[0])
+      {
+        r->torn++;
+        break;
+      }
+    }
+    // Neither the value nor the sequence may go back in time
+    if (v.word[0] < last_value || seq < last_seq)
+    {
+      r->backwards++;
+    }
+    last_value = v.word[0];
+    last_seq = seq;
+    r->reads++;
+  }
+  return NULL;
+}
+
+static void test_concurrent(void)
+{
+  pthread_t w;
+  pthread_t rd[READERS];
+  reader_result_t results[READERS];
+  memset(results, 0, sizeof(results));
+
+  for (int i = 0; i < READERS; i++)
+  {
+    pthread_create(&rd[i], NULL, reader, &results[i]);
+  }
+  pthread_create(&w, NULL, writer, NULL);
+  pthread_join(w, NULL);
+  for (int i = 0; i < READERS; i++)
+  {
+    pthread_join(rd[i], NULL);
+    CHECK(results[i].reads > 0);
+    CHECK_EQ(results[i].torn, 0);
+    CHECK_EQ(results[i].backwards, 0);
+  }
+
+  value_t v;
+  seqlock_read(&lock, &v);
+  CHECK_EQ(v.word[0], WRITES);
+  CHECK_EQ(v.word[WORDS - 1], WRITES);
+  CHECK_EQ(seqlock_sequence(&lock), 2u * WRITES);
+}
+
+static void test_init_and_sequence(void)
+{
+  uint32_t buf[2];
+  seqlock_t l;
+  memset(buf, 0xAB, sizeof(buf));
+  seqlock_init(&l, buf, sizeof(buf[0]));
+
+  uint32_t out = 1;
+  CHECK_EQ(seqlock_read(&l, &out), 0);
+  CHECK_EQ(out, 0); // All zero until the first write
+
+  uint32_t in = 42;
+  seqlock_write(&l, &in);
+  CHECK_EQ(seqlock_read(&l, &out), 2);
+  CHECK_EQ(out, 42);
+  CHECK_EQ(buf[0], 42);
+  CHECK_EQ(buf[1], 42); // Both copies caught up
+}
+
+static void test_wraparound(void)
+{
+  uint32_t buf[2];
+  seqlock_t l;
+  seqlock_init(&l, buf, sizeof(buf[0]));
+  atomic_store(&l.sequence, UINT32_MAX - 1);
+
+  uint32_t in = 7;
+  uint32_t out = 0;
+  seqlock_write(&l, &in);
+  CHECK_EQ(seqlock_sequence(&l), 0); // 32-bit wrap, as on the target
+  CHECK_EQ(seqlock_read(&l, &out), 0);
+  CHECK_EQ(out, 7);
+
+  in = 8;
+  seqlock_write(&l, &in);
+  CHECK_EQ(seqlock_read(&l, &out), 2);
+  CHECK_EQ(out, 8);
+}
+
+int main(void)
+{
+  test_init_and_sequence();
+  test_wraparound();
+  test_concurrent();
+  TEST_DONE();
+}
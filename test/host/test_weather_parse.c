@@ -0,0 +1,330 @@
+/**
+ * @file test_weather_parse.c
+ * @brief weather_parse: Open-Meteo responses in any chunking, malformed input
+ */
+
+#include "test_host.h"
+#include "weather_parse.h"
+#include <string.h>
+
+// Shaped like a real response: units with a UTF-8 and an escaped degree
+// sign, three days of daily values of which only the first is today's
+static const char forecast[] =
+    "{\"latitude\":50.45,\"longitude\":30.52,\"generationtime_ms\":0.05,"
+    "\"utc_offset_seconds\":7200,\"timezone\":\"Europe/Kyiv\","
+    "\"elevation\":1.79E2,\r\n"
+    "\"current_units\": {\"time\": \"iso8601\", \"interval\": \"seconds\", "
+    "\"temperature_2m\": \"\xC2\xB0" "C\", \"weather_code\": \"wmo code\"},\n"
+    "\"current\": {\"time\": \"2024-10-16T18:00\", \"interval\": 900, "
+    "\"temperature_2m\": -1.25e1, \"weather_code\": 71},\n"
+    "\"daily_units\": {\"time\": \"iso8601\", "
+    "\"temperature_2m_max\": \"\\u00b0C\", "
+    "\"temperature_2m_min\": \"\\u00b0C\"},\n"
+    "\"daily\": {\"time\": [\"2024-10-16\", \"2024-10-17\", \"2024-10-18\"],\n"
+    "  \"temperature_2m_max\": [-3.04, 99.0, 98.0],\n"
+    "  \"temperature_2m_min\": [-1.5E+1, -99.0, -98.0]}}\n";
+
+static weather_parse_result_t parse(const char *json, size_t len,
+                                    size_t chunk, weather_data_t *out,
+                                    bool *ok)
+{
+  weather_parser_t p;
+  weather_parse_init(&p);
+  weather_parse_result_t res = WEATHER_PARSE_MORE;
+  for (size_t i = 0; i < len && res == WEATHER_PARSE_MORE; i += chunk)
+  {
+    size_t n = len - i < chunk ? len - i : chunk;
+    res = weather_parse_push(&p, json + i, n);
+  }
+  memset(out, 0, sizeof(*out));
+  *ok = weather_parse_finish(&p, out);
+  return res;
+}
+
+static void check_forecast(const weather_data_t *d)
+{
+  CHECK_EQ(d->temp_c10, -125);
+  CHECK_EQ(d->code, 71);
+  CHECK_EQ(d->high_c10, -30);
+  CHECK_EQ(d->low_c10, -150);
+  CHECK_EQ(d->fields,
+           WEATHER_HAS_TEMP | WEATHER_HAS_CODE | WEATHER_HAS_HIGH |
+               WEATHER_HAS_LOW);
+}
+
+static void test_every_split(void)
+{
+  const size_t len = strlen(forecast);
+  weather_data_t d;
+  bool ok = false;
+
+  CHECK_EQ(parse(forecast, len, len, &d, &ok), WEATHER_PARSE_DONE);
+  CHECK(ok);
+  check_forecast(&d);
+  CHECK_EQ(parse(forecast, len, 1, &d, &ok), WEATHER_PARSE_DONE);
+  CHECK(ok);
+  check_forecast(&d);
+
+  // Every place a read can end: inside keys, escapes, numbers, UTF-8
+  for (size_t cut = 1; cut < len; cut++)
+  {
+    weather_parser_t p;
+    weather_parse_init(&p);
+    const size_t closed = (size_t)(strrchr(forecast, '}') - forecast);
+    CHECK_EQ(weather_parse_push(&p, forecast, cut),
+             cut > closed ? WEATHER_PARSE_DONE : WEATHER_PARSE_MORE);
+    CHECK_EQ(weather_parse_push(&p, forecast + cut, len - cut),
+             WEATHER_PARSE_DONE);
+    CHECK(weather_parse_finish(&p, &d));
+    check_forecast(&d);
+  }
+
+  // Uneven network reads
+  for (size_t chunk = 2; chunk < 64; chunk++)
+  {
+    CHECK_EQ(parse(forecast, len, chunk, &d, &ok), WEATHER_PARSE_DONE);
+    CHECK(ok);
+    check_forecast(&d);
+  }
+}
+
+static void test_truncated(void)
+{
+  // Any prefix, even one holding every value, is not a whole document
+  const size_t len = strlen(forecast);
+  const size_t closed = (size_t)(strrchr(forecast, '}') - forecast);
+  for (size_t cut = 0; cut <= closed; cut++)
+  {
+    weather_data_t d;
+    bool ok = true;
+    CHECK_EQ(parse(forecast, cut, 7, &d, &ok), WEATHER_PARSE_MORE);
+    CHECK(!ok);
+  }
+
+  // Trailing bytes after the top-level object are ignored
+  weather_parser_t p;
+  weather_data_t d;
+  weather_parse_init(&p);
+  CHECK_EQ(weather_parse_push(&p, forecast, len), WEATHER_PARSE_DONE);
+  CHECK_EQ(weather_parse_push(&p, "garbage", 7), WEATHER_PARSE_DONE);
+  CHECK(weather_parse_finish(&p, &d));
+}
+
+static bool parse_one(const char *json, weather_data_t *d)
+{
+  bool ok = false;
+  weather_parse_result_t res = parse(json, strlen(json), 5, d, &ok);
+  return res == WEATHER_PARSE_DONE && ok;
+}
+
+static void test_numbers(void)
+{
+  weather_data_t d;
+
+  // Rounding half away from zero, exponents, clamping to int16
+  CHECK(parse_one("{\"current\":{\"temperature_2m\":0.05,\"weather_code\":0}}",
+                  &d));
+  CHECK_EQ(d.temp_c10, 1);
+  CHECK(parse_one("{\"current\":{\"temperature_2m\":-0.05,"
+                  "\"weather_code\":0}}",
+                  &d));
+  CHECK_EQ(d.temp_c10, -1);
+  CHECK(parse_one("{\"current\":{\"temperature_2m\":25E-1,"
+                  "\"weather_code\":1.0e0}}",
+                  &d));
+  CHECK_EQ(d.temp_c10, 25);
+  CHECK_EQ(d.code, 1);
+  CHECK(parse_one("{\"current\":{\"temperature_2m\":1e9,\"weather_code\":0}}",
+                  &d));
+  CHECK_EQ(d.temp_c10, INT16_MAX);
+  CHECK(parse_one("{\"current\":{\"temperature_2m\":-1e9,"
+                  "\"weather_code\":0}}",
+                  &d));
+  CHECK_EQ(d.temp_c10, INT16_MIN);
+
+  // A weather code that is not a byte is left out
+  CHECK(!parse_one("{\"current\":{\"temperature_2m\":1,\"weather_code\":256}}",
+                   &d));
+  CHECK(!parse_one("{\"current\":{\"temperature_2m\":1,\"weather_code\":-1}}",
+                   &d));
+
+  // Number characters that do not make a number are skipped, not read
+  // as a prefix
+  CHECK(!parse_one("{\"current\":{\"temperature_2m\":1.2.3,"
+                   "\"weather_code\":3}}",
+                   &d));
+  CHECK(!parse_one("{\"current\":{\"temperature_2m\":-,\"weather_code\":3}}",
+                   &d));
+}
+
+static void test_paths(void)
+{
+  weather_data_t d;
+
+  // The same names elsewhere in the tree do not count
+  CHECK(!parse_one("{\"temperature_2m\":1,\"weather_code\":2,"
+                   "\"hourly\":{\"temperature_2m\":[3],\"weather_code\":[4]},"
+                   "\"x\":{\"current\":{\"temperature_2m\":5,"
+                   "\"weather_code\":6}}}",
+                   &d));
+  CHECK(!parse_one("{\"current\":[{\"temperature_2m\":1,\"weather_code\":2}]}",
+                   &d));
+
+  // Daily values only from index 0, and only from arrays
+  CHECK(parse_one("{\"current\":{\"temperature_2m\":1,\"weather_code\":2},"
+                  "\"daily\":{\"temperature_2m_max\":[null,7],"
+                  "\"temperature_2m_min\":6}}",
+                  &d));
+  CHECK_EQ(d.fields, WEATHER_HAS_TEMP | WEATHER_HAS_CODE);
+
+  // Past 255 elements the index saturates instead of wrapping to 0
+  char big[2400] = "{\"current\":{\"temperature_2m\":1,\"weather_code\":2},"
+                   "\"daily\":{\"temperature_2m_max\":[5";
+  for (int i = 0; i < 300; i++)
+  {
+    strcat(big, ",9");
+  }
+  strcat(big, "]}}");
+  CHECK(parse_one(big, &d));
+  CHECK_EQ(d.high_c10, 50);
+
+  // Other value kinds are skipped wherever they are
+  CHECK(parse_one("{\"a\":true,\"b\":[false,null,{},[],\"\\\"}\"],"
+                  "\"current\":{\"is_day\":false,\"temperature_2m\":4,"
+                  "\"note\":\"a \\\"quoted\\\" ]} string\","
+                  "\"weather_code\":5}}",
+                  &d));
+  CHECK_EQ(d.temp_c10, 40);
+  CHECK_EQ(d.code, 5);
+}
+
+static void test_long_tokens(void)
+{
+  weather_data_t d;
+
+  // Keys that only start like a known one are not truncated into it
+  CHECK(!parse_one("{\"current\":{\"temperature_2m_apparent_in_shade\":1,"
+                   "\"weather_code\":2}}",
+                   &d));
+  CHECK(!parse_one("{\"current_with_a_much_longer_name_than_fits\":"
+                   "{\"temperature_2m\":1,\"weather_code\":2}}",
+                   &d));
+
+  // A number longer than the token buffer is dropped, not misread
+  CHECK(!parse_one("{\"current\":{\"temperature_2m\":"
+                   "12.000000000000000000001,\"weather_code\":2}}",
+                   &d));
+  CHECK(parse_one("{\"current\":{\"temperature_2m\":"
+                  "12.00000000000000000001,\"weather_code\":2}}",
+                  &d)); // 23 characters still fit, 24 do not
+  CHECK_EQ(d.temp_c10, 120);
+
+  // Long strings, and strings longer than 255 bytes, are skipped whole
+  char json[700] = "{\"current\":{\"time\":\"";
+  memset(json + strlen(json), 'x', 600);
+  strcat(json, "\",\"temperature_2m\":1,\"weather_code\":2}}");
+  CHECK(parse_one(json, &d));
+  CHECK_EQ(d.code, 2);
+}
+
+static void test_malformed(void)
+{
+  weather_data_t d;
+  bool ok = true;
+
+  // Nesting: the forecast needs 3 levels, 6 are followed, 7 is an error
+  CHECK(parse_one("{\"current\":{\"temperature_2m\":1,\"weather_code\":2},"
+                  "\"x\":[[[[{}]]]]}",
+                  &d));
+  static const char deep[] =
+      "{\"current\":{\"temperature_2m\":1,\"weather_code\":2},"
+      "\"x\":[[[[[{}]]]]]}";
+  CHECK_EQ(parse(deep, strlen(deep), 1, &d, &ok), WEATHER_PARSE_ERROR);
+  CHECK(!ok);
+
+  // Not an object, not JSON, or broken structure
+  static const char *const bad[] = {
+      "[1,2]",
+      "<html>",
+      "\"text\"",
+      "{\"current\" 1}",
+      "{\"current\":{\"temperature_2m\":1,,}}",
+      "{\"a\":1]",
+      "{\"a\":[1}",
+      "{1:2}",
+      "{\"a\":@}",
+  };
+  for (size_t i = 0; i < sizeof(bad) / sizeof(bad[0]); i++)
+  {
+    CHECK_EQ(parse(bad[i], strlen(bad[i]), 1, &d, &ok), WEATHER_PARSE_ERROR);
+    CHECK(!ok);
+  }
+
+  // A trailing comma is let through: nothing is lost by reading it
+  CHECK(parse_one("{\"current\":{\"temperature_2m\":1,\"weather_code\":2,},"
+                  "\"daily\":{\"temperature_2m_max\":[3,]}}",
+                  &d));
+  CHECK_EQ(d.high_c10, 30);
+
+  // Errors stick
+  weather_parser_t p;
+  weather_parse_init(&p);
+  CHECK_EQ(weather_parse_push(&p, "x", 1), WEATHER_PARSE_ERROR);
+  CHECK_EQ(weather_parse_push(&p, forecast, strlen(forecast)),
+           WEATHER_PARSE_ERROR);
+}
+
+static void test_required_fields(void)
+{
+  weather_data_t d;
+
+  // Temperature and code are required, high and low are optional
+  CHECK(!parse_one("{\"current\":{\"weather_code\":2},"
+                   "\"daily\":{\"temperature_2m_max\":[5],"
+                   "\"temperature_2m_min\":[1]}}",
+                   &d));
+  CHECK(!parse_one("{\"current\":{\"temperature_2m\":2},"
+                   "\"daily\":{\"temperature_2m_max\":[5],"
+                   "\"temperature_2m_min\":[1]}}",
+                   &d));
+  CHECK(!parse_one("{}", &d));
+  CHECK(!parse_one("{\"error\":true,\"reason\":\"Cannot initialize\"}", &d));
+  CHECK(parse_one("{\"current\":{\"temperature_2m\":2,\"weather_code\":0}}",
+                  &d));
+  CHECK_EQ(d.fields, WEATHER_HAS_TEMP | WEATHER_HAS_CODE);
+  CHECK_EQ(d.high_c10, 0);
+
+  // Nothing is copied out on failure
+  weather_parser_t p;
+  weather_parse_init(&p);
+  weather_parse_push(&p, "{\"current\":{\"temperature_2m\":2}}", 32);
+  memset(&d, 0x5A, sizeof(d));
+  CHECK(!weather_parse_finish(&p, &d));
+  CHECK_EQ(d.fields, 0x5A);
+}
+
+static void test_code_names(void)
+{
+  CHECK(strcmp(weather_code_name(0), "Clear") == 0);
+  CHECK(strcmp(weather_code_name(3), "Overcast") == 0);
+  CHECK(strcmp(weather_code_name(48), "Fog") == 0);
+  CHECK(strcmp(weather_code_name(65), "Rain") == 0);
+  CHECK(strcmp(weather_code_name(71), "Snow") == 0);
+  CHECK(strcmp(weather_code_name(86), "Snow") == 0);
+  CHECK(strcmp(weather_code_name(99), "Storm") == 0);
+  CHECK(strcmp(weather_code_name(4), "?") == 0);
+  CHECK(strcmp(weather_code_name(255), "?") == 0);
+}
+
+int main(void)
+{
+  test_every_split();
+  test_truncated();
+  test_numbers();
+  test_paths();
+  test_long_tokens();
+  test_malformed();
+  test_required_fields();
+  test_code_names();
+  TEST_DONE();
+}
@@ -0,0 +1,236 @@
+/**
+ * @file test_wifi_reconnect.c
+ * @brief wifi_reconnect: reason classes, auth limit, jittered backoff
+ */
+
+#include "test_host.h"
+#include "wifi_reconnect.h"
+#include <stddef.h>
+
+#define BASE_MS 1000
+#define CAP_MS (5 * 60 * 1000)
+#define FACTOR 4
+
+// wifi_err_reason_t values from esp_wifi_types.h
+#define REASON_UNSPECIFIED 1
+#define REASON_AUTH_EXPIRE 2
+#define REASON_ASSOC_LEAVE 8
+#define REASON_MIC_FAILURE 14
+#define REASON_4WAY_HANDSHAKE_TIMEOUT 15
+#define REASON_BEACON_TIMEOUT 200
+#define REASON_NO_AP_FOUND 201
+#define REASON_AUTH_FAIL 202
+#define REASON_ASSOC_FAIL 203
+#define REASON_HANDSHAKE_TIMEOUT 204
+#define REASON_CONNECTION_FAIL 205
+#define REASON_NO_AP_COMPATIBLE_SECURITY 210
+#define REASON_NO_AP_RSSI_THRESHOLD 212
+
+static const wifi_reconnect_config_t cfg = {
+    .base_ms = BASE_MS,
+    .cap_ms = CAP_MS,
+    .low_battery_factor = FACTOR,
+    .auth_retries = 2,
+};
+
+/** Delay before jitter for the nth failure, shifted as the policy does */
+static uint32_t nominal(uint32_t base, uint32_t cap, int shift)
+{
+  uint64_t d = (uint64_t)base << shift;
+  return d > cap ? cap : (uint32_t)d;
+}
+
+/** Equal jitter: at least half the nominal delay, at most all of it */
+static int in_bounds(uint32_t delay, uint32_t nom)
+{
+  return delay >= nom - nom / 2 && delay <= nom;
+}
+
+static void test_classify(void)
+{
+  static const struct
+  {
+    uint16_t reason;
+    wifi_disc_class_t cls;
+  } cases[] = {
+      {REASON_ASSOC_LEAVE, WIFI_DISC_LOCAL},
+      {REASON_MIC_FAILURE, WIFI_DISC_AUTH},
+      {REASON_4WAY_HANDSHAKE_TIMEOUT, WIFI_DISC_AUTH},
+      {REASON_AUTH_FAIL, WIFI_DISC_AUTH},
+      {REASON_HANDSHAKE_TIMEOUT, WIFI_DISC_AUTH},
+      {REASON_NO_AP_COMPATIBLE_SECURITY, WIFI_DISC_AUTH},
+      {REASON_NO_AP_FOUND, WIFI_DISC_NO_AP},
+      {REASON_NO_AP_RSSI_THRESHOLD, WIFI_DISC_NO_AP},
+      {REASON_AUTH_EXPIRE, WIFI_DISC_LINK_LOST},
+      {REASON_BEACON_TIMEOUT, WIFI_DISC_LINK_LOST},
+      {REASON_UNSPECIFIED, WIFI_DISC_OTHER},
+      {REASON_ASSOC_FAIL, WIFI_DISC_OTHER},
+      {REASON_CONNECTION_FAIL, WIFI_DISC_OTHER},
+      {0, WIFI_DISC_OTHER},
+      {UINT16_MAX, WIFI_DISC_OTHER},
+  };
+  for (size_t i = 0; i < sizeof(cases) / sizeof(cases[0]); i++)
+  {
+    CHECK_EQ(wifi_reconnect_classify(cases[i].reason), cases[i].cls);
+  }
+  CHECK(wifi_reconnect_class_name(WIFI_DISC_AUTH)[0] == 'a');
+  CHECK(wifi_reconnect_class_name((wifi_disc_class_t)99)[0] == 'o');
+}
+
+static void test_local_never_retried(void)
+{
+  wifi_reconnect_t r;
+  wifi_reconnect_init(&r, &cfg, 1);
+  CHECK_EQ(wifi_reconnect_next_delay(&r, REASON_ASSOC_LEAVE, false),
+           WIFI_RECONNECT_GIVE_UP);
+  CHECK_EQ(r.attempt, 0); // Not a failure, the backoff does not grow
+}
+
+static void test_auth_limit(void)
+{
+  wifi_reconnect_t r;
+  wifi_reconnect_init(&r, &cfg, 1);
+
+  // A weak link can time out a handshake: auth_retries are tolerated
+  CHECK(wifi_reconnect_next_delay(&r, REASON_AUTH_FAIL, false) !=
+        WIFI_RECONNECT_GIVE_UP);
+  CHECK(wifi_reconnect_next_delay(&r, REASON_4WAY_HANDSHAKE_TIMEOUT, false) !=
+        WIFI_RECONNECT_GIVE_UP);
+  CHECK_EQ(wifi_reconnect_next_delay(&r, REASON_AUTH_FAIL, false),
+           WIFI_RECONNECT_GIVE_UP);
+  CHECK_EQ(wifi_reconnect_next_delay(&r, REASON_AUTH_FAIL, true),
+           WIFI_RECONNECT_GIVE_UP); // Stays given up
+
+  // Only consecutive auth failures count
+  wifi_reconnect_reset(&r);
+  for (int i = 0; i < 5; i++)
+  {
+    CHECK(wifi_reconnect_next_delay(&r, REASON_AUTH_FAIL, false) !=
+          WIFI_RECONNECT_GIVE_UP);
+    CHECK(wifi_reconnect_next_delay(&r, REASON_BEACON_TIMEOUT, false) !=
+          WIFI_RECONNECT_GIVE_UP);
+  }
+
+  // No tolerance configured: the first wrong password stops retries
+  wifi_reconnect_config_t strict = cfg;
+  strict.auth_retries = 0;
+  wifi_reconnect_init(&r, &strict, 1);
+  CHECK_EQ(wifi_reconnect_next_delay(&r, REASON_AUTH_FAIL, false),
+           WIFI_RECONNECT_GIVE_UP);
+}
+
+static void test_backoff_and_jitter(void)
+{
+  uint64_t sum = 0;
+  uint32_t count = 0;
+  uint32_t min_seen = UINT32_MAX;
+  uint32_t max_seen = 0;
+
+  for (uint32_t seed = 1; seed <= 200; seed++)
+  {
+    wifi_reconnect_t r;
+    wifi_reconnect_init(&r, &cfg, seed * 2654435761u);
+    for (int n = 0; n < 16; n++)
+    {
+      uint32_t nom = nominal(BASE_MS, CAP_MS, n);
+      uint32_t d = wifi_reconnect_next_delay(&r, REASON_BEACON_TIMEOUT, false);
+      CHECK(in_bounds(d, nom));
+      if (n == 0)
+      {
+        sum += d;
+        count++;
+        min_seen = d < min_seen ? d : min_seen;
+        max_seen = d > max_seen ? d : max_seen;
+      }
+    }
+    // Retries go on at the cap
+    uint32_t d = wifi_reconnect_next_delay(&r, REASON_BEACON_TIMEOUT, false);
+    CHECK(in_bounds(d, CAP_MS));
+  }
+
+  // The random half is spread over its range, not stuck at one end
+  CHECK(min_seen < BASE_MS * 6 / 10);
+  CHECK(max_seen > BASE_MS * 9 / 10);
+  uint32_t mean = (uint32_t)(sum / count);
+  CHECK(mean > BASE_MS * 7 / 10 && mean < BASE_MS * 8 / 10);
+
+  // Same seed, same sequence; a zero seed still gives a working generator
+  wifi_reconnect_t a;
+  wifi_reconnect_t b;
+  wifi_reconnect_init(&a, &cfg, 42);
+  wifi_reconnect_init(&b, &cfg, 42);
+  for (int n = 0; n < 8; n++)
+  {
+    CHECK_EQ(wifi_reconnect_next_delay(&a, REASON_BEACON_TIMEOUT, false),
+             wifi_reconnect_next_delay(&b, REASON_BEACON_TIMEOUT, false));
+  }
+  wifi_reconnect_init(&a, &cfg, 0);
+  CHECK(a.rng != 0);
+  CHECK(in_bounds(wifi_reconnect_next_delay(&a, REASON_UNSPECIFIED, false),
+                  BASE_MS));
+}
+
+static void test_no_ap_starts_slower(void)
+{
+  wifi_reconnect_t r;
+  wifi_reconnect_init(&r, &cfg, 7);
+  for (int n = 0; n < 10; n++)
+  {
+    uint32_t d = wifi_reconnect_next_delay(&r, REASON_NO_AP_FOUND, false);
+    CHECK(in_bounds(d, nominal(BASE_MS, CAP_MS, n + 2)));
+  }
+
+  // Connected again: back to the base
+  wifi_reconnect_reset(&r);
+  CHECK(in_bounds(wifi_reconnect_next_delay(&r, REASON_BEACON_TIMEOUT, false),
+                  BASE_MS));
+}
+
+static void test_low_battery_scaling(void)
+{
+  wifi_reconnect_t r;
+  wifi_reconnect_init(&r, &cfg, 3);
+  for (int n = 0; n < 16; n++)
+  {
+    uint32_t d = wifi_reconnect_next_delay(&r, REASON_BEACON_TIMEOUT, true);
+    CHECK(in_bounds(d, nominal(BASE_MS * FACTOR, CAP_MS * FACTOR, n)));
+  }
+  // The cap itself is stretched, not just the base
+  CHECK(wifi_reconnect_next_delay(&r, REASON_BEACON_TIMEOUT, true) >
+        CAP_MS * FACTOR / 2);
+
+  // Battery recovers mid-backoff: same attempt count, normal cap
+  CHECK(in_bounds(wifi_reconnect_next_delay(&r, REASON_BEACON_TIMEOUT, false),
+                  CAP_MS));
+
+  // Factor 0 means unscaled
+  wifi_reconnect_config_t flat = cfg;
+  flat.low_battery_factor = 0;
+  wifi_reconnect_init(&r, &flat, 3);
+  CHECK(in_bounds(wifi_reconnect_next_delay(&r, REASON_BEACON_TIMEOUT, true),
+                  BASE_MS));
+
+  // A scaled cap past 32 bits is clamped, never mistaken for give-up
+  wifi_reconnect_config_t huge = cfg;
+  huge.base_ms = UINT32_MAX / 2;
+  huge.cap_ms = UINT32_MAX - 1;
+  huge.low_battery_factor = 255;
+  wifi_reconnect_init(&r, &huge, 3);
+  for (int n = 0; n < 30; n++)
+  {
+    uint32_t d = wifi_reconnect_next_delay(&r, REASON_NO_AP_FOUND, true);
+    CHECK(d != WIFI_RECONNECT_GIVE_UP);
+    CHECK(d >= (UINT32_MAX - 1) / 2);
+  }
+}
+
+int main(void)
+{
+  test_classify();
+  test_local_never_retried();
+  test_auth_limit();
+  test_backoff_and_jitter();
+  test_no_ap_starts_slower();
+  test_low_battery_scaling();
+  TEST_DONE();
+}
@@ -0,0 +1,108 @@
+#!/usr/bin/env python3
+"""Answer NTP queries with a chosen clock offset, delay and jitter.
+
+A local stand-in for an NTP server to exercise the best-of-N sync, the
+slew/step decision and the reply checks. Point the watch at it (the port
+is fixed at 123, so run as root or with CAP_NET_BIND_SERVICE):
+
+    sudo ntp_mock.py --offset 0.3 --delay 40 --jitter 30
+    # CONFIG_NTP_DEFAULT_SERVER="192.168.1.10"
+
+The delay is split over both directions: each leg sleeps delay/2 plus a
+random part of the jitter, one before stamping the receive time and one
+after stamping the transmit time, so the server clock sees it as network
+delay. With jitter the watch should keep the reply with the lowest round
+trip and report an offset close to --offset. Every reply is logged with
+the delay it got.
+
+    ntp_mock.py --kod            # answer RATE kiss-o'-death
+    ntp_mock.py --unsynced       # leap indicator 3, server not synced
+    ntp_mock.py --drop 0.5       # ignore half of the queries
+    ntp_mock.py --bad-origin     # echo a wrong origin timestamp
+"""
+
+import argparse
+import random
+import socket
+import struct
+import sys
+import time
+
+NTP_UNIX_DELTA = 2208988800
+
+
+def ntp_timestamp(unix_time):
+    """Unix seconds (float) to the 64-bit NTP format, era wrap included."""
+    sec = int(unix_time)
+    frac = int((unix_time - sec) * (1 << 32)) & 0xFFFFFFFF
+    return struct.pack("!II", (sec + NTP_UNIX_DELTA) & 0xFFFFFFFF, frac)
+
+
+def reply(request, args, t2, t3):
+    version = (request[0] >> 3) & 0x07
+    leap = 3 if args.unsynced else 0
+    stratum = 0 if args.kod else args.stratum
+    ref_id = b"RATE" if args.kod else b"MOCK"
+    origin = request[40:48]
+    if args.bad_origin:
+        origin = bytes(b ^ 0xFF for b in origin)
+
+    header = struct.pack("!BBbb", (leap << 6) | (version << 3) | 4, stratum,
+                         6, -20)
+    root = struct.pack("!II", 0, 0)  # root delay, root dispersion
+    return (header + root + ref_id + ntp_timestamp(t2 - 60) + origin +
+            ntp_timestamp(t2) + ntp_timestamp(t3))
+
+
+def leg_delay(args):
+    return max(0.0, args.delay / 2 + random.uniform(0, args.jitter)) / 1000
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", type=int, default=123)
+    parser.add_argument("--offset", type=float, default=0.0,
+                        help="server clock minus real time, seconds")
+    parser.add_argument("--delay", type=float, default=0.0,
+                        help="round trip delay to add, ms")
+    parser.add_argument("--jitter", type=float, default=0.0,
+                        help="random extra delay per direction, 0..N ms")
+    parser.add_argument("--stratum", type=int, default=2)
+    parser.add_argument("--drop", type=float, default=0.0,
+                        help="fraction of queries to ignore")
+    parser.add_argument("--kod", action="store_true")
+    parser.add_argument("--unsynced", action="store_true")
+    parser.add_argument("--bad-origin", action="store_true")
+    args = parser.parse_args()
+
+    sock = socket.socket(socket.AF_INET, socket.SOCK_DGRAM)
+    sock.bind(("", args.port))
+    print(f"Answering NTP on port {args.port}, offset {args.offset:+.3f} s",
+          file=sys.stderr)
+
+    while True:
+        request, peer = sock.recvfrom(512)
+        if len(request) < 48 or request[0] & 0x07 != 3:
+            continue
+        if random.random() < args.drop:
+            print(f"{peer[0]}: dropped", file=sys.stderr)
+            continue
+
+        inbound = leg_delay(args)
+        outbound = leg_delay(args)
+        time.sleep(inbound)
+        t2 = time.time() + args.offset
+        t3 = time.time() + args.offset
+        packet = reply(request, args, t2, t3)
+        time.sleep(outbound)
+        sock.sendto(packet, peer)
+        print(f"{peer[0]}: replied, delay {1000 * (inbound + outbound):.1f} ms",
+              file=sys.stderr)
+
+
+if __name__ == "__main__":
+    try:
+        sys.exit(main())
+    except KeyboardInterrupt:
+        sys.exit(0)
@@ -0,0 +1,141 @@
+#!/usr/bin/env python3
+"""Serve a firmware image and cut the connection part way through.
+
+A local stand-in for the release download to exercise the OTA resume
+path (CONFIG_OTA_RESUME): every response is cut after a number of bytes,
+and the watch has to come back with a Range request from its last resume
+point, a 4 KB sector of a plain image or a frame boundary of a packed one.
+
+    ota_drop_server.py build/esp_watch.bin --port 8082 --drop-after 100000
+    # OTA URL "http://192.168.1.10:8082/esp_watch.bin"
+
+Every request is logged with the range asked for and where it was cut, so
+the resume offsets can be checked against ota_pack.py's frame layout.
+Cuts stop after --drops responses (default: never), letting the last
+attempt finish. Servers that do not play along can be mimicked too:
+
+    ota_drop_server.py image.wota --drop-after 65536 --jitter 4096
+    ota_drop_server.py image.bin --no-range      # always 200, full file
+    ota_drop_server.py image.bin --change-etag   # new ETag after each cut
+    ota_drop_server.py image.bin --stall 30      # hang instead of closing
+"""
+
+import argparse
+import random
+import re
+import sys
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+RANGE_RE = re.compile(r"bytes=(\d+)-(\d*)$")
+
+
+def make_handler(args, image):
+    state = {"drops": 0, "etag": 1}
+
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"
+
+        def etag(self):
+            return f'"ota-{state["etag"]}"'
+
+        def requested_start(self):
+            """First byte asked for, or None for the whole file."""
+            header = self.headers.get("Range")
+            if not header or args.no_range:
+                return None
+            match = RANGE_RE.match(header.strip())
+            if not match:
+                return None
+            if_range = self.headers.get("If-Range")
+            if if_range and if_range != self.etag():
+                self.log_message("If-Range %s is stale, sending it all",
+                                 if_range)
+                return None
+            return int(match.group(1))
+
+        def do_HEAD(self):
+            self.send_response(200)
+            self.send_header("Content-Length", str(len(image)))
+            self.send_header("Accept-Ranges", "bytes")
+            self.send_header("ETag", self.etag())
+            self.end_headers()
+
+        def do_GET(self):
+            start = self.requested_start()
+            if start is not None and start >= len(image):
+                self.send_response(416)
+                self.send_header("Content-Range", f"bytes */{len(image)}")
+                self.send_header("Content-Length", "0")
+                self.end_headers()
+                return
+
+            first = start or 0
+            body = image[first:]
+            if start is None:
+                self.send_response(200)
+            else:
+                self.send_response(206)
+                self.send_header("Content-Range",
+                                 f"bytes {first}-{len(image) - 1}/{len(image)}")
+            self.send_header("Content-Length", str(len(body)))
+            self.send_header("Accept-Ranges", "bytes")
+            self.send_header("ETag", self.etag())
+            self.end_headers()
+
+            cut = len(body)
+            if args.drops is None or state["drops"] < args.drops:
+                cut = args.drop_after + random.randint(0, args.jitter)
+            if cut >= len(body):
+                self.wfile.write(body)
+                self.log_message("GET from %d: sent %d bytes, complete",
+                                 first, len(body))
+                return
+
+            self.wfile.write(body[:cut])
+            self.wfile.flush()
+            state["drops"] += 1
+            if args.change_etag:
+                state["etag"] += 1
+            self.log_message("GET from %d: cut at %d (file offset %d)",
+                             first, cut, first + cut)
+            if args.stall:
+                time.sleep(args.stall)
+            self.close_connection = True
+
+    return Handler
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("image", type=argparse.FileType("rb"),
+                        help="plain .bin or packed .wota to serve")
+    parser.add_argument("--port", type=int, default=8082)
+    parser.add_argument("--drop-after", type=int, default=100000,
+                        help="bytes of each response body sent before the cut")
+    parser.add_argument("--jitter", type=int, default=0,
+                        help="random extra bytes per response, 0..N")
+    parser.add_argument("--drops", type=int, default=None,
+                        help="cut only the first N responses")
+    parser.add_argument("--no-range", action="store_true",
+                        help="ignore Range, always send the whole file")
+    parser.add_argument("--change-etag", action="store_true",
+                        help="pretend the file changed after every cut")
+    parser.add_argument("--stall", type=float, default=0,
+                        help="seconds to hang after the cut before closing")
+    args = parser.parse_args()
+    image = args.image.read()
+
+    server = ThreadingHTTPServer(("", args.port), make_handler(args, image))
+    print(f"Serving {len(image)} bytes on port {args.port}, cutting after "
+          f"{args.drop_after}", file=sys.stderr)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,496 @@
+#!/usr/bin/env python3
+"""Pack a firmware image as a compressed or delta OTA container.
+
+The container is decoded on the watch by
+components/ota_manager/ota_stream.c while it downloads. The format is
+documented in ota_stream.h and must stay in sync with it.
+
+    # heatshrink-compressed full image
+    ota_pack.py build/esp_watch.bin -o esp_watch.wota
+
+    # delta against the image the watch is running, then compressed
+    ota_pack.py build/esp_watch.bin --base v1.2.0/esp_watch.bin -o v1.3.0.wota
+
+    # patch size and host apply time for consecutive releases
+    ota_pack.py --report v1.0.0.bin v1.1.0.bin v1.2.0.bin
+
+Every container is decoded again before it is written and compared with
+the input image, so a bad encoder never produces a file that would only
+fail on the device.
+"""
+
+import argparse
+import struct
+import sys
+import time
+
+MAGIC = b"WOTA"
+VERSION = 1
+FLAG_LZSS = 0x01
+FLAG_DELTA = 0x02
+
+HEADER = struct.Struct("<4sBBBBII32s")
+FRAME_LEN = struct.Struct("<I")
+
+OP_COPY = 1
+OP_ADD = 2
+OP_INSERT = 3
+
+WINDOW_BITS = 11
+LOOKAHEAD_BITS = 5
+WINDOW_BITS_MAX = 12
+FRAME_SIZE = 64 * 1024
+FRAME_ALIGN = 4096
+
+IMAGE_MAGIC = 0xE9
+# Image header (24) + first segment header (8) + offset in esp_app_desc_t
+APP_ELF_SHA256_OFFSET = 24 + 8 + 144
+
+# Delta matching: seeds are exact BLOCK-byte matches found through an index
+# of every INDEX_STRIDE-th base offset, then grown with bsdiff-style
+# approximate extension so relocated code becomes ADD ops of small diffs.
+BLOCK = 12
+INDEX_STRIDE = 4
+EXTEND_GIVE_UP = 64
+COPY_MIN = 32
+
+
+class PackError(Exception):
+    pass
+
+
+def app_elf_sha256(image):
+    if len(image) < APP_ELF_SHA256_OFFSET + 32 or image[0] != IMAGE_MAGIC:
+        raise PackError("not an ESP app image")
+    return image[APP_ELF_SHA256_OFFSET:APP_ELF_SHA256_OFFSET + 32]
+
+
+# --- heatshrink (LZSS) ----------------------------------------------------
+
+class BitWriter:
+    def __init__(self):
+        self.out = bytearray()
+        self.acc = 0
+        self.nbits = 0
+
+    def put(self, value, count):
+        self.acc = (self.acc << count) | value
+        self.nbits += count
+        while self.nbits >= 8:
+            self.nbits -= 8
+            self.out.append((self.acc >> self.nbits) & 0xFF)
+        self.acc &= (1 << self.nbits) - 1
+
+    def finish(self):
+        if self.nbits:
+            self.out.append((self.acc << (8 - self.nbits)) & 0xFF)
+            self.nbits = 0
+            self.acc = 0
+        return bytes(self.out)
+
+
+def lzss_encode(data, window_bits, lookahead_bits):
+    window = 1 << window_bits
+    max_len = 1 << lookahead_bits
+    backref_bits = 1 + window_bits + lookahead_bits
+    min_len = backref_bits // 9 + 1
+
+    bits = BitWriter()
+    i = 0
+    n = len(data)
+    while i < n:
+        best_len = 0
+        best_dist = 0
+        lo = max(0, i - window)
+        length = min_len
+        while length <= max_len and i + length <= n:
+            # Closest earlier start; may overlap i like any LZ77 copy
+            pos = data.rfind(data[i:i + length], lo, i + length - 1)
+            if pos < 0:
+                break
+            best_len = length
+            best_dist = i - pos
+            # Grow in place before searching again
+            length += 1
+            while (length <= max_len and i + length <= n
+                   and data[pos + length - 1] == data[i + length - 1]):
+                best_len = length
+                length += 1
+
+        if best_len:
+            bits.put(0, 1)
+            bits.put(best_dist - 1, window_bits)
+            bits.put(best_len - 1, lookahead_bits)
+            i += best_len
+        else:
+            bits.put(0x100 | data[i], 9)
+            i += 1
+    return bits.finish()
+
+
+def lzss_decode(payload, window_bits, lookahead_bits):
+    mask = (1 << window_bits) - 1
+    window = bytearray(1 << window_bits)
+    head = 0
+    out = bytearray()
+    padded = payload + bytes(3)
+    pos = 0
+    left = len(payload) * 8
+
+    def take(count):
+        nonlocal pos, left
+        chunk = int.from_bytes(padded[pos >> 3:(pos >> 3) + 3], "big")
+        value = (chunk >> (24 - (pos & 7) - count)) & ((1 << count) - 1)
+        pos += count
+        left -= count
+        return value
+
+    while left >= 1:
+        if take(1):
+            if left < 8:
+                break
+            c = take(8)
+            window[head & mask] = c
+            head += 1
+            out.append(c)
+            continue
+        if left < window_bits + lookahead_bits:
+            break
+        dist = take(window_bits) + 1
+        count = take(lookahead_bits) + 1
+        for _ in range(count):
+            c = window[(head - dist) & mask]
+            window[head & mask] = c
+            head += 1
+            out.append(c)
+    return bytes(out)
+
+
+# --- delta ---------------------------------------------------------------
+
+def varint(value):
+    out = bytearray()
+    while True:
+        byte = value & 0x7F
+        value >>= 7
+        if value:
+            out.append(byte | 0x80)
+        else:
+            out.append(byte)
+            return bytes(out)
+
+
+def extend(base, image, src, dst):
+    """Length at dst whose bytes mostly equal base[src:], bsdiff style."""
+    score = best = 0
+    best_len = 0
+    limit = min(len(base) - src, len(image) - dst)
+    for k in range(limit):
+        if base[src + k] == image[dst + k]:
+            score += 1
+            if score > best:
+                best = score
+                best_len = k + 1
+        else:
+            score -= 1
+            if score < best - EXTEND_GIVE_UP:
+                break
+    return best_len
+
+
+def match_ops(base, image, src, dst, length):
+    """COPY for long identical runs of a match, ADD for the rest."""
+    diff = bytes((image[dst + k] - base[src + k]) & 0xFF
+                 for k in range(length))
+    ops = []
+    pos = 0
+    while pos < length:
+        zeros = diff.find(bytes(COPY_MIN), pos)
+        if zeros < 0:
+            zeros = length
+        if zeros > pos:
+            ops.append((OP_ADD, src + pos, diff[pos:zeros]))
+        end = zeros
+        while end < length and diff[end] == 0:
+            end += 1
+        if end > zeros:
+            ops.append((OP_COPY, src + zeros, end - zeros))
+        pos = end
+    return ops
+
+
+def delta_ops(base, image):
+    """List of (op, src, data_or_len) turning base into image."""
+    index = {}
+    for j in range(0, len(base) - BLOCK + 1, INDEX_STRIDE):
+        index.setdefault(base[j:j + BLOCK], j)
+
+    ops = []
+    n = len(image)
+    i = 0
+    lit_start = 0
+    shift = None
+    while i <= n - BLOCK:
+        key = image[i:i + BLOCK]
+        src = None
+        # Keep following the previous match's alignment first
+        if shift is not None and 0 <= i + shift <= len(base) - BLOCK \
+                and base[i + shift:i + shift + BLOCK] == key:
+            src = i + shift
+        else:
+            src = index.get(key)
+        if src is None:
+            i += 1
+            continue
+
+        while i > lit_start and src > 0 and image[i - 1] == base[src - 1]:
+            i -= 1
+            src -= 1
+        length = extend(base, image, src, i)
+
+        if i > lit_start:
+            ops.append((OP_INSERT, 0, image[lit_start:i]))
+        ops += match_ops(base, image, src, i, length)
+        shift = src - i
+        i += length
+        lit_start = i
+
+    if lit_start < n:
+        ops.append((OP_INSERT, 0, image[lit_start:]))
+    return ops
+
+
+def op_len(op):
+    return op[2] if op[0] == OP_COPY else len(op[2])
+
+
+def encode_op(code, src, arg):
+    if code == OP_COPY:
+        return bytes([OP_COPY]) + varint(src) + varint(arg)
+    if code == OP_ADD:
+        return bytes([OP_ADD]) + varint(src) + varint(len(arg)) + arg
+    return bytes([OP_INSERT]) + varint(len(arg)) + arg
+
+
+def delta_frames(base, image, frame_size):
+    """Op lists, one per frame, cut so no op crosses a frame boundary."""
+    frames = []
+    current = bytearray()
+    room = frame_size
+    for code, src, arg in delta_ops(base, image):
+        length = op_len((code, src, arg))
+        pos = 0
+        while pos < length:
+            take = min(room, length - pos)
+            if code == OP_COPY:
+                piece = take
+            else:
+                piece = arg[pos:pos + take]
+            current += encode_op(code, src + pos, piece)
+            pos += take
+            room -= take
+            if room == 0:
+                frames.append(bytes(current))
+                current = bytearray()
+                room = frame_size
+    if current:
+        frames.append(bytes(current))
+    return frames
+
+
+def apply_ops(ops, base, frame_out):
+    out = bytearray()
+    i = 0
+    while i < len(ops):
+        code = ops[i]
+        i += 1
+
+        def read_varint():
+            nonlocal i
+            value = shift = 0
+            while True:
+                byte = ops[i]
+                i += 1
+                value |= (byte & 0x7F) << shift
+                shift += 7
+                if not byte & 0x80:
+                    return value
+
+        if code == OP_INSERT:
+            length = read_varint()
+            out += ops[i:i + length]
+            i += length
+            continue
+        src = read_varint()
+        length = read_varint()
+        if src + length > len(base):
+            raise PackError("op reads past the end of the base image")
+        if code == OP_COPY:
+            out += base[src:src + length]
+        elif code == OP_ADD:
+            out += bytes((base[src + k] + ops[i + k]) & 0xFF
+                         for k in range(length))
+            i += length
+        else:
+            raise PackError(f"bad op {code}")
+    if len(out) != frame_out:
+        raise PackError("frame decodes to the wrong size")
+    return bytes(out)
+
+
+# --- container -------------------------------------------------------------
+
+def pack(image, base=None, compress=True, window_bits=WINDOW_BITS,
+         lookahead_bits=LOOKAHEAD_BITS, frame_size=FRAME_SIZE):
+    if image[:1] != bytes([IMAGE_MAGIC]):
+        raise PackError("not an ESP app image")
+    if not compress and base is None:
+        raise PackError("nothing to do: ship the .bin as it is")
+    if frame_size % FRAME_ALIGN:
+        raise PackError(f"frame size must be a multiple of {FRAME_ALIGN}")
+    if not 4 <= window_bits <= WINDOW_BITS_MAX \
+            or not 3 <= lookahead_bits < window_bits:
+        raise PackError("window/lookahead bits out of range")
+
+    flags = (FLAG_LZSS if compress else 0) | (FLAG_DELTA if base else 0)
+    if base is not None:
+        base_sha = app_elf_sha256(base)
+        bodies = delta_frames(base, image, frame_size)
+    else:
+        base_sha = bytes(32)
+        bodies = [image[k:k + frame_size]
+                  for k in range(0, len(image), frame_size)]
+
+    out = bytearray(HEADER.pack(MAGIC, VERSION, flags, window_bits,
+                                lookahead_bits, len(image), frame_size,
+                                base_sha))
+    for body in bodies:
+        payload = lzss_encode(body, window_bits, lookahead_bits) \
+            if compress else body
+        out += FRAME_LEN.pack(len(payload)) + payload
+    return bytes(out)
+
+
+def unpack(blob, base=None):
+    if len(blob) < HEADER.size or blob[:4] != MAGIC:
+        raise PackError("not an OTA container")
+    (_, version, flags, window_bits, lookahead_bits, image_size, frame_size,
+     base_sha) = HEADER.unpack_from(blob)
+    if version != VERSION:
+        raise PackError(f"container version {version}")
+    if flags & FLAG_DELTA:
+        if base is None:
+            raise PackError("delta container needs --base")
+        if app_elf_sha256(base) != base_sha:
+            raise PackError("container was made against another base image")
+
+    image = bytearray()
+    pos = HEADER.size
+    while len(image) < image_size:
+        (length,) = FRAME_LEN.unpack_from(blob, pos)
+        pos += FRAME_LEN.size
+        payload = blob[pos:pos + length]
+        pos += length
+        frame_out = min(frame_size, image_size - len(image))
+        body = lzss_decode(payload, window_bits, lookahead_bits) \
+            if flags & FLAG_LZSS else payload
+        if flags & FLAG_DELTA:
+            body = apply_ops(body, base, frame_out)
+        elif len(body) != frame_out:
+            raise PackError("frame decodes to the wrong size")
+        image += body[:frame_out]
+    if pos != len(blob):
+        raise PackError("trailing data after the last frame")
+    return bytes(image)
+
+
+def pack_checked(image, base=None, **kwargs):
+    blob = pack(image, base, **kwargs)
+    if unpack(blob, base) != image:
+        raise PackError("container does not decode to the input image")
+    return blob
+
+
+def report(paths, args):
+    images = []
+    for path in paths:
+        with open(path, "rb") as f:
+            images.append((path, f.read()))
+
+    print(f"{'image':<28} {'full':>9} {'compressed':>11} {'delta':>9} "
+          f"{'ratio':>6} {'encode':>8} {'apply':>8}")
+    for k, (path, image) in enumerate(images):
+        compressed = pack_checked(image, window_bits=args.window,
+                                  lookahead_bits=args.lookahead,
+                                  frame_size=args.frame)
+        delta = "-"
+        ratio = "-"
+        encode_ms = apply_ms = "-"
+        if k > 0:
+            base = images[k - 1][1]
+            start = time.perf_counter()
+            blob = pack(image, base, compress=not args.no_compress,
+                        window_bits=args.window,
+                        lookahead_bits=args.lookahead, frame_size=args.frame)
+            encode_ms = f"{(time.perf_counter() - start) * 1000:.0f}ms"
+            start = time.perf_counter()
+            if unpack(blob, base) != image:
+                raise PackError(f"{path}: delta does not decode")
+            apply_ms = f"{(time.perf_counter() - start) * 1000:.0f}ms"
+            delta = len(blob)
+            ratio = f"{len(blob) / len(image):.1%}"
+        print(f"{path[-28:]:<28} {len(image):>9} {len(compressed):>11} "
+              f"{delta:>9} {ratio:>6} {encode_ms:>8} {apply_ms:>8}")
+    print("apply is the host reference decoder; the watch logs its own "
+          "time after each update")
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("image", nargs="+", help="firmware image (.bin)")
+    parser.add_argument("-o", "--output", help="container to write")
+    parser.add_argument("--base", help="image the watch runs (makes a delta)")
+    parser.add_argument("--no-compress", action="store_true",
+                        help="skip heatshrink compression")
+    parser.add_argument("--window", type=int, default=WINDOW_BITS,
+                        help=f"LZSS window bits (default {WINDOW_BITS})")
+    parser.add_argument("--lookahead", type=int, default=LOOKAHEAD_BITS,
+                        help=f"LZSS lookahead bits (default {LOOKAHEAD_BITS})")
+    parser.add_argument("--frame", type=int, default=FRAME_SIZE,
+                        help=f"image bytes per frame (default {FRAME_SIZE})")
+    parser.add_argument("--report", action="store_true",
+                        help="compare consecutive images instead of packing")
+    args = parser.parse_args()
+
+    try:
+        if args.report:
+            report(args.image, args)
+            return 0
+        if len(args.image) != 1 or not args.output:
+            parser.error("pack takes one image and -o")
+
+        with open(args.image[0], "rb") as f:
+            image = f.read()
+        base = None
+        if args.base:
+            with open(args.base, "rb") as f:
+                base = f.read()
+        blob = pack_checked(image, base, compress=not args.no_compress,
+                            window_bits=args.window,
+                            lookahead_bits=args.lookahead,
+                            frame_size=args.frame)
+    except (PackError, OSError) as err:
+        print(f"error: {err}", file=sys.stderr)
+        return 1
+
+    with open(args.output, "wb") as f:
+        f.write(blob)
+
+    kind = "delta" if base is not None else "compressed"
+    print(f"{args.output}: {kind}, {len(blob)} bytes for a {len(image)} "
+          f"byte image ({len(blob) / len(image):.1%})")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
@@ -0,0 +1,119 @@
+#!/usr/bin/env python3
+"""Serve an Open-Meteo shaped forecast for testing the weather complication.
+
+Point CONFIG_WEATHER_URL at this machine over plain HTTP:
+
+    weather_mock.py --port 8081 --temp -3.4 --code 71
+    # CONFIG_WEATHER_URL="http://192.168.1.10:8081/v1/forecast"
+
+Every request is logged with the time since the previous one, which shows
+how often the watch really fetches at a given battery level. The response
+can be slowed down, sent chunked in small pieces or replaced by an error
+to exercise the streaming parser and the stale-while-revalidate path:
+
+    weather_mock.py --chunk 7 --delay 2     # 7-byte chunks, 2 s late
+    weather_mock.py --status 503            # fetch fails, cache stays
+"""
+
+import argparse
+import json
+import sys
+import time
+from http.server import BaseHTTPRequestHandler, ThreadingHTTPServer
+
+
+def forecast(args):
+    """Trimmed copy of a real Open-Meteo response, unused fields included."""
+    return {
+        "latitude": 50.45,
+        "longitude": 30.52,
+        "generationtime_ms": 0.05,
+        "utc_offset_seconds": 7200,
+        "timezone": "Europe/Kyiv",
+        "elevation": 179.0,
+        "current_units": {"time": "iso8601", "interval": "seconds",
+                          "temperature_2m": "°C", "weather_code": "wmo code"},
+        "current": {"time": time.strftime("%Y-%m-%dT%H:%M"),
+                    "interval": 900,
+                    "temperature_2m": args.temp,
+                    "weather_code": args.code},
+        "daily_units": {"time": "iso8601",
+                        "temperature_2m_max": "°C",
+                        "temperature_2m_min": "°C"},
+        "daily": {"time": [time.strftime("%Y-%m-%d")],
+                  "temperature_2m_max": [args.high],
+                  "temperature_2m_min": [args.low]},
+    }
+
+
+def make_handler(args):
+    last = {"t": None}
+
+    class Handler(BaseHTTPRequestHandler):
+        protocol_version = "HTTP/1.1"  # keep-alive, like the real API
+
+        def do_GET(self):
+            now = time.monotonic()
+            since = ("first request" if last["t"] is None
+                     else f"{now - last['t']:.0f} s since last")
+            last["t"] = now
+            self.log_message("GET %s (%s)", self.path, since)
+
+            if args.delay:
+                time.sleep(args.delay)
+            if args.status != 200:
+                body = b"unavailable\n"
+                self.send_response(args.status)
+                self.send_header("Content-Length", str(len(body)))
+                self.end_headers()
+                self.wfile.write(body)
+                return
+
+            body = json.dumps(forecast(args)).encode()
+            self.send_response(200)
+            self.send_header("Content-Type", "application/json")
+            if args.chunk:
+                self.send_header("Transfer-Encoding", "chunked")
+                self.end_headers()
+                for i in range(0, len(body), args.chunk):
+                    piece = body[i:i + args.chunk]
+                    self.wfile.write(b"%x\r\n%s\r\n" % (len(piece), piece))
+                    self.wfile.flush()
+                self.wfile.write(b"0\r\n\r\n")
+            else:
+                self.send_header("Content-Length", str(len(body)))
+                self.end_headers()
+                self.wfile.write(body)
+
+    return Handler
+
+
+def main():
+    parser = argparse.ArgumentParser(
+        description=__doc__, formatter_class=argparse.RawDescriptionHelpFormatter)
+    parser.add_argument("--port", type=int, default=8081)
+    parser.add_argument("--temp", type=float, default=12.3,
+                        help="current temperature, C (default 12.3)")
+    parser.add_argument("--code", type=int, default=3,
+                        help="WMO weather code (default 3, overcast)")
+    parser.add_argument("--high", type=float, default=15.2)
+    parser.add_argument("--low", type=float, default=7.1)
+    parser.add_argument("--chunk", type=int, default=0,
+                        help="send chunked, N bytes per chunk")
+    parser.add_argument("--delay", type=float, default=0,
+                        help="seconds to wait before answering")
+    parser.add_argument("--status", type=int, default=200,
+                        help="answer with this status instead")
+    args = parser.parse_args()
+
+    server = ThreadingHTTPServer(("", args.port), make_handler(args))
+    print(f"Serving forecasts on port {args.port}", file=sys.stderr)
+    try:
+        server.serve_forever()
+    except KeyboardInterrupt:
+        pass
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())
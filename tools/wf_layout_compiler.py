@@ -0,0 +1,241 @@
+#!/usr/bin/env python3
+"""Compile a watchface layout description into a binary layout pack.
+
+The pack is read by main/apps/watchface/watchface_layout.c straight from the
+`storage` partition (CONFIG_WATCHFACE_LAYOUT_FROM_FLASH). The binary format
+is documented in watchface_layout.h and must stay in sync with it.
+
+Description format (one statement per line, lines starting with '#' are
+comments):
+
+    layout "Classic"
+    label time    font=48 color=#FFFFFF align=center y=-30
+    label date    font=20 color=#888888 align=center y=30
+    label text    font=14 text="Hello" align=bottom_mid safe_area=no
+
+`label` takes a binding (time, date, battery, uptime, boot_count,
+sleep_indicator, weather) or `text` for a static label. Options:
+
+    font=12|14|16|18|20|22|24|26|48   (default 14)
+    color=#RRGGBB                     (default #FFFFFF)
+    align=top_left|top_mid|top_right|bottom_left|bottom_mid|
+          bottom_right|left_mid|right_mid|center   (default center)
+    x=<px> y=<px>                     offsets added to the safe area
+    text="..."                        initial / static text
+    safe_area=yes|no                  (default yes)
+
+Usage:
+    wf_layout_compiler.py layouts.wfl -o layout.bin
+"""
+
+import argparse
+import shlex
+import struct
+import sys
+import zlib
+
+MAGIC = 0x594C4657  # "WFLY"
+VERSION = 1
+MAX_WIDGETS = 24
+MAX_SIZE = 16 * 1024
+NO_TEXT = 0xFFFF
+FLAG_NO_SAFE_AREA = 0x01
+
+HEADER = struct.Struct("<IHBBHHII")
+ENTRY = struct.Struct("<HHB3x")
+WIDGET = struct.Struct("<BBBBIhhHBx")
+
+BINDINGS = {
+    "text": 0,
+    "time": 1,
+    "date": 2,
+    "battery": 3,
+    "uptime": 4,
+    "boot_count": 5,
+    "sleep_indicator": 6,
+    "weather": 7,
+}
+FONTS = {12: 0, 14: 1, 16: 2, 18: 3, 20: 4, 22: 5, 24: 6, 26: 7, 48: 8}
+ALIGNS = {
+    "top_left": 0,
+    "top_mid": 1,
+    "top_right": 2,
+    "bottom_left": 3,
+    "bottom_mid": 4,
+    "bottom_right": 5,
+    "left_mid": 6,
+    "right_mid": 7,
+    "center": 8,
+}
+
+
+class LayoutError(Exception):
+    pass
+
+
+class StringTable:
+    def __init__(self):
+        self.data = bytearray()
+        self.offsets = {}
+
+    def add(self, text):
+        if text in self.offsets:
+            return self.offsets[text]
+        offset = len(self.data)
+        self.data += text.encode("utf-8") + b"\0"
+        self.offsets[text] = offset
+        return offset
+
+
+def parse_int(value, lo, hi, what):
+    try:
+        number = int(value, 0)
+    except ValueError:
+        raise LayoutError(f"bad {what} '{value}'")
+    if not lo <= number <= hi:
+        raise LayoutError(f"{what} {number} out of range {lo}..{hi}")
+    return number
+
+
+def parse_label(args, strings):
+    if not args or args[0] not in BINDINGS:
+        raise LayoutError(f"label needs one of: {', '.join(BINDINGS)}")
+
+    widget = {
+        "binding": BINDINGS[args[0]],
+        "font": FONTS[14],
+        "color": 0xFFFFFF,
+        "align": ALIGNS["center"],
+        "x": 0,
+        "y": 0,
+        "text": NO_TEXT,
+        "flags": 0,
+    }
+
+    for option in args[1:]:
+        key, sep, value = option.partition("=")
+        if not sep:
+            raise LayoutError(f"expected key=value, got '{option}'")
+        if key == "font":
+            size = parse_int(value, 0, 255, "font")
+            if size not in FONTS:
+                raise LayoutError(f"font must be one of {sorted(FONTS)}")
+            widget["font"] = FONTS[size]
+        elif key == "color":
+            widget["color"] = parse_int(value.replace("#", "0x"), 0, 0xFFFFFF,
+                                        "color")
+        elif key == "align":
+            if value not in ALIGNS:
+                raise LayoutError(f"align must be one of {', '.join(ALIGNS)}")
+            widget["align"] = ALIGNS[value]
+        elif key in ("x", "y"):
+            widget[key] = parse_int(value, -32768, 32767, key)
+        elif key == "text":
+            widget["text"] = strings.add(value)
+        elif key == "safe_area":
+            if value not in ("yes", "no"):
+                raise LayoutError("safe_area must be yes or no")
+            if value == "no":
+                widget["flags"] |= FLAG_NO_SAFE_AREA
+        else:
+            raise LayoutError(f"unknown option '{key}'")
+
+    return widget
+
+
+def parse(source):
+    strings = StringTable()
+    layouts = []
+
+    for lineno, line in enumerate(source.splitlines(), 1):
+        try:
+            if line.lstrip().startswith("#"):
+                continue
+            tokens = shlex.split(line)
+            if not tokens:
+                continue
+
+            keyword, args = tokens[0], tokens[1:]
+            if keyword == "layout":
+                if len(args) != 1:
+                    raise LayoutError("layout takes one name")
+                layouts.append({"name": strings.add(args[0]), "widgets": []})
+            elif keyword == "label":
+                if not layouts:
+                    raise LayoutError("label before any layout")
+                widget = parse_label(args, strings)
+                current = layouts[-1]
+                if widget["binding"] and any(
+                        w["binding"] == widget["binding"]
+                        for w in current["widgets"]):
+                    raise LayoutError(f"binding '{args[0]}' used twice")
+                current["widgets"].append(widget)
+                if len(current["widgets"]) > MAX_WIDGETS:
+                    raise LayoutError(f"more than {MAX_WIDGETS} widgets")
+            else:
+                raise LayoutError(f"unknown statement '{keyword}'")
+        except (LayoutError, ValueError) as err:
+            raise LayoutError(f"line {lineno}: {err}")
+
+    if not layouts:
+        raise LayoutError("no layouts defined")
+    for layout in layouts:
+        if not layout["widgets"]:
+            raise LayoutError("layout without widgets")
+    if len(layouts) > 255:
+        raise LayoutError("too many layouts")
+
+    return layouts, strings
+
+
+def build(layouts, strings):
+    entries = bytearray()
+    widgets = bytearray()
+    widget_count = 0
+
+    for layout in layouts:
+        entries += ENTRY.pack(layout["name"], widget_count,
+                              len(layout["widgets"]))
+        for w in layout["widgets"]:
+            widgets += WIDGET.pack(0, w["font"], w["align"], w["binding"],
+                                   w["color"], w["x"], w["y"], w["text"],
+                                   w["flags"])
+        widget_count += len(layout["widgets"])
+
+    body = bytes(entries + widgets + strings.data)
+    total = HEADER.size + len(body)
+    if total > MAX_SIZE:
+        raise LayoutError(f"pack is {total} bytes, limit is {MAX_SIZE}")
+    if len(strings.data) > 0xFFFF:
+        raise LayoutError("string table too large")
+
+    header = HEADER.pack(MAGIC, VERSION, len(layouts), 0, widget_count,
+                         len(strings.data), total,
+                         zlib.crc32(body) & 0xFFFFFFFF)
+    return header + body
+
+
+def main():
+    parser = argparse.ArgumentParser(description=__doc__.splitlines()[0])
+    parser.add_argument("input", help="layout description (.wfl)")
+    parser.add_argument("-o", "--output", required=True,
+                        help="binary layout pack to write")
+    args = parser.parse_args()
+
+    try:
+        with open(args.input, encoding="utf-8") as f:
+            layouts, strings = parse(f.read())
+        blob = build(layouts, strings)
+    except LayoutError as err:
+        print(f"{args.input}: error: {err}", file=sys.stderr)
+        return 1
+
+    with open(args.output, "wb") as f:
+        f.write(blob)
+
+    print(f"{args.output}: {len(layouts)} layout(s), {len(blob)} bytes")
+    return 0
+
+
+if __name__ == "__main__":
+    sys.exit(main())